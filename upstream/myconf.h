@@ -192,6 +192,14 @@
 #define TCUSEPTHREAD   1
 #endif
 
+#if defined(_MYNOURING) || !defined(_SYS_LINUX_) || !defined(__has_include)
+#define TCUSEURING     0
+#elif __has_include(<linux/io_uring.h>)
+#define TCUSEURING     1
+#else
+#define TCUSEURING     0
+#endif
+
 #if defined(_MYMICROYIELD)
 #define TCMICROYIELD   1
 #else
@@ -251,6 +259,11 @@
 #endif
 #endif
 
+#if TCUSEURING
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
 
 
 /*************************************************************************************************
@@ -379,6 +392,16 @@ void *_tc_recdecode(const void *ptr, int size, int *sp, void *op);
 #define pthread_mutex_lock(TC_a)         _tc_dummyfuncv((intptr_t)(TC_a))
 #define pthread_mutex_unlock(TC_a)       _tc_dummyfuncv((intptr_t)(TC_a))
 
+#define pthread_cond_t                   intptr_t
+#undef PTHREAD_COND_INITIALIZER
+#define PTHREAD_COND_INITIALIZER         0
+#define pthread_cond_init(TC_a, TC_b)    _tc_dummyfuncv((intptr_t)(TC_a), (TC_b))
+#define pthread_cond_destroy(TC_a)       _tc_dummyfuncv((intptr_t)(TC_a))
+#define pthread_cond_wait(TC_a, TC_b)    _tc_dummyfuncv((intptr_t)(TC_a), (TC_b))
+#define pthread_cond_timedwait(TC_a, TC_b, TC_c)  _tc_dummyfuncv((intptr_t)(TC_a), (TC_b), (TC_c))
+#define pthread_cond_signal(TC_a)        _tc_dummyfuncv((intptr_t)(TC_a))
+#define pthread_cond_broadcast(TC_a)     _tc_dummyfuncv((intptr_t)(TC_a))
+
 #define pthread_rwlock_t                 intptr_t
 #undef PTHREAD_RWLOCK_INITIALIZER
 #define PTHREAD_RWLOCK_INITIALIZER       0
@@ -81,6 +81,7 @@ static int tcadbmapreccmpdecimal(const TCLISTDATUM *a, const TCLISTDATUM *b);
 static int tcadbmapreccmpint32(const TCLISTDATUM *a, const TCLISTDATUM *b);
 static int tcadbmapreccmpint64(const TCLISTDATUM *a, const TCLISTDATUM *b);
 static int tcadbtdbqrygetout(const void *pkbuf, int pksiz, TCMAP *cols, void *op);
+static TCLIST *tcadbstatlist(const TCSTATS *stats);
 
 
 
@@ -147,9 +148,12 @@ bool tcadbopen(TCADB *adb, const char *name){
   bool tdmode = false;
   bool tbmode = false;
   bool ttmode = false;
+  bool tsmode = false;
   int32_t rcnum = -1;
+  int64_t rcsiz = -1;
   int64_t xmsiz = -1;
   int32_t dfunit = -1;
+  int64_t dfbps = -1;
   int32_t lmemb = -1;
   int32_t nmemb = -1;
   int32_t lcnum = -1;
@@ -186,12 +190,17 @@ bool tcadbopen(TCADB *adb, const char *name){
       if(strchr(pv, 'd') || strchr(pv, 'D')) tdmode = true;
       if(strchr(pv, 'b') || strchr(pv, 'B')) tbmode = true;
       if(strchr(pv, 't') || strchr(pv, 'T')) ttmode = true;
+      if(strchr(pv, 's') || strchr(pv, 'S')) tsmode = true;
     } else if(!tcstricmp(elem, "rcnum")){
       rcnum = tcatoix(pv);
+    } else if(!tcstricmp(elem, "rcsiz")){
+      rcsiz = tcatoix(pv);
     } else if(!tcstricmp(elem, "xmsiz")){
       xmsiz = tcatoix(pv);
     } else if(!tcstricmp(elem, "dfunit")){
       dfunit = tcatoix(pv);
+    } else if(!tcstricmp(elem, "dfbps")){
+      dfbps = tcatoix(pv);
     } else if(!tcstricmp(elem, "lmemb")){
       lmemb = tcatoix(pv);
     } else if(!tcstricmp(elem, "nmemb")){
@@ -240,10 +249,12 @@ bool tcadbopen(TCADB *adb, const char *name){
     if(tdmode) opts |= HDBTDEFLATE;
     if(tbmode) opts |= HDBTBZIP;
     if(ttmode) opts |= HDBTTCBS;
+    if(tsmode) opts |= HDBTLZ;
     tchdbtune(hdb, bnum, apow, fpow, opts);
-    tchdbsetcache(hdb, rcnum);
+    tchdbsetcache2(hdb, rcnum, rcsiz);
     if(xmsiz >= 0) tchdbsetxmsiz(hdb, xmsiz);
     if(dfunit >= 0) tchdbsetdfunit(hdb, dfunit);
+    if(dfbps >= 0) tchdbsetbgdefrag(hdb, dfbps);
     int omode = owmode ? HDBOWRITER : HDBOREADER;
     if(ocmode) omode |= HDBOCREAT;
     if(otmode) omode |= HDBOTRUNC;
@@ -266,6 +277,7 @@ bool tcadbopen(TCADB *adb, const char *name){
     if(tdmode) opts |= BDBTDEFLATE;
     if(tbmode) opts |= BDBTBZIP;
     if(ttmode) opts |= BDBTTCBS;
+    if(tsmode) opts |= BDBTLZ;
     tcbdbtune(bdb, lmemb, nmemb, bnum, apow, fpow, opts);
     tcbdbsetcache(bdb, lcnum, ncnum);
     if(xmsiz >= 0) tcbdbsetxmsiz(bdb, xmsiz);
@@ -312,6 +324,7 @@ bool tcadbopen(TCADB *adb, const char *name){
     if(tdmode) opts |= TDBTDEFLATE;
     if(tbmode) opts |= TDBTBZIP;
     if(ttmode) opts |= TDBTTCBS;
+    if(tsmode) opts |= TDBTLZ;
     tctdbtune(tdb, bnum, apow, fpow, opts);
     tctdbsetcache(tdb, rcnum, lcnum, ncnum);
     if(xmsiz >= 0) tctdbsetxmsiz(tdb, xmsiz);
@@ -1101,6 +1114,7 @@ bool tcadboptimize(TCADB *adb, const char *params){
   bool tdmode = false;
   bool tbmode = false;
   bool ttmode = false;
+  bool tsmode = false;
   int32_t lmemb = -1;
   int32_t nmemb = -1;
   int32_t width = -1;
@@ -1127,6 +1141,7 @@ bool tcadboptimize(TCADB *adb, const char *params){
       if(strchr(pv, 'd') || strchr(pv, 'D')) tdmode = true;
       if(strchr(pv, 'b') || strchr(pv, 'B')) tbmode = true;
       if(strchr(pv, 't') || strchr(pv, 'T')) ttmode = true;
+      if(strchr(pv, 's') || strchr(pv, 'S')) tsmode = true;
     } else if(!tcstricmp(elem, "lmemb")){
       lmemb = tcatoix(pv);
     } else if(!tcstricmp(elem, "nmemb")){
@@ -1161,6 +1176,7 @@ bool tcadboptimize(TCADB *adb, const char *params){
         if(tdmode) opts |= HDBTDEFLATE;
         if(tbmode) opts |= HDBTBZIP;
         if(ttmode) opts |= HDBTTCBS;
+        if(tsmode) opts |= HDBTLZ;
       }
       if(!tchdboptimize(adb->hdb, bnum, apow, fpow, opts)) err = true;
       break;
@@ -1173,6 +1189,7 @@ bool tcadboptimize(TCADB *adb, const char *params){
         if(tdmode) opts |= BDBTDEFLATE;
         if(tbmode) opts |= BDBTBZIP;
         if(ttmode) opts |= BDBTTCBS;
+        if(tsmode) opts |= BDBTLZ;
       }
       if(!tcbdboptimize(adb->bdb, lmemb, nmemb, bnum, apow, fpow, opts)) err = true;
       break;
@@ -1188,6 +1205,7 @@ bool tcadboptimize(TCADB *adb, const char *params){
         if(tdmode) opts |= TDBTDEFLATE;
         if(tbmode) opts |= TDBTBZIP;
         if(ttmode) opts |= TDBTTCBS;
+        if(tsmode) opts |= TDBTLZ;
       }
       if(!tctdboptimize(adb->tdb, bnum, apow, fpow, opts)) err = true;
       break;
@@ -2089,26 +2107,7 @@ TCLIST *tcadbmisc(TCADB *adb, const char *name, const TCLIST *args){
           rv = NULL;
         }
       } else if(!strcmp(name, "getlist")){
-        rv = tclistnew2(argc * 2);
-        bool err = false;
-        for(int i = 0; i < argc; i++){
-          const char *kbuf;
-          int ksiz;
-          TCLISTVAL(kbuf, args, i, ksiz);
-          int vsiz;
-          char *vbuf = tchdbget(adb->hdb, kbuf, ksiz, &vsiz);
-          if(vbuf){
-            TCLISTPUSH(rv, kbuf, ksiz);
-            TCLISTPUSH(rv, vbuf, vsiz);
-            TCFREE(vbuf);
-          } else if(tchdbecode(adb->hdb) != TCENOREC){
-            err = true;
-          }
-        }
-        if(err){
-          tclistdel(rv);
-          rv = NULL;
-        }
+        rv = tchdbgetmulti(adb->hdb, args);
       } else if(!strcmp(name, "getpart")){
         if(argc > 0){
           const char *kbuf;
@@ -2189,6 +2188,8 @@ TCLIST *tcadbmisc(TCADB *adb, const char *name, const TCLIST *args){
           tclistdel(rv);
           rv = NULL;
         }
+      } else if(!strcmp(name, "stat")){
+        rv = tcadbstatlist(tchdbstats(adb->hdb));
       } else if(!strcmp(name, "error")){
         rv = tclistnew2(1);
         int ecode = tchdbecode(adb->hdb);
@@ -2442,6 +2443,8 @@ TCLIST *tcadbmisc(TCADB *adb, const char *name, const TCLIST *args){
           tclistdel(rv);
           rv = NULL;
         }
+      } else if(!strcmp(name, "stat")){
+        rv = tcadbstatlist(tcbdbstats(adb->bdb));
       } else if(!strcmp(name, "error")){
         rv = tclistnew2(1);
         int ecode = tcbdbecode(adb->bdb);
@@ -2722,6 +2725,8 @@ TCLIST *tcadbmisc(TCADB *adb, const char *name, const TCLIST *args){
           tclistdel(rv);
           rv = NULL;
         }
+      } else if(!strcmp(name, "stat")){
+        rv = tcadbstatlist(tcfdbstats(adb->fdb));
       } else if(!strcmp(name, "error")){
         rv = tclistnew2(1);
         int ecode = tcfdbecode(adb->fdb);
@@ -3006,6 +3011,8 @@ TCLIST *tcadbmisc(TCADB *adb, const char *name, const TCLIST *args){
           tclistdel(rv);
           rv = NULL;
         }
+      } else if(!strcmp(name, "stat")){
+        rv = tcadbstatlist(tctdbstats(adb->tdb));
       } else if(!strcmp(name, "error")){
         rv = tclistnew2(1);
         int ecode = tctdbecode(adb->tdb);
@@ -4334,5 +4341,26 @@ static int tcadbtdbqrygetout(const void *pkbuf, int pksiz, TCMAP *cols, void *op
 }
 
 
+/* Get the summary of statistics of operations as a list.
+   `stats' specifies the statistics object.
+   The return value is a list object of names and values one after the other. */
+static TCLIST *tcadbstatlist(const TCSTATS *stats){
+  assert(stats);
+  TCMAP *map = tcstatsmap(stats);
+  TCLIST *rv = tclistnew2(TCMAPRNUM(map) * 2);
+  tcmapiterinit(map);
+  const char *kbuf;
+  int ksiz;
+  while((kbuf = tcmapiternext(map, &ksiz)) != NULL){
+    int vsiz;
+    const char *vbuf = tcmapiterval(kbuf, &vsiz);
+    TCLISTPUSH(rv, kbuf, ksiz);
+    TCLISTPUSH(rv, vbuf, vsiz);
+  }
+  tcmapdel(map);
+  return rv;
+}
+
+
 
 // END OF FILE
@@ -87,18 +87,20 @@ void tcadbdel(TCADB *adb);
    fails.  Tuning parameters can trail the name, separated by "#".  Each parameter is composed of
    the name and the value, separated by "=".  On-memory hash database supports "bnum", "capnum",
    and "capsiz".  On-memory tree database supports "capnum" and "capsiz".  Hash database supports
-   "mode", "bnum", "apow", "fpow", "opts", "rcnum", "xmsiz", and "dfunit".  B+ tree database
-   supports "mode", "lmemb", "nmemb", "bnum", "apow", "fpow", "opts", "lcnum", "ncnum", "xmsiz",
-   and "dfunit".  Fixed-length database supports "mode", "width", and "limsiz".  Table database
-   supports "mode", "bnum", "apow", "fpow", "opts", "rcnum", "lcnum", "ncnum", "xmsiz", "dfunit",
-   and "idx".
+   "mode", "bnum", "apow", "fpow", "opts", "rcnum", "rcsiz", "xmsiz", "dfunit", and "dfbps".
+   B+ tree database supports "mode", "lmemb", "nmemb", "bnum", "apow", "fpow", "opts", "lcnum", "ncnum",
+   "xmsiz", and "dfunit".  Fixed-length database supports "mode", "width", and "limsiz".  Table
+   database supports "mode", "bnum", "apow", "fpow", "opts", "rcnum", "lcnum", "ncnum", "xmsiz",
+   "dfunit", and "idx".
    If successful, the return value is true, else, it is false.
    The tuning parameter "capnum" specifies the capacity number of records.  "capsiz" specifies
    the capacity size of using memory.  Records spilled the capacity are removed by the storing
    order.  "mode" can contain "w" of writer, "r" of reader, "c" of creating, "t" of truncating,
    "e" of no locking, and "f" of non-blocking lock.  The default mode is relevant to "wc".
-   "opts" can contains "l" of large option, "d" of Deflate option, "b" of BZIP2 option, and "t"
-   of TCBS option.  "idx" specifies the column name of an index and its type separated by ":".
+   "rcsiz" specifies the maximum total size of cached records of hash database.
+   "dfbps" specifies the budget of background defragmentation in bytes per second.
+   "opts" can contains "l" of large option, "d" of Deflate option, "b" of BZIP2 option, "t" of
+   TCBS option, and "s" of LZ option.  "idx" specifies the column name of an index and its type separated by ":".
    For example, "casket.tch#bnum=1000000#opts=ld" means that the name of the database file is
    "casket.tch", and the bucket number is 1000000, and the options are large and Deflate. */
 bool tcadbopen(TCADB *adb, const char *name);
@@ -408,6 +410,9 @@ uint64_t tcadbsize(TCADB *adb);
    returns an empty list.  "getlist" is to retrieve records.  It receives keys, and returns keys
    and values of corresponding records one after the other.  "getpart" is to retrieve the partial
    value of a record.  It receives a key, the offset of the region, and the length of the region.
+   The hash, B+ tree, fixed-length, and table databases also support "stat", which is to get the
+   statistics of operations.  It receives nothing, and returns the names and the values of the
+   summary made by the function `tcstatsmap' one after the other.
    `args' specifies a list object containing arguments.
    If successful, the return value is a list object of the result.  `NULL' is returned on failure.
    Because the object of the return value is created with the function `tclistnew', it
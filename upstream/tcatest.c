@@ -828,6 +828,24 @@ static int procmisc(const char *name, int rnum){
   }
   tclistdel(args);
   args = tclistnew2(1);
+  int smode = tcadbomode(adb);
+  if(smode == ADBOHDB || smode == ADBOBDB || smode == ADBOFDB || smode == ADBOTDB){
+    TCLIST *rv = tcadbmisc(adb, "stat", args);
+    if(rv){
+      int gnum = -1;
+      for(int i = 0; i < tclistnum(rv) - 1; i += 2){
+        if(!strcmp(tclistval2(rv, i), "get_count")) gnum = tcatoi(tclistval2(rv, i + 1));
+      }
+      if(gnum < inum){
+        eprint(adb, __LINE__, "(validation)");
+        err = true;
+      }
+      tclistdel(rv);
+    } else {
+      eprint(adb, __LINE__, "tcadbmisc");
+      err = true;
+    }
+  }
   if(myrand(10) == 0){
     TCLIST *rv = tcadbmisc(adb, "sync", args);
     if(rv){
@@ -37,10 +37,17 @@
 #define BDBDEFNCNUM    512               // default number of node cache
 #define BDBDEFLSMAX    16384             // default maximum size of each leaf
 #define BDBMINLSMAX    512               // minimum maximum size of each leaf
+#define BDBXTINHERIT   UINT32_MAX        // expiration time to keep that of the existing record
+#define BDBXTSWINTV    60                // interval of passes of the expiration sweeper in seconds
+#define BDBXTSWUNIT    64                // number of leaves swept at once in a whole pass
+#define BDBXTIDXRAT    2                 // ratio of the expiration index to the record number
+#define BDBXTIDXMIN    65536             // minimum size of the expiration index to be rebuilt
+#define BDBLEAFXTBIT   (1ULL<<56)        // bit of the previous ID of a leaf with expiration times
 
 typedef struct {                         // type of structure for a record
   int ksiz;                              // size of the key region
   int vsiz;                              // size of the value region
+  uint32_t xtime;                        // expiration time, or 0 if it never expires
   TCLIST *rest;                          // list of value objects
 } BDBREC;
 
@@ -95,12 +102,15 @@ typedef struct {                         // type of structure for a duplication
   ((TC_bdb)->mmtx ? tcbdbunlockcache(TC_bdb) : true)
 #define BDBTHREADYIELD(TC_bdb)                          \
   do { if((TC_bdb)->mmtx) sched_yield(); } while(false)
+#define BDBRECEXPIRED(TC_rec)                                           \
+  ((TC_rec)->xtime > 0 && (TC_rec)->xtime <= (uint32_t)time(NULL))
 
 
 /* private function prototypes */
 static void tcbdbclear(TCBDB *bdb);
 static void tcbdbdumpmeta(TCBDB *bdb);
 static void tcbdbloadmeta(TCBDB *bdb);
+static uint32_t tcbdbxtime(int64_t xt);
 static BDBLEAF *tcbdbleafnew(TCBDB *bdb, uint64_t prev, uint64_t next);
 static bool tcbdbleafcacheout(TCBDB *bdb, BDBLEAF *leaf);
 static bool tcbdbleafsave(TCBDB *bdb, BDBLEAF *leaf);
@@ -108,7 +118,9 @@ static BDBLEAF *tcbdbleafload(TCBDB *bdb, uint64_t id);
 static bool tcbdbleafcheck(TCBDB *bdb, uint64_t id);
 static BDBLEAF *tcbdbgethistleaf(TCBDB *bdb, const char *kbuf, int ksiz, uint64_t id);
 static bool tcbdbleafaddrec(TCBDB *bdb, BDBLEAF *leaf, int dmode,
-                            const char *kbuf, int ksiz, const char *vbuf, int vsiz);
+                            const char *kbuf, int ksiz, const char *vbuf, int vsiz,
+                            uint32_t xtime);
+static void tcbdbleafoutrec(TCBDB *bdb, BDBLEAF *leaf, int ri);
 static BDBLEAF *tcbdbleafdivide(TCBDB *bdb, BDBLEAF *leaf);
 static bool tcbdbleafkill(TCBDB *bdb, BDBLEAF *leaf);
 static BDBNODE *tcbdbnodenew(TCBDB *bdb, uint64_t heir);
@@ -126,18 +138,26 @@ static void tcbdbcachepurge(TCBDB *bdb);
 static bool tcbdbopenimpl(TCBDB *bdb, const char *path, int omode);
 static bool tcbdbcloseimpl(TCBDB *bdb);
 static bool tcbdbputimpl(TCBDB *bdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz,
-                         int dmode);
+                         int dmode, uint32_t xtime);
 static bool tcbdboutimpl(TCBDB *bdb, const char *kbuf, int ksiz);
 static bool tcbdboutlist(TCBDB *bdb, const char *kbuf, int ksiz);
 static const char *tcbdbgetimpl(TCBDB *bdb, const char *kbuf, int ksiz, int *sp);
 static int tcbdbgetnum(TCBDB *bdb, const char *kbuf, int ksiz);
 static TCLIST *tcbdbgetlist(TCBDB *bdb, const char *kbuf, int ksiz);
+static int64_t tcbdbgetxtimpl(TCBDB *bdb, const char *kbuf, int ksiz);
 static bool tcbdbrangeimpl(TCBDB *bdb, const char *bkbuf, int bksiz, bool binc,
                            const char *ekbuf, int eksiz, bool einc, int max, TCLIST *keys);
 static bool tcbdbrangefwm(TCBDB *bdb, const char *pbuf, int psiz, int max, TCLIST *keys);
 static bool tcbdboptimizeimpl(TCBDB *bdb, int32_t lmemb, int32_t nmemb,
                               int64_t bnum, int8_t apow, int8_t fpow, uint8_t opts);
 static bool tcbdbvanishimpl(TCBDB *bdb);
+static bool tcbdbxtstep(TCBDB *bdb, int64_t step);
+static bool tcbdbxtsweep(TCBDB *bdb, int64_t step);
+static bool tcbdbxtleaf(TCBDB *bdb, BDBLEAF *leaf, time_t now, bool index);
+static void tcbdbxtindex(TCBDB *bdb, uint64_t id, uint32_t xtime);
+static void tcbdbxtreset(TCBDB *bdb);
+static void tcbdbxtsetnext(TCBDB *bdb);
+static bool tcbdbbkproc(bool begin, void *op);
 static bool tcbdblockmethod(TCBDB *bdb, bool wr);
 static bool tcbdbunlockmethod(TCBDB *bdb);
 static bool tcbdblockcache(TCBDB *bdb);
@@ -178,6 +198,7 @@ TCBDB *tcbdbnew(void){
   TCMALLOC(bdb, sizeof(*bdb));
   tcbdbclear(bdb);
   bdb->hdb = tchdbnew();
+  bdb->stats = tcstatsnew();
   TCMALLOC(bdb->hist, sizeof(*bdb->hist) * BDBLEVELMAX);
   tchdbtune(bdb->hdb, BDBDEFBNUM, BDBDEFAPOW, BDBDEFFPOW, 0);
   tchdbsetxmsiz(bdb->hdb, 0);
@@ -190,6 +211,7 @@ void tcbdbdel(TCBDB *bdb){
   assert(bdb);
   if(bdb->open) tcbdbclose(bdb);
   TCFREE(bdb->hist);
+  tcstatsdel(bdb->stats);
   tchdbdel(bdb->hdb);
   if(bdb->mmtx){
     pthread_mutex_destroy(bdb->cmtx);
@@ -261,6 +283,7 @@ bool tcbdbtune(TCBDB *bdb, int32_t lmemb, int32_t nmemb,
   if(opts & BDBTDEFLATE) hopts |= HDBTDEFLATE;
   if(opts & BDBTBZIP) hopts |= HDBTBZIP;
   if(opts & BDBTTCBS) hopts |= HDBTTCBS;
+  if(opts & BDBTLZ) hopts |= HDBTLZ;
   if(opts & BDBTEXCODEC) hopts |= HDBTEXCODEC;
   bnum = (bnum > 0) ? bnum : BDBDEFBNUM;
   apow = (apow >= 0) ? apow : BDBDEFAPOW;
@@ -293,6 +316,17 @@ bool tcbdbsetxmsiz(TCBDB *bdb, int64_t xmsiz){
 }
 
 
+/* Set the options of the mapped region of a B+ tree database object. */
+bool tcbdbsetmapopts(TCBDB *bdb, int mopts){
+  assert(bdb);
+  if(bdb->open){
+    tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  return tchdbsetmapopts(bdb->hdb, mopts);
+}
+
+
 /* Set the unit step number of auto defragmentation of a B+ tree database object. */
 bool tcbdbsetdfunit(TCBDB *bdb, int32_t dfunit){
   assert(bdb);
@@ -337,14 +371,16 @@ bool tcbdbclose(TCBDB *bdb){
 /* Store a record into a B+ tree database object. */
 bool tcbdbput(TCBDB *bdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz){
   assert(bdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  uint64_t stime = tcstatsclock();
   if(!BDBLOCKMETHOD(bdb, true)) return false;
   if(!bdb->open || !bdb->wmode){
     tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
     BDBUNLOCKMETHOD(bdb);
     return false;
   }
-  bool rv = tcbdbputimpl(bdb, kbuf, ksiz, vbuf, vsiz, BDBPDOVER);
+  bool rv = tcbdbputimpl(bdb, kbuf, ksiz, vbuf, vsiz, BDBPDOVER, 0);
   BDBUNLOCKMETHOD(bdb);
+  tcstatsop(bdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -356,17 +392,36 @@ bool tcbdbput2(TCBDB *bdb, const char *kstr, const char *vstr){
 }
 
 
+/* Store a record with an expiration time into a B+ tree database object. */
+bool tcbdbputxt(TCBDB *bdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz, int64_t xt){
+  assert(bdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  uint64_t stime = tcstatsclock();
+  if(!BDBLOCKMETHOD(bdb, true)) return false;
+  if(!bdb->open || !bdb->wmode){
+    tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    BDBUNLOCKMETHOD(bdb);
+    return false;
+  }
+  bool rv = tcbdbputimpl(bdb, kbuf, ksiz, vbuf, vsiz, BDBPDOVER, tcbdbxtime(xt));
+  BDBUNLOCKMETHOD(bdb);
+  tcstatsop(bdb->stats, TCSOPUT, stime);
+  return rv;
+}
+
+
 /* Store a new record into a B+ tree database object. */
 bool tcbdbputkeep(TCBDB *bdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz){
   assert(bdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  uint64_t stime = tcstatsclock();
   if(!BDBLOCKMETHOD(bdb, true)) return false;
   if(!bdb->open || !bdb->wmode){
     tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
     BDBUNLOCKMETHOD(bdb);
     return false;
   }
-  bool rv = tcbdbputimpl(bdb, kbuf, ksiz, vbuf, vsiz, BDBPDKEEP);
+  bool rv = tcbdbputimpl(bdb, kbuf, ksiz, vbuf, vsiz, BDBPDKEEP, BDBXTINHERIT);
   BDBUNLOCKMETHOD(bdb);
+  tcstatsop(bdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -381,14 +436,16 @@ bool tcbdbputkeep2(TCBDB *bdb, const char *kstr, const char *vstr){
 /* Concatenate a value at the end of the existing record in a B+ tree database object. */
 bool tcbdbputcat(TCBDB *bdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz){
   assert(bdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  uint64_t stime = tcstatsclock();
   if(!BDBLOCKMETHOD(bdb, true)) return false;
   if(!bdb->open || !bdb->wmode){
     tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
     BDBUNLOCKMETHOD(bdb);
     return false;
   }
-  bool rv = tcbdbputimpl(bdb, kbuf, ksiz, vbuf, vsiz, BDBPDCAT);
+  bool rv = tcbdbputimpl(bdb, kbuf, ksiz, vbuf, vsiz, BDBPDCAT, BDBXTINHERIT);
   BDBUNLOCKMETHOD(bdb);
+  tcstatsop(bdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -403,14 +460,16 @@ bool tcbdbputcat2(TCBDB *bdb, const char *kstr, const char *vstr){
 /* Store a record into a B+ tree database object with allowing duplication of keys. */
 bool tcbdbputdup(TCBDB *bdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz){
   assert(bdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  uint64_t stime = tcstatsclock();
   if(!BDBLOCKMETHOD(bdb, true)) return false;
   if(!bdb->open || !bdb->wmode){
     tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
     BDBUNLOCKMETHOD(bdb);
     return false;
   }
-  bool rv = tcbdbputimpl(bdb, kbuf, ksiz, vbuf, vsiz, BDBPDDUP);
+  bool rv = tcbdbputimpl(bdb, kbuf, ksiz, vbuf, vsiz, BDBPDDUP, BDBXTINHERIT);
   BDBUNLOCKMETHOD(bdb);
+  tcstatsop(bdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -425,6 +484,7 @@ bool tcbdbputdup2(TCBDB *bdb, const char *kstr, const char *vstr){
 /* Store records into a B+ tree database object with allowing duplication of keys. */
 bool tcbdbputdup3(TCBDB *bdb, const void *kbuf, int ksiz, const TCLIST *vals){
   assert(bdb && kbuf && ksiz >= 0 && vals);
+  uint64_t stime = tcstatsclock();
   if(!BDBLOCKMETHOD(bdb, true)) return false;
   if(!bdb->open || !bdb->wmode){
     tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -437,9 +497,10 @@ bool tcbdbputdup3(TCBDB *bdb, const void *kbuf, int ksiz, const TCLIST *vals){
     const char *vbuf;
     int vsiz;
     TCLISTVAL(vbuf, vals, i, vsiz);
-    if(!tcbdbputimpl(bdb, kbuf, ksiz, vbuf, vsiz, BDBPDDUP)) err = true;
+    if(!tcbdbputimpl(bdb, kbuf, ksiz, vbuf, vsiz, BDBPDDUP, BDBXTINHERIT)) err = true;
   }
   BDBUNLOCKMETHOD(bdb);
+  tcstatsop(bdb->stats, TCSOPUT, stime);
   return !err;
 }
 
@@ -447,6 +508,7 @@ bool tcbdbputdup3(TCBDB *bdb, const void *kbuf, int ksiz, const TCLIST *vals){
 /* Remove a record of a B+ tree database object. */
 bool tcbdbout(TCBDB *bdb, const void *kbuf, int ksiz){
   assert(bdb && kbuf && ksiz >= 0);
+  uint64_t stime = tcstatsclock();
   if(!BDBLOCKMETHOD(bdb, true)) return false;
   if(!bdb->open || !bdb->wmode){
     tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -455,6 +517,7 @@ bool tcbdbout(TCBDB *bdb, const void *kbuf, int ksiz){
   }
   bool rv = tcbdboutimpl(bdb, kbuf, ksiz);
   BDBUNLOCKMETHOD(bdb);
+  tcstatsop(bdb->stats, TCSOOUT, stime);
   return rv;
 }
 
@@ -469,6 +532,7 @@ bool tcbdbout2(TCBDB *bdb, const char *kstr){
 /* Remove records of a B+ tree database object. */
 bool tcbdbout3(TCBDB *bdb, const void *kbuf, int ksiz){
   assert(bdb && kbuf && ksiz >= 0);
+  uint64_t stime = tcstatsclock();
   if(!BDBLOCKMETHOD(bdb, true)) return false;
   if(!bdb->open || !bdb->wmode){
     tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -477,6 +541,7 @@ bool tcbdbout3(TCBDB *bdb, const void *kbuf, int ksiz){
   }
   bool rv = tcbdboutlist(bdb, kbuf, ksiz);
   BDBUNLOCKMETHOD(bdb);
+  tcstatsop(bdb->stats, TCSOOUT, stime);
   return rv;
 }
 
@@ -484,6 +549,7 @@ bool tcbdbout3(TCBDB *bdb, const void *kbuf, int ksiz){
 /* Retrieve a record in a B+ tree database object. */
 void *tcbdbget(TCBDB *bdb, const void *kbuf, int ksiz, int *sp){
   assert(bdb && kbuf && ksiz >= 0 && sp);
+  uint64_t stime = tcstatsclock();
   if(!BDBLOCKMETHOD(bdb, false)) return NULL;
   if(!bdb->open){
     tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -506,6 +572,8 @@ void *tcbdbget(TCBDB *bdb, const void *kbuf, int ksiz, int *sp){
     }
     BDBUNLOCKMETHOD(bdb);
   }
+  if(!rv) tcstatsadd(bdb->stats, TCSCMISS, 1);
+  tcstatsop(bdb->stats, TCSOGET, stime);
   return rv;
 }
 
@@ -521,6 +589,7 @@ char *tcbdbget2(TCBDB *bdb, const char *kstr){
 /* Retrieve a record in a B+ tree database object and write the value into a buffer. */
 const void *tcbdbget3(TCBDB *bdb, const void *kbuf, int ksiz, int *sp){
   assert(bdb && kbuf && ksiz >= 0 && sp);
+  uint64_t stime = tcstatsclock();
   if(!BDBLOCKMETHOD(bdb, false)) return NULL;
   if(!bdb->open){
     tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -534,6 +603,8 @@ const void *tcbdbget3(TCBDB *bdb, const void *kbuf, int ksiz, int *sp){
     if(!bdb->tran && !tcbdbcacheadjust(bdb)) rv = NULL;
     BDBUNLOCKMETHOD(bdb);
   }
+  if(!rv) tcstatsadd(bdb->stats, TCSCMISS, 1);
+  tcstatsop(bdb->stats, TCSOGET, stime);
   return rv;
 }
 
@@ -541,6 +612,7 @@ const void *tcbdbget3(TCBDB *bdb, const void *kbuf, int ksiz, int *sp){
 /* Retrieve records in a B+ tree database object. */
 TCLIST *tcbdbget4(TCBDB *bdb, const void *kbuf, int ksiz){
   assert(bdb && kbuf && ksiz >= 0);
+  uint64_t stime = tcstatsclock();
   if(!BDBLOCKMETHOD(bdb, false)) return NULL;
   if(!bdb->open){
     tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -557,6 +629,8 @@ TCLIST *tcbdbget4(TCBDB *bdb, const void *kbuf, int ksiz){
     }
     BDBUNLOCKMETHOD(bdb);
   }
+  if(!rv) tcstatsadd(bdb->stats, TCSCMISS, 1);
+  tcstatsop(bdb->stats, TCSOGET, stime);
   return rv;
 }
 
@@ -604,6 +678,26 @@ int tcbdbvsiz2(TCBDB *bdb, const char *kstr){
 }
 
 
+/* Get the expiration time of a record in a B+ tree database object. */
+int64_t tcbdbgetxt(TCBDB *bdb, const void *kbuf, int ksiz){
+  assert(bdb && kbuf && ksiz >= 0);
+  if(!BDBLOCKMETHOD(bdb, false)) return -1;
+  if(!bdb->open){
+    tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    BDBUNLOCKMETHOD(bdb);
+    return -1;
+  }
+  int64_t rv = tcbdbgetxtimpl(bdb, kbuf, ksiz);
+  bool adj = TCMAPRNUM(bdb->leafc) > bdb->lcnum || TCMAPRNUM(bdb->nodec) > bdb->ncnum;
+  BDBUNLOCKMETHOD(bdb);
+  if(adj && BDBLOCKMETHOD(bdb, true)){
+    if(!bdb->tran && !tcbdbcacheadjust(bdb)) rv = -1;
+    BDBUNLOCKMETHOD(bdb);
+  }
+  return rv;
+}
+
+
 /* Get keys of ranged records in a B+ tree database object. */
 TCLIST *tcbdbrange(TCBDB *bdb, const void *bkbuf, int bksiz, bool binc,
                    const void *ekbuf, int eksiz, bool einc, int max){
@@ -666,14 +760,16 @@ TCLIST *tcbdbfwmkeys2(TCBDB *bdb, const char *pstr, int max){
 /* Add an integer to a record in a B+ tree database object. */
 int tcbdbaddint(TCBDB *bdb, const void *kbuf, int ksiz, int num){
   assert(bdb && kbuf && ksiz >= 0);
+  uint64_t stime = tcstatsclock();
   if(!BDBLOCKMETHOD(bdb, true)) return INT_MIN;
   if(!bdb->open || !bdb->wmode){
     tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
     BDBUNLOCKMETHOD(bdb);
     return INT_MIN;
   }
-  bool rv = tcbdbputimpl(bdb, kbuf, ksiz, (char *)&num, sizeof(num), BDBPDADDINT);
+  bool rv = tcbdbputimpl(bdb, kbuf, ksiz, (char *)&num, sizeof(num), BDBPDADDINT, BDBXTINHERIT);
   BDBUNLOCKMETHOD(bdb);
+  tcstatsop(bdb->stats, TCSOPUT, stime);
   return rv ? num : INT_MIN;
 }
 
@@ -681,14 +777,16 @@ int tcbdbaddint(TCBDB *bdb, const void *kbuf, int ksiz, int num){
 /* Add a real number to a record in a B+ tree database object. */
 double tcbdbadddouble(TCBDB *bdb, const void *kbuf, int ksiz, double num){
   assert(bdb && kbuf && ksiz >= 0);
+  uint64_t stime = tcstatsclock();
   if(!BDBLOCKMETHOD(bdb, true)) return nan("");
   if(!bdb->open || !bdb->wmode){
     tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
     BDBUNLOCKMETHOD(bdb);
     return nan("");
   }
-  bool rv = tcbdbputimpl(bdb, kbuf, ksiz, (char *)&num, sizeof(num), BDBPDADDDBL);
+  bool rv = tcbdbputimpl(bdb, kbuf, ksiz, (char *)&num, sizeof(num), BDBPDADDDBL, BDBXTINHERIT);
   BDBUNLOCKMETHOD(bdb);
+  tcstatsop(bdb->stats, TCSOPUT, stime);
   return rv ? num : nan("");
 }
 
@@ -696,6 +794,7 @@ double tcbdbadddouble(TCBDB *bdb, const void *kbuf, int ksiz, double num){
 /* Synchronize updated contents of a B+ tree database object with the file and the device. */
 bool tcbdbsync(TCBDB *bdb){
   assert(bdb);
+  uint64_t stime = tcstatsclock();
   if(!BDBLOCKMETHOD(bdb, true)) return false;
   if(!bdb->open || !bdb->wmode || bdb->tran){
     tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -704,6 +803,7 @@ bool tcbdbsync(TCBDB *bdb){
   }
   bool rv = tcbdbmemsync(bdb, true);
   BDBUNLOCKMETHOD(bdb);
+  tcstatsop(bdb->stats, TCSOSYNC, stime);
   return rv;
 }
 
@@ -815,6 +915,20 @@ bool tcbdbcopy(TCBDB *bdb, const char *path){
 }
 
 
+/* Copy the database file of a B+ tree database object without blocking writers. */
+bool tcbdbbackup(TCBDB *bdb, const char *path){
+  assert(bdb && path);
+  if(!BDBLOCKMETHOD(bdb, false)) return false;
+  if(!bdb->open){
+    tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    BDBUNLOCKMETHOD(bdb);
+    return false;
+  }
+  BDBUNLOCKMETHOD(bdb);
+  return tchdbbackupproc(bdb->hdb, path, tcbdbbkproc, bdb);
+}
+
+
 /* Begin the transaction of a B+ tree database object. */
 bool tcbdbtranbegin(TCBDB *bdb){
   assert(bdb);
@@ -848,6 +962,7 @@ bool tcbdbtranbegin(TCBDB *bdb){
 /* Commit the transaction of a B+ tree database object. */
 bool tcbdbtrancommit(TCBDB *bdb){
   assert(bdb);
+  uint64_t stime = tcstatsclock();
   if(!BDBLOCKMETHOD(bdb, true)) return false;
   if(!bdb->open || !bdb->wmode || !bdb->tran){
     tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -866,6 +981,7 @@ bool tcbdbtrancommit(TCBDB *bdb){
     err = true;
   }
   BDBUNLOCKMETHOD(bdb);
+  tcstatsop(bdb->stats, TCSOTRAN, stime);
   return !err;
 }
 
@@ -887,6 +1003,8 @@ bool tcbdbtranabort(TCBDB *bdb){
   bdb->rbopaque = NULL;
   bdb->hleaf = 0;
   bdb->lleaf = 0;
+  bdb->xtcur = 0;
+  tcbdbxtreset(bdb);
   bdb->clock++;
   bool err = false;
   if(!tcbdbcacheadjust(bdb)) err = true;
@@ -1035,6 +1153,7 @@ bool tcbdbcurjump2(BDBCUR *cur, const char *kstr){
 /* Move a cursor object to the previous record. */
 bool tcbdbcurprev(BDBCUR *cur){
   assert(cur);
+  uint64_t stime = tcstatsclock();
   TCBDB *bdb = cur->bdb;
   if(!BDBLOCKMETHOD(bdb, false)) return false;
   if(!bdb->open){
@@ -1054,6 +1173,7 @@ bool tcbdbcurprev(BDBCUR *cur){
     if(!bdb->tran && !tcbdbcacheadjust(bdb)) rv = false;
     BDBUNLOCKMETHOD(bdb);
   }
+  tcstatsop(bdb->stats, TCSOITER, stime);
   return rv;
 }
 
@@ -1061,6 +1181,7 @@ bool tcbdbcurprev(BDBCUR *cur){
 /* Move a cursor object to the next record. */
 bool tcbdbcurnext(BDBCUR *cur){
   assert(cur);
+  uint64_t stime = tcstatsclock();
   TCBDB *bdb = cur->bdb;
   if(!BDBLOCKMETHOD(bdb, false)) return false;
   if(!bdb->open){
@@ -1080,6 +1201,7 @@ bool tcbdbcurnext(BDBCUR *cur){
     if(!bdb->tran && !tcbdbcacheadjust(bdb)) rv = false;
     BDBUNLOCKMETHOD(bdb);
   }
+  tcstatsop(bdb->stats, TCSOITER, stime);
   return rv;
 }
 
@@ -1561,6 +1683,30 @@ uint32_t tcbdbdfunit(TCBDB *bdb){
 /* Perform dynamic defragmentation of a B+ tree database object. */
 bool tcbdbdefrag(TCBDB *bdb, int64_t step){
   assert(bdb);
+  bool full = step < 1;
+  bool first = true;
+  bool cont = bdb->expire;
+  while(cont){
+    if(!BDBLOCKMETHOD(bdb, true)) return false;
+    if(!bdb->open || !bdb->wmode){
+      tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
+      BDBUNLOCKMETHOD(bdb);
+      return false;
+    }
+    if(full && first){
+      bdb->xtcur = 0;
+      bdb->xtnext = 0;
+    }
+    first = false;
+    bool err = false;
+    if(!tcbdbxtstep(bdb, full ? BDBXTSWUNIT : step)) err = true;
+    if(!bdb->tran && !tcbdbcacheadjust(bdb)) err = true;
+    cont = full && !bdb->tran && bdb->expire &&
+      (bdb->xtcur > 0 || time(NULL) >= bdb->xtnext);
+    BDBUNLOCKMETHOD(bdb);
+    if(err) return false;
+    BDBTHREADYIELD(bdb);
+  }
   if(!BDBLOCKMETHOD(bdb, false)) return false;
   if(!bdb->open || !bdb->wmode){
     tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -1614,17 +1760,26 @@ bool tcbdbcacheclear(TCBDB *bdb){
 }
 
 
+/* Get the statistics of operations of a B+ tree database object. */
+TCSTATS *tcbdbstats(TCBDB *bdb){
+  assert(bdb);
+  return bdb->stats;
+}
+
+
 /* Store a new record into a B+ tree database object with backward duplication. */
 bool tcbdbputdupback(TCBDB *bdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz){
   assert(bdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  uint64_t stime = tcstatsclock();
   if(!BDBLOCKMETHOD(bdb, true)) return false;
   if(!bdb->open || !bdb->wmode){
     tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
     BDBUNLOCKMETHOD(bdb);
     return false;
   }
-  bool rv = tcbdbputimpl(bdb, kbuf, ksiz, vbuf, vsiz, BDBPDDUPB);
+  bool rv = tcbdbputimpl(bdb, kbuf, ksiz, vbuf, vsiz, BDBPDDUPB, BDBXTINHERIT);
   BDBUNLOCKMETHOD(bdb);
+  tcstatsop(bdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -1633,6 +1788,7 @@ bool tcbdbputdupback(TCBDB *bdb, const void *kbuf, int ksiz, const void *vbuf, i
 bool tcbdbputproc(TCBDB *bdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz,
                   TCPDPROC proc, void *op){
   assert(bdb && kbuf && ksiz >= 0 && proc);
+  uint64_t stime = tcstatsclock();
   if(!BDBLOCKMETHOD(bdb, true)) return false;
   if(!bdb->open || !bdb->wmode){
     tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -1655,9 +1811,10 @@ bool tcbdbputproc(TCBDB *bdb, const void *kbuf, int ksiz, const void *vbuf, int
   wp += sizeof(procptr);
   memcpy(wp, kbuf, ksiz);
   kbuf = rbuf + sizeof(procptr);
-  bool rv = tcbdbputimpl(bdb, kbuf, ksiz, vbuf, vsiz, BDBPDPROC);
+  bool rv = tcbdbputimpl(bdb, kbuf, ksiz, vbuf, vsiz, BDBPDPROC, BDBXTINHERIT);
   if(rbuf != (char *)stack) TCFREE(rbuf);
   BDBUNLOCKMETHOD(bdb);
+  tcstatsop(bdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -1749,6 +1906,12 @@ static void tcbdbclear(TCBDB *bdb){
   bdb->tran = false;
   bdb->rbopaque = NULL;
   bdb->clock = 0;
+  bdb->stats = NULL;
+  bdb->expire = false;
+  bdb->xtcur = 0;
+  bdb->xtnext = 0;
+  bdb->xtidx = NULL;
+  bdb->xtinum = 0;
   bdb->cnt_saveleaf = -1;
   bdb->cnt_loadleaf = -1;
   bdb->cnt_killleaf = -1;
@@ -1783,7 +1946,8 @@ static void tcbdbdumpmeta(TCBDB *bdb){
   } else {
     *(uint8_t *)(wp++) = 0xff;
   }
-  wp += 7;
+  *(uint8_t *)(wp++) = bdb->expire ? 0x1 : 0x0;
+  wp += 6;
   uint32_t lnum;
   lnum = bdb->lmemb;
   lnum = TCHTOIL(lnum);
@@ -1835,7 +1999,8 @@ static void tcbdbloadmeta(TCBDB *bdb){
   } else if(cnum == 0x3){
     bdb->cmp = tccmpint64;
   }
-  rp += 7;
+  bdb->expire = *(uint8_t *)(rp++) & 0x1;
+  rp += 6;
   uint32_t lnum;
   memcpy(&lnum, rp, sizeof(lnum));
   rp += sizeof(lnum);
@@ -1865,6 +2030,22 @@ static void tcbdbloadmeta(TCBDB *bdb){
 }
 
 
+/* Get the expiration time to be stored from that specified by the caller.
+   `xt' specifies the expiration time.  If it is positive, it is the lifetime in seconds from now.
+   If it is negative, its absolute value is the time in seconds since the epoch.
+   The return value is the expiration time to be stored.  0 means that it never expires. */
+static uint32_t tcbdbxtime(int64_t xt){
+  if(xt == 0) return 0;
+  if(xt > UINT32_MAX){
+    xt = UINT32_MAX;
+  } else if(xt < -(int64_t)UINT32_MAX){
+    xt = -(int64_t)UINT32_MAX;
+  }
+  int64_t xtime = (xt > 0) ? (int64_t)time(NULL) + xt : -xt;
+  return (xtime < BDBXTINHERIT) ? xtime : BDBXTINHERIT - 1;
+}
+
+
 /* Create a new leaf.
    `bdb' specifies the B+ tree database object.
    `prev' specifies the ID number of the previous leaf.
@@ -1919,15 +2100,24 @@ static bool tcbdbleafsave(TCBDB *bdb, BDBLEAF *leaf){
   char *wp = hbuf;
   uint64_t llnum;
   int step;
+  TCPTRLIST *recs = leaf->recs;
+  int ln = TCPTRLISTNUM(recs);
+  bool xt = false;
+  for(int i = 0; i < ln; i++){
+    BDBREC *rec = TCPTRLISTVAL(recs, i);
+    if(rec->xtime > 0){
+      xt = true;
+      break;
+    }
+  }
   llnum = leaf->prev;
+  if(xt) llnum |= BDBLEAFXTBIT;
   TCSETVNUMBUF64(step, wp, llnum);
   wp += step;
   llnum = leaf->next;
   TCSETVNUMBUF64(step, wp, llnum);
   wp += step;
   TCXSTRCAT(rbuf, hbuf, wp - hbuf);
-  TCPTRLIST *recs = leaf->recs;
-  int ln = TCPTRLISTNUM(recs);
   for(int i = 0; i < ln; i++){
     BDBREC *rec = TCPTRLISTVAL(recs, i);
     char *dbuf = (char *)rec + sizeof(*rec);
@@ -1943,6 +2133,11 @@ static bool tcbdbleafsave(TCBDB *bdb, BDBLEAF *leaf){
     int rnum = rest ? TCLISTNUM(rest) : 0;
     TCSETVNUMBUF(step, wp, rnum);
     wp += step;
+    if(xt){
+      llnum = rec->xtime;
+      TCSETVNUMBUF64(step, wp, llnum);
+      wp += step;
+    }
     TCXSTRCAT(rbuf, hbuf, wp - hbuf);
     TCXSTRCAT(rbuf, dbuf, rec->ksiz);
     TCXSTRCAT(rbuf, dbuf + rec->ksiz + TCALIGNPAD(rec->ksiz), rec->vsiz);
@@ -1961,6 +2156,7 @@ static bool tcbdbleafsave(TCBDB *bdb, BDBLEAF *leaf){
     err = true;
   if(!leaf->dead && !tchdbput(bdb->hdb, hbuf, step, TCXSTRPTR(rbuf), TCXSTRSIZE(rbuf)))
     err = true;
+  if(!leaf->dead) tcstatsadd(bdb->stats, TCSCWRITE, TCXSTRSIZE(rbuf));
   tcxstrdel(rbuf);
   leaf->dirty = false;
   leaf->dead = false;
@@ -1978,6 +2174,7 @@ static BDBLEAF *tcbdbleafload(TCBDB *bdb, uint64_t id){
   int rsiz;
   BDBLEAF *leaf = (BDBLEAF *)tcmapget3(bdb->leafc, &id, sizeof(id), &rsiz);
   if(leaf){
+    tcstatsadd(bdb->stats, TCSCCACHE, 1);
     if(clk) BDBUNLOCKCACHE(bdb);
     return leaf;
   }
@@ -2002,11 +2199,13 @@ static BDBLEAF *tcbdbleafload(TCBDB *bdb, uint64_t id){
     }
     rp = rbuf;
   }
+  tcstatsadd(bdb->stats, TCSCREAD, rsiz);
   BDBLEAF lent;
   lent.id = id;
   uint64_t llnum;
   TCREADVNUMBUF64(rp, llnum, step);
-  lent.prev = llnum;
+  lent.prev = llnum & ~BDBLEAFXTBIT;
+  bool xt = llnum & BDBLEAFXTBIT;
   rp += step;
   rsiz -= step;
   TCREADVNUMBUF64(rp, llnum, step);
@@ -2031,6 +2230,13 @@ static BDBLEAF *tcbdbleafload(TCBDB *bdb, uint64_t id){
     TCREADVNUMBUF(rp, rnum, step);
     rp += step;
     rsiz -= step;
+    uint32_t xtime = 0;
+    if(xt){
+      TCREADVNUMBUF64(rp, llnum, step);
+      xtime = llnum;
+      rp += step;
+      rsiz -= step;
+    }
     if(rsiz < ksiz + vsiz + rnum){
       err = true;
       break;
@@ -2047,6 +2253,7 @@ static BDBLEAF *tcbdbleafload(TCBDB *bdb, uint64_t id){
     memcpy(dbuf + ksiz + psiz, rp, vsiz);
     dbuf[ksiz+psiz+vsiz] = '\0';
     nrec->vsiz = vsiz;
+    nrec->xtime = xtime;
     rp += vsiz;
     rsiz -= vsiz;
     lent.size += ksiz;
@@ -2153,8 +2360,13 @@ static BDBLEAF *tcbdbgethistleaf(TCBDB *bdb, const char *kbuf, int ksiz, uint64_
    `vsiz' specifies the size of the region of the value.
    If successful, the return value is true, else, it is false. */
 static bool tcbdbleafaddrec(TCBDB *bdb, BDBLEAF *leaf, int dmode,
-                            const char *kbuf, int ksiz, const char *vbuf, int vsiz){
+                            const char *kbuf, int ksiz, const char *vbuf, int vsiz,
+                            uint32_t xtime){
   assert(bdb && leaf && kbuf && ksiz >= 0);
+  if(xtime > 0 && xtime != BDBXTINHERIT){
+    bdb->expire = true;
+    tcbdbxtindex(bdb, leaf->id, xtime);
+  }
   TCCMP cmp = bdb->cmp;
   void *cmpop = bdb->cmpop;
   TCPTRLIST *recs = leaf->recs;
@@ -2189,6 +2401,11 @@ static bool tcbdbleafaddrec(TCBDB *bdb, BDBLEAF *leaf, int dmode,
     } else {
       rv = cmp(kbuf, ksiz, dbuf, rec->ksiz, cmpop);
     }
+    if(rv == 0 && BDBRECEXPIRED(rec)){
+      tcbdbleafoutrec(bdb, leaf, i);
+      ln--;
+      continue;
+    }
     if(rv == 0){
       int psiz = TCALIGNPAD(rec->ksiz);
       BDBREC *orec = rec;
@@ -2291,6 +2508,7 @@ static bool tcbdbleafaddrec(TCBDB *bdb, BDBLEAF *leaf, int dmode,
           memcpy(dbuf + rec->ksiz + psiz, vbuf, vsiz);
           dbuf[rec->ksiz+psiz+vsiz] = '\0';
           rec->vsiz = vsiz;
+          if(xtime != BDBXTINHERIT) rec->xtime = xtime;
           break;
       }
       break;
@@ -2310,6 +2528,7 @@ static bool tcbdbleafaddrec(TCBDB *bdb, BDBLEAF *leaf, int dmode,
       memcpy(dbuf + ksiz + psiz, vbuf, vsiz);
       dbuf[ksiz+psiz+vsiz] = '\0';
       nrec->vsiz = vsiz;
+      nrec->xtime = (xtime != BDBXTINHERIT) ? xtime : 0;
       nrec->rest = NULL;
       TCPTRLISTINSERT(recs, i, nrec);
       bdb->rnum++;
@@ -2333,6 +2552,7 @@ static bool tcbdbleafaddrec(TCBDB *bdb, BDBLEAF *leaf, int dmode,
     memcpy(dbuf + ksiz + psiz, vbuf, vsiz);
     dbuf[ksiz+psiz+vsiz] = '\0';
     nrec->vsiz = vsiz;
+    nrec->xtime = (xtime != BDBXTINHERIT) ? xtime : 0;
     nrec->rest = NULL;
     TCPTRLISTPUSH(recs, nrec);
     bdb->rnum++;
@@ -2342,6 +2562,31 @@ static bool tcbdbleafaddrec(TCBDB *bdb, BDBLEAF *leaf, int dmode,
 }
 
 
+/* Remove a record with all of its values from a leaf.
+   `bdb' specifies the B+ tree database object.
+   `leaf' specifies the leaf object.
+   `ri' specifies the index of the record. */
+static void tcbdbleafoutrec(TCBDB *bdb, BDBLEAF *leaf, int ri){
+  assert(bdb && leaf && ri >= 0);
+  BDBREC *rec = TCPTRLISTVAL(leaf->recs, ri);
+  int rnum = 1;
+  int rsiz = rec->ksiz + rec->vsiz;
+  if(rec->rest){
+    TCLIST *rest = rec->rest;
+    int ln = TCLISTNUM(rec->rest);
+    rnum += ln;
+    for(int i = 0; i < ln; i++){
+      rsiz += TCLISTVALSIZ(rest, i);
+    }
+    tclistdel(rest);
+  }
+  TCFREE(tcptrlistremove(leaf->recs, ri));
+  leaf->size -= rsiz;
+  leaf->dirty = true;
+  bdb->rnum -= rnum;
+}
+
+
 /* Divide a leaf into two.
    `bdb' specifies the B+ tree database object.
    `leaf' specifies the leaf object.
@@ -2373,6 +2618,7 @@ static BDBLEAF *tcbdbleafdivide(TCBDB *bdb, BDBLEAF *leaf){
         nsiz += TCLISTVALSIZ(rest, j);
       }
     }
+    if(rec->xtime > 0) tcbdbxtindex(bdb, newleaf->id, rec->xtime);
     TCPTRLISTPUSH(newrecs, rec);
   }
   TCPTRLISTTRUNC(recs, TCPTRLISTNUM(recs) - TCPTRLISTNUM(newrecs));
@@ -2487,6 +2733,7 @@ static bool tcbdbnodesave(TCBDB *bdb, BDBNODE *node){
     err = true;
   if(!node->dead && !tchdbput(bdb->hdb, hbuf, step, TCXSTRPTR(rbuf), TCXSTRSIZE(rbuf)))
     err = true;
+  if(!node->dead) tcstatsadd(bdb->stats, TCSCWRITE, TCXSTRSIZE(rbuf));
   tcxstrdel(rbuf);
   node->dirty = false;
   node->dead = false;
@@ -2504,6 +2751,7 @@ static BDBNODE *tcbdbnodeload(TCBDB *bdb, uint64_t id){
   int rsiz;
   BDBNODE *node = (BDBNODE *)tcmapget3(bdb->nodec, &id, sizeof(id), &rsiz);
   if(node){
+    tcstatsadd(bdb->stats, TCSCCACHE, 1);
     if(clk) BDBUNLOCKCACHE(bdb);
     return node;
   }
@@ -2528,6 +2776,7 @@ static BDBNODE *tcbdbnodeload(TCBDB *bdb, uint64_t id){
     }
     rp = rbuf;
   }
+  tcstatsadd(bdb->stats, TCSCREAD, rsiz);
   BDBNODE nent;
   nent.id = id;
   uint64_t llnum;
@@ -2724,6 +2973,7 @@ static uint64_t tcbdbsearchleaf(TCBDB *bdb, const char *kbuf, int ksiz){
       return 0;
     }
     hist[hnum++] = node->id;
+    tcstatsadd(bdb->stats, TCSCCHAIN, 1);
     TCPTRLIST *idxs = node->idxs;
     int ln = TCPTRLISTNUM(idxs);
     if(ln > 0){
@@ -3003,12 +3253,15 @@ static bool tcbdbopenimpl(TCBDB *bdb, const char *path, int omode){
     return false;
   }
   bdb->open = true;
+  bdb->xtcur = 0;
+  bdb->xtnext = 0;
   uint8_t hopts = tchdbopts(bdb->hdb);
   uint8_t opts = 0;
   if(hopts & HDBTLARGE) opts |= BDBTLARGE;
   if(hopts & HDBTDEFLATE) opts |= BDBTDEFLATE;
   if(hopts & HDBTBZIP) opts |= BDBTBZIP;
   if(hopts & HDBTTCBS) opts |= BDBTTCBS;
+  if(hopts & HDBTLZ) opts |= BDBTLZ;
   if(hopts & HDBTEXCODEC) opts |= BDBTEXCODEC;
   bdb->opts = opts;
   bdb->hleaf = 0;
@@ -3049,6 +3302,7 @@ static bool tcbdbcloseimpl(TCBDB *bdb){
     if(!tcbdbnodecacheout(bdb, (BDBNODE *)tcmapiterval(vbuf, &vsiz))) err = true;
   }
   if(bdb->wmode) tcbdbdumpmeta(bdb);
+  tcbdbxtreset(bdb);
   tcmapdel(bdb->nodec);
   tcmapdel(bdb->leafc);
   if(!tchdbclose(bdb->hdb)) err = true;
@@ -3065,7 +3319,7 @@ static bool tcbdbcloseimpl(TCBDB *bdb){
    `dmode' specifies behavior when the key overlaps.
    If successful, the return value is true, else, it is false. */
 static bool tcbdbputimpl(TCBDB *bdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz,
-                         int dmode){
+                         int dmode, uint32_t xtime){
   assert(bdb && kbuf && ksiz >= 0);
   BDBLEAF *leaf = NULL;
   uint64_t hlid = bdb->hleaf;
@@ -3075,7 +3329,9 @@ static bool tcbdbputimpl(TCBDB *bdb, const void *kbuf, int ksiz, const void *vbu
     if(!(leaf = tcbdbleafload(bdb, pid))) return false;
     hlid = 0;
   }
-  if(!tcbdbleafaddrec(bdb, leaf, dmode, kbuf, ksiz, vbuf, vsiz)){
+  if(!tcbdbleafaddrec(bdb, leaf, dmode, kbuf, ksiz, vbuf, vsiz, xtime)){
+    if(TCPTRLISTNUM(leaf->recs) < 1 && bdb->hnum > 0 &&
+       (hlid < 1 || hlid == tcbdbsearchleaf(bdb, kbuf, ksiz))) tcbdbleafkill(bdb, leaf);
     if(!bdb->tran) tcbdbcacheadjust(bdb);
     return false;
   }
@@ -3173,7 +3429,7 @@ static bool tcbdboutimpl(TCBDB *bdb, const char *kbuf, int ksiz){
   }
   int ri;
   BDBREC *rec = tcbdbsearchrec(bdb, leaf, kbuf, ksiz, &ri);
-  if(!rec){
+  if(!rec || BDBRECEXPIRED(rec)){
     tcbdbsetecode(bdb, TCENOREC, __FILE__, __LINE__, __func__);
     return false;
   }
@@ -3205,25 +3461,11 @@ static bool tcbdboutlist(TCBDB *bdb, const char *kbuf, int ksiz){
   }
   int ri;
   BDBREC *rec = tcbdbsearchrec(bdb, leaf, kbuf, ksiz, &ri);
-  if(!rec){
+  if(!rec || BDBRECEXPIRED(rec)){
     tcbdbsetecode(bdb, TCENOREC, __FILE__, __LINE__, __func__);
     return false;
   }
-  int rnum = 1;
-  int rsiz = rec->ksiz + rec->vsiz;
-  if(rec->rest){
-    TCLIST *rest = rec->rest;
-    int ln = TCLISTNUM(rec->rest);
-    rnum += ln;
-    for(int i = 0; i < ln; i++){
-      rsiz += TCLISTVALSIZ(rest, i);
-    }
-    tclistdel(rest);
-  }
-  TCFREE(tcptrlistremove(leaf->recs, ri));
-  leaf->size -= rsiz;
-  leaf->dirty = true;
-  bdb->rnum -= rnum;
+  tcbdbleafoutrec(bdb, leaf, ri);
   if(TCPTRLISTNUM(leaf->recs) < 1){
     if(hlid > 0 && hlid != tcbdbsearchleaf(bdb, kbuf, ksiz)) return false;
     if(bdb->hnum > 0 && !tcbdbleafkill(bdb, leaf)) return false;
@@ -3251,7 +3493,7 @@ static const char *tcbdbgetimpl(TCBDB *bdb, const char *kbuf, int ksiz, int *sp)
     if(!(leaf = tcbdbleafload(bdb, pid))) return NULL;
   }
   BDBREC *rec = tcbdbsearchrec(bdb, leaf, kbuf, ksiz, NULL);
-  if(!rec){
+  if(!rec || BDBRECEXPIRED(rec)){
     tcbdbsetecode(bdb, TCENOREC, __FILE__, __LINE__, __func__);
     return NULL;
   }
@@ -3275,7 +3517,7 @@ static int tcbdbgetnum(TCBDB *bdb, const char *kbuf, int ksiz){
     if(!(leaf = tcbdbleafload(bdb, pid))) return 0;
   }
   BDBREC *rec = tcbdbsearchrec(bdb, leaf, kbuf, ksiz, NULL);
-  if(!rec){
+  if(!rec || BDBRECEXPIRED(rec)){
     tcbdbsetecode(bdb, TCENOREC, __FILE__, __LINE__, __func__);
     return 0;
   }
@@ -3298,7 +3540,7 @@ static TCLIST *tcbdbgetlist(TCBDB *bdb, const char *kbuf, int ksiz){
     if(!(leaf = tcbdbleafload(bdb, pid))) return NULL;
   }
   BDBREC *rec = tcbdbsearchrec(bdb, leaf, kbuf, ksiz, NULL);
-  if(!rec){
+  if(!rec || BDBRECEXPIRED(rec)){
     tcbdbsetecode(bdb, TCENOREC, __FILE__, __LINE__, __func__);
     return NULL;
   }
@@ -3322,6 +3564,30 @@ static TCLIST *tcbdbgetlist(TCBDB *bdb, const char *kbuf, int ksiz){
 }
 
 
+/* Get the expiration time of a record in a B+ tree database object.
+   `bdb' specifies the B+ tree database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   If successful, the return value is the expiration time of the corresponding record, else, it
+   is -1. */
+static int64_t tcbdbgetxtimpl(TCBDB *bdb, const char *kbuf, int ksiz){
+  assert(bdb && kbuf && ksiz >= 0);
+  BDBLEAF *leaf = NULL;
+  uint64_t hlid = bdb->hleaf;
+  if(hlid < 1 || !(leaf = tcbdbgethistleaf(bdb, kbuf, ksiz, hlid))){
+    uint64_t pid = tcbdbsearchleaf(bdb, kbuf, ksiz);
+    if(pid < 1) return -1;
+    if(!(leaf = tcbdbleafload(bdb, pid))) return -1;
+  }
+  BDBREC *rec = tcbdbsearchrec(bdb, leaf, kbuf, ksiz, NULL);
+  if(!rec || BDBRECEXPIRED(rec)){
+    tcbdbsetecode(bdb, TCENOREC, __FILE__, __LINE__, __func__);
+    return -1;
+  }
+  return rec->xtime;
+}
+
+
 /* Get keys of ranged records in a B+ tree database object.
    `bdb' specifies the B+ tree database object.
    `bkbuf' specifies the pointer to the region of the key of the beginning border.
@@ -3469,7 +3735,17 @@ static bool tcbdboptimizeimpl(TCBDB *bdb, int32_t lmemb, int32_t nmemb,
   int ksiz, vsiz;
   int cnt = 0;
   while(!err && cur->id > 0 && tcbdbcurrecimpl(cur, &kbuf, &ksiz, &vbuf, &vsiz)){
-    if(!tcbdbputdup(tbdb, kbuf, ksiz, vbuf, vsiz)){
+    uint32_t xtime = 0;
+    if(bdb->expire && cur->vidx < 1){
+      BDBLEAF *leaf = tcbdbleafload(bdb, cur->id);
+      if(leaf) xtime = ((BDBREC *)TCPTRLISTVAL(leaf->recs, cur->kidx))->xtime;
+    }
+    if(xtime > 0){
+      if(!tcbdbputxt(tbdb, kbuf, ksiz, vbuf, vsiz, -(int64_t)xtime)){
+        tcbdbsetecode(bdb, tcbdbecode(tbdb), __FILE__, __LINE__, __func__);
+        err = true;
+      }
+    } else if(!tcbdbputdup(tbdb, kbuf, ksiz, vbuf, vsiz)){
       tcbdbsetecode(bdb, tcbdbecode(tbdb), __FILE__, __LINE__, __func__);
       err = true;
     }
@@ -3521,6 +3797,203 @@ static bool tcbdbvanishimpl(TCBDB *bdb){
 }
 
 
+/* Sweep records which have expired in a B+ tree database object.
+   `bdb' specifies the B+ tree database object.
+   `step' specifies the number of leaves to be swept.
+   If successful, the return value is true, else, it is false.
+   The leaves holding records with expiration times are kept in the expiration index by coarse
+   time slots, and the sweeper visits only the leaves in the slots which have expired.  The index
+   lives in memory, so it is built by a pass over all leaves, which is started at most once in
+   the sweeping interval while the index is missing.  When the index is empty, the expiration
+   flag of the database is cleared. */
+static bool tcbdbxtstep(TCBDB *bdb, int64_t step){
+  assert(bdb && step > 0);
+  if(!bdb->expire || bdb->tran) return true;
+  if(bdb->xtidx && bdb->xtinum > bdb->rnum * BDBXTIDXRAT + BDBXTIDXMIN) tcbdbxtreset(bdb);
+  if(bdb->xtidx && bdb->xtcur < 1) return tcbdbxtsweep(bdb, step);
+  time_t now = time(NULL);
+  if(bdb->xtcur < 1){
+    if(now < bdb->xtnext) return true;
+    bdb->xtcur = bdb->first;
+    bdb->xtnext = now + BDBXTSWINTV;
+    bdb->xtidx = tctreenew2(tccmpint64, NULL);
+    bdb->xtinum = 0;
+  }
+  while(step-- > 0 && bdb->xtcur > 0){
+    if(!tcbdbleafcheck(bdb, bdb->xtcur)) bdb->xtcur = bdb->first;
+    BDBLEAF *leaf = tcbdbleafload(bdb, bdb->xtcur);
+    if(!leaf) return false;
+    bdb->xtcur = leaf->next;
+    if(!tcbdbxtleaf(bdb, leaf, now, true)) return false;
+  }
+  if(bdb->xtcur < 1) tcbdbxtsetnext(bdb);
+  return true;
+}
+
+
+/* Sweep the expired slots of the expiration index of a B+ tree database object.
+   `bdb' specifies the B+ tree database object.
+   `step' specifies the number of leaves to be swept.
+   If successful, the return value is true, else, it is false.
+   A leaf which has been killed since it was indexed is skipped. */
+static bool tcbdbxtsweep(TCBDB *bdb, int64_t step){
+  assert(bdb && bdb->xtidx && step > 0);
+  time_t now = time(NULL);
+  while(step > 0 && tctreernum(bdb->xtidx) > 0){
+    tctreeiterinit(bdb->xtidx);
+    int ksiz;
+    const char *kbuf = tctreeiternext(bdb->xtidx, &ksiz);
+    int64_t slot;
+    memcpy(&slot, kbuf, sizeof(slot));
+    if((slot + 1) * BDBXTSWINTV > now) break;
+    int vsiz;
+    const char *vbuf = tctreeiterval(kbuf, &vsiz);
+    int inum = vsiz / sizeof(uint64_t);
+    int num = (inum > step) ? step : inum;
+    char *ibuf;
+    TCMEMDUP(ibuf, vbuf, vsiz);
+    uint64_t *ids = (uint64_t *)ibuf;
+    if(num < inum){
+      tctreeput(bdb->xtidx, &slot, sizeof(slot), ids + num, (inum - num) * sizeof(uint64_t));
+    } else {
+      tctreeout(bdb->xtidx, &slot, sizeof(slot));
+    }
+    bdb->xtinum -= num;
+    step -= num;
+    bool err = false;
+    for(int i = 0; i < num && !err; i++){
+      if(!tcbdbleafcheck(bdb, ids[i])) continue;
+      BDBLEAF *leaf = tcbdbleafload(bdb, ids[i]);
+      if(!leaf || !tcbdbxtleaf(bdb, leaf, now, false)) err = true;
+    }
+    TCFREE(ibuf);
+    if(err) return false;
+  }
+  tcbdbxtsetnext(bdb);
+  return true;
+}
+
+
+/* Remove the records which have expired from a leaf of a B+ tree database object.
+   `bdb' specifies the B+ tree database object.
+   `leaf' specifies the leaf object.
+   `now' specifies the current time.
+   `index' specifies whether to add the leaf to the expiration index for the records which have
+   not expired.
+   If successful, the return value is true, else, it is false.
+   The last record of a leaf which is not found through the tree is kept and retried in the next
+   sweeping interval. */
+static bool tcbdbxtleaf(TCBDB *bdb, BDBLEAF *leaf, time_t now, bool index){
+  assert(bdb && leaf);
+  if(leaf->dead) return true;
+  TCPTRLIST *recs = leaf->recs;
+  for(int i = TCPTRLISTNUM(recs) - 1; i >= 0; i--){
+    BDBREC *rec = TCPTRLISTVAL(recs, i);
+    if(rec->xtime < 1) continue;
+    if(rec->xtime > now){
+      if(index) tcbdbxtindex(bdb, leaf->id, rec->xtime);
+      continue;
+    }
+    if(TCPTRLISTNUM(recs) < 2){
+      uint64_t pid = tcbdbsearchleaf(bdb, (char *)rec + sizeof(*rec), rec->ksiz);
+      if(pid < 1) return false;
+      if(pid != leaf->id){
+        tcbdbxtindex(bdb, leaf->id, now + BDBXTSWINTV);
+        continue;
+      }
+      tcbdbleafoutrec(bdb, leaf, i);
+      if(bdb->hnum > 0 && !tcbdbleafkill(bdb, leaf)) return false;
+      break;
+    }
+    tcbdbleafoutrec(bdb, leaf, i);
+  }
+  return true;
+}
+
+
+/* Add a leaf to the expiration index of a B+ tree database object.
+   `bdb' specifies the B+ tree database object.
+   `id' specifies the ID number of the leaf.
+   `xtime' specifies the expiration time of a record in the leaf.
+   The leaf is not added again if it is the last one in the slot. */
+static void tcbdbxtindex(TCBDB *bdb, uint64_t id, uint32_t xtime){
+  assert(bdb && id > 0);
+  if(!bdb->xtidx) return;
+  int64_t slot = xtime / BDBXTSWINTV;
+  int vsiz;
+  const char *vbuf = tctreeget(bdb->xtidx, &slot, sizeof(slot), &vsiz);
+  if(vbuf && vsiz >= sizeof(id) && !memcmp(vbuf + vsiz - sizeof(id), &id, sizeof(id))) return;
+  tctreeputcat(bdb->xtidx, &slot, sizeof(slot), &id, sizeof(id));
+  bdb->xtinum++;
+}
+
+
+/* Discard the expiration index of a B+ tree database object.
+   `bdb' specifies the B+ tree database object.
+   The index is built again by the next pass of the expiration sweeper. */
+static void tcbdbxtreset(TCBDB *bdb){
+  assert(bdb);
+  if(bdb->xtidx){
+    tctreedel(bdb->xtidx);
+    bdb->xtidx = NULL;
+  }
+  bdb->xtinum = 0;
+}
+
+
+/* Set the time when the expiration sweeper of a B+ tree database object runs next.
+   `bdb' specifies the B+ tree database object.
+   It is when the earliest slot of the expiration index expires.  If the index is empty, the
+   expiration flag of the database is cleared instead. */
+static void tcbdbxtsetnext(TCBDB *bdb){
+  assert(bdb && bdb->xtidx);
+  if(tctreernum(bdb->xtidx) < 1){
+    bdb->expire = false;
+    return;
+  }
+  tctreeiterinit(bdb->xtidx);
+  int ksiz;
+  const char *kbuf = tctreeiternext(bdb->xtidx, &ksiz);
+  int64_t slot;
+  memcpy(&slot, kbuf, sizeof(slot));
+  bdb->xtnext = (slot + 1) * BDBXTSWINTV;
+}
+
+
+/* Lock and flush a B+ tree database object around the catch-up phase of an online backup.
+   `begin' specifies true before the catch-up phase or false after it.
+   `op' specifies the B+ tree database object.
+   The return value is true if successful, else, it is false.
+   Before the catch-up phase, the method is locked exclusively after the running transaction
+   finishes and the dirty leaves and nodes are written into the internal database.  The lock is
+   released after the phase. */
+static bool tcbdbbkproc(bool begin, void *op){
+  TCBDB *bdb = op;
+  assert(bdb);
+  if(!begin){
+    BDBUNLOCKMETHOD(bdb);
+    return true;
+  }
+  for(double wsec = 1.0 / sysconf(_SC_CLK_TCK); true; wsec *= 2){
+    if(!BDBLOCKMETHOD(bdb, true)) return false;
+    if(!bdb->open){
+      tcbdbsetecode(bdb, TCEINVALID, __FILE__, __LINE__, __func__);
+      BDBUNLOCKMETHOD(bdb);
+      return false;
+    }
+    if(!bdb->tran) break;
+    BDBUNLOCKMETHOD(bdb);
+    if(wsec > 1.0) wsec = 1.0;
+    tcsleep(wsec);
+  }
+  if(bdb->wmode && !tcbdbmemsync(bdb, false)){
+    BDBUNLOCKMETHOD(bdb);
+    return false;
+  }
+  return true;
+}
+
+
 /* Lock a method of the B+ tree database object.
    `bdb' specifies the B+ tree database object.
    `wr' specifies whether the lock is writer or not.
@@ -3646,7 +4119,7 @@ static bool tcbdbcurjumpimpl(BDBCUR *cur, const char *kbuf, int ksiz, bool forwa
     } else {
       cur->vidx = rec->rest ? TCLISTNUM(rec->rest) : 0;
     }
-    return true;
+    return tcbdbcuradjust(cur, forward);
   }
   cur->id = leaf->id;
   if(ri > 0 && ri >= TCPTRLISTNUM(leaf->recs)) ri = TCPTRLISTNUM(leaf->recs) - 1;
@@ -3662,7 +4135,7 @@ static bool tcbdbcurjumpimpl(BDBCUR *cur, const char *kbuf, int ksiz, bool forwa
     }
     if(rv < 0){
       cur->vidx = 0;
-      return true;
+      return tcbdbcuradjust(cur, forward);
     }
     cur->vidx = rec->rest ? TCLISTNUM(rec->rest) : 0;
     return tcbdbcurnextimpl(cur);
@@ -3675,7 +4148,7 @@ static bool tcbdbcurjumpimpl(BDBCUR *cur, const char *kbuf, int ksiz, bool forwa
   }
   if(rv > 0){
     cur->vidx = rec->rest ? TCLISTNUM(rec->rest) : 0;
-    return true;
+    return tcbdbcuradjust(cur, forward);
   }
   cur->vidx = 0;
   return tcbdbcurprevimpl(cur);
@@ -3742,7 +4215,15 @@ static bool tcbdbcuradjust(BDBCUR *cur, bool forward){
     } else {
       BDBREC *rec = TCPTRLISTVAL(recs, cur->kidx);
       int vnum = rec->rest ? TCLISTNUM(rec->rest) + 1 : 1;
-      if(cur->vidx < 0){
+      if(BDBRECEXPIRED(rec)){
+        if(forward){
+          cur->kidx++;
+          cur->vidx = 0;
+        } else {
+          cur->kidx--;
+          cur->vidx = INT_MAX;
+        }
+      } else if(cur->vidx < 0){
         if(forward){
           cur->vidx = 0;
         } else {
@@ -3757,8 +4238,6 @@ static bool tcbdbcuradjust(BDBCUR *cur, bool forward){
             cur->id = leaf->next;
             cur->kidx = 0;
             cur->vidx = 0;
-          } else {
-            break;
           }
         } else {
           cur->vidx = vnum - 1;
@@ -69,6 +69,12 @@ typedef struct {                         /* type of structure for a B+ tree data
   bool tran;                             /* whether in the transaction */
   char *rbopaque;                        /* opaque for rollback */
   volatile uint64_t clock;               /* logical clock */
+  TCSTATS *stats;                        /* statistics of operations */
+  bool expire;                           /* whether records with expiration times are stored */
+  uint64_t xtcur;                        /* ID number of the leaf at the expiration sweeper */
+  time_t xtnext;                         /* time when the next pass of the sweeper may start */
+  TCTREE *xtidx;                         /* ID numbers of the leaves with expiration times */
+  uint64_t xtinum;                       /* number of the ID numbers in the expiration index */
   volatile int64_t cnt_saveleaf;         /* tesing counter for leaf save times */
   volatile int64_t cnt_loadleaf;         /* tesing counter for leaf load times */
   volatile int64_t cnt_killleaf;         /* tesing counter for leaf kill times */
@@ -88,7 +94,8 @@ enum {                                   /* enumeration for tuning options */
   BDBTDEFLATE = 1 << 1,                  /* compress each page with Deflate */
   BDBTBZIP = 1 << 2,                     /* compress each record with BZIP2 */
   BDBTTCBS = 1 << 3,                     /* compress each page with TCBS */
-  BDBTEXCODEC = 1 << 4                   /* compress each record with outer functions */
+  BDBTEXCODEC = 1 << 4,                  /* compress each record with outer functions */
+  BDBTLZ = 1 << 5                        /* compress each page with LZ */
 };
 
 enum {                                   /* enumeration for open modes */
@@ -101,6 +108,15 @@ enum {                                   /* enumeration for open modes */
   BDBOTSYNC = 1 << 6                     /* synchronize every transaction */
 };
 
+enum {                                   /* enumeration for mapping options */
+  BDBMHUGE = HDBMHUGE,                   /* back the bucket array with huge pages */
+  BDBMLOCK = HDBMLOCK,                   /* lock the bucket array in memory */
+  BDBMBRANDOM = HDBMBRANDOM,             /* advise random access to the bucket array */
+  BDBMBWILLNEED = HDBMBWILLNEED,         /* read the bucket array ahead */
+  BDBMRRANDOM = HDBMRRANDOM,             /* advise random access to the mapped records */
+  BDBMRWILLNEED = HDBMRWILLNEED          /* read the mapped records ahead */
+};
+
 typedef struct {                         /* type of structure for a B+ tree cursor */
   TCBDB *bdb;                            /* database object */
   uint64_t clock;                        /* logical clock */
@@ -191,7 +207,8 @@ bool tcbdbsetcmpfunc(TCBDB *bdb, TCCMP cmp, void *cmpop);
    `opts' specifies options by bitwise-or: `BDBTLARGE' specifies that the size of the database
    can be larger than 2GB by using 64-bit bucket array, `BDBTDEFLATE' specifies that each page
    is compressed with Deflate encoding, `BDBTBZIP' specifies that each page is compressed with
-   BZIP2 encoding, `BDBTTCBS' specifies that each page is compressed with TCBS encoding.
+   BZIP2 encoding, `BDBTTCBS' specifies that each page is compressed with TCBS encoding,
+   `BDBTLZ' specifies that each page is compressed with LZ encoding.
    If successful, the return value is true, else, it is false.
    Note that the tuning parameters should be set before the database is opened. */
 bool tcbdbtune(TCBDB *bdb, int32_t lmemb, int32_t nmemb,
@@ -218,6 +235,16 @@ bool tcbdbsetcache(TCBDB *bdb, int32_t lcnum, int32_t ncnum);
 bool tcbdbsetxmsiz(TCBDB *bdb, int64_t xmsiz);
 
 
+/* Set the options of the mapped region of a B+ tree database object.
+   `bdb' specifies the B+ tree database object which is not opened.
+   `mopts' specifies options by bitwise-or: `BDBMHUGE', `BDBMLOCK', `BDBMBRANDOM',
+   `BDBMBWILLNEED', `BDBMRRANDOM', and `BDBMRWILLNEED'.  They have the same meanings as
+   the options of `tchdbsetmapopts'.  By default, no option is specified.
+   If successful, the return value is true, else, it is false.
+   Note that the mapping parameters should be set before the database is opened. */
+bool tcbdbsetmapopts(TCBDB *bdb, int mopts);
+
+
 /* Set the unit step number of auto defragmentation of a B+ tree database object.
    `bdb' specifies the B+ tree database object which is not opened.
    `dfunit' specifie the unit step number.  If it is not more than 0, the auto defragmentation
@@ -269,6 +296,26 @@ bool tcbdbput(TCBDB *bdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz
 bool tcbdbput2(TCBDB *bdb, const char *kstr, const char *vstr);
 
 
+/* Store a record with an expiration time into a B+ tree database object.
+   `bdb' specifies the B+ tree database object connected as a writer.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `vbuf' specifies the pointer to the region of the value.
+   `vsiz' specifies the size of the region of the value.
+   `xt' specifies the expiration time.  If it is positive, it is the lifetime in seconds from now.
+   If it is negative, its absolute value is the time in seconds since the epoch.  If it is 0, the
+   record never expires.
+   If successful, the return value is true, else, it is false.
+   If a record with the same key exists in the database, it is overwritten.  The expiration time
+   applies to the key with all of its duplicated values.  A record which has expired is treated as
+   missing by every function and is reclaimed when it is stored again, by the defragmentation, and
+   by the optimization.  Functions which modify the values of an existing record, such as
+   `tcbdbputcat' and `tcbdbputdup', keep its expiration time, while `tcbdbput' clears it.  A
+   database where records with expiration times have been stored can not be read by older
+   versions of the library. */
+bool tcbdbputxt(TCBDB *bdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz, int64_t xt);
+
+
 /* Store a new record into a B+ tree database object.
    `bdb' specifies the B+ tree database object connected as a writer.
    `kbuf' specifies the pointer to the region of the key.
@@ -456,6 +503,15 @@ int tcbdbvsiz(TCBDB *bdb, const void *kbuf, int ksiz);
 int tcbdbvsiz2(TCBDB *bdb, const char *kstr);
 
 
+/* Get the expiration time of a record in a B+ tree database object.
+   `bdb' specifies the B+ tree database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   If successful, the return value is the expiration time of the corresponding record in seconds
+   since the epoch, or 0 if it never expires.  -1 is returned if no record corresponds. */
+int64_t tcbdbgetxt(TCBDB *bdb, const void *kbuf, int ksiz);
+
+
 /* Get keys of ranged records in a B+ tree database object.
    `bdb' specifies the B+ tree database object.
    `bkbuf' specifies the pointer to the region of the key of the beginning border.  If it is
@@ -563,8 +619,8 @@ bool tcbdbsync(TCBDB *bdb);
    `opts' specifies options by bitwise-or: `BDBTLARGE' specifies that the size of the database
    can be larger than 2GB by using 64-bit bucket array, `BDBTDEFLATE' specifies that each record
    is compressed with Deflate encoding, `BDBTBZIP' specifies that each page is compressed with
-   BZIP2 encoding, `BDBTTCBS' specifies that each page is compressed with TCBS encoding.  If it
-   is `UINT8_MAX', the current setting is not changed.
+   BZIP2 encoding, `BDBTTCBS' specifies that each page is compressed with TCBS encoding,
+   `BDBTLZ' specifies that each page is compressed with LZ encoding.  If it is `UINT8_MAX', the current setting is not changed.
    If successful, the return value is true, else, it is false.
    This function is useful to reduce the size of the database file with data fragmentation by
    successive updating. */
@@ -590,6 +646,17 @@ bool tcbdbvanish(TCBDB *bdb);
 bool tcbdbcopy(TCBDB *bdb, const char *path);
 
 
+/* Copy the database file of a B+ tree database object without blocking writers.
+   `bdb' specifies the B+ tree database object.
+   `path' specifies the path of the destination file.  A command line beginning with `@' is not
+   supported.
+   If successful, the return value is true, else, it is false.
+   The internal hash database is copied by `tchdbbackup' while writers continue.  Only the
+   catch-up phase at the end locks the database, after the dirty leaves and nodes in the cache
+   are written, so that the destination is a consistent image as of the end of the backup. */
+bool tcbdbbackup(TCBDB *bdb, const char *path);
+
+
 /* Begin the transaction of a B+ tree database object.
    `bdb' specifies the B+ tree database object connected as a writer.
    If successful, the return value is true, else, it is false.
@@ -1001,7 +1068,10 @@ uint32_t tcbdbdfunit(TCBDB *bdb);
    `bdb' specifies the B+ tree database object connected as a writer.
    `step' specifie the number of steps.  If it is not more than 0, the whole file is defragmented
    gradually without keeping a continuous lock.
-   If successful, the return value is true, else, it is false. */
+   If successful, the return value is true, else, it is false.
+   While records with expiration times are stored, the leaves are also swept at most once in a
+   minute, `step' leaves at a time, and the records which have expired are removed.  If `step' is
+   not more than 0, all leaves are swept. */
 bool tcbdbdefrag(TCBDB *bdb, int64_t step);
 
 
@@ -1011,6 +1081,15 @@ bool tcbdbdefrag(TCBDB *bdb, int64_t step);
 bool tcbdbcacheclear(TCBDB *bdb);
 
 
+/* Get the statistics of operations of a B+ tree database object.
+   `bdb' specifies the B+ tree database object.
+   The return value is the statistics object of the database.  It is updated by every thread
+   calling the API of the object and valid until the object is deleted.  Cache hits, visited
+   nodes, and read and written bytes are counted by pages.  Statistics of the internal hash
+   database are kept apart. */
+TCSTATS *tcbdbstats(TCBDB *bdb);
+
+
 /* Store a new record into a B+ tree database object with backward duplication.
    `bdb' specifies the B+ tree database object connected as a writer.
    `kbuf' specifies the pointer to the region of the key.
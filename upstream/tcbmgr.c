@@ -94,7 +94,7 @@ static void usage(void){
   fprintf(stderr, "%s: the command line utility of the B+ tree database API\n", g_progname);
   fprintf(stderr, "\n");
   fprintf(stderr, "usage:\n");
-  fprintf(stderr, "  %s create [-cd|-ci|-cj] [-tl] [-td|-tb|-tt|-tx] path"
+  fprintf(stderr, "  %s create [-cd|-ci|-cj] [-tl] [-td|-tb|-tt|-ts|-tx] path"
           " [lmemb [nmemb [bnum [apow [fpow]]]]]\n", g_progname);
   fprintf(stderr, "  %s inform [-nl|-nb] path\n", g_progname);
   fprintf(stderr, "  %s put [-cd|-ci|-cj] [-nl|-nb] [-sx] [-dk|-dc|-dd|-db|-dai|-dad] path"
@@ -103,7 +103,7 @@ static void usage(void){
   fprintf(stderr, "  %s get [-cd|-ci|-cj] [-nl|-nb] [-sx] [-px] [-pz] path key\n", g_progname);
   fprintf(stderr, "  %s list [-cd|-ci|-cj] [-nl|-nb] [-m num] [-bk] [-pv] [-px] [-j str]"
           " [-rb bkey ekey] [-fm str] path\n", g_progname);
-  fprintf(stderr, "  %s optimize [-cd|-ci|-cj] [-tl] [-td|-tb|-tt|-tx] [-tz] [-nl|-nb] [-df]"
+  fprintf(stderr, "  %s optimize [-cd|-ci|-cj] [-tl] [-td|-tb|-tt|-ts|-tx] [-tz] [-nl|-nb] [-df]"
           " path [lmemb [nmemb [bnum [apow [fpow]]]]]\n", g_progname);
   fprintf(stderr, "  %s importtsv [-nl|-nb] [-sc] path [file]\n", g_progname);
   fprintf(stderr, "  %s version\n", g_progname);
@@ -196,6 +196,8 @@ static int runcreate(int argc, char **argv){
         opts |= BDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= BDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= BDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= BDBTEXCODEC;
       } else {
@@ -512,6 +514,9 @@ static int runoptimize(int argc, char **argv){
       } else if(!strcmp(argv[i], "-tt")){
         if(opts == UINT8_MAX) opts = 0;
         opts |= BDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        if(opts == UINT8_MAX) opts = 0;
+        opts |= BDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         if(opts == UINT8_MAX) opts = 0;
         opts |= BDBTEXCODEC;
@@ -672,6 +677,7 @@ static int procinform(const char *path, int omode){
   if(opts & BDBTDEFLATE) printf(" deflate");
   if(opts & BDBTBZIP) printf(" bzip");
   if(opts & BDBTTCBS) printf(" tcbs");
+  if(opts & BDBTLZ) printf(" lz");
   if(opts & BDBTEXCODEC) printf(" excodec");
   printf("\n");
   printf("record number: %llu\n", (unsigned long long)tcbdbrnum(bdb));
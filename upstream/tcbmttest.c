@@ -149,16 +149,16 @@ static void usage(void){
   fprintf(stderr, "%s: test cases of the B+ tree database API of Tokyo Cabinet\n", g_progname);
   fprintf(stderr, "\n");
   fprintf(stderr, "usage:\n");
-  fprintf(stderr, "  %s write [-tl] [-td|-tb|-tt|-tx] [-xm num] [-df num] [-nl|-nb] [-rnd]"
+  fprintf(stderr, "  %s write [-tl] [-td|-tb|-tt|-ts|-tx] [-xm num] [-df num] [-nl|-nb] [-rnd]"
           " path tnum rnum [lmemb [nmemb [bnum [apow [fpow]]]]]\n", g_progname);
   fprintf(stderr, "  %s read [-xm num] [-df num] [-nl|-nb] [-wb] [-rnd] path tnum\n",
           g_progname);
   fprintf(stderr, "  %s remove [-xm num] [-df num] [-nl|-nb] [-rnd] path tnum\n", g_progname);
-  fprintf(stderr, "  %s wicked [-tl] [-td|-tb|-tt|-tx] [-nl|-nb] [-nc] path tnum rnum\n",
+  fprintf(stderr, "  %s wicked [-tl] [-td|-tb|-tt|-ts|-tx] [-nl|-nb] [-nc] path tnum rnum\n",
           g_progname);
-  fprintf(stderr, "  %s typical [-tl] [-td|-tb|-tt|-tx] [-xm num] [-df num] [-nl|-nb]"
+  fprintf(stderr, "  %s typical [-tl] [-td|-tb|-tt|-ts|-tx] [-xm num] [-df num] [-nl|-nb]"
           " [-nc] [-rr num] path tnum rnum [lmemb [nmemb [bnum [apow [fpow]]]]]\n", g_progname);
-  fprintf(stderr, "  %s race [-tl] [-td|-tb|-tt|-tx] [-xm num] [-df num] [-nl|-nb]"
+  fprintf(stderr, "  %s race [-tl] [-td|-tb|-tt|-ts|-tx] [-xm num] [-df num] [-nl|-nb]"
           " path tnum rnum [lmemb [nmemb [bnum [apow [fpow]]]]]\n", g_progname);
   fprintf(stderr, "\n");
   exit(1);
@@ -296,6 +296,8 @@ static int runwrite(int argc, char **argv){
         opts |= BDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= BDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= BDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= BDBTEXCODEC;
       } else if(!strcmp(argv[i], "-xm")){
@@ -451,6 +453,8 @@ static int runwicked(int argc, char **argv){
         opts |= BDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= BDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= BDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= BDBTEXCODEC;
       } else if(!strcmp(argv[i], "-nl")){
@@ -507,6 +511,8 @@ static int runtypical(int argc, char **argv){
         opts |= BDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= BDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= BDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= BDBTEXCODEC;
       } else if(!strcmp(argv[i], "-xm")){
@@ -586,6 +592,8 @@ static int runrace(int argc, char **argv){
         opts |= BDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= BDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= BDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= BDBTEXCODEC;
       } else if(!strcmp(argv[i], "-xm")){
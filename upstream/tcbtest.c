@@ -38,6 +38,7 @@ static void sysprint(void);
 static int myrand(int range);
 static void *pdprocfunc(const void *vbuf, int vsiz, int *sp, void *op);
 static bool iterfunc(const void *kbuf, int ksiz, const void *vbuf, int vsiz, void *op);
+static bool expirecheck(TCBDB *bdb, int rnum, TCMAP *map, TCMAP *nmap, TCMAP *xmap);
 static int runwrite(int argc, char **argv);
 static int runread(int argc, char **argv);
 static int runremove(int argc, char **argv);
@@ -45,6 +46,7 @@ static int runrcat(int argc, char **argv);
 static int runqueue(int argc, char **argv);
 static int runmisc(int argc, char **argv);
 static int runwicked(int argc, char **argv);
+static int runexpire(int argc, char **argv);
 static int procwrite(const char *path, int rnum, int lmemb, int nmemb, int bnum,
                      int apow, int fpow, bool mt, TCCMP cmp, int opts, int lcnum, int ncnum,
                      int xmsiz, int dfunit, int lsmax, int capnum, int omode, bool rnd);
@@ -63,6 +65,8 @@ static int procqueue(const char *path, int rnum, int lmemb, int nmemb, int bnum,
                      int omode);
 static int procmisc(const char *path, int rnum, bool mt, int opts, int omode);
 static int procwicked(const char *path, int rnum, bool mt, int opts, int omode);
+static int procexpire(const char *path, int rnum, bool mt, int opts, int lcnum, int ncnum,
+                      int omode);
 
 
 /* main routine */
@@ -89,6 +93,8 @@ int main(int argc, char **argv){
     rv = runmisc(argc, argv);
   } else if(!strcmp(argv[1], "wicked")){
     rv = runwicked(argc, argv);
+  } else if(!strcmp(argv[1], "expire")){
+    rv = runexpire(argc, argv);
   } else {
     usage();
   }
@@ -108,21 +114,23 @@ static void usage(void){
   fprintf(stderr, "%s: test cases of the B+ tree database API of Tokyo Cabinet\n", g_progname);
   fprintf(stderr, "\n");
   fprintf(stderr, "usage:\n");
-  fprintf(stderr, "  %s write [-mt] [-cd|-ci|-cj] [-tl] [-td|-tb|-tt|-tx] [-lc num] [-nc num]"
+  fprintf(stderr, "  %s write [-mt] [-cd|-ci|-cj] [-tl] [-td|-tb|-tt|-ts|-tx] [-lc num] [-nc num]"
           " [-xm num] [-df num] [-ls num] [-ca num] [-nl|-nb] [-rnd] path rnum"
           " [lmemb [nmemb [bnum [apow [fpow]]]]]\n", g_progname);
   fprintf(stderr, "  %s read [-mt] [-cd|-ci|-cj] [-lc num] [-nc num] [-xm num] [-df num]"
           " [-nl|-nb] [-wb] [-rnd] path\n", g_progname);
   fprintf(stderr, "  %s remove [-mt] [-cd|-ci|-cj] [-lc num] [-nc num] [-xm num] [-df num]"
           " [-nl|-nb] [-rnd] path\n", g_progname);
-  fprintf(stderr, "  %s rcat [-mt] [-cd|-ci|-cj] [-tl] [-td|-tb|-tt|-tx] [-lc num] [-nc num]"
+  fprintf(stderr, "  %s rcat [-mt] [-cd|-ci|-cj] [-tl] [-td|-tb|-tt|-ts|-tx] [-lc num] [-nc num]"
           " [-xm num] [-df num] [-ls num] [-ca num] [-nl|-nb] [-pn num] [-dai|-dad|-rl|-ru]"
           " path rnum [lmemb [nmemb [bnum [apow [fpow]]]]]\n", g_progname);
-  fprintf(stderr, "  %s queue [-mt] [-cd|-ci|-cj] [-tl] [-td|-tb|-tt|-tx] [-lc num] [-nc num]"
+  fprintf(stderr, "  %s queue [-mt] [-cd|-ci|-cj] [-tl] [-td|-tb|-tt|-ts|-tx] [-lc num] [-nc num]"
           " [-xm num] [-df num] [-ls num] [-ca num] [-nl|-nb] path rnum"
           " [lmemb [nmemb [bnum [apow [fpow]]]]]\n", g_progname);
-  fprintf(stderr, "  %s misc [-mt] [-tl] [-td|-tb|-tt|-tx] [-nl|-nb] path rnum\n", g_progname);
-  fprintf(stderr, "  %s wicked [-mt] [-tl] [-td|-tb|-tt|-tx] [-nl|-nb] path rnum\n", g_progname);
+  fprintf(stderr, "  %s misc [-mt] [-tl] [-td|-tb|-tt|-ts|-tx] [-nl|-nb] path rnum\n", g_progname);
+  fprintf(stderr, "  %s wicked [-mt] [-tl] [-td|-tb|-tt|-ts|-tx] [-nl|-nb] path rnum\n", g_progname);
+  fprintf(stderr, "  %s expire [-mt] [-tl] [-td|-tb|-tt|-ts|-tx] [-lc num] [-nc num] [-nl|-nb]"
+          " path rnum\n", g_progname);
   fprintf(stderr, "\n");
   exit(1);
 }
@@ -255,6 +263,96 @@ static bool iterfunc(const void *kbuf, int ksiz, const void *vbuf, int vsiz, voi
 }
 
 
+/* check every record of a B+ tree database against the model of expire command */
+static bool expirecheck(TCBDB *bdb, int rnum, TCMAP *map, TCMAP *nmap, TCMAP *xmap){
+  bool err = false;
+  int64_t vnum = 0;
+  for(int i = 1; i <= rnum && !err; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "%08d", i);
+    int vsiz;
+    const char *vbuf = tcmapget(map, kbuf, ksiz, &vsiz);
+    int rsiz;
+    char *rbuf = tcbdbget(bdb, kbuf, ksiz, &rsiz);
+    if(vbuf){
+      if(!rbuf){
+        eprint(bdb, __LINE__, "tcbdbget");
+        err = true;
+      } else if(rsiz != vsiz || memcmp(rbuf, vbuf, rsiz)){
+        eprint(bdb, __LINE__, "(validation)");
+        err = true;
+      }
+      const int *np = tcmapget(nmap, kbuf, ksiz, &vsiz);
+      if(!np || tcbdbvnum(bdb, kbuf, ksiz) != *np){
+        eprint(bdb, __LINE__, "tcbdbvnum");
+        err = true;
+      }
+      if(np) vnum += *np;
+      const char *xstr = tcmapget2(xmap, kbuf);
+      if(tcbdbgetxt(bdb, kbuf, ksiz) != (xstr ? tcatoi(xstr) : 0)){
+        eprint(bdb, __LINE__, "tcbdbgetxt");
+        err = true;
+      }
+    } else {
+      if(rbuf || tcbdbecode(bdb) != TCENOREC){
+        eprint(bdb, __LINE__, "tcbdbget");
+        err = true;
+      }
+      if(tcbdbvnum(bdb, kbuf, ksiz) != 0){
+        eprint(bdb, __LINE__, "tcbdbvnum");
+        err = true;
+      }
+      if(tcbdbgetxt(bdb, kbuf, ksiz) != -1){
+        eprint(bdb, __LINE__, "tcbdbgetxt");
+        err = true;
+      }
+    }
+    tcfree(rbuf);
+  }
+  for(int i = 0; i < 2; i++){
+    BDBCUR *cur = tcbdbcurnew(bdb);
+    if(i == 0){
+      tcbdbcurfirst(cur);
+    } else {
+      tcbdbcurlast(cur);
+    }
+    int64_t cnum = 0;
+    char *kbuf;
+    int ksiz;
+    while((kbuf = tcbdbcurkey(cur, &ksiz)) != NULL){
+      int vsiz;
+      if(!tcmapget(map, kbuf, ksiz, &vsiz)){
+        eprint(bdb, __LINE__, "(validation)");
+        err = true;
+      }
+      tcfree(kbuf);
+      cnum++;
+      if(i == 0){
+        tcbdbcurnext(cur);
+      } else {
+        tcbdbcurprev(cur);
+      }
+    }
+    if(tcbdbecode(bdb) != TCENOREC){
+      eprint(bdb, __LINE__, "tcbdbcurkey");
+      err = true;
+    }
+    tcbdbcurdel(cur);
+    if(cnum != vnum){
+      eprint(bdb, __LINE__, "(validation)");
+      err = true;
+    }
+  }
+  TCLIST *keys = tcbdbrange(bdb, NULL, -1, true, NULL, -1, true, -1);
+  if(tclistnum(keys) != tcmaprnum(map)){
+    eprint(bdb, __LINE__, "tcbdbrange");
+    err = true;
+  }
+  tclistdel(keys);
+  return !err;
+}
+
+
 /* parse arguments of write command */
 static int runwrite(int argc, char **argv){
   char *path = NULL;
@@ -293,6 +391,8 @@ static int runwrite(int argc, char **argv){
         opts |= BDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= BDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= BDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= BDBTEXCODEC;
       } else if(!strcmp(argv[i], "-lc")){
@@ -507,6 +607,8 @@ static int runrcat(int argc, char **argv){
         opts |= BDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= BDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= BDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= BDBTEXCODEC;
       } else if(!strcmp(argv[i], "-lc")){
@@ -614,6 +716,8 @@ static int runqueue(int argc, char **argv){
         opts |= BDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= BDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= BDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= BDBTEXCODEC;
       } else if(!strcmp(argv[i], "-lc")){
@@ -692,6 +796,8 @@ static int runmisc(int argc, char **argv){
         opts |= BDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= BDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= BDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= BDBTEXCODEC;
       } else if(!strcmp(argv[i], "-nl")){
@@ -736,6 +842,8 @@ static int runwicked(int argc, char **argv){
         opts |= BDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= BDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= BDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= BDBTEXCODEC;
       } else if(!strcmp(argv[i], "-nl")){
@@ -761,6 +869,60 @@ static int runwicked(int argc, char **argv){
 }
 
 
+/* parse arguments of expire command */
+static int runexpire(int argc, char **argv){
+  char *path = NULL;
+  char *rstr = NULL;
+  bool mt = false;
+  int opts = 0;
+  int lcnum = 0;
+  int ncnum = 0;
+  int omode = 0;
+  for(int i = 2; i < argc; i++){
+    if(!path && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-mt")){
+        mt = true;
+      } else if(!strcmp(argv[i], "-tl")){
+        opts |= BDBTLARGE;
+      } else if(!strcmp(argv[i], "-td")){
+        opts |= BDBTDEFLATE;
+      } else if(!strcmp(argv[i], "-tb")){
+        opts |= BDBTBZIP;
+      } else if(!strcmp(argv[i], "-tt")){
+        opts |= BDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= BDBTLZ;
+      } else if(!strcmp(argv[i], "-tx")){
+        opts |= BDBTEXCODEC;
+      } else if(!strcmp(argv[i], "-lc")){
+        if(++i >= argc) usage();
+        lcnum = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-nc")){
+        if(++i >= argc) usage();
+        ncnum = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-nl")){
+        omode |= BDBONOLCK;
+      } else if(!strcmp(argv[i], "-nb")){
+        omode |= BDBOLCKNB;
+      } else {
+        usage();
+      }
+    } else if(!path){
+      path = argv[i];
+    } else if(!rstr){
+      rstr = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if(!path || !rstr) usage();
+  int rnum = tcatoix(rstr);
+  if(rnum < 1) usage();
+  int rv = procexpire(path, rnum, mt, opts, lcnum, ncnum, omode);
+  return rv;
+}
+
+
 /* perform write command */
 static int procwrite(const char *path, int rnum, int lmemb, int nmemb, int bnum,
                      int apow, int fpow, bool mt, TCCMP cmp, int opts, int lcnum, int ncnum,
@@ -2478,6 +2640,24 @@ static int procwicked(const char *path, int rnum, bool mt, int opts, int omode){
         err = true;
       }
       tcbdbdel(nbdb);
+      if(!tcbdbbackup(bdb, npath)){
+        eprint(bdb, __LINE__, "tcbdbbackup");
+        err = true;
+      }
+      nbdb = tcbdbnew();
+      if(!tcbdbsetcodecfunc(nbdb, _tc_recencode, NULL, _tc_recdecode, NULL)){
+        eprint(nbdb, __LINE__, "tcbdbsetcodecfunc");
+        err = true;
+      }
+      if(!tcbdbopen(nbdb, npath, BDBOREADER | omode)){
+        eprint(nbdb, __LINE__, "tcbdbopen");
+        err = true;
+      }
+      if(tcbdbrnum(nbdb) != tcbdbrnum(bdb)){
+        eprint(nbdb, __LINE__, "(validation)");
+        err = true;
+      }
+      tcbdbdel(nbdb);
       unlink(npath);
       tcfree(npath);
       if(!tcbdboptimize(bdb, -1, -1, -1, -1, -1, -1)){
@@ -2583,4 +2763,289 @@ static int procwicked(const char *path, int rnum, bool mt, int opts, int omode){
 
 
 
+/* perform expire command */
+static int procexpire(const char *path, int rnum, bool mt, int opts, int lcnum, int ncnum,
+                      int omode){
+  iprintf("<Expiration Test>\n  seed=%u  path=%s  rnum=%d  mt=%d  opts=%d  lcnum=%d  ncnum=%d"
+          "  omode=%d\n\n", g_randseed, path, rnum, mt, opts, lcnum, ncnum, omode);
+  bool err = false;
+  double stime = tctime();
+  TCBDB *bdb = tcbdbnew();
+  if(g_dbgfd >= 0) tcbdbsetdbgfd(bdb, g_dbgfd);
+  if(mt && !tcbdbsetmutex(bdb)){
+    eprint(bdb, __LINE__, "tcbdbsetmutex");
+    err = true;
+  }
+  if(!tcbdbsetcodecfunc(bdb, _tc_recencode, NULL, _tc_recdecode, NULL)){
+    eprint(bdb, __LINE__, "tcbdbsetcodecfunc");
+    err = true;
+  }
+  if(!tcbdbtune(bdb, 8, 8, rnum / 50, 2, -1, opts)){
+    eprint(bdb, __LINE__, "tcbdbtune");
+    err = true;
+  }
+  if(!tcbdbsetcache(bdb, lcnum, ncnum)){
+    eprint(bdb, __LINE__, "tcbdbsetcache");
+    err = true;
+  }
+  if(!tcbdbsetdfunit(bdb, 8)){
+    eprint(bdb, __LINE__, "tcbdbsetdfunit");
+    err = true;
+  }
+  if(!tcbdbopen(bdb, path, BDBOWRITER | BDBOCREAT | BDBOTRUNC | omode)){
+    eprint(bdb, __LINE__, "tcbdbopen");
+    err = true;
+  }
+  TCMAP *map = tcmapnew2(rnum / 5);
+  TCMAP *nmap = tcmapnew2(rnum / 5);
+  TCMAP *xmap = tcmapnew2(rnum / 5);
+  int64_t xfar = (int64_t)time(NULL) + INT16_MAX * 100;
+  for(int i = 1; i <= rnum && !err; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "%08d", myrand(rnum) + 1);
+    char vbuf[RECBUFSIZ*4];
+    int vsiz = myrand(myrand(10) == 0 ? sizeof(vbuf) : RECBUFSIZ);
+    memset(vbuf, '*', vsiz);
+    char xbuf[RECBUFSIZ];
+    int xsiz;
+    int64_t xt;
+    switch(myrand(11)){
+      case 0:
+        iputchar('0');
+        if(!tcbdbput(bdb, kbuf, ksiz, vbuf, vsiz)){
+          eprint(bdb, __LINE__, "tcbdbput");
+          err = true;
+        }
+        if(!tcmapget(map, kbuf, ksiz, &xsiz)) tcmapaddint(nmap, kbuf, ksiz, 1);
+        tcmapput(map, kbuf, ksiz, vbuf, vsiz);
+        tcmapout(xmap, kbuf, ksiz);
+        break;
+      case 1:
+      case 2:
+        iputchar('1');
+        xt = xfar + myrand(100);
+        if(!tcbdbputxt(bdb, kbuf, ksiz, vbuf, vsiz, -xt)){
+          eprint(bdb, __LINE__, "tcbdbputxt");
+          err = true;
+        }
+        if(!tcmapget(map, kbuf, ksiz, &xsiz)) tcmapaddint(nmap, kbuf, ksiz, 1);
+        tcmapput(map, kbuf, ksiz, vbuf, vsiz);
+        xsiz = sprintf(xbuf, "%lld", (long long)xt);
+        tcmapput(xmap, kbuf, ksiz, xbuf, xsiz);
+        break;
+      case 3:
+        iputchar('2');
+        if(!tcbdbputxt(bdb, kbuf, ksiz, vbuf, vsiz, INT16_MAX)){
+          eprint(bdb, __LINE__, "tcbdbputxt");
+          err = true;
+        }
+        xt = tcbdbgetxt(bdb, kbuf, ksiz);
+        if(xt < (int64_t)time(NULL) + INT16_MAX - 1 || xt > (int64_t)time(NULL) + INT16_MAX){
+          eprint(bdb, __LINE__, "tcbdbgetxt");
+          err = true;
+        }
+        if(!tcmapget(map, kbuf, ksiz, &xsiz)) tcmapaddint(nmap, kbuf, ksiz, 1);
+        tcmapput(map, kbuf, ksiz, vbuf, vsiz);
+        xsiz = sprintf(xbuf, "%lld", (long long)xt);
+        tcmapput(xmap, kbuf, ksiz, xbuf, xsiz);
+        break;
+      case 4:
+      case 5:
+        iputchar('3');
+        if(!tcbdbputxt(bdb, kbuf, ksiz, vbuf, vsiz, -1 - myrand(100))){
+          eprint(bdb, __LINE__, "tcbdbputxt");
+          err = true;
+        }
+        tcmapout(map, kbuf, ksiz);
+        tcmapout(nmap, kbuf, ksiz);
+        tcmapout(xmap, kbuf, ksiz);
+        break;
+      case 6:
+        iputchar('4');
+        if(tcbdbputkeep(bdb, kbuf, ksiz, vbuf, vsiz)){
+          if(tcmapget(map, kbuf, ksiz, &xsiz)){
+            eprint(bdb, __LINE__, "tcbdbputkeep");
+            err = true;
+          }
+          tcmapput(map, kbuf, ksiz, vbuf, vsiz);
+          tcmapaddint(nmap, kbuf, ksiz, 1);
+        } else if(tcbdbecode(bdb) != TCEKEEP || !tcmapget(map, kbuf, ksiz, &xsiz)){
+          eprint(bdb, __LINE__, "tcbdbputkeep");
+          err = true;
+        }
+        break;
+      case 7:
+        iputchar('5');
+        if(!tcbdbputcat(bdb, kbuf, ksiz, vbuf, vsiz)){
+          eprint(bdb, __LINE__, "tcbdbputcat");
+          err = true;
+        }
+        if(!tcmapget(map, kbuf, ksiz, &xsiz)) tcmapaddint(nmap, kbuf, ksiz, 1);
+        tcmapputcat(map, kbuf, ksiz, vbuf, vsiz);
+        break;
+      case 8:
+        iputchar('6');
+        if(!tcbdbputdup(bdb, kbuf, ksiz, vbuf, vsiz)){
+          eprint(bdb, __LINE__, "tcbdbputdup");
+          err = true;
+        }
+        tcmapputkeep(map, kbuf, ksiz, vbuf, vsiz);
+        tcmapaddint(nmap, kbuf, ksiz, 1);
+        break;
+      case 9:
+        iputchar('7');
+        if(tcbdbout3(bdb, kbuf, ksiz)){
+          if(!tcmapget(map, kbuf, ksiz, &xsiz)){
+            eprint(bdb, __LINE__, "tcbdbout3");
+            err = true;
+          }
+        } else if(tcbdbecode(bdb) != TCENOREC || tcmapget(map, kbuf, ksiz, &xsiz)){
+          eprint(bdb, __LINE__, "tcbdbout3");
+          err = true;
+        }
+        tcmapout(map, kbuf, ksiz);
+        tcmapout(nmap, kbuf, ksiz);
+        tcmapout(xmap, kbuf, ksiz);
+        break;
+      default:
+        iputchar('8');
+        if(myrand(rnum / 50 + 1) == 0){
+          if(!tcbdbdefrag(bdb, myrand(2) == 0 ? 0 : myrand(rnum / 10 + 1) + 1)){
+            eprint(bdb, __LINE__, "tcbdbdefrag");
+            err = true;
+          }
+        } else if(myrand(rnum / 20 + 1) == 0){
+          if(!tcbdboptimize(bdb, -1, -1, -1, -1, -1, UINT8_MAX)){
+            eprint(bdb, __LINE__, "tcbdboptimize");
+            err = true;
+          }
+        } else {
+          const char *mbuf = tcmapget(map, kbuf, ksiz, &xsiz);
+          int rsiz;
+          char *rbuf = tcbdbget(bdb, kbuf, ksiz, &rsiz);
+          if(mbuf ? (!rbuf || rsiz != xsiz || memcmp(rbuf, mbuf, rsiz)) : rbuf != NULL){
+            eprint(bdb, __LINE__, "tcbdbget");
+            err = true;
+          }
+          tcfree(rbuf);
+        }
+        break;
+    }
+    if(i % 50 == 0) iprintf(" (%08d)\n", i);
+  }
+  if(rnum % 50 > 0) iprintf(" (%08d)\n", rnum);
+  if(!expirecheck(bdb, rnum, map, nmap, xmap)) err = true;
+  if(!tcbdbdefrag(bdb, 0)){
+    eprint(bdb, __LINE__, "tcbdbdefrag");
+    err = true;
+  }
+  int64_t vnum = 0;
+  tcmapiterinit(nmap);
+  const char *ikbuf;
+  int iksiz;
+  while((ikbuf = tcmapiternext(nmap, &iksiz)) != NULL){
+    vnum += *(int *)tcmapiterval(ikbuf, &iksiz);
+  }
+  if(tcbdbrnum(bdb) != vnum){
+    eprint(bdb, __LINE__, "(validation)");
+    err = true;
+  }
+  if(!expirecheck(bdb, rnum, map, nmap, xmap)) err = true;
+  for(int i = 1; i <= rnum / 10; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "%08d", myrand(rnum) + 1);
+    if(!tcbdbputxt(bdb, kbuf, ksiz, kbuf, ksiz, -1)){
+      eprint(bdb, __LINE__, "tcbdbputxt");
+      err = true;
+      break;
+    }
+    const int *np = tcmapget(nmap, kbuf, ksiz, &iksiz);
+    if(np) vnum -= *np;
+    tcmapout(map, kbuf, ksiz);
+    tcmapout(nmap, kbuf, ksiz);
+    tcmapout(xmap, kbuf, ksiz);
+  }
+  if(!tcbdboptimize(bdb, -1, -1, -1, -1, -1, UINT8_MAX)){
+    eprint(bdb, __LINE__, "tcbdboptimize");
+    err = true;
+  }
+  if(tcbdbrnum(bdb) != vnum){
+    eprint(bdb, __LINE__, "(validation)");
+    err = true;
+  }
+  if(!expirecheck(bdb, rnum, map, nmap, xmap)) err = true;
+  if(tcmaprnum(xmap) > 0 && !bdb->expire){
+    eprint(bdb, __LINE__, "(validation)");
+    err = true;
+  }
+  tcmapiterinit(xmap);
+  while((ikbuf = tcmapiternext(xmap, &iksiz)) != NULL){
+    int vsiz;
+    const char *vbuf = tcmapget(map, ikbuf, iksiz, &vsiz);
+    if(!tcbdbput(bdb, ikbuf, iksiz, vbuf, vsiz)){
+      eprint(bdb, __LINE__, "tcbdbput");
+      err = true;
+      break;
+    }
+  }
+  tcmapclear(xmap);
+  if(!tcbdbdefrag(bdb, 0)){
+    eprint(bdb, __LINE__, "tcbdbdefrag");
+    err = true;
+  }
+  if(bdb->expire){
+    eprint(bdb, __LINE__, "(validation)");
+    err = true;
+  }
+  if(!expirecheck(bdb, rnum, map, nmap, xmap)) err = true;
+  char xbuf[RECBUFSIZ];
+  int xsiz = sprintf(xbuf, "%08d", myrand(rnum) + 1);
+  if(!tcbdbputxt(bdb, xbuf, xsiz, xbuf, xsiz, INT16_MAX)){
+    eprint(bdb, __LINE__, "tcbdbputxt");
+    err = true;
+  }
+  if(!tcmapget(map, xbuf, xsiz, &iksiz)) tcmapaddint(nmap, xbuf, xsiz, 1);
+  tcmapput(map, xbuf, xsiz, xbuf, xsiz);
+  tcmapprintf(xmap, xbuf, "%lld", (long long)tcbdbgetxt(bdb, xbuf, xsiz));
+  if(!tcbdbdefrag(bdb, 0)){
+    eprint(bdb, __LINE__, "tcbdbdefrag");
+    err = true;
+  }
+  if(!bdb->expire){
+    eprint(bdb, __LINE__, "(validation)");
+    err = true;
+  }
+  if(!expirecheck(bdb, rnum, map, nmap, xmap)) err = true;
+  if(!tcbdbclose(bdb)){
+    eprint(bdb, __LINE__, "tcbdbclose");
+    err = true;
+  }
+  if(!tcbdbopen(bdb, path, BDBOREADER | omode)){
+    eprint(bdb, __LINE__, "tcbdbopen");
+    err = true;
+  }
+  if(!bdb->expire){
+    eprint(bdb, __LINE__, "(validation)");
+    err = true;
+  }
+  if(!expirecheck(bdb, rnum, map, nmap, xmap)) err = true;
+  iprintf("record number: %llu\n", (unsigned long long)tcbdbrnum(bdb));
+  iprintf("size: %llu\n", (unsigned long long)tcbdbfsiz(bdb));
+  mprint(bdb);
+  sysprint();
+  tcmapdel(xmap);
+  tcmapdel(nmap);
+  tcmapdel(map);
+  if(!tcbdbclose(bdb)){
+    eprint(bdb, __LINE__, "tcbdbclose");
+    err = true;
+  }
+  tcbdbdel(bdb);
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+
 // END OF FILE
@@ -137,6 +137,7 @@ TCFDB *tcfdbnew(void){
   TCFDB *fdb;
   TCMALLOC(fdb, sizeof(*fdb));
   tcfdbclear(fdb);
+  fdb->stats = tcstatsnew();
   return fdb;
 }
 
@@ -161,6 +162,7 @@ void tcfdbdel(TCFDB *fdb){
     TCFREE(fdb->amtx);
     TCFREE(fdb->mmtx);
   }
+  tcstatsdel(fdb->stats);
   TCFREE(fdb);
 }
 
@@ -291,6 +293,7 @@ bool tcfdbclose(TCFDB *fdb){
 /* Store a record into a fixed-length database object. */
 bool tcfdbput(TCFDB *fdb, int64_t id, const void *vbuf, int vsiz){
   assert(fdb && vbuf && vsiz >= 0);
+  uint64_t stime = tcstatsclock();
   if(!FDBLOCKMETHOD(fdb, id < 1)) return false;
   if(fdb->fd < 0 || !(fdb->omode & FDBOWRITER)){
     tcfdbsetecode(fdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -318,6 +321,7 @@ bool tcfdbput(TCFDB *fdb, int64_t id, const void *vbuf, int vsiz){
   bool rv = tcfdbputimpl(fdb, id, vbuf, vsiz, FDBPDOVER);
   FDBUNLOCKRECORD(fdb, id);
   FDBUNLOCKMETHOD(fdb);
+  tcstatsop(fdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -339,6 +343,7 @@ bool tcfdbput3(TCFDB *fdb, const char *kstr, const void *vstr){
 /* Store a new record into a fixed-length database object. */
 bool tcfdbputkeep(TCFDB *fdb, int64_t id, const void *vbuf, int vsiz){
   assert(fdb && vbuf && vsiz >= 0);
+  uint64_t stime = tcstatsclock();
   if(!FDBLOCKMETHOD(fdb, id < 1)) return false;
   if(fdb->fd < 0 || !(fdb->omode & FDBOWRITER)){
     tcfdbsetecode(fdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -366,6 +371,7 @@ bool tcfdbputkeep(TCFDB *fdb, int64_t id, const void *vbuf, int vsiz){
   bool rv = tcfdbputimpl(fdb, id, vbuf, vsiz, FDBPDKEEP);
   FDBUNLOCKRECORD(fdb, id);
   FDBUNLOCKMETHOD(fdb);
+  tcstatsop(fdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -387,6 +393,7 @@ bool tcfdbputkeep3(TCFDB *fdb, const char *kstr, const void *vstr){
 /* Concatenate a value at the end of the existing record in a fixed-length database object. */
 bool tcfdbputcat(TCFDB *fdb, int64_t id, const void *vbuf, int vsiz){
   assert(fdb && vbuf && vsiz >= 0);
+  uint64_t stime = tcstatsclock();
   if(!FDBLOCKMETHOD(fdb, id < 1)) return false;
   if(fdb->fd < 0 || !(fdb->omode & FDBOWRITER)){
     tcfdbsetecode(fdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -414,6 +421,7 @@ bool tcfdbputcat(TCFDB *fdb, int64_t id, const void *vbuf, int vsiz){
   bool rv = tcfdbputimpl(fdb, id, vbuf, vsiz, FDBPDCAT);
   FDBUNLOCKRECORD(fdb, id);
   FDBUNLOCKMETHOD(fdb);
+  tcstatsop(fdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -435,6 +443,7 @@ bool tcfdbputcat3(TCFDB *fdb, const char *kstr, const void *vstr){
 /* Remove a record of a fixed-length database object. */
 bool tcfdbout(TCFDB *fdb, int64_t id){
   assert(fdb);
+  uint64_t stime = tcstatsclock();
   if(!FDBLOCKMETHOD(fdb, true)) return false;
   if(fdb->fd < 0 || !(fdb->omode & FDBOWRITER)){
     tcfdbsetecode(fdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -458,6 +467,7 @@ bool tcfdbout(TCFDB *fdb, int64_t id){
   bool rv = tcfdboutimpl(fdb, id);
   FDBUNLOCKRECORD(fdb, id);
   FDBUNLOCKMETHOD(fdb);
+  tcstatsop(fdb->stats, TCSOOUT, stime);
   return rv;
 }
 
@@ -479,6 +489,7 @@ bool tcfdbout3(TCFDB *fdb, const char *kstr){
 /* Retrieve a record in a fixed-length database object. */
 void *tcfdbget(TCFDB *fdb, int64_t id, int *sp){
   assert(fdb && sp);
+  uint64_t stime = tcstatsclock();
   if(!FDBLOCKMETHOD(fdb, false)) return false;
   if(fdb->fd < 0){
     tcfdbsetecode(fdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -503,6 +514,8 @@ void *tcfdbget(TCFDB *fdb, int64_t id, int *sp){
   char *rv = vbuf ? tcmemdup(vbuf, *sp) : NULL;
   FDBUNLOCKRECORD(fdb, id);
   FDBUNLOCKMETHOD(fdb);
+  if(!rv) tcstatsadd(fdb->stats, TCSCMISS, 1);
+  tcstatsop(fdb->stats, TCSOGET, stime);
   return rv;
 }
 
@@ -525,6 +538,7 @@ char *tcfdbget3(TCFDB *fdb, const char *kstr){
 /* Retrieve a record in a fixed-length database object and write the value into a buffer. */
 int tcfdbget4(TCFDB *fdb, int64_t id, void *vbuf, int max){
   assert(fdb && vbuf && max >= 0);
+  uint64_t stime = tcstatsclock();
   if(!FDBLOCKMETHOD(fdb, false)) return false;
   if(fdb->fd < 0){
     tcfdbsetecode(fdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -555,6 +569,8 @@ int tcfdbget4(TCFDB *fdb, int64_t id, void *vbuf, int max){
   }
   FDBUNLOCKRECORD(fdb, id);
   FDBUNLOCKMETHOD(fdb);
+  if(vsiz < 0) tcstatsadd(fdb->stats, TCSCMISS, 1);
+  tcstatsop(fdb->stats, TCSOGET, stime);
   return vsiz;
 }
 
@@ -623,6 +639,7 @@ bool tcfdbiterinit(TCFDB *fdb){
 /* Get the next ID number of the iterator of a fixed-length database object. */
 uint64_t tcfdbiternext(TCFDB *fdb){
   assert(fdb);
+  uint64_t stime = tcstatsclock();
   if(!FDBLOCKMETHOD(fdb, true)) return false;
   if(fdb->fd < 0){
     tcfdbsetecode(fdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -631,6 +648,7 @@ uint64_t tcfdbiternext(TCFDB *fdb){
   }
   uint64_t rv = tcfdbiternextimpl(fdb);
   FDBUNLOCKMETHOD(fdb);
+  tcstatsop(fdb->stats, TCSOITER, stime);
   return rv;
 }
 
@@ -787,6 +805,7 @@ TCLIST *tcfdbrange5(TCFDB *fdb, const void *istr, int max){
 /* Add an integer to a record in a fixed-length database object. */
 int tcfdbaddint(TCFDB *fdb, int64_t id, int num){
   assert(fdb);
+  uint64_t stime = tcstatsclock();
   if(!FDBLOCKMETHOD(fdb, id < 1)) return INT_MIN;
   if(fdb->fd < 0 || !(fdb->omode & FDBOWRITER)){
     tcfdbsetecode(fdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -814,6 +833,7 @@ int tcfdbaddint(TCFDB *fdb, int64_t id, int num){
   bool rv = tcfdbputimpl(fdb, id, (char *)&num, sizeof(num), FDBPDADDINT);
   FDBUNLOCKRECORD(fdb, id);
   FDBUNLOCKMETHOD(fdb);
+  tcstatsop(fdb->stats, TCSOPUT, stime);
   return rv ? num : INT_MIN;
 }
 
@@ -821,6 +841,7 @@ int tcfdbaddint(TCFDB *fdb, int64_t id, int num){
 /* Add a real number to a record in a fixed-length database object. */
 double tcfdbadddouble(TCFDB *fdb, int64_t id, double num){
   assert(fdb);
+  uint64_t stime = tcstatsclock();
   if(!FDBLOCKMETHOD(fdb, id < 1)) return nan("");
   if(fdb->fd < 0 || !(fdb->omode & FDBOWRITER)){
     tcfdbsetecode(fdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -848,6 +869,7 @@ double tcfdbadddouble(TCFDB *fdb, int64_t id, double num){
   bool rv = tcfdbputimpl(fdb, id, (char *)&num, sizeof(num), FDBPDADDDBL);
   FDBUNLOCKRECORD(fdb, id);
   FDBUNLOCKMETHOD(fdb);
+  tcstatsop(fdb->stats, TCSOPUT, stime);
   return rv ? num : nan("");
 }
 
@@ -855,6 +877,7 @@ double tcfdbadddouble(TCFDB *fdb, int64_t id, double num){
 /* Synchronize updated contents of a fixed-length database object with the file and the device. */
 bool tcfdbsync(TCFDB *fdb){
   assert(fdb);
+  uint64_t stime = tcstatsclock();
   if(!FDBLOCKMETHOD(fdb, true)) return false;
   if(fdb->fd < 0 || !(fdb->omode & FDBOWRITER) || fdb->tran){
     tcfdbsetecode(fdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -863,6 +886,7 @@ bool tcfdbsync(TCFDB *fdb){
   }
   bool rv = tcfdbmemsync(fdb, true);
   FDBUNLOCKMETHOD(fdb);
+  tcstatsop(fdb->stats, TCSOSYNC, stime);
   return rv;
 }
 
@@ -976,6 +1000,7 @@ bool tcfdbtranbegin(TCFDB *fdb){
 /* Commit the transaction of a fixed-length database object. */
 bool tcfdbtrancommit(TCFDB *fdb){
   assert(fdb);
+  uint64_t stime = tcstatsclock();
   if(!FDBLOCKMETHOD(fdb, true)) return false;
   if(fdb->fd < 0 || !(fdb->omode & FDBOWRITER) || fdb->fatal || !fdb->tran){
     tcfdbsetecode(fdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -990,6 +1015,7 @@ bool tcfdbtrancommit(TCFDB *fdb){
   }
   fdb->tran = false;
   FDBUNLOCKMETHOD(fdb);
+  tcstatsop(fdb->stats, TCSOTRAN, stime);
   return !err;
 }
 
@@ -1266,6 +1292,7 @@ char *tcfdbopaque(TCFDB *fdb){
 /* Store a record into a fixed-length database object with a duplication handler. */
 bool tcfdbputproc(TCFDB *fdb, int64_t id, const void *vbuf, int vsiz, TCPDPROC proc, void *op){
   assert(fdb && proc);
+  uint64_t stime = tcstatsclock();
   if(!FDBLOCKMETHOD(fdb, id < 1)) return false;
   if(fdb->fd < 0 || !(fdb->omode & FDBOWRITER)){
     tcfdbsetecode(fdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -1317,6 +1344,7 @@ bool tcfdbputproc(TCFDB *fdb, int64_t id, const void *vbuf, int vsiz, TCPDPROC p
   if(rbuf != (char *)stack) TCFREE(rbuf);
   FDBUNLOCKRECORD(fdb, id);
   FDBUNLOCKMETHOD(fdb);
+  tcstatsop(fdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -1381,6 +1409,13 @@ bool tcfdbforeach(TCFDB *fdb, TCITER iter, void *op){
 }
 
 
+/* Get the statistics of operations of a fixed-length database object. */
+TCSTATS *tcfdbstats(TCFDB *fdb){
+  assert(fdb);
+  return fdb->stats;
+}
+
+
 /* Generate the ID number from arbitrary binary data. */
 int64_t tcfdbkeytoid(const char *kbuf, int ksiz){
   assert(kbuf && ksiz >= 0);
@@ -1497,6 +1532,7 @@ static void tcfdbclear(TCFDB *fdb){
   fdb->walfd = -1;
   fdb->walend = 0;
   fdb->dbgfd = -1;
+  fdb->stats = NULL;
   fdb->cnt_writerec = -1;
   fdb->cnt_readrec = -1;
   fdb->cnt_truncfile = -1;
@@ -2023,6 +2059,7 @@ static bool tcfdbputimpl(TCFDB *fdb, int64_t id, const void *vbuf, int vsiz, int
         *wp = 1;
       }
       TCDODEBUG(fdb->cnt_writerec++);
+      tcstatsadd(fdb->stats, TCSCWRITE, fdb->rsiz);
       fdb->rnum++;
       if(fdb->min < 1 || id < fdb->min) fdb->min = id;
       if(fdb->max < 1 || id > fdb->max) fdb->max = id;
@@ -2082,6 +2119,7 @@ static bool tcfdbputimpl(TCFDB *fdb, int64_t id, const void *vbuf, int vsiz, int
         *wp = 1;
       }
       TCDODEBUG(fdb->cnt_writerec++);
+      tcstatsadd(fdb->stats, TCSCWRITE, fdb->rsiz);
       return true;
     }
     if(dmode == FDBPDADDINT){
@@ -2100,6 +2138,7 @@ static bool tcfdbputimpl(TCFDB *fdb, int64_t id, const void *vbuf, int vsiz, int
       *(int *)vbuf = lnum;
       memcpy(rp, &lnum, sizeof(lnum));
       TCDODEBUG(fdb->cnt_writerec++);
+      tcstatsadd(fdb->stats, TCSCWRITE, fdb->rsiz);
       return true;
     }
     if(dmode == FDBPDADDDBL){
@@ -2118,6 +2157,7 @@ static bool tcfdbputimpl(TCFDB *fdb, int64_t id, const void *vbuf, int vsiz, int
       *(double *)vbuf = dnum;
       memcpy(rp, &dnum, sizeof(dnum));
       TCDODEBUG(fdb->cnt_writerec++);
+      tcstatsadd(fdb->stats, TCSCWRITE, fdb->rsiz);
       return true;
     }
     if(dmode == FDBPDPROC){
@@ -2128,6 +2168,7 @@ static bool tcfdbputimpl(TCFDB *fdb, int64_t id, const void *vbuf, int vsiz, int
         if(fdb->tran && !tcfdbwalwrite(fdb, (char *)rec - fdb->map, fdb->width)) return false;
         memset(rec, 0, fdb->wsiz + 1);
         TCDODEBUG(fdb->cnt_writerec++);
+        tcstatsadd(fdb->stats, TCSCWRITE, fdb->rsiz);
         if(!FDBLOCKATTR(fdb)) return false;
         fdb->rnum--;
         if(fdb->rnum < 1){
@@ -2175,6 +2216,7 @@ static bool tcfdbputimpl(TCFDB *fdb, int64_t id, const void *vbuf, int vsiz, int
       }
       TCFREE(nvbuf);
       TCDODEBUG(fdb->cnt_writerec++);
+      tcstatsadd(fdb->stats, TCSCWRITE, fdb->rsiz);
       return true;
     }
   }
@@ -2205,6 +2247,7 @@ static bool tcfdbputimpl(TCFDB *fdb, int64_t id, const void *vbuf, int vsiz, int
     *wp = 1;
   }
   TCDODEBUG(fdb->cnt_writerec++);
+  tcstatsadd(fdb->stats, TCSCWRITE, fdb->rsiz);
   if(miss){
     if(!FDBLOCKATTR(fdb)) return false;
     fdb->rnum++;
@@ -2255,6 +2298,7 @@ static bool tcfdboutimpl(TCFDB *fdb, int64_t id){
   if(fdb->tran && !tcfdbwalwrite(fdb, (char *)rec - fdb->map, fdb->width)) return false;
   memset(rec, 0, fdb->wsiz + 1);
   TCDODEBUG(fdb->cnt_writerec++);
+  tcstatsadd(fdb->stats, TCSCWRITE, fdb->rsiz);
   if(!FDBLOCKATTR(fdb)) return false;
   fdb->rnum--;
   if(fdb->rnum < 1){
@@ -2314,6 +2358,7 @@ static const void *tcfdbgetimpl(TCFDB *fdb, int64_t id, int *sp){
     tcfdbsetecode(fdb, TCENOREC, __FILE__, __LINE__, __func__);
     return false;
   }
+  tcstatsadd(fdb->stats, TCSCREAD, fdb->rsiz);
   *sp = osiz;
   return rp;
 }
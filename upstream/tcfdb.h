@@ -69,6 +69,7 @@ typedef struct {                         /* type of structure for a fixed-length
   int walfd;                             /* file descriptor of write ahead logging */
   uint64_t walend;                       /* end offset of write ahead logging */
   int dbgfd;                             /* file descriptor for debugging */
+  TCSTATS *stats;                        /* statistics of operations */
   int64_t cnt_writerec;                  /* tesing counter for record write times */
   int64_t cnt_readrec;                   /* tesing counter for record read times */
   int64_t cnt_truncfile;                 /* tesing counter for file truncate times */
@@ -843,6 +844,14 @@ bool tcfdbiterinit4(TCFDB *fdb, const char *kstr);
 bool tcfdbforeach(TCFDB *fdb, TCITER iter, void *op);
 
 
+/* Get the statistics of operations of a fixed-length database object.
+   `fdb' specifies the fixed-length database object.
+   The return value is the statistics object of the database.  It is updated by every thread
+   calling the API of the object and valid until the object is deleted.  Read and written bytes
+   are counted by records. */
+TCSTATS *tcfdbstats(TCFDB *fdb);
+
+
 /* Generate the ID number from arbitrary binary data.
    `kbuf' specifies the pointer to the region of the key.
    `ksiz' specifies the size of the region of the key.
@@ -33,6 +33,14 @@
 #define HDBRNUMOFF     48                // offset of the region for the record number
 #define HDBFSIZOFF     56                // offset of the region for the file size
 #define HDBFRECOFF     64                // offset of the region for the first record offset
+#define HDBLHBASEOFF   72                // offset of the region for the base of linear hashing
+#define HDBLHNUMOFF    80                // offset of the region for the active bucket number
+#define HDBVLTAILOFF   88                // offset of the region for the tail of the value log
+#define HDBVLDEADOFF   96                // offset of the region for the dead size of the value log
+#define HDBFWPOWOFF    104               // offset of the region for the fingerprint word power
+#define HDBFKNUMOFF    105               // offset of the region for the fingerprint bit number
+#define HDBAPSYNCOFF   112               // offset of the region for the synchronized end of records
+#define HDBAPRELOFF    120               // offset of the region for the record being released
 #define HDBOPAQUEOFF   128               // offset of the region for the opaque field
 
 #define HDBDEFBNUM     131071            // default bucket number
@@ -43,7 +51,7 @@
 #define HDBDEFXMSIZ    (64LL<<20)        // default size of the extra mapped memory
 #define HDBXFSIZINC    32768             // increment of extra file size
 #define HDBMINRUNIT    48                // minimum record reading unit
-#define HDBMAXHSIZ     32                // maximum record header size
+#define HDBMAXHSIZ     36                // maximum record header size
 #define HDBFBPALWRAT   2                 // allowance ratio of the free block pool
 #define HDBFBPBSIZ     64                // base region size of the free block pool
 #define HDBFBPESIZ     4                 // size of each region of the free block pool
@@ -52,8 +60,62 @@
 #define HDBDRPLAT      2048              // latitude size of the delayed record pool
 #define HDBDFRSRAT     2                 // step ratio of auto defragmentation
 #define HDBFBMAXSIZ    (INT32_MAX/4)     // maximum size of a free block pool
-#define HDBCACHEOUT    128               // number of records in a process of cacheout
+#define HDBRCSHARDNUM  16                // number of shards of the record cache
+#define HDBRCSHARDMIN  64                // minimum number of records in a shard of the record cache
+#define HDBRCPROBRAT   4                 // inverse ratio of the probationary queue of the cache
+#define HDBRCRECUNIT   48                // overhead size of a record in the record cache
+#define HDBRCBNUMMAX   (1<<20)           // maximum bucket number of a map of the record cache
+#define HDBLHSPLRAT    1                 // load ratio to split a bucket of linear hashing
+#define HDBLHSPLUNIT   8                 // maximum number of splits in a growing step
+#define HDBFPBITNUM    3                 // number of bits of a key in the bucket fingerprint
+#define HDBFPBITMAX    6                 // maximum number of bits of a key in the fingerprint
+#define HDBFWPOWMAX    6                 // maximum power of fingerprint words of a bucket
+#define HDBFPLOAD      2                 // assumed number of keys of a bucket for the rate
 #define HDBWALSUFFIX   "wal"             // suffix of write ahead logging file
+#define HDBVLSUFFIX    "vlog"            // suffix of the value log file
+#define HDBDEFRMTXNUM  256               // default number of record locks
+#define HDBMAXRMTXNUM  (1<<20)           // maximum number of record locks
+#define HDBCLINESIZ    64                // size of a cache line
+#define HDBSEQHOPMAX   64                // maximum number of hops of an optimistic reading
+#define HDBURINGDEPTH  64                // depth of the submission queue of asynchronous I/O
+#define HDBBGDFIDLE    1.0               // interval of checks by the idle background defragmenter
+#define HDBBGDFMAX     256               // maximum number of records of a background step
+#define HDBAWBATCH     256               // maximum number of records stored by the writer at once
+#define HDBAWIDLE      1.0               // interval of checks by the idle asynchronous writer
+#define HDBAWWAIT      0.01              // interval of checks by threads waiting for the writer
+#define HDBAWQMAX      (1<<24)           // maximum capacity of the queue of the writer
+#define HDBAWBUFMAX    65536             // maximum size of the buffer kept by a slot of the queue
+#define HDBHPAGESIZ    (1<<21)           // size of a huge page
+#define HDBVLPTRSIZ    12                // size of a reference into the value log
+#define HDBVLGCRAT     0.5               // ratio of dead values to start collection of the value log
+#define HDBSNAPPGSIZ   512               // size of a page logged for reader snapshots
+#define HDBOPTTHMAX    256               // maximum number of threads of parallel optimization
+#define HDBOPTCHKNUM   4                 // number of chunks per thread of parallel optimization
+#define HDBOPTUNITMIN  (1<<16)           // minimum size of a chunk of parallel optimization
+#define HDBOPTUNITMAX  (1<<22)           // maximum size of a chunk of parallel optimization
+#define HDBBLRUNSIZ    (1<<26)           // size of a sorted run of bulk loading
+#define HDBBLIOBUFSIZ  (1<<20)           // size of an I/O buffer of bulk loading
+#define HDBBLHSIZ      13                // size of the header of an entry of bulk loading
+#define HDBBLFANIN     64                // maximum number of runs merged at once in bulk loading
+#define HDBSCANSIZ     (1<<20)           // size of a chunk of sequential scanning
+#define HDBSCANALIGN   4096              // alignment of a chunk of sequential scanning
+#define HDBSCANRASIZ   (1<<23)           // size of the readahead window of sequential scanning
+#define HDBPTPRBSIZ    65536             // size of a window of probing for partitioning
+#define HDBRLSUFFIX    "redo"            // suffix of the redo log file
+#define HDBRLPGSIZ     4096              // size of a page kept beyond the mapped region for redo
+#define HDBRLPRUNIT    (1<<16)           // minimum size of a chunk of the map made private for redo
+#define HDBRLPRMAX     4096              // maximum number of chunks of the map made private for redo
+#define HDBRLFHSIZ     20                // size of the header of a frame of the redo log
+#define HDBRLRHSIZ     12                // size of the header of a region of the redo log
+#define HDBDEFCKPTSIZ  (64LL<<20)        // default size of the redo log to start a checkpoint
+#define HDBBKPGSIZ     (1<<16)           // size of a page tracked by online backup
+#define HDBBKCHUNKSIZ  (1<<22)           // size of a chunk copied at once by online backup
+#define HDBBKPASSMAX   8                 // maximum number of passes of online backup
+#define HDBBKLEFTMAX   64                // number of pages left to the catch-up of online backup
+#define HDBXTINHERIT   UINT32_MAX        // expiration time to keep that of the existing record
+#define HDBXTSWINTV    60                // interval of passes of the expiration sweeper in seconds
+#define HDBXTIDXRAT    2                 // ratio of the expiration index to the record number
+#define HDBXTIDXMIN    65536             // minimum size of the expiration index to be rebuilt
 
 typedef struct {                         // type of structure for a record
   uint64_t off;                          // offset of the record
@@ -65,6 +127,8 @@ typedef struct {                         // type of structure for a record
   uint32_t ksiz;                         // size of the key
   uint32_t vsiz;                         // size of the value
   uint16_t psiz;                         // size of the padding
+  bool vlog;                             // whether the value is a reference into the value log
+  uint32_t xtime;                        // expiration time, or 0 if it never expires
   const char *kbuf;                      // pointer to the key
   const char *vbuf;                      // pointer to the value
   uint64_t boff;                         // offset of the body
@@ -76,8 +140,30 @@ typedef struct {                         // type of structure for a free block
   uint32_t rsiz;                         // size of the block
 } HDBFB;
 
+enum {                                   // enumeration for indices of the free block pool
+  HDBFBPSIZE,                            // ordered by size and offset
+  HDBFBPOFF                              // ordered by offset
+};
+
+typedef struct {                         // type of structure for a node of the free block pool
+  uint64_t off;                          // offset of the block
+  uint32_t rsiz;                         // size of the block
+  int32_t child[2][2];                   // left and right children in each index
+} HDBFBNODE;
+
+typedef struct {                         // type of structure for the free block pool
+  HDBFBNODE *nodes;                      // array of the nodes
+  int32_t cap;                           // number of the nodes
+  int32_t used;                          // number of the nodes which have been used
+  int32_t free;                          // head of the list of released nodes
+  int32_t root[2];                       // root nodes of the indices
+} HDBFBP;
+
 enum {                                   // enumeration for magic data
   HDBMAGICREC = 0xc8,                    // for data block
+  HDBMAGICVLREC = 0xc9,                  // for data block referring to the value log
+  HDBMAGICXREC = 0xca,                   // for data block with an expiration time
+  HDBMAGICXVLREC = 0xcb,                 // for data block with both of them
   HDBMAGICFB = 0xb0                      // for free block
 };
 
@@ -95,6 +181,189 @@ typedef struct {                         // type of structure for a duplication
   void *op;                              // opaque pointer
 } HDBPDPROCOP;
 
+typedef struct {                         // type of structure for a record lock
+  pthread_rwlock_t rwlock;               // reader-writer lock
+  volatile uint32_t seq;                 // sequence number for optimistic reading
+} HDBRLOCK;
+
+typedef struct {                         // type of structure for a shard of the record cache
+  pthread_mutex_t mutex;                 // mutex for the shard
+  TCMAP *pmap;                           // probationary records in the FIFO order
+  TCMAP *gmap;                           // keys of ghost records evicted from the probation
+  TCMAP *fmap;                           // frequent records in the LRU order
+  int64_t psiz;                          // total size of the probationary records
+  int64_t fsiz;                          // total size of the frequent records
+  uint64_t hnum;                         // number of hits
+  uint64_t mnum;                         // number of misses
+} HDBRCSHARD;
+
+typedef struct {                         // type of structure for the record cache
+  HDBRCSHARD *shards;                    // array of the shards
+  int snum;                              // number of the shards
+  bool mt;                               // whether the shards are locked
+  int64_t rmax;                          // maximum number of records in each shard
+  int64_t smax;                          // maximum size of records in each shard
+} HDBRCACHE;
+
+#define HDBRCRECSIZ(TC_ksiz, TC_vsiz) \
+  ((int64_t)(TC_ksiz) + (TC_vsiz) + HDBRCRECUNIT)
+
+#if TCUSEURING
+
+typedef struct {                         // type of structure for a ring of asynchronous I/O
+  int fd;                                // file descriptor of the ring
+  void *sqmap;                           // mapped region of the submission queue
+  size_t sqmsiz;                         // size of the mapped region of the submission queue
+  void *cqmap;                           // mapped region of the completion queue
+  size_t cqmsiz;                         // size of the mapped region of the completion queue
+  struct io_uring_sqe *sqes;             // entries of the submission queue
+  size_t sqesiz;                         // size of the entries of the submission queue
+  uint32_t *sqtail;                      // tail of the submission queue
+  uint32_t sqmask;                       // mask of the submission queue
+  uint32_t *sqarray;                     // index array of the submission queue
+  uint32_t *cqhead;                      // head of the completion queue
+  uint32_t *cqtail;                      // tail of the completion queue
+  uint32_t cqmask;                       // mask of the completion queue
+  struct io_uring_cqe *cqes;             // entries of the completion queue
+} HDBURING;
+
+#endif
+
+typedef struct {                         // type of structure for a background defragmenter
+  pthread_t thid;                        // thread ID
+  pthread_mutex_t mutex;                 // mutex for the control flags
+  pthread_cond_t cond;                   // condition variable to wake the thread
+  bool kick;                             // whether a step is requested
+  bool stop;                             // whether the thread should finish
+} HDBDFTH;
+
+typedef struct {                         // type of structure for a slot of the writer queue
+  volatile uint64_t seq;                 // sequence number of the slot
+  char *rbuf;                            // buffer of the queued record
+  int rsiz;                              // allocated size of the buffer
+  int ksiz;                              // size of the key
+  int vsiz;                              // size of the value
+} HDBAWSLOT;
+
+typedef struct {                         // type of structure for an asynchronous writer
+  pthread_t thid;                        // thread ID
+  pthread_mutex_t mutex;                 // mutex for sleeping and waiting
+  pthread_cond_t cond;                   // condition variable to wake the writer
+  pthread_cond_t dcnd;                   // condition variable to wake the waiting threads
+  HDBAWSLOT *slots;                      // ring of the slots
+  uint64_t mask;                         // mask of the positions of the ring
+  uint64_t head;                         // position to be taken out next
+  volatile uint64_t tail;                // position to be put next
+  volatile uint64_t dnum;                // position until which records have been stored
+  volatile bool idle;                    // whether the writer is sleeping
+  volatile int wnum;                     // number of threads waiting for the writer
+  bool stop;                             // whether the thread should finish
+  volatile int ecode;                    // error code of the first failure
+} HDBAWTH;
+
+typedef struct {                         // type of structure for a probe of batched retrieval
+  int idx;                               // index of the key
+  uint8_t hash;                          // second hash value
+  uint64_t bidx;                         // index of the bucket
+  uint64_t lidx;                         // index of the record lock
+  uint64_t off;                          // offset of the first record of the bucket
+  int bufidx;                            // index of the block read ahead or -1
+} HDBPROBE;
+
+typedef struct {                         // type of structure for a reader snapshot
+  pthread_t owner;                       // thread which began the transaction
+  TCMAP *pages;                          // offsets of the logged pre-images of pages
+  uint64_t rnum;                         // number of records at the beginning
+  uint64_t lhnum;                        // number of active buckets at the beginning
+  uint64_t lhmod;                        // modulus of linear hashing at the beginning
+} HDBSNAP;
+
+typedef struct {                         // type of structure for a chunk of parallel optimization
+  TCHDB *hdb;                            // database object of the source
+  TCHDB *thdb;                           // database object of the destination
+  char *buf;                             // buffer of the records
+  int64_t bsiz;                          // allocated size of the buffer
+  uint64_t off;                          // offset of the chunk
+  int64_t size;                          // size of the chunk
+  TCLIST *recs;                          // keys, encoded values and expiration times by turns
+  int ecode;                             // error code of the worker
+  bool done;                             // whether the worker has finished the chunk
+} HDBOPTJOB;
+
+typedef struct {                         // type of structure for workers of parallel optimization
+  pthread_mutex_t mutex;                 // mutex for the queue
+  pthread_cond_t cond;                   // condition variable to wake the workers
+  pthread_cond_t dcnd;                   // condition variable to wake the main thread
+  HDBOPTJOB *jobs;                       // ring of the chunks
+  int jnum;                              // number of the chunks in the ring
+  uint64_t qnum;                         // number of chunks queued
+  uint64_t tnum;                         // number of chunks taken by the workers
+  bool stop;                             // whether the workers should finish
+} HDBOPTPOOL;
+
+typedef struct {                         // type of structure for an entry of a run of bulk loading
+  uint64_t bidx;                         // index of the bucket
+  uint64_t off;                          // offset of the entry in the run buffer
+} HDBBLENT;
+
+typedef struct {                         // type of structure for a reader of a run of bulk loading
+  int fd;                                // file descriptor
+  char *buf;                             // read buffer
+  int rp;                                // reading position in the buffer
+  int len;                               // length of the data in the buffer
+  bool end;                              // whether the run is exhausted
+  int idx;                               // order of the run among the runs merged together
+  uint64_t bidx;                         // index of the bucket of the current entry
+  uint8_t hash;                          // second hash value of the current entry
+  uint32_t ksiz;                         // size of the key of the current entry
+  uint32_t vsiz;                         // size of the value of the current entry
+  uint32_t xtime;                        // expiration time of the current entry
+  char *kvbuf;                           // region of the key and the value of the current entry
+  uint32_t kvcap;                        // allocated size of the region
+} HDBBLRUN;
+
+typedef struct {                         // type of structure for a record of a bucket of bulk loading
+  const char *kbuf;                      // pointer to the region of the key
+  uint32_t ksiz;                         // size of the key
+  uint32_t vsiz;                         // size of the value
+  uint32_t xtime;                        // expiration time
+  bool vlog;                             // whether the value is moved into the value log
+  uint64_t vloff;                        // offset of the value in the value log
+  uint64_t koff;                         // offset of the key in the group buffer
+  uint64_t seq;                          // sequence number in the input
+  uint64_t off;                          // offset of the record
+  uint64_t left;                         // offset of the left child
+  uint64_t right;                        // offset of the right child
+  uint16_t psiz;                         // size of the padding
+  uint8_t hash;                          // second hash value
+} HDBBLREC;
+
+typedef struct {                         // type of structure for a reader of sequential scanning
+  char *buf;                             // buffer of the current chunk
+  uint64_t off;                          // offset of the current chunk
+  int32_t size;                          // size of the data in the buffer
+  uint64_t wseq;                         // write sequence number when the chunk was read
+  uint64_t raend;                        // end of the region advised to be read ahead
+} HDBSCAN;
+
+typedef struct {                         // type of structure for a transaction with redo logging
+  TCXSTR *marks;                         // pairs of the beginning and the end of updated regions
+  TCMAP *pages;                          // pages written beyond the mapped region
+  uint64_t pbeg;                         // offset of the first page beyond the mapped region
+  uint64_t msiz;                         // size of the mapped region
+  uint64_t punit;                        // size of a chunk of the mapped region made private
+  char *privs;                           // flags whether each chunk is mapped privately
+} HDBREDO;
+
+typedef struct {                         // type of structure for an online backup
+  pthread_mutex_t mutex;                 // mutex for the updated pages
+  TCMAP *pages;                          // indices of the pages updated since the last pass
+  bool cancel;                           // whether the database was closed
+} HDBBKUP;
+
+#define HDBRLOCKSIZ                                                     \
+  ((sizeof(HDBRLOCK) + HDBCLINESIZ - 1) / HDBCLINESIZ * HDBCLINESIZ)
+
 
 /* private macros */
 #define HDBLOCKMETHOD(TC_hdb, TC_wr)                            \
@@ -102,9 +371,9 @@ typedef struct {                         // type of structure for a duplication
 #define HDBUNLOCKMETHOD(TC_hdb)                         \
   ((TC_hdb)->mmtx ? tchdbunlockmethod(TC_hdb) : true)
 #define HDBLOCKRECORD(TC_hdb, TC_bidx, TC_wr)                           \
-  ((TC_hdb)->mmtx ? tchdblockrecord((TC_hdb), (uint8_t)(TC_bidx), (TC_wr)) : true)
+  ((TC_hdb)->mmtx ? tchdblockrecord((TC_hdb), (TC_bidx), (TC_wr)) : true)
 #define HDBUNLOCKRECORD(TC_hdb, TC_bidx)                                \
-  ((TC_hdb)->mmtx ? tchdbunlockrecord((TC_hdb), (uint8_t)(TC_bidx)) : true)
+  ((TC_hdb)->mmtx ? tchdbunlockrecord((TC_hdb), (TC_bidx)) : true)
 #define HDBLOCKALLRECORDS(TC_hdb, TC_wr)                                \
   ((TC_hdb)->mmtx ? tchdblockallrecords((TC_hdb), (TC_wr)) : true)
 #define HDBUNLOCKALLRECORDS(TC_hdb)                             \
@@ -119,6 +388,13 @@ typedef struct {                         // type of structure for a duplication
   ((TC_hdb)->mmtx ? tchdbunlockwal(TC_hdb) : true)
 #define HDBTHREADYIELD(TC_hdb)                          \
   do { if((TC_hdb)->mmtx) sched_yield(); } while(false)
+#define HDBLHSPLITNEEDED(TC_hdb)                                        \
+  ((TC_hdb)->lhmod > 0 && (TC_hdb)->lhnum < (TC_hdb)->bnum &&           \
+   (TC_hdb)->rnum > (TC_hdb)->lhnum * HDBLHSPLRAT)
+#define HDBFBPPRIO(TC_off)                                      \
+  ((uint32_t)(((uint64_t)(TC_off) * 0x9e3779b97f4a7c15ULL) >> 32))
+#define HDBRLOCKPTR(TC_hdb, TC_idx)                                     \
+  ((HDBRLOCK *)((char *)(TC_hdb)->rmtxs + ((TC_idx) & ((TC_hdb)->rmtxnum - 1)) * HDBRLOCKSIZ))
 
 
 /* private function prototypes */
@@ -126,65 +402,212 @@ static uint64_t tcgetprime(uint64_t num);
 static bool tchdbseekwrite(TCHDB *hdb, off_t off, const void *buf, size_t size);
 static bool tchdbseekread(TCHDB *hdb, off_t off, void *buf, size_t size);
 static bool tchdbseekreadtry(TCHDB *hdb, off_t off, void *buf, size_t size);
+static void tchdbreadblocks(TCHDB *hdb, const uint64_t *offs, int num, char *buf, int *sizs);
+static void *tchdburingnew(void);
+static void tchdburingdel(void *ring);
+static bool tchdburingread(void *ring, int fd, const uint64_t *offs, int num, char *buf, int bsiz,
+                           int *sizs);
+static void tchdburingabort(void *ring, bool *dones, int num, int pnum);
 static void tchdbdumpmeta(TCHDB *hdb, char *hbuf);
 static void tchdbloadmeta(TCHDB *hdb, const char *hbuf);
 static void tchdbclear(TCHDB *hdb);
 static int32_t tchdbpadsize(TCHDB *hdb, uint64_t off);
+static int32_t tchdbapfit(TCHDB *hdb, uint32_t rsiz);
 static void tchdbsetflag(TCHDB *hdb, int flag, bool sign);
+static void tchdbsetapsync(TCHDB *hdb, uint64_t off);
+static void tchdbsetaprel(TCHDB *hdb, uint64_t off);
+static uint32_t tchdbxtime(int64_t xt);
 static uint64_t tchdbbidx(TCHDB *hdb, const char *kbuf, int ksiz, uint8_t *hp);
+static uint64_t tchdbbidx2(TCHDB *hdb, const char *kbuf, int ksiz, uint8_t *hp,
+                           uint64_t lhnum, uint64_t lhmod);
 static off_t tchdbgetbucket(TCHDB *hdb, uint64_t bidx);
 static void tchdbsetbucket(TCHDB *hdb, uint64_t bidx, uint64_t off);
+static uint32_t tchdbfpbits(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t *wip);
+static bool tchdbfpmiss(TCHDB *hdb, uint64_t bidx, const char *kbuf, int ksiz);
+static void tchdbfpadd(TCHDB *hdb, uint64_t bidx, const char *kbuf, int ksiz);
+static void tchdbfpclear(TCHDB *hdb, uint64_t bidx);
 static bool tchdbsavefbp(TCHDB *hdb);
 static bool tchdbloadfbp(TCHDB *hdb);
-static void tcfbpsortbyoff(HDBFB *fbpool, int fbpnum);
-static void tcfbpsortbyrsiz(HDBFB *fbpool, int fbpnum);
+static HDBFBP *tchdbfbpnew(int32_t cap);
+static void tchdbfbpdel(HDBFBP *fbp);
+static void tchdbfbpreset(HDBFBP *fbp);
+static int tchdbfbpcmp(HDBFBP *fbp, int32_t aidx, int32_t bidx, int tree);
+static int32_t tchdbfbpinsnode(HDBFBP *fbp, int32_t root, int32_t idx, int tree);
+static int32_t tchdbfbpjoinnode(HDBFBP *fbp, int32_t left, int32_t right, int tree);
+static int32_t tchdbfbpoutnode(HDBFBP *fbp, int32_t root, int32_t idx, int tree);
+static int32_t tchdbfbpbestfit(HDBFBP *fbp, uint32_t rsiz);
+static int32_t tchdbfbpceil(HDBFBP *fbp, uint64_t off);
+static void tchdbfbpadd(TCHDB *hdb, uint64_t off, uint32_t rsiz);
+static void tchdbfbpout(TCHDB *hdb, int32_t idx);
+static void tchdbfbpoutrange(TCHDB *hdb, uint64_t lower, uint64_t upper);
+static void tchdbfbpclear(TCHDB *hdb);
 static void tchdbfbpmerge(TCHDB *hdb);
+static void tchdbfbpreduce(TCHDB *hdb, int32_t max);
 static void tchdbfbpinsert(TCHDB *hdb, uint64_t off, uint32_t rsiz);
 static bool tchdbfbpsearch(TCHDB *hdb, TCHREC *rec);
 static bool tchdbfbpsplice(TCHDB *hdb, TCHREC *rec, uint32_t nsiz);
 static void tchdbfbptrim(TCHDB *hdb, uint64_t base, uint64_t next, uint64_t off, uint32_t rsiz);
 static bool tchdbwritefb(TCHDB *hdb, uint64_t off, uint32_t rsiz);
 static bool tchdbwriterec(TCHDB *hdb, TCHREC *rec, uint64_t bidx, off_t entoff);
+static bool tchdbrewriterec(TCHDB *hdb, TCHREC *rec, uint64_t bidx, off_t entoff);
 static bool tchdbreadrec(TCHDB *hdb, TCHREC *rec, char *rbuf);
+static void tchdbscaninit(HDBSCAN *scan);
+static void tchdbscanclear(HDBSCAN *scan);
+static bool tchdbscanreadrec(TCHDB *hdb, HDBSCAN *scan, TCHREC *rec, char *rbuf);
+static bool tchdbscanfill(TCHDB *hdb, HDBSCAN *scan, uint64_t off);
+static void tchdbscanpatch(TCHDB *hdb, uint64_t off, const void *buf, size_t size);
+static bool tchdbparserec(TCHDB *hdb, TCHREC *rec, char *rbuf, int rsiz);
+static bool tchdbparserectry(TCHDB *hdb, TCHREC *rec, char *rbuf, int rsiz);
 static bool tchdbreadrecbody(TCHDB *hdb, TCHREC *rec);
+static bool tchdbreadrecvalue(TCHDB *hdb, TCHREC *rec);
+static bool tchdbvlgetref(TCHDB *hdb, TCHREC *rec, uint64_t *offp, uint32_t *sizp);
+static void tchdbvlsetref(char *pbuf, uint64_t off, uint32_t vsiz);
+static bool tchdbvlput(TCHDB *hdb, TCHREC *rec, char *pbuf);
+static bool tchdbvlpeek(TCHDB *hdb, TCHREC *rec, uint64_t *offp, uint32_t *sizp);
+static void tchdbvlrelease(TCHDB *hdb, uint64_t off, uint32_t vsiz);
+static void tchdbvltranabort(TCHDB *hdb);
 static bool tchdbremoverec(TCHDB *hdb, TCHREC *rec, char *rbuf, uint64_t bidx, off_t entoff);
 static bool tchdbshiftrec(TCHDB *hdb, TCHREC *rec, char *rbuf, off_t destoff);
 static int tcreckeycmp(const char *abuf, int asiz, const char *bbuf, int bsiz);
+static int tchdbprobecmp(const void *a, const void *b);
+static int tchdbprobeoffcmp(const void *a, const void *b);
 static bool tchdbflushdrp(TCHDB *hdb);
-static void tchdbcacheadjust(TCHDB *hdb);
+static HDBRCACHE *tchdbrcnew(int32_t rcnum, int64_t rcsiz, bool mt);
+static void tchdbrcdel(HDBRCACHE *rc);
+static HDBRCSHARD *tchdbrcshard(HDBRCACHE *rc, const char *kbuf, int ksiz);
+static void tchdbrcshardadjust(TCHDB *hdb, HDBRCSHARD *shard);
+static char *tchdbrcget(TCHDB *hdb, const char *kbuf, int ksiz, int *sp);
+static void tchdbrcput(TCHDB *hdb, const char *kbuf, int ksiz, char mark,
+                       const char *vbuf, int vsiz);
+static void tchdbrcout(TCHDB *hdb, const char *kbuf, int ksiz);
+static void tchdbrcvanish(TCHDB *hdb);
 static bool tchdbwalinit(TCHDB *hdb);
 static bool tchdbwalwrite(TCHDB *hdb, uint64_t off, int64_t size);
-static int tchdbwalrestore(TCHDB *hdb, const char *path);
+static bool tchdbwalwritepages(TCHDB *hdb, uint64_t off, int64_t size);
+static bool tchdbwalappend(TCHDB *hdb);
+static int tchdbwalrestore(TCHDB *hdb, const char *path, uint64_t begoff, uint64_t begfsiz);
 static bool tchdbwalremove(TCHDB *hdb, const char *path);
+static bool tchdbrlbegin(TCHDB *hdb);
+static bool tchdbrlcommit(TCHDB *hdb);
+static bool tchdbrlabort(TCHDB *hdb);
+static bool tchdbrlend(TCHDB *hdb);
+static bool tchdbrlremap(TCHDB *hdb, uint64_t off, uint64_t size, int flags);
+static bool tchdbrlprivate(TCHDB *hdb, HDBREDO *redo, uint64_t off, int64_t size);
+static bool tchdbrlmark(TCHDB *hdb, uint64_t off, int64_t size);
+static int tchdbrlmarkcmp(const void *a, const void *b);
+static char *tchdbrlpage(TCHDB *hdb, uint64_t pidx, bool fill);
+static bool tchdbrlwrite(TCHDB *hdb, uint64_t off, const void *buf, size_t size);
+static bool tchdbrlread(TCHDB *hdb, uint64_t off, void *buf, size_t size);
+static bool tchdbrlpread(TCHDB *hdb, uint64_t off, void *buf, size_t size);
+static bool tchdbrlpwrite(TCHDB *hdb, int fd, uint64_t off, const void *buf, size_t size);
+static bool tchdbrlckpt(TCHDB *hdb);
+static bool tchdbrlrestore(TCHDB *hdb, const char *path);
+static bool tchdbrlremove(TCHDB *hdb, const char *path);
+static void *tchdbmapfile(TCHDB *hdb, int fd, size_t xmsiz, int omode);
+static bool tchdbmapadvise(TCHDB *hdb, void *map, size_t msiz, size_t xmsiz, size_t beg,
+                           size_t end);
 static bool tchdbopenimpl(TCHDB *hdb, const char *path, int omode);
 static bool tchdbcloseimpl(TCHDB *hdb);
 static bool tchdbputimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash,
-                         const char *vbuf, int vsiz, int dmode);
+                         const char *vbuf, int vsiz, int dmode, uint32_t xtime);
 static void tchdbdrpappend(TCHDB *hdb, const char *kbuf, int ksiz, const char *vbuf, int vsiz,
                            uint8_t hash);
 static bool tchdbputasyncimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx,
                               uint8_t hash, const char *vbuf, int vsiz);
 static bool tchdboutimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash);
 static char *tchdbgetimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash,
-                          int *sp);
+                          char *hbuf, int hsiz, int *sp);
+static bool tchdbgetseq(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash,
+                        char **vbp, int *sp);
+static const char *tchdbgetpinimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx,
+                                   uint8_t hash, int *sp, uint64_t *offp);
+static bool tchdbpinned(TCHDB *hdb, uint64_t off);
+static void tchdbsnapbegin(TCHDB *hdb);
+static void tchdbsnapend(TCHDB *hdb);
+static bool tchdbsnapactive(TCHDB *hdb);
+static bool tchdbsnapread(TCHDB *hdb, uint64_t off, void *buf, size_t size);
+static bool tchdbsnapreadrec(TCHDB *hdb, TCHREC *rec, char *rbuf);
+static bool tchdbsnapreadrecbody(TCHDB *hdb, TCHREC *rec);
+static char *tchdbsnapgetimpl(TCHDB *hdb, const char *kbuf, int ksiz, int *sp, uint32_t *xtp);
 static int tchdbgetintobuf(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash,
                            char *vbuf, int max);
 static char *tchdbgetnextimpl(TCHDB *hdb, const char *kbuf, int ksiz, int *sp,
                               const char **vbp, int *vsp);
 static int tchdbvsizimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash);
+static int64_t tchdbgetxtimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash);
 static bool tchdbiterinitimpl(TCHDB *hdb);
 static char *tchdbiternextimpl(TCHDB *hdb, int *sp);
 static bool tchdbiternextintoxstr(TCHDB *hdb, TCXSTR *kxstr, TCXSTR *vxstr);
 static bool tchdboptimizeimpl(TCHDB *hdb, int64_t bnum, int8_t apow, int8_t fpow, uint8_t opts);
+static bool tchdboptimizepara(TCHDB *hdb, TCHDB *thdb);
+static void *tchdboptimizeproc(void *arg);
+static void tchdboptimizejob(HDBOPTJOB *job);
 static bool tchdbvanishimpl(TCHDB *hdb);
 static bool tchdbcopyimpl(TCHDB *hdb, const char *path);
+static bool tchdbbackupimpl(TCHDB *hdb, HDBBKUP *bkup, int fd, int vlfd, uint64_t fsiz,
+                            uint64_t vlsiz, TCHDBBKPROC proc, void *op);
+static bool tchdbbkcopy(TCHDB *hdb, HDBBKUP *bkup, bool vl, int dfd, uint64_t off, uint64_t end,
+                        char *buf, bool locked);
+static bool tchdbbkcopypages(TCHDB *hdb, HDBBKUP *bkup, TCMAP *pages, int dfd, uint64_t end,
+                             char *buf, bool locked);
+static void tchdbbkmark(TCHDB *hdb, uint64_t off, int64_t size);
 static bool tchdbdefragimpl(TCHDB *hdb, int64_t step);
+static bool tchdbvlopen(TCHDB *hdb, const char *path, int omode);
+static bool tchdbvlread(TCHDB *hdb, uint64_t off, void *buf, size_t size);
+static bool tchdbvlreadraw(TCHDB *hdb, uint64_t off, void *buf, size_t size);
+static bool tchdbvlwrite(TCHDB *hdb, uint64_t off, const void *buf, size_t size);
+static bool tchdbvlgcstep(TCHDB *hdb, int64_t step);
+static bool tchdbxtstep(TCHDB *hdb, int64_t step);
+static bool tchdbxtsweep(TCHDB *hdb, int64_t step);
+static bool tchdbxtremove(TCHDB *hdb, TCHREC *rec, char *rbuf);
+static void tchdbxtindex(TCHDB *hdb, uint64_t off, uint32_t xtime);
+static void tchdbxtreset(TCHDB *hdb);
+static void tchdbxtsetnext(TCHDB *hdb);
 static bool tchdbiterjumpimpl(TCHDB *hdb, const char *kbuf, int ksiz);
-static bool tchdbforeachimpl(TCHDB *hdb, TCITER iter, void *op);
+static bool tchdbforeachimpl(TCHDB *hdb, uint64_t beg, uint64_t end, TCITER iter, void *op);
+static bool tchdbiternextpartimpl(TCHDB *hdb, uint64_t *curp, uint64_t end,
+                                  TCXSTR *kxstr, TCXSTR *vxstr);
+static bool tchdbpartpeek(TCHDB *hdb, TCHREC *rec, uint64_t end, char *rbuf, bool *errp);
+static uint64_t tchdbpartprobe(TCHDB *hdb, uint64_t off, uint64_t end);
+static bool tchdbreferred(TCHDB *hdb, TCHREC *rec, uint64_t bidx, uint8_t hash, bool *hitp);
+static bool tchdbaprecover(TCHDB *hdb, uint64_t end);
+static uint64_t tchdbapscan(TCHDB *hdb, uint64_t off, uint64_t fsiz, uint64_t end, bool *errp);
+static bool tchdbaprelease(TCHDB *hdb, uint64_t off);
+static bool tchdbapdefrag(TCHDB *hdb, int64_t step);
+static bool tchdbbulkloadimpl(TCHDB *hdb, TCHDBFEED feed, void *op);
+static void tchdbblsetlinear(TCHDB *hdb, uint64_t rnum);
+static bool tchdbblspill(TCHDB *hdb, int idx, TCXSTR *chunk, HDBBLENT *ents, int num);
+static bool tchdbblmerge(TCHDB *hdb, int rnum, int *idnump);
+static bool tchdbblmergeruns(TCHDB *hdb, const int *ids, int num, int oid);
+static bool tchdbblrunopen(TCHDB *hdb, HDBBLRUN *run, int id, int idx);
+static bool tchdbblrunclose(TCHDB *hdb, HDBBLRUN *run);
+static void tchdbblheapdown(HDBBLRUN **heap, int num, int idx);
+static bool tchdbblrunnext(TCHDB *hdb, HDBBLRUN *run);
+static int tchdbblrunfill(TCHDB *hdb, HDBBLRUN *run);
+static bool tchdbblrunread(TCHDB *hdb, HDBBLRUN *run, void *buf, int size);
+static uint64_t tchdbbltree(HDBBLREC *recs, int lo, int hi);
+static int tchdbblentcmp(const void *a, const void *b);
+static int tchdbblreccmp(const void *a, const void *b);
+static bool tchdbgcsync(TCHDB *hdb);
+static bool tchdbgcwaitimpl(TCHDB *hdb, uint64_t seq);
+static bool tchdbautodefrag(TCHDB *hdb);
+static bool tchdbbgdefragstart(TCHDB *hdb);
+static bool tchdbbgdefragstop(TCHDB *hdb);
+static bool tchdbbgdefragstep(TCHDB *hdb, uint64_t *bsp);
+static void *tchdbbgdefragproc(void *arg);
+static bool tchdbawstart(TCHDB *hdb);
+static bool tchdbawstop(TCHDB *hdb);
+static bool tchdbawpush(TCHDB *hdb, const char *kbuf, int ksiz, const char *vbuf, int vsiz);
+static bool tchdbawbarrier(TCHDB *hdb);
+static int tchdbawdrain(TCHDB *hdb, int max);
+static void *tchdbawproc(void *arg);
+static bool tchdblhgrow(TCHDB *hdb);
+static bool tchdblhsplitimpl(TCHDB *hdb);
+static bool tchdblhlinkrec(TCHDB *hdb, TCHREC *rec, uint64_t bidx);
 static bool tchdblockmethod(TCHDB *hdb, bool wr);
 static bool tchdbunlockmethod(TCHDB *hdb);
-static bool tchdblockrecord(TCHDB *hdb, uint8_t bidx, bool wr);
-static bool tchdbunlockrecord(TCHDB *hdb, uint8_t bidx);
+static bool tchdblockrecord(TCHDB *hdb, uint64_t bidx, bool wr);
+static bool tchdbunlockrecord(TCHDB *hdb, uint64_t bidx);
 static bool tchdblockallrecords(TCHDB *hdb, bool wr);
 static bool tchdbunlockallrecords(TCHDB *hdb);
 static bool tchdblockdb(TCHDB *hdb);
@@ -215,6 +638,7 @@ TCHDB *tchdbnew(void){
   TCHDB *hdb;
   TCMALLOC(hdb, sizeof(*hdb));
   tchdbclear(hdb);
+  hdb->stats = tcstatsnew();
   return hdb;
 }
 
@@ -225,18 +649,23 @@ void tchdbdel(TCHDB *hdb){
   if(hdb->fd >= 0) tchdbclose(hdb);
   if(hdb->mmtx){
     pthread_key_delete(*(pthread_key_t *)hdb->eckey);
+    pthread_cond_destroy(hdb->gcnd);
+    pthread_mutex_destroy(hdb->gmtx);
     pthread_mutex_destroy(hdb->wmtx);
     pthread_mutex_destroy(hdb->dmtx);
-    for(int i = UINT8_MAX; i >= 0; i--){
-      pthread_rwlock_destroy((pthread_rwlock_t *)hdb->rmtxs + i);
+    for(int i = hdb->rmtxnum - 1; i >= 0; i--){
+      pthread_rwlock_destroy(&HDBRLOCKPTR(hdb, i)->rwlock);
     }
     pthread_rwlock_destroy(hdb->mmtx);
     TCFREE(hdb->eckey);
+    TCFREE(hdb->gcnd);
+    TCFREE(hdb->gmtx);
     TCFREE(hdb->wmtx);
     TCFREE(hdb->dmtx);
     TCFREE(hdb->rmtxs);
     TCFREE(hdb->mmtx);
   }
+  tcstatsdel(hdb->stats);
   TCFREE(hdb);
 }
 
@@ -251,40 +680,65 @@ int tchdbecode(TCHDB *hdb){
 
 /* Set mutual exclusion control of a hash database object for threading. */
 bool tchdbsetmutex(TCHDB *hdb){
+  assert(hdb);
+  return tchdbsetmutex2(hdb, -1);
+}
+
+
+/* Set mutual exclusion control of a hash database object with the number of record locks. */
+bool tchdbsetmutex2(TCHDB *hdb, int32_t rmtxnum){
   assert(hdb);
   if(!TCUSEPTHREAD) return true;
   if(hdb->mmtx || hdb->fd >= 0){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
     return false;
   }
+  if(rmtxnum < 1) rmtxnum = HDBDEFRMTXNUM;
+  if(rmtxnum > HDBMAXRMTXNUM) rmtxnum = HDBMAXRMTXNUM;
+  hdb->rmtxnum = 1;
+  while(hdb->rmtxnum < rmtxnum){
+    hdb->rmtxnum <<= 1;
+  }
   pthread_mutexattr_t rma;
   pthread_mutexattr_init(&rma);
   TCMALLOC(hdb->mmtx, sizeof(pthread_rwlock_t));
-  TCMALLOC(hdb->rmtxs, (UINT8_MAX + 1) * sizeof(pthread_rwlock_t));
+  if(posix_memalign(&hdb->rmtxs, HDBCLINESIZ, hdb->rmtxnum * HDBRLOCKSIZ) != 0)
+    tcmyfatal("out of memory");
   TCMALLOC(hdb->dmtx, sizeof(pthread_mutex_t));
   TCMALLOC(hdb->wmtx, sizeof(pthread_mutex_t));
+  TCMALLOC(hdb->gmtx, sizeof(pthread_mutex_t));
+  TCMALLOC(hdb->gcnd, sizeof(pthread_cond_t));
   TCMALLOC(hdb->eckey, sizeof(pthread_key_t));
   bool err = false;
   if(pthread_mutexattr_settype(&rma, PTHREAD_MUTEX_RECURSIVE) != 0) err = true;
   if(pthread_rwlock_init(hdb->mmtx, NULL) != 0) err = true;
-  for(int i = 0; i <= UINT8_MAX; i++){
-    if(pthread_rwlock_init((pthread_rwlock_t *)hdb->rmtxs + i, NULL) != 0) err = true;
+  for(int i = 0; i < hdb->rmtxnum; i++){
+    HDBRLOCK *rlock = HDBRLOCKPTR(hdb, i);
+    if(pthread_rwlock_init(&rlock->rwlock, NULL) != 0) err = true;
+    rlock->seq = 0;
   }
   if(pthread_mutex_init(hdb->dmtx, &rma) != 0) err = true;
   if(pthread_mutex_init(hdb->wmtx, NULL) != 0) err = true;
+  if(pthread_mutex_init(hdb->gmtx, NULL) != 0) err = true;
+  if(pthread_cond_init(hdb->gcnd, NULL) != 0) err = true;
   if(pthread_key_create(hdb->eckey, NULL) != 0) err = true;
   if(err){
     tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
     pthread_mutexattr_destroy(&rma);
     TCFREE(hdb->eckey);
+    TCFREE(hdb->gcnd);
+    TCFREE(hdb->gmtx);
     TCFREE(hdb->wmtx);
     TCFREE(hdb->dmtx);
     TCFREE(hdb->rmtxs);
     TCFREE(hdb->mmtx);
     hdb->eckey = NULL;
+    hdb->gcnd = NULL;
+    hdb->gmtx = NULL;
     hdb->wmtx = NULL;
     hdb->dmtx = NULL;
     hdb->rmtxs = NULL;
+    hdb->rmtxnum = 0;
     hdb->mmtx = NULL;
     return false;
   }
@@ -317,7 +771,16 @@ bool tchdbsetcache(TCHDB *hdb, int32_t rcnum){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
     return false;
   }
-  hdb->rcnum = (rcnum > 0) ? tclmin(tclmax(rcnum, HDBCACHEOUT * 2), INT_MAX / 4) : 0;
+  hdb->rcnum = (rcnum > 0) ? tclmin(tclmax(rcnum, HDBRCSHARDMIN * 2), INT_MAX / 4) : 0;
+  return true;
+}
+
+
+/* Set the caching parameters of a hash database object with the size limit. */
+bool tchdbsetcache2(TCHDB *hdb, int32_t rcnum, int64_t rcsiz){
+  assert(hdb);
+  if(!tchdbsetcache(hdb, rcnum)) return false;
+  hdb->rcsiz = (rcsiz > 0) ? tclmax(rcsiz, HDBRCSHARDMIN * HDBRCRECUNIT * 2) : 0;
   return true;
 }
 
@@ -334,6 +797,18 @@ bool tchdbsetxmsiz(TCHDB *hdb, int64_t xmsiz){
 }
 
 
+/* Set the options of the mapped region of a hash database object. */
+bool tchdbsetmapopts(TCHDB *hdb, int mopts){
+  assert(hdb);
+  if(hdb->fd >= 0){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  hdb->mopts = mopts;
+  return true;
+}
+
+
 /* Set the unit step number of auto defragmentation of a hash database object. */
 bool tchdbsetdfunit(TCHDB *hdb, int32_t dfunit){
   assert(hdb);
@@ -346,6 +821,115 @@ bool tchdbsetdfunit(TCHDB *hdb, int32_t dfunit){
 }
 
 
+/* Set the initial number of active buckets of linear hashing of a hash database object. */
+bool tchdbsetlinear(TCHDB *hdb, int64_t lhnum){
+  assert(hdb);
+  if(hdb->fd >= 0){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  hdb->lhbase = (lhnum > 0) ? tcgetprime(lhnum) : 0;
+  return true;
+}
+
+
+/* Set the false positive rate of the key fingerprints of a hash database object. */
+bool tchdbsetfprate(TCHDB *hdb, double rate){
+  assert(hdb);
+  if(hdb->fd >= 0){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  hdb->fwpow = 0;
+  hdb->fknum = 0;
+  if(rate <= 0) return true;
+  for(int wpow = 0; wpow <= HDBFWPOWMAX; wpow++){
+    double load = (double)HDBFPLOAD / (1 << wpow);
+    double best = 1.0;
+    int bknum = 1;
+    for(int knum = 1; knum <= HDBFPBITMAX; knum++){
+      double fpr = pow(1.0 - exp(-knum * load / 32), knum);
+      if(fpr < best){
+        best = fpr;
+        bknum = knum;
+      }
+    }
+    hdb->fwpow = wpow;
+    hdb->fknum = bknum;
+    if(best <= rate) break;
+  }
+  return true;
+}
+
+
+/* Set the waiting time of group commit of a hash database object. */
+bool tchdbsetgcwait(TCHDB *hdb, double wsec){
+  assert(hdb);
+  if(hdb->fd >= 0){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  hdb->gcwait = (wsec > 0) ? wsec : 0;
+  return true;
+}
+
+
+/* Set the checkpoint size of the redo log of a hash database object. */
+bool tchdbsetckptsiz(TCHDB *hdb, int64_t ckptsiz){
+  assert(hdb);
+  if(hdb->fd >= 0){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  hdb->rllim = (ckptsiz > 0) ? ckptsiz : HDBDEFCKPTSIZ;
+  return true;
+}
+
+
+/* Set the budget of background defragmentation of a hash database object. */
+bool tchdbsetbgdefrag(TCHDB *hdb, int64_t bps){
+  assert(hdb);
+  if(hdb->fd >= 0){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  hdb->dfbps = (bps > 0) ? bps : 0;
+  return true;
+}
+
+
+/* Set the asynchronous writer of a hash database object. */
+bool tchdbsetasyncwriter(TCHDB *hdb, int32_t qnum){
+  assert(hdb);
+  if(hdb->fd >= 0){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  hdb->awqnum = (qnum > 0) ? tclmin(qnum, HDBAWQMAX) : 0;
+  return true;
+}
+
+
+/* Set the threshold of the value log of a hash database object. */
+bool tchdbsetvlog(TCHDB *hdb, int32_t thres){
+  assert(hdb);
+  if(hdb->fd >= 0){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  hdb->vlthres = (thres > 0) ? thres : 0;
+  return true;
+}
+
+
+/* Set the number of threads of optimization of a hash database object. */
+bool tchdbsetoptthreads(TCHDB *hdb, int32_t tnum){
+  assert(hdb);
+  hdb->optthnum = tclmin(tclmax(tnum, 0), HDBOPTTHMAX);
+  return true;
+}
+
+
 /* Open a database file and connect a hash database object. */
 bool tchdbopen(TCHDB *hdb, const char *path, int omode){
   assert(hdb && path);
@@ -376,6 +960,16 @@ bool tchdbopen(TCHDB *hdb, const char *path, int omode){
   bool rv = tchdbopenimpl(hdb, path, omode);
   if(rv){
     hdb->rpath = rpath;
+    if((hdb->mmtx && hdb->dfbps > 0 && hdb->dfunit > 0 && (hdb->omode & HDBOWRITER) &&
+        !tchdbbgdefragstart(hdb)) ||
+       (hdb->mmtx && hdb->awqnum > 0 && (hdb->omode & HDBOWRITER) && !tchdbawstart(hdb))){
+      if(hdb->dfth) tchdbbgdefragstop(hdb);
+      tchdbcloseimpl(hdb);
+      tcpathunlock(hdb->rpath);
+      TCFREE(hdb->rpath);
+      hdb->rpath = NULL;
+      rv = false;
+    }
   } else {
     tcpathunlock(rpath);
     TCFREE(rpath);
@@ -388,13 +982,16 @@ bool tchdbopen(TCHDB *hdb, const char *path, int omode){
 /* Close a database object. */
 bool tchdbclose(TCHDB *hdb){
   assert(hdb);
+  bool err = false;
+  if(hdb->awth && !tchdbawstop(hdb)) err = true;
+  if(hdb->dfth && !tchdbbgdefragstop(hdb)) err = true;
   if(!HDBLOCKMETHOD(hdb, true)) return false;
   if(hdb->fd < 0){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
     HDBUNLOCKMETHOD(hdb);
     return false;
   }
-  bool rv = tchdbcloseimpl(hdb);
+  bool rv = tchdbcloseimpl(hdb) && !err;
   tcpathunlock(hdb->rpath);
   TCFREE(hdb->rpath);
   hdb->rpath = NULL;
@@ -406,6 +1003,8 @@ bool tchdbclose(TCHDB *hdb){
 /* Store a record into a hash database object. */
 bool tchdbput(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz){
   assert(hdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  uint64_t stime = tcstatsclock();
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
   if(!HDBLOCKMETHOD(hdb, false)) return false;
   uint8_t hash;
   uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
@@ -430,6 +1029,8 @@ bool tchdbput(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz
       zbuf = _tc_bzcompress(vbuf, vsiz, &vsiz);
     } else if(hdb->opts & HDBTTCBS){
       zbuf = tcbsencode(vbuf, vsiz, &vsiz);
+    } else if(hdb->opts & HDBTLZ){
+      zbuf = tclzencode(vbuf, vsiz, &vsiz);
     } else {
       zbuf = hdb->enc(vbuf, vsiz, &vsiz, hdb->encop);
     }
@@ -439,19 +1040,23 @@ bool tchdbput(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz
       HDBUNLOCKMETHOD(hdb);
       return false;
     }
-    bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, zbuf, vsiz, HDBPDOVER);
+    bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, zbuf, vsiz, HDBPDOVER, 0);
     TCFREE(zbuf);
     HDBUNLOCKRECORD(hdb, bidx);
     HDBUNLOCKMETHOD(hdb);
     if(hdb->dfunit > 0 && hdb->dfcnt > hdb->dfunit &&
-       !tchdbdefrag(hdb, hdb->dfunit * HDBDFRSRAT + 1)) rv = false;
+       !tchdbautodefrag(hdb)) rv = false;
+    if(HDBLHSPLITNEEDED(hdb) && !tchdblhgrow(hdb)) rv = false;
+    tcstatsop(hdb->stats, TCSOPUT, stime);
     return rv;
   }
-  bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, vbuf, vsiz, HDBPDOVER);
+  bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, vbuf, vsiz, HDBPDOVER, 0);
   HDBUNLOCKRECORD(hdb, bidx);
   HDBUNLOCKMETHOD(hdb);
   if(hdb->dfunit > 0 && hdb->dfcnt > hdb->dfunit &&
-     !tchdbdefrag(hdb, hdb->dfunit * HDBDFRSRAT + 1)) rv = false;
+     !tchdbautodefrag(hdb)) rv = false;
+  if(HDBLHSPLITNEEDED(hdb) && !tchdblhgrow(hdb)) rv = false;
+  tcstatsop(hdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -463,9 +1068,73 @@ bool tchdbput2(TCHDB *hdb, const char *kstr, const char *vstr){
 }
 
 
+/* Store a record with an expiration time into a hash database object. */
+bool tchdbputxt(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz, int64_t xt){
+  assert(hdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  uint64_t stime = tcstatsclock();
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
+  if(!HDBLOCKMETHOD(hdb, false)) return false;
+  uint8_t hash;
+  uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
+  if(hdb->fd < 0 || !(hdb->omode & HDBOWRITER)){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  if(hdb->async && !tchdbflushdrp(hdb)){
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  if(!HDBLOCKRECORD(hdb, bidx, true)){
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  uint32_t xtime = tchdbxtime(xt);
+  if(hdb->zmode){
+    char *zbuf;
+    if(hdb->opts & HDBTDEFLATE){
+      zbuf = _tc_deflate(vbuf, vsiz, &vsiz, _TCZMRAW);
+    } else if(hdb->opts & HDBTBZIP){
+      zbuf = _tc_bzcompress(vbuf, vsiz, &vsiz);
+    } else if(hdb->opts & HDBTTCBS){
+      zbuf = tcbsencode(vbuf, vsiz, &vsiz);
+    } else if(hdb->opts & HDBTLZ){
+      zbuf = tclzencode(vbuf, vsiz, &vsiz);
+    } else {
+      zbuf = hdb->enc(vbuf, vsiz, &vsiz, hdb->encop);
+    }
+    if(!zbuf){
+      tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+      HDBUNLOCKRECORD(hdb, bidx);
+      HDBUNLOCKMETHOD(hdb);
+      return false;
+    }
+    bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, zbuf, vsiz, HDBPDOVER, xtime);
+    TCFREE(zbuf);
+    HDBUNLOCKRECORD(hdb, bidx);
+    HDBUNLOCKMETHOD(hdb);
+    if(hdb->dfunit > 0 && hdb->dfcnt > hdb->dfunit &&
+       !tchdbautodefrag(hdb)) rv = false;
+    if(HDBLHSPLITNEEDED(hdb) && !tchdblhgrow(hdb)) rv = false;
+    tcstatsop(hdb->stats, TCSOPUT, stime);
+    return rv;
+  }
+  bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, vbuf, vsiz, HDBPDOVER, xtime);
+  HDBUNLOCKRECORD(hdb, bidx);
+  HDBUNLOCKMETHOD(hdb);
+  if(hdb->dfunit > 0 && hdb->dfcnt > hdb->dfunit &&
+     !tchdbautodefrag(hdb)) rv = false;
+  if(HDBLHSPLITNEEDED(hdb) && !tchdblhgrow(hdb)) rv = false;
+  tcstatsop(hdb->stats, TCSOPUT, stime);
+  return rv;
+}
+
+
 /* Store a new record into a hash database object. */
 bool tchdbputkeep(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz){
   assert(hdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  uint64_t stime = tcstatsclock();
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
   if(!HDBLOCKMETHOD(hdb, false)) return false;
   uint8_t hash;
   uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
@@ -490,6 +1159,8 @@ bool tchdbputkeep(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int
       zbuf = _tc_bzcompress(vbuf, vsiz, &vsiz);
     } else if(hdb->opts & HDBTTCBS){
       zbuf = tcbsencode(vbuf, vsiz, &vsiz);
+    } else if(hdb->opts & HDBTLZ){
+      zbuf = tclzencode(vbuf, vsiz, &vsiz);
     } else {
       zbuf = hdb->enc(vbuf, vsiz, &vsiz, hdb->encop);
     }
@@ -499,19 +1170,23 @@ bool tchdbputkeep(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int
       HDBUNLOCKMETHOD(hdb);
       return false;
     }
-    bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, zbuf, vsiz, HDBPDKEEP);
+    bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, zbuf, vsiz, HDBPDKEEP, 0);
     TCFREE(zbuf);
     HDBUNLOCKRECORD(hdb, bidx);
     HDBUNLOCKMETHOD(hdb);
     if(hdb->dfunit > 0 && hdb->dfcnt > hdb->dfunit &&
-       !tchdbdefrag(hdb, hdb->dfunit * HDBDFRSRAT + 1)) rv = false;
+       !tchdbautodefrag(hdb)) rv = false;
+    if(HDBLHSPLITNEEDED(hdb) && !tchdblhgrow(hdb)) rv = false;
+    tcstatsop(hdb->stats, TCSOPUT, stime);
     return rv;
   }
-  bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, vbuf, vsiz, HDBPDKEEP);
+  bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, vbuf, vsiz, HDBPDKEEP, 0);
   HDBUNLOCKRECORD(hdb, bidx);
   HDBUNLOCKMETHOD(hdb);
   if(hdb->dfunit > 0 && hdb->dfcnt > hdb->dfunit &&
-     !tchdbdefrag(hdb, hdb->dfunit * HDBDFRSRAT + 1)) rv = false;
+     !tchdbautodefrag(hdb)) rv = false;
+  if(HDBLHSPLITNEEDED(hdb) && !tchdblhgrow(hdb)) rv = false;
+  tcstatsop(hdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -525,6 +1200,8 @@ bool tchdbputkeep2(TCHDB *hdb, const char *kstr, const char *vstr){
 /* Concatenate a value at the end of the existing record in a hash database object. */
 bool tchdbputcat(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz){
   assert(hdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  uint64_t stime = tcstatsclock();
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
   if(!HDBLOCKMETHOD(hdb, false)) return false;
   uint8_t hash;
   uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
@@ -544,7 +1221,7 @@ bool tchdbputcat(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int v
   if(hdb->zmode){
     char *zbuf;
     int osiz;
-    char *obuf = tchdbgetimpl(hdb, kbuf, ksiz, bidx, hash, &osiz);
+    char *obuf = tchdbgetimpl(hdb, kbuf, ksiz, bidx, hash, NULL, 0, &osiz);
     if(obuf){
       TCREALLOC(obuf, obuf, osiz + vsiz + 1);
       memcpy(obuf + osiz, vbuf, vsiz);
@@ -554,6 +1231,8 @@ bool tchdbputcat(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int v
         zbuf = _tc_bzcompress(obuf, osiz + vsiz, &vsiz);
       } else if(hdb->opts & HDBTTCBS){
         zbuf = tcbsencode(obuf, osiz + vsiz, &vsiz);
+      } else if(hdb->opts & HDBTLZ){
+        zbuf = tclzencode(obuf, osiz + vsiz, &vsiz);
       } else {
         zbuf = hdb->enc(obuf, osiz + vsiz, &vsiz, hdb->encop);
       }
@@ -565,6 +1244,8 @@ bool tchdbputcat(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int v
         zbuf = _tc_bzcompress(vbuf, vsiz, &vsiz);
       } else if(hdb->opts & HDBTTCBS){
         zbuf = tcbsencode(vbuf, vsiz, &vsiz);
+      } else if(hdb->opts & HDBTLZ){
+        zbuf = tclzencode(vbuf, vsiz, &vsiz);
       } else {
         zbuf = hdb->enc(vbuf, vsiz, &vsiz, hdb->encop);
       }
@@ -575,19 +1256,23 @@ bool tchdbputcat(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int v
       HDBUNLOCKMETHOD(hdb);
       return false;
     }
-    bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, zbuf, vsiz, HDBPDOVER);
+    bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, zbuf, vsiz, HDBPDOVER, HDBXTINHERIT);
     TCFREE(zbuf);
     HDBUNLOCKRECORD(hdb, bidx);
     HDBUNLOCKMETHOD(hdb);
     if(hdb->dfunit > 0 && hdb->dfcnt > hdb->dfunit &&
-       !tchdbdefrag(hdb, hdb->dfunit * HDBDFRSRAT + 1)) rv = false;
+       !tchdbautodefrag(hdb)) rv = false;
+    if(HDBLHSPLITNEEDED(hdb) && !tchdblhgrow(hdb)) rv = false;
+    tcstatsop(hdb->stats, TCSOPUT, stime);
     return rv;
   }
-  bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, vbuf, vsiz, HDBPDCAT);
+  bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, vbuf, vsiz, HDBPDCAT, HDBXTINHERIT);
   HDBUNLOCKRECORD(hdb, bidx);
   HDBUNLOCKMETHOD(hdb);
   if(hdb->dfunit > 0 && hdb->dfcnt > hdb->dfunit &&
-     !tchdbdefrag(hdb, hdb->dfunit * HDBDFRSRAT + 1)) rv = false;
+     !tchdbautodefrag(hdb)) rv = false;
+  if(HDBLHSPLITNEEDED(hdb) && !tchdblhgrow(hdb)) rv = false;
+  tcstatsop(hdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -602,6 +1287,12 @@ bool tchdbputcat2(TCHDB *hdb, const char *kstr, const char *vstr){
 /* Store a record into a hash database object in asynchronous fashion. */
 bool tchdbputasync(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz){
   assert(hdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  uint64_t stime = tcstatsclock();
+  if(hdb->awth){
+    bool rv = tchdbawpush(hdb, kbuf, ksiz, vbuf, vsiz);
+    tcstatsop(hdb->stats, TCSOPUT, stime);
+    return rv;
+  }
   if(!HDBLOCKMETHOD(hdb, true)) return false;
   uint8_t hash;
   uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
@@ -619,6 +1310,8 @@ bool tchdbputasync(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int
       zbuf = _tc_bzcompress(vbuf, vsiz, &vsiz);
     } else if(hdb->opts & HDBTTCBS){
       zbuf = tcbsencode(vbuf, vsiz, &vsiz);
+    } else if(hdb->opts & HDBTLZ){
+      zbuf = tclzencode(vbuf, vsiz, &vsiz);
     } else {
       zbuf = hdb->enc(vbuf, vsiz, &vsiz, hdb->encop);
     }
@@ -630,10 +1323,14 @@ bool tchdbputasync(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int
     bool rv = tchdbputasyncimpl(hdb, kbuf, ksiz, bidx, hash, zbuf, vsiz);
     TCFREE(zbuf);
     HDBUNLOCKMETHOD(hdb);
+    if(HDBLHSPLITNEEDED(hdb) && !tchdblhgrow(hdb)) rv = false;
+    tcstatsop(hdb->stats, TCSOPUT, stime);
     return rv;
   }
   bool rv = tchdbputasyncimpl(hdb, kbuf, ksiz, bidx, hash, vbuf, vsiz);
   HDBUNLOCKMETHOD(hdb);
+  if(HDBLHSPLITNEEDED(hdb) && !tchdblhgrow(hdb)) rv = false;
+  tcstatsop(hdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -645,9 +1342,27 @@ bool tchdbputasync2(TCHDB *hdb, const char *kstr, const char *vstr){
 }
 
 
+/* Wait for records stored in asynchronous fashion to be written into a hash database object. */
+bool tchdbasyncflush(TCHDB *hdb){
+  assert(hdb);
+  if(hdb->awth) return tchdbawbarrier(hdb);
+  if(!HDBLOCKMETHOD(hdb, true)) return false;
+  if(hdb->fd < 0 || !(hdb->omode & HDBOWRITER)){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  bool rv = !hdb->async || tchdbflushdrp(hdb);
+  HDBUNLOCKMETHOD(hdb);
+  return rv;
+}
+
+
 /* Remove a record of a hash database object. */
 bool tchdbout(TCHDB *hdb, const void *kbuf, int ksiz){
   assert(hdb && kbuf && ksiz >= 0);
+  uint64_t stime = tcstatsclock();
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
   if(!HDBLOCKMETHOD(hdb, false)) return false;
   uint8_t hash;
   uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
@@ -668,7 +1383,8 @@ bool tchdbout(TCHDB *hdb, const void *kbuf, int ksiz){
   HDBUNLOCKRECORD(hdb, bidx);
   HDBUNLOCKMETHOD(hdb);
   if(hdb->dfunit > 0 && hdb->dfcnt > hdb->dfunit &&
-     !tchdbdefrag(hdb, hdb->dfunit * HDBDFRSRAT + 1)) rv = false;
+     !tchdbautodefrag(hdb)) rv = false;
+  tcstatsop(hdb->stats, TCSOOUT, stime);
   return rv;
 }
 
@@ -683,6 +1399,8 @@ bool tchdbout2(TCHDB *hdb, const char *kstr){
 /* Retrieve a record in a hash database object. */
 void *tchdbget(TCHDB *hdb, const void *kbuf, int ksiz, int *sp){
   assert(hdb && kbuf && ksiz >= 0 && sp);
+  uint64_t stime = tcstatsclock();
+  if(hdb->awth && !tchdbawbarrier(hdb)) return NULL;
   if(!HDBLOCKMETHOD(hdb, false)) return NULL;
   uint8_t hash;
   uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
@@ -691,99 +1409,405 @@ void *tchdbget(TCHDB *hdb, const void *kbuf, int ksiz, int *sp){
     HDBUNLOCKMETHOD(hdb);
     return NULL;
   }
+  char *rv;
+  if(tchdbsnapactive(hdb)){
+    rv = tchdbsnapgetimpl(hdb, kbuf, ksiz, sp, NULL);
+    HDBUNLOCKMETHOD(hdb);
+    if(!rv) tcstatsadd(hdb->stats, TCSCMISS, 1);
+    tcstatsop(hdb->stats, TCSOGET, stime);
+    return rv;
+  }
   if(hdb->async && !tchdbflushdrp(hdb)){
     HDBUNLOCKMETHOD(hdb);
     return NULL;
   }
+  if(hdb->mmtx && !hdb->async && tchdbgetseq(hdb, kbuf, ksiz, bidx, hash, &rv, sp)){
+    HDBUNLOCKMETHOD(hdb);
+    if(!rv) tcstatsadd(hdb->stats, TCSCMISS, 1);
+    tcstatsop(hdb->stats, TCSOGET, stime);
+    return rv;
+  }
   if(!HDBLOCKRECORD(hdb, bidx, false)){
     HDBUNLOCKMETHOD(hdb);
     return false;
   }
-  char *rv = tchdbgetimpl(hdb, kbuf, ksiz, bidx, hash, sp);
+  rv = tchdbgetimpl(hdb, kbuf, ksiz, bidx, hash, NULL, 0, sp);
   HDBUNLOCKRECORD(hdb, bidx);
   HDBUNLOCKMETHOD(hdb);
+  if(!rv) tcstatsadd(hdb->stats, TCSCMISS, 1);
+  tcstatsop(hdb->stats, TCSOGET, stime);
   return rv;
 }
 
 
-/* Retrieve a string record in a hash database object. */
-char *tchdbget2(TCHDB *hdb, const char *kstr){
-  assert(hdb && kstr);
-  int vsiz;
-  return tchdbget(hdb, kstr, strlen(kstr), &vsiz);
-}
-
-
-/* Retrieve a record in a hash database object and write the value into a buffer. */
-int tchdbget3(TCHDB *hdb, const void *kbuf, int ksiz, void *vbuf, int max){
-  assert(hdb && kbuf && ksiz >= 0 && vbuf && max >= 0);
-  if(!HDBLOCKMETHOD(hdb, false)) return -1;
-  uint8_t hash;
-  uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
+/* Retrieve records of multiple keys in a hash database object. */
+TCLIST *tchdbgetmulti(TCHDB *hdb, const TCLIST *keys){
+  assert(hdb && keys);
+  uint64_t stime = tcstatsclock();
+  if(hdb->awth && !tchdbawbarrier(hdb)) return NULL;
+  if(!HDBLOCKMETHOD(hdb, false)) return NULL;
   if(hdb->fd < 0){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
     HDBUNLOCKMETHOD(hdb);
-    return -1;
+    return NULL;
   }
   if(hdb->async && !tchdbflushdrp(hdb)){
     HDBUNLOCKMETHOD(hdb);
-    return -1;
+    return NULL;
   }
-  if(!HDBLOCKRECORD(hdb, bidx, false)){
-    HDBUNLOCKMETHOD(hdb);
-    return -1;
+  int knum = TCLISTNUM(keys);
+  HDBPROBE *probes;
+  TCMALLOC(probes, sizeof(*probes) * knum + 1);
+  HDBPROBE **ords;
+  TCMALLOC(ords, sizeof(*ords) * knum + 1);
+  char **vbufs;
+  TCMALLOC(vbufs, sizeof(*vbufs) * knum + 1);
+  int *vsizs;
+  TCMALLOC(vsizs, sizeof(*vsizs) * knum + 1);
+  for(int i = 0; i < knum; i++){
+    const char *kbuf;
+    int ksiz;
+    TCLISTVAL(kbuf, keys, i, ksiz);
+    HDBPROBE *probe = probes + i;
+    probe->idx = i;
+    probe->bidx = tchdbbidx(hdb, kbuf, ksiz, &probe->hash);
+    probe->lidx = hdb->mmtx ? probe->bidx & (hdb->rmtxnum - 1) : 0;
+    vbufs[i] = NULL;
+    vsizs[i] = 0;
+  }
+  qsort(probes, knum, sizeof(*probes), tchdbprobecmp);
+  uint64_t raoffs[HDBURINGDEPTH];
+  int rasizs[HDBURINGDEPTH];
+  HDBPROBE *raprobes[HDBURINGDEPTH];
+  char *rabuf = NULL;
+  bool err = false;
+  int i = 0;
+  while(i < knum && !err){
+    int end = i;
+    int bnum = 0;
+    while(end < knum){
+      if(end == i || probes[end].bidx != probes[end-1].bidx){
+        if(bnum >= HDBURINGDEPTH) break;
+        bnum++;
+      }
+      end++;
+    }
+    int lend = i;
+    while(lend < end){
+      if((lend == i || probes[lend].lidx != probes[lend-1].lidx) &&
+         !HDBLOCKRECORD(hdb, probes[lend].bidx, false)){
+        err = true;
+        break;
+      }
+      lend++;
+    }
+    if(!err){
+      int ranum = 0;
+      for(int j = i; j < end; j++){
+        HDBPROBE *probe = probes + j;
+        ords[j-i] = probe;
+        if(j > i && probe->bidx == probes[j-1].bidx){
+          probe->off = probes[j-1].off;
+          continue;
+        }
+        probe->off = tchdbgetbucket(hdb, probe->bidx);
+        probe->bufidx = -1;
+        if(probe->off < hdb->xmsiz) continue;
+        for(int k = j; k < end && probes[k].bidx == probe->bidx; k++){
+          const char *kbuf;
+          int ksiz;
+          TCLISTVAL(kbuf, keys, probes[k].idx, ksiz);
+          if(!tchdbfpmiss(hdb, probe->bidx, kbuf, ksiz)){
+            raprobes[ranum++] = probe;
+            break;
+          }
+        }
+      }
+      qsort(ords, end - i, sizeof(*ords), tchdbprobeoffcmp);
+      if(ranum > 0){
+        qsort(raprobes, ranum, sizeof(*raprobes), tchdbprobeoffcmp);
+        for(int j = 0; j < ranum; j++){
+          raprobes[j]->bufidx = j;
+          raoffs[j] = raprobes[j]->off;
+        }
+        if(!rabuf) TCMALLOC(rabuf, HDBURINGDEPTH * hdb->runit);
+        tchdbreadblocks(hdb, raoffs, ranum, rabuf, rasizs);
+      }
+      for(int j = i + 1; j < end; j++){
+        if(probes[j].bidx == probes[j-1].bidx) probes[j].bufidx = probes[j-1].bufidx;
+      }
+      for(int j = 0; j < end - i; j++){
+        HDBPROBE *probe = ords[j];
+        const char *kbuf;
+        int ksiz;
+        TCLISTVAL(kbuf, keys, probe->idx, ksiz);
+        char *hbuf = NULL;
+        int hsiz = 0;
+        if(probe->bufidx >= 0){
+          hbuf = rabuf + probe->bufidx * hdb->runit;
+          hsiz = rasizs[probe->bufidx];
+        }
+        vbufs[probe->idx] = tchdbgetimpl(hdb, kbuf, ksiz, probe->bidx, probe->hash, hbuf, hsiz,
+                                         vsizs + probe->idx);
+        if(!vbufs[probe->idx] && tchdbecode(hdb) != TCENOREC){
+          err = true;
+          break;
+        }
+      }
+    }
+    while(--lend >= i){
+      if(lend == i || probes[lend].lidx != probes[lend-1].lidx){
+        HDBUNLOCKRECORD(hdb, probes[lend].bidx);
+      }
+    }
+    i = end;
   }
-  int rv = tchdbgetintobuf(hdb, kbuf, ksiz, bidx, hash, vbuf, max);
-  HDBUNLOCKRECORD(hdb, bidx);
+  TCFREE(rabuf);
   HDBUNLOCKMETHOD(hdb);
+  TCLIST *rv = err ? NULL : tclistnew2(knum * 2 + 1);
+  if(rv){
+    int mnum = 0;
+    for(int i = 0; i < knum; i++){
+      if(!vbufs[i]) mnum++;
+      tcstatsop(hdb->stats, TCSOGET, stime);
+    }
+    if(mnum > 0) tcstatsadd(hdb->stats, TCSCMISS, mnum);
+  }
+  for(int i = 0; i < knum; i++){
+    if(!vbufs[i]) continue;
+    if(rv){
+      const char *kbuf;
+      int ksiz;
+      TCLISTVAL(kbuf, keys, i, ksiz);
+      TCLISTPUSH(rv, kbuf, ksiz);
+      tclistpushmalloc(rv, vbufs[i], vsizs[i]);
+    } else {
+      TCFREE(vbufs[i]);
+    }
+  }
+  TCFREE(vsizs);
+  TCFREE(vbufs);
+  TCFREE(ords);
+  TCFREE(probes);
   return rv;
 }
 
 
-/* Get the size of the value of a record in a hash database object. */
-int tchdbvsiz(TCHDB *hdb, const void *kbuf, int ksiz){
-  assert(hdb && kbuf && ksiz >= 0);
-  if(!HDBLOCKMETHOD(hdb, false)) return -1;
+/* Retrieve a record in a hash database object and pin the value in the mapped region. */
+const void *tchdbgetpin(TCHDB *hdb, const void *kbuf, int ksiz, int *sp, uint64_t *pinp){
+  assert(hdb && kbuf && ksiz >= 0 && sp && pinp);
+  uint64_t stime = tcstatsclock();
+  if(hdb->awth && !tchdbawbarrier(hdb)) return NULL;
+  if(!HDBLOCKMETHOD(hdb, false)) return NULL;
   uint8_t hash;
   uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
-  if(hdb->fd < 0){
+  if(hdb->fd < 0 || hdb->tran || tchdbsnapactive(hdb)){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
     HDBUNLOCKMETHOD(hdb);
-    return -1;
+    return NULL;
   }
   if(hdb->async && !tchdbflushdrp(hdb)){
     HDBUNLOCKMETHOD(hdb);
-    return -1;
+    return NULL;
   }
   if(!HDBLOCKRECORD(hdb, bidx, false)){
     HDBUNLOCKMETHOD(hdb);
-    return -1;
+    return NULL;
+  }
+  uint64_t off;
+  const char *rv = tchdbgetpinimpl(hdb, kbuf, ksiz, bidx, hash, sp, &off);
+  if(rv){
+    if(HDBLOCKDB(hdb)){
+      if(!hdb->pins){
+        hdb->pins = tcmapnew();
+        hdb->pinrecs = tcmapnew();
+      }
+      uint64_t pin = ++hdb->pinid;
+      tcmapput(hdb->pins, &pin, sizeof(pin), &off, sizeof(off));
+      tcmapaddint(hdb->pinrecs, &off, sizeof(off), 1);
+      hdb->pinnum++;
+      HDBUNLOCKDB(hdb);
+      *pinp = pin;
+    } else {
+      rv = NULL;
+    }
   }
-  int rv = tchdbvsizimpl(hdb, kbuf, ksiz, bidx, hash);
   HDBUNLOCKRECORD(hdb, bidx);
   HDBUNLOCKMETHOD(hdb);
+  if(!rv) tcstatsadd(hdb->stats, TCSCMISS, 1);
+  tcstatsop(hdb->stats, TCSOGET, stime);
   return rv;
 }
 
 
-/* Get the size of the value of a string record in a hash database object. */
-int tchdbvsiz2(TCHDB *hdb, const char *kstr){
-  assert(hdb && kstr);
-  return tchdbvsiz(hdb, kstr, strlen(kstr));
-}
-
-
-/* Initialize the iterator of a hash database object. */
-bool tchdbiterinit(TCHDB *hdb){
+/* Release a value pinned by `tchdbgetpin' in a hash database object. */
+bool tchdbunpin(TCHDB *hdb, uint64_t pin){
   assert(hdb);
-  if(!HDBLOCKMETHOD(hdb, true)) return false;
-  if(hdb->fd < 0){
-    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+  if(!HDBLOCKMETHOD(hdb, false)) return false;
+  if(hdb->fd < 0 || !HDBLOCKDB(hdb)){
+    if(hdb->fd < 0) tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
     HDBUNLOCKMETHOD(hdb);
     return false;
   }
-  if(hdb->async && !tchdbflushdrp(hdb)){
-    HDBUNLOCKMETHOD(hdb);
+  int vsiz;
+  const char *vbuf = hdb->pins ? tcmapget(hdb->pins, &pin, sizeof(pin), &vsiz) : NULL;
+  if(!vbuf){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    HDBUNLOCKDB(hdb);
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  uint64_t off;
+  memcpy(&off, vbuf, sizeof(off));
+  tcmapout(hdb->pins, &pin, sizeof(pin));
+  if(tcmapaddint(hdb->pinrecs, &off, sizeof(off), -1) < 1)
+    tcmapout(hdb->pinrecs, &off, sizeof(off));
+  hdb->pinnum--;
+  HDBUNLOCKDB(hdb);
+  HDBUNLOCKMETHOD(hdb);
+  return true;
+}
+
+
+/* Retrieve a string record in a hash database object. */
+char *tchdbget2(TCHDB *hdb, const char *kstr){
+  assert(hdb && kstr);
+  int vsiz;
+  return tchdbget(hdb, kstr, strlen(kstr), &vsiz);
+}
+
+
+/* Retrieve a record in a hash database object and write the value into a buffer. */
+int tchdbget3(TCHDB *hdb, const void *kbuf, int ksiz, void *vbuf, int max){
+  assert(hdb && kbuf && ksiz >= 0 && vbuf && max >= 0);
+  uint64_t stime = tcstatsclock();
+  if(hdb->awth && !tchdbawbarrier(hdb)) return -1;
+  if(!HDBLOCKMETHOD(hdb, false)) return -1;
+  uint8_t hash;
+  uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
+  if(hdb->fd < 0){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    HDBUNLOCKMETHOD(hdb);
+    return -1;
+  }
+  if(tchdbsnapactive(hdb)){
+    int vsiz;
+    char *rbuf = tchdbsnapgetimpl(hdb, kbuf, ksiz, &vsiz, NULL);
+    HDBUNLOCKMETHOD(hdb);
+    if(!rbuf) return -1;
+    if(vsiz > max) vsiz = max;
+    memcpy(vbuf, rbuf, vsiz);
+    TCFREE(rbuf);
+    tcstatsop(hdb->stats, TCSOGET, stime);
+    return vsiz;
+  }
+  if(hdb->async && !tchdbflushdrp(hdb)){
+    HDBUNLOCKMETHOD(hdb);
+    return -1;
+  }
+  if(!HDBLOCKRECORD(hdb, bidx, false)){
+    HDBUNLOCKMETHOD(hdb);
+    return -1;
+  }
+  int rv = tchdbgetintobuf(hdb, kbuf, ksiz, bidx, hash, vbuf, max);
+  HDBUNLOCKRECORD(hdb, bidx);
+  HDBUNLOCKMETHOD(hdb);
+  if(rv < 0) tcstatsadd(hdb->stats, TCSCMISS, 1);
+  tcstatsop(hdb->stats, TCSOGET, stime);
+  return rv;
+}
+
+
+/* Get the size of the value of a record in a hash database object. */
+int tchdbvsiz(TCHDB *hdb, const void *kbuf, int ksiz){
+  assert(hdb && kbuf && ksiz >= 0);
+  if(hdb->awth && !tchdbawbarrier(hdb)) return -1;
+  if(!HDBLOCKMETHOD(hdb, false)) return -1;
+  uint8_t hash;
+  uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
+  if(hdb->fd < 0){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    HDBUNLOCKMETHOD(hdb);
+    return -1;
+  }
+  if(tchdbsnapactive(hdb)){
+    int vsiz;
+    char *rbuf = tchdbsnapgetimpl(hdb, kbuf, ksiz, &vsiz, NULL);
+    HDBUNLOCKMETHOD(hdb);
+    if(!rbuf) return -1;
+    TCFREE(rbuf);
+    return vsiz;
+  }
+  if(hdb->async && !tchdbflushdrp(hdb)){
+    HDBUNLOCKMETHOD(hdb);
+    return -1;
+  }
+  if(!HDBLOCKRECORD(hdb, bidx, false)){
+    HDBUNLOCKMETHOD(hdb);
+    return -1;
+  }
+  int rv = tchdbvsizimpl(hdb, kbuf, ksiz, bidx, hash);
+  HDBUNLOCKRECORD(hdb, bidx);
+  HDBUNLOCKMETHOD(hdb);
+  return rv;
+}
+
+
+/* Get the size of the value of a string record in a hash database object. */
+int tchdbvsiz2(TCHDB *hdb, const char *kstr){
+  assert(hdb && kstr);
+  return tchdbvsiz(hdb, kstr, strlen(kstr));
+}
+
+
+/* Get the expiration time of a record in a hash database object. */
+int64_t tchdbgetxt(TCHDB *hdb, const void *kbuf, int ksiz){
+  assert(hdb && kbuf && ksiz >= 0);
+  if(hdb->awth && !tchdbawbarrier(hdb)) return -1;
+  if(!HDBLOCKMETHOD(hdb, false)) return -1;
+  uint8_t hash;
+  uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
+  if(hdb->fd < 0){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    HDBUNLOCKMETHOD(hdb);
+    return -1;
+  }
+  if(tchdbsnapactive(hdb)){
+    int vsiz;
+    uint32_t xtime;
+    char *rbuf = tchdbsnapgetimpl(hdb, kbuf, ksiz, &vsiz, &xtime);
+    HDBUNLOCKMETHOD(hdb);
+    if(!rbuf) return -1;
+    TCFREE(rbuf);
+    return xtime;
+  }
+  if(hdb->async && !tchdbflushdrp(hdb)){
+    HDBUNLOCKMETHOD(hdb);
+    return -1;
+  }
+  if(!HDBLOCKRECORD(hdb, bidx, false)){
+    HDBUNLOCKMETHOD(hdb);
+    return -1;
+  }
+  int64_t rv = tchdbgetxtimpl(hdb, kbuf, ksiz, bidx, hash);
+  HDBUNLOCKRECORD(hdb, bidx);
+  HDBUNLOCKMETHOD(hdb);
+  return rv;
+}
+
+
+/* Initialize the iterator of a hash database object. */
+bool tchdbiterinit(TCHDB *hdb){
+  assert(hdb);
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
+  if(!HDBLOCKMETHOD(hdb, true)) return false;
+  if(hdb->fd < 0){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  if(hdb->async && !tchdbflushdrp(hdb)){
+    HDBUNLOCKMETHOD(hdb);
     return false;
   }
   bool rv = tchdbiterinitimpl(hdb);
@@ -795,6 +1819,8 @@ bool tchdbiterinit(TCHDB *hdb){
 /* Get the next key of the iterator of a hash database object. */
 void *tchdbiternext(TCHDB *hdb, int *sp){
   assert(hdb && sp);
+  uint64_t stime = tcstatsclock();
+  if(hdb->awth && !tchdbawbarrier(hdb)) return NULL;
   if(!HDBLOCKMETHOD(hdb, true)) return NULL;
   if(hdb->fd < 0 || hdb->iter < 1){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -807,6 +1833,7 @@ void *tchdbiternext(TCHDB *hdb, int *sp){
   }
   char *rv = tchdbiternextimpl(hdb, sp);
   HDBUNLOCKMETHOD(hdb);
+  tcstatsop(hdb->stats, TCSOITER, stime);
   return rv;
 }
 
@@ -822,6 +1849,8 @@ char *tchdbiternext2(TCHDB *hdb){
 /* Get the next extensible objects of the iterator of a hash database object. */
 bool tchdbiternext3(TCHDB *hdb, TCXSTR *kxstr, TCXSTR *vxstr){
   assert(hdb && kxstr && vxstr);
+  uint64_t stime = tcstatsclock();
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
   if(!HDBLOCKMETHOD(hdb, true)) return false;
   if(hdb->fd < 0 || hdb->iter < 1){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -834,6 +1863,7 @@ bool tchdbiternext3(TCHDB *hdb, TCXSTR *kxstr, TCXSTR *vxstr){
   }
   bool rv = tchdbiternextintoxstr(hdb, kxstr, vxstr);
   HDBUNLOCKMETHOD(hdb);
+  tcstatsop(hdb->stats, TCSOITER, stime);
   return rv;
 }
 
@@ -842,6 +1872,7 @@ bool tchdbiternext3(TCHDB *hdb, TCXSTR *kxstr, TCXSTR *vxstr){
 TCLIST *tchdbfwmkeys(TCHDB *hdb, const void *pbuf, int psiz, int max){
   assert(hdb && pbuf && psiz >= 0);
   TCLIST* keys = tclistnew();
+  if(hdb->awth && !tchdbawbarrier(hdb)) return keys;
   if(!HDBLOCKMETHOD(hdb, true)) return keys;
   if(hdb->fd < 0){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -880,6 +1911,8 @@ TCLIST *tchdbfwmkeys2(TCHDB *hdb, const char *pstr, int max){
 /* Add an integer to a record in a hash database object. */
 int tchdbaddint(TCHDB *hdb, const void *kbuf, int ksiz, int num){
   assert(hdb && kbuf && ksiz >= 0);
+  uint64_t stime = tcstatsclock();
+  if(hdb->awth && !tchdbawbarrier(hdb)) return INT_MIN;
   if(!HDBLOCKMETHOD(hdb, false)) return INT_MIN;
   uint8_t hash;
   uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
@@ -899,7 +1932,7 @@ int tchdbaddint(TCHDB *hdb, const void *kbuf, int ksiz, int num){
   if(hdb->zmode){
     char *zbuf;
     int osiz;
-    char *obuf = tchdbgetimpl(hdb, kbuf, ksiz, bidx, hash, &osiz);
+    char *obuf = tchdbgetimpl(hdb, kbuf, ksiz, bidx, hash, NULL, 0, &osiz);
     if(obuf){
       if(osiz != sizeof(num)){
         tchdbsetecode(hdb, TCEKEEP, __FILE__, __LINE__, __func__);
@@ -918,6 +1951,8 @@ int tchdbaddint(TCHDB *hdb, const void *kbuf, int ksiz, int num){
       zbuf = _tc_bzcompress((char *)&num, sizeof(num), &zsiz);
     } else if(hdb->opts & HDBTTCBS){
       zbuf = tcbsencode((char *)&num, sizeof(num), &zsiz);
+    } else if(hdb->opts & HDBTLZ){
+      zbuf = tclzencode((char *)&num, sizeof(num), &zsiz);
     } else {
       zbuf = hdb->enc((char *)&num, sizeof(num), &zsiz, hdb->encop);
     }
@@ -927,19 +1962,24 @@ int tchdbaddint(TCHDB *hdb, const void *kbuf, int ksiz, int num){
       HDBUNLOCKMETHOD(hdb);
       return INT_MIN;
     }
-    bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, zbuf, zsiz, HDBPDOVER);
+    bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, zbuf, zsiz, HDBPDOVER, HDBXTINHERIT);
     TCFREE(zbuf);
     HDBUNLOCKRECORD(hdb, bidx);
     HDBUNLOCKMETHOD(hdb);
     if(hdb->dfunit > 0 && hdb->dfcnt > hdb->dfunit &&
-       !tchdbdefrag(hdb, hdb->dfunit * HDBDFRSRAT + 1)) rv = false;
+       !tchdbautodefrag(hdb)) rv = false;
+    if(HDBLHSPLITNEEDED(hdb) && !tchdblhgrow(hdb)) rv = false;
+    tcstatsop(hdb->stats, TCSOPUT, stime);
     return rv ? num : INT_MIN;
   }
-  bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, (char *)&num, sizeof(num), HDBPDADDINT);
+  bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, (char *)&num, sizeof(num), HDBPDADDINT,
+                         HDBXTINHERIT);
   HDBUNLOCKRECORD(hdb, bidx);
   HDBUNLOCKMETHOD(hdb);
   if(hdb->dfunit > 0 && hdb->dfcnt > hdb->dfunit &&
-     !tchdbdefrag(hdb, hdb->dfunit * HDBDFRSRAT + 1)) rv = false;
+     !tchdbautodefrag(hdb)) rv = false;
+  if(HDBLHSPLITNEEDED(hdb) && !tchdblhgrow(hdb)) rv = false;
+  tcstatsop(hdb->stats, TCSOPUT, stime);
   return rv ? num : INT_MIN;
 }
 
@@ -947,6 +1987,8 @@ int tchdbaddint(TCHDB *hdb, const void *kbuf, int ksiz, int num){
 /* Add a real number to a record in a hash database object. */
 double tchdbadddouble(TCHDB *hdb, const void *kbuf, int ksiz, double num){
   assert(hdb && kbuf && ksiz >= 0);
+  uint64_t stime = tcstatsclock();
+  if(hdb->awth && !tchdbawbarrier(hdb)) return nan("");
   if(!HDBLOCKMETHOD(hdb, false)) return nan("");
   uint8_t hash;
   uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
@@ -966,7 +2008,7 @@ double tchdbadddouble(TCHDB *hdb, const void *kbuf, int ksiz, double num){
   if(hdb->zmode){
     char *zbuf;
     int osiz;
-    char *obuf = tchdbgetimpl(hdb, kbuf, ksiz, bidx, hash, &osiz);
+    char *obuf = tchdbgetimpl(hdb, kbuf, ksiz, bidx, hash, NULL, 0, &osiz);
     if(obuf){
       if(osiz != sizeof(num)){
         tchdbsetecode(hdb, TCEKEEP, __FILE__, __LINE__, __func__);
@@ -985,6 +2027,8 @@ double tchdbadddouble(TCHDB *hdb, const void *kbuf, int ksiz, double num){
       zbuf = _tc_bzcompress((char *)&num, sizeof(num), &zsiz);
     } else if(hdb->opts & HDBTTCBS){
       zbuf = tcbsencode((char *)&num, sizeof(num), &zsiz);
+    } else if(hdb->opts & HDBTLZ){
+      zbuf = tclzencode((char *)&num, sizeof(num), &zsiz);
     } else {
       zbuf = hdb->enc((char *)&num, sizeof(num), &zsiz, hdb->encop);
     }
@@ -994,19 +2038,24 @@ double tchdbadddouble(TCHDB *hdb, const void *kbuf, int ksiz, double num){
       HDBUNLOCKMETHOD(hdb);
       return nan("");
     }
-    bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, zbuf, zsiz, HDBPDOVER);
+    bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, zbuf, zsiz, HDBPDOVER, HDBXTINHERIT);
     TCFREE(zbuf);
     HDBUNLOCKRECORD(hdb, bidx);
     HDBUNLOCKMETHOD(hdb);
     if(hdb->dfunit > 0 && hdb->dfcnt > hdb->dfunit &&
-       !tchdbdefrag(hdb, hdb->dfunit * HDBDFRSRAT + 1)) rv = false;
+       !tchdbautodefrag(hdb)) rv = false;
+    if(HDBLHSPLITNEEDED(hdb) && !tchdblhgrow(hdb)) rv = false;
+    tcstatsop(hdb->stats, TCSOPUT, stime);
     return rv ? num : nan("");
   }
-  bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, (char *)&num, sizeof(num), HDBPDADDDBL);
+  bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, (char *)&num, sizeof(num), HDBPDADDDBL,
+                         HDBXTINHERIT);
   HDBUNLOCKRECORD(hdb, bidx);
   HDBUNLOCKMETHOD(hdb);
   if(hdb->dfunit > 0 && hdb->dfcnt > hdb->dfunit &&
-     !tchdbdefrag(hdb, hdb->dfunit * HDBDFRSRAT + 1)) rv = false;
+     !tchdbautodefrag(hdb)) rv = false;
+  if(HDBLHSPLITNEEDED(hdb) && !tchdblhgrow(hdb)) rv = false;
+  tcstatsop(hdb->stats, TCSOPUT, stime);
   return rv ? num : nan("");
 }
 
@@ -1014,6 +2063,8 @@ double tchdbadddouble(TCHDB *hdb, const void *kbuf, int ksiz, double num){
 /* Synchronize updated contents of a hash database object with the file and the device. */
 bool tchdbsync(TCHDB *hdb){
   assert(hdb);
+  uint64_t stime = tcstatsclock();
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
   if(!HDBLOCKMETHOD(hdb, true)) return false;
   if(hdb->fd < 0 || !(hdb->omode & HDBOWRITER) || hdb->tran){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -1025,7 +2076,9 @@ bool tchdbsync(TCHDB *hdb){
     return false;
   }
   bool rv = tchdbmemsync(hdb, true);
+  if(rv && !tchdbgcsync(hdb)) rv = false;
   HDBUNLOCKMETHOD(hdb);
+  tcstatsop(hdb->stats, TCSOSYNC, stime);
   return rv;
 }
 
@@ -1033,8 +2086,9 @@ bool tchdbsync(TCHDB *hdb){
 /* Optimize the file of a hash database object. */
 bool tchdboptimize(TCHDB *hdb, int64_t bnum, int8_t apow, int8_t fpow, uint8_t opts){
   assert(hdb);
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
   if(!HDBLOCKMETHOD(hdb, true)) return false;
-  if(hdb->fd < 0 || !(hdb->omode & HDBOWRITER) || hdb->tran){
+  if(hdb->fd < 0 || !(hdb->omode & HDBOWRITER) || hdb->tran || hdb->pinnum > 0){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
     HDBUNLOCKMETHOD(hdb);
     return false;
@@ -1043,6 +2097,10 @@ bool tchdboptimize(TCHDB *hdb, int64_t bnum, int8_t apow, int8_t fpow, uint8_t o
     HDBUNLOCKMETHOD(hdb);
     return false;
   }
+  if(!tchdbgcsync(hdb)){
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
   HDBTHREADYIELD(hdb);
   bool rv = tchdboptimizeimpl(hdb, bnum, apow, fpow, opts);
   HDBUNLOCKMETHOD(hdb);
@@ -1053,8 +2111,9 @@ bool tchdboptimize(TCHDB *hdb, int64_t bnum, int8_t apow, int8_t fpow, uint8_t o
 /* Remove all records of a hash database object. */
 bool tchdbvanish(TCHDB *hdb){
   assert(hdb);
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
   if(!HDBLOCKMETHOD(hdb, true)) return false;
-  if(hdb->fd < 0 || !(hdb->omode & HDBOWRITER) || hdb->tran){
+  if(hdb->fd < 0 || !(hdb->omode & HDBOWRITER) || hdb->tran || hdb->pinnum > 0){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
     HDBUNLOCKMETHOD(hdb);
     return false;
@@ -1063,6 +2122,10 @@ bool tchdbvanish(TCHDB *hdb){
     HDBUNLOCKMETHOD(hdb);
     return false;
   }
+  if(!tchdbgcsync(hdb)){
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
   HDBTHREADYIELD(hdb);
   bool rv = tchdbvanishimpl(hdb);
   HDBUNLOCKMETHOD(hdb);
@@ -1073,6 +2136,7 @@ bool tchdbvanish(TCHDB *hdb){
 /* Copy the database file of a hash database object. */
 bool tchdbcopy(TCHDB *hdb, const char *path){
   assert(hdb && path);
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
   if(!HDBLOCKMETHOD(hdb, false)) return false;
   if(hdb->fd < 0){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -1095,9 +2159,17 @@ bool tchdbcopy(TCHDB *hdb, const char *path){
 }
 
 
+/* Copy the database file of a hash database object without blocking writers. */
+bool tchdbbackup(TCHDB *hdb, const char *path){
+  assert(hdb && path);
+  return tchdbbackupproc(hdb, path, NULL, NULL);
+}
+
+
 /* Begin the transaction of a hash database object. */
 bool tchdbtranbegin(TCHDB *hdb){
   assert(hdb);
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
   for(double wsec = 1.0 / sysconf(_SC_CLK_TCK); true; wsec *= 2){
     if(!HDBLOCKMETHOD(hdb, true)) return false;
     if(hdb->fd < 0 || !(hdb->omode & HDBOWRITER) || hdb->fatal){
@@ -1105,7 +2177,7 @@ bool tchdbtranbegin(TCHDB *hdb){
       HDBUNLOCKMETHOD(hdb);
       return false;
     }
-    if(!hdb->tran) break;
+    if(!hdb->tran && !hdb->gcwant) break;
     HDBUNLOCKMETHOD(hdb);
     if(wsec > 1.0) wsec = 1.0;
     tcsleep(wsec);
@@ -1118,10 +2190,24 @@ bool tchdbtranbegin(TCHDB *hdb){
     HDBUNLOCKMETHOD(hdb);
     return false;
   }
-  if((hdb->omode & HDBOTSYNC) && fsync(hdb->fd) == -1){
+  bool gcpend = hdb->gcseq != hdb->gcsynced || hdb->rlsiz > 0;
+  hdb->vltran = hdb->vlhead;
+  hdb->vltrandead = hdb->vldead;
+  if(!gcpend && (hdb->omode & HDBOTSYNC) && fsync(hdb->fd) == -1){
     tchdbsetecode(hdb, TCESYNC, __FILE__, __LINE__, __func__);
     return false;
   }
+  if(hdb->omode & HDBOREDO){
+    if((hdb->omode & HDBOSNAPSHOT) && hdb->mmtx) tchdbsnapbegin(hdb);
+    if(!tchdbrlbegin(hdb)){
+      tchdbsnapend(hdb);
+      HDBUNLOCKMETHOD(hdb);
+      return false;
+    }
+    hdb->tran = true;
+    HDBUNLOCKMETHOD(hdb);
+    return true;
+  }
   if(hdb->walfd < 0){
     char *tpath = tcsprintf("%s%c%s", hdb->path, MYEXTCHR, HDBWALSUFFIX);
     int walfd = open(tpath, O_RDWR | O_CREAT | O_TRUNC, HDBFILEMODE);
@@ -1140,7 +2226,9 @@ bool tchdbtranbegin(TCHDB *hdb){
     hdb->walfd = walfd;
   }
   tchdbsetflag(hdb, HDBFOPEN, false);
-  if(!tchdbwalinit(hdb)){
+  if((hdb->omode & HDBOSNAPSHOT) && hdb->mmtx) tchdbsnapbegin(hdb);
+  if(gcpend ? !tchdbwalappend(hdb) : !tchdbwalinit(hdb)){
+    tchdbsnapend(hdb);
     tchdbsetflag(hdb, HDBFOPEN, true);
     HDBUNLOCKMETHOD(hdb);
     return false;
@@ -1155,6 +2243,8 @@ bool tchdbtranbegin(TCHDB *hdb){
 /* Commit the transaction of a hash database object. */
 bool tchdbtrancommit(TCHDB *hdb){
   assert(hdb);
+  uint64_t stime = tcstatsclock();
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
   if(!HDBLOCKMETHOD(hdb, true)) return false;
   if(hdb->fd < 0 || !(hdb->omode & HDBOWRITER) || hdb->fatal || !hdb->tran){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -1163,13 +2253,33 @@ bool tchdbtrancommit(TCHDB *hdb){
   }
   bool err = false;
   if(hdb->async && !tchdbflushdrp(hdb)) err = true;
+  if(hdb->redo){
+    if(!tchdbrlcommit(hdb)) err = true;
+    hdb->tran = false;
+    tchdbsnapend(hdb);
+    HDBUNLOCKMETHOD(hdb);
+    tcstatsop(hdb->stats, TCSOTRAN, stime);
+    return !err;
+  }
+  if(hdb->mmtx && hdb->gcwait > 0 && (hdb->omode & HDBOTSYNC)){
+    if(!tchdbmemsync(hdb, false)) err = true;
+    hdb->tran = false;
+    tchdbsnapend(hdb);
+    uint64_t seq = ++hdb->gcseq;
+    HDBUNLOCKMETHOD(hdb);
+    if(!err && !tchdbgcwaitimpl(hdb, seq)) err = true;
+    tcstatsop(hdb->stats, TCSOTRAN, stime);
+    return !err;
+  }
   if(!tchdbmemsync(hdb, hdb->omode & HDBOTSYNC)) err = true;
   if(!err && ftruncate(hdb->walfd, 0) == -1){
     tchdbsetecode(hdb, TCETRUNC, __FILE__, __LINE__, __func__);
     err = true;
   }
   hdb->tran = false;
+  tchdbsnapend(hdb);
   HDBUNLOCKMETHOD(hdb);
+  tcstatsop(hdb->stats, TCSOTRAN, stime);
   return !err;
 }
 
@@ -1177,6 +2287,7 @@ bool tchdbtrancommit(TCHDB *hdb){
 /* Abort the transaction of a hash database object. */
 bool tchdbtranabort(TCHDB *hdb){
   assert(hdb);
+  if(hdb->awth) tchdbawbarrier(hdb);
   if(!HDBLOCKMETHOD(hdb, true)) return false;
   if(hdb->fd < 0 || !(hdb->omode & HDBOWRITER) || !hdb->tran){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -1185,8 +2296,21 @@ bool tchdbtranabort(TCHDB *hdb){
   }
   bool err = false;
   if(hdb->async && !tchdbflushdrp(hdb)) err = true;
+  if(hdb->redo){
+    if(!tchdbrlabort(hdb)) err = true;
+    tchdbvltranabort(hdb);
+    hdb->tran = false;
+    tchdbsnapend(hdb);
+    HDBUNLOCKMETHOD(hdb);
+    return !err;
+  }
   if(!tchdbmemsync(hdb, false)) err = true;
-  if(!tchdbwalrestore(hdb, hdb->path)) err = true;
+  if(!tchdbwalrestore(hdb, hdb->path, hdb->gcwaloff, hdb->gcfsiz)) err = true;
+  if(hdb->gcwaloff > 0 && (ftruncate(hdb->walfd, hdb->gcwaloff) == -1 ||
+                           lseek(hdb->walfd, hdb->gcwaloff, SEEK_SET) == -1)){
+    tchdbsetecode(hdb, TCETRUNC, __FILE__, __LINE__, __func__);
+    err = true;
+  }
   char hbuf[HDBHEADSIZ];
   if(lseek(hdb->fd, 0, SEEK_SET) == -1){
     tchdbsetecode(hdb, TCESEEK, __FILE__, __LINE__, __func__);
@@ -1197,12 +2321,18 @@ bool tchdbtranabort(TCHDB *hdb){
   } else {
     tchdbloadmeta(hdb, hbuf);
   }
+  tchdbvltranabort(hdb);
   hdb->dfcur = hdb->frec;
+  hdb->apcur = 0;
+  hdb->apend = 0;
+  hdb->xtcur = 0;
+  tchdbxtreset(hdb);
   hdb->iter = 0;
   hdb->xfsiz = 0;
-  hdb->fbpnum = 0;
-  if(hdb->recc) tcmdbvanish(hdb->recc);
+  tchdbfbpclear(hdb);
+  if(hdb->recc) tchdbrcvanish(hdb);
   hdb->tran = false;
+  tchdbsnapend(hdb);
   HDBUNLOCKMETHOD(hdb);
   return !err;
 }
@@ -1232,7 +2362,7 @@ uint64_t tchdbrnum(TCHDB *hdb){
     HDBUNLOCKMETHOD(hdb);
     return 0;
   }
-  uint64_t rv = hdb->rnum;
+  uint64_t rv = tchdbsnapactive(hdb) ? ((HDBSNAP *)hdb->snap)->rnum : hdb->rnum;
   HDBUNLOCKMETHOD(hdb);
   return rv;
 }
@@ -1325,6 +2455,8 @@ bool tchdbmemsync(TCHDB *hdb, bool phys){
     return false;
   }
   bool err = false;
+  uint64_t fsiz = hdb->fsiz;
+  uint64_t apsync = (hdb->apend > 0) ? hdb->apcur : fsiz;
   char hbuf[HDBHEADSIZ];
   tchdbdumpmeta(hdb, hbuf);
   memcpy(hdb->map, hbuf, HDBOPAQUEOFF);
@@ -1338,6 +2470,11 @@ bool tchdbmemsync(TCHDB *hdb, bool phys){
       tchdbsetecode(hdb, TCESYNC, __FILE__, __LINE__, __func__);
       err = true;
     }
+    if(hdb->vlfd >= 0 && fsync(hdb->vlfd) == -1){
+      tchdbsetecode(hdb, TCESYNC, __FILE__, __LINE__, __func__);
+      err = true;
+    }
+    if(!err && (hdb->omode & HDBOAPPEND)) tchdbsetapsync(hdb, apsync);
   }
   return !err;
 }
@@ -1487,6 +2624,17 @@ uint64_t tchdbbnumused(TCHDB *hdb){
 }
 
 
+/* Get the number of active elements of the bucket array of a hash database object. */
+uint64_t tchdbbnumactive(TCHDB *hdb){
+  assert(hdb);
+  if(hdb->fd < 0){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    return 0;
+  }
+  return (hdb->lhmod > 0) ? hdb->lhnum : hdb->bnum;
+}
+
+
 /* Set the custom codec functions of a hash database object. */
 bool tchdbsetcodecfunc(TCHDB *hdb, TCCODEC enc, void *encop, TCCODEC dec, void *decop){
   assert(hdb && enc && dec);
@@ -1512,6 +2660,18 @@ uint32_t tchdbdfunit(TCHDB *hdb){
 }
 
 
+/* Get the progress of background defragmentation of a hash database object. */
+bool tchdbbgdefragstat(TCHDB *hdb, uint64_t *snp, uint64_t *bsp, uint64_t *pnp){
+  assert(hdb);
+  if(!HDBLOCKMETHOD(hdb, false)) return false;
+  if(snp) *snp = hdb->dfsnum;
+  if(bsp) *bsp = hdb->dfbsiz;
+  if(pnp) *pnp = hdb->dfpnum;
+  HDBUNLOCKMETHOD(hdb);
+  return true;
+}
+
+
 /* Perform dynamic defragmentation of a hash database object. */
 bool tchdbdefrag(TCHDB *hdb, int64_t step){
   assert(hdb);
@@ -1543,6 +2703,10 @@ bool tchdbdefrag(TCHDB *hdb, int64_t step){
   bool err = false;
   if(HDBLOCKALLRECORDS(hdb, true)){
     hdb->dfcur = hdb->frec;
+    hdb->apcur = 0;
+    hdb->apend = 0;
+    hdb->xtcur = 0;
+    hdb->xtnext = 0;
     HDBUNLOCKALLRECORDS(hdb);
   } else {
     err = true;
@@ -1552,7 +2716,8 @@ bool tchdbdefrag(TCHDB *hdb, int64_t step){
     if(HDBLOCKALLRECORDS(hdb, true)){
       uint64_t cur = hdb->dfcur;
       if(!tchdbdefragimpl(hdb, UINT8_MAX)) err = true;
-      if(hdb->dfcur <= cur) stop = true;
+      if(hdb->dfcur <= cur && hdb->vlgccur < 1 && hdb->xtcur < 1 &&
+         (!(hdb->flags & HDBFEXPIRE) || hdb->tran || time(NULL) < hdb->xtnext)) stop = true;
       HDBUNLOCKALLRECORDS(hdb);
       HDBTHREADYIELD(hdb);
     } else {
@@ -1574,16 +2739,75 @@ bool tchdbcacheclear(TCHDB *hdb){
     return false;
   }
   HDBTHREADYIELD(hdb);
-  if(hdb->recc) tcmdbvanish(hdb->recc);
+  if(hdb->recc) tchdbrcvanish(hdb);
+  HDBUNLOCKMETHOD(hdb);
+  return true;
+}
+
+
+/* Get the statistics of the record cache of a hash database object. */
+bool tchdbcachestat(TCHDB *hdb, uint64_t *hitp, uint64_t *missp, uint64_t *rnump,
+                    uint64_t *msizp){
+  assert(hdb);
+  if(!HDBLOCKMETHOD(hdb, false)) return false;
+  if(hdb->fd < 0){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  uint64_t hnum = 0;
+  uint64_t mnum = 0;
+  uint64_t rnum = 0;
+  uint64_t msiz = 0;
+  HDBRCACHE *rc = hdb->recc;
+  for(int i = 0; rc && i < rc->snum; i++){
+    HDBRCSHARD *shard = rc->shards + i;
+    if(rc->mt && pthread_mutex_lock(&shard->mutex) != 0) tcmyfatal("pthread_mutex_lock failed");
+    hnum += shard->hnum;
+    mnum += shard->mnum;
+    rnum += TCMAPRNUM(shard->pmap) + TCMAPRNUM(shard->fmap);
+    msiz += shard->psiz + shard->fsiz;
+    if(rc->mt) pthread_mutex_unlock(&shard->mutex);
+  }
+  if(hitp) *hitp = hnum;
+  if(missp) *missp = mnum;
+  if(rnump) *rnump = rnum;
+  if(msizp) *msizp = msiz;
+  HDBUNLOCKMETHOD(hdb);
+  return true;
+}
+
+
+/* Get the statistics of the value log of a hash database object. */
+bool tchdbvlogstat(TCHDB *hdb, uint64_t *lsizp, uint64_t *dsizp, uint64_t *pnp){
+  assert(hdb);
+  if(!HDBLOCKMETHOD(hdb, false)) return false;
+  if(hdb->fd < 0){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  if(lsizp) *lsizp = hdb->vlhead - hdb->vltail;
+  if(dsizp) *dsizp = hdb->vldead + hdb->vlgcdead;
+  if(pnp) *pnp = hdb->vlgcnum;
   HDBUNLOCKMETHOD(hdb);
   return true;
 }
 
 
+/* Get the statistics of operations of a hash database object. */
+TCSTATS *tchdbstats(TCHDB *hdb){
+  assert(hdb);
+  return hdb->stats;
+}
+
+
 /* Store a record into a hash database object with a duplication handler. */
 bool tchdbputproc(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz,
                   TCPDPROC proc, void *op){
   assert(hdb && kbuf && ksiz >= 0 && proc);
+  uint64_t stime = tcstatsclock();
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
   if(!HDBLOCKMETHOD(hdb, false)) return false;
   uint8_t hash;
   uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
@@ -1603,7 +2827,7 @@ bool tchdbputproc(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int
   if(hdb->zmode){
     char *zbuf;
     int osiz;
-    char *obuf = tchdbgetimpl(hdb, kbuf, ksiz, bidx, hash, &osiz);
+    char *obuf = tchdbgetimpl(hdb, kbuf, ksiz, bidx, hash, NULL, 0, &osiz);
     if(obuf){
       int nsiz;
       char *nbuf = proc(obuf, osiz, &nsiz, op);
@@ -1612,6 +2836,7 @@ bool tchdbputproc(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int
         TCFREE(obuf);
         HDBUNLOCKRECORD(hdb, bidx);
         HDBUNLOCKMETHOD(hdb);
+        tcstatsop(hdb->stats, TCSOPUT, stime);
         return rv;
       } else if(nbuf){
         if(hdb->opts & HDBTDEFLATE){
@@ -1620,6 +2845,8 @@ bool tchdbputproc(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int
           zbuf = _tc_bzcompress(nbuf, nsiz, &vsiz);
         } else if(hdb->opts & HDBTTCBS){
           zbuf = tcbsencode(nbuf, nsiz, &vsiz);
+        } else if(hdb->opts & HDBTLZ){
+          zbuf = tclzencode(nbuf, nsiz, &vsiz);
         } else {
           zbuf = hdb->enc(nbuf, nsiz, &vsiz, hdb->encop);
         }
@@ -1635,6 +2862,8 @@ bool tchdbputproc(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int
         zbuf = _tc_bzcompress(vbuf, vsiz, &vsiz);
       } else if(hdb->opts & HDBTTCBS){
         zbuf = tcbsencode(vbuf, vsiz, &vsiz);
+      } else if(hdb->opts & HDBTLZ){
+        zbuf = tclzencode(vbuf, vsiz, &vsiz);
       } else {
         zbuf = hdb->enc(vbuf, vsiz, &vsiz, hdb->encop);
       }
@@ -1650,12 +2879,14 @@ bool tchdbputproc(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int
       HDBUNLOCKMETHOD(hdb);
       return false;
     }
-    bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, zbuf, vsiz, HDBPDOVER);
+    bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, zbuf, vsiz, HDBPDOVER, HDBXTINHERIT);
     TCFREE(zbuf);
     HDBUNLOCKRECORD(hdb, bidx);
     HDBUNLOCKMETHOD(hdb);
     if(hdb->dfunit > 0 && hdb->dfcnt > hdb->dfunit &&
-       !tchdbdefrag(hdb, hdb->dfunit * HDBDFRSRAT + 1)) rv = false;
+       !tchdbautodefrag(hdb)) rv = false;
+    if(HDBLHSPLITNEEDED(hdb) && !tchdblhgrow(hdb)) rv = false;
+    tcstatsop(hdb->stats, TCSOPUT, stime);
     return rv;
   }
   HDBPDPROCOP procop;
@@ -1674,12 +2905,14 @@ bool tchdbputproc(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int
   wp += sizeof(procptr);
   memcpy(wp, kbuf, ksiz);
   kbuf = rbuf + sizeof(procptr);
-  bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, vbuf, vsiz, HDBPDPROC);
+  bool rv = tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, vbuf, vsiz, HDBPDPROC, HDBXTINHERIT);
   if(rbuf != (char *)stack) TCFREE(rbuf);
   HDBUNLOCKRECORD(hdb, bidx);
   HDBUNLOCKMETHOD(hdb);
   if(hdb->dfunit > 0 && hdb->dfcnt > hdb->dfunit &&
-     !tchdbdefrag(hdb, hdb->dfunit * HDBDFRSRAT + 1)) rv = false;
+     !tchdbautodefrag(hdb)) rv = false;
+  if(HDBLHSPLITNEEDED(hdb) && !tchdblhgrow(hdb)) rv = false;
+  tcstatsop(hdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -1697,6 +2930,7 @@ void tchdbcodecfunc(TCHDB *hdb, TCCODEC *ep, void **eop, TCCODEC *dp, void **dop
 /* Retrieve the next record of a record in a hash database object. */
 void *tchdbgetnext(TCHDB *hdb, const void *kbuf, int ksiz, int *sp){
   assert(hdb && sp);
+  if(hdb->awth && !tchdbawbarrier(hdb)) return NULL;
   if(!HDBLOCKMETHOD(hdb, true)) return NULL;
   if(hdb->fd < 0){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -1724,6 +2958,7 @@ char *tchdbgetnext2(TCHDB *hdb, const char *kstr){
 /* Retrieve the key and the value of the next record of a record in a hash database object. */
 char *tchdbgetnext3(TCHDB *hdb, const char *kbuf, int ksiz, int *sp, const char **vbp, int *vsp){
   assert(hdb && sp && vbp && vsp);
+  if(hdb->awth && !tchdbawbarrier(hdb)) return NULL;
   if(!HDBLOCKMETHOD(hdb, true)) return NULL;
   if(hdb->fd < 0){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -1743,6 +2978,7 @@ char *tchdbgetnext3(TCHDB *hdb, const char *kbuf, int ksiz, int *sp, const char
 /* Move the iterator to the record corresponding a key of a hash database object. */
 bool tchdbiterinit2(TCHDB *hdb, const void *kbuf, int ksiz){
   assert(hdb && kbuf && ksiz >= 0);
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
   if(!HDBLOCKMETHOD(hdb, true)) return false;
   if(hdb->fd < 0){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -1769,6 +3005,7 @@ bool tchdbiterinit3(TCHDB *hdb, const char *kstr){
 /* Process each record atomically of a hash database object. */
 bool tchdbforeach(TCHDB *hdb, TCITER iter, void *op){
   assert(hdb && iter);
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
   if(!HDBLOCKMETHOD(hdb, false)) return false;
   if(hdb->fd < 0){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -1784,32 +3021,193 @@ bool tchdbforeach(TCHDB *hdb, TCITER iter, void *op){
     return false;
   }
   HDBTHREADYIELD(hdb);
-  bool rv = tchdbforeachimpl(hdb, iter, op);
+  bool rv = tchdbforeachimpl(hdb, hdb->frec, hdb->fsiz, iter, op);
   HDBUNLOCKALLRECORDS(hdb);
   HDBUNLOCKMETHOD(hdb);
   return rv;
 }
 
 
-/* Void the transaction of a hash database object. */
-bool tchdbtranvoid(TCHDB *hdb){
-  assert(hdb);
-  if(!HDBLOCKMETHOD(hdb, true)) return false;
-  if(hdb->fd < 0 || !(hdb->omode & HDBOWRITER) || hdb->fatal || !hdb->tran){
+/* Split the record region of a hash database object into partitions. */
+uint64_t *tchdbpartition(TCHDB *hdb, int pnum, int *np){
+  assert(hdb && np);
+  if(hdb->awth && !tchdbawbarrier(hdb)) return NULL;
+  if(!HDBLOCKMETHOD(hdb, false)) return NULL;
+  if(hdb->fd < 0){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    HDBUNLOCKMETHOD(hdb);
+    return NULL;
+  }
+  if(hdb->async && !tchdbflushdrp(hdb)){
+    HDBUNLOCKMETHOD(hdb);
+    return NULL;
+  }
+  if(pnum < 1) pnum = 1;
+  uint64_t beg = hdb->frec;
+  uint64_t end = hdb->fsiz;
+  uint64_t *offs;
+  TCMALLOC(offs, sizeof(*offs) * (pnum + 1));
+  offs[0] = beg;
+  int num = 1;
+  for(int i = 1; i < pnum; i++){
+    uint64_t off = beg + (end - beg) / pnum * i;
+    if(off <= offs[num-1]) continue;
+    off = tchdbpartprobe(hdb, off, end);
+    if(off > offs[num-1] && off < end) offs[num++] = off;
+  }
+  offs[num++] = end;
+  *np = num - 1;
+  HDBUNLOCKMETHOD(hdb);
+  return offs;
+}
+
+
+/* Get the next record of a partition of a hash database object. */
+bool tchdbiternextpart(TCHDB *hdb, uint64_t *curp, uint64_t end, TCXSTR *kxstr, TCXSTR *vxstr){
+  assert(hdb && curp && kxstr && vxstr);
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
+  if(!HDBLOCKMETHOD(hdb, false)) return false;
+  if(hdb->fd < 0 || *curp < hdb->frec){
     tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
     HDBUNLOCKMETHOD(hdb);
     return false;
   }
-  hdb->tran = false;
+  if(hdb->async && !tchdbflushdrp(hdb)){
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  bool rv = tchdbiternextpartimpl(hdb, curp, tclmin(end, hdb->fsiz), kxstr, vxstr);
   HDBUNLOCKMETHOD(hdb);
-  return true;
+  return rv;
 }
 
 
+/* Process each record of a partition of a hash database object atomically. */
+bool tchdbforeachpart(TCHDB *hdb, uint64_t beg, uint64_t end, TCITER iter, void *op){
+  assert(hdb && iter);
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
+  if(!HDBLOCKMETHOD(hdb, false)) return false;
+  if(hdb->fd < 0 || beg < hdb->frec){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  if(hdb->async && !tchdbflushdrp(hdb)){
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  if(!HDBLOCKALLRECORDS(hdb, false)){
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  bool rv = tchdbforeachimpl(hdb, beg, tclmin(end, hdb->fsiz), iter, op);
+  HDBUNLOCKALLRECORDS(hdb);
+  HDBUNLOCKMETHOD(hdb);
+  return rv;
+}
 
-/*************************************************************************************************
- * private features
- *************************************************************************************************/
+
+/* Create a hash database file from a stream of records in bulk. */
+bool tchdbbulkload(TCHDB *hdb, const char *path, TCHDBFEED feed, void *op){
+  assert(hdb && path && feed);
+  if(!tchdbopen(hdb, path, HDBOWRITER | HDBOCREAT | HDBOTRUNC)) return false;
+  bool err = false;
+  if(HDBLOCKMETHOD(hdb, true)){
+    if(!tchdbbulkloadimpl(hdb, feed, op)) err = true;
+    HDBUNLOCKMETHOD(hdb);
+  } else {
+    err = true;
+  }
+  if(!tchdbclose(hdb)) err = true;
+  return !err;
+}
+
+
+/* Copy the database file of a hash database object without blocking writers, with a hook. */
+bool tchdbbackupproc(TCHDB *hdb, const char *path, TCHDBBKPROC proc, void *op){
+  assert(hdb && path);
+  if(hdb->awth && !tchdbawbarrier(hdb)) return false;
+  if(!HDBLOCKMETHOD(hdb, true)) return false;
+  if(hdb->fd < 0 || hdb->bkup || *path == '@'){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  if(hdb->async && !tchdbflushdrp(hdb)){
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, HDBFILEMODE);
+  if(fd < 0){
+    tchdbsetecode(hdb, TCEOPEN, __FILE__, __LINE__, __func__);
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  int vlfd = -1;
+  if(hdb->vlfd >= 0){
+    char *vpath = tcsprintf("%s%c%s", path, MYEXTCHR, HDBVLSUFFIX);
+    vlfd = open(vpath, O_WRONLY | O_CREAT | O_TRUNC, HDBFILEMODE);
+    TCFREE(vpath);
+    if(vlfd < 0){
+      tchdbsetecode(hdb, TCEOPEN, __FILE__, __LINE__, __func__);
+      close(fd);
+      HDBUNLOCKMETHOD(hdb);
+      return false;
+    }
+  }
+  HDBBKUP *bkup;
+  TCMALLOC(bkup, sizeof(*bkup));
+  if(pthread_mutex_init(&bkup->mutex, NULL) != 0){
+    tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+    TCFREE(bkup);
+    if(vlfd >= 0) close(vlfd);
+    close(fd);
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  bkup->pages = tcmapnew();
+  bkup->cancel = false;
+  hdb->bkup = bkup;
+  uint64_t fsiz = hdb->fsiz;
+  uint64_t vlsiz = (vlfd >= 0) ? hdb->vlhead : 0;
+  HDBUNLOCKMETHOD(hdb);
+  bool err = false;
+  if(!tchdbbackupimpl(hdb, bkup, fd, vlfd, fsiz, vlsiz, proc, op)) err = true;
+  if(vlfd >= 0 && close(vlfd) == -1){
+    tchdbsetecode(hdb, TCECLOSE, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  if(close(fd) == -1){
+    tchdbsetecode(hdb, TCECLOSE, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  tcmapdel(bkup->pages);
+  pthread_mutex_destroy(&bkup->mutex);
+  TCFREE(bkup);
+  return !err;
+}
+
+
+/* Void the transaction of a hash database object. */
+bool tchdbtranvoid(TCHDB *hdb){
+  assert(hdb);
+  if(!HDBLOCKMETHOD(hdb, true)) return false;
+  if(hdb->fd < 0 || !(hdb->omode & HDBOWRITER) || hdb->fatal || !hdb->tran){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  hdb->tran = false;
+  tchdbsnapend(hdb);
+  HDBUNLOCKMETHOD(hdb);
+  return true;
+}
+
+
+
+/*************************************************************************************************
+ * private features
+ *************************************************************************************************/
 
 
 /* Get a natural prime number not less than a floor number.
@@ -1859,7 +3257,14 @@ static uint64_t tcgetprime(uint64_t num){
    The return value is true if successful, else, it is false. */
 static bool tchdbseekwrite(TCHDB *hdb, off_t off, const void *buf, size_t size){
   assert(hdb && off >= 0 && buf && size >= 0);
-  if(hdb->tran && !tchdbwalwrite(hdb, off, size)) return false;
+  if(hdb->tran){
+    if(!tchdbwalwrite(hdb, off, size)) return false;
+    if(hdb->redo) return tchdbrlwrite(hdb, off, buf, size);
+  } else if(hdb->gcseq != hdb->gcsynced || hdb->rlsiz > 0){
+    if(!tchdbgcsync(hdb)) return false;
+  }
+  tcstatsadd(hdb->stats, TCSCWRITE, size);
+  if(hdb->bkup) tchdbbkmark(hdb, off, size);
   off_t end = off + size;
   if(end <= hdb->xmsiz){
     if(end >= hdb->fsiz && end >= hdb->xfsiz){
@@ -1873,11 +3278,13 @@ static bool tchdbseekwrite(TCHDB *hdb, off_t off, const void *buf, size_t size){
     memcpy(hdb->map + off, buf, size);
     return true;
   }
+  tchdbscanpatch(hdb, off, buf, size);
   if(!TCUBCACHE && off < hdb->xmsiz){
     if(end >= hdb->fsiz && end >= hdb->xfsiz){
       uint64_t xfsiz = end + HDBXFSIZINC;
       if(ftruncate(hdb->fd, xfsiz) == -1){
         tchdbsetecode(hdb, TCETRUNC, __FILE__, __LINE__, __func__);
+        __sync_fetch_and_add(&hdb->wseq, 1);
         return false;
       }
       hdb->xfsiz = xfsiz;
@@ -1899,11 +3306,13 @@ static bool tchdbseekwrite(TCHDB *hdb, off_t off, const void *buf, size_t size){
     } else if(wb == -1){
       if(errno != EINTR){
         tchdbsetecode(hdb, TCEWRITE, __FILE__, __LINE__, __func__);
+        __sync_fetch_and_add(&hdb->wseq, 1);
         return false;
       }
     } else {
       if(size > 0){
         tchdbsetecode(hdb, TCEWRITE, __FILE__, __LINE__, __func__);
+        __sync_fetch_and_add(&hdb->wseq, 1);
         return false;
       }
     }
@@ -1920,6 +3329,8 @@ static bool tchdbseekwrite(TCHDB *hdb, off_t off, const void *buf, size_t size){
    The return value is true if successful, else, it is false. */
 static bool tchdbseekread(TCHDB *hdb, off_t off, void *buf, size_t size){
   assert(hdb && off >= 0 && buf && size >= 0);
+  tcstatsadd(hdb->stats, TCSCREAD, size);
+  if(hdb->redo && off + size > hdb->xmsiz) return tchdbrlread(hdb, off, buf, size);
   if(off + size <= hdb->xmsiz){
     memcpy(buf, hdb->map + off, size);
     return true;
@@ -1965,6 +3376,8 @@ static bool tchdbseekreadtry(TCHDB *hdb, off_t off, void *buf, size_t size){
   assert(hdb && off >= 0 && buf && size >= 0);
   off_t end = off + size;
   if(end > hdb->fsiz) return false;
+  tcstatsadd(hdb->stats, TCSCREAD, size);
+  if(hdb->redo && end > hdb->xmsiz) return tchdbrlread(hdb, off, buf, size);
   if(end <= hdb->xmsiz){
     memcpy(buf, hdb->map + off, size);
     return true;
@@ -1983,6 +3396,265 @@ static bool tchdbseekreadtry(TCHDB *hdb, off_t off, void *buf, size_t size){
 }
 
 
+/* Read blocks of a file in a batch.
+   `hdb' specifies the hash database object.
+   `offs' specifies an array of the offsets of the blocks.
+   `num' specifies the number of the elements of the array.
+   `buf' specifies the buffer into which the blocks are read.  The block of each element is put
+   at the multiple of the record reading unit.
+   `sizs' specifies an array into which the sizes of the data read are assigned.  0 means that the
+   block is not read and should be read by the caller.
+   The reads are submitted in batches through io_uring where it is available.  Else, the kernel
+   is only advised of them and all sizes are 0.  Nothing is read while the redo log of a
+   transaction is active, as the file does not reflect it. */
+static void tchdbreadblocks(TCHDB *hdb, const uint64_t *offs, int num, char *buf, int *sizs){
+  assert(hdb && offs && num >= 0 && buf && sizs);
+  if(hdb->redo){
+    memset(sizs, 0, sizeof(*sizs) * num);
+    return;
+  }
+  for(int i = 0; i < num; i++){
+    sizs[i] = (offs[i] < hdb->fsiz) ? tclmin(hdb->fsiz - offs[i], hdb->runit) : 0;
+  }
+#if TCUSEURING
+  if(!HDBLOCKDB(hdb)){
+    memset(sizs, 0, sizeof(*sizs) * num);
+    return;
+  }
+  if(!hdb->uring) hdb->uring = tchdburingnew();
+  HDBURING *ring = hdb->uring;
+  bool done = ring->fd >= 0;
+  for(int i = 0; i < num && ring->fd >= 0; i += HDBURINGDEPTH){
+    int rnum = tclmin(num - i, HDBURINGDEPTH);
+    if(!tchdburingread(ring, hdb->fd, offs + i, rnum, buf + (size_t)i * hdb->runit, hdb->runit,
+                       sizs + i)){
+      close(ring->fd);
+      ring->fd = -1;
+      done = false;
+    }
+  }
+  HDBUNLOCKDB(hdb);
+  if(done){
+    int64_t rsiz = 0;
+    for(int i = 0; i < num; i++){
+      rsiz += sizs[i];
+    }
+    tcstatsadd(hdb->stats, TCSCREAD, rsiz);
+    return;
+  }
+#endif
+#if defined(POSIX_FADV_WILLNEED)
+  for(int i = 0; i < num; i++){
+    if(sizs[i] > 0) posix_fadvise(hdb->fd, offs[i], sizs[i], POSIX_FADV_WILLNEED);
+  }
+#endif
+  memset(sizs, 0, sizeof(*sizs) * num);
+}
+
+
+/* Create a ring of asynchronous I/O.
+   The return value is the new ring object.  If io_uring is not available, the file descriptor
+   of the object is negative. */
+static void *tchdburingnew(void){
+#if TCUSEURING
+  HDBURING *ring;
+  TCMALLOC(ring, sizeof(*ring));
+  memset(ring, 0, sizeof(*ring));
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring->fd = syscall(__NR_io_uring_setup, HDBURINGDEPTH, &params);
+  if(ring->fd < 0){
+    ring->fd = -1;
+    return ring;
+  }
+  ring->sqmsiz = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  ring->cqmsiz = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if(params.features & IORING_FEAT_SINGLE_MMAP){
+    if(ring->cqmsiz > ring->sqmsiz) ring->sqmsiz = ring->cqmsiz;
+    ring->cqmsiz = 0;
+  }
+  ring->sqmap = mmap(0, ring->sqmsiz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     ring->fd, IORING_OFF_SQ_RING);
+  ring->cqmap = (ring->sqmap != MAP_FAILED && ring->cqmsiz > 0) ?
+    mmap(0, ring->cqmsiz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+         ring->fd, IORING_OFF_CQ_RING) : ring->sqmap;
+  ring->sqesiz = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = (ring->cqmap != MAP_FAILED) ?
+    mmap(0, ring->sqesiz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+         ring->fd, IORING_OFF_SQES) : MAP_FAILED;
+  if(ring->sqes == MAP_FAILED){
+    if(ring->cqmsiz > 0 && ring->cqmap != MAP_FAILED) munmap(ring->cqmap, ring->cqmsiz);
+    if(ring->sqmap != MAP_FAILED) munmap(ring->sqmap, ring->sqmsiz);
+    close(ring->fd);
+    ring->fd = -1;
+    return ring;
+  }
+  char *sp = ring->sqmap;
+  char *cp = ring->cqmap;
+  ring->sqtail = (uint32_t *)(sp + params.sq_off.tail);
+  ring->sqmask = *(uint32_t *)(sp + params.sq_off.ring_mask);
+  ring->sqarray = (uint32_t *)(sp + params.sq_off.array);
+  ring->cqhead = (uint32_t *)(cp + params.cq_off.head);
+  ring->cqtail = (uint32_t *)(cp + params.cq_off.tail);
+  ring->cqmask = *(uint32_t *)(cp + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *)(cp + params.cq_off.cqes);
+  return ring;
+#else
+  return NULL;
+#endif
+}
+
+
+/* Delete a ring of asynchronous I/O.
+   `ring' specifies the ring object. */
+static void tchdburingdel(void *ring){
+#if TCUSEURING
+  assert(ring);
+  HDBURING *myring = ring;
+  if(myring->fd >= 0){
+    close(myring->fd);
+    munmap(myring->sqes, myring->sqesiz);
+    if(myring->cqmsiz > 0) munmap(myring->cqmap, myring->cqmsiz);
+    munmap(myring->sqmap, myring->sqmsiz);
+  }
+  TCFREE(myring);
+#endif
+}
+
+
+/* Read regions of a file through a ring of asynchronous I/O.
+   `ring' specifies the ring object.
+   `fd' specifies the file descriptor.
+   `offs' specifies an array of the offsets of the regions.
+   `num' specifies the number of the elements of the array.  It should not be more than the depth
+   of the ring.
+   `buf' specifies the buffer into which the regions are read.
+   `bsiz' specifies the distance between the regions in the buffer.
+   `sizs' specifies an array of the sizes of the regions.  The sizes of the data read are
+   assigned to it.  0 is assigned for a region whose read failed.
+   If successful, the return value is true, else, it is false.  Every read is submitted by one
+   system call and all of them are waited for by the same call.  Even on failure, no read is left
+   in flight when the function returns, so the buffer can be released at once. */
+static bool tchdburingread(void *ring, int fd, const uint64_t *offs, int num, char *buf, int bsiz,
+                           int *sizs){
+#if TCUSEURING
+  assert(ring && fd >= 0 && offs && num >= 0 && num <= HDBURINGDEPTH && buf && bsiz > 0 && sizs);
+  HDBURING *myring = ring;
+  uint32_t tail = *myring->sqtail;
+  int sidxs[HDBURINGDEPTH];
+  bool dones[HDBURINGDEPTH];
+  int snum = 0;
+  for(int i = 0; i < num; i++){
+    dones[i] = true;
+    if(sizs[i] < 1) continue;
+    uint32_t idx = tail & myring->sqmask;
+    struct io_uring_sqe *sqe = myring->sqes + idx;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->off = offs[i];
+    sqe->addr = (uintptr_t)(buf + (size_t)i * bsiz);
+    sqe->len = sizs[i];
+    sqe->user_data = i;
+    myring->sqarray[idx] = idx;
+    tail++;
+    sidxs[snum++] = i;
+    dones[i] = false;
+  }
+  __atomic_store_n(myring->sqtail, tail, __ATOMIC_RELEASE);
+  int pnum = snum;
+  int cnum = 0;
+  while(cnum < snum){
+    int rv = syscall(__NR_io_uring_enter, myring->fd, pnum, snum - cnum,
+                     IORING_ENTER_GETEVENTS, NULL, 0);
+    if(rv == -1){
+      if(errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+      for(int i = snum - pnum; i < snum; i++){
+        dones[sidxs[i]] = true;
+      }
+      tchdburingabort(myring, dones, num, pnum);
+      memset(sizs, 0, sizeof(*sizs) * num);
+      return false;
+    }
+    pnum = tclmax(pnum - rv, 0);
+    uint32_t head = *myring->cqhead;
+    uint32_t ctail = __atomic_load_n(myring->cqtail, __ATOMIC_ACQUIRE);
+    while(head != ctail){
+      struct io_uring_cqe *cqe = myring->cqes + (head & myring->cqmask);
+      uint64_t ud = cqe->user_data;
+      if(ud < (uint64_t)num && !dones[ud]){
+        int i = ud;
+        if(cqe->res < sizs[i]) sizs[i] = tclmax(cqe->res, 0);
+        dones[i] = true;
+        cnum++;
+      }
+      head++;
+    }
+    __atomic_store_n(myring->cqhead, head, __ATOMIC_RELEASE);
+  }
+  return true;
+#else
+  assert(ring && fd >= 0 && offs && num >= 0 && buf && bsiz > 0 && sizs);
+  return false;
+#endif
+}
+
+
+/* Abort the reads submitted to a ring of asynchronous I/O.
+   `ring' specifies the ring object.
+   `dones' specifies an array of the flags whether the read of each region is finished.
+   `num' specifies the number of the elements of the array.
+   `pnum' specifies the number of the last entries which the kernel has not consumed yet.
+   The pending entries are withdrawn, a cancellation is submitted for every read in flight, and
+   the completion of each read is waited for. */
+static void tchdburingabort(void *ring, bool *dones, int num, int pnum){
+#if TCUSEURING
+  assert(ring && dones && num >= 0 && pnum >= 0);
+  HDBURING *myring = ring;
+  uint32_t tail = *myring->sqtail - pnum;
+  int snum = 0;
+  int wnum = 0;
+  for(int i = 0; i < num; i++){
+    if(dones[i]) continue;
+    uint32_t idx = tail & myring->sqmask;
+    struct io_uring_sqe *sqe = myring->sqes + idx;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = i;
+    sqe->user_data = UINT64_MAX;
+    myring->sqarray[idx] = idx;
+    tail++;
+    snum++;
+    wnum++;
+  }
+  __atomic_store_n(myring->sqtail, tail, __ATOMIC_RELEASE);
+  while(wnum > 0){
+    int rv = syscall(__NR_io_uring_enter, myring->fd, snum, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+    if(rv >= 0){
+      snum = tclmax(snum - rv, 0);
+    } else if(errno != EINTR && errno != EAGAIN && errno != EBUSY){
+      tcsleep(HDBAWWAIT);
+    }
+    uint32_t head = *myring->cqhead;
+    uint32_t ctail = __atomic_load_n(myring->cqtail, __ATOMIC_ACQUIRE);
+    while(head != ctail){
+      struct io_uring_cqe *cqe = myring->cqes + (head & myring->cqmask);
+      uint64_t ud = cqe->user_data;
+      if(ud < (uint64_t)num && !dones[ud]){
+        dones[ud] = true;
+        wnum--;
+      }
+      head++;
+    }
+    __atomic_store_n(myring->cqhead, head, __ATOMIC_RELEASE);
+  }
+  if(snum > 0) __atomic_store_n(myring->sqtail, tail - snum, __ATOMIC_RELEASE);
+#else
+  assert(ring && dones && num >= 0 && pnum >= 0);
+#endif
+}
+
+
 /* Serialize meta data into a buffer.
    `hdb' specifies the hash database object.
    `hbuf' specifies the buffer. */
@@ -2007,6 +3679,26 @@ static void tchdbdumpmeta(TCHDB *hdb, char *hbuf){
   llnum = hdb->frec;
   llnum = TCHTOILL(llnum);
   memcpy(hbuf + HDBFRECOFF, &llnum, sizeof(llnum));
+  llnum = hdb->lhbase;
+  llnum = TCHTOILL(llnum);
+  memcpy(hbuf + HDBLHBASEOFF, &llnum, sizeof(llnum));
+  llnum = hdb->lhnum;
+  llnum = TCHTOILL(llnum);
+  memcpy(hbuf + HDBLHNUMOFF, &llnum, sizeof(llnum));
+  llnum = hdb->vltail;
+  llnum = TCHTOILL(llnum);
+  memcpy(hbuf + HDBVLTAILOFF, &llnum, sizeof(llnum));
+  llnum = hdb->vldead + hdb->vlgcdead;
+  llnum = TCHTOILL(llnum);
+  memcpy(hbuf + HDBVLDEADOFF, &llnum, sizeof(llnum));
+  memcpy(hbuf + HDBFWPOWOFF, &(hdb->fwpow), sizeof(hdb->fwpow));
+  memcpy(hbuf + HDBFKNUMOFF, &(hdb->fknum), sizeof(hdb->fknum));
+  llnum = hdb->apsync;
+  llnum = TCHTOILL(llnum);
+  memcpy(hbuf + HDBAPSYNCOFF, &llnum, sizeof(llnum));
+  llnum = hdb->aprel;
+  llnum = TCHTOILL(llnum);
+  memcpy(hbuf + HDBAPRELOFF, &llnum, sizeof(llnum));
 }
 
 
@@ -2028,6 +3720,29 @@ static void tchdbloadmeta(TCHDB *hdb, const char *hbuf){
   hdb->fsiz = TCITOHLL(llnum);
   memcpy(&llnum, hbuf + HDBFRECOFF, sizeof(llnum));
   hdb->frec = TCITOHLL(llnum);
+  memcpy(&llnum, hbuf + HDBLHBASEOFF, sizeof(llnum));
+  hdb->lhbase = TCITOHLL(llnum);
+  memcpy(&llnum, hbuf + HDBLHNUMOFF, sizeof(llnum));
+  hdb->lhnum = TCITOHLL(llnum);
+  memcpy(&llnum, hbuf + HDBVLTAILOFF, sizeof(llnum));
+  hdb->vltail = TCITOHLL(llnum);
+  memcpy(&llnum, hbuf + HDBVLDEADOFF, sizeof(llnum));
+  hdb->vldead = TCITOHLL(llnum);
+  memcpy(&(hdb->fwpow), hbuf + HDBFWPOWOFF, sizeof(hdb->fwpow));
+  memcpy(&(hdb->fknum), hbuf + HDBFKNUMOFF, sizeof(hdb->fknum));
+  memcpy(&llnum, hbuf + HDBAPSYNCOFF, sizeof(llnum));
+  hdb->apsync = TCITOHLL(llnum);
+  memcpy(&llnum, hbuf + HDBAPRELOFF, sizeof(llnum));
+  hdb->aprel = TCITOHLL(llnum);
+  if(hdb->fwpow > HDBFWPOWMAX) hdb->fwpow = HDBFWPOWMAX;
+  if(hdb->fknum > HDBFPBITMAX) hdb->fknum = HDBFPBITMAX;
+  hdb->lhmod = 0;
+  if(hdb->lhbase > 0 && hdb->lhnum >= hdb->lhbase && hdb->lhnum <= hdb->bnum){
+    hdb->lhmod = hdb->lhbase;
+    while(hdb->lhmod * 2 <= hdb->lhnum){
+      hdb->lhmod *= 2;
+    }
+  }
 }
 
 
@@ -2037,13 +3752,19 @@ static void tchdbclear(TCHDB *hdb){
   assert(hdb);
   hdb->mmtx = NULL;
   hdb->rmtxs = NULL;
+  hdb->rmtxnum = 0;
   hdb->dmtx = NULL;
   hdb->wmtx = NULL;
+  hdb->gmtx = NULL;
+  hdb->gcnd = NULL;
   hdb->eckey = NULL;
   hdb->rpath = NULL;
   hdb->type = TCDBTHASH;
   hdb->flags = 0;
   hdb->bnum = HDBDEFBNUM;
+  hdb->lhbase = 0;
+  hdb->lhnum = 0;
+  hdb->lhmod = 0;
   hdb->apow = HDBDEFAPOW;
   hdb->fpow = HDBDEFFPOW;
   hdb->opts = 0;
@@ -2058,9 +3779,13 @@ static void tchdbclear(TCHDB *hdb){
   hdb->map = NULL;
   hdb->msiz = 0;
   hdb->xmsiz = HDBDEFXMSIZ;
+  hdb->mopts = 0;
   hdb->xfsiz = 0;
   hdb->ba32 = NULL;
   hdb->ba64 = NULL;
+  hdb->fpa = NULL;
+  hdb->fwpow = 0;
+  hdb->fknum = 0;
   hdb->align = 0;
   hdb->runit = 0;
   hdb->zmode = false;
@@ -2074,6 +3799,7 @@ static void tchdbclear(TCHDB *hdb){
   hdb->drpoff = 0;
   hdb->recc = NULL;
   hdb->rcnum = 0;
+  hdb->rcsiz = 0;
   hdb->enc = NULL;
   hdb->encop = NULL;
   hdb->dec = NULL;
@@ -2087,7 +3813,56 @@ static void tchdbclear(TCHDB *hdb){
   hdb->tran = false;
   hdb->walfd = -1;
   hdb->walend = 0;
+  hdb->snap = NULL;
+  hdb->gcwait = 0;
+  hdb->gcseq = 0;
+  hdb->gcsynced = 0;
+  hdb->gcdone = 0;
+  hdb->gclead = false;
+  hdb->gcwant = false;
+  hdb->gcwaloff = 0;
+  hdb->gcfsiz = 0;
+  hdb->redo = NULL;
+  hdb->rlfd = -1;
+  hdb->rlsiz = 0;
+  hdb->rllim = HDBDEFCKPTSIZ;
+  hdb->dfbps = 0;
+  hdb->dfth = NULL;
+  hdb->dfsnum = 0;
+  hdb->dfbsiz = 0;
+  hdb->dfpnum = 0;
+  hdb->awqnum = 0;
+  hdb->awth = NULL;
+  hdb->vlthres = 0;
+  hdb->vlfd = -1;
+  hdb->vlhead = 0;
+  hdb->vltail = 0;
+  hdb->vldead = 0;
+  hdb->vltran = 0;
+  hdb->vltrandead = 0;
+  hdb->vlgccur = 0;
+  hdb->vlgcend = 0;
+  hdb->vlgcdead = 0;
+  hdb->vlgcnum = 0;
+  hdb->optthnum = 0;
   hdb->dbgfd = -1;
+  hdb->uring = NULL;
+  hdb->iscan = NULL;
+  hdb->wseq = 0;
+  hdb->stats = NULL;
+  hdb->bkup = NULL;
+  hdb->xtcur = 0;
+  hdb->xtnext = 0;
+  hdb->xtidx = NULL;
+  hdb->xtinum = 0;
+  hdb->apsync = 0;
+  hdb->apcur = 0;
+  hdb->apend = 0;
+  hdb->aprel = 0;
+  hdb->pins = NULL;
+  hdb->pinrecs = NULL;
+  hdb->pinid = 0;
+  hdb->pinnum = 0;
   hdb->cnt_writerec = -1;
   hdb->cnt_reuserec = -1;
   hdb->cnt_moverec = -1;
@@ -2152,6 +3927,61 @@ static void tchdbsetflag(TCHDB *hdb, int flag, bool sign){
 }
 
 
+/* Get the padding size of a record placed at the free extent of append-only mode.
+   `hdb' specifies the hash database object.
+   `rsiz' specifies the size of the record without padding.
+   The return value is the padding size, or -1 if the record does not fit the extent.  The rest
+   of the extent must be large enough for a free block. */
+static int32_t tchdbapfit(TCHDB *hdb, uint32_t rsiz){
+  assert(hdb);
+  if(hdb->apend <= hdb->apcur) return -1;
+  int32_t psiz = tchdbpadsize(hdb, hdb->apcur + rsiz);
+  uint64_t noff = hdb->apcur + rsiz + psiz;
+  if(noff > hdb->apend) return -1;
+  if(noff < hdb->apend && hdb->apend - noff < sizeof(uint8_t) + sizeof(uint32_t)) return -1;
+  return psiz;
+}
+
+
+/* Set the end of the records synchronized in append-only mode.
+   `hdb' specifies the hash database object.
+   `off' specifies the offset of the end. */
+static void tchdbsetapsync(TCHDB *hdb, uint64_t off){
+  assert(hdb);
+  hdb->apsync = off;
+  uint64_t llnum = TCHTOILL(off);
+  memcpy(hdb->map + HDBAPSYNCOFF, &llnum, sizeof(llnum));
+}
+
+
+/* Set the offset of the record released in append-only mode.
+   `hdb' specifies the hash database object.
+   `off' specifies the offset of the old record whose region is being made a free block, or 0
+   if no record is being released. */
+static void tchdbsetaprel(TCHDB *hdb, uint64_t off){
+  assert(hdb);
+  hdb->aprel = off;
+  uint64_t llnum = TCHTOILL(off);
+  memcpy(hdb->map + HDBAPRELOFF, &llnum, sizeof(llnum));
+}
+
+
+/* Get the expiration time to be stored from that specified by the caller.
+   `xt' specifies the expiration time.  If it is positive, it is the lifetime in seconds from now.
+   If it is negative, its absolute value is the time in seconds since the epoch.
+   The return value is the expiration time to be stored.  0 means that it never expires. */
+static uint32_t tchdbxtime(int64_t xt){
+  if(xt == 0) return 0;
+  if(xt > UINT32_MAX){
+    xt = UINT32_MAX;
+  } else if(xt < -(int64_t)UINT32_MAX){
+    xt = -(int64_t)UINT32_MAX;
+  }
+  int64_t xtime = (xt > 0) ? (int64_t)time(NULL) + xt : -xt;
+  return (xtime < HDBXTINHERIT) ? xtime : HDBXTINHERIT - 1;
+}
+
+
 /* Get the bucket index of a record.
    `hdb' specifies the hash database object.
    `kbuf' specifies the pointer to the region of the key.
@@ -2160,6 +3990,21 @@ static void tchdbsetflag(TCHDB *hdb, int flag, bool sign){
    The return value is the bucket index. */
 static uint64_t tchdbbidx(TCHDB *hdb, const char *kbuf, int ksiz, uint8_t *hp){
   assert(hdb && kbuf && ksiz >= 0 && hp);
+  return tchdbbidx2(hdb, kbuf, ksiz, hp, hdb->lhnum, hdb->lhmod);
+}
+
+
+/* Get the bucket index of a record with the state of linear hashing specified.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `hp' specifies the pointer to the variable into which the second hash value is assigned.
+   `lhnum' specifies the number of active buckets of linear hashing.
+   `lhmod' specifies the modulus of the current round of linear hashing.
+   The return value is the bucket index. */
+static uint64_t tchdbbidx2(TCHDB *hdb, const char *kbuf, int ksiz, uint8_t *hp,
+                           uint64_t lhnum, uint64_t lhmod){
+  assert(hdb && kbuf && ksiz >= 0 && hp);
   uint64_t idx = 19780211;
   uint32_t hash = 751;
   const char *rp = kbuf + ksiz;
@@ -2168,6 +4013,11 @@ static uint64_t tchdbbidx(TCHDB *hdb, const char *kbuf, int ksiz, uint8_t *hp){
     hash = (hash * 31) ^ *(uint8_t *)--rp;
   }
   *hp = hash;
+  if(lhmod > 0){
+    uint64_t bidx = idx % lhmod;
+    if(bidx < lhnum - lhmod) bidx = idx % (lhmod * 2);
+    return bidx;
+  }
   return idx % hdb->bnum;
 }
 
@@ -2196,45 +4046,125 @@ static void tchdbsetbucket(TCHDB *hdb, uint64_t bidx, uint64_t off){
   if(hdb->ba64){
     uint64_t llnum = off >> hdb->apow;
     if(hdb->tran) tchdbwalwrite(hdb, HDBHEADSIZ + bidx * sizeof(llnum), sizeof(llnum));
+    if(hdb->bkup) tchdbbkmark(hdb, HDBHEADSIZ + bidx * sizeof(llnum), sizeof(llnum));
     hdb->ba64[bidx] = TCHTOILL(llnum);
   } else {
     uint32_t lnum = off >> hdb->apow;
     if(hdb->tran) tchdbwalwrite(hdb, HDBHEADSIZ + bidx * sizeof(lnum), sizeof(lnum));
+    if(hdb->bkup) tchdbbkmark(hdb, HDBHEADSIZ + bidx * sizeof(lnum), sizeof(lnum));
     hdb->ba32[bidx] = TCHTOIL(lnum);
   }
 }
 
 
-/* Load the free block pool from the file.
+/* Get the fingerprint bits of a key.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `wip' specifies the pointer to the variable into which the index of the word in the
+   fingerprint of the bucket is assigned.
+   The return value is the bit mask to be set in the word of the fingerprint. */
+static uint32_t tchdbfpbits(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t *wip){
+  assert(hdb && kbuf && ksiz >= 0 && wip);
+  uint32_t hash = 2166136261U;
+  while(ksiz--){
+    hash = (hash ^ *(uint8_t *)kbuf++) * 16777619U;
+  }
+  *wip = (hdb->fwpow > 0) ? (hash * 2654435761U) >> (32 - hdb->fwpow) : 0;
+  int knum = (hdb->fknum > 0) ? hdb->fknum : HDBFPBITNUM;
+  uint32_t bits = 0;
+  for(int i = 0; i < knum; i++){
+    bits |= 1U << (hash & 0x1f);
+    hash >>= 5;
+  }
+  return bits;
+}
+
+
+/* Check whether a key is surely absent in a bucket by the fingerprint.
+   `hdb' specifies the hash database object.
+   `bidx' specifies the index of the bucket.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   The return value is true if the key is not in the bucket, or false if it may be. */
+static bool tchdbfpmiss(TCHDB *hdb, uint64_t bidx, const char *kbuf, int ksiz){
+  assert(hdb && bidx >= 0 && kbuf && ksiz >= 0);
+  if(!hdb->fpa) return false;
+  uint64_t widx;
+  uint32_t bits = tchdbfpbits(hdb, kbuf, ksiz, &widx);
+  uint32_t lnum = hdb->fpa[(bidx<<hdb->fwpow)+widx];
+  return (TCITOHL(lnum) & bits) != bits;
+}
+
+
+/* Add a key to the fingerprint of a bucket.
+   `hdb' specifies the hash database object.
+   `bidx' specifies the index of the bucket.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key. */
+static void tchdbfpadd(TCHDB *hdb, uint64_t bidx, const char *kbuf, int ksiz){
+  assert(hdb && bidx >= 0 && kbuf && ksiz >= 0);
+  if(!hdb->fpa) return;
+  uint64_t widx;
+  uint32_t bits = tchdbfpbits(hdb, kbuf, ksiz, &widx);
+  uint32_t *wp = hdb->fpa + (bidx << hdb->fwpow) + widx;
+  uint32_t lnum = TCITOHL(*wp);
+  if((lnum & bits) == bits) return;
+  lnum |= bits;
+  if(hdb->tran) tchdbwalwrite(hdb, (char *)wp - hdb->map, sizeof(lnum));
+  if(hdb->bkup) tchdbbkmark(hdb, (char *)wp - hdb->map, sizeof(lnum));
+  *wp = TCHTOIL(lnum);
+}
+
+
+/* Clear the fingerprint of a bucket.
+   `hdb' specifies the hash database object.
+   `bidx' specifies the index of the bucket. */
+static void tchdbfpclear(TCHDB *hdb, uint64_t bidx){
+  assert(hdb && bidx >= 0);
+  if(!hdb->fpa) return;
+  uint32_t *wp = hdb->fpa + (bidx << hdb->fwpow);
+  int wnum = 1 << hdb->fwpow;
+  for(int i = 0; i < wnum; i++){
+    if(wp[i] == 0) continue;
+    if(hdb->tran) tchdbwalwrite(hdb, (char *)wp - hdb->map, sizeof(*wp) * wnum);
+    if(hdb->bkup) tchdbbkmark(hdb, (char *)wp - hdb->map, sizeof(*wp) * wnum);
+    memset(wp, 0, sizeof(*wp) * wnum);
+    break;
+  }
+}
+
+
+/* Save the free block pool into the file.
    The return value is true if successful, else, it is false. */
 static bool tchdbsavefbp(TCHDB *hdb){
   assert(hdb);
   if(hdb->fbpnum > hdb->fbpmax){
     tchdbfbpmerge(hdb);
-  } else if(hdb->fbpnum > 1){
-    tcfbpsortbyoff(hdb->fbpool, hdb->fbpnum);
+    tchdbfbpreduce(hdb, hdb->fbpmax);
   }
   int bsiz = hdb->frec - hdb->msiz;
   char *buf;
   TCMALLOC(buf, bsiz);
   char *wp = buf;
-  HDBFB *cur = hdb->fbpool;
-  HDBFB *end = cur + hdb->fbpnum;
+  HDBFBP *fbp = hdb->fbpool;
   uint64_t base = 0;
   bsiz -= sizeof(HDBFB) + sizeof(uint8_t) + sizeof(uint8_t);
-  while(cur < end && bsiz > 0){
-    uint64_t noff = cur->off >> hdb->apow;
+  int32_t idx = fbp ? tchdbfbpceil(fbp, 1) : -1;
+  while(idx >= 0 && bsiz > 0){
+    HDBFBNODE *node = fbp->nodes + idx;
+    uint64_t noff = node->off >> hdb->apow;
     int step;
     uint64_t llnum = noff - base;
     TCSETVNUMBUF64(step, wp, llnum);
     wp += step;
     bsiz -= step;
-    uint32_t lnum = cur->rsiz >> hdb->apow;
+    uint32_t lnum = node->rsiz >> hdb->apow;
     TCSETVNUMBUF(step, wp, lnum);
     wp += step;
     bsiz -= step;
     base = noff;
-    cur++;
+    idx = tchdbfbpceil(fbp, node->off + 1);
   }
   *(wp++) = '\0';
   *(wp++) = '\0';
@@ -2247,7 +4177,7 @@ static bool tchdbsavefbp(TCHDB *hdb){
 }
 
 
-/* Save the free block pool into the file.
+/* Load the free block pool from the file.
    The return value is true if successful, else, it is false. */
 static bool tchdbloadfbp(TCHDB *hdb){
   int bsiz = hdb->frec - hdb->msiz;
@@ -2258,110 +4188,227 @@ static bool tchdbloadfbp(TCHDB *hdb){
     return false;
   }
   const char *rp = buf;
-  HDBFB *cur = hdb->fbpool;
-  HDBFB *end = cur + hdb->fbpmax * HDBFBPALWRAT;
+  HDBFBP *fbp = hdb->fbpool;
   uint64_t base = 0;
-  while(cur < end && *rp != '\0'){
+  while(hdb->fbpnum < fbp->cap && *rp != '\0'){
     int step;
     uint64_t llnum;
     TCREADVNUMBUF64(rp, llnum, step);
     base += llnum << hdb->apow;
-    cur->off = base;
     rp += step;
     uint32_t lnum;
     TCREADVNUMBUF(rp, lnum, step);
-    cur->rsiz = lnum << hdb->apow;
     rp += step;
-    cur++;
+    if(lnum > 0) tchdbfbpadd(hdb, base, lnum << hdb->apow);
   }
-  hdb->fbpnum = cur - (HDBFB *)hdb->fbpool;
   TCFREE(buf);
-  tcfbpsortbyrsiz(hdb->fbpool, hdb->fbpnum);
   return true;
 }
 
 
-/* Sort the free block pool by offset.
-   `fbpool' specifies the free block pool.
-   `fbpnum' specifies the number of blocks. */
-static void tcfbpsortbyoff(HDBFB *fbpool, int fbpnum){
-  assert(fbpool && fbpnum >= 0);
-  fbpnum--;
-  int bottom = fbpnum / 2 + 1;
-  int top = fbpnum;
-  while(bottom > 0){
-    bottom--;
-    int mybot = bottom;
-    int i = mybot * 2;
-    while(i <= top){
-      if(i < top && fbpool[i+1].off > fbpool[i].off) i++;
-      if(fbpool[mybot].off >= fbpool[i].off) break;
-      HDBFB swap = fbpool[mybot];
-      fbpool[mybot] = fbpool[i];
-      fbpool[i] = swap;
-      mybot = i;
-      i = mybot * 2;
-    }
-  }
-  while(top > 0){
-    HDBFB swap = fbpool[0];
-    fbpool[0] = fbpool[top];
-    fbpool[top] = swap;
-    top--;
-    int mybot = bottom;
-    int i = mybot * 2;
-    while(i <= top){
-      if(i < top && fbpool[i+1].off > fbpool[i].off) i++;
-      if(fbpool[mybot].off >= fbpool[i].off) break;
-      swap = fbpool[mybot];
-      fbpool[mybot] = fbpool[i];
-      fbpool[i] = swap;
-      mybot = i;
-      i = mybot * 2;
-    }
-  }
-}
-
-
-/* Sort the free block pool by record size.
-   `fbpool' specifies the free block pool.
-   `fbpnum' specifies the number of blocks. */
-static void tcfbpsortbyrsiz(HDBFB *fbpool, int fbpnum){
-  assert(fbpool && fbpnum >= 0);
-  fbpnum--;
-  int bottom = fbpnum / 2 + 1;
-  int top = fbpnum;
-  while(bottom > 0){
-    bottom--;
-    int mybot = bottom;
-    int i = mybot * 2;
-    while(i <= top){
-      if(i < top && fbpool[i+1].rsiz > fbpool[i].rsiz) i++;
-      if(fbpool[mybot].rsiz >= fbpool[i].rsiz) break;
-      HDBFB swap = fbpool[mybot];
-      fbpool[mybot] = fbpool[i];
-      fbpool[i] = swap;
-      mybot = i;
-      i = mybot * 2;
-    }
-  }
-  while(top > 0){
-    HDBFB swap = fbpool[0];
-    fbpool[0] = fbpool[top];
-    fbpool[top] = swap;
-    top--;
-    int mybot = bottom;
-    int i = mybot * 2;
-    while(i <= top){
-      if(i < top && fbpool[i+1].rsiz > fbpool[i].rsiz) i++;
-      if(fbpool[mybot].rsiz >= fbpool[i].rsiz) break;
-      swap = fbpool[mybot];
-      fbpool[mybot] = fbpool[i];
-      fbpool[i] = swap;
-      mybot = i;
-      i = mybot * 2;
+/* Create the free block pool.
+   `cap' specifies the maximum number of blocks.
+   The return value is the new free block pool. */
+static HDBFBP *tchdbfbpnew(int32_t cap){
+  assert(cap > 0);
+  HDBFBP *fbp;
+  TCMALLOC(fbp, sizeof(*fbp));
+  TCMALLOC(fbp->nodes, cap * sizeof(*fbp->nodes));
+  fbp->cap = cap;
+  tchdbfbpreset(fbp);
+  return fbp;
+}
+
+
+/* Delete the free block pool.
+   `fbp' specifies the free block pool. */
+static void tchdbfbpdel(HDBFBP *fbp){
+  assert(fbp);
+  TCFREE(fbp->nodes);
+  TCFREE(fbp);
+}
+
+
+/* Remove all blocks of the free block pool.
+   `fbp' specifies the free block pool. */
+static void tchdbfbpreset(HDBFBP *fbp){
+  assert(fbp);
+  fbp->used = 0;
+  fbp->free = -1;
+  fbp->root[HDBFBPSIZE] = -1;
+  fbp->root[HDBFBPOFF] = -1;
+}
+
+
+/* Compare two nodes of the free block pool in an index.
+   `fbp' specifies the free block pool.
+   `aidx' specifies the index of one node.
+   `bidx' specifies the index of the other node.
+   `tree' specifies the kind of the index: `HDBFBPSIZE' or `HDBFBPOFF'.
+   The return value is positive if the former is big, negative if the latter is big, 0 if both
+   are equivalent. */
+static int tchdbfbpcmp(HDBFBP *fbp, int32_t aidx, int32_t bidx, int tree){
+  assert(fbp && aidx >= 0 && bidx >= 0);
+  HDBFBNODE *anode = fbp->nodes + aidx;
+  HDBFBNODE *bnode = fbp->nodes + bidx;
+  if(tree == HDBFBPSIZE && anode->rsiz != bnode->rsiz) return (anode->rsiz < bnode->rsiz) ? -1 : 1;
+  if(anode->off != bnode->off) return (anode->off < bnode->off) ? -1 : 1;
+  return 0;
+}
+
+
+/* Insert a node into an index of the free block pool.
+   `fbp' specifies the free block pool.
+   `root' specifies the index of the root node of the subtree.
+   `idx' specifies the index of the node to be inserted.
+   `tree' specifies the kind of the index.
+   The return value is the index of the new root node of the subtree. */
+static int32_t tchdbfbpinsnode(HDBFBP *fbp, int32_t root, int32_t idx, int tree){
+  assert(fbp && idx >= 0);
+  HDBFBNODE *nodes = fbp->nodes;
+  if(root < 0){
+    nodes[idx].child[tree][0] = -1;
+    nodes[idx].child[tree][1] = -1;
+    return idx;
+  }
+  int dir = tchdbfbpcmp(fbp, idx, root, tree) < 0 ? 0 : 1;
+  int32_t sub = tchdbfbpinsnode(fbp, nodes[root].child[tree][dir], idx, tree);
+  nodes[root].child[tree][dir] = sub;
+  if(HDBFBPPRIO(nodes[sub].off) > HDBFBPPRIO(nodes[root].off)){
+    nodes[root].child[tree][dir] = nodes[sub].child[tree][!dir];
+    nodes[sub].child[tree][!dir] = root;
+    return sub;
+  }
+  return root;
+}
+
+
+/* Join two subtrees of an index of the free block pool.
+   `fbp' specifies the free block pool.
+   `left' specifies the index of the root node of the subtree of smaller nodes.
+   `right' specifies the index of the root node of the subtree of bigger nodes.
+   `tree' specifies the kind of the index.
+   The return value is the index of the root node of the joined subtree. */
+static int32_t tchdbfbpjoinnode(HDBFBP *fbp, int32_t left, int32_t right, int tree){
+  assert(fbp);
+  HDBFBNODE *nodes = fbp->nodes;
+  if(left < 0) return right;
+  if(right < 0) return left;
+  if(HDBFBPPRIO(nodes[left].off) > HDBFBPPRIO(nodes[right].off)){
+    nodes[left].child[tree][1] = tchdbfbpjoinnode(fbp, nodes[left].child[tree][1], right, tree);
+    return left;
+  }
+  nodes[right].child[tree][0] = tchdbfbpjoinnode(fbp, left, nodes[right].child[tree][0], tree);
+  return right;
+}
+
+
+/* Remove a node from an index of the free block pool.
+   `fbp' specifies the free block pool.
+   `root' specifies the index of the root node of the subtree.
+   `idx' specifies the index of the node to be removed.
+   `tree' specifies the kind of the index.
+   The return value is the index of the new root node of the subtree. */
+static int32_t tchdbfbpoutnode(HDBFBP *fbp, int32_t root, int32_t idx, int tree){
+  assert(fbp && idx >= 0);
+  HDBFBNODE *nodes = fbp->nodes;
+  if(root < 0) return -1;
+  if(root == idx)
+    return tchdbfbpjoinnode(fbp, nodes[root].child[tree][0], nodes[root].child[tree][1], tree);
+  int dir = tchdbfbpcmp(fbp, idx, root, tree) < 0 ? 0 : 1;
+  nodes[root].child[tree][dir] = tchdbfbpoutnode(fbp, nodes[root].child[tree][dir], idx, tree);
+  return root;
+}
+
+
+/* Get the node of the smallest block not smaller than a size in the free block pool.
+   `fbp' specifies the free block pool.
+   `rsiz' specifies the size.
+   The return value is the index of the corresponding node or -1 if no node corresponds. */
+static int32_t tchdbfbpbestfit(HDBFBP *fbp, uint32_t rsiz){
+  assert(fbp);
+  HDBFBNODE *nodes = fbp->nodes;
+  int32_t cand = -1;
+  int32_t cur = fbp->root[HDBFBPSIZE];
+  while(cur >= 0){
+    if(nodes[cur].rsiz >= rsiz){
+      cand = cur;
+      cur = nodes[cur].child[HDBFBPSIZE][0];
+    } else {
+      cur = nodes[cur].child[HDBFBPSIZE][1];
+    }
+  }
+  return cand;
+}
+
+
+/* Get the node of the first block at or after an offset in the free block pool.
+   `fbp' specifies the free block pool.
+   `off' specifies the offset.
+   The return value is the index of the corresponding node or -1 if no node corresponds. */
+static int32_t tchdbfbpceil(HDBFBP *fbp, uint64_t off){
+  assert(fbp);
+  HDBFBNODE *nodes = fbp->nodes;
+  int32_t cand = -1;
+  int32_t cur = fbp->root[HDBFBPOFF];
+  while(cur >= 0){
+    if(nodes[cur].off >= off){
+      if(nodes[cur].off == off) return cur;
+      cand = cur;
+      cur = nodes[cur].child[HDBFBPOFF][0];
+    } else {
+      cur = nodes[cur].child[HDBFBPOFF][1];
     }
   }
+  return cand;
+}
+
+
+/* Add a block to the free block pool.
+   `hdb' specifies the hash database object.
+   `off' specifies the offset of the block.
+   `rsiz' specifies the size of the block. */
+static void tchdbfbpadd(TCHDB *hdb, uint64_t off, uint32_t rsiz){
+  assert(hdb && off > 0 && rsiz > 0);
+  HDBFBP *fbp = hdb->fbpool;
+  int32_t idx = tchdbfbpceil(fbp, off);
+  if(idx >= 0 && fbp->nodes[idx].off == off) tchdbfbpout(hdb, idx);
+  if(fbp->free < 0 && fbp->used >= fbp->cap) tchdbfbpreduce(hdb, hdb->fbpnum - 1);
+  if(fbp->free >= 0){
+    idx = fbp->free;
+    fbp->free = fbp->nodes[idx].child[HDBFBPSIZE][0];
+  } else {
+    idx = fbp->used++;
+  }
+  HDBFBNODE *node = fbp->nodes + idx;
+  node->off = off;
+  node->rsiz = rsiz;
+  fbp->root[HDBFBPSIZE] = tchdbfbpinsnode(fbp, fbp->root[HDBFBPSIZE], idx, HDBFBPSIZE);
+  fbp->root[HDBFBPOFF] = tchdbfbpinsnode(fbp, fbp->root[HDBFBPOFF], idx, HDBFBPOFF);
+  hdb->fbpnum++;
+}
+
+
+/* Remove a block from the free block pool.
+   `hdb' specifies the hash database object.
+   `idx' specifies the index of the node of the block. */
+static void tchdbfbpout(TCHDB *hdb, int32_t idx){
+  assert(hdb && idx >= 0);
+  HDBFBP *fbp = hdb->fbpool;
+  fbp->root[HDBFBPSIZE] = tchdbfbpoutnode(fbp, fbp->root[HDBFBPSIZE], idx, HDBFBPSIZE);
+  fbp->root[HDBFBPOFF] = tchdbfbpoutnode(fbp, fbp->root[HDBFBPOFF], idx, HDBFBPOFF);
+  fbp->nodes[idx].child[HDBFBPSIZE][0] = fbp->free;
+  fbp->free = idx;
+  hdb->fbpnum--;
+}
+
+
+/* Clear the free block pool.
+   `hdb' specifies the hash database object. */
+static void tchdbfbpclear(TCHDB *hdb){
+  assert(hdb);
+  if(hdb->fbpool) tchdbfbpreset(hdb->fbpool);
+  hdb->fbpnum = 0;
 }
 
 
@@ -2370,29 +4417,49 @@ static void tcfbpsortbyrsiz(HDBFB *fbpool, int fbpnum){
 static void tchdbfbpmerge(TCHDB *hdb){
   assert(hdb);
   TCDODEBUG(hdb->cnt_mergefbp++);
-  tcfbpsortbyoff(hdb->fbpool, hdb->fbpnum);
-  HDBFB *wp = hdb->fbpool;
-  HDBFB *cur = wp;
-  HDBFB *end = wp + hdb->fbpnum - 1;
-  while(cur < end){
-    if(cur->off > 0){
-      HDBFB *next = cur + 1;
-      if(cur->off + cur->rsiz == next->off && cur->rsiz + next->rsiz <= HDBFBMAXSIZ){
-        if(hdb->dfcur == next->off) hdb->dfcur += next->rsiz;
-        if(hdb->iter == next->off) hdb->iter += next->rsiz;
-        cur->rsiz += next->rsiz;
-        next->off = 0;
-      }
-      *(wp++) = *cur;
+  HDBFBP *fbp = hdb->fbpool;
+  HDBFBNODE *nodes = fbp->nodes;
+  int32_t idx = (hdb->fbpnum > 1) ? tchdbfbpceil(fbp, 1) : -1;
+  while(idx >= 0){
+    uint64_t off = nodes[idx].off;
+    uint64_t rsiz = nodes[idx].rsiz;
+    int32_t next;
+    while((next = tchdbfbpceil(fbp, off + rsiz)) >= 0 && nodes[next].off == off + rsiz &&
+          rsiz + nodes[next].rsiz <= HDBFBMAXSIZ){
+      if(hdb->dfcur == nodes[next].off) hdb->dfcur += nodes[next].rsiz;
+      if(hdb->xtcur == nodes[next].off) hdb->xtcur += nodes[next].rsiz;
+      if(hdb->apsync == nodes[next].off) tchdbsetapsync(hdb, hdb->apsync + nodes[next].rsiz);
+      if(hdb->vlgccur == nodes[next].off) hdb->vlgccur += nodes[next].rsiz;
+      if(hdb->iter == nodes[next].off) hdb->iter += nodes[next].rsiz;
+      rsiz += nodes[next].rsiz;
+      tchdbfbpout(hdb, next);
     }
-    cur++;
+    if(rsiz != nodes[idx].rsiz){
+      tchdbfbpout(hdb, idx);
+      tchdbfbpadd(hdb, off, rsiz);
+    }
+    idx = tchdbfbpceil(fbp, off + rsiz);
   }
-  if(end->off > 0) *(wp++) = *end;
-  hdb->fbpnum = wp - (HDBFB *)hdb->fbpool;
   hdb->fbpmis = hdb->fbpnum * -1;
 }
 
 
+/* Reduce the free block pool by removing the smallest blocks.
+   `hdb' specifies the hash database object.
+   `max' specifies the maximum number of blocks to be kept. */
+static void tchdbfbpreduce(TCHDB *hdb, int32_t max){
+  assert(hdb && max >= 0);
+  if(hdb->fbpnum <= max) return;
+  TCDODEBUG(hdb->cnt_reducefbp++);
+  HDBFBP *fbp = hdb->fbpool;
+  while(hdb->fbpnum > max){
+    int32_t idx = tchdbfbpbestfit(fbp, 0);
+    if(idx < 0) break;
+    tchdbfbpout(hdb, idx);
+  }
+}
+
+
 /* Insert a block into the free block pool.
    `hdb' specifies the hash database object.
    `off' specifies the offset of the block.
@@ -2402,45 +4469,12 @@ static void tchdbfbpinsert(TCHDB *hdb, uint64_t off, uint32_t rsiz){
   TCDODEBUG(hdb->cnt_insertfbp++);
   hdb->dfcnt++;
   if(hdb->fpow < 1) return;
-  HDBFB *pv = hdb->fbpool;
   if(hdb->fbpnum >= hdb->fbpmax * HDBFBPALWRAT){
     tchdbfbpmerge(hdb);
-    tcfbpsortbyrsiz(hdb->fbpool, hdb->fbpnum);
-    int diff = hdb->fbpnum - hdb->fbpmax;
-    if(diff > 0){
-      TCDODEBUG(hdb->cnt_reducefbp++);
-      memmove(pv, pv + diff, (hdb->fbpnum - diff) * sizeof(*pv));
-      hdb->fbpnum -= diff;
-    }
+    tchdbfbpreduce(hdb, hdb->fbpmax);
     hdb->fbpmis = 0;
   }
-  int num = hdb->fbpnum;
-  int left = 0;
-  int right = num;
-  int i = (left + right) / 2;
-  int cand = -1;
-  while(right >= left && i < num){
-    int rv = (int)rsiz - (int)pv[i].rsiz;
-    if(rv == 0){
-      cand = i;
-      break;
-    } else if(rv <= 0){
-      cand = i;
-      right = i - 1;
-    } else {
-      left = i + 1;
-    }
-    i = (left + right) / 2;
-  }
-  if(cand >= 0){
-    pv += cand;
-    memmove(pv + 1, pv, sizeof(*pv) * (num - cand));
-  } else {
-    pv += num;
-  }
-  pv->off = off;
-  pv->rsiz = rsiz;
-  hdb->fbpnum++;
+  tchdbfbpadd(hdb, off, rsiz);
 }
 
 
@@ -2451,58 +4485,37 @@ static void tchdbfbpinsert(TCHDB *hdb, uint64_t off, uint32_t rsiz){
 static bool tchdbfbpsearch(TCHDB *hdb, TCHREC *rec){
   assert(hdb && rec);
   TCDODEBUG(hdb->cnt_searchfbp++);
-  if(hdb->fbpnum < 1){
+  if(hdb->fbpnum < 1 || (hdb->omode & HDBOAPPEND)){
     rec->off = hdb->fsiz;
     rec->rsiz = 0;
     return true;
   }
   uint32_t rsiz = rec->rsiz;
-  HDBFB *pv = hdb->fbpool;
-  int num = hdb->fbpnum;
-  int left = 0;
-  int right = num;
-  int i = (left + right) / 2;
-  int cand = -1;
-  while(right >= left && i < num){
-    int rv = (int)rsiz - (int)pv[i].rsiz;
-    if(rv == 0){
-      cand = i;
-      break;
-    } else if(rv <= 0){
-      cand = i;
-      right = i - 1;
-    } else {
-      left = i + 1;
-    }
-    i = (left + right) / 2;
-  }
-  if(cand >= 0){
-    pv += cand;
-    if(pv->rsiz > rsiz * 2){
-      uint32_t psiz = tchdbpadsize(hdb, pv->off + rsiz);
-      uint64_t noff = pv->off + rsiz + psiz;
-      if(pv->rsiz >= (noff - pv->off) * 2){
+  int32_t idx = tchdbfbpbestfit(hdb->fbpool, rsiz);
+  if(idx >= 0){
+    HDBFBNODE *node = ((HDBFBP *)hdb->fbpool)->nodes + idx;
+    uint64_t off = node->off;
+    uint32_t fbsiz = node->rsiz;
+    tchdbfbpout(hdb, idx);
+    if(fbsiz > rsiz * 2){
+      uint32_t psiz = tchdbpadsize(hdb, off + rsiz);
+      uint64_t noff = off + rsiz + psiz;
+      if(fbsiz >= (noff - off) * 2){
         TCDODEBUG(hdb->cnt_dividefbp++);
-        rec->off = pv->off;
-        rec->rsiz = noff - pv->off;
-        pv->off = noff;
-        pv->rsiz -= rec->rsiz;
-        return tchdbwritefb(hdb, pv->off, pv->rsiz);
+        rec->off = off;
+        rec->rsiz = noff - off;
+        tchdbfbpadd(hdb, noff, fbsiz - rec->rsiz);
+        return tchdbwritefb(hdb, noff, fbsiz - rec->rsiz);
       }
     }
-    rec->off = pv->off;
-    rec->rsiz = pv->rsiz;
-    memmove(pv, pv + 1, sizeof(*pv) * (num - cand - 1));
-    hdb->fbpnum--;
+    rec->off = off;
+    rec->rsiz = fbsiz;
     return true;
   }
   rec->off = hdb->fsiz;
   rec->rsiz = 0;
   hdb->fbpmis++;
-  if(hdb->fbpmis >= HDBFBPMGFREQ){
-    tchdbfbpmerge(hdb);
-    tcfbpsortbyrsiz(hdb->fbpool, hdb->fbpnum);
-  }
+  if(hdb->fbpmis >= HDBFBPMGFREQ) tchdbfbpmerge(hdb);
   return true;
 }
 
@@ -2520,20 +4533,18 @@ static bool tchdbfbpsplice(TCHDB *hdb, TCHREC *rec, uint32_t nsiz){
     uint32_t rsiz = rec->rsiz;
     uint8_t magic;
     if(tchdbseekreadtry(hdb, off, &magic, sizeof(magic)) && magic != HDBMAGICFB) return false;
-    HDBFB *pv = hdb->fbpool;
-    HDBFB *ep = pv + hdb->fbpnum;
-    while(pv < ep){
-      if(pv->off == off && rsiz + pv->rsiz >= nsiz){
-        if(hdb->dfcur == pv->off) hdb->dfcur += pv->rsiz;
-        if(hdb->iter == pv->off) hdb->iter += pv->rsiz;
-        rec->rsiz += pv->rsiz;
-        memmove(pv, pv + 1, sizeof(*pv) * ((ep - pv) - 1));
-        hdb->fbpnum--;
-        return true;
-      }
-      pv++;
-    }
-    return false;
+    HDBFBP *fbp = hdb->fbpool;
+    int32_t idx = tchdbfbpceil(fbp, off);
+    if(idx < 0 || fbp->nodes[idx].off != off) return false;
+    uint32_t fbsiz = fbp->nodes[idx].rsiz;
+    if(rsiz + fbsiz < nsiz) return false;
+    if(hdb->dfcur == off) hdb->dfcur += fbsiz;
+    if(hdb->xtcur == off) hdb->xtcur += fbsiz;
+    if(hdb->vlgccur == off) hdb->vlgccur += fbsiz;
+    if(hdb->iter == off) hdb->iter += fbsiz;
+    rec->rsiz += fbsiz;
+    tchdbfbpout(hdb, idx);
+    return true;
   }
   uint64_t off = rec->off + rec->rsiz;
   TCHREC nrec;
@@ -2543,21 +4554,15 @@ static bool tchdbfbpsplice(TCHDB *hdb, TCHREC *rec, uint32_t nsiz){
     if(!tchdbreadrec(hdb, &nrec, nbuf)) return false;
     if(nrec.magic != HDBMAGICFB) break;
     if(hdb->dfcur == off) hdb->dfcur += nrec.rsiz;
+    if(hdb->xtcur == off) hdb->xtcur += nrec.rsiz;
+    if(hdb->vlgccur == off) hdb->vlgccur += nrec.rsiz;
     if(hdb->iter == off) hdb->iter += nrec.rsiz;
     off += nrec.rsiz;
   }
   uint32_t jsiz = off - rec->off;
   if(jsiz < nsiz) return false;
   rec->rsiz = jsiz;
-  uint64_t base = rec->off;
-  HDBFB *wp = hdb->fbpool;
-  HDBFB *cur = wp;
-  HDBFB *end = wp + hdb->fbpnum;
-  while(cur < end){
-    if(cur->off < base || cur->off > off) *(wp++) = *cur;
-    cur++;
-  }
-  hdb->fbpnum = wp - (HDBFB *)hdb->fbpool;
+  if(hdb->fbpnum > 0) tchdbfbpoutrange(hdb, rec->off, off + 1);
   if(jsiz > nsiz * 2){
     uint32_t psiz = tchdbpadsize(hdb, rec->off + nsiz);
     uint64_t noff = rec->off + nsiz + psiz;
@@ -2573,6 +4578,20 @@ static bool tchdbfbpsplice(TCHDB *hdb, TCHREC *rec, uint32_t nsiz){
 }
 
 
+/* Remove blocks of a range of offsets from the free block pool.
+   `hdb' specifies the hash database object.
+   `lower' specifies the lower offset of the range.
+   `upper' specifies the upper offset of the range, which is not included. */
+static void tchdbfbpoutrange(TCHDB *hdb, uint64_t lower, uint64_t upper){
+  assert(hdb);
+  HDBFBP *fbp = hdb->fbpool;
+  int32_t idx;
+  while((idx = tchdbfbpceil(fbp, lower)) >= 0 && fbp->nodes[idx].off < upper){
+    tchdbfbpout(hdb, idx);
+  }
+}
+
+
 /* Remove blocks of a region from the free block pool.
    `hdb' specifies the hash database object.
    `base' specifies the base offset of the region.
@@ -2582,39 +4601,12 @@ static bool tchdbfbpsplice(TCHDB *hdb, TCHREC *rec, uint32_t nsiz){
 static void tchdbfbptrim(TCHDB *hdb, uint64_t base, uint64_t next, uint64_t off, uint32_t rsiz){
   assert(hdb && base > 0 && next > 0);
   if(hdb->fpow < 1) return;
-  if(hdb->fbpnum < 1){
-    if(off > 0){
-      HDBFB *fbpool = hdb->fbpool;
-      fbpool->off = off;
-      fbpool->rsiz = rsiz;
-      hdb->fbpnum = 1;
-    }
-    return;
-  }
-  HDBFB *wp = hdb->fbpool;
-  HDBFB *cur = wp;
-  HDBFB *end = wp + hdb->fbpnum;
-  if(hdb->fbpnum >= hdb->fbpmax * HDBFBPALWRAT) cur++;
-  while(cur < end){
-    if(cur->rsiz >= rsiz && off > 0){
-      TCDODEBUG(hdb->cnt_insertfbp++);
-      wp->off = off;
-      wp->rsiz = rsiz;
-      wp++;
-      off = 0;
-    } else if(cur->off < base || cur->off >= next){
-      *(wp++) = *cur;
-    }
-    cur++;
-  }
+  if(hdb->fbpnum > 0) tchdbfbpoutrange(hdb, base, next);
   if(off > 0){
+    if(hdb->fbpnum >= hdb->fbpmax * HDBFBPALWRAT) tchdbfbpreduce(hdb, hdb->fbpnum - 1);
     TCDODEBUG(hdb->cnt_insertfbp++);
-    wp->off = off;
-    wp->rsiz = rsiz;
-    wp++;
-    off = 0;
+    tchdbfbpadd(hdb, off, rsiz);
   }
-  hdb->fbpnum = wp - (HDBFB *)hdb->fbpool;
 }
 
 
@@ -2641,7 +4633,9 @@ static bool tchdbwritefb(TCHDB *hdb, uint64_t off, uint32_t rsiz){
    `rec' specifies the record object.
    `bidx' specifies the index of the bucket.
    `entoff' specifies the offset of the tree entry.
-   The return value is true if successful, else, it is false. */
+   The return value is true if successful, else, it is false.
+   A new record is written into the free extent of append-only mode if it fits there, else at the
+   end of the file.  The rest of the extent is made a free block before the record is written. */
 static bool tchdbwriterec(TCHDB *hdb, TCHREC *rec, uint64_t bidx, off_t entoff){
   assert(hdb && rec);
   TCDODEBUG(hdb->cnt_writerec++);
@@ -2654,7 +4648,11 @@ static bool tchdbwriterec(TCHDB *hdb, TCHREC *rec, uint64_t bidx, off_t entoff){
     TCMALLOC(rbuf, bsiz);
   }
   char *wp = rbuf;
-  *(uint8_t *)(wp++) = HDBMAGICREC;
+  if(rec->xtime > 0){
+    *(uint8_t *)(wp++) = rec->vlog ? HDBMAGICXVLREC : HDBMAGICXREC;
+  } else {
+    *(uint8_t *)(wp++) = rec->vlog ? HDBMAGICVLREC : HDBMAGICREC;
+  }
   *(uint8_t *)(wp++) = rec->hash;
   if(hdb->ba64){
     uint64_t llnum;
@@ -2680,6 +4678,11 @@ static bool tchdbwriterec(TCHDB *hdb, TCHREC *rec, uint64_t bidx, off_t entoff){
   uint16_t snum;
   char *pwp = wp;
   wp += sizeof(snum);
+  if(rec->xtime > 0){
+    uint32_t lnum = TCHTOIL(rec->xtime);
+    memcpy(wp, &lnum, sizeof(lnum));
+    wp += sizeof(lnum);
+  }
   int step;
   TCSETVNUMBUF(step, wp, rec->ksiz);
   wp += step;
@@ -2689,10 +4692,21 @@ static bool tchdbwriterec(TCHDB *hdb, TCHREC *rec, uint64_t bidx, off_t entoff){
   int32_t rsiz = hsiz + rec->ksiz + rec->vsiz;
   int32_t finc = 0;
   if(rec->rsiz < 1){
-    uint16_t psiz = tchdbpadsize(hdb, hdb->fsiz + rsiz);
+    int32_t psiz = tchdbapfit(hdb, rsiz);
+    if(psiz >= 0){
+      uint64_t noff = hdb->apcur + rsiz + psiz;
+      if(noff < hdb->apend && !tchdbwritefb(hdb, noff, hdb->apend - noff)){
+        if(rbuf != stack) TCFREE(rbuf);
+        return false;
+      }
+      rec->off = hdb->apcur;
+      hdb->apcur = noff;
+    } else {
+      psiz = tchdbpadsize(hdb, hdb->fsiz + rsiz);
+      finc = rsiz + psiz;
+    }
     rec->rsiz = rsiz + psiz;
     rec->psiz = psiz;
-    finc = rec->rsiz;
   } else if(rsiz > rec->rsiz){
     if(rbuf != stack) TCFREE(rbuf);
     if(!HDBLOCKDB(hdb)) return false;
@@ -2762,6 +4776,8 @@ static bool tchdbwriterec(TCHDB *hdb, TCHREC *rec, uint64_t bidx, off_t entoff){
     memcpy(hdb->map + HDBFSIZOFF, &llnum, sizeof(llnum));
   }
   if(rbuf != stack) TCFREE(rbuf);
+  tchdbfpadd(hdb, bidx, rec->kbuf, rec->ksiz);
+  if(rec->xtime > 0) tchdbxtindex(hdb, rec->off, rec->xtime);
   if(entoff > 0){
     if(hdb->ba64){
       uint64_t llnum = rec->off >> hdb->apow;
@@ -2779,6 +4795,43 @@ static bool tchdbwriterec(TCHDB *hdb, TCHREC *rec, uint64_t bidx, off_t entoff){
 }
 
 
+/* Write a record which has been stored into the file.
+   `hdb' specifies the hash database object.
+   `rec' specifies the record object read from the file.
+   `bidx' specifies the index of the bucket.
+   `entoff' specifies the offset of the tree entry.
+   The return value is true if successful, else, it is false.
+   In append-only mode, the record is written as a new one and the region of the old record is
+   made a free block only after the tree refers to the new one.  The offset of the old record is
+   kept in the header meanwhile, so that recovery after a crash releases it.  A pinned record is
+   also written as a new one, and the region of the old one is not put into the free block
+   pool. */
+static bool tchdbrewriterec(TCHDB *hdb, TCHREC *rec, uint64_t bidx, off_t entoff){
+  assert(hdb && rec);
+  bool pinned = tchdbpinned(hdb, rec->off);
+  if(!(hdb->omode & HDBOAPPEND) && !pinned) return tchdbwriterec(hdb, rec, bidx, entoff);
+  TCDODEBUG(hdb->cnt_moverec++);
+  uint64_t ooff = rec->off;
+  uint32_t orsiz = rec->rsiz;
+  if(!HDBLOCKDB(hdb)) return false;
+  bool append = hdb->omode & HDBOAPPEND;
+  if(append) tchdbsetaprel(hdb, ooff);
+  rec->off = hdb->fsiz;
+  rec->rsiz = 0;
+  bool rv = tchdbwriterec(hdb, rec, bidx, entoff);
+  if(rv){
+    if(tchdbwritefb(hdb, ooff, orsiz)){
+      if(!pinned) tchdbfbpinsert(hdb, ooff, orsiz);
+    } else {
+      rv = false;
+    }
+  }
+  if(append) tchdbsetaprel(hdb, 0);
+  HDBUNLOCKDB(hdb);
+  return rv;
+}
+
+
 /* Read a record from the file.
    `hdb' specifies the hash database object.
    `rec' specifies the record object.
@@ -2804,15 +4857,144 @@ static bool tchdbreadrec(TCHDB *hdb, TCHREC *rec, char *rbuf){
     }
     HDBUNLOCKDB(hdb);
   }
-  const char *rp = rbuf;
-  rec->magic = *(uint8_t *)(rp++);
-  if(rec->magic == HDBMAGICFB){
-    uint32_t lnum;
-    memcpy(&lnum, rp, sizeof(lnum));
-    rec->rsiz = TCITOHL(lnum);
-    return true;
-  } else if(rec->magic != HDBMAGICREC){
-    tchdbsetecode(hdb, TCERHEAD, __FILE__, __LINE__, __func__);
+  return tchdbparserec(hdb, rec, rbuf, rsiz);
+}
+
+
+/* Initialize a reader of sequential scanning.
+   `scan' specifies the reader object. */
+static void tchdbscaninit(HDBSCAN *scan){
+  assert(scan);
+  scan->buf = NULL;
+  scan->off = 0;
+  scan->size = 0;
+  scan->wseq = 0;
+  scan->raend = 0;
+}
+
+
+/* Release the buffer of a reader of sequential scanning.
+   `scan' specifies the reader object. */
+static void tchdbscanclear(HDBSCAN *scan){
+  assert(scan);
+  if(scan->buf) TCFREE(scan->buf);
+  tchdbscaninit(scan);
+}
+
+
+/* Read a record for sequential scanning.
+   `hdb' specifies the hash database object.
+   `scan' specifies the reader object.
+   `rec' specifies the record object.  The member `off' must be specified.
+   `rbuf' specifies the buffer used when the record is not read through the reader.
+   The return value is true if successful, else, it is false.
+   Records beyond the mapped region are parsed out of large chunks read ahead of the cursor, so
+   that the key and the value usually refer to the buffer of the reader.  They are valid until
+   the next call.  Writes overlapping the chunk of the iterator are copied into it, and the chunk
+   is discarded only when the write sequence number changes because the contents are unknown. */
+static bool tchdbscanreadrec(TCHDB *hdb, HDBSCAN *scan, TCHREC *rec, char *rbuf){
+  assert(hdb && scan && rec && rbuf);
+  uint64_t off = rec->off;
+  if(off < hdb->xmsiz || off + hdb->runit > hdb->fsiz) return tchdbreadrec(hdb, rec, rbuf);
+  TCDODEBUG(hdb->cnt_readrec++);
+  if(!scan->buf || scan->wseq != hdb->wseq || off < scan->off ||
+     off + hdb->runit > scan->off + scan->size){
+    if(!tchdbscanfill(hdb, scan, off)) return false;
+  }
+  return tchdbparserec(hdb, rec, scan->buf + (off - scan->off), scan->off + scan->size - off);
+}
+
+
+/* Fill the buffer of a reader of sequential scanning.
+   `hdb' specifies the hash database object.
+   `scan' specifies the reader object.
+   `off' specifies the offset which the chunk should contain.
+   The return value is true if successful, else, it is false. */
+static bool tchdbscanfill(TCHDB *hdb, HDBSCAN *scan, uint64_t off){
+  assert(hdb && scan);
+  if(!scan->buf) TCMALLOC(scan->buf, HDBSCANSIZ);
+  uint64_t boff = off & ~((uint64_t)HDBSCANALIGN - 1);
+  int32_t size = tclmin(HDBSCANSIZ, hdb->fsiz - boff);
+  scan->size = 0;
+  scan->wseq = hdb->wseq;
+  if(!tchdbseekread(hdb, boff, scan->buf, size)) return false;
+  scan->off = boff;
+  scan->size = size;
+#if defined(POSIX_FADV_WILLNEED)
+  uint64_t end = boff + size;
+  if(scan->raend < end + HDBSCANSIZ && end < hdb->fsiz){
+    uint64_t rabeg = tclmax(end, scan->raend);
+    uint64_t raend = tclmin(end + HDBSCANRASIZ, hdb->fsiz);
+    if(raend > rabeg) posix_fadvise(hdb->fd, rabeg, raend - rabeg, POSIX_FADV_WILLNEED);
+    scan->raend = raend;
+  }
+#endif
+  return true;
+}
+
+
+/* Copy data written beyond the mapped region into the chunk of the reader of the iterator.
+   `hdb' specifies the hash database object.
+   `off' specifies the offset of the region written.
+   `buf' specifies the buffer of the data.
+   `size' specifies the size of the buffer.
+   The iterator holds the exclusive method lock while it uses its reader, so writers which hold
+   the shared lock never race with it, and only the part overlapping the chunk is copied. */
+static void tchdbscanpatch(TCHDB *hdb, uint64_t off, const void *buf, size_t size){
+  assert(hdb && buf && size >= 0);
+  HDBSCAN *scan = hdb->iscan;
+  if(!scan || scan->size < 1) return;
+  uint64_t beg = tclmax(off, scan->off);
+  uint64_t end = tclmin(off + size, scan->off + scan->size);
+  if(beg >= end) return;
+  memcpy(scan->buf + (beg - scan->off), (char *)buf + (beg - off), end - beg);
+}
+
+
+/* Parse the header of a record read into a buffer.
+   `hdb' specifies the hash database object.
+   `rec' specifies the record object.
+   `rbuf' specifies the buffer holding the beginning of the record.
+   `rsiz' specifies the size of the data in the buffer.
+   The return value is true if successful, else, it is false.
+   The magic number of a data block is normalized to `HDBMAGICREC'.  Only a record which has
+   expired is given `HDBMAGICXREC' so that scans skip it while tree walks still pass it. */
+static bool tchdbparserec(TCHDB *hdb, TCHREC *rec, char *rbuf, int rsiz){
+  assert(hdb && rec && rbuf && rsiz >= 0);
+  if(tchdbparserectry(hdb, rec, rbuf, rsiz)) return true;
+  tchdbsetecode(hdb, TCERHEAD, __FILE__, __LINE__, __func__);
+  return false;
+}
+
+
+/* Parse the header of a record read into a buffer without reporting a broken header.
+   `hdb' specifies the hash database object.
+   `rec' specifies the record object.
+   `rbuf' specifies the buffer holding the beginning of the record.
+   `rsiz' specifies the size of the data in the buffer.
+   The return value is true if successful, else, it is false.  The error code is not set, so that
+   this is used for speculative reads of blocks which may be half written. */
+static bool tchdbparserectry(TCHDB *hdb, TCHREC *rec, char *rbuf, int rsiz){
+  assert(hdb && rec && rbuf && rsiz >= 0);
+  const char *rp = rbuf;
+  rec->magic = *(uint8_t *)(rp++);
+  rec->vlog = false;
+  rec->xtime = 0;
+  bool xt = false;
+  if(rec->magic == HDBMAGICFB){
+    uint32_t lnum;
+    memcpy(&lnum, rp, sizeof(lnum));
+    rec->rsiz = TCITOHL(lnum);
+    return true;
+  } else if(rec->magic == HDBMAGICVLREC){
+    rec->magic = HDBMAGICREC;
+    rec->vlog = true;
+  } else if(rec->magic == HDBMAGICXREC){
+    xt = true;
+  } else if(rec->magic == HDBMAGICXVLREC){
+    rec->vlog = true;
+    xt = true;
+  } else if(rec->magic != HDBMAGICREC){
     return false;
   }
   rec->hash = *(uint8_t *)(rp++);
@@ -2838,6 +5020,12 @@ static bool tchdbreadrec(TCHDB *hdb, TCHREC *rec, char *rbuf){
   rec->psiz = TCITOHS(snum);
   rp += sizeof(snum);
   uint32_t lnum;
+  if(xt){
+    memcpy(&lnum, rp, sizeof(lnum));
+    rec->xtime = TCITOHL(lnum);
+    rp += sizeof(lnum);
+    rec->magic = (rec->xtime > (uint32_t)time(NULL)) ? HDBMAGICREC : HDBMAGICXREC;
+  }
   int step;
   TCREADVNUMBUF(rp, lnum, step);
   rec->ksiz = lnum;
@@ -2877,6 +5065,130 @@ static bool tchdbreadrecbody(TCHDB *hdb, TCHREC *rec){
 }
 
 
+/* Read the value of a record, resolving the reference into the value log.
+   `hdb' specifies the hash database object.
+   `rec' specifies the record object.
+   The return value is true if successful, else, it is false. */
+static bool tchdbreadrecvalue(TCHDB *hdb, TCHREC *rec){
+  assert(hdb && rec);
+  if(!rec->vbuf && !tchdbreadrecbody(hdb, rec)) return false;
+  if(!rec->vlog) return true;
+  uint64_t off;
+  uint32_t vsiz;
+  if(!tchdbvlgetref(hdb, rec, &off, &vsiz)) return false;
+  char *bbuf;
+  TCMALLOC(bbuf, rec->ksiz + vsiz + 1);
+  memcpy(bbuf, rec->kbuf, rec->ksiz);
+  if(!tchdbvlread(hdb, off, bbuf + rec->ksiz, vsiz)){
+    TCFREE(bbuf);
+    return false;
+  }
+  TCFREE(rec->bbuf);
+  rec->bbuf = bbuf;
+  rec->kbuf = bbuf;
+  rec->vbuf = bbuf + rec->ksiz;
+  rec->vsiz = vsiz;
+  rec->vlog = false;
+  return true;
+}
+
+
+/* Get the reference into the value log from a record.
+   `hdb' specifies the hash database object.
+   `rec' specifies the record object whose value has been read.
+   `offp' specifies the pointer to the variable into which the offset of the value is assigned.
+   `sizp' specifies the pointer to the variable into which the size of the value is assigned.
+   The return value is true if successful, else, it is false. */
+static bool tchdbvlgetref(TCHDB *hdb, TCHREC *rec, uint64_t *offp, uint32_t *sizp){
+  assert(hdb && rec && rec->vbuf && offp && sizp);
+  if(rec->vsiz != HDBVLPTRSIZ){
+    tchdbsetecode(hdb, TCERHEAD, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  uint64_t llnum;
+  memcpy(&llnum, rec->vbuf, sizeof(llnum));
+  *offp = TCITOHLL(llnum);
+  uint32_t lnum;
+  memcpy(&lnum, rec->vbuf + sizeof(llnum), sizeof(lnum));
+  *sizp = TCITOHL(lnum);
+  return true;
+}
+
+
+/* Set a reference into the value log.
+   `pbuf' specifies the buffer for the reference.
+   `off' specifies the offset of the value.
+   `vsiz' specifies the size of the value. */
+static void tchdbvlsetref(char *pbuf, uint64_t off, uint32_t vsiz){
+  assert(pbuf);
+  uint64_t llnum = TCHTOILL(off);
+  memcpy(pbuf, &llnum, sizeof(llnum));
+  uint32_t lnum = TCHTOIL(vsiz);
+  memcpy(pbuf + sizeof(llnum), &lnum, sizeof(lnum));
+}
+
+
+/* Move the value of a record into the value log if it is large.
+   `hdb' specifies the hash database object.
+   `rec' specifies the record object.  If the value is appended to the value log, the value of the
+   record is replaced with the reference to it.
+   `pbuf' specifies the buffer for the reference.
+   The return value is true if successful, else, it is false. */
+static bool tchdbvlput(TCHDB *hdb, TCHREC *rec, char *pbuf){
+  assert(hdb && rec && pbuf);
+  rec->vlog = false;
+  if(hdb->vlfd < 0 || hdb->vlthres < 1 || rec->vsiz < hdb->vlthres) return true;
+  uint64_t off = __sync_fetch_and_add(&hdb->vlhead, rec->vsiz);
+  if(!tchdbvlwrite(hdb, off, rec->vbuf, rec->vsiz)) return false;
+  tchdbvlsetref(pbuf, off, rec->vsiz);
+  rec->vbuf = pbuf;
+  rec->vsiz = HDBVLPTRSIZ;
+  rec->vlog = true;
+  return true;
+}
+
+
+/* Get the region of the value log occupied by a record which is to be overwritten or removed.
+   `hdb' specifies the hash database object.
+   `rec' specifies the record object.
+   `offp' specifies the pointer to the variable into which the offset of the value is assigned.
+   `sizp' specifies the pointer to the variable into which the size of the value is assigned.  It
+   is zero if the value is not in the value log.
+   The return value is true if successful, else, it is false. */
+static bool tchdbvlpeek(TCHDB *hdb, TCHREC *rec, uint64_t *offp, uint32_t *sizp){
+  assert(hdb && rec && offp && sizp);
+  *offp = 0;
+  *sizp = 0;
+  if(!rec->vlog) return true;
+  if(!rec->vbuf && !tchdbreadrecbody(hdb, rec)) return false;
+  return tchdbvlgetref(hdb, rec, offp, sizp);
+}
+
+
+/* Account a region of the value log as dead.
+   `hdb' specifies the hash database object.
+   `off' specifies the offset of the region.
+   `vsiz' specifies the size of the region.
+   This function should be called only after the record referring to the region has been
+   overwritten or removed successfully. */
+static void tchdbvlrelease(TCHDB *hdb, uint64_t off, uint32_t vsiz){
+  assert(hdb);
+  if(vsiz < 1) return;
+  if(hdb->vlgccur < 1 || off >= hdb->vlgcend) __sync_fetch_and_add(&hdb->vldead, vsiz);
+}
+
+
+/* Restore the accounting of the value log on aborting the transaction.
+   `hdb' specifies the hash database object.
+   The values released during the transaction are alive again because their records are restored,
+   while the values appended during the transaction are referred to by no record. */
+static void tchdbvltranabort(TCHDB *hdb){
+  assert(hdb);
+  hdb->vldead = hdb->vltrandead;
+  if(hdb->vlhead > hdb->vltran) hdb->vldead += hdb->vlhead - hdb->vltran;
+}
+
+
 /* Remove a record from the file.
    `hdb' specifies the hash database object.
    `rec' specifies the record object.
@@ -2888,7 +5200,7 @@ static bool tchdbremoverec(TCHDB *hdb, TCHREC *rec, char *rbuf, uint64_t bidx, o
   assert(hdb && rec);
   if(!tchdbwritefb(hdb, rec->off, rec->rsiz)) return false;
   if(!HDBLOCKDB(hdb)) return false;
-  tchdbfbpinsert(hdb, rec->off, rec->rsiz);
+  if(!tchdbpinned(hdb, rec->off)) tchdbfbpinsert(hdb, rec->off, rec->rsiz);
   HDBUNLOCKDB(hdb);
   uint64_t child;
   if(rec->left > 0 && rec->right < 1){
@@ -2929,6 +5241,7 @@ static bool tchdbremoverec(TCHDB *hdb, TCHREC *rec, char *rbuf, uint64_t bidx, o
     }
   } else {
     tchdbsetbucket(hdb, bidx, child);
+    if(child < 1) tchdbfpclear(hdb, bidx);
   }
   if(!HDBLOCKDB(hdb)) return false;
   hdb->rnum--;
@@ -2944,18 +5257,25 @@ static bool tchdbremoverec(TCHDB *hdb, TCHREC *rec, char *rbuf, uint64_t bidx, o
    `hdb' specifies the hash database object.
    `rec' specifies the record object.
    `rbuf' specifies the buffer for reading.
-   `destoff' specifies the offset of the destination.
+   `destoff' specifies the offset of the destination.  If it is 0, the record is written as a
+   new one.
    The return value is true if successful, else, it is false. */
 static bool tchdbshiftrec(TCHDB *hdb, TCHREC *rec, char *rbuf, off_t destoff){
   assert(hdb && rec && rbuf && destoff >= 0);
   TCDODEBUG(hdb->cnt_shiftrec++);
   if(!rec->vbuf && !tchdbreadrecbody(hdb, rec)) return false;
+  uint32_t rsiz = rec->rsiz;
+  if(destoff < 1){
+    destoff = hdb->fsiz;
+    rsiz = 0;
+  }
   uint8_t hash;
   uint64_t bidx = tchdbbidx(hdb, rec->kbuf, rec->ksiz, &hash);
   off_t off = tchdbgetbucket(hdb, bidx);
   if(rec->off == off){
     bool err = false;
     rec->off = destoff;
+    rec->rsiz = rsiz;
     if(!tchdbwriterec(hdb, rec, bidx, 0)) err = true;
     TCFREE(rec->bbuf);
     rec->kbuf = NULL;
@@ -3011,6 +5331,7 @@ static bool tchdbshiftrec(TCHDB *hdb, TCHREC *rec, char *rbuf, off_t destoff){
         trec.bbuf = NULL;
         bool err = false;
         rec->off = destoff;
+        rec->rsiz = rsiz;
         rec->kbuf = kbuf;
         rec->ksiz = ksiz;
         rec->vbuf = vbuf;
@@ -3041,6 +5362,35 @@ static int tcreckeycmp(const char *abuf, int asiz, const char *bbuf, int bsiz){
 }
 
 
+/* Compare two probes of batched retrieval by the bucket index and the record offset.
+   `a' specifies the pointer to one probe.
+   `b' specifies the pointer to the other probe.
+   The return value is positive if the former is big, negative if the latter is big, 0 if both
+   are equivalent. */
+static int tchdbprobecmp(const void *a, const void *b){
+  assert(a && b);
+  const HDBPROBE *ap = a;
+  const HDBPROBE *bp = b;
+  if(ap->lidx != bp->lidx) return ap->lidx > bp->lidx ? 1 : -1;
+  if(ap->bidx != bp->bidx) return ap->bidx > bp->bidx ? 1 : -1;
+  return ap->idx - bp->idx;
+}
+
+
+/* Compare two pointers to probes of batched retrieval by the record offset.
+   `a' specifies the pointer to the pointer to one probe.
+   `b' specifies the pointer to the pointer to the other probe.
+   The return value is positive if the former is big, negative if the latter is big, 0 if both
+   are equivalent. */
+static int tchdbprobeoffcmp(const void *a, const void *b){
+  assert(a && b);
+  const HDBPROBE *ap = *(HDBPROBE **)a;
+  const HDBPROBE *bp = *(HDBPROBE **)b;
+  if(ap->off != bp->off) return ap->off > bp->off ? 1 : -1;
+  return ap->idx - bp->idx;
+}
+
+
 /* Flush the delayed record pool.
    `hdb' specifies the hash database object.
    The return value is true if successful, else, it is false. */
@@ -3070,7 +5420,7 @@ static bool tchdbflushdrp(TCHDB *hdb){
     rp += vsiz;
     uint8_t hash;
     uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
-    if(!tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, vbuf, vsiz, HDBPDOVER)){
+    if(!tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, vbuf, vsiz, HDBPDOVER, 0)){
       tcxstrdel(hdb->drpdef);
       tcxstrdel(hdb->drpool);
       hdb->drpool = NULL;
@@ -3098,12 +5448,207 @@ static bool tchdbflushdrp(TCHDB *hdb){
 }
 
 
-/* Adjust the caches for leaves and nodes.
-   `hdb' specifies the hash tree database object. */
-static void tchdbcacheadjust(TCHDB *hdb){
+/* Create the record cache.
+   `rcnum' specifies the maximum number of records.  If it is not more than 0, it is not limited.
+   `rcsiz' specifies the maximum size of records.  If it is not more than 0, it is not limited.
+   `mt' specifies whether the shards are locked.
+   The return value is the new record cache. */
+static HDBRCACHE *tchdbrcnew(int32_t rcnum, int64_t rcsiz, bool mt){
+  HDBRCACHE *rc;
+  TCMALLOC(rc, sizeof(*rc));
+  rc->snum = mt ? HDBRCSHARDNUM : 1;
+  rc->mt = mt;
+  rc->rmax = (rcnum > 0) ? tclmax(rcnum / rc->snum, HDBRCSHARDMIN) : INT32_MAX;
+  rc->smax = (rcsiz > 0) ? tclmax(rcsiz / rc->snum, HDBRCSHARDMIN * HDBRCRECUNIT) : INT64_MAX;
+  uint32_t bnum = (rcnum > 0) ? rc->rmax : rc->smax / HDBRCRECUNIT;
+  bnum = tclmin(tclmax(bnum, HDBRCSHARDMIN), HDBRCBNUMMAX);
+  TCMALLOC(rc->shards, rc->snum * sizeof(*rc->shards));
+  for(int i = 0; i < rc->snum; i++){
+    HDBRCSHARD *shard = rc->shards + i;
+    if(mt && pthread_mutex_init(&shard->mutex, NULL) != 0) tcmyfatal("pthread_mutex_init failed");
+    shard->pmap = tcmapnew2(bnum / HDBRCPROBRAT + 1);
+    shard->gmap = tcmapnew2(bnum / 2 + 1);
+    shard->fmap = tcmapnew2(bnum);
+    shard->psiz = 0;
+    shard->fsiz = 0;
+    shard->hnum = 0;
+    shard->mnum = 0;
+  }
+  return rc;
+}
+
+
+/* Delete the record cache.
+   `rc' specifies the record cache. */
+static void tchdbrcdel(HDBRCACHE *rc){
+  assert(rc);
+  for(int i = rc->snum - 1; i >= 0; i--){
+    HDBRCSHARD *shard = rc->shards + i;
+    tcmapdel(shard->fmap);
+    tcmapdel(shard->gmap);
+    tcmapdel(shard->pmap);
+    if(rc->mt) pthread_mutex_destroy(&shard->mutex);
+  }
+  TCFREE(rc->shards);
+  TCFREE(rc);
+}
+
+
+/* Get the shard of the record cache for a key.
+   `rc' specifies the record cache.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   The return value is the shard which is locked if needed. */
+static HDBRCSHARD *tchdbrcshard(HDBRCACHE *rc, const char *kbuf, int ksiz){
+  assert(rc && kbuf && ksiz >= 0);
+  uint32_t hash = 19780211;
+  const unsigned char *rp = (const unsigned char *)kbuf + ksiz;
+  while(ksiz--){
+    hash = (hash * 33) ^ *(--rp);
+  }
+  HDBRCSHARD *shard = rc->shards + (hash % rc->snum);
+  if(rc->mt && pthread_mutex_lock(&shard->mutex) != 0) tcmyfatal("pthread_mutex_lock failed");
+  return shard;
+}
+
+
+/* Evict records from a shard of the record cache until it fits the limits.
+   `hdb' specifies the hash database object.
+   `shard' specifies the shard. */
+static void tchdbrcshardadjust(TCHDB *hdb, HDBRCSHARD *shard){
+  assert(hdb && shard);
+  HDBRCACHE *rc = hdb->recc;
+  while(true){
+    int64_t pnum = TCMAPRNUM(shard->pmap);
+    int64_t fnum = TCMAPRNUM(shard->fmap);
+    if(pnum + fnum <= rc->rmax && shard->psiz + shard->fsiz <= rc->smax) break;
+    TCDODEBUG(hdb->cnt_adjrecc++);
+    bool prob = pnum > 0 && (fnum < 1 || pnum > rc->rmax / HDBRCPROBRAT ||
+                             shard->psiz > rc->smax / HDBRCPROBRAT);
+    TCMAP *map = prob ? shard->pmap : shard->fmap;
+    tcmapiterinit(map);
+    int ksiz;
+    const char *kbuf = tcmapiternext(map, &ksiz);
+    if(!kbuf) break;
+    int vsiz;
+    tcmapiterval(kbuf, &vsiz);
+    int64_t rsiz = HDBRCRECSIZ(ksiz, vsiz);
+    if(prob){
+      tcmapput(shard->gmap, kbuf, ksiz, "", 0);
+      int64_t gmax = tclmin(rc->rmax, (pnum + fnum) * HDBRCPROBRAT) / 2 + 1;
+      if(TCMAPRNUM(shard->gmap) > gmax) tcmapcutfront(shard->gmap, TCMAPRNUM(shard->gmap) - gmax);
+      shard->psiz -= rsiz;
+    } else {
+      shard->fsiz -= rsiz;
+    }
+    tcmapout(map, kbuf, ksiz);
+  }
+}
+
+
+/* Retrieve a record from the record cache.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `sp' specifies the pointer to the variable into which the size of the region of the return
+   value is assigned.
+   If successful, the return value is the pointer to the region of the cached value whose first
+   byte is the mark of existence, else, it is `NULL'.  Because the region of the return value is
+   allocated with the `malloc' call, it should be released with the `free' call. */
+static char *tchdbrcget(TCHDB *hdb, const char *kbuf, int ksiz, int *sp){
+  assert(hdb && kbuf && ksiz >= 0 && sp);
+  HDBRCACHE *rc = hdb->recc;
+  HDBRCSHARD *shard = tchdbrcshard(rc, kbuf, ksiz);
+  int vsiz;
+  const char *vbuf = tcmapget3(shard->fmap, kbuf, ksiz, &vsiz);
+  if(!vbuf) vbuf = tcmapget(shard->pmap, kbuf, ksiz, &vsiz);
+  char *rv = NULL;
+  if(vbuf){
+    TCMEMDUP(rv, vbuf, vsiz);
+    *sp = vsiz;
+    shard->hnum++;
+  } else {
+    shard->mnum++;
+  }
+  if(rc->mt) pthread_mutex_unlock(&shard->mutex);
+  return rv;
+}
+
+
+/* Store a record into the record cache.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `mark' specifies the mark of existence: '=' for an existing record, '*' for a missing one.
+   `vbuf' specifies the pointer to the region of the value.  It can be `NULL' for a missing
+   record.
+   `vsiz' specifies the size of the region of the value.
+   A record which has been cached once is kept in the probationary queue and it is promoted to
+   the frequent queue only if it is stored again after it has been evicted from the queue. */
+static void tchdbrcput(TCHDB *hdb, const char *kbuf, int ksiz, char mark,
+                       const char *vbuf, int vsiz){
+  assert(hdb && kbuf && ksiz >= 0 && vsiz >= 0);
+  HDBRCACHE *rc = hdb->recc;
+  int64_t rsiz = HDBRCRECSIZ(ksiz, vsiz + 1);
+  if(rsiz > rc->smax / HDBRCPROBRAT){
+    tchdbrcout(hdb, kbuf, ksiz);
+    return;
+  }
+  HDBRCSHARD *shard = tchdbrcshard(rc, kbuf, ksiz);
+  int osiz;
+  if(tcmapget(shard->fmap, kbuf, ksiz, &osiz)){
+    tcmapput4(shard->fmap, kbuf, ksiz, &mark, 1, vbuf ? vbuf : "", vsiz);
+    shard->fsiz += rsiz - HDBRCRECSIZ(ksiz, osiz);
+  } else if(tcmapget(shard->pmap, kbuf, ksiz, &osiz)){
+    tcmapput4(shard->pmap, kbuf, ksiz, &mark, 1, vbuf ? vbuf : "", vsiz);
+    shard->psiz += rsiz - HDBRCRECSIZ(ksiz, osiz);
+  } else if(tcmapout(shard->gmap, kbuf, ksiz)){
+    tcmapput4(shard->fmap, kbuf, ksiz, &mark, 1, vbuf ? vbuf : "", vsiz);
+    shard->fsiz += rsiz;
+  } else {
+    tcmapput4(shard->pmap, kbuf, ksiz, &mark, 1, vbuf ? vbuf : "", vsiz);
+    shard->psiz += rsiz;
+  }
+  tchdbrcshardadjust(hdb, shard);
+  if(rc->mt) pthread_mutex_unlock(&shard->mutex);
+}
+
+
+/* Remove a record from the record cache.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key. */
+static void tchdbrcout(TCHDB *hdb, const char *kbuf, int ksiz){
+  assert(hdb && kbuf && ksiz >= 0);
+  HDBRCACHE *rc = hdb->recc;
+  HDBRCSHARD *shard = tchdbrcshard(rc, kbuf, ksiz);
+  int vsiz;
+  if(tcmapget(shard->fmap, kbuf, ksiz, &vsiz)){
+    shard->fsiz -= HDBRCRECSIZ(ksiz, vsiz);
+    tcmapout(shard->fmap, kbuf, ksiz);
+  } else if(tcmapget(shard->pmap, kbuf, ksiz, &vsiz)){
+    shard->psiz -= HDBRCRECSIZ(ksiz, vsiz);
+    tcmapout(shard->pmap, kbuf, ksiz);
+  }
+  if(rc->mt) pthread_mutex_unlock(&shard->mutex);
+}
+
+
+/* Remove all records of the record cache.
+   `hdb' specifies the hash database object. */
+static void tchdbrcvanish(TCHDB *hdb){
   assert(hdb);
-  TCDODEBUG(hdb->cnt_adjrecc++);
-  tcmdbcutfront(hdb->recc, HDBCACHEOUT);
+  HDBRCACHE *rc = hdb->recc;
+  for(int i = 0; i < rc->snum; i++){
+    HDBRCSHARD *shard = rc->shards + i;
+    if(rc->mt && pthread_mutex_lock(&shard->mutex) != 0) tcmyfatal("pthread_mutex_lock failed");
+    tcmapclear(shard->pmap);
+    tcmapclear(shard->gmap);
+    tcmapclear(shard->fmap);
+    shard->psiz = 0;
+    shard->fsiz = 0;
+    if(rc->mt) pthread_mutex_unlock(&shard->mutex);
+  }
 }
 
 
@@ -3127,6 +5672,27 @@ static bool tchdbwalinit(TCHDB *hdb){
     return false;
   }
   hdb->walend = hdb->fsiz;
+  hdb->gcwaloff = 0;
+  if(!tchdbwalwrite(hdb, 0, HDBHEADSIZ)) return false;
+  return true;
+}
+
+
+/* Continue write ahead logging after grouped commits which are not synchronized yet.
+   `hdb' specifies the hash database object.
+   If successful, the return value is true, else, it is false.
+   The log of the committed transactions is kept so that a crash still rolls them back, and the
+   log of the new transaction is appended so that it can be aborted by itself. */
+static bool tchdbwalappend(TCHDB *hdb){
+  assert(hdb);
+  off_t off = lseek(hdb->walfd, 0, SEEK_END);
+  if(off == -1){
+    tchdbsetecode(hdb, TCESEEK, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  hdb->walend = hdb->fsiz;
+  hdb->gcwaloff = off;
+  hdb->gcfsiz = hdb->fsiz;
   if(!tchdbwalwrite(hdb, 0, HDBHEADSIZ)) return false;
   return true;
 }
@@ -3139,6 +5705,8 @@ static bool tchdbwalinit(TCHDB *hdb){
    If successful, the return value is true, else, it is false. */
 static bool tchdbwalwrite(TCHDB *hdb, uint64_t off, int64_t size){
   assert(hdb && off >= 0 && size >= 0);
+  if(hdb->redo) return tchdbrlmark(hdb, off, size);
+  if(hdb->snap) return tchdbwalwritepages(hdb, off, size);
   if(off + size > hdb->walend) size = hdb->walend - off;
   if(size < 1) return true;
   char stack[HDBIOBUFSIZ];
@@ -3178,11 +5746,67 @@ static bool tchdbwalwrite(TCHDB *hdb, uint64_t off, int64_t size){
 }
 
 
+/* Write the pre-images of the pages of a region into the write ahead logging file.
+   `hdb' specifies the hash database object.
+   `off' specifies the offset of the region to be updated.
+   `size' specifies the size of the region.
+   If successful, the return value is true, else, it is false.
+   Each page is logged only once in a transaction and the offset of its pre-image in the log is
+   recorded so that reader snapshots can be served from it. */
+static bool tchdbwalwritepages(TCHDB *hdb, uint64_t off, int64_t size){
+  assert(hdb && hdb->snap && off >= 0 && size >= 0);
+  if(off + size > hdb->walend) size = hdb->walend - off;
+  if(size < 1) return true;
+  HDBSNAP *snap = hdb->snap;
+  uint64_t end = (off + size - 1) / HDBSNAPPGSIZ;
+  if(!HDBLOCKWAL(hdb)) return false;
+  for(uint64_t pidx = off / HDBSNAPPGSIZ; pidx <= end; pidx++){
+    int vsiz;
+    if(tcmapget(snap->pages, &pidx, sizeof(pidx), &vsiz)) continue;
+    uint64_t poff = pidx * HDBSNAPPGSIZ;
+    uint32_t psiz = tclmin(HDBSNAPPGSIZ, hdb->walend - poff);
+    char buf[sizeof(uint64_t)+sizeof(uint32_t)+HDBSNAPPGSIZ];
+    uint64_t llnum = TCHTOILL(poff);
+    memcpy(buf, &llnum, sizeof(llnum));
+    uint32_t lnum = TCHTOIL(psiz);
+    memcpy(buf + sizeof(llnum), &lnum, sizeof(lnum));
+    char *wp = buf + sizeof(llnum) + sizeof(lnum);
+    if(!tchdbseekread(hdb, poff, wp, psiz)){
+      HDBUNLOCKWAL(hdb);
+      return false;
+    }
+    off_t waloff = lseek(hdb->walfd, 0, SEEK_CUR);
+    if(waloff == -1){
+      tchdbsetecode(hdb, TCESEEK, __FILE__, __LINE__, __func__);
+      HDBUNLOCKWAL(hdb);
+      return false;
+    }
+    if(!tcwrite(hdb->walfd, buf, wp - buf + psiz)){
+      tchdbsetecode(hdb, TCEWRITE, __FILE__, __LINE__, __func__);
+      HDBUNLOCKWAL(hdb);
+      return false;
+    }
+    if((hdb->omode & HDBOTSYNC) && fsync(hdb->walfd) == -1){
+      tchdbsetecode(hdb, TCESYNC, __FILE__, __LINE__, __func__);
+      HDBUNLOCKWAL(hdb);
+      return false;
+    }
+    uint64_t doff = waloff + (wp - buf);
+    tcmapput(snap->pages, &pidx, sizeof(pidx), &doff, sizeof(doff));
+  }
+  HDBUNLOCKWAL(hdb);
+  return true;
+}
+
+
 /* Restore the database from the write ahead logging file.
    `hdb' specifies the hash database object.
    `path' specifies the path of the database file.
+   `begoff' specifies the offset of the first log to restore.  If it is 0, the whole log is
+   restored.
+   `begfsiz' specifies the file size to restore when `begoff' is not 0.
    If successful, the return value is true, else, it is false. */
-static int tchdbwalrestore(TCHDB *hdb, const char *path){
+static int tchdbwalrestore(TCHDB *hdb, const char *path, uint64_t begoff, uint64_t begfsiz){
   assert(hdb && path);
   char *tpath = tcsprintf("%s%c%s", path, MYEXTCHR, HDBWALSUFFIX);
   int walfd = open(tpath, O_RDONLY, HDBFILEMODE);
@@ -3222,8 +5846,16 @@ static int tchdbwalrestore(TCHDB *hdb, const char *path){
       tchdbsetecode(hdb, TCEREAD, __FILE__, __LINE__, __func__);
       err = true;
     }
-    TCLIST *list = tclistnew();
     uint64_t waloff = sizeof(fsiz);
+    if(begoff > 0){
+      if(lseek(walfd, begoff, SEEK_SET) == -1){
+        tchdbsetecode(hdb, TCESEEK, __FILE__, __LINE__, __func__);
+        err = true;
+      }
+      waloff = begoff;
+      fsiz = begfsiz;
+    }
+    TCLIST *list = tclistnew();
     char stack[HDBIOBUFSIZ];
     while(waloff < walsiz){
       uint64_t off;
@@ -3273,6 +5905,8 @@ static int tchdbwalrestore(TCHDB *hdb, const char *path){
         err = true;
         break;
       }
+      tchdbscanpatch(hdb, off, rec, size);
+      if(hdb->bkup) tchdbbkmark(hdb, off, size);
       if(!TCUBCACHE && off < xmsiz){
         size = (size <= xmsiz - off) ? size : xmsiz - off;
         memcpy(hdb->map + off, rec, size);
@@ -3319,1244 +5953,5072 @@ static bool tchdbwalremove(TCHDB *hdb, const char *path){
 }
 
 
-/* Open a database file and connect a hash database object.
+/* Begin a transaction with redo logging.
    `hdb' specifies the hash database object.
-   `path' specifies the path of the database file.
-   `omode' specifies the connection mode.
-   If successful, the return value is true, else, it is false. */
-static bool tchdbopenimpl(TCHDB *hdb, const char *path, int omode){
-  assert(hdb && path);
-  int mode = O_RDONLY;
-  if(omode & HDBOWRITER){
-    mode = O_RDWR;
-    if(omode & HDBOCREAT) mode |= O_CREAT;
-  }
-  int fd = open(path, mode, HDBFILEMODE);
-  if(fd < 0){
-    int ecode = TCEOPEN;
-    switch(errno){
-      case EACCES: ecode = TCENOPERM; break;
-      case ENOENT: ecode = TCENOFILE; break;
-      case ENOTDIR: ecode = TCENOFILE; break;
+   If successful, the return value is true, else, it is false.
+   Each chunk of the mapped region is replaced with a private mapping of the file before it is
+   updated first, and regions beyond the mapped region are written into pages in memory, so that
+   the file is not modified until the commit.  As mappings of the same file are coherent, the
+   shared mapping need not be synchronized, and the chunks never updated keep their advice. */
+static bool tchdbrlbegin(TCHDB *hdb){
+  assert(hdb && !hdb->redo);
+  if(hdb->rlfd < 0){
+    char *tpath = tcsprintf("%s%c%s", hdb->path, MYEXTCHR, HDBRLSUFFIX);
+    int rlfd = open(tpath, O_RDWR | O_CREAT | O_TRUNC, HDBFILEMODE);
+    TCFREE(tpath);
+    if(rlfd < 0){
+      int ecode = TCEOPEN;
+      switch(errno){
+        case EACCES: ecode = TCENOPERM; break;
+        case ENOENT: ecode = TCENOFILE; break;
+        case ENOTDIR: ecode = TCENOFILE; break;
+      }
+      tchdbsetecode(hdb, ecode, __FILE__, __LINE__, __func__);
+      return false;
     }
-    tchdbsetecode(hdb, ecode, __FILE__, __LINE__, __func__);
+    hdb->rlfd = rlfd;
+    hdb->rlsiz = 0;
+  }
+  size_t xmsiz = (hdb->xmsiz > hdb->msiz) ? hdb->xmsiz : hdb->msiz;
+  HDBREDO *redo;
+  TCMALLOC(redo, sizeof(*redo));
+  redo->marks = tcxstrnew();
+  redo->pages = tcmapnew();
+  redo->pbeg = UINT64_MAX;
+  redo->msiz = xmsiz;
+  redo->punit = HDBRLPRUNIT;
+  while(xmsiz / redo->punit > HDBRLPRMAX){
+    redo->punit <<= 1;
+  }
+  TCCALLOC(redo->privs, xmsiz / redo->punit + 1, 1);
+  if(!tchdbrlprivate(hdb, redo, 0, HDBHEADSIZ)){
+    hdb->redo = redo;
+    tchdbrlend(hdb);
     return false;
   }
-  if(!(omode & HDBONOLCK)){
-    if(!tclock(fd, omode & HDBOWRITER, omode & HDBOLCKNB)){
-      tchdbsetecode(hdb, TCELOCK, __FILE__, __LINE__, __func__);
-      close(fd);
-      return false;
+  hdb->walend = hdb->fsiz;
+  hdb->redo = redo;
+  return true;
+}
+
+
+/* Commit a transaction with redo logging.
+   `hdb' specifies the hash database object.
+   If successful, the return value is true, else, it is false.
+   The new contents of the updated regions are appended to the redo log as a frame, which is then
+   applied to the file.  If the frame can not be logged, the transaction is aborted. */
+static bool tchdbrlcommit(TCHDB *hdb){
+  assert(hdb && hdb->redo);
+  HDBREDO *redo = hdb->redo;
+  bool err = false;
+  if(!tchdbmemsync(hdb, false)) err = true;
+  uint64_t head[2] = { 0, HDBHEADSIZ };
+  TCXSTRCAT(redo->marks, head, sizeof(head));
+  uint64_t *marks = (uint64_t *)TCXSTRPTR(redo->marks);
+  int mnum = TCXSTRSIZE(redo->marks) / sizeof(head);
+  qsort(marks, mnum, sizeof(head), tchdbrlmarkcmp);
+  int rnum = 0;
+  uint64_t bsiz = 0;
+  for(int i = 0; i < mnum; i++){
+    uint64_t beg = marks[i*2];
+    uint64_t end = tclmin(marks[i*2+1], hdb->fsiz);
+    if(beg >= end) continue;
+    if(rnum > 0 && beg <= marks[rnum*2-1] + HDBRLRHSIZ){
+      if(end > marks[rnum*2-1]){
+        bsiz += end - marks[rnum*2-1];
+        marks[rnum*2-1] = end;
+      }
+    } else {
+      marks[rnum*2] = beg;
+      marks[rnum*2+1] = end;
+      bsiz += HDBRLRHSIZ + end - beg;
+      rnum++;
     }
   }
-  if((omode & HDBOWRITER) && (omode & HDBOTRUNC)){
-    if(ftruncate(fd, 0) == -1){
-      tchdbsetecode(hdb, TCETRUNC, __FILE__, __LINE__, __func__);
-      close(fd);
-      return false;
-    }
-    if(!tchdbwalremove(hdb, path)){
-      close(fd);
-      return false;
+  uint64_t lsiz = HDBRLFHSIZ + bsiz;
+  if(lsiz > INT_MAX){
+    tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  char *fbuf = NULL;
+  if(!err){
+    TCMALLOC(fbuf, lsiz);
+    char *wp = fbuf + HDBRLFHSIZ;
+    for(int i = 0; i < rnum; i++){
+      uint64_t off = marks[i*2];
+      uint32_t size = marks[i*2+1] - off;
+      uint64_t llnum = TCHTOILL(off);
+      memcpy(wp, &llnum, sizeof(llnum));
+      wp += sizeof(llnum);
+      uint32_t lnum = TCHTOIL(size);
+      memcpy(wp, &lnum, sizeof(lnum));
+      wp += sizeof(lnum);
+      if(!tchdbrlread(hdb, off, wp, size)){
+        err = true;
+        break;
+      }
+      wp += size;
     }
+    uint64_t llnum = TCHTOILL(bsiz);
+    memcpy(fbuf + sizeof(uint32_t), &llnum, sizeof(llnum));
+    llnum = TCHTOILL(hdb->fsiz);
+    memcpy(fbuf + sizeof(uint32_t) + sizeof(llnum), &llnum, sizeof(llnum));
+    uint32_t lnum = tcgetcrc(fbuf + sizeof(lnum), lsiz - sizeof(lnum));
+    lnum = TCHTOIL(lnum);
+    memcpy(fbuf, &lnum, sizeof(lnum));
   }
-  struct stat sbuf;
-  if(fstat(fd, &sbuf) == -1 || !S_ISREG(sbuf.st_mode)){
-    tchdbsetecode(hdb, TCESTAT, __FILE__, __LINE__, __func__);
-    close(fd);
-    return false;
+  if(!err && hdb->vlfd >= 0 && (hdb->omode & HDBOTSYNC) && fsync(hdb->vlfd) == -1){
+    tchdbsetecode(hdb, TCESYNC, __FILE__, __LINE__, __func__);
+    err = true;
   }
-  char hbuf[HDBHEADSIZ];
-  if((omode & HDBOWRITER) && sbuf.st_size < 1){
-    hdb->flags = 0;
-    hdb->rnum = 0;
-    uint32_t fbpmax = 1 << hdb->fpow;
-    uint32_t fbpsiz = HDBFBPBSIZ + fbpmax * HDBFBPESIZ;
-    int besiz = (hdb->opts & HDBTLARGE) ? sizeof(int64_t) : sizeof(int32_t);
-    hdb->align = 1 << hdb->apow;
-    hdb->fsiz = HDBHEADSIZ + besiz * hdb->bnum + fbpsiz;
-    hdb->fsiz += tchdbpadsize(hdb, hdb->fsiz);
-    hdb->frec = hdb->fsiz;
-    tchdbdumpmeta(hdb, hbuf);
-    bool err = false;
-    if(!tcwrite(fd, hbuf, HDBHEADSIZ)) err = true;
-    char pbuf[HDBIOBUFSIZ];
-    memset(pbuf, 0, HDBIOBUFSIZ);
-    uint64_t psiz = hdb->fsiz - HDBHEADSIZ;
-    while(psiz > 0){
-      if(psiz > HDBIOBUFSIZ){
-        if(!tcwrite(fd, pbuf, HDBIOBUFSIZ)) err = true;
-        psiz -= HDBIOBUFSIZ;
-      } else {
-        if(!tcwrite(fd, pbuf, psiz)) err = true;
-        psiz = 0;
-      }
-    }
-    if(err){
+  if(!err){
+    if(lseek(hdb->rlfd, hdb->rlsiz, SEEK_SET) == -1){
+      tchdbsetecode(hdb, TCESEEK, __FILE__, __LINE__, __func__);
+      err = true;
+    } else if(!tcwrite(hdb->rlfd, fbuf, lsiz)){
       tchdbsetecode(hdb, TCEWRITE, __FILE__, __LINE__, __func__);
-      close(fd);
-      return false;
+      err = true;
+    } else if((hdb->omode & HDBOTSYNC) && fsync(hdb->rlfd) == -1){
+      tchdbsetecode(hdb, TCESYNC, __FILE__, __LINE__, __func__);
+      err = true;
     }
-    sbuf.st_size = hdb->fsiz;
-  }
-  if(lseek(fd, 0, SEEK_SET) == -1){
-    tchdbsetecode(hdb, TCESEEK, __FILE__, __LINE__, __func__);
-    close(fd);
-    return false;
   }
-  if(!tcread(fd, hbuf, HDBHEADSIZ)){
-    tchdbsetecode(hdb, TCEREAD, __FILE__, __LINE__, __func__);
-    close(fd);
+  if(err){
+    TCFREE(fbuf);
+    tchdbrlabort(hdb);
     return false;
   }
-  int type = hdb->type;
-  tchdbloadmeta(hdb, hbuf);
-  if((hdb->flags & HDBFOPEN) && tchdbwalrestore(hdb, path)){
-    if(lseek(fd, 0, SEEK_SET) == -1){
-      tchdbsetecode(hdb, TCESEEK, __FILE__, __LINE__, __func__);
-      close(fd);
-      return false;
-    }
-    if(!tcread(fd, hbuf, HDBHEADSIZ)){
-      tchdbsetecode(hdb, TCEREAD, __FILE__, __LINE__, __func__);
-      close(fd);
-      return false;
+  hdb->rlsiz += lsiz;
+  const char *rp = fbuf + HDBRLFHSIZ;
+  for(int i = 0; i < rnum; i++){
+    uint64_t off = marks[i*2];
+    uint32_t size = marks[i*2+1] - off;
+    rp += HDBRLRHSIZ;
+    if(!tchdbrlpwrite(hdb, hdb->fd, off, rp, size)){
+      err = true;
+      break;
     }
+    if(hdb->bkup) tchdbbkmark(hdb, off, size);
+    rp += size;
+  }
+  TCFREE(fbuf);
+  if(!tchdbrlend(hdb)) err = true;
+  if(!err && hdb->rlsiz >= hdb->rllim && !tchdbrlckpt(hdb)) err = true;
+  return !err;
+}
+
+
+/* Abort a transaction with redo logging.
+   `hdb' specifies the hash database object.
+   If successful, the return value is true, else, it is false.
+   The updates kept in memory are discarded and the meta data is loaded from the file, which has
+   not been modified by the transaction. */
+static bool tchdbrlabort(TCHDB *hdb){
+  assert(hdb && hdb->redo);
+  bool err = false;
+  if(!tchdbrlend(hdb)) err = true;
+  __sync_fetch_and_add(&hdb->wseq, 1);
+  char hbuf[HDBHEADSIZ];
+  if(tchdbrlpread(hdb, 0, hbuf, HDBHEADSIZ)){
     tchdbloadmeta(hdb, hbuf);
-    if(!tchdbwalremove(hdb, path)){
-      close(fd);
-      return false;
-    }
+  } else {
+    err = true;
   }
-  int besiz = (hdb->opts & HDBTLARGE) ? sizeof(int64_t) : sizeof(int32_t);
-  size_t msiz = HDBHEADSIZ + hdb->bnum * besiz;
-  if(!(omode & HDBONOLCK)){
-    if(memcmp(hbuf, HDBMAGICDATA, strlen(HDBMAGICDATA)) || hdb->type != type ||
-       hdb->frec < msiz + HDBFBPBSIZ || hdb->frec > hdb->fsiz || sbuf.st_size < hdb->fsiz){
-      tchdbsetecode(hdb, TCEMETA, __FILE__, __LINE__, __func__);
-      close(fd);
-      return false;
+  hdb->dfcur = hdb->frec;
+  hdb->apcur = 0;
+  hdb->apend = 0;
+  hdb->xtcur = 0;
+  tchdbxtreset(hdb);
+  hdb->iter = 0;
+  hdb->xfsiz = 0;
+  tchdbfbpclear(hdb);
+  if(hdb->recc) tchdbrcvanish(hdb);
+  return !err;
+}
+
+
+/* Finish a transaction with redo logging.
+   `hdb' specifies the hash database object.
+   If successful, the return value is true, else, it is false.
+   The chunks mapped privately are mapped again in the shared mode and the pages kept in memory
+   are released. */
+static bool tchdbrlend(TCHDB *hdb){
+  assert(hdb && hdb->redo);
+  HDBREDO *redo = hdb->redo;
+  hdb->redo = NULL;
+  bool err = false;
+  uint64_t pnum = redo->msiz / redo->punit + 1;
+  uint64_t cidx = 0;
+  while(cidx < pnum){
+    if(!redo->privs[cidx]){
+      cidx++;
+      continue;
     }
+    uint64_t ridx = cidx;
+    while(cidx < pnum && redo->privs[cidx]){
+      cidx++;
+    }
+    uint64_t off = ridx * redo->punit;
+    uint64_t size = tclmin(cidx * redo->punit, redo->msiz) - off;
+    if(!tchdbrlremap(hdb, off, size, MAP_SHARED)) err = true;
   }
-  if(((hdb->opts & HDBTDEFLATE) && !_tc_deflate) ||
-     ((hdb->opts & HDBTBZIP) && !_tc_bzcompress) || ((hdb->opts & HDBTEXCODEC) && !hdb->enc)){
-    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
-    close(fd);
-    return false;
-  }
-  size_t xmsiz = (hdb->xmsiz > msiz) ? hdb->xmsiz : msiz;
-  if(!(omode & HDBOWRITER) && xmsiz > hdb->fsiz) xmsiz = hdb->fsiz;
-  void *map = mmap(0, xmsiz, PROT_READ | ((omode & HDBOWRITER) ? PROT_WRITE : 0),
-                   MAP_SHARED, fd, 0);
+  TCFREE(redo->privs);
+  tcmapiterinit(redo->pages);
+  int ksiz;
+  const char *kbuf;
+  while((kbuf = tcmapiternext(redo->pages, &ksiz)) != NULL){
+    int vsiz;
+    char * const *pp = tcmapiterval(kbuf, &vsiz);
+    TCFREE(*pp);
+  }
+  tcmapdel(redo->pages);
+  tcxstrdel(redo->marks);
+  TCFREE(redo);
+  return !err;
+}
+
+
+/* Map a region of the file of a hash database object again at the same address.
+   `hdb' specifies the hash database object.
+   `off' specifies the offset of the region, which should be aligned to pages.
+   `size' specifies the size of the region.
+   `flags' specifies `MAP_PRIVATE' to keep updates in memory or `MAP_SHARED' to map the file.
+   If successful, the return value is true, else, it is false.
+   As the address is not changed, the pointers into the mapped region stay valid.  The mapping
+   options are applied again only to the region mapped in the shared mode. */
+static bool tchdbrlremap(TCHDB *hdb, uint64_t off, uint64_t size, int flags){
+  assert(hdb);
+  size_t xmsiz = (hdb->xmsiz > hdb->msiz) ? hdb->xmsiz : hdb->msiz;
+  void *map = mmap(hdb->map + off, size, PROT_READ | PROT_WRITE, flags | MAP_FIXED, hdb->fd, off);
   if(map == MAP_FAILED){
     tchdbsetecode(hdb, TCEMMAP, __FILE__, __LINE__, __func__);
-    close(fd);
     return false;
   }
-  hdb->fbpmax = 1 << hdb->fpow;
-  if(omode & HDBOWRITER){
-    TCMALLOC(hdb->fbpool, hdb->fbpmax * HDBFBPALWRAT * sizeof(HDBFB));
-  } else {
-    hdb->fbpool = NULL;
-  }
-  hdb->fbpnum = 0;
-  hdb->fbpmis = 0;
-  hdb->async = false;
-  hdb->drpool = NULL;
-  hdb->drpdef = NULL;
-  hdb->drpoff = 0;
-  hdb->recc = (hdb->rcnum > 0) ? tcmdbnew2(hdb->rcnum * 2 + 1) : NULL;
-  hdb->path = tcstrdup(path);
-  hdb->fd = fd;
-  hdb->omode = omode;
-  hdb->dfcur = hdb->frec;
-  hdb->iter = 0;
-  hdb->map = map;
-  hdb->msiz = msiz;
-  hdb->xfsiz = 0;
-  if(hdb->opts & HDBTLARGE){
-    hdb->ba32 = NULL;
-    hdb->ba64 = (uint64_t *)((char *)map + HDBHEADSIZ);
-  } else {
-    hdb->ba32 = (uint32_t *)((char *)map + HDBHEADSIZ);
-    hdb->ba64 = NULL;
-  }
-  hdb->align = 1 << hdb->apow;
-  hdb->runit = tclmin(tclmax(hdb->align, HDBMINRUNIT), HDBIOBUFSIZ);
-  hdb->zmode = (hdb->opts & HDBTDEFLATE) || (hdb->opts & HDBTBZIP) ||
-    (hdb->opts & HDBTTCBS) || (hdb->opts & HDBTEXCODEC);
-  hdb->ecode = TCESUCCESS;
-  hdb->fatal = false;
-  hdb->inode = (uint64_t)sbuf.st_ino;
-  hdb->mtime = sbuf.st_mtime;
-  hdb->dfcnt = 0;
-  hdb->tran = false;
-  hdb->walfd = -1;
-  hdb->walend = 0;
-  if(hdb->omode & HDBOWRITER){
-    bool err = false;
-    if(!(hdb->flags & HDBFOPEN) && !tchdbloadfbp(hdb)) err = true;
-    memset(hbuf, 0, 2);
-    if(!tchdbseekwrite(hdb, hdb->msiz, hbuf, 2)) err = true;
-    if(err){
-      TCFREE(hdb->path);
-      TCFREE(hdb->fbpool);
-      munmap(hdb->map, xmsiz);
-      close(fd);
-      hdb->fd = -1;
-      return false;
+  if(flags == MAP_SHARED && hdb->mopts &&
+     !tchdbmapadvise(hdb, hdb->map, hdb->msiz, xmsiz, off, off + size)) return false;
+  return true;
+}
+
+
+/* Map the chunks of a region of the mapped region privately in a transaction with redo logging.
+   `hdb' specifies the hash database object.
+   `redo' specifies the state of the transaction.
+   `off' specifies the offset of the region to be updated.
+   `size' specifies the size of the region.
+   If successful, the return value is true, else, it is false. */
+static bool tchdbrlprivate(TCHDB *hdb, HDBREDO *redo, uint64_t off, int64_t size){
+  assert(hdb && redo && off >= 0 && size >= 0);
+  if(off >= redo->msiz || size < 1) return true;
+  uint64_t end = tclmin(off + size, redo->msiz);
+  uint64_t cidx = off / redo->punit;
+  uint64_t cend = (end + redo->punit - 1) / redo->punit;
+  while(cidx < cend){
+    if(redo->privs[cidx]){
+      cidx++;
+      continue;
     }
-    tchdbsetflag(hdb, HDBFOPEN, true);
+    uint64_t ridx = cidx;
+    while(cidx < cend && !redo->privs[cidx]){
+      cidx++;
+    }
+    uint64_t roff = ridx * redo->punit;
+    uint64_t rsiz = tclmin(cidx * redo->punit, redo->msiz) - roff;
+    if(!tchdbrlremap(hdb, roff, rsiz, MAP_PRIVATE)) return false;
+    memset(redo->privs + ridx, 1, cidx - ridx);
   }
   return true;
 }
 
 
-/* Close a hash database object.
+/* Mark a region updated by a transaction with redo logging.
    `hdb' specifies the hash database object.
+   `off' specifies the offset of the region.
+   `size' specifies the size of the region.
    If successful, the return value is true, else, it is false. */
-static bool tchdbcloseimpl(TCHDB *hdb){
-  assert(hdb);
-  bool err = false;
-  if(hdb->recc){
-    tcmdbdel(hdb->recc);
-    hdb->recc = NULL;
+static bool tchdbrlmark(TCHDB *hdb, uint64_t off, int64_t size){
+  assert(hdb && hdb->redo && off >= 0 && size >= 0);
+  if(size < 1) return true;
+  HDBREDO *redo = hdb->redo;
+  if(!HDBLOCKWAL(hdb)) return false;
+  if(!tchdbrlprivate(hdb, redo, off, size)){
+    HDBUNLOCKWAL(hdb);
+    return false;
   }
-  if(hdb->omode & HDBOWRITER){
-    if(!tchdbflushdrp(hdb)) err = true;
-    if(hdb->tran) hdb->fbpnum = 0;
-    if(!tchdbsavefbp(hdb)) err = true;
-    TCFREE(hdb->fbpool);
-    tchdbsetflag(hdb, HDBFOPEN, false);
+  int msiz = TCXSTRSIZE(redo->marks);
+  uint64_t *last = (msiz > 0) ? (uint64_t *)(TCXSTRPTR(redo->marks) + msiz) - 2 : NULL;
+  if(last && off >= last[0] && off <= last[1]){
+    if(off + size > last[1]) last[1] = off + size;
+  } else {
+    uint64_t mark[2] = { off, off + size };
+    TCXSTRCAT(redo->marks, mark, sizeof(mark));
   }
-  if((hdb->omode & HDBOWRITER) && !tchdbmemsync(hdb, false)) err = true;
-  size_t xmsiz = (hdb->xmsiz > hdb->msiz) ? hdb->xmsiz : hdb->msiz;
-  if(!(hdb->omode & HDBOWRITER) && xmsiz > hdb->fsiz) xmsiz = hdb->fsiz;
-  if(munmap(hdb->map, xmsiz) == -1){
-    tchdbsetecode(hdb, TCEMMAP, __FILE__, __LINE__, __func__);
-    err = true;
+  HDBUNLOCKWAL(hdb);
+  return true;
+}
+
+
+/* Compare two marks of updated regions by the beginning.
+   `a' specifies the pointer to one mark.
+   `b' specifies the pointer to the other mark.
+   The return value is positive if the former is big, negative if the latter is big, 0 if both
+   are equivalent. */
+static int tchdbrlmarkcmp(const void *a, const void *b){
+  assert(a && b);
+  uint64_t aoff = *(const uint64_t *)a;
+  uint64_t boff = *(const uint64_t *)b;
+  if(aoff != boff) return (aoff < boff) ? -1 : 1;
+  return 0;
+}
+
+
+/* Get a page kept in memory beyond the mapped region by a transaction with redo logging.
+   `hdb' specifies the hash database object.
+   `pidx' specifies the index of the page.
+   `fill' specifies whether a new page is filled with the contents of the file.
+   The return value is the pointer to the page or `NULL' on failure.
+   This function should be called under the lock of the write ahead logging. */
+static char *tchdbrlpage(TCHDB *hdb, uint64_t pidx, bool fill){
+  assert(hdb && hdb->redo && pidx >= 0);
+  HDBREDO *redo = hdb->redo;
+  int vsiz;
+  char * const *pp = tcmapget(redo->pages, &pidx, sizeof(pidx), &vsiz);
+  if(pp) return *pp;
+  uint64_t poff = pidx * HDBRLPGSIZ;
+  char *page;
+  TCMALLOC(page, HDBRLPGSIZ);
+  if(fill && !tchdbrlpread(hdb, poff, page, HDBRLPGSIZ)){
+    TCFREE(page);
+    return NULL;
   }
-  hdb->map = NULL;
-  if((hdb->omode & HDBOWRITER) && ftruncate(hdb->fd, hdb->fsiz) == -1){
-    tchdbsetecode(hdb, TCETRUNC, __FILE__, __LINE__, __func__);
-    err = true;
+  tcmapput(redo->pages, &pidx, sizeof(pidx), &page, sizeof(page));
+  if(poff < redo->pbeg) redo->pbeg = poff;
+  return page;
+}
+
+
+/* Write data in a transaction with redo logging.
+   `hdb' specifies the hash database object.
+   `off' specifies the offset of the region to write.
+   `buf' specifies the buffer of the data.
+   `size' specifies the size of the buffer.
+   If successful, the return value is true, else, it is false. */
+static bool tchdbrlwrite(TCHDB *hdb, uint64_t off, const void *buf, size_t size){
+  assert(hdb && hdb->redo && off >= 0 && buf && size >= 0);
+  HDBREDO *redo = hdb->redo;
+  if(off < redo->msiz){
+    size_t head = tclmin(size, redo->msiz - off);
+    uint64_t end = off + head;
+    if(end >= hdb->fsiz && end >= hdb->xfsiz){
+      uint64_t xfsiz = end + HDBXFSIZINC;
+      if(ftruncate(hdb->fd, xfsiz) == -1){
+        tchdbsetecode(hdb, TCETRUNC, __FILE__, __LINE__, __func__);
+        return false;
+      }
+      hdb->xfsiz = xfsiz;
+    }
+    memcpy(hdb->map + off, buf, head);
+    off += head;
+    buf = (char *)buf + head;
+    size -= head;
+    if(size < 1) return true;
   }
-  if(hdb->tran){
-    if(!tchdbwalrestore(hdb, hdb->path)) err = true;
-    hdb->tran = false;
+  tchdbscanpatch(hdb, off, buf, size);
+  if(!HDBLOCKWAL(hdb)){
+    __sync_fetch_and_add(&hdb->wseq, 1);
+    return false;
   }
-  if(hdb->walfd >= 0){
-    if(close(hdb->walfd) == -1){
-      tchdbsetecode(hdb, TCECLOSE, __FILE__, __LINE__, __func__);
-      err = true;
+  while(size > 0){
+    uint64_t pidx = off / HDBRLPGSIZ;
+    uint64_t poff = pidx * HDBRLPGSIZ;
+    size_t psiz = tclmin(size, poff + HDBRLPGSIZ - off);
+    char *page = tchdbrlpage(hdb, pidx, psiz < HDBRLPGSIZ);
+    if(!page){
+      HDBUNLOCKWAL(hdb);
+      __sync_fetch_and_add(&hdb->wseq, 1);
+      return false;
     }
-    if(!hdb->fatal && !tchdbwalremove(hdb, hdb->path)) err = true;
-  }
-  if(close(hdb->fd) == -1){
-    tchdbsetecode(hdb, TCECLOSE, __FILE__, __LINE__, __func__);
-    err = true;
+    memcpy(page + (off - poff), buf, psiz);
+    off += psiz;
+    buf = (char *)buf + psiz;
+    size -= psiz;
   }
-  TCFREE(hdb->path);
-  hdb->path = NULL;
-  hdb->fd = -1;
-  return !err;
+  HDBUNLOCKWAL(hdb);
+  return true;
 }
 
 
-/* Store a record.
+/* Read data in a transaction with redo logging.
    `hdb' specifies the hash database object.
-   `kbuf' specifies the pointer to the region of the key.
-   `ksiz' specifies the size of the region of the key.
-   `bidx' specifies the index of the bucket array.
-   `hash' specifies the hash value for the collision tree.
-   `vbuf' specifies the pointer to the region of the value.
-   `vsiz' specifies the size of the region of the value.
-   `dmode' specifies behavior when the key overlaps.
-   If successful, the return value is true, else, it is false. */
-static bool tchdbputimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash,
-                         const char *vbuf, int vsiz, int dmode){
-  assert(hdb && kbuf && ksiz >= 0);
-  if(hdb->recc) tcmdbout(hdb->recc, kbuf, ksiz);
-  off_t off = tchdbgetbucket(hdb, bidx);
-  off_t entoff = 0;
-  TCHREC rec;
-  char rbuf[HDBIOBUFSIZ];
-  while(off > 0){
-    rec.off = off;
-    if(!tchdbreadrec(hdb, &rec, rbuf)) return false;
-    if(hash > rec.hash){
-      off = rec.left;
-      entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t));
-    } else if(hash < rec.hash){
-      off = rec.right;
-      entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t)) +
-        (hdb->ba64 ? sizeof(uint64_t) : sizeof(uint32_t));
+   `off' specifies the offset of the region to read.
+   `buf' specifies the buffer to store into.
+   `size' specifies the size of the buffer.
+   If successful, the return value is true, else, it is false.
+   Pages kept in memory are read over the contents of the file, which are read in runs. */
+static bool tchdbrlread(TCHDB *hdb, uint64_t off, void *buf, size_t size){
+  assert(hdb && hdb->redo && off >= 0 && buf && size >= 0);
+  HDBREDO *redo = hdb->redo;
+  if(off < redo->msiz){
+    size_t head = tclmin(size, redo->msiz - off);
+    memcpy(buf, hdb->map + off, head);
+    off += head;
+    buf = (char *)buf + head;
+    size -= head;
+    if(size < 1) return true;
+  }
+  if(!HDBLOCKWAL(hdb)) return false;
+  bool err = false;
+  uint64_t roff = off;
+  char *rbuf = buf;
+  size_t rsiz = 0;
+  while(size > 0){
+    if(off + size <= redo->pbeg){
+      if(rsiz < 1){
+        roff = off;
+        rbuf = buf;
+      }
+      rsiz += size;
+      break;
+    }
+    uint64_t pidx = off / HDBRLPGSIZ;
+    uint64_t poff = pidx * HDBRLPGSIZ;
+    size_t psiz = tclmin(size, poff + HDBRLPGSIZ - off);
+    int vsiz;
+    char * const *pp = tcmapget(redo->pages, &pidx, sizeof(pidx), &vsiz);
+    if(pp){
+      if(rsiz > 0 && !tchdbrlpread(hdb, roff, rbuf, rsiz)){
+        err = true;
+        break;
+      }
+      rsiz = 0;
+      memcpy(buf, *pp + (off - poff), psiz);
     } else {
-      if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)) return false;
-      int kcmp = tcreckeycmp(kbuf, ksiz, rec.kbuf, rec.ksiz);
-      if(kcmp > 0){
-        off = rec.left;
-        TCFREE(rec.bbuf);
-        rec.kbuf = NULL;
-        rec.bbuf = NULL;
-        entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t));
-      } else if(kcmp < 0){
-        off = rec.right;
-        TCFREE(rec.bbuf);
-        rec.kbuf = NULL;
-        rec.bbuf = NULL;
-        entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t)) +
-          (hdb->ba64 ? sizeof(uint64_t) : sizeof(uint32_t));
+      if(rsiz < 1){
+        roff = off;
+        rbuf = buf;
+      }
+      rsiz += psiz;
+    }
+    off += psiz;
+    buf = (char *)buf + psiz;
+    size -= psiz;
+  }
+  if(!err && rsiz > 0 && !tchdbrlpread(hdb, roff, rbuf, rsiz)) err = true;
+  HDBUNLOCKWAL(hdb);
+  return !err;
+}
+
+
+/* Read data from the file of a hash database object for redo logging.
+   `hdb' specifies the hash database object.
+   `off' specifies the offset of the region to read.
+   `buf' specifies the buffer to store into.
+   `size' specifies the size of the buffer.
+   If successful, the return value is true, else, it is false.
+   The region beyond the end of the file is filled with zero. */
+static bool tchdbrlpread(TCHDB *hdb, uint64_t off, void *buf, size_t size){
+  assert(hdb && off >= 0 && buf && size >= 0);
+  char *wp = buf;
+  while(size > 0){
+    ssize_t rb = pread(hdb->fd, wp, size, off);
+    if(rb > 0){
+      wp += rb;
+      size -= rb;
+      off += rb;
+    } else if(rb == 0){
+      memset(wp, 0, size);
+      break;
+    } else if(errno != EINTR){
+      tchdbsetecode(hdb, TCEREAD, __FILE__, __LINE__, __func__);
+      return false;
+    }
+  }
+  return true;
+}
+
+
+/* Write data into a file for redo logging.
+   `hdb' specifies the hash database object.
+   `fd' specifies the file descriptor of the file.
+   `off' specifies the offset of the region to write.
+   `buf' specifies the buffer of the data.
+   `size' specifies the size of the buffer.
+   If successful, the return value is true, else, it is false. */
+static bool tchdbrlpwrite(TCHDB *hdb, int fd, uint64_t off, const void *buf, size_t size){
+  assert(hdb && fd >= 0 && off >= 0 && buf && size >= 0);
+  const char *rp = buf;
+  while(size > 0){
+    ssize_t wb = pwrite(fd, rp, size, off);
+    if(wb > 0){
+      rp += wb;
+      size -= wb;
+      off += wb;
+    } else if(wb == -1 && errno == EINTR){
+      continue;
+    } else {
+      tchdbsetecode(hdb, TCEWRITE, __FILE__, __LINE__, __func__);
+      return false;
+    }
+  }
+  return true;
+}
+
+
+/* Perform a checkpoint of the redo log.
+   `hdb' specifies the hash database object.
+   If successful, the return value is true, else, it is false.
+   Every frame has been applied to the file by its commit, so the file is only synchronized if
+   the database is opened with `HDBOTSYNC' before the log is truncated. */
+static bool tchdbrlckpt(TCHDB *hdb){
+  assert(hdb);
+  if(hdb->rlsiz < 1) return true;
+  if((hdb->omode & HDBOTSYNC) && !tchdbmemsync(hdb, true)) return false;
+  if(ftruncate(hdb->rlfd, 0) == -1){
+    tchdbsetecode(hdb, TCETRUNC, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  hdb->rlsiz = 0;
+  return true;
+}
+
+
+/* Restore the database from the redo log.
+   `hdb' specifies the hash database object.
+   `path' specifies the path of the database file.
+   If successful, the return value is true, else, it is false.
+   Frames are applied in order until the end of the log or the first frame which was not written
+   completely, and the file is truncated to the size recorded in the last applied frame. */
+static bool tchdbrlrestore(TCHDB *hdb, const char *path){
+  assert(hdb && path);
+  char *tpath = tcsprintf("%s%c%s", path, MYEXTCHR, HDBRLSUFFIX);
+  int rlfd = open(tpath, O_RDONLY, HDBFILEMODE);
+  TCFREE(tpath);
+  if(rlfd < 0) return false;
+  int dbfd = open(path, O_WRONLY, HDBFILEMODE);
+  if(dbfd < 0){
+    int ecode = TCEOPEN;
+    switch(errno){
+      case EACCES: ecode = TCENOPERM; break;
+      case ENOENT: ecode = TCENOFILE; break;
+      case ENOTDIR: ecode = TCENOFILE; break;
+    }
+    tchdbsetecode(hdb, ecode, __FILE__, __LINE__, __func__);
+    close(rlfd);
+    return false;
+  }
+  bool err = false;
+  bool done = false;
+  uint64_t fsiz = 0;
+  char hbuf[HDBRLFHSIZ];
+  while(!err && tcread(rlfd, hbuf, HDBRLFHSIZ)){
+    uint32_t crc;
+    memcpy(&crc, hbuf, sizeof(crc));
+    crc = TCITOHL(crc);
+    uint64_t bsiz;
+    memcpy(&bsiz, hbuf + sizeof(crc), sizeof(bsiz));
+    bsiz = TCITOHLL(bsiz);
+    uint64_t nfsiz;
+    memcpy(&nfsiz, hbuf + sizeof(crc) + sizeof(bsiz), sizeof(nfsiz));
+    nfsiz = TCITOHLL(nfsiz);
+    if(bsiz > INT_MAX - HDBRLFHSIZ) break;
+    char *fbuf;
+    TCMALLOC(fbuf, HDBRLFHSIZ + bsiz);
+    memcpy(fbuf, hbuf, HDBRLFHSIZ);
+    if(!tcread(rlfd, fbuf + HDBRLFHSIZ, bsiz) ||
+       tcgetcrc(fbuf + sizeof(crc), HDBRLFHSIZ - sizeof(crc) + bsiz) != crc){
+      TCFREE(fbuf);
+      break;
+    }
+    const char *rp = fbuf + HDBRLFHSIZ;
+    const char *ep = rp + bsiz;
+    while(rp + HDBRLRHSIZ <= ep){
+      uint64_t off;
+      memcpy(&off, rp, sizeof(off));
+      off = TCITOHLL(off);
+      uint32_t size;
+      memcpy(&size, rp + sizeof(off), sizeof(size));
+      size = TCITOHL(size);
+      rp += HDBRLRHSIZ;
+      if(size > ep - rp) break;
+      if(!tchdbrlpwrite(hdb, dbfd, off, rp, size)){
+        err = true;
+        break;
+      }
+      rp += size;
+    }
+    TCFREE(fbuf);
+    fsiz = nfsiz;
+    done = true;
+  }
+  if(!err && done){
+    if(ftruncate(dbfd, fsiz) == -1){
+      tchdbsetecode(hdb, TCETRUNC, __FILE__, __LINE__, __func__);
+      err = true;
+    } else if(fsync(dbfd) == -1){
+      tchdbsetecode(hdb, TCESYNC, __FILE__, __LINE__, __func__);
+      err = true;
+    }
+  }
+  if(close(dbfd) == -1){
+    tchdbsetecode(hdb, TCECLOSE, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  if(close(rlfd) == -1){
+    tchdbsetecode(hdb, TCECLOSE, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  return !err;
+}
+
+
+/* Remove the redo log file.
+   `hdb' specifies the hash database object.
+   `path' specifies the path of the database file.
+   If successful, the return value is true, else, it is false. */
+static bool tchdbrlremove(TCHDB *hdb, const char *path){
+  assert(hdb && path);
+  char *tpath = tcsprintf("%s%c%s", path, MYEXTCHR, HDBRLSUFFIX);
+  bool err = false;
+  if(unlink(tpath) == -1 && errno != ENOENT){
+    tchdbsetecode(hdb, TCEUNLINK, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  TCFREE(tpath);
+  return !err;
+}
+
+
+/* Map a database file into memory.
+   `hdb' specifies the hash database object.
+   `fd' specifies the file descriptor of the database file.
+   `xmsiz' specifies the size of the region to be mapped.
+   `omode' specifies the connection mode.
+   The return value is the pointer to the mapped region or `MAP_FAILED' on failure.
+   If huge pages are requested, the region is placed at an address aligned to the size of a huge
+   page so that the bucket array can be backed by them. */
+static void *tchdbmapfile(TCHDB *hdb, int fd, size_t xmsiz, int omode){
+  assert(hdb && fd >= 0 && xmsiz > 0);
+  int prot = PROT_READ | ((omode & HDBOWRITER) ? PROT_WRITE : 0);
+#if defined(MADV_HUGEPAGE) && defined(MAP_ANONYMOUS) && defined(MAP_NORESERVE)
+  if(hdb->mopts & HDBMHUGE){
+    size_t asiz = tcpagealign(xmsiz);
+    char *rsv = mmap(0, asiz + HDBHPAGESIZ, PROT_NONE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(rsv != MAP_FAILED){
+      char *head = (char *)(((uintptr_t)rsv + HDBHPAGESIZ - 1) & ~((uintptr_t)HDBHPAGESIZ - 1));
+      char *tail = head + asiz;
+      if(head > rsv) munmap(rsv, head - rsv);
+      if(rsv + asiz + HDBHPAGESIZ > tail) munmap(tail, rsv + asiz + HDBHPAGESIZ - tail);
+      void *map = mmap(head, xmsiz, prot, MAP_SHARED | MAP_FIXED, fd, 0);
+      if(map != MAP_FAILED) return map;
+      munmap(head, asiz);
+    }
+  }
+#endif
+  return mmap(0, xmsiz, prot, MAP_SHARED, fd, 0);
+}
+
+
+/* Apply the mapping options to the mapped region of a hash database object.
+   `hdb' specifies the hash database object.
+   `map' specifies the pointer to the mapped region.
+   `msiz' specifies the size of the region of the header and the bucket array.
+   `xmsiz' specifies the size of the whole mapped region.
+   `beg' specifies the offset of the beginning of the part to be advised, aligned to pages.
+   `end' specifies the offset of the end of the part to be advised.
+   If successful, the return value is true, else, it is false.
+   Failures of advice are ignored because the kernel may not support them. */
+static bool tchdbmapadvise(TCHDB *hdb, void *map, size_t msiz, size_t xmsiz, size_t beg,
+                           size_t end){
+  assert(hdb && map);
+  if(msiz > xmsiz) msiz = xmsiz;
+  if(end > xmsiz) end = xmsiz;
+  int mopts = hdb->mopts;
+  size_t bend = tclmin(msiz, end);
+  if(beg < bend){
+#if defined(MADV_HUGEPAGE)
+    if(mopts & HDBMHUGE) madvise((char *)map + beg, bend - beg, MADV_HUGEPAGE);
+#endif
+    if(mopts & HDBMBRANDOM) madvise((char *)map + beg, bend - beg, MADV_RANDOM);
+    if(mopts & HDBMBWILLNEED) madvise((char *)map + beg, bend - beg, MADV_WILLNEED);
+  }
+  size_t roff = tclmax(tcpagealign(msiz), beg);
+  if(roff < end){
+    if(mopts & HDBMRRANDOM) madvise((char *)map + roff, end - roff, MADV_RANDOM);
+    if(mopts & HDBMRWILLNEED) madvise((char *)map + roff, end - roff, MADV_WILLNEED);
+  }
+  if((mopts & HDBMLOCK) && beg < bend && mlock((char *)map + beg, bend - beg) == -1){
+    tchdbsetecode(hdb, TCEMMAP, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  return true;
+}
+
+
+/* Open a database file and connect a hash database object.
+   `hdb' specifies the hash database object.
+   `path' specifies the path of the database file.
+   `omode' specifies the connection mode.
+   If successful, the return value is true, else, it is false. */
+static bool tchdbopenimpl(TCHDB *hdb, const char *path, int omode){
+  assert(hdb && path);
+  int mode = O_RDONLY;
+  if(omode & HDBOWRITER){
+    mode = O_RDWR;
+    if(omode & HDBOCREAT) mode |= O_CREAT;
+  }
+  int fd = open(path, mode, HDBFILEMODE);
+  if(fd < 0){
+    int ecode = TCEOPEN;
+    switch(errno){
+      case EACCES: ecode = TCENOPERM; break;
+      case ENOENT: ecode = TCENOFILE; break;
+      case ENOTDIR: ecode = TCENOFILE; break;
+    }
+    tchdbsetecode(hdb, ecode, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  if(!(omode & HDBONOLCK)){
+    if(!tclock(fd, omode & HDBOWRITER, omode & HDBOLCKNB)){
+      tchdbsetecode(hdb, TCELOCK, __FILE__, __LINE__, __func__);
+      close(fd);
+      return false;
+    }
+  }
+  if((omode & HDBOWRITER) && (omode & HDBOTRUNC)){
+    if(ftruncate(fd, 0) == -1){
+      tchdbsetecode(hdb, TCETRUNC, __FILE__, __LINE__, __func__);
+      close(fd);
+      return false;
+    }
+    if(!tchdbwalremove(hdb, path) || !tchdbrlremove(hdb, path)){
+      close(fd);
+      return false;
+    }
+  }
+  struct stat sbuf;
+  if(fstat(fd, &sbuf) == -1 || !S_ISREG(sbuf.st_mode)){
+    tchdbsetecode(hdb, TCESTAT, __FILE__, __LINE__, __func__);
+    close(fd);
+    return false;
+  }
+  char hbuf[HDBHEADSIZ];
+  if((omode & HDBOWRITER) && sbuf.st_size < 1){
+    hdb->flags = 0;
+    hdb->rnum = 0;
+    hdb->vltail = 0;
+    hdb->vldead = 0;
+    hdb->vlgcdead = 0;
+    uint32_t fbpmax = 1 << hdb->fpow;
+    uint32_t fbpsiz = HDBFBPBSIZ + fbpmax * HDBFBPESIZ;
+    int besiz = (hdb->opts & HDBTLARGE) ? sizeof(int64_t) : sizeof(int32_t);
+    hdb->align = 1 << hdb->apow;
+    hdb->fsiz = HDBHEADSIZ + besiz * hdb->bnum + fbpsiz;
+    if(hdb->opts & HDBTFPRINT) hdb->fsiz += sizeof(uint32_t) * (hdb->bnum << hdb->fwpow);
+    hdb->fsiz += tchdbpadsize(hdb, hdb->fsiz);
+    hdb->frec = hdb->fsiz;
+    if(hdb->lhbase > hdb->bnum) hdb->lhbase = hdb->bnum;
+    hdb->lhnum = hdb->lhbase;
+    tchdbdumpmeta(hdb, hbuf);
+    bool err = false;
+    if(!tcwrite(fd, hbuf, HDBHEADSIZ)) err = true;
+    char pbuf[HDBIOBUFSIZ];
+    memset(pbuf, 0, HDBIOBUFSIZ);
+    uint64_t psiz = hdb->fsiz - HDBHEADSIZ;
+    while(psiz > 0){
+      if(psiz > HDBIOBUFSIZ){
+        if(!tcwrite(fd, pbuf, HDBIOBUFSIZ)) err = true;
+        psiz -= HDBIOBUFSIZ;
       } else {
-        bool rv;
-        int nvsiz;
-        char *nvbuf;
-        HDBPDPROCOP *procptr;
-        switch(dmode){
-          case HDBPDKEEP:
-            tchdbsetecode(hdb, TCEKEEP, __FILE__, __LINE__, __func__);
-            TCFREE(rec.bbuf);
-            return false;
-          case HDBPDCAT:
-            if(vsiz < 1){
-              TCFREE(rec.bbuf);
-              return true;
-            }
-            if(!rec.vbuf && !tchdbreadrecbody(hdb, &rec)){
-              TCFREE(rec.bbuf);
-              return false;
-            }
-            nvsiz = rec.vsiz + vsiz;
-            if(rec.bbuf){
-              TCREALLOC(rec.bbuf, rec.bbuf, rec.ksiz + nvsiz);
-              memcpy(rec.bbuf + rec.ksiz + rec.vsiz, vbuf, vsiz);
-              rec.kbuf = rec.bbuf;
-              rec.vbuf = rec.kbuf + rec.ksiz;
-              rec.vsiz = nvsiz;
+        if(!tcwrite(fd, pbuf, psiz)) err = true;
+        psiz = 0;
+      }
+    }
+    if(err){
+      tchdbsetecode(hdb, TCEWRITE, __FILE__, __LINE__, __func__);
+      close(fd);
+      return false;
+    }
+    sbuf.st_size = hdb->fsiz;
+  }
+  if(lseek(fd, 0, SEEK_SET) == -1){
+    tchdbsetecode(hdb, TCESEEK, __FILE__, __LINE__, __func__);
+    close(fd);
+    return false;
+  }
+  if(!tcread(fd, hbuf, HDBHEADSIZ)){
+    tchdbsetecode(hdb, TCEREAD, __FILE__, __LINE__, __func__);
+    close(fd);
+    return false;
+  }
+  int type = hdb->type;
+  tchdbloadmeta(hdb, hbuf);
+  if((hdb->flags & HDBFOPEN) && tchdbwalrestore(hdb, path, 0, 0)){
+    if(lseek(fd, 0, SEEK_SET) == -1){
+      tchdbsetecode(hdb, TCESEEK, __FILE__, __LINE__, __func__);
+      close(fd);
+      return false;
+    }
+    if(!tcread(fd, hbuf, HDBHEADSIZ)){
+      tchdbsetecode(hdb, TCEREAD, __FILE__, __LINE__, __func__);
+      close(fd);
+      return false;
+    }
+    tchdbloadmeta(hdb, hbuf);
+    if(!tchdbwalremove(hdb, path)){
+      close(fd);
+      return false;
+    }
+  }
+  if((hdb->flags & HDBFOPEN) && tchdbrlrestore(hdb, path)){
+    if(lseek(fd, 0, SEEK_SET) == -1){
+      tchdbsetecode(hdb, TCESEEK, __FILE__, __LINE__, __func__);
+      close(fd);
+      return false;
+    }
+    if(!tcread(fd, hbuf, HDBHEADSIZ)){
+      tchdbsetecode(hdb, TCEREAD, __FILE__, __LINE__, __func__);
+      close(fd);
+      return false;
+    }
+    tchdbloadmeta(hdb, hbuf);
+    if(!tchdbrlremove(hdb, path)){
+      close(fd);
+      return false;
+    }
+    if(fstat(fd, &sbuf) == -1){
+      tchdbsetecode(hdb, TCESTAT, __FILE__, __LINE__, __func__);
+      close(fd);
+      return false;
+    }
+  }
+  int besiz = (hdb->opts & HDBTLARGE) ? sizeof(int64_t) : sizeof(int32_t);
+  size_t msiz = HDBHEADSIZ + hdb->bnum * besiz;
+  if(hdb->opts & HDBTFPRINT) msiz += sizeof(uint32_t) * (hdb->bnum << hdb->fwpow);
+  if(!(omode & HDBONOLCK)){
+    if(memcmp(hbuf, HDBMAGICDATA, strlen(HDBMAGICDATA)) || hdb->type != type ||
+       hdb->frec < msiz + HDBFBPBSIZ || hdb->frec > hdb->fsiz || sbuf.st_size < hdb->fsiz){
+      tchdbsetecode(hdb, TCEMETA, __FILE__, __LINE__, __func__);
+      close(fd);
+      return false;
+    }
+  }
+  if(((hdb->opts & HDBTDEFLATE) && !_tc_deflate) ||
+     ((hdb->opts & HDBTBZIP) && !_tc_bzcompress) || ((hdb->opts & HDBTEXCODEC) && !hdb->enc)){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    close(fd);
+    return false;
+  }
+  size_t xmsiz = (hdb->xmsiz > msiz) ? hdb->xmsiz : msiz;
+  if(!(omode & HDBOWRITER) && xmsiz > hdb->fsiz) xmsiz = hdb->fsiz;
+  void *map = tchdbmapfile(hdb, fd, xmsiz, omode);
+  if(map == MAP_FAILED){
+    tchdbsetecode(hdb, TCEMMAP, __FILE__, __LINE__, __func__);
+    close(fd);
+    return false;
+  }
+  if(hdb->mopts && !tchdbmapadvise(hdb, map, msiz, xmsiz, 0, xmsiz)){
+    munmap(map, xmsiz);
+    close(fd);
+    return false;
+  }
+  hdb->fbpmax = 1 << hdb->fpow;
+  if(omode & HDBOWRITER){
+    hdb->fbpool = tchdbfbpnew(hdb->fbpmax * HDBFBPALWRAT);
+  } else {
+    hdb->fbpool = NULL;
+  }
+  hdb->fbpnum = 0;
+  hdb->fbpmis = 0;
+  hdb->async = false;
+  hdb->drpool = NULL;
+  hdb->drpdef = NULL;
+  hdb->drpoff = 0;
+  hdb->recc = (hdb->rcnum > 0 || hdb->rcsiz > 0) ?
+    tchdbrcnew(hdb->rcnum, hdb->rcsiz, hdb->mmtx != NULL) : NULL;
+  hdb->path = tcstrdup(path);
+  hdb->fd = fd;
+  hdb->omode = omode;
+  hdb->dfcur = hdb->frec;
+  hdb->apcur = 0;
+  hdb->apend = 0;
+  hdb->xtcur = 0;
+  hdb->xtnext = 0;
+  hdb->iter = 0;
+  hdb->map = map;
+  hdb->msiz = msiz;
+  hdb->xfsiz = 0;
+  if(hdb->opts & HDBTLARGE){
+    hdb->ba32 = NULL;
+    hdb->ba64 = (uint64_t *)((char *)map + HDBHEADSIZ);
+  } else {
+    hdb->ba32 = (uint32_t *)((char *)map + HDBHEADSIZ);
+    hdb->ba64 = NULL;
+  }
+  hdb->fpa = (hdb->opts & HDBTFPRINT) ?
+    (uint32_t *)((char *)map + HDBHEADSIZ + hdb->bnum * besiz) : NULL;
+  hdb->align = 1 << hdb->apow;
+  hdb->runit = tclmin(tclmax(hdb->align, HDBMINRUNIT), HDBIOBUFSIZ);
+  hdb->zmode = (hdb->opts & HDBTDEFLATE) || (hdb->opts & HDBTBZIP) ||
+    (hdb->opts & HDBTTCBS) || (hdb->opts & HDBTLZ) || (hdb->opts & HDBTEXCODEC);
+  hdb->ecode = TCESUCCESS;
+  hdb->fatal = false;
+  hdb->inode = (uint64_t)sbuf.st_ino;
+  hdb->mtime = sbuf.st_mtime;
+  hdb->dfcnt = 0;
+  hdb->tran = false;
+  hdb->walfd = -1;
+  hdb->walend = 0;
+  hdb->redo = NULL;
+  hdb->rlfd = -1;
+  hdb->rlsiz = 0;
+  if(hdb->omode & HDBOWRITER){
+    bool err = false;
+    if(!(hdb->flags & HDBFOPEN) && !tchdbloadfbp(hdb)) err = true;
+    memset(hbuf, 0, 2);
+    if(!tchdbseekwrite(hdb, hdb->msiz, hbuf, 2)) err = true;
+    if(!err && (omode & HDBOAPPEND) && (hdb->flags & HDBFOPEN) &&
+       !tchdbaprecover(hdb, sbuf.st_size)) err = true;
+    tchdbsetapsync(hdb, (omode & HDBOAPPEND) ? hdb->fsiz : 0);
+    tchdbsetaprel(hdb, 0);
+    if(!err && !tchdbvlopen(hdb, path, omode)) err = true;
+    if(err){
+      TCFREE(hdb->path);
+      tchdbfbpdel(hdb->fbpool);
+      hdb->fbpool = NULL;
+      hdb->fbpnum = 0;
+      munmap(hdb->map, xmsiz);
+      close(fd);
+      hdb->fd = -1;
+      return false;
+    }
+    tchdbsetflag(hdb, HDBFOPEN, true);
+  } else if(!tchdbvlopen(hdb, path, omode)){
+    TCFREE(hdb->path);
+    munmap(hdb->map, xmsiz);
+    close(fd);
+    hdb->fd = -1;
+    return false;
+  }
+  return true;
+}
+
+
+/* Close a hash database object.
+   `hdb' specifies the hash database object.
+   If successful, the return value is true, else, it is false. */
+static bool tchdbcloseimpl(TCHDB *hdb){
+  assert(hdb);
+  bool err = false;
+  if(hdb->bkup){
+    ((HDBBKUP *)hdb->bkup)->cancel = true;
+    hdb->bkup = NULL;
+  }
+  if(hdb->redo){
+    if(!tchdbrlabort(hdb)) err = true;
+    tchdbvltranabort(hdb);
+    hdb->tran = false;
+    tchdbsnapend(hdb);
+  }
+  if(!hdb->tran && !tchdbgcsync(hdb)) err = true;
+  if(hdb->recc){
+    tchdbrcdel(hdb->recc);
+    hdb->recc = NULL;
+  }
+  if(hdb->omode & HDBOWRITER){
+    if(!tchdbflushdrp(hdb)) err = true;
+    if(hdb->tran) tchdbfbpclear(hdb);
+    if(!tchdbsavefbp(hdb)) err = true;
+    tchdbfbpdel(hdb->fbpool);
+    hdb->fbpool = NULL;
+    hdb->fbpnum = 0;
+    tchdbsetflag(hdb, HDBFOPEN, false);
+  }
+  if((hdb->omode & HDBOWRITER) && !tchdbmemsync(hdb, false)) err = true;
+  size_t xmsiz = (hdb->xmsiz > hdb->msiz) ? hdb->xmsiz : hdb->msiz;
+  if(!(hdb->omode & HDBOWRITER) && xmsiz > hdb->fsiz) xmsiz = hdb->fsiz;
+  if(munmap(hdb->map, xmsiz) == -1){
+    tchdbsetecode(hdb, TCEMMAP, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  hdb->map = NULL;
+  if((hdb->omode & HDBOWRITER) && ftruncate(hdb->fd, hdb->fsiz) == -1){
+    tchdbsetecode(hdb, TCETRUNC, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  if(hdb->tran){
+    if(!tchdbwalrestore(hdb, hdb->path, hdb->gcwaloff, hdb->gcfsiz)) err = true;
+    hdb->tran = false;
+    tchdbsnapend(hdb);
+  }
+  if(hdb->walfd >= 0){
+    if(close(hdb->walfd) == -1){
+      tchdbsetecode(hdb, TCECLOSE, __FILE__, __LINE__, __func__);
+      err = true;
+    }
+    if(!hdb->fatal && !tchdbwalremove(hdb, hdb->path)) err = true;
+  }
+  if(hdb->rlfd >= 0){
+    if(close(hdb->rlfd) == -1){
+      tchdbsetecode(hdb, TCECLOSE, __FILE__, __LINE__, __func__);
+      err = true;
+    }
+    hdb->rlfd = -1;
+    if(!hdb->fatal && hdb->rlsiz < 1 && !tchdbrlremove(hdb, hdb->path)) err = true;
+  }
+  if(hdb->uring){
+    tchdburingdel(hdb->uring);
+    hdb->uring = NULL;
+  }
+  if(hdb->iscan){
+    tchdbscanclear(hdb->iscan);
+    TCFREE(hdb->iscan);
+    hdb->iscan = NULL;
+  }
+  tchdbxtreset(hdb);
+  if(hdb->pins){
+    tcmapdel(hdb->pinrecs);
+    tcmapdel(hdb->pins);
+    hdb->pins = NULL;
+    hdb->pinrecs = NULL;
+    hdb->pinnum = 0;
+  }
+  if(hdb->vlfd >= 0){
+    if(close(hdb->vlfd) == -1){
+      tchdbsetecode(hdb, TCECLOSE, __FILE__, __LINE__, __func__);
+      err = true;
+    }
+    hdb->vlfd = -1;
+  }
+  if(close(hdb->fd) == -1){
+    tchdbsetecode(hdb, TCECLOSE, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  TCFREE(hdb->path);
+  hdb->path = NULL;
+  hdb->fd = -1;
+  return !err;
+}
+
+
+/* Store a record.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `bidx' specifies the index of the bucket array.
+   `hash' specifies the hash value for the collision tree.
+   `vbuf' specifies the pointer to the region of the value.
+   `vsiz' specifies the size of the region of the value.
+   `dmode' specifies behavior when the key overlaps.
+   `xtime' specifies the expiration time of the stored record.  0 means that it never expires.
+   `HDBXTINHERIT' means that the expiration time of the existing record is kept.
+   If successful, the return value is true, else, it is false.
+   A record which has expired is treated as missing and its region is reused. */
+static bool tchdbputimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash,
+                         const char *vbuf, int vsiz, int dmode, uint32_t xtime){
+  assert(hdb && kbuf && ksiz >= 0);
+  if(hdb->recc) tchdbrcout(hdb, kbuf, ksiz);
+  if(xtime > 0 && xtime != HDBXTINHERIT && !(hdb->flags & HDBFEXPIRE)){
+    if(!HDBLOCKDB(hdb)) return false;
+    tchdbsetflag(hdb, HDBFEXPIRE, true);
+    HDBUNLOCKDB(hdb);
+  }
+  off_t off = tchdbgetbucket(hdb, bidx);
+  off_t entoff = 0;
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ];
+  char pbuf[HDBVLPTRSIZ];
+  while(off > 0){
+    rec.off = off;
+    tcstatsadd(hdb->stats, TCSCCHAIN, 1);
+    if(!tchdbreadrec(hdb, &rec, rbuf)) return false;
+    if(hash > rec.hash){
+      off = rec.left;
+      entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t));
+    } else if(hash < rec.hash){
+      off = rec.right;
+      entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t)) +
+        (hdb->ba64 ? sizeof(uint64_t) : sizeof(uint32_t));
+    } else {
+      if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)) return false;
+      int kcmp = tcreckeycmp(kbuf, ksiz, rec.kbuf, rec.ksiz);
+      if(kcmp > 0){
+        off = rec.left;
+        TCFREE(rec.bbuf);
+        rec.kbuf = NULL;
+        rec.bbuf = NULL;
+        entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t));
+      } else if(kcmp < 0){
+        off = rec.right;
+        TCFREE(rec.bbuf);
+        rec.kbuf = NULL;
+        rec.bbuf = NULL;
+        entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t)) +
+          (hdb->ba64 ? sizeof(uint64_t) : sizeof(uint32_t));
+      } else {
+        bool rv;
+        int nvsiz;
+        char *nvbuf;
+        HDBPDPROCOP *procptr;
+        uint64_t vloff;
+        uint32_t vlsiz;
+        if(rec.magic != HDBMAGICREC){
+          if(!vbuf){
+            rv = tchdbvlpeek(hdb, &rec, &vloff, &vlsiz);
+            TCFREE(rec.bbuf);
+            if(rv && tchdbremoverec(hdb, &rec, rbuf, bidx, entoff)){
+              tchdbvlrelease(hdb, vloff, vlsiz);
+              tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+            }
+            return false;
+          }
+          dmode = HDBPDOVER;
+          rec.xtime = 0;
+        }
+        if(dmode != HDBPDKEEP && !tchdbvlpeek(hdb, &rec, &vloff, &vlsiz)){
+          TCFREE(rec.bbuf);
+          return false;
+        }
+        switch(dmode){
+          case HDBPDKEEP:
+            tchdbsetecode(hdb, TCEKEEP, __FILE__, __LINE__, __func__);
+            TCFREE(rec.bbuf);
+            return false;
+          case HDBPDCAT:
+            if(vsiz < 1){
+              TCFREE(rec.bbuf);
+              return true;
+            }
+            if(!tchdbreadrecvalue(hdb, &rec)){
+              TCFREE(rec.bbuf);
+              return false;
+            }
+            nvsiz = rec.vsiz + vsiz;
+            if(rec.bbuf){
+              TCREALLOC(rec.bbuf, rec.bbuf, rec.ksiz + nvsiz);
+              memcpy(rec.bbuf + rec.ksiz + rec.vsiz, vbuf, vsiz);
+              rec.kbuf = rec.bbuf;
+              rec.vbuf = rec.kbuf + rec.ksiz;
+              rec.vsiz = nvsiz;
+            } else {
+              TCMALLOC(rec.bbuf, nvsiz + 1);
+              memcpy(rec.bbuf, rec.vbuf, rec.vsiz);
+              memcpy(rec.bbuf + rec.vsiz, vbuf, vsiz);
+              rec.vbuf = rec.bbuf;
+              rec.vsiz = nvsiz;
+            }
+            rv = tchdbvlput(hdb, &rec, pbuf) && tchdbrewriterec(hdb, &rec, bidx, entoff);
+            if(rv) tchdbvlrelease(hdb, vloff, vlsiz);
+            TCFREE(rec.bbuf);
+            return rv;
+          case HDBPDADDINT:
+            if(rec.vlog && !tchdbreadrecvalue(hdb, &rec)){
+              TCFREE(rec.bbuf);
+              return false;
+            }
+            if(rec.vsiz != sizeof(int)){
+              tchdbsetecode(hdb, TCEKEEP, __FILE__, __LINE__, __func__);
+              TCFREE(rec.bbuf);
+              return false;
+            }
+            if(!rec.vbuf && !tchdbreadrecbody(hdb, &rec)){
+              TCFREE(rec.bbuf);
+              return false;
+            }
+            int lnum;
+            memcpy(&lnum, rec.vbuf, sizeof(lnum));
+            if(*(int *)vbuf == 0){
+              TCFREE(rec.bbuf);
+              *(int *)vbuf = lnum;
+              return true;
+            }
+            lnum += *(int *)vbuf;
+            rec.vbuf = (char *)&lnum;
+            *(int *)vbuf = lnum;
+            rv = tchdbvlput(hdb, &rec, pbuf) && tchdbrewriterec(hdb, &rec, bidx, entoff);
+            if(rv) tchdbvlrelease(hdb, vloff, vlsiz);
+            TCFREE(rec.bbuf);
+            return rv;
+          case HDBPDADDDBL:
+            if(rec.vlog && !tchdbreadrecvalue(hdb, &rec)){
+              TCFREE(rec.bbuf);
+              return false;
+            }
+            if(rec.vsiz != sizeof(double)){
+              tchdbsetecode(hdb, TCEKEEP, __FILE__, __LINE__, __func__);
+              TCFREE(rec.bbuf);
+              return false;
+            }
+            if(!rec.vbuf && !tchdbreadrecbody(hdb, &rec)){
+              TCFREE(rec.bbuf);
+              return false;
+            }
+            double dnum;
+            memcpy(&dnum, rec.vbuf, sizeof(dnum));
+            if(*(double *)vbuf == 0.0){
+              TCFREE(rec.bbuf);
+              *(double *)vbuf = dnum;
+              return true;
+            }
+            dnum += *(double *)vbuf;
+            rec.vbuf = (char *)&dnum;
+            *(double *)vbuf = dnum;
+            rv = tchdbvlput(hdb, &rec, pbuf) && tchdbrewriterec(hdb, &rec, bidx, entoff);
+            if(rv) tchdbvlrelease(hdb, vloff, vlsiz);
+            TCFREE(rec.bbuf);
+            return rv;
+          case HDBPDPROC:
+            if(!tchdbreadrecvalue(hdb, &rec)){
+              TCFREE(rec.bbuf);
+              return false;
+            }
+            procptr = *(HDBPDPROCOP **)((char *)kbuf - sizeof(procptr));
+            nvbuf = procptr->proc(rec.vbuf, rec.vsiz, &nvsiz, procptr->op);
+            TCFREE(rec.bbuf);
+            if(nvbuf == (void *)-1){
+              if(!tchdbremoverec(hdb, &rec, rbuf, bidx, entoff)) return false;
+              tchdbvlrelease(hdb, vloff, vlsiz);
+              return true;
+            } else if(nvbuf){
+              rec.kbuf = kbuf;
+              rec.ksiz = ksiz;
+              rec.vbuf = nvbuf;
+              rec.vsiz = nvsiz;
+              rv = tchdbvlput(hdb, &rec, pbuf) && tchdbrewriterec(hdb, &rec, bidx, entoff);
+              if(rv) tchdbvlrelease(hdb, vloff, vlsiz);
+              TCFREE(nvbuf);
+              return rv;
+            }
+            tchdbsetecode(hdb, TCEKEEP, __FILE__, __LINE__, __func__);
+            return false;
+          default:
+            break;
+        }
+        TCFREE(rec.bbuf);
+        rec.ksiz = ksiz;
+        rec.vsiz = vsiz;
+        rec.kbuf = kbuf;
+        rec.vbuf = vbuf;
+        if(xtime != HDBXTINHERIT) rec.xtime = xtime;
+        if(!tchdbvlput(hdb, &rec, pbuf) || !tchdbrewriterec(hdb, &rec, bidx, entoff)) return false;
+        tchdbvlrelease(hdb, vloff, vlsiz);
+        return true;
+      }
+    }
+  }
+  if(!vbuf){
+    tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  rec.vsiz = vsiz;
+  rec.kbuf = kbuf;
+  rec.vbuf = vbuf;
+  rec.xtime = (xtime != HDBXTINHERIT) ? xtime : 0;
+  if(!tchdbvlput(hdb, &rec, pbuf)) return false;
+  vsiz = rec.vsiz;
+  if(!HDBLOCKDB(hdb)) return false;
+  rec.rsiz = hdb->ba64 ? sizeof(uint8_t) * 2 + sizeof(uint64_t) * 2 + sizeof(uint16_t) :
+    sizeof(uint8_t) * 2 + sizeof(uint32_t) * 2 + sizeof(uint16_t);
+  if(rec.xtime > 0) rec.rsiz += sizeof(uint32_t);
+  if(ksiz < (1U << 7)){
+    rec.rsiz += 1;
+  } else if(ksiz < (1U << 14)){
+    rec.rsiz += 2;
+  } else if(ksiz < (1U << 21)){
+    rec.rsiz += 3;
+  } else if(ksiz < (1U << 28)){
+    rec.rsiz += 4;
+  } else {
+    rec.rsiz += 5;
+  }
+  if(vsiz < (1U << 7)){
+    rec.rsiz += 1;
+  } else if(vsiz < (1U << 14)){
+    rec.rsiz += 2;
+  } else if(vsiz < (1U << 21)){
+    rec.rsiz += 3;
+  } else if(vsiz < (1U << 28)){
+    rec.rsiz += 4;
+  } else {
+    rec.rsiz += 5;
+  }
+  if(!tchdbfbpsearch(hdb, &rec)){
+    HDBUNLOCKDB(hdb);
+    return false;
+  }
+  rec.hash = hash;
+  rec.left = 0;
+  rec.right = 0;
+  rec.ksiz = ksiz;
+  rec.psiz = 0;
+  if(!tchdbwriterec(hdb, &rec, bidx, entoff)){
+    HDBUNLOCKDB(hdb);
+    return false;
+  }
+  hdb->rnum++;
+  uint64_t llnum = hdb->rnum;
+  llnum = TCHTOILL(llnum);
+  memcpy(hdb->map + HDBRNUMOFF, &llnum, sizeof(llnum));
+  HDBUNLOCKDB(hdb);
+  return true;
+}
+
+
+/* Append a record to the delayed record pool.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `vbuf' specifies the pointer to the region of the value.
+   `vsiz' specifies the size of the region of the value.
+   `hash' specifies the second hash value. */
+static void tchdbdrpappend(TCHDB *hdb, const char *kbuf, int ksiz, const char *vbuf, int vsiz,
+                           uint8_t hash){
+  assert(hdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  TCDODEBUG(hdb->cnt_appenddrp++);
+  char rbuf[HDBIOBUFSIZ];
+  char *wp = rbuf;
+  *(uint8_t *)(wp++) = HDBMAGICREC;
+  *(uint8_t *)(wp++) = hash;
+  if(hdb->ba64){
+    memset(wp, 0, sizeof(uint64_t) * 2);
+    wp += sizeof(uint64_t) * 2;
+  } else {
+    memset(wp, 0, sizeof(uint32_t) * 2);
+    wp += sizeof(uint32_t) * 2;
+  }
+  uint16_t snum;
+  char *pwp = wp;
+  wp += sizeof(snum);
+  int step;
+  TCSETVNUMBUF(step, wp, ksiz);
+  wp += step;
+  TCSETVNUMBUF(step, wp, vsiz);
+  wp += step;
+  int32_t hsiz = wp - rbuf;
+  int32_t rsiz = hsiz + ksiz + vsiz;
+  uint16_t psiz = tchdbpadsize(hdb, hdb->fsiz + rsiz);
+  hdb->fsiz += rsiz + psiz;
+  snum = TCHTOIS(psiz);
+  memcpy(pwp, &snum, sizeof(snum));
+  TCXSTR *drpool = hdb->drpool;
+  TCXSTRCAT(drpool, rbuf, hsiz);
+  TCXSTRCAT(drpool, kbuf, ksiz);
+  TCXSTRCAT(drpool, vbuf, vsiz);
+  if(psiz > 0){
+    char pbuf[psiz];
+    memset(pbuf, 0, psiz);
+    TCXSTRCAT(drpool, pbuf, psiz);
+  }
+}
+
+
+/* Store a record in asynchronus fashion.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `bidx' specifies the index of the bucket array.
+   `hash' specifies the hash value for the collision tree.
+   `vbuf' specifies the pointer to the region of the value.
+   `vsiz' specifies the size of the region of the value.
+   If successful, the return value is true, else, it is false. */
+static bool tchdbputasyncimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx,
+                              uint8_t hash, const char *vbuf, int vsiz){
+  assert(hdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  if(hdb->vlfd >= 0 && hdb->vlthres > 0 && vsiz >= hdb->vlthres){
+    if(!tchdbflushdrp(hdb)) return false;
+    return tchdbputimpl(hdb, kbuf, ksiz, bidx, hash, vbuf, vsiz, HDBPDOVER, 0);
+  }
+  if(hdb->recc) tchdbrcout(hdb, kbuf, ksiz);
+  if(!hdb->drpool){
+    hdb->drpool = tcxstrnew3(HDBDRPUNIT + HDBDRPLAT);
+    hdb->drpdef = tcxstrnew3(HDBDRPUNIT);
+    hdb->drpoff = hdb->fsiz;
+  }
+  off_t off = tchdbgetbucket(hdb, bidx);
+  off_t entoff = 0;
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ];
+  while(off > 0){
+    if(off >= hdb->drpoff - hdb->runit){
+      TCDODEBUG(hdb->cnt_deferdrp++);
+      TCXSTR *drpdef = hdb->drpdef;
+      TCXSTRCAT(drpdef, &ksiz, sizeof(ksiz));
+      TCXSTRCAT(drpdef, &vsiz, sizeof(vsiz));
+      TCXSTRCAT(drpdef, kbuf, ksiz);
+      TCXSTRCAT(drpdef, vbuf, vsiz);
+      if(TCXSTRSIZE(hdb->drpdef) > HDBDRPUNIT && !tchdbflushdrp(hdb)) return false;
+      return true;
+    }
+    rec.off = off;
+    if(!tchdbreadrec(hdb, &rec, rbuf)) return false;
+    if(hash > rec.hash){
+      off = rec.left;
+      entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t));
+    } else if(hash < rec.hash){
+      off = rec.right;
+      entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t)) +
+        (hdb->ba64 ? sizeof(uint64_t) : sizeof(uint32_t));
+    } else {
+      TCDODEBUG(hdb->cnt_deferdrp++);
+      TCXSTR *drpdef = hdb->drpdef;
+      TCXSTRCAT(drpdef, &ksiz, sizeof(ksiz));
+      TCXSTRCAT(drpdef, &vsiz, sizeof(vsiz));
+      TCXSTRCAT(drpdef, kbuf, ksiz);
+      TCXSTRCAT(drpdef, vbuf, vsiz);
+      if(TCXSTRSIZE(hdb->drpdef) > HDBDRPUNIT && !tchdbflushdrp(hdb)) return false;
+      return true;
+    }
+  }
+  if(entoff > 0){
+    if(hdb->ba64){
+      uint64_t llnum = hdb->fsiz >> hdb->apow;
+      llnum = TCHTOILL(llnum);
+      if(!tchdbseekwrite(hdb, entoff, &llnum, sizeof(uint64_t))) return false;
+    } else {
+      uint32_t lnum = hdb->fsiz >> hdb->apow;
+      lnum = TCHTOIL(lnum);
+      if(!tchdbseekwrite(hdb, entoff, &lnum, sizeof(uint32_t))) return false;
+    }
+  } else {
+    tchdbsetbucket(hdb, bidx, hdb->fsiz);
+  }
+  tchdbfpadd(hdb, bidx, kbuf, ksiz);
+  tchdbdrpappend(hdb, kbuf, ksiz, vbuf, vsiz, hash);
+  hdb->rnum++;
+  if(TCXSTRSIZE(hdb->drpool) > HDBDRPUNIT && !tchdbflushdrp(hdb)) return false;
+  return true;
+}
+
+
+/* Remove a record of a hash database object.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `bidx' specifies the index of the bucket array.
+   `hash' specifies the hash value for the collision tree.
+   If successful, the return value is true, else, it is false.
+   A record which has expired is removed but reported as missing. */
+static bool tchdboutimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash){
+  assert(hdb && kbuf && ksiz >= 0);
+  if(hdb->recc) tchdbrcout(hdb, kbuf, ksiz);
+  if(tchdbfpmiss(hdb, bidx, kbuf, ksiz)){
+    tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  off_t off = tchdbgetbucket(hdb, bidx);
+  off_t entoff = 0;
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ];
+  while(off > 0){
+    rec.off = off;
+    tcstatsadd(hdb->stats, TCSCCHAIN, 1);
+    if(!tchdbreadrec(hdb, &rec, rbuf)) return false;
+    if(hash > rec.hash){
+      off = rec.left;
+      entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t));
+    } else if(hash < rec.hash){
+      off = rec.right;
+      entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t)) +
+        (hdb->ba64 ? sizeof(uint64_t) : sizeof(uint32_t));
+    } else {
+      if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)) return false;
+      int kcmp = tcreckeycmp(kbuf, ksiz, rec.kbuf, rec.ksiz);
+      if(kcmp > 0){
+        off = rec.left;
+        TCFREE(rec.bbuf);
+        rec.kbuf = NULL;
+        rec.bbuf = NULL;
+        entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t));
+      } else if(kcmp < 0){
+        off = rec.right;
+        TCFREE(rec.bbuf);
+        rec.kbuf = NULL;
+        rec.bbuf = NULL;
+        entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t)) +
+          (hdb->ba64 ? sizeof(uint64_t) : sizeof(uint32_t));
+      } else {
+        bool live = rec.magic == HDBMAGICREC;
+        uint64_t vloff;
+        uint32_t vlsiz;
+        bool rv = tchdbvlpeek(hdb, &rec, &vloff, &vlsiz);
+        TCFREE(rec.bbuf);
+        rec.bbuf = NULL;
+        if(!rv || !tchdbremoverec(hdb, &rec, rbuf, bidx, entoff)) return false;
+        tchdbvlrelease(hdb, vloff, vlsiz);
+        if(!live){
+          tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+          return false;
+        }
+        return true;
+      }
+    }
+  }
+  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+  return false;
+}
+
+
+/* Retrieve a record in a hash database object.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `bidx' specifies the index of the bucket array.
+   `hash' specifies the hash value for the collision tree.
+   `hbuf' specifies the buffer holding the beginning of the first record of the bucket read by
+   the caller under the record lock, or `NULL' if it is not read.
+   `hsiz' specifies the size of the data in the buffer.
+   `sp' specifies the pointer to the variable into which the size of the region of the return
+   value is assigned.
+   If successful, the return value is the pointer to the region of the value of the corresponding
+   record. */
+static char *tchdbgetimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash,
+                          char *hbuf, int hsiz, int *sp){
+  assert(hdb && kbuf && ksiz >= 0 && sp);
+  if(hdb->recc){
+    int tvsiz;
+    char *tvbuf = tchdbrcget(hdb, kbuf, ksiz, &tvsiz);
+    if(tvbuf){
+      tcstatsadd(hdb->stats, TCSCCACHE, 1);
+      if(*tvbuf == '*'){
+        tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+        TCFREE(tvbuf);
+        return NULL;
+      }
+      *sp = tvsiz - 1;
+      memmove(tvbuf, tvbuf + 1, tvsiz);
+      return tvbuf;
+    }
+  }
+  if(tchdbfpmiss(hdb, bidx, kbuf, ksiz)){
+    tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+    return NULL;
+  }
+  off_t off = tchdbgetbucket(hdb, bidx);
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ];
+  if(hsiz < (int)(sizeof(uint8_t) + sizeof(uint32_t))) hbuf = NULL;
+  while(off > 0){
+    rec.off = off;
+    tcstatsadd(hdb->stats, TCSCCHAIN, 1);
+    if(hbuf){
+      if(!tchdbparserec(hdb, &rec, hbuf, hsiz)) return NULL;
+      hbuf = NULL;
+    } else if(!tchdbreadrec(hdb, &rec, rbuf)){
+      return NULL;
+    }
+    if(hash > rec.hash){
+      off = rec.left;
+    } else if(hash < rec.hash){
+      off = rec.right;
+    } else {
+      if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)) return NULL;
+      int kcmp = tcreckeycmp(kbuf, ksiz, rec.kbuf, rec.ksiz);
+      if(kcmp > 0){
+        off = rec.left;
+        TCFREE(rec.bbuf);
+        rec.kbuf = NULL;
+        rec.bbuf = NULL;
+      } else if(kcmp < 0){
+        off = rec.right;
+        TCFREE(rec.bbuf);
+        rec.kbuf = NULL;
+        rec.bbuf = NULL;
+      } else if(rec.magic != HDBMAGICREC){
+        TCFREE(rec.bbuf);
+        break;
+      } else {
+        if(!tchdbreadrecvalue(hdb, &rec)){
+          TCFREE(rec.bbuf);
+          return NULL;
+        }
+        if(hdb->zmode){
+          int zsiz;
+          char *zbuf;
+          if(hdb->opts & HDBTDEFLATE){
+            zbuf = _tc_inflate(rec.vbuf, rec.vsiz, &zsiz, _TCZMRAW);
+          } else if(hdb->opts & HDBTBZIP){
+            zbuf = _tc_bzdecompress(rec.vbuf, rec.vsiz, &zsiz);
+          } else if(hdb->opts & HDBTTCBS){
+            zbuf = tcbsdecode(rec.vbuf, rec.vsiz, &zsiz);
+          } else if(hdb->opts & HDBTLZ){
+            zbuf = tclzdecode(rec.vbuf, rec.vsiz, &zsiz);
+          } else {
+            zbuf = hdb->dec(rec.vbuf, rec.vsiz, &zsiz, hdb->decop);
+          }
+          TCFREE(rec.bbuf);
+          if(!zbuf){
+            tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+            return NULL;
+          }
+          if(hdb->recc && rec.xtime < 1){
+            tchdbrcput(hdb, kbuf, ksiz, '=', zbuf, zsiz);
+          }
+          *sp = zsiz;
+          return zbuf;
+        }
+        if(hdb->recc && rec.xtime < 1){
+          tchdbrcput(hdb, kbuf, ksiz, '=', rec.vbuf, rec.vsiz);
+        }
+        if(rec.bbuf){
+          memmove(rec.bbuf, rec.vbuf, rec.vsiz);
+          rec.bbuf[rec.vsiz] = '\0';
+          *sp = rec.vsiz;
+          return rec.bbuf;
+        }
+        *sp = rec.vsiz;
+        char *rv;
+        TCMEMDUP(rv, rec.vbuf, rec.vsiz);
+        return rv;
+      }
+    }
+  }
+  if(hdb->recc){
+    tchdbrcput(hdb, kbuf, ksiz, '*', NULL, 0);
+  }
+  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+  return NULL;
+}
+
+
+/* Retrieve a record in a hash database object without copying the value.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `bidx' specifies the index of the bucket array.
+   `hash' specifies the hash value for the collision tree.
+   `sp' specifies the pointer to the variable into which the size of the region of the return
+   value is assigned.
+   `offp' specifies the pointer to the variable into which the offset of the record is assigned.
+   If successful, the return value is the pointer to the region of the value in the mapped
+   region, else, it is `NULL'.
+   The record cache is bypassed because its entries are copies. */
+static const char *tchdbgetpinimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx,
+                                   uint8_t hash, int *sp, uint64_t *offp){
+  assert(hdb && kbuf && ksiz >= 0 && sp && offp);
+  if(tchdbfpmiss(hdb, bidx, kbuf, ksiz)){
+    tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+    return NULL;
+  }
+  off_t off = tchdbgetbucket(hdb, bidx);
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ];
+  while(off > 0){
+    rec.off = off;
+    tcstatsadd(hdb->stats, TCSCCHAIN, 1);
+    if(!tchdbreadrec(hdb, &rec, rbuf)) return NULL;
+    if(hash > rec.hash){
+      off = rec.left;
+    } else if(hash < rec.hash){
+      off = rec.right;
+    } else {
+      if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)) return NULL;
+      int kcmp = tcreckeycmp(kbuf, ksiz, rec.kbuf, rec.ksiz);
+      TCFREE(rec.bbuf);
+      if(kcmp > 0){
+        off = rec.left;
+      } else if(kcmp < 0){
+        off = rec.right;
+      } else if(rec.magic != HDBMAGICREC){
+        break;
+      } else {
+        uint64_t voff = rec.boff + rec.ksiz;
+        if(hdb->zmode || rec.vlog || voff + rec.vsiz > hdb->xmsiz){
+          tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+          return NULL;
+        }
+        *sp = rec.vsiz;
+        *offp = rec.off;
+        return hdb->map + voff;
+      }
+    }
+  }
+  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+  return NULL;
+}
+
+
+/* Check whether a record is pinned.
+   `hdb' specifies the hash database object.
+   `off' specifies the offset of the record.
+   The return value is true if the record is pinned, else, it is false.
+   The caller should hold the lock of the record, which pins are registered under, so that the
+   number of the live pins is read without the lock of the whole database when it is zero. */
+static bool tchdbpinned(TCHDB *hdb, uint64_t off){
+  assert(hdb);
+  if(hdb->pinnum < 1) return false;
+  if(!HDBLOCKDB(hdb)) return true;
+  int vsiz;
+  bool rv = hdb->pinrecs && tcmapget(hdb->pinrecs, &off, sizeof(off), &vsiz) != NULL;
+  HDBUNLOCKDB(hdb);
+  return rv;
+}
+
+
+/* Retrieve a record in a hash database object without locking the record.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `bidx' specifies the index of the bucket array.
+   `hash' specifies the hash value for the collision tree.
+   `vbp' specifies the pointer to the variable into which the pointer to the region of the value
+   of the corresponding record is assigned.  `NULL' is assigned if no record corresponds.
+   `sp' specifies the pointer to the variable into which the size of the region of the value is
+   assigned.
+   If the result is reliable, the return value is true.  Otherwise, false is returned and the
+   record should be retrieved with the record lock.
+   Records are read only from the mapped region and the result is validated by the sequence
+   number of the record lock, which is incremented by writers before and after updating.  The
+   result is put into the cache only under the record lock and only if the sequence number has
+   not changed since, so that a writer racing with the validation cannot leave a stale value
+   cached. */
+static bool tchdbgetseq(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash,
+                        char **vbp, int *sp){
+  assert(hdb && kbuf && ksiz >= 0 && vbp && sp);
+  if(hdb->recc){
+    int tvsiz;
+    char *tvbuf = tchdbrcget(hdb, kbuf, ksiz, &tvsiz);
+    if(tvbuf){
+      tcstatsadd(hdb->stats, TCSCCACHE, 1);
+      if(*tvbuf == '*'){
+        tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+        TCFREE(tvbuf);
+        *vbp = NULL;
+        return true;
+      }
+      *sp = tvsiz - 1;
+      memmove(tvbuf, tvbuf + 1, tvsiz);
+      *vbp = tvbuf;
+      return true;
+    }
+  }
+  HDBRLOCK *rlock = HDBRLOCKPTR(hdb, bidx);
+  uint32_t seq = rlock->seq;
+  __sync_synchronize();
+  if(seq & 1) return false;
+  uint64_t lim = tclmin(hdb->xmsiz, hdb->fsiz);
+  char *vbuf = NULL;
+  int vsiz = 0;
+  off_t off = tchdbfpmiss(hdb, bidx, kbuf, ksiz) ? 0 : tchdbgetbucket(hdb, bidx);
+  for(int hop = 0; off > 0; hop++){
+    if(hop >= HDBSEQHOPMAX || off + HDBMAXHSIZ > lim) return false;
+    tcstatsadd(hdb->stats, TCSCCHAIN, 1);
+    char rbuf[HDBMAXHSIZ+1];
+    memcpy(rbuf, hdb->map + off, HDBMAXHSIZ);
+    rbuf[HDBMAXHSIZ] = '\0';
+    const char *rp = rbuf;
+    if(*(uint8_t *)(rp++) != HDBMAGICREC) return false;
+    uint8_t rhash = *(uint8_t *)(rp++);
+    uint64_t left, right;
+    if(hdb->ba64){
+      uint64_t llnum;
+      memcpy(&llnum, rp, sizeof(llnum));
+      left = TCITOHLL(llnum) << hdb->apow;
+      rp += sizeof(llnum);
+      memcpy(&llnum, rp, sizeof(llnum));
+      right = TCITOHLL(llnum) << hdb->apow;
+      rp += sizeof(llnum);
+    } else {
+      uint32_t lnum;
+      memcpy(&lnum, rp, sizeof(lnum));
+      left = (uint64_t)TCITOHL(lnum) << hdb->apow;
+      rp += sizeof(lnum);
+      memcpy(&lnum, rp, sizeof(lnum));
+      right = (uint64_t)TCITOHL(lnum) << hdb->apow;
+      rp += sizeof(lnum);
+    }
+    rp += sizeof(uint16_t);
+    uint32_t rksiz, rvsiz;
+    int step;
+    TCREADVNUMBUF(rp, rksiz, step);
+    rp += step;
+    if(rp - rbuf > HDBMAXHSIZ) return false;
+    TCREADVNUMBUF(rp, rvsiz, step);
+    rp += step;
+    int32_t hsiz = rp - rbuf;
+    if(hsiz > HDBMAXHSIZ || off + hsiz + (uint64_t)rksiz + rvsiz > lim) return false;
+    if(hash > rhash){
+      off = left;
+    } else if(hash < rhash){
+      off = right;
+    } else {
+      int kcmp = tcreckeycmp(kbuf, ksiz, hdb->map + off + hsiz, rksiz);
+      if(kcmp > 0){
+        off = left;
+      } else if(kcmp < 0){
+        off = right;
+      } else {
+        TCMEMDUP(vbuf, hdb->map + off + hsiz + rksiz, rvsiz);
+        vsiz = rvsiz;
+        break;
+      }
+    }
+  }
+  __sync_synchronize();
+  if(rlock->seq != seq){
+    TCFREE(vbuf);
+    return false;
+  }
+  if(!vbuf){
+    if(hdb->recc && HDBLOCKRECORD(hdb, bidx, false)){
+      if(rlock->seq == seq) tchdbrcput(hdb, kbuf, ksiz, '*', NULL, 0);
+      HDBUNLOCKRECORD(hdb, bidx);
+    }
+    tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+    *vbp = NULL;
+    return true;
+  }
+  if(hdb->zmode){
+    int zsiz;
+    char *zbuf;
+    if(hdb->opts & HDBTDEFLATE){
+      zbuf = _tc_inflate(vbuf, vsiz, &zsiz, _TCZMRAW);
+    } else if(hdb->opts & HDBTBZIP){
+      zbuf = _tc_bzdecompress(vbuf, vsiz, &zsiz);
+    } else if(hdb->opts & HDBTTCBS){
+      zbuf = tcbsdecode(vbuf, vsiz, &zsiz);
+    } else if(hdb->opts & HDBTLZ){
+      zbuf = tclzdecode(vbuf, vsiz, &zsiz);
+    } else {
+      zbuf = hdb->dec(vbuf, vsiz, &zsiz, hdb->decop);
+    }
+    TCFREE(vbuf);
+    if(!zbuf){
+      tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+      *vbp = NULL;
+      return true;
+    }
+    vbuf = zbuf;
+    vsiz = zsiz;
+  }
+  if(hdb->recc && HDBLOCKRECORD(hdb, bidx, false)){
+    if(rlock->seq == seq) tchdbrcput(hdb, kbuf, ksiz, '=', vbuf, vsiz);
+    HDBUNLOCKRECORD(hdb, bidx);
+  }
+  *vbp = vbuf;
+  *sp = vsiz;
+  return true;
+}
+
+
+/* Begin the reader snapshot of the transaction of a hash database object.
+   `hdb' specifies the hash database object.
+   The snapshot keeps the state needed to serve the last committed records to the threads other
+   than the one which began the transaction. */
+static void tchdbsnapbegin(TCHDB *hdb){
+  assert(hdb && !hdb->snap);
+  HDBSNAP *snap;
+  TCMALLOC(snap, sizeof(*snap));
+  snap->owner = pthread_self();
+  snap->pages = tcmapnew();
+  snap->rnum = hdb->rnum;
+  snap->lhnum = hdb->lhnum;
+  snap->lhmod = hdb->lhmod;
+  hdb->snap = snap;
+}
+
+
+/* End the reader snapshot of the transaction of a hash database object.
+   `hdb' specifies the hash database object. */
+static void tchdbsnapend(TCHDB *hdb){
+  assert(hdb);
+  HDBSNAP *snap = hdb->snap;
+  if(!snap) return;
+  tcmapdel(snap->pages);
+  TCFREE(snap);
+  hdb->snap = NULL;
+}
+
+
+/* Check whether the calling thread should read from the reader snapshot.
+   `hdb' specifies the hash database object.
+   The return value is true if a transaction with a snapshot is running and the calling thread did
+   not begin it, else, it is false. */
+static bool tchdbsnapactive(TCHDB *hdb){
+  assert(hdb);
+  HDBSNAP *snap = hdb->snap;
+  return snap && hdb->tran && !pthread_equal(snap->owner, pthread_self());
+}
+
+
+/* Read data of the last committed state from the reader snapshot.
+   `hdb' specifies the hash database object.
+   `off' specifies the offset of the region to read.
+   `buf' specifies the buffer to store into.
+   `size' specifies the size of the buffer.
+   The return value is true if successful, else, it is false.
+   The current contents are read under the lock of the write ahead logging, so pages which are not
+   logged yet have not been modified, and the pre-images of logged pages are read over them.
+   With redo logging, the file itself keeps the last committed state while the transaction runs. */
+static bool tchdbsnapread(TCHDB *hdb, uint64_t off, void *buf, size_t size){
+  assert(hdb && hdb->snap && off >= 0 && buf && size >= 0);
+  if(hdb->redo) return tchdbrlpread(hdb, off, buf, size);
+  HDBSNAP *snap = hdb->snap;
+  if(!HDBLOCKWAL(hdb)) return false;
+  if(!tchdbseekread(hdb, off, buf, size)){
+    HDBUNLOCKWAL(hdb);
+    return false;
+  }
+  uint64_t end = off + size;
+  if(end > hdb->walend) end = hdb->walend;
+  for(uint64_t pidx = off / HDBSNAPPGSIZ; pidx * HDBSNAPPGSIZ < end; pidx++){
+    int vsiz;
+    const uint64_t *dp = tcmapget(snap->pages, &pidx, sizeof(pidx), &vsiz);
+    if(!dp) continue;
+    uint64_t poff = pidx * HDBSNAPPGSIZ;
+    uint64_t rbeg = tclmax(off, poff);
+    uint64_t rend = tclmin(end, poff + HDBSNAPPGSIZ);
+    char *wp = (char *)buf + (rbeg - off);
+    uint64_t roff = *dp + (rbeg - poff);
+    size_t rsiz = rend - rbeg;
+    while(rsiz > 0){
+      ssize_t rb = pread(hdb->walfd, wp, rsiz, roff);
+      if(rb > 0){
+        wp += rb;
+        rsiz -= rb;
+        roff += rb;
+      } else if(rb == -1 && errno == EINTR){
+        continue;
+      } else {
+        tchdbsetecode(hdb, TCEREAD, __FILE__, __LINE__, __func__);
+        HDBUNLOCKWAL(hdb);
+        return false;
+      }
+    }
+  }
+  HDBUNLOCKWAL(hdb);
+  return true;
+}
+
+
+/* Read the header of a record of the last committed state from the reader snapshot.
+   `hdb' specifies the hash database object.
+   `rec' specifies the record object.
+   `rbuf' specifies the buffer for reading.
+   The return value is true if successful, else, it is false. */
+static bool tchdbsnapreadrec(TCHDB *hdb, TCHREC *rec, char *rbuf){
+  assert(hdb && rec && rbuf);
+  int rsiz = hdb->runit;
+  if(rec->off + rsiz > hdb->walend){
+    rsiz = hdb->walend > rec->off ? hdb->walend - rec->off : 0;
+    if(rsiz < (int)(sizeof(uint8_t) + sizeof(uint32_t))){
+      tchdbsetecode(hdb, TCERHEAD, __FILE__, __LINE__, __func__);
+      return false;
+    }
+  }
+  if(!tchdbsnapread(hdb, rec->off, rbuf, rsiz)) return false;
+  return tchdbparserec(hdb, rec, rbuf, rsiz);
+}
+
+
+/* Read the body of a record of the last committed state from the reader snapshot.
+   `hdb' specifies the hash database object.
+   `rec' specifies the record object.
+   The return value is true if successful, else, it is false. */
+static bool tchdbsnapreadrecbody(TCHDB *hdb, TCHREC *rec){
+  assert(hdb && rec);
+  int32_t bsiz = rec->ksiz + rec->vsiz;
+  TCMALLOC(rec->bbuf, bsiz + 1);
+  if(!tchdbsnapread(hdb, rec->boff, rec->bbuf, bsiz)) return false;
+  rec->kbuf = rec->bbuf;
+  rec->vbuf = rec->bbuf + rec->ksiz;
+  return true;
+}
+
+
+/* Retrieve a record of the last committed state from the reader snapshot.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `sp' specifies the pointer to the variable into which the size of the region of the return
+   value is assigned.
+   `xtp' specifies the pointer to the variable into which the expiration time of the record is
+   assigned.  If it is `NULL', it is not used.
+   If successful, the return value is the pointer to the region of the value of the corresponding
+   record.
+   The record cache, the delayed record pool and the fingerprints are not consulted because they
+   reflect the uncommitted updates. */
+static char *tchdbsnapgetimpl(TCHDB *hdb, const char *kbuf, int ksiz, int *sp, uint32_t *xtp){
+  assert(hdb && hdb->snap && kbuf && ksiz >= 0 && sp);
+  HDBSNAP *snap = hdb->snap;
+  uint8_t hash;
+  uint64_t bidx = tchdbbidx2(hdb, kbuf, ksiz, &hash, snap->lhnum, snap->lhmod);
+  off_t off;
+  if(hdb->ba64){
+    uint64_t llnum;
+    if(!tchdbsnapread(hdb, HDBHEADSIZ + bidx * sizeof(llnum), &llnum, sizeof(llnum)))
+      return NULL;
+    off = TCITOHLL(llnum) << hdb->apow;
+  } else {
+    uint32_t lnum;
+    if(!tchdbsnapread(hdb, HDBHEADSIZ + bidx * sizeof(lnum), &lnum, sizeof(lnum)))
+      return NULL;
+    off = (off_t)TCITOHL(lnum) << hdb->apow;
+  }
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ];
+  while(off > 0){
+    rec.off = off;
+    tcstatsadd(hdb->stats, TCSCCHAIN, 1);
+    if(!tchdbsnapreadrec(hdb, &rec, rbuf)) return NULL;
+    if(rec.magic != HDBMAGICREC && rec.magic != HDBMAGICXREC){
+      tchdbsetecode(hdb, TCERHEAD, __FILE__, __LINE__, __func__);
+      return NULL;
+    }
+    if(hash > rec.hash){
+      off = rec.left;
+    } else if(hash < rec.hash){
+      off = rec.right;
+    } else {
+      if(!rec.kbuf && !tchdbsnapreadrecbody(hdb, &rec)){
+        TCFREE(rec.bbuf);
+        return NULL;
+      }
+      int kcmp = tcreckeycmp(kbuf, ksiz, rec.kbuf, rec.ksiz);
+      if(kcmp > 0){
+        off = rec.left;
+        TCFREE(rec.bbuf);
+        rec.kbuf = NULL;
+        rec.bbuf = NULL;
+      } else if(kcmp < 0){
+        off = rec.right;
+        TCFREE(rec.bbuf);
+        rec.kbuf = NULL;
+        rec.bbuf = NULL;
+      } else if(rec.magic != HDBMAGICREC){
+        TCFREE(rec.bbuf);
+        break;
+      } else {
+        if(xtp) *xtp = rec.xtime;
+        if((!rec.vbuf && !tchdbsnapreadrecbody(hdb, &rec)) || !tchdbreadrecvalue(hdb, &rec)){
+          TCFREE(rec.bbuf);
+          return NULL;
+        }
+        if(hdb->zmode){
+          int zsiz;
+          char *zbuf;
+          if(hdb->opts & HDBTDEFLATE){
+            zbuf = _tc_inflate(rec.vbuf, rec.vsiz, &zsiz, _TCZMRAW);
+          } else if(hdb->opts & HDBTBZIP){
+            zbuf = _tc_bzdecompress(rec.vbuf, rec.vsiz, &zsiz);
+          } else if(hdb->opts & HDBTTCBS){
+            zbuf = tcbsdecode(rec.vbuf, rec.vsiz, &zsiz);
+          } else if(hdb->opts & HDBTLZ){
+            zbuf = tclzdecode(rec.vbuf, rec.vsiz, &zsiz);
+          } else {
+            zbuf = hdb->dec(rec.vbuf, rec.vsiz, &zsiz, hdb->decop);
+          }
+          TCFREE(rec.bbuf);
+          if(!zbuf){
+            tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+            return NULL;
+          }
+          *sp = zsiz;
+          return zbuf;
+        }
+        if(rec.bbuf){
+          memmove(rec.bbuf, rec.vbuf, rec.vsiz);
+          rec.bbuf[rec.vsiz] = '\0';
+          *sp = rec.vsiz;
+          return rec.bbuf;
+        }
+        *sp = rec.vsiz;
+        char *rv;
+        TCMEMDUP(rv, rec.vbuf, rec.vsiz);
+        return rv;
+      }
+    }
+  }
+  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+  return NULL;
+}
+
+
+/* Retrieve a record in a hash database object and write the value into a buffer.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `bidx' specifies the index of the bucket array.
+   `hash' specifies the hash value for the collision tree.
+   `vbuf' specifies the pointer to the buffer into which the value of the corresponding record is
+   written.
+   `max' specifies the size of the buffer.
+   If successful, the return value is the size of the written data, else, it is -1. */
+static int tchdbgetintobuf(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash,
+                           char *vbuf, int max){
+  assert(hdb && kbuf && ksiz >= 0 && vbuf && max >= 0);
+  if(hdb->recc){
+    int tvsiz;
+    char *tvbuf = tchdbrcget(hdb, kbuf, ksiz, &tvsiz);
+    if(tvbuf){
+      tcstatsadd(hdb->stats, TCSCCACHE, 1);
+      if(*tvbuf == '*'){
+        tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+        TCFREE(tvbuf);
+        return -1;
+      }
+      tvsiz = tclmin(tvsiz - 1, max);
+      memcpy(vbuf, tvbuf + 1, tvsiz);
+      TCFREE(tvbuf);
+      return tvsiz;
+    }
+  }
+  off_t off = tchdbgetbucket(hdb, bidx);
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ];
+  while(off > 0){
+    rec.off = off;
+    tcstatsadd(hdb->stats, TCSCCHAIN, 1);
+    if(!tchdbreadrec(hdb, &rec, rbuf)) return -1;
+    if(hash > rec.hash){
+      off = rec.left;
+    } else if(hash < rec.hash){
+      off = rec.right;
+    } else {
+      if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)) return -1;
+      int kcmp = tcreckeycmp(kbuf, ksiz, rec.kbuf, rec.ksiz);
+      if(kcmp > 0){
+        off = rec.left;
+        TCFREE(rec.bbuf);
+        rec.kbuf = NULL;
+        rec.bbuf = NULL;
+      } else if(kcmp < 0){
+        off = rec.right;
+        TCFREE(rec.bbuf);
+        rec.kbuf = NULL;
+        rec.bbuf = NULL;
+      } else if(rec.magic != HDBMAGICREC){
+        TCFREE(rec.bbuf);
+        break;
+      } else {
+        if(!tchdbreadrecvalue(hdb, &rec)){
+          TCFREE(rec.bbuf);
+          return -1;
+        }
+        if(hdb->zmode){
+          int zsiz;
+          char *zbuf;
+          if(hdb->opts & HDBTDEFLATE){
+            zbuf = _tc_inflate(rec.vbuf, rec.vsiz, &zsiz, _TCZMRAW);
+          } else if(hdb->opts & HDBTBZIP){
+            zbuf = _tc_bzdecompress(rec.vbuf, rec.vsiz, &zsiz);
+          } else if(hdb->opts & HDBTTCBS){
+            zbuf = tcbsdecode(rec.vbuf, rec.vsiz, &zsiz);
+          } else if(hdb->opts & HDBTLZ){
+            zbuf = tclzdecode(rec.vbuf, rec.vsiz, &zsiz);
+          } else {
+            zbuf = hdb->dec(rec.vbuf, rec.vsiz, &zsiz, hdb->decop);
+          }
+          TCFREE(rec.bbuf);
+          if(!zbuf){
+            tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+            return -1;
+          }
+          if(hdb->recc && rec.xtime < 1){
+            tchdbrcput(hdb, kbuf, ksiz, '=', zbuf, zsiz);
+          }
+          zsiz = tclmin(zsiz, max);
+          memcpy(vbuf, zbuf, zsiz);
+          TCFREE(zbuf);
+          return zsiz;
+        }
+        if(hdb->recc && rec.xtime < 1){
+          tchdbrcput(hdb, kbuf, ksiz, '=', rec.vbuf, rec.vsiz);
+        }
+        int vsiz = tclmin(rec.vsiz, max);
+        memcpy(vbuf, rec.vbuf, vsiz);
+        TCFREE(rec.bbuf);
+        return vsiz;
+      }
+    }
+  }
+  if(hdb->recc){
+    tchdbrcput(hdb, kbuf, ksiz, '*', NULL, 0);
+  }
+  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+  return -1;
+}
+
+
+/* Retrieve the next record of a record in a hash database object.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `sp' specifies the pointer to the variable into which the size of the region of the return
+   value is assigned.
+   `vbp' specifies the pointer to the variable into which the pointer to the value is assigned.
+   `vsp' specifies the pointer to the variable into which the size of the value is assigned.
+   If successful, the return value is the pointer to the region of the value of the next
+   record. */
+static char *tchdbgetnextimpl(TCHDB *hdb, const char *kbuf, int ksiz, int *sp,
+                              const char **vbp, int *vsp){
+  assert(hdb && sp);
+  if(!kbuf){
+    uint64_t iter = hdb->frec;
+    TCHREC rec;
+    char rbuf[HDBIOBUFSIZ];
+    while(iter < hdb->fsiz){
+      rec.off = iter;
+      if(!tchdbreadrec(hdb, &rec, rbuf)) return NULL;
+      iter += rec.rsiz;
+      if(rec.magic == HDBMAGICREC){
+        if(vbp){
+          if(hdb->zmode){
+            if(!tchdbreadrecvalue(hdb, &rec)) return NULL;
+            int zsiz;
+            char *zbuf;
+            if(hdb->opts & HDBTDEFLATE){
+              zbuf = _tc_inflate(rec.vbuf, rec.vsiz, &zsiz, _TCZMRAW);
+            } else if(hdb->opts & HDBTBZIP){
+              zbuf = _tc_bzdecompress(rec.vbuf, rec.vsiz, &zsiz);
+            } else if(hdb->opts & HDBTTCBS){
+              zbuf = tcbsdecode(rec.vbuf, rec.vsiz, &zsiz);
+            } else if(hdb->opts & HDBTLZ){
+              zbuf = tclzdecode(rec.vbuf, rec.vsiz, &zsiz);
+            } else {
+              zbuf = hdb->dec(rec.vbuf, rec.vsiz, &zsiz, hdb->decop);
+            }
+            if(!zbuf){
+              tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+              TCFREE(rec.bbuf);
+              return NULL;
+            }
+            char *rv;
+            TCMALLOC(rv, rec.ksiz + zsiz + 1);
+            memcpy(rv, rec.kbuf, rec.ksiz);
+            memcpy(rv + rec.ksiz, zbuf, zsiz);
+            *sp = rec.ksiz;
+            *vbp = rv + rec.ksiz;
+            *vsp = zsiz;
+            TCFREE(zbuf);
+            TCFREE(rec.bbuf);
+            return rv;
+          }
+          if(rec.vbuf && !rec.vlog){
+            char *rv;
+            TCMALLOC(rv, rec.ksiz + rec.vsiz + 1);
+            memcpy(rv, rec.kbuf, rec.ksiz);
+            memcpy(rv + rec.ksiz, rec.vbuf, rec.vsiz);
+            *sp = rec.ksiz;
+            *vbp = rv + rec.ksiz;
+            *vsp = rec.vsiz;
+            return rv;
+          }
+          if(!tchdbreadrecvalue(hdb, &rec)) return NULL;
+          *sp = rec.ksiz;
+          *vbp = rec.vbuf;
+          *vsp = rec.vsiz;
+          return rec.bbuf;
+        }
+        if(rec.kbuf){
+          *sp = rec.ksiz;
+          char *rv;
+          TCMEMDUP(rv, rec.kbuf, rec.ksiz);
+          return rv;
+        }
+        if(!tchdbreadrecbody(hdb, &rec)) return NULL;
+        rec.bbuf[rec.ksiz] = '\0';
+        *sp = rec.ksiz;
+        return rec.bbuf;
+      }
+    }
+    tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+    return NULL;
+  }
+  uint8_t hash;
+  uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
+  off_t off = tchdbgetbucket(hdb, bidx);
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ];
+  while(off > 0){
+    rec.off = off;
+    if(!tchdbreadrec(hdb, &rec, rbuf)) return NULL;
+    if(hash > rec.hash){
+      off = rec.left;
+    } else if(hash < rec.hash){
+      off = rec.right;
+    } else {
+      if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)) return NULL;
+      int kcmp = tcreckeycmp(kbuf, ksiz, rec.kbuf, rec.ksiz);
+      if(kcmp > 0){
+        off = rec.left;
+        TCFREE(rec.bbuf);
+        rec.kbuf = NULL;
+        rec.bbuf = NULL;
+      } else if(kcmp < 0){
+        off = rec.right;
+        TCFREE(rec.bbuf);
+        rec.kbuf = NULL;
+        rec.bbuf = NULL;
+      } else {
+        uint64_t iter = rec.off + rec.rsiz;
+        TCFREE(rec.bbuf);
+        rec.kbuf = NULL;
+        rec.bbuf = NULL;
+        while(iter < hdb->fsiz){
+          rec.off = iter;
+          if(!tchdbreadrec(hdb, &rec, rbuf)) return NULL;
+          iter += rec.rsiz;
+          if(rec.magic == HDBMAGICREC){
+            if(vbp){
+              if(hdb->zmode){
+                if(!tchdbreadrecvalue(hdb, &rec)) return NULL;
+                int zsiz;
+                char *zbuf;
+                if(hdb->opts & HDBTDEFLATE){
+                  zbuf = _tc_inflate(rec.vbuf, rec.vsiz, &zsiz, _TCZMRAW);
+                } else if(hdb->opts & HDBTBZIP){
+                  zbuf = _tc_bzdecompress(rec.vbuf, rec.vsiz, &zsiz);
+                } else if(hdb->opts & HDBTTCBS){
+                  zbuf = tcbsdecode(rec.vbuf, rec.vsiz, &zsiz);
+                } else if(hdb->opts & HDBTLZ){
+                  zbuf = tclzdecode(rec.vbuf, rec.vsiz, &zsiz);
+                } else {
+                  zbuf = hdb->dec(rec.vbuf, rec.vsiz, &zsiz, hdb->decop);
+                }
+                if(!zbuf){
+                  tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+                  TCFREE(rec.bbuf);
+                  return NULL;
+                }
+                char *rv;
+                TCMALLOC(rv, rec.ksiz + zsiz + 1);
+                memcpy(rv, rec.kbuf, rec.ksiz);
+                memcpy(rv + rec.ksiz, zbuf, zsiz);
+                *sp = rec.ksiz;
+                *vbp = rv + rec.ksiz;
+                *vsp = zsiz;
+                TCFREE(zbuf);
+                TCFREE(rec.bbuf);
+                return rv;
+              }
+              if(rec.vbuf && !rec.vlog){
+                char *rv;
+                TCMALLOC(rv, rec.ksiz + rec.vsiz + 1);
+                memcpy(rv, rec.kbuf, rec.ksiz);
+                memcpy(rv + rec.ksiz, rec.vbuf, rec.vsiz);
+                *sp = rec.ksiz;
+                *vbp = rv + rec.ksiz;
+                *vsp = rec.vsiz;
+                return rv;
+              }
+              if(!tchdbreadrecvalue(hdb, &rec)) return NULL;
+              *sp = rec.ksiz;
+              *vbp = rec.vbuf;
+              *vsp = rec.vsiz;
+              return rec.bbuf;
+            }
+            if(rec.kbuf){
+              *sp = rec.ksiz;
+              char *rv;
+              TCMEMDUP(rv, rec.kbuf, rec.ksiz);
+              return rv;
+            }
+            if(!tchdbreadrecbody(hdb, &rec)) return NULL;
+            rec.bbuf[rec.ksiz] = '\0';
+            *sp = rec.ksiz;
+            return rec.bbuf;
+          }
+        }
+        tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+        return NULL;
+      }
+    }
+  }
+  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+  return NULL;
+}
+
+
+/* Get the size of the value of a record in a hash database object.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `bidx' specifies the index of the bucket array.
+   `hash' specifies the hash value for the collision tree.
+   If successful, the return value is the size of the value of the corresponding record, else,
+   it is -1. */
+static int tchdbvsizimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash){
+  assert(hdb && kbuf && ksiz >= 0);
+  if(hdb->recc){
+    int tvsiz;
+    char *tvbuf = tchdbrcget(hdb, kbuf, ksiz, &tvsiz);
+    if(tvbuf){
+      tcstatsadd(hdb->stats, TCSCCACHE, 1);
+      if(*tvbuf == '*'){
+        tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+        TCFREE(tvbuf);
+        return -1;
+      }
+      TCFREE(tvbuf);
+      return tvsiz - 1;
+    }
+  }
+  if(tchdbfpmiss(hdb, bidx, kbuf, ksiz)){
+    tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+    return -1;
+  }
+  off_t off = tchdbgetbucket(hdb, bidx);
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ];
+  while(off > 0){
+    rec.off = off;
+    tcstatsadd(hdb->stats, TCSCCHAIN, 1);
+    if(!tchdbreadrec(hdb, &rec, rbuf)) return -1;
+    if(hash > rec.hash){
+      off = rec.left;
+    } else if(hash < rec.hash){
+      off = rec.right;
+    } else {
+      if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)) return -1;
+      int kcmp = tcreckeycmp(kbuf, ksiz, rec.kbuf, rec.ksiz);
+      if(kcmp > 0){
+        off = rec.left;
+        TCFREE(rec.bbuf);
+        rec.kbuf = NULL;
+        rec.bbuf = NULL;
+      } else if(kcmp < 0){
+        off = rec.right;
+        TCFREE(rec.bbuf);
+        rec.kbuf = NULL;
+        rec.bbuf = NULL;
+      } else if(rec.magic != HDBMAGICREC){
+        TCFREE(rec.bbuf);
+        break;
+      } else {
+        if(hdb->zmode){
+          if(!tchdbreadrecvalue(hdb, &rec)){
+            TCFREE(rec.bbuf);
+            return -1;
+          }
+          int zsiz;
+          char *zbuf;
+          if(hdb->opts & HDBTDEFLATE){
+            zbuf = _tc_inflate(rec.vbuf, rec.vsiz, &zsiz, _TCZMRAW);
+          } else if(hdb->opts & HDBTBZIP){
+            zbuf = _tc_bzdecompress(rec.vbuf, rec.vsiz, &zsiz);
+          } else if(hdb->opts & HDBTTCBS){
+            zbuf = tcbsdecode(rec.vbuf, rec.vsiz, &zsiz);
+          } else if(hdb->opts & HDBTLZ){
+            zbuf = tclzdecode(rec.vbuf, rec.vsiz, &zsiz);
+          } else {
+            zbuf = hdb->dec(rec.vbuf, rec.vsiz, &zsiz, hdb->decop);
+          }
+          TCFREE(rec.bbuf);
+          if(!zbuf){
+            tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+            return -1;
+          }
+          if(hdb->recc && rec.xtime < 1){
+            tchdbrcput(hdb, kbuf, ksiz, '=', zbuf, zsiz);
+          }
+          TCFREE(zbuf);
+          return zsiz;
+        }
+        if(rec.vlog){
+          uint64_t voff;
+          uint32_t vsiz;
+          bool ok = (rec.vbuf || tchdbreadrecbody(hdb, &rec)) &&
+            tchdbvlgetref(hdb, &rec, &voff, &vsiz);
+          TCFREE(rec.bbuf);
+          return ok ? vsiz : -1;
+        }
+        if(hdb->recc && rec.vbuf && rec.xtime < 1){
+          tchdbrcput(hdb, kbuf, ksiz, '=', rec.vbuf, rec.vsiz);
+        }
+        TCFREE(rec.bbuf);
+        return rec.vsiz;
+      }
+    }
+  }
+  if(hdb->recc){
+    tchdbrcput(hdb, kbuf, ksiz, '*', NULL, 0);
+  }
+  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+  return -1;
+}
+
+
+/* Get the expiration time of a record in a hash database object.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `bidx' specifies the index of the bucket array.
+   `hash' specifies the hash value for the collision tree.
+   If successful, the return value is the expiration time of the corresponding record, else, it
+   is -1. */
+static int64_t tchdbgetxtimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash){
+  assert(hdb && kbuf && ksiz >= 0);
+  if(tchdbfpmiss(hdb, bidx, kbuf, ksiz)){
+    tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+    return -1;
+  }
+  off_t off = tchdbgetbucket(hdb, bidx);
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ];
+  while(off > 0){
+    rec.off = off;
+    tcstatsadd(hdb->stats, TCSCCHAIN, 1);
+    if(!tchdbreadrec(hdb, &rec, rbuf)) return -1;
+    if(hash > rec.hash){
+      off = rec.left;
+    } else if(hash < rec.hash){
+      off = rec.right;
+    } else {
+      if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)) return -1;
+      int kcmp = tcreckeycmp(kbuf, ksiz, rec.kbuf, rec.ksiz);
+      TCFREE(rec.bbuf);
+      if(kcmp > 0){
+        off = rec.left;
+      } else if(kcmp < 0){
+        off = rec.right;
+      } else if(rec.magic != HDBMAGICREC){
+        break;
+      } else {
+        return rec.xtime;
+      }
+    }
+  }
+  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+  return -1;
+}
+
+
+/* Initialize the iterator of a hash database object.
+   `hdb' specifies the hash database object.
+   If successful, the return value is true, else, it is false. */
+static bool tchdbiterinitimpl(TCHDB *hdb){
+  assert(hdb);
+  hdb->iter = hdb->frec;
+  return true;
+}
+
+
+/* Get the next key of the iterator of a hash database object.
+   `hdb' specifies the hash database object.
+   `sp' specifies the pointer to the variable into which the size of the region of the return
+   value is assigned.
+   If successful, the return value is the pointer to the region of the next key, else, it is
+   `NULL'. */
+static char *tchdbiternextimpl(TCHDB *hdb, int *sp){
+  assert(hdb && sp);
+  if(!hdb->iscan){
+    TCMALLOC(hdb->iscan, sizeof(HDBSCAN));
+    tchdbscaninit(hdb->iscan);
+  }
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ];
+  while(hdb->iter < hdb->fsiz){
+    rec.off = hdb->iter;
+    if(!tchdbscanreadrec(hdb, hdb->iscan, &rec, rbuf)) return NULL;
+    hdb->iter += rec.rsiz;
+    if(rec.magic == HDBMAGICREC){
+      if(rec.kbuf){
+        *sp = rec.ksiz;
+        char *rv;
+        TCMEMDUP(rv, rec.kbuf, rec.ksiz);
+        return rv;
+      }
+      if(!tchdbreadrecbody(hdb, &rec)) return NULL;
+      rec.bbuf[rec.ksiz] = '\0';
+      *sp = rec.ksiz;
+      return rec.bbuf;
+    }
+  }
+  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+  return NULL;
+}
+
+
+/* Get the next extensible objects of the iterator of a hash database object. */
+static bool tchdbiternextintoxstr(TCHDB *hdb, TCXSTR *kxstr, TCXSTR *vxstr){
+  assert(hdb && kxstr && vxstr);
+  if(!hdb->iscan){
+    TCMALLOC(hdb->iscan, sizeof(HDBSCAN));
+    tchdbscaninit(hdb->iscan);
+  }
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ];
+  while(hdb->iter < hdb->fsiz){
+    rec.off = hdb->iter;
+    if(!tchdbscanreadrec(hdb, hdb->iscan, &rec, rbuf)) return false;
+    hdb->iter += rec.rsiz;
+    if(rec.magic == HDBMAGICREC){
+      if(!tchdbreadrecvalue(hdb, &rec)){
+        TCFREE(rec.bbuf);
+        return false;
+      }
+      tcxstrclear(kxstr);
+      TCXSTRCAT(kxstr, rec.kbuf, rec.ksiz);
+      tcxstrclear(vxstr);
+      if(hdb->zmode){
+        int zsiz;
+        char *zbuf;
+        if(hdb->opts & HDBTDEFLATE){
+          zbuf = _tc_inflate(rec.vbuf, rec.vsiz, &zsiz, _TCZMRAW);
+        } else if(hdb->opts & HDBTBZIP){
+          zbuf = _tc_bzdecompress(rec.vbuf, rec.vsiz, &zsiz);
+        } else if(hdb->opts & HDBTTCBS){
+          zbuf = tcbsdecode(rec.vbuf, rec.vsiz, &zsiz);
+        } else if(hdb->opts & HDBTLZ){
+          zbuf = tclzdecode(rec.vbuf, rec.vsiz, &zsiz);
+        } else {
+          zbuf = hdb->dec(rec.vbuf, rec.vsiz, &zsiz, hdb->decop);
+        }
+        if(!zbuf){
+          tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+          TCFREE(rec.bbuf);
+          return false;
+        }
+        TCXSTRCAT(vxstr, zbuf, zsiz);
+        TCFREE(zbuf);
+      } else {
+        TCXSTRCAT(vxstr, rec.vbuf, rec.vsiz);
+      }
+      TCFREE(rec.bbuf);
+      return true;
+    }
+  }
+  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+  return false;
+}
+
+
+/* Get the next record of a partition of a hash database object.
+   `hdb' specifies the hash database object.
+   `curp' specifies the pointer to the cursor, which is the offset of the next record.
+   `end' specifies the end offset of the partition.
+   `kxstr' specifies the object into which the next key is wrote down.
+   `vxstr' specifies the object into which the next value is wrote down.
+   If successful, the return value is true, else, it is false.
+   Only the record lock of the bucket of each record is taken.  As the key is known only after
+   the record is read, the block at the cursor is peeked without the lock and read again under
+   it.  The record is taken only if the bucket tree of its key refers to it, the same offset is
+   tried again if it was replaced in the meantime, and the cursor is moved to the next record
+   found by probing if the block can not be parsed. */
+static bool tchdbiternextpartimpl(TCHDB *hdb, uint64_t *curp, uint64_t end,
+                                  TCXSTR *kxstr, TCXSTR *vxstr){
+  assert(hdb && curp && kxstr && vxstr);
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ+sizeof(uint64_t)];
+  while(*curp < end){
+    bool err = false;
+    rec.off = *curp;
+    if(!tchdbpartpeek(hdb, &rec, end, rbuf, &err)){
+      if(err) return false;
+      *curp = tchdbpartprobe(hdb, *curp + 1, end);
+      continue;
+    }
+    if(rec.magic != HDBMAGICREC){
+      TCFREE(rec.bbuf);
+      *curp += rec.rsiz;
+      continue;
+    }
+    tcxstrclear(kxstr);
+    TCXSTRCAT(kxstr, rec.kbuf, rec.ksiz);
+    TCFREE(rec.bbuf);
+    uint8_t hash;
+    uint64_t bidx = tchdbbidx(hdb, TCXSTRPTR(kxstr), TCXSTRSIZE(kxstr), &hash);
+    if(hash != rec.hash){
+      *curp = tchdbpartprobe(hdb, *curp + 1, end);
+      continue;
+    }
+    if(!HDBLOCKRECORD(hdb, bidx, false)) return false;
+    bool hit = false;
+    bool dead = false;
+    bool broken = false;
+    rec.off = *curp;
+    if(!tchdbpartpeek(hdb, &rec, end, rbuf, &err)){
+      broken = true;
+    } else if(rec.magic == HDBMAGICREC && rec.ksiz == TCXSTRSIZE(kxstr) &&
+              !memcmp(rec.kbuf, TCXSTRPTR(kxstr), rec.ksiz)){
+      if(!tchdbreferred(hdb, &rec, bidx, hash, &hit)){
+        err = true;
+      } else if(!hit){
+        dead = true;
+      } else if(!tchdbreadrecvalue(hdb, &rec)){
+        err = true;
+      } else {
+        tcxstrclear(vxstr);
+        if(hdb->zmode){
+          int zsiz;
+          char *zbuf;
+          if(hdb->opts & HDBTDEFLATE){
+            zbuf = _tc_inflate(rec.vbuf, rec.vsiz, &zsiz, _TCZMRAW);
+          } else if(hdb->opts & HDBTBZIP){
+            zbuf = _tc_bzdecompress(rec.vbuf, rec.vsiz, &zsiz);
+          } else if(hdb->opts & HDBTTCBS){
+            zbuf = tcbsdecode(rec.vbuf, rec.vsiz, &zsiz);
+          } else if(hdb->opts & HDBTLZ){
+            zbuf = tclzdecode(rec.vbuf, rec.vsiz, &zsiz);
+          } else {
+            zbuf = hdb->dec(rec.vbuf, rec.vsiz, &zsiz, hdb->decop);
+          }
+          if(zbuf){
+            TCXSTRCAT(vxstr, zbuf, zsiz);
+            TCFREE(zbuf);
+          } else {
+            tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+            err = true;
+          }
+        } else {
+          TCXSTRCAT(vxstr, rec.vbuf, rec.vsiz);
+        }
+      }
+    }
+    TCFREE(rec.bbuf);
+    HDBUNLOCKRECORD(hdb, bidx);
+    if(err) return false;
+    if(hit){
+      *curp += rec.rsiz;
+      return true;
+    }
+    if(dead){
+      *curp += rec.rsiz;
+    } else if(broken){
+      *curp = tchdbpartprobe(hdb, *curp + 1, end);
+    }
+  }
+  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+  return false;
+}
+
+
+/* Peek a block of a partition of a hash database object without the record lock.
+   `hdb' specifies the hash database object.
+   `rec' specifies the record object whose offset has been set.
+   `end' specifies the end offset of the partition.
+   `rbuf' specifies the buffer whose size is `HDBIOBUFSIZ' plus eight bytes at least.
+   `errp' specifies the pointer to the variable into which whether an I/O error occurred is
+   assigned.
+   The return value is true if a whole block is parsed, else, it is false.  The error code is set
+   only on I/O errors, so that a block being written by another thread is just skipped.  If the
+   block is a record, its key is read and the region of its body should be released. */
+static bool tchdbpartpeek(TCHDB *hdb, TCHREC *rec, uint64_t end, char *rbuf, bool *errp){
+  assert(hdb && rec && rbuf && errp);
+  *errp = false;
+  rec->bbuf = NULL;
+  uint64_t off = rec->off;
+  int rsiz = tclmin(hdb->runit, end - off);
+  if(rsiz < (int)(sizeof(uint8_t) + sizeof(uint32_t))) return false;
+  if(!tchdbseekread(hdb, off, rbuf, rsiz)){
+    *errp = true;
+    return false;
+  }
+  uint8_t magic = *(uint8_t *)rbuf;
+  if(magic != HDBMAGICREC && magic != HDBMAGICVLREC && magic != HDBMAGICXREC &&
+     magic != HDBMAGICXVLREC && magic != HDBMAGICFB) return false;
+  memset(rbuf + rsiz, 0, sizeof(uint64_t));
+  if(!tchdbparserectry(hdb, rec, rbuf, rsiz)) return false;
+  if(rec->rsiz < 1 || rec->rsiz > end - off) return false;
+  if(magic == HDBMAGICFB) return true;
+  if(rec->boff - off > (uint64_t)rsiz || (uint64_t)rec->ksiz + rec->vsiz > end - off) return false;
+  if(!rec->kbuf && !tchdbreadrecbody(hdb, rec)){
+    TCFREE(rec->bbuf);
+    rec->bbuf = NULL;
+    *errp = true;
+    return false;
+  }
+  return true;
+}
+
+
+/* Find the first record at or after an offset for partitioning a hash database object.
+   `hdb' specifies the hash database object.
+   `off' specifies the offset where the search starts.
+   `end' specifies the offset where the search stops.
+   The return value is the offset of the first record found, or `end' if none is found.
+   Each aligned offset is tried in order in windows read at once.  Headers are parsed without
+   reporting errors, and a candidate must be a key with the right second hash value, end at an
+   aligned offset, link to offsets inside the file, and be followed by a block with a valid
+   magic number.  Only then is the record lock taken, and the candidate is accepted only if the
+   bucket tree of its key leads to the same offset, so that bytes of a value which look like a
+   record header are never taken. */
+static uint64_t tchdbpartprobe(TCHDB *hdb, uint64_t off, uint64_t end){
+  assert(hdb);
+  uint64_t align = hdb->align;
+  off = (off + align - 1) / align * align;
+  TCHREC rec;
+  char *wbuf;
+  TCMALLOC(wbuf, HDBPTPRBSIZ + HDBMAXHSIZ);
+  uint64_t woff = 0;
+  int wsiz = 0;
+  uint64_t rv = end;
+  for(; off < end; off += align){
+    if(off < woff || off + tclmin(hdb->runit, end - off) > woff + wsiz){
+      woff = off;
+      wsiz = tclmin(HDBPTPRBSIZ, end - off);
+      if(wsiz < (int)(sizeof(uint8_t) + sizeof(uint32_t))) break;
+      if(!tchdbseekread(hdb, woff, wbuf, wsiz)) break;
+      memset(wbuf + wsiz, 0, HDBMAXHSIZ);
+    }
+    char *rbuf = wbuf + (off - woff);
+    int rsiz = woff + wsiz - off;
+    uint8_t magic = *(uint8_t *)rbuf;
+    if(magic != HDBMAGICREC && magic != HDBMAGICVLREC && magic != HDBMAGICXREC &&
+       magic != HDBMAGICXVLREC) continue;
+    rec.off = off;
+    if(!tchdbparserectry(hdb, &rec, rbuf, rsiz) || !rec.kbuf || off + rec.rsiz > end ||
+       ((off + rec.rsiz) & (align - 1)) != 0 || rec.left >= hdb->fsiz ||
+       rec.right >= hdb->fsiz) continue;
+    uint64_t noff = off + rec.rsiz;
+    if(noff < end && noff < woff + wsiz){
+      uint8_t nmagic = *(uint8_t *)(wbuf + (noff - woff));
+      if(nmagic != HDBMAGICREC && nmagic != HDBMAGICVLREC && nmagic != HDBMAGICXREC &&
+         nmagic != HDBMAGICXVLREC && nmagic != HDBMAGICFB) continue;
+    }
+    uint8_t hash;
+    uint64_t bidx = tchdbbidx(hdb, rec.kbuf, rec.ksiz, &hash);
+    if(hash != rec.hash) continue;
+    if(!HDBLOCKRECORD(hdb, bidx, false)) break;
+    bool hit;
+    bool err = !tchdbreferred(hdb, &rec, bidx, hash, &hit);
+    HDBUNLOCKRECORD(hdb, bidx);
+    if(err) break;
+    if(hit){
+      rv = off;
+      break;
+    }
+  }
+  TCFREE(wbuf);
+  return rv;
+}
+
+
+/* Check whether the tree of a bucket of a hash database object refers to a record.
+   `hdb' specifies the hash database object.
+   `rec' specifies the record object whose key has been read.
+   `bidx' specifies the index of the bucket of the key.
+   `hash' specifies the second hash value of the key.
+   `hitp' specifies the pointer to the variable into which whether the record is referred to is
+   assigned.
+   If successful, the return value is true, else, it is false. */
+static bool tchdbreferred(TCHDB *hdb, TCHREC *rec, uint64_t bidx, uint8_t hash, bool *hitp){
+  assert(hdb && rec && rec->kbuf && hitp);
+  *hitp = false;
+  uint64_t toff = tchdbgetbucket(hdb, bidx);
+  TCHREC trec;
+  char tbuf[HDBIOBUFSIZ];
+  while(toff > 0){
+    if(toff == rec->off){
+      *hitp = true;
+      break;
+    }
+    trec.off = toff;
+    if(!tchdbreadrec(hdb, &trec, tbuf)) return false;
+    if(hash > trec.hash){
+      toff = trec.left;
+    } else if(hash < trec.hash){
+      toff = trec.right;
+    } else {
+      if(!trec.kbuf && !tchdbreadrecbody(hdb, &trec)) return false;
+      int kcmp = tcreckeycmp(rec->kbuf, rec->ksiz, trec.kbuf, trec.ksiz);
+      if(kcmp > 0){
+        toff = trec.left;
+      } else if(kcmp < 0){
+        toff = trec.right;
+      } else {
+        toff = 0;
+      }
+      TCFREE(trec.bbuf);
+    }
+  }
+  return true;
+}
+
+
+/* Recover the end of the records of a hash database object opened in append-only mode.
+   `hdb' specifies the hash database object connected as a writer.
+   `end' specifies the size of the file.
+   If successful, the return value is true, else, it is false.
+   The blocks from the end of the records synchronized last to the end of the file are scanned.
+   A record is accepted only if the tree of its bucket refers to it, and a record which is not
+   referred to before the recorded end is made a free block.  The scan stops at the first block
+   which is broken or which is not referred to beyond the recorded end, and the end of the
+   records is set there.  If the scan stops before the recorded end, it is retried from the
+   first record.  The old record of an update which was interrupted is released beforehand. */
+static bool tchdbaprecover(TCHDB *hdb, uint64_t end){
+  assert(hdb);
+  uint64_t fsiz = hdb->fsiz;
+  uint64_t start = hdb->apsync;
+  if(start < hdb->frec || start > fsiz) start = hdb->frec;
+  if(end < fsiz) end = fsiz;
+  hdb->fsiz = end;
+  bool err = false;
+  if(hdb->aprel >= hdb->frec && hdb->aprel < fsiz && !tchdbaprelease(hdb, hdb->aprel)) err = true;
+  uint64_t off = tchdbapscan(hdb, start, fsiz, end, &err);
+  if(!err && off < fsiz && start > hdb->frec) off = tchdbapscan(hdb, hdb->frec, fsiz, end, &err);
+  hdb->fsiz = off;
+  uint64_t llnum = hdb->fsiz;
+  llnum = TCHTOILL(llnum);
+  memcpy(hdb->map + HDBFSIZOFF, &llnum, sizeof(llnum));
+  return !err;
+}
+
+
+/* Scan the blocks of a hash database object opened in append-only mode.
+   `hdb' specifies the hash database object connected as a writer.
+   `off' specifies the offset of the first block.
+   `fsiz' specifies the recorded end of the records.
+   `end' specifies the size of the file.
+   `errp' specifies the pointer to a variable to which whether an error occurred is assigned.
+   The return value is the offset where the scan stopped. */
+static uint64_t tchdbapscan(TCHDB *hdb, uint64_t off, uint64_t fsiz, uint64_t end, bool *errp){
+  assert(hdb && errp);
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ+sizeof(uint64_t)];
+  bool err = false;
+  while(off < end){
+    int rsiz = tclmin(hdb->runit, end - off);
+    if(rsiz < (int)(sizeof(uint8_t) + sizeof(uint32_t))) break;
+    if(!tchdbseekread(hdb, off, rbuf, rsiz)){
+      err = true;
+      break;
+    }
+    uint8_t magic = *(uint8_t *)rbuf;
+    if(magic == HDBMAGICFB){
+      uint32_t lnum;
+      memcpy(&lnum, rbuf + sizeof(magic), sizeof(lnum));
+      uint32_t bsiz = TCITOHL(lnum);
+      if(off >= fsiz || bsiz < 1 || off + bsiz > end) break;
+      off += bsiz;
+      continue;
+    }
+    if(magic != HDBMAGICREC && magic != HDBMAGICVLREC && magic != HDBMAGICXREC &&
+       magic != HDBMAGICXVLREC) break;
+    memset(rbuf + rsiz, 0, sizeof(uint64_t));
+    rec.off = off;
+    if(!tchdbparserec(hdb, &rec, rbuf, rsiz) || rec.rsiz < 1 || off + rec.rsiz > end) break;
+    if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)){
+      err = true;
+      break;
+    }
+    uint8_t hash;
+    uint64_t bidx = tchdbbidx(hdb, rec.kbuf, rec.ksiz, &hash);
+    bool hit = false;
+    if(hash == rec.hash && !tchdbreferred(hdb, &rec, bidx, hash, &hit)) err = true;
+    TCFREE(rec.bbuf);
+    if(err) break;
+    if(!hit){
+      if(off >= fsiz) break;
+      if(!tchdbwritefb(hdb, off, rec.rsiz)){
+        err = true;
+        break;
+      }
+    }
+    off += rec.rsiz;
+  }
+  if(err) *errp = true;
+  return off;
+}
+
+
+/* Release the old record of an interrupted update of a hash database object opened in
+   append-only mode.
+   `hdb' specifies the hash database object connected as a writer.
+   `off' specifies the offset of the old record.
+   If successful, the return value is true, else, it is false.
+   The region is made a free block unless the tree of its bucket refers to the record. */
+static bool tchdbaprelease(TCHDB *hdb, uint64_t off){
+  assert(hdb && off > 0);
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ];
+  rec.off = off;
+  if(!tchdbreadrec(hdb, &rec, rbuf)) return false;
+  if(rec.magic == HDBMAGICFB) return true;
+  if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)) return false;
+  uint8_t hash;
+  uint64_t bidx = tchdbbidx(hdb, rec.kbuf, rec.ksiz, &hash);
+  bool hit = false;
+  bool err = false;
+  if(hash == rec.hash && !tchdbreferred(hdb, &rec, bidx, hash, &hit)) err = true;
+  TCFREE(rec.bbuf);
+  if(!err && !hit && !tchdbwritefb(hdb, off, rec.rsiz)) err = true;
+  return !err;
+}
+
+
+/* Load records into an empty hash database object in bulk.
+   `hdb' specifies the hash database object.
+   `feed' specifies the pointer to the function feeding the records.
+   `op' specifies an arbitrary pointer to be given as a parameter of the feeding function.
+   If successful, the return value is true, else, it is false.
+   The bucket index of each entry is computed when its run is spilled.  At the first spill, the
+   active buckets of linear hashing are grown for the number of records fed if the feed is
+   exhausted, or to the whole bucket array otherwise. */
+static bool tchdbbulkloadimpl(TCHDB *hdb, TCHDBFEED feed, void *op){
+  assert(hdb && feed);
+  bool err = false;
+  TCXSTR *chunk = tcxstrnew3(HDBBLIOBUFSIZ);
+  int ecap = HDBBLIOBUFSIZ / sizeof(HDBBLENT);
+  HDBBLENT *ents;
+  TCMALLOC(ents, sizeof(*ents) * ecap);
+  int num = 0;
+  int rnum = 0;
+  uint64_t cnum = 0;
+  while(!err){
+    int ksiz, vsiz;
+    const void *vbuf;
+    int64_t xt = 0;
+    const char *kbuf = feed(&ksiz, &vbuf, &vsiz, &xt, op);
+    if(kbuf){
+      char *zbuf = NULL;
+      if(hdb->zmode){
+        if(hdb->opts & HDBTDEFLATE){
+          zbuf = _tc_deflate(vbuf, vsiz, &vsiz, _TCZMRAW);
+        } else if(hdb->opts & HDBTBZIP){
+          zbuf = _tc_bzcompress(vbuf, vsiz, &vsiz);
+        } else if(hdb->opts & HDBTTCBS){
+          zbuf = tcbsencode(vbuf, vsiz, &vsiz);
+        } else if(hdb->opts & HDBTLZ){
+          zbuf = tclzencode(vbuf, vsiz, &vsiz);
+        } else {
+          zbuf = hdb->enc(vbuf, vsiz, &vsiz, hdb->encop);
+        }
+        if(!zbuf){
+          tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+          err = true;
+          break;
+        }
+        vbuf = zbuf;
+      }
+      uint8_t hash;
+      tchdbbidx(hdb, kbuf, ksiz, &hash);
+      if(num >= ecap){
+        ecap *= 2;
+        TCREALLOC(ents, ents, sizeof(*ents) * ecap);
+      }
+      ents[num].off = TCXSTRSIZE(chunk);
+      num++;
+      cnum++;
+      char hbuf[HDBBLHSIZ];
+      uint32_t lnum;
+      *(uint8_t *)hbuf = hash;
+      lnum = ksiz;
+      memcpy(hbuf + sizeof(uint8_t), &lnum, sizeof(lnum));
+      lnum = vsiz;
+      memcpy(hbuf + sizeof(uint8_t) + sizeof(lnum), &lnum, sizeof(lnum));
+      lnum = tchdbxtime(xt);
+      memcpy(hbuf + sizeof(uint8_t) + sizeof(lnum) * 2, &lnum, sizeof(lnum));
+      TCXSTRCAT(chunk, hbuf, HDBBLHSIZ);
+      TCXSTRCAT(chunk, kbuf, ksiz);
+      TCXSTRCAT(chunk, vbuf, vsiz);
+      if(zbuf) TCFREE(zbuf);
+    }
+    if(num > 0 && (!kbuf || TCXSTRSIZE(chunk) >= HDBBLRUNSIZ)){
+      if(rnum < 1) tchdbblsetlinear(hdb, kbuf ? hdb->bnum : cnum);
+      if(!tchdbblspill(hdb, rnum, chunk, ents, num)) err = true;
+      rnum++;
+      num = 0;
+      tcxstrclear(chunk);
+    }
+    if(!kbuf) break;
+  }
+  TCFREE(ents);
+  tcxstrdel(chunk);
+  int idnum = rnum;
+  if(!err && rnum > 0 && !tchdbblmerge(hdb, rnum, &idnum)) err = true;
+  for(int i = 0; i < idnum; i++){
+    char *rpath = tcsprintf("%s%cbulk%c%d", hdb->path, MYEXTCHR, MYEXTCHR, i);
+    if(unlink(rpath) == -1 && errno != ENOENT){
+      tchdbsetecode(hdb, TCEUNLINK, __FILE__, __LINE__, __func__);
+      err = true;
+    }
+    TCFREE(rpath);
+  }
+  return !err;
+}
+
+
+/* Grow the active buckets of linear hashing of bulk loading for a number of records.
+   `hdb' specifies the hash database object.
+   `rnum' specifies the number of records.
+   The active buckets are set as many as a database storing the records one by one would have,
+   so that every bucket index is computed in the final state of linear hashing. */
+static void tchdbblsetlinear(TCHDB *hdb, uint64_t rnum){
+  assert(hdb);
+  if(hdb->lhmod < 1) return;
+  uint64_t lhnum = tclmin(tclmax((rnum + HDBLHSPLRAT - 1) / HDBLHSPLRAT, hdb->lhnum), hdb->bnum);
+  uint64_t lhmod = hdb->lhbase;
+  while(lhmod * 2 <= lhnum){
+    lhmod *= 2;
+  }
+  hdb->lhnum = lhnum;
+  hdb->lhmod = lhmod;
+  uint64_t llnum = hdb->lhnum;
+  llnum = TCHTOILL(llnum);
+  memcpy(hdb->map + HDBLHNUMOFF, &llnum, sizeof(llnum));
+}
+
+
+/* Sort the entries of bulk loading by bucket and write them into a run file.
+   `hdb' specifies the hash database object.
+   `idx' specifies the index of the run.
+   `chunk' specifies the buffer of the entries.
+   `ents' specifies the array of the entries.
+   `num' specifies the number of the entries.
+   If successful, the return value is true, else, it is false. */
+static bool tchdbblspill(TCHDB *hdb, int idx, TCXSTR *chunk, HDBBLENT *ents, int num){
+  assert(hdb && idx >= 0 && chunk && ents && num >= 0);
+  const char *base = TCXSTRPTR(chunk);
+  for(int i = 0; i < num; i++){
+    const char *rp = base + ents[i].off;
+    uint32_t ksiz;
+    memcpy(&ksiz, rp + sizeof(uint8_t), sizeof(ksiz));
+    uint8_t hash;
+    ents[i].bidx = tchdbbidx(hdb, rp + HDBBLHSIZ, ksiz, &hash);
+  }
+  qsort(ents, num, sizeof(*ents), tchdbblentcmp);
+  char *rpath = tcsprintf("%s%cbulk%c%d", hdb->path, MYEXTCHR, MYEXTCHR, idx);
+  int fd = open(rpath, O_WRONLY | O_CREAT | O_TRUNC, HDBFILEMODE);
+  TCFREE(rpath);
+  if(fd < 0){
+    tchdbsetecode(hdb, TCEOPEN, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  bool err = false;
+  TCXSTR *obuf = tcxstrnew3(HDBBLIOBUFSIZ);
+  for(int i = 0; !err && i < num; i++){
+    const char *rp = base + ents[i].off;
+    uint32_t ksiz, vsiz;
+    memcpy(&ksiz, rp + sizeof(uint8_t), sizeof(ksiz));
+    memcpy(&vsiz, rp + sizeof(uint8_t) + sizeof(ksiz), sizeof(vsiz));
+    TCXSTRCAT(obuf, &ents[i].bidx, sizeof(ents[i].bidx));
+    TCXSTRCAT(obuf, rp, HDBBLHSIZ + ksiz + vsiz);
+    if(TCXSTRSIZE(obuf) >= HDBBLIOBUFSIZ){
+      if(!tcwrite(fd, TCXSTRPTR(obuf), TCXSTRSIZE(obuf))){
+        tchdbsetecode(hdb, TCEWRITE, __FILE__, __LINE__, __func__);
+        err = true;
+      }
+      tcxstrclear(obuf);
+    }
+  }
+  if(!err && TCXSTRSIZE(obuf) > 0 && !tcwrite(fd, TCXSTRPTR(obuf), TCXSTRSIZE(obuf))){
+    tchdbsetecode(hdb, TCEWRITE, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  tcxstrdel(obuf);
+  if(close(fd) == -1){
+    tchdbsetecode(hdb, TCECLOSE, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  return !err;
+}
+
+
+/* Merge the run files of bulk loading into the database file.
+   `hdb' specifies the hash database object.
+   `rnum' specifies the number of the runs.
+   `idnump' specifies the pointer to the variable into which the number of the run files created
+   including the intermediate ones is assigned.
+   If successful, the return value is true, else, it is false.
+   While there are more runs than `HDBBLFANIN', consecutive groups of them are merged into
+   intermediate runs, so that the number of files opened at once is bounded.  The last level is
+   merged bucket by bucket.  The records of each bucket are sorted in the order of the binary
+   search tree, laid out sequentially, and linked as a balanced tree. */
+static bool tchdbblmerge(TCHDB *hdb, int rnum, int *idnump){
+  assert(hdb && rnum > 0 && idnump);
+  bool err = false;
+  int *ids;
+  TCMALLOC(ids, sizeof(*ids) * rnum);
+  for(int i = 0; i < rnum; i++){
+    ids[i] = i;
+  }
+  int idnum = rnum;
+  while(!err && rnum > HDBBLFANIN){
+    int onum = 0;
+    for(int i = 0; !err && i < rnum; i += HDBBLFANIN){
+      int num = tclmin(rnum - i, HDBBLFANIN);
+      if(num < 2){
+        ids[onum++] = ids[i];
+        continue;
+      }
+      if(!tchdbblmergeruns(hdb, ids + i, num, idnum)) err = true;
+      ids[onum++] = idnum++;
+    }
+    rnum = onum;
+  }
+  *idnump = idnum;
+  if(err){
+    TCFREE(ids);
+    return false;
+  }
+  HDBBLRUN *runs;
+  TCMALLOC(runs, sizeof(*runs) * rnum);
+  HDBBLRUN **heap;
+  TCMALLOC(heap, sizeof(*heap) * rnum);
+  int hnum = 0;
+  for(int i = 0; i < rnum; i++){
+    HDBBLRUN *run = runs + i;
+    if(!tchdbblrunopen(hdb, run, ids[i], i)) err = true;
+    if(!run->end) heap[hnum++] = run;
+  }
+  TCFREE(ids);
+  for(int i = hnum / 2 - 1; i >= 0; i--){
+    tchdbblheapdown(heap, hnum, i);
+  }
+  int rcap = HDBBLIOBUFSIZ / sizeof(HDBBLREC);
+  HDBBLREC *recs;
+  TCMALLOC(recs, sizeof(*recs) * rcap);
+  TCXSTR *gbuf = tcxstrnew3(HDBBLIOBUFSIZ);
+  TCXSTR *obuf = tcxstrnew3(HDBBLIOBUFSIZ);
+  TCXSTR *vlbuf = tcxstrnew3(HDBBLIOBUFSIZ);
+  char zbuf[HDBMAXHSIZ];
+  memset(zbuf, 0, sizeof(zbuf));
+  uint64_t woff = hdb->fsiz;
+  uint64_t noff = woff;
+  uint64_t vwoff = hdb->vlhead;
+  uint64_t seq = 0;
+  bool xt = false;
+  while(!err && hnum > 0){
+    uint64_t bidx = heap[0]->bidx;
+    tcxstrclear(gbuf);
+    int num = 0;
+    while(!err && hnum > 0 && heap[0]->bidx == bidx){
+      HDBBLRUN *run = heap[0];
+      while(!run->end && run->bidx == bidx){
+        if(num >= rcap){
+          rcap *= 2;
+          TCREALLOC(recs, recs, sizeof(*recs) * rcap);
+        }
+        HDBBLREC *rec = recs + num++;
+        rec->ksiz = run->ksiz;
+        rec->vsiz = run->vsiz;
+        rec->hash = run->hash;
+        rec->xtime = run->xtime;
+        rec->koff = TCXSTRSIZE(gbuf);
+        rec->seq = seq++;
+        TCXSTRCAT(gbuf, run->kvbuf, run->ksiz + run->vsiz);
+        if(!tchdbblrunnext(hdb, run)){
+          err = true;
+          break;
+        }
+      }
+      if(run->end) heap[0] = heap[--hnum];
+      tchdbblheapdown(heap, hnum, 0);
+    }
+    if(err) break;
+    const char *gp = TCXSTRPTR(gbuf);
+    for(int i = 0; i < num; i++){
+      recs[i].kbuf = gp + recs[i].koff;
+    }
+    qsort(recs, num, sizeof(*recs), tchdbblreccmp);
+    int unum = 0;
+    for(int i = 0; i < num; i++){
+      if(unum > 0 && recs[i].hash == recs[unum-1].hash &&
+         tcreckeycmp(recs[i].kbuf, recs[i].ksiz, recs[unum-1].kbuf, recs[unum-1].ksiz) == 0){
+        recs[unum-1] = recs[i];
+      } else {
+        recs[unum++] = recs[i];
+      }
+    }
+    for(int i = 0; i < unum; i++){
+      HDBBLREC *rec = recs + i;
+      rec->vlog = hdb->vlfd >= 0 && hdb->vlthres > 0 && rec->vsiz >= hdb->vlthres;
+      if(rec->vlog){
+        rec->vloff = vwoff + TCXSTRSIZE(vlbuf);
+        TCXSTRCAT(vlbuf, rec->kbuf + rec->ksiz, rec->vsiz);
+      }
+      if(rec->xtime > 0) xt = true;
+      char nbuf[sizeof(uint64_t)*2];
+      int32_t hsiz = sizeof(uint8_t) * 2 + sizeof(uint16_t) +
+        (hdb->ba64 ? sizeof(uint64_t) : sizeof(uint32_t)) * 2;
+      if(rec->xtime > 0) hsiz += sizeof(uint32_t);
+      uint32_t vsiz = rec->vlog ? HDBVLPTRSIZ : rec->vsiz;
+      int step;
+      TCSETVNUMBUF(step, nbuf, rec->ksiz);
+      hsiz += step;
+      TCSETVNUMBUF(step, nbuf, vsiz);
+      hsiz += step;
+      int32_t rsiz = hsiz + rec->ksiz + vsiz;
+      rec->psiz = tchdbpadsize(hdb, noff + rsiz);
+      rec->off = noff;
+      noff += rsiz + rec->psiz;
+    }
+    uint64_t root = tchdbbltree(recs, 0, unum - 1);
+    for(int i = 0; i < unum; i++){
+      HDBBLREC *rec = recs + i;
+      char hbuf[HDBMAXHSIZ];
+      char *wp = hbuf;
+      if(rec->xtime > 0){
+        *(uint8_t *)(wp++) = rec->vlog ? HDBMAGICXVLREC : HDBMAGICXREC;
+      } else {
+        *(uint8_t *)(wp++) = rec->vlog ? HDBMAGICVLREC : HDBMAGICREC;
+      }
+      *(uint8_t *)(wp++) = rec->hash;
+      if(hdb->ba64){
+        uint64_t llnum;
+        llnum = rec->left >> hdb->apow;
+        llnum = TCHTOILL(llnum);
+        memcpy(wp, &llnum, sizeof(llnum));
+        wp += sizeof(llnum);
+        llnum = rec->right >> hdb->apow;
+        llnum = TCHTOILL(llnum);
+        memcpy(wp, &llnum, sizeof(llnum));
+        wp += sizeof(llnum);
+      } else {
+        uint32_t lnum;
+        lnum = rec->left >> hdb->apow;
+        lnum = TCHTOIL(lnum);
+        memcpy(wp, &lnum, sizeof(lnum));
+        wp += sizeof(lnum);
+        lnum = rec->right >> hdb->apow;
+        lnum = TCHTOIL(lnum);
+        memcpy(wp, &lnum, sizeof(lnum));
+        wp += sizeof(lnum);
+      }
+      uint16_t snum = TCHTOIS(rec->psiz);
+      memcpy(wp, &snum, sizeof(snum));
+      wp += sizeof(snum);
+      if(rec->xtime > 0){
+        uint32_t lnum = TCHTOIL(rec->xtime);
+        memcpy(wp, &lnum, sizeof(lnum));
+        wp += sizeof(lnum);
+      }
+      int step;
+      TCSETVNUMBUF(step, wp, rec->ksiz);
+      wp += step;
+      TCSETVNUMBUF(step, wp, rec->vlog ? HDBVLPTRSIZ : rec->vsiz);
+      wp += step;
+      TCXSTRCAT(obuf, hbuf, wp - hbuf);
+      TCXSTRCAT(obuf, rec->kbuf, rec->ksiz);
+      if(rec->vlog){
+        char pbuf[HDBVLPTRSIZ];
+        tchdbvlsetref(pbuf, rec->vloff, rec->vsiz);
+        TCXSTRCAT(obuf, pbuf, HDBVLPTRSIZ);
+      } else {
+        TCXSTRCAT(obuf, rec->kbuf + rec->ksiz, rec->vsiz);
+      }
+      int psiz = rec->psiz;
+      while(psiz > 0){
+        step = tclmin(psiz, sizeof(zbuf));
+        TCXSTRCAT(obuf, zbuf, step);
+        psiz -= step;
+      }
+      tchdbfpadd(hdb, bidx, rec->kbuf, rec->ksiz);
+    }
+    tchdbsetbucket(hdb, bidx, root);
+    hdb->rnum += unum;
+    if(TCXSTRSIZE(vlbuf) >= HDBBLIOBUFSIZ){
+      if(!tchdbvlwrite(hdb, vwoff, TCXSTRPTR(vlbuf), TCXSTRSIZE(vlbuf))) err = true;
+      vwoff += TCXSTRSIZE(vlbuf);
+      hdb->vlhead = vwoff;
+      tcxstrclear(vlbuf);
+    }
+    if(TCXSTRSIZE(obuf) >= HDBBLIOBUFSIZ){
+      if(!tchdbseekwrite(hdb, woff, TCXSTRPTR(obuf), TCXSTRSIZE(obuf))) err = true;
+      woff += TCXSTRSIZE(obuf);
+      hdb->fsiz = woff;
+      tcxstrclear(obuf);
+    }
+  }
+  if(!err && TCXSTRSIZE(vlbuf) > 0){
+    if(!tchdbvlwrite(hdb, vwoff, TCXSTRPTR(vlbuf), TCXSTRSIZE(vlbuf))) err = true;
+    vwoff += TCXSTRSIZE(vlbuf);
+    hdb->vlhead = vwoff;
+  }
+  if(!err && TCXSTRSIZE(obuf) > 0){
+    if(!tchdbseekwrite(hdb, woff, TCXSTRPTR(obuf), TCXSTRSIZE(obuf))) err = true;
+    woff += TCXSTRSIZE(obuf);
+    hdb->fsiz = woff;
+  }
+  if(xt){
+    tchdbsetflag(hdb, HDBFEXPIRE, true);
+    tchdbxtreset(hdb);
+  }
+  tcxstrdel(vlbuf);
+  tcxstrdel(obuf);
+  tcxstrdel(gbuf);
+  TCFREE(recs);
+  for(int i = 0; i < rnum; i++){
+    if(!tchdbblrunclose(hdb, runs + i)) err = true;
+  }
+  TCFREE(heap);
+  TCFREE(runs);
+  return !err;
+}
+
+
+/* Merge runs of bulk loading into an intermediate run.
+   `hdb' specifies the hash database object.
+   `ids' specifies the array of the indices of the runs in the input order.
+   `num' specifies the number of the elements of the array.
+   `oid' specifies the index of the run to be created.
+   If successful, the return value is true, else, it is false.
+   The entries are written in the order of the bucket index and then of the input, so that the
+   last value of a duplicated key still comes last.  The merged runs are removed. */
+static bool tchdbblmergeruns(TCHDB *hdb, const int *ids, int num, int oid){
+  assert(hdb && ids && num > 0 && oid >= 0);
+  char *rpath = tcsprintf("%s%cbulk%c%d", hdb->path, MYEXTCHR, MYEXTCHR, oid);
+  int fd = open(rpath, O_WRONLY | O_CREAT | O_TRUNC, HDBFILEMODE);
+  TCFREE(rpath);
+  if(fd < 0){
+    tchdbsetecode(hdb, TCEOPEN, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  bool err = false;
+  HDBBLRUN *runs;
+  TCMALLOC(runs, sizeof(*runs) * num);
+  HDBBLRUN **heap;
+  TCMALLOC(heap, sizeof(*heap) * num);
+  int hnum = 0;
+  for(int i = 0; i < num; i++){
+    HDBBLRUN *run = runs + i;
+    if(!tchdbblrunopen(hdb, run, ids[i], i)) err = true;
+    if(!run->end) heap[hnum++] = run;
+  }
+  for(int i = hnum / 2 - 1; i >= 0; i--){
+    tchdbblheapdown(heap, hnum, i);
+  }
+  TCXSTR *obuf = tcxstrnew3(HDBBLIOBUFSIZ);
+  while(!err && hnum > 0){
+    HDBBLRUN *run = heap[0];
+    char hbuf[sizeof(uint64_t)+HDBBLHSIZ];
+    memcpy(hbuf, &run->bidx, sizeof(run->bidx));
+    *(uint8_t *)(hbuf + sizeof(uint64_t)) = run->hash;
+    memcpy(hbuf + sizeof(uint64_t) + sizeof(uint8_t), &run->ksiz, sizeof(run->ksiz));
+    memcpy(hbuf + sizeof(uint64_t) + sizeof(uint8_t) + sizeof(run->ksiz), &run->vsiz,
+           sizeof(run->vsiz));
+    memcpy(hbuf + sizeof(uint64_t) + sizeof(uint8_t) + sizeof(run->ksiz) + sizeof(run->vsiz),
+           &run->xtime, sizeof(run->xtime));
+    TCXSTRCAT(obuf, hbuf, sizeof(hbuf));
+    TCXSTRCAT(obuf, run->kvbuf, run->ksiz + run->vsiz);
+    if(TCXSTRSIZE(obuf) >= HDBBLIOBUFSIZ){
+      if(!tcwrite(fd, TCXSTRPTR(obuf), TCXSTRSIZE(obuf))){
+        tchdbsetecode(hdb, TCEWRITE, __FILE__, __LINE__, __func__);
+        err = true;
+      }
+      tcxstrclear(obuf);
+    }
+    if(!tchdbblrunnext(hdb, run)) err = true;
+    if(run->end) heap[0] = heap[--hnum];
+    tchdbblheapdown(heap, hnum, 0);
+  }
+  if(!err && TCXSTRSIZE(obuf) > 0 && !tcwrite(fd, TCXSTRPTR(obuf), TCXSTRSIZE(obuf))){
+    tchdbsetecode(hdb, TCEWRITE, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  tcxstrdel(obuf);
+  if(close(fd) == -1){
+    tchdbsetecode(hdb, TCECLOSE, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  for(int i = 0; i < num; i++){
+    if(!tchdbblrunclose(hdb, runs + i)) err = true;
+    if(!err){
+      rpath = tcsprintf("%s%cbulk%c%d", hdb->path, MYEXTCHR, MYEXTCHR, ids[i]);
+      if(unlink(rpath) == -1){
+        tchdbsetecode(hdb, TCEUNLINK, __FILE__, __LINE__, __func__);
+        err = true;
+      }
+      TCFREE(rpath);
+    }
+  }
+  TCFREE(heap);
+  TCFREE(runs);
+  return !err;
+}
+
+
+/* Open a run of bulk loading and read its first entry.
+   `hdb' specifies the hash database object.
+   `run' specifies the reader of the run.
+   `id' specifies the index of the run file.
+   `idx' specifies the order of the run among the runs merged together.
+   If successful, the return value is true, else, it is false.  The reader should be closed even
+   on failure. */
+static bool tchdbblrunopen(TCHDB *hdb, HDBBLRUN *run, int id, int idx){
+  assert(hdb && run && id >= 0 && idx >= 0);
+  char *rpath = tcsprintf("%s%cbulk%c%d", hdb->path, MYEXTCHR, MYEXTCHR, id);
+  run->fd = open(rpath, O_RDONLY, HDBFILEMODE);
+  TCFREE(rpath);
+  TCMALLOC(run->buf, HDBBLIOBUFSIZ);
+  run->rp = 0;
+  run->len = 0;
+  run->end = true;
+  run->idx = idx;
+  run->kvbuf = NULL;
+  run->kvcap = 0;
+  if(run->fd < 0){
+    tchdbsetecode(hdb, TCEOPEN, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  return tchdbblrunnext(hdb, run);
+}
+
+
+/* Close a run of bulk loading.
+   `hdb' specifies the hash database object.
+   `run' specifies the reader of the run.
+   If successful, the return value is true, else, it is false. */
+static bool tchdbblrunclose(TCHDB *hdb, HDBBLRUN *run){
+  assert(hdb && run);
+  bool err = false;
+  if(run->fd >= 0 && close(run->fd) == -1){
+    tchdbsetecode(hdb, TCECLOSE, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  run->fd = -1;
+  TCFREE(run->buf);
+  if(run->kvbuf) TCFREE(run->kvbuf);
+  return !err;
+}
+
+
+/* Move down an element of the heap of the runs of bulk loading.
+   `heap' specifies the array of the runs whose current entries form a min-heap keyed on the
+   bucket index and then on the order of the run.
+   `num' specifies the number of the elements of the heap.
+   `idx' specifies the index of the element to move down. */
+static void tchdbblheapdown(HDBBLRUN **heap, int num, int idx){
+  assert(heap && num >= 0 && idx >= 0);
+  while(true){
+    int min = idx;
+    for(int child = idx * 2 + 1; child <= idx * 2 + 2 && child < num; child++){
+      HDBBLRUN *crun = heap[child];
+      HDBBLRUN *mrun = heap[min];
+      if(crun->bidx < mrun->bidx || (crun->bidx == mrun->bidx && crun->idx < mrun->idx))
+        min = child;
+    }
+    if(min == idx) break;
+    HDBBLRUN *swap = heap[idx];
+    heap[idx] = heap[min];
+    heap[min] = swap;
+    idx = min;
+  }
+}
+
+
+/* Read the next entry of a run of bulk loading.
+   `hdb' specifies the hash database object.
+   `run' specifies the reader of the run.
+   If successful, the return value is true, else, it is false.  When the run is exhausted, the
+   member `end' is set true. */
+static bool tchdbblrunnext(TCHDB *hdb, HDBBLRUN *run){
+  assert(hdb && run);
+  run->end = true;
+  if(run->rp >= run->len){
+    int rb = tchdbblrunfill(hdb, run);
+    if(rb < 0) return false;
+    if(rb == 0) return true;
+  }
+  char hbuf[sizeof(uint64_t)+HDBBLHSIZ];
+  if(!tchdbblrunread(hdb, run, hbuf, sizeof(hbuf))) return false;
+  memcpy(&run->bidx, hbuf, sizeof(run->bidx));
+  run->hash = *(uint8_t *)(hbuf + sizeof(uint64_t));
+  memcpy(&run->ksiz, hbuf + sizeof(uint64_t) + sizeof(uint8_t), sizeof(run->ksiz));
+  memcpy(&run->vsiz, hbuf + sizeof(uint64_t) + sizeof(uint8_t) + sizeof(run->ksiz),
+         sizeof(run->vsiz));
+  memcpy(&run->xtime, hbuf + sizeof(uint64_t) + sizeof(uint8_t) + sizeof(run->ksiz) +
+         sizeof(run->vsiz), sizeof(run->xtime));
+  uint32_t size = run->ksiz + run->vsiz;
+  if(size > run->kvcap || !run->kvbuf){
+    run->kvcap = size + 1;
+    TCREALLOC(run->kvbuf, run->kvbuf, run->kvcap);
+  }
+  if(!tchdbblrunread(hdb, run, run->kvbuf, size)) return false;
+  run->end = false;
+  return true;
+}
+
+
+/* Fill the buffer of a run of bulk loading.
+   `hdb' specifies the hash database object.
+   `run' specifies the reader of the run.
+   The return value is the size of the data read, 0 at the end of the run, or -1 on error. */
+static int tchdbblrunfill(TCHDB *hdb, HDBBLRUN *run){
+  assert(hdb && run);
+  while(true){
+    int rb = read(run->fd, run->buf, HDBBLIOBUFSIZ);
+    if(rb >= 0){
+      run->rp = 0;
+      run->len = rb;
+      return rb;
+    }
+    if(errno != EINTR){
+      tchdbsetecode(hdb, TCEREAD, __FILE__, __LINE__, __func__);
+      return -1;
+    }
+  }
+  return -1;
+}
+
+
+/* Read data from a run of bulk loading.
+   `hdb' specifies the hash database object.
+   `run' specifies the reader of the run.
+   `buf' specifies the buffer to store into.
+   `size' specifies the size of the data.
+   If successful, the return value is true, else, it is false. */
+static bool tchdbblrunread(TCHDB *hdb, HDBBLRUN *run, void *buf, int size){
+  assert(hdb && run && buf && size >= 0);
+  char *wp = buf;
+  while(size > 0){
+    if(run->rp >= run->len){
+      int rb = tchdbblrunfill(hdb, run);
+      if(rb < 0) return false;
+      if(rb == 0){
+        tchdbsetecode(hdb, TCEREAD, __FILE__, __LINE__, __func__);
+        return false;
+      }
+    }
+    int step = tclmin(size, run->len - run->rp);
+    memcpy(wp, run->buf + run->rp, step);
+    run->rp += step;
+    wp += step;
+    size -= step;
+  }
+  return true;
+}
+
+
+/* Link the sorted records of a bucket of bulk loading as a balanced tree.
+   `recs' specifies the array of the records sorted in ascending order.
+   `lo' specifies the index of the first record of the subtree.
+   `hi' specifies the index of the last record of the subtree.
+   The return value is the offset of the root of the subtree, or 0 if it is empty.  As the
+   search descends to the left for a bigger key, bigger records are linked on the left. */
+static uint64_t tchdbbltree(HDBBLREC *recs, int lo, int hi){
+  assert(recs);
+  if(lo > hi) return 0;
+  int mid = lo + (hi - lo) / 2;
+  recs[mid].left = tchdbbltree(recs, mid + 1, hi);
+  recs[mid].right = tchdbbltree(recs, lo, mid - 1);
+  return recs[mid].off;
+}
+
+
+/* Compare two entries of bulk loading by bucket and input order.
+   `a' specifies the pointer to one entry.
+   `b' specifies the pointer to the other entry.
+   The return value is positive if the former is big, negative if the latter is big, 0 if both
+   are equivalent. */
+static int tchdbblentcmp(const void *a, const void *b){
+  assert(a && b);
+  const HDBBLENT *ea = a;
+  const HDBBLENT *eb = b;
+  if(ea->bidx != eb->bidx) return (ea->bidx < eb->bidx) ? -1 : 1;
+  if(ea->off != eb->off) return (ea->off < eb->off) ? -1 : 1;
+  return 0;
+}
+
+
+/* Compare two records of a bucket of bulk loading in the order of the search tree.
+   `a' specifies the pointer to one record.
+   `b' specifies the pointer to the other record.
+   The return value is positive if the former is big, negative if the latter is big, 0 if both
+   are equivalent. */
+static int tchdbblreccmp(const void *a, const void *b){
+  assert(a && b);
+  const HDBBLREC *ra = a;
+  const HDBBLREC *rb = b;
+  if(ra->hash != rb->hash) return (ra->hash < rb->hash) ? -1 : 1;
+  int rv = tcreckeycmp(ra->kbuf, ra->ksiz, rb->kbuf, rb->ksiz);
+  if(rv != 0) return rv;
+  if(ra->seq != rb->seq) return (ra->seq < rb->seq) ? -1 : 1;
+  return 0;
+}
+
+
+/* Optimize the file of a hash database object.
+   `hdb' specifies the hash database object.
+   `bnum' specifies the number of elements of the bucket array.
+   `apow' specifies the size of record alignment by power of 2.
+   `fpow' specifies the maximum number of elements of the free block pool by power of 2.
+   `opts' specifies options by bitwise-or.
+   If successful, the return value is true, else, it is false. */
+static bool tchdboptimizeimpl(TCHDB *hdb, int64_t bnum, int8_t apow, int8_t fpow, uint8_t opts){
+  assert(hdb);
+  char *tpath = tcsprintf("%s%ctmp%c%llu", hdb->path, MYEXTCHR, MYEXTCHR, hdb->inode);
+  TCHDB *thdb = tchdbnew();
+  thdb->dbgfd = hdb->dbgfd;
+  thdb->enc = hdb->enc;
+  thdb->encop = hdb->encop;
+  thdb->dec = hdb->dec;
+  thdb->decop = hdb->decop;
+  thdb->vlthres = hdb->vlthres;
+  thdb->fwpow = hdb->fwpow;
+  thdb->fknum = hdb->fknum;
+  if(bnum < 1){
+    bnum = hdb->rnum * 2 + 1;
+    if(bnum < HDBDEFBNUM) bnum = HDBDEFBNUM;
+    if(hdb->lhbase > 0 && bnum < hdb->bnum) bnum = hdb->bnum;
+  }
+  if(apow < 0) apow = hdb->apow;
+  if(fpow < 0) fpow = hdb->fpow;
+  if(opts == UINT8_MAX) opts = hdb->opts;
+  tchdbtune(thdb, bnum, apow, fpow, opts);
+  if(hdb->lhbase > 0) tchdbsetlinear(thdb, tclmax(hdb->rnum / HDBLHSPLRAT, hdb->lhbase));
+  if(!tchdbopen(thdb, tpath, HDBOWRITER | HDBOCREAT | HDBOTRUNC)){
+    tchdbsetecode(hdb, thdb->ecode, __FILE__, __LINE__, __func__);
+    tchdbdel(thdb);
+    TCFREE(tpath);
+    return false;
+  }
+  memcpy(tchdbopaque(thdb), tchdbopaque(hdb), HDBHEADSIZ - HDBOPAQUEOFF);
+  bool err = false;
+  if(hdb->optthnum > 1){
+    if(!tchdboptimizepara(hdb, thdb)) err = true;
+  } else {
+    uint64_t off = hdb->frec;
+    HDBSCAN scan;
+    tchdbscaninit(&scan);
+    TCHREC rec;
+    char rbuf[HDBIOBUFSIZ];
+    while(off < hdb->fsiz){
+      rec.off = off;
+      if(!tchdbscanreadrec(hdb, &scan, &rec, rbuf)){
+        err = true;
+        break;
+      }
+      off += rec.rsiz;
+      if(rec.magic == HDBMAGICREC){
+        if(!tchdbreadrecvalue(hdb, &rec)){
+          TCFREE(rec.bbuf);
+          err = true;
+        } else {
+          if(hdb->zmode){
+            int zsiz;
+            char *zbuf;
+            if(hdb->opts & HDBTDEFLATE){
+              zbuf = _tc_inflate(rec.vbuf, rec.vsiz, &zsiz, _TCZMRAW);
+            } else if(hdb->opts & HDBTBZIP){
+              zbuf = _tc_bzdecompress(rec.vbuf, rec.vsiz, &zsiz);
+            } else if(hdb->opts & HDBTTCBS){
+              zbuf = tcbsdecode(rec.vbuf, rec.vsiz, &zsiz);
+            } else if(hdb->opts & HDBTLZ){
+              zbuf = tclzdecode(rec.vbuf, rec.vsiz, &zsiz);
             } else {
-              TCMALLOC(rec.bbuf, nvsiz + 1);
-              memcpy(rec.bbuf, rec.vbuf, rec.vsiz);
-              memcpy(rec.bbuf + rec.vsiz, vbuf, vsiz);
-              rec.vbuf = rec.bbuf;
-              rec.vsiz = nvsiz;
-            }
-            rv = tchdbwriterec(hdb, &rec, bidx, entoff);
-            TCFREE(rec.bbuf);
-            return rv;
-          case HDBPDADDINT:
-            if(rec.vsiz != sizeof(int)){
-              tchdbsetecode(hdb, TCEKEEP, __FILE__, __LINE__, __func__);
-              TCFREE(rec.bbuf);
-              return false;
-            }
-            if(!rec.vbuf && !tchdbreadrecbody(hdb, &rec)){
-              TCFREE(rec.bbuf);
-              return false;
-            }
-            int lnum;
-            memcpy(&lnum, rec.vbuf, sizeof(lnum));
-            if(*(int *)vbuf == 0){
-              TCFREE(rec.bbuf);
-              *(int *)vbuf = lnum;
-              return true;
-            }
-            lnum += *(int *)vbuf;
-            rec.vbuf = (char *)&lnum;
-            *(int *)vbuf = lnum;
-            rv = tchdbwriterec(hdb, &rec, bidx, entoff);
-            TCFREE(rec.bbuf);
-            return rv;
-          case HDBPDADDDBL:
-            if(rec.vsiz != sizeof(double)){
-              tchdbsetecode(hdb, TCEKEEP, __FILE__, __LINE__, __func__);
-              TCFREE(rec.bbuf);
-              return false;
-            }
-            if(!rec.vbuf && !tchdbreadrecbody(hdb, &rec)){
-              TCFREE(rec.bbuf);
-              return false;
-            }
-            double dnum;
-            memcpy(&dnum, rec.vbuf, sizeof(dnum));
-            if(*(double *)vbuf == 0.0){
-              TCFREE(rec.bbuf);
-              *(double *)vbuf = dnum;
-              return true;
+              zbuf = hdb->dec(rec.vbuf, rec.vsiz, &zsiz, hdb->decop);
             }
-            dnum += *(double *)vbuf;
-            rec.vbuf = (char *)&dnum;
-            *(double *)vbuf = dnum;
-            rv = tchdbwriterec(hdb, &rec, bidx, entoff);
-            TCFREE(rec.bbuf);
-            return rv;
-          case HDBPDPROC:
-            if(!rec.vbuf && !tchdbreadrecbody(hdb, &rec)){
-              TCFREE(rec.bbuf);
-              return false;
+            if(zbuf){
+              if(!tchdbputxt(thdb, rec.kbuf, rec.ksiz, zbuf, zsiz, -(int64_t)rec.xtime)){
+                tchdbsetecode(hdb, thdb->ecode, __FILE__, __LINE__, __func__);
+                err = true;
+              }
+              TCFREE(zbuf);
+            } else {
+              tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+              err = true;
             }
-            procptr = *(HDBPDPROCOP **)((char *)kbuf - sizeof(procptr));
-            nvbuf = procptr->proc(rec.vbuf, rec.vsiz, &nvsiz, procptr->op);
-            TCFREE(rec.bbuf);
-            if(nvbuf == (void *)-1){
-              return tchdbremoverec(hdb, &rec, rbuf, bidx, entoff);
-            } else if(nvbuf){
-              rec.kbuf = kbuf;
-              rec.ksiz = ksiz;
-              rec.vbuf = nvbuf;
-              rec.vsiz = nvsiz;
-              rv = tchdbwriterec(hdb, &rec, bidx, entoff);
-              TCFREE(nvbuf);
-              return rv;
+          } else {
+            if(!tchdbputxt(thdb, rec.kbuf, rec.ksiz, rec.vbuf, rec.vsiz, -(int64_t)rec.xtime)){
+              tchdbsetecode(hdb, thdb->ecode, __FILE__, __LINE__, __func__);
+              err = true;
             }
-            tchdbsetecode(hdb, TCEKEEP, __FILE__, __LINE__, __func__);
-            return false;
-          default:
-            break;
+          }
         }
         TCFREE(rec.bbuf);
-        rec.ksiz = ksiz;
-        rec.vsiz = vsiz;
-        rec.kbuf = kbuf;
-        rec.vbuf = vbuf;
-        return tchdbwriterec(hdb, &rec, bidx, entoff);
       }
     }
+    tchdbscanclear(&scan);
   }
-  if(!vbuf){
-    tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+  if(!tchdbclose(thdb)){
+    tchdbsetecode(hdb, thdb->ecode, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  bool esc = false;
+  if(err && (hdb->omode & HDBONOLCK) && !thdb->fatal){
+    err = false;
+    esc = true;
+  }
+  tchdbdel(thdb);
+  if(err){
+    TCFREE(tpath);
     return false;
   }
-  if(!HDBLOCKDB(hdb)) return false;
-  rec.rsiz = hdb->ba64 ? sizeof(uint8_t) * 2 + sizeof(uint64_t) * 2 + sizeof(uint16_t) :
-    sizeof(uint8_t) * 2 + sizeof(uint32_t) * 2 + sizeof(uint16_t);
-  if(ksiz < (1U << 7)){
-    rec.rsiz += 1;
-  } else if(ksiz < (1U << 14)){
-    rec.rsiz += 2;
-  } else if(ksiz < (1U << 21)){
-    rec.rsiz += 3;
-  } else if(ksiz < (1U << 28)){
-    rec.rsiz += 4;
+  if(esc){
+    char *bpath = tcsprintf("%s%cbroken", tpath, MYEXTCHR);
+    if(rename(hdb->path, bpath) == -1){
+      tchdbsetecode(hdb, TCEUNLINK, __FILE__, __LINE__, __func__);
+      err = true;
+    }
+    TCFREE(bpath);
   } else {
-    rec.rsiz += 5;
+    if(unlink(hdb->path) == -1){
+      tchdbsetecode(hdb, TCEUNLINK, __FILE__, __LINE__, __func__);
+      err = true;
+    }
   }
-  if(vsiz < (1U << 7)){
-    rec.rsiz += 1;
-  } else if(vsiz < (1U << 14)){
-    rec.rsiz += 2;
-  } else if(vsiz < (1U << 21)){
-    rec.rsiz += 3;
-  } else if(vsiz < (1U << 28)){
-    rec.rsiz += 4;
-  } else {
-    rec.rsiz += 5;
+  if(rename(tpath, hdb->path) == -1){
+    tchdbsetecode(hdb, TCERENAME, __FILE__, __LINE__, __func__);
+    err = true;
   }
-  if(!tchdbfbpsearch(hdb, &rec)){
-    HDBUNLOCKDB(hdb);
+  char *vpath = tcsprintf("%s%c%s", hdb->path, MYEXTCHR, HDBVLSUFFIX);
+  char *tvpath = tcsprintf("%s%c%s", tpath, MYEXTCHR, HDBVLSUFFIX);
+  if(rename(tvpath, vpath) == -1){
+    if(errno != ENOENT){
+      tchdbsetecode(hdb, TCERENAME, __FILE__, __LINE__, __func__);
+      err = true;
+    } else if(unlink(vpath) == -1 && errno != ENOENT){
+      tchdbsetecode(hdb, TCEUNLINK, __FILE__, __LINE__, __func__);
+      err = true;
+    }
+  }
+  TCFREE(tvpath);
+  TCFREE(vpath);
+  TCFREE(tpath);
+  if(err) return false;
+  tpath = tcstrdup(hdb->path);
+  int omode = (hdb->omode & ~HDBOCREAT) & ~HDBOTRUNC;
+  if(!tchdbcloseimpl(hdb)){
+    TCFREE(tpath);
     return false;
   }
-  rec.hash = hash;
-  rec.left = 0;
-  rec.right = 0;
-  rec.ksiz = ksiz;
-  rec.vsiz = vsiz;
-  rec.psiz = 0;
-  rec.kbuf = kbuf;
-  rec.vbuf = vbuf;
-  if(!tchdbwriterec(hdb, &rec, bidx, entoff)){
-    HDBUNLOCKDB(hdb);
+  bool rv = tchdbopenimpl(hdb, tpath, omode);
+  TCFREE(tpath);
+  return rv;
+}
+
+
+/* Copy the records of a hash database object into another one with worker threads.
+   `hdb' specifies the hash database object of the source.
+   `thdb' specifies the hash database object of the destination.
+   If successful, the return value is true, else, it is false.
+   The source is partitioned by file offset into chunks which contain whole records.  The main
+   thread reads the chunks into a ring and queues them to a fixed pool of workers which decode and
+   re-encode them, while it stores the finished chunks into the destination in the order of the
+   source. */
+static bool tchdboptimizepara(TCHDB *hdb, TCHDB *thdb){
+  assert(hdb && thdb);
+  int tnum = hdb->optthnum;
+  int64_t unit = (hdb->fsiz - hdb->frec) / (tnum * HDBOPTCHKNUM);
+  unit = tclmax(tclmin(unit, HDBOPTUNITMAX), tclmax(HDBOPTUNITMIN, hdb->runit));
+  HDBOPTPOOL pool;
+  if(pthread_mutex_init(&pool.mutex, NULL) != 0){
+    tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
     return false;
   }
-  hdb->rnum++;
-  uint64_t llnum = hdb->rnum;
-  llnum = TCHTOILL(llnum);
-  memcpy(hdb->map + HDBRNUMOFF, &llnum, sizeof(llnum));
-  HDBUNLOCKDB(hdb);
-  return true;
+  if(pthread_cond_init(&pool.cond, NULL) != 0){
+    tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+    pthread_mutex_destroy(&pool.mutex);
+    return false;
+  }
+  if(pthread_cond_init(&pool.dcnd, NULL) != 0){
+    tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+    pthread_cond_destroy(&pool.cond);
+    pthread_mutex_destroy(&pool.mutex);
+    return false;
+  }
+  pool.jnum = tnum * 2;
+  TCMALLOC(pool.jobs, sizeof(*pool.jobs) * pool.jnum);
+  for(int i = 0; i < pool.jnum; i++){
+    HDBOPTJOB *job = pool.jobs + i;
+    job->hdb = hdb;
+    job->thdb = thdb;
+    TCMALLOC(job->buf, unit);
+    job->bsiz = unit;
+    job->recs = tclistnew();
+    job->ecode = TCESUCCESS;
+    job->done = false;
+  }
+  pool.qnum = 0;
+  pool.tnum = 0;
+  pool.stop = false;
+  bool err = false;
+  pthread_t *thids;
+  TCMALLOC(thids, sizeof(*thids) * tnum);
+  int wnum = 0;
+  while(wnum < tnum){
+    if(pthread_create(thids + wnum, NULL, tchdboptimizeproc, &pool) != 0){
+      tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+      err = true;
+      break;
+    }
+    wnum++;
+  }
+  uint64_t off = hdb->frec;
+  uint64_t snum = 0;
+  while(true){
+    while(!err && pool.qnum - snum < pool.jnum && off < hdb->fsiz){
+      HDBOPTJOB *job = pool.jobs + pool.qnum % pool.jnum;
+      int64_t size = tclmin(unit, hdb->fsiz - off);
+      if(!tchdbseekread(hdb, off, job->buf, size)){
+        err = true;
+        break;
+      }
+      int64_t rsiz = 0;
+      while(rsiz < size){
+        int64_t left = size - rsiz;
+        if(left < hdb->runit && off + size < hdb->fsiz) break;
+        TCHREC rec;
+        rec.off = off + rsiz;
+        if(!tchdbparserec(hdb, &rec, job->buf + rsiz, left)){
+          err = true;
+          break;
+        }
+        if(rec.rsiz > left){
+          if(rsiz < 1){
+            if(rec.rsiz > job->bsiz){
+              TCREALLOC(job->buf, job->buf, rec.rsiz);
+              job->bsiz = rec.rsiz;
+            }
+            if(!tchdbseekread(hdb, off, job->buf, rec.rsiz)) err = true;
+            rsiz = rec.rsiz;
+          }
+          break;
+        }
+        rsiz += rec.rsiz;
+      }
+      if(err) break;
+      if(rsiz < 1){
+        tchdbsetecode(hdb, TCERHEAD, __FILE__, __LINE__, __func__);
+        err = true;
+        break;
+      }
+      job->off = off;
+      job->size = rsiz;
+      job->ecode = TCESUCCESS;
+      job->done = false;
+      off += rsiz;
+      pthread_mutex_lock(&pool.mutex);
+      pool.qnum++;
+      pthread_cond_signal(&pool.cond);
+      pthread_mutex_unlock(&pool.mutex);
+    }
+    if(snum >= pool.qnum) break;
+    HDBOPTJOB *job = pool.jobs + snum % pool.jnum;
+    pthread_mutex_lock(&pool.mutex);
+    while(!job->done && wnum > 0){
+      pthread_cond_wait(&pool.dcnd, &pool.mutex);
+    }
+    pthread_mutex_unlock(&pool.mutex);
+    snum++;
+    if(!job->done){
+      err = true;
+      continue;
+    }
+    if(job->ecode != TCESUCCESS && !err){
+      tchdbsetecode(hdb, job->ecode, __FILE__, __LINE__, __func__);
+      err = true;
+    }
+    TCLIST *recs = job->recs;
+    int rnum = TCLISTNUM(recs);
+    for(int j = 0; !err && j < rnum; j += 3){
+      const char *kbuf, *vbuf;
+      int ksiz, vsiz;
+      TCLISTVAL(kbuf, recs, j, ksiz);
+      TCLISTVAL(vbuf, recs, j + 1, vsiz);
+      uint32_t xtime;
+      memcpy(&xtime, TCLISTVALPTR(recs, j + 2), sizeof(xtime));
+      uint8_t hash;
+      uint64_t bidx = tchdbbidx(thdb, kbuf, ksiz, &hash);
+      if(!tchdbputimpl(thdb, kbuf, ksiz, bidx, hash, vbuf, vsiz, HDBPDOVER, xtime) ||
+         (HDBLHSPLITNEEDED(thdb) && !tchdblhgrow(thdb))){
+        tchdbsetecode(hdb, thdb->ecode, __FILE__, __LINE__, __func__);
+        err = true;
+      }
+    }
+    tclistclear(recs);
+  }
+  pthread_mutex_lock(&pool.mutex);
+  pool.stop = true;
+  pthread_cond_broadcast(&pool.cond);
+  pthread_mutex_unlock(&pool.mutex);
+  for(int i = 0; i < wnum; i++){
+    if(pthread_join(thids[i], NULL) != 0){
+      tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+      err = true;
+    }
+  }
+  TCFREE(thids);
+  for(int i = 0; i < pool.jnum; i++){
+    tclistdel(pool.jobs[i].recs);
+    TCFREE(pool.jobs[i].buf);
+  }
+  TCFREE(pool.jobs);
+  pthread_cond_destroy(&pool.dcnd);
+  pthread_cond_destroy(&pool.cond);
+  pthread_mutex_destroy(&pool.mutex);
+  return !err;
+}
+
+
+/* Take chunks of parallel optimization from the queue until the pool is stopped.
+   `arg' specifies the pool of the workers.
+   The return value is always `NULL'. */
+static void *tchdboptimizeproc(void *arg){
+  HDBOPTPOOL *pool = arg;
+  pthread_mutex_lock(&pool->mutex);
+  while(true){
+    if(pool->tnum < pool->qnum){
+      HDBOPTJOB *job = pool->jobs + pool->tnum % pool->jnum;
+      pool->tnum++;
+      pthread_mutex_unlock(&pool->mutex);
+      tchdboptimizejob(job);
+      pthread_mutex_lock(&pool->mutex);
+      job->done = true;
+      pthread_cond_broadcast(&pool->dcnd);
+    } else if(pool->stop){
+      break;
+    } else {
+      pthread_cond_wait(&pool->cond, &pool->mutex);
+    }
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  return NULL;
+}
+
+
+/* Decode and re-encode the records of a chunk of parallel optimization.
+   `job' specifies the job of the chunk.
+   The key, the value encoded for the destination and the expiration time of each record are
+   pushed to the list of the job by turns.  Records which have expired are dropped.  Errors are
+   reported only by the error code of the job because the source object is shared by the
+   workers, so headers are parsed without reporting and nothing here sets the error code of the
+   source.  The main thread sets it from the job when it stores the chunk. */
+static void tchdboptimizejob(HDBOPTJOB *job){
+  TCHDB *hdb = job->hdb;
+  TCHDB *thdb = job->thdb;
+  int64_t rsiz = 0;
+  while(rsiz < job->size){
+    uint8_t magic = *(uint8_t *)(job->buf + rsiz);
+    if(magic != HDBMAGICREC && magic != HDBMAGICFB && magic != HDBMAGICVLREC &&
+       magic != HDBMAGICXREC && magic != HDBMAGICXVLREC){
+      job->ecode = TCERHEAD;
+      break;
+    }
+    TCHREC rec;
+    rec.off = job->off + rsiz;
+    if(!tchdbparserectry(hdb, &rec, job->buf + rsiz, job->size - rsiz) || rec.rsiz < 1 ||
+       rec.rsiz > job->size - rsiz){
+      job->ecode = TCERHEAD;
+      break;
+    }
+    rsiz += rec.rsiz;
+    if(rec.magic != HDBMAGICREC) continue;
+    if(!rec.vbuf || (rec.vlog && rec.vsiz != HDBVLPTRSIZ)){
+      job->ecode = TCERHEAD;
+      break;
+    }
+    if(rec.vlog){
+      uint64_t off;
+      uint32_t vsiz;
+      tchdbvlgetref(hdb, &rec, &off, &vsiz);
+      TCMALLOC(rec.bbuf, rec.ksiz + vsiz + 1);
+      memcpy(rec.bbuf, rec.kbuf, rec.ksiz);
+      if(!tchdbvlreadraw(hdb, off, rec.bbuf + rec.ksiz, vsiz)){
+        TCFREE(rec.bbuf);
+        job->ecode = TCEREAD;
+        break;
+      }
+      rec.kbuf = rec.bbuf;
+      rec.vbuf = rec.bbuf + rec.ksiz;
+      rec.vsiz = vsiz;
+    }
+    const char *vbuf = rec.vbuf;
+    int vsiz = rec.vsiz;
+    char *zbuf = NULL;
+    if(hdb->zmode){
+      if(hdb->opts & HDBTDEFLATE){
+        zbuf = _tc_inflate(vbuf, vsiz, &vsiz, _TCZMRAW);
+      } else if(hdb->opts & HDBTBZIP){
+        zbuf = _tc_bzdecompress(vbuf, vsiz, &vsiz);
+      } else if(hdb->opts & HDBTTCBS){
+        zbuf = tcbsdecode(vbuf, vsiz, &vsiz);
+      } else if(hdb->opts & HDBTLZ){
+        zbuf = tclzdecode(vbuf, vsiz, &vsiz);
+      } else {
+        zbuf = hdb->dec(vbuf, vsiz, &vsiz, hdb->decop);
+      }
+      if(!zbuf){
+        TCFREE(rec.bbuf);
+        job->ecode = TCEMISC;
+        break;
+      }
+      vbuf = zbuf;
+    }
+    if(thdb->zmode){
+      char *ebuf;
+      if(thdb->opts & HDBTDEFLATE){
+        ebuf = _tc_deflate(vbuf, vsiz, &vsiz, _TCZMRAW);
+      } else if(thdb->opts & HDBTBZIP){
+        ebuf = _tc_bzcompress(vbuf, vsiz, &vsiz);
+      } else if(thdb->opts & HDBTTCBS){
+        ebuf = tcbsencode(vbuf, vsiz, &vsiz);
+      } else if(thdb->opts & HDBTLZ){
+        ebuf = tclzencode(vbuf, vsiz, &vsiz);
+      } else {
+        ebuf = thdb->enc(vbuf, vsiz, &vsiz, thdb->encop);
+      }
+      if(zbuf) TCFREE(zbuf);
+      if(!ebuf){
+        TCFREE(rec.bbuf);
+        job->ecode = TCEMISC;
+        break;
+      }
+      vbuf = zbuf = ebuf;
+    }
+    TCLISTPUSH(job->recs, rec.kbuf, rec.ksiz);
+    TCLISTPUSH(job->recs, vbuf, vsiz);
+    TCLISTPUSH(job->recs, &rec.xtime, sizeof(rec.xtime));
+    if(zbuf) TCFREE(zbuf);
+    TCFREE(rec.bbuf);
+  }
 }
 
 
-/* Append a record to the delayed record pool.
+/* Remove all records of a hash database object.
    `hdb' specifies the hash database object.
-   `kbuf' specifies the pointer to the region of the key.
-   `ksiz' specifies the size of the region of the key.
-   `vbuf' specifies the pointer to the region of the value.
-   `vsiz' specifies the size of the region of the value.
-   `hash' specifies the second hash value. */
-static void tchdbdrpappend(TCHDB *hdb, const char *kbuf, int ksiz, const char *vbuf, int vsiz,
-                           uint8_t hash){
-  assert(hdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
-  TCDODEBUG(hdb->cnt_appenddrp++);
-  char rbuf[HDBIOBUFSIZ];
-  char *wp = rbuf;
-  *(uint8_t *)(wp++) = HDBMAGICREC;
-  *(uint8_t *)(wp++) = hash;
-  if(hdb->ba64){
-    memset(wp, 0, sizeof(uint64_t) * 2);
-    wp += sizeof(uint64_t) * 2;
-  } else {
-    memset(wp, 0, sizeof(uint32_t) * 2);
-    wp += sizeof(uint32_t) * 2;
-  }
-  uint16_t snum;
-  char *pwp = wp;
-  wp += sizeof(snum);
-  int step;
-  TCSETVNUMBUF(step, wp, ksiz);
-  wp += step;
-  TCSETVNUMBUF(step, wp, vsiz);
-  wp += step;
-  int32_t hsiz = wp - rbuf;
-  int32_t rsiz = hsiz + ksiz + vsiz;
-  uint16_t psiz = tchdbpadsize(hdb, hdb->fsiz + rsiz);
-  hdb->fsiz += rsiz + psiz;
-  snum = TCHTOIS(psiz);
-  memcpy(pwp, &snum, sizeof(snum));
-  TCXSTR *drpool = hdb->drpool;
-  TCXSTRCAT(drpool, rbuf, hsiz);
-  TCXSTRCAT(drpool, kbuf, ksiz);
-  TCXSTRCAT(drpool, vbuf, vsiz);
-  if(psiz > 0){
-    char pbuf[psiz];
-    memset(pbuf, 0, psiz);
-    TCXSTRCAT(drpool, pbuf, psiz);
+   If successful, the return value is true, else, it is false. */
+static bool tchdbvanishimpl(TCHDB *hdb){
+  assert(hdb);
+  char *path = tcstrdup(hdb->path);
+  int omode = hdb->omode;
+  bool err = false;
+  if(!tchdbcloseimpl(hdb)) err = true;
+  if(!tchdbopenimpl(hdb, path, HDBOTRUNC | omode)){
+    tcpathunlock(hdb->rpath);
+    TCFREE(hdb->rpath);
+    err = true;
   }
+  TCFREE(path);
+  return !err;
 }
 
 
-/* Store a record in asynchronus fashion.
+/* Copy the database file of a hash database object.
    `hdb' specifies the hash database object.
-   `kbuf' specifies the pointer to the region of the key.
-   `ksiz' specifies the size of the region of the key.
-   `bidx' specifies the index of the bucket array.
-   `hash' specifies the hash value for the collision tree.
-   `vbuf' specifies the pointer to the region of the value.
-   `vsiz' specifies the size of the region of the value.
+   `path' specifies the path of the destination file.
    If successful, the return value is true, else, it is false. */
-static bool tchdbputasyncimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx,
-                              uint8_t hash, const char *vbuf, int vsiz){
-  assert(hdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
-  if(hdb->recc) tcmdbout(hdb->recc, kbuf, ksiz);
-  if(!hdb->drpool){
-    hdb->drpool = tcxstrnew3(HDBDRPUNIT + HDBDRPLAT);
-    hdb->drpdef = tcxstrnew3(HDBDRPUNIT);
-    hdb->drpoff = hdb->fsiz;
+static bool tchdbcopyimpl(TCHDB *hdb, const char *path){
+  assert(hdb && path);
+  bool err = false;
+  if(hdb->omode & HDBOWRITER){
+    if(!tchdbsavefbp(hdb)) err = true;
+    if(!tchdbmemsync(hdb, false)) err = true;
+    tchdbsetflag(hdb, HDBFOPEN, false);
   }
-  off_t off = tchdbgetbucket(hdb, bidx);
-  off_t entoff = 0;
-  TCHREC rec;
-  char rbuf[HDBIOBUFSIZ];
-  while(off > 0){
-    if(off >= hdb->drpoff - hdb->runit){
-      TCDODEBUG(hdb->cnt_deferdrp++);
-      TCXSTR *drpdef = hdb->drpdef;
-      TCXSTRCAT(drpdef, &ksiz, sizeof(ksiz));
-      TCXSTRCAT(drpdef, &vsiz, sizeof(vsiz));
-      TCXSTRCAT(drpdef, kbuf, ksiz);
-      TCXSTRCAT(drpdef, vbuf, vsiz);
-      if(TCXSTRSIZE(hdb->drpdef) > HDBDRPUNIT && !tchdbflushdrp(hdb)) return false;
-      return true;
+  if(*path == '@'){
+    char tsbuf[TCNUMBUFSIZ];
+    sprintf(tsbuf, "%llu", (unsigned long long)(tctime() * 1000000));
+    const char *args[3];
+    args[0] = path + 1;
+    args[1] = hdb->path;
+    args[2] = tsbuf;
+    if(tcsystem(args, sizeof(args) / sizeof(*args)) != 0) err = true;
+  } else {
+    if(!tccopyfile(hdb->path, path)){
+      tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+      err = true;
     }
-    rec.off = off;
-    if(!tchdbreadrec(hdb, &rec, rbuf)) return false;
-    if(hash > rec.hash){
-      off = rec.left;
-      entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t));
-    } else if(hash < rec.hash){
-      off = rec.right;
-      entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t)) +
-        (hdb->ba64 ? sizeof(uint64_t) : sizeof(uint32_t));
-    } else {
-      TCDODEBUG(hdb->cnt_deferdrp++);
-      TCXSTR *drpdef = hdb->drpdef;
-      TCXSTRCAT(drpdef, &ksiz, sizeof(ksiz));
-      TCXSTRCAT(drpdef, &vsiz, sizeof(vsiz));
-      TCXSTRCAT(drpdef, kbuf, ksiz);
-      TCXSTRCAT(drpdef, vbuf, vsiz);
-      if(TCXSTRSIZE(hdb->drpdef) > HDBDRPUNIT && !tchdbflushdrp(hdb)) return false;
-      return true;
+    if(hdb->vlfd >= 0){
+      char *vpath = tcsprintf("%s%c%s", hdb->path, MYEXTCHR, HDBVLSUFFIX);
+      char *dvpath = tcsprintf("%s%c%s", path, MYEXTCHR, HDBVLSUFFIX);
+      if(!tccopyfile(vpath, dvpath)){
+        tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+        err = true;
+      }
+      TCFREE(dvpath);
+      TCFREE(vpath);
     }
   }
-  if(entoff > 0){
-    if(hdb->ba64){
-      uint64_t llnum = hdb->fsiz >> hdb->apow;
-      llnum = TCHTOILL(llnum);
-      if(!tchdbseekwrite(hdb, entoff, &llnum, sizeof(uint64_t))) return false;
+  if(hdb->omode & HDBOWRITER) tchdbsetflag(hdb, HDBFOPEN, true);
+  return !err;
+}
+
+
+/* Copy the database file of a hash database object while it is updated.
+   `hdb' specifies the hash database object.
+   `bkup' specifies the state of the online backup.
+   `fd' specifies the file descriptor of the destination file.
+   `vlfd' specifies the file descriptor of the destination value log or -1.
+   `fsiz' specifies the size of the file at the beginning.
+   `vlsiz' specifies the size of the value log at the beginning.
+   `proc' specifies the pointer to the function called around the catch-up phase or `NULL'.
+   `op' specifies the pointer to the optional opaque object.
+   If successful, the return value is true, else, it is false.
+   The first pass copies the whole file under the shared lock taken by chunks, and each later
+   pass copies the pages marked by the writers during the previous one and the region appended
+   since.  As the value log is only appended, its region as of the beginning of each pass is
+   copied.  The remaining pages are copied while the database is locked exclusively and no
+   transaction is running. */
+static bool tchdbbackupimpl(TCHDB *hdb, HDBBKUP *bkup, int fd, int vlfd, uint64_t fsiz,
+                            uint64_t vlsiz, TCHDBBKPROC proc, void *op){
+  assert(hdb && bkup && fd >= 0);
+  bool err = false;
+  char *buf;
+  TCMALLOC(buf, HDBBKCHUNKSIZ);
+  uint64_t cend = 0;
+  uint64_t vlend = 0;
+  TCMAP *pages = NULL;
+  for(int pass = 1; !err; pass++){
+    if(pages && !tchdbbkcopypages(hdb, bkup, pages, fd, cend, buf, false)) err = true;
+    if(!err && !tchdbbkcopy(hdb, bkup, false, fd, cend, fsiz, buf, false)) err = true;
+    if(!err && vlfd >= 0 && !tchdbbkcopy(hdb, bkup, true, vlfd, vlend, vlsiz, buf, false))
+      err = true;
+    if(pages) tcmapdel(pages);
+    pages = NULL;
+    if(err) break;
+    if(fsiz > cend) cend = fsiz;
+    vlend = vlsiz;
+    if(!HDBLOCKMETHOD(hdb, true)){
+      err = true;
+      break;
+    }
+    if(bkup->cancel){
+      tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+      HDBUNLOCKMETHOD(hdb);
+      err = true;
+      break;
+    }
+    fsiz = hdb->fsiz;
+    if(vlfd >= 0) vlsiz = hdb->vlhead;
+    bool last = pass >= HDBBKPASSMAX ||
+      (TCMAPRNUM(bkup->pages) <= HDBBKLEFTMAX && fsiz <= cend + HDBBKLEFTMAX * HDBBKPGSIZ);
+    if(!last){
+      pages = bkup->pages;
+      bkup->pages = tcmapnew();
+    }
+    HDBUNLOCKMETHOD(hdb);
+    if(last) break;
+  }
+  bool called = false;
+  if(!err && proc){
+    if(proc(true, op)){
+      called = true;
     } else {
-      uint32_t lnum = hdb->fsiz >> hdb->apow;
-      lnum = TCHTOIL(lnum);
-      if(!tchdbseekwrite(hdb, entoff, &lnum, sizeof(uint32_t))) return false;
+      err = true;
     }
-  } else {
-    tchdbsetbucket(hdb, bidx, hdb->fsiz);
   }
-  tchdbdrpappend(hdb, kbuf, ksiz, vbuf, vsiz, hash);
-  hdb->rnum++;
-  if(TCXSTRSIZE(hdb->drpool) > HDBDRPUNIT && !tchdbflushdrp(hdb)) return false;
-  return true;
+  bool locked = false;
+  for(double wsec = 1.0 / sysconf(_SC_CLK_TCK); true; wsec *= 2){
+    if(!HDBLOCKMETHOD(hdb, true)) break;
+    locked = true;
+    if(err || bkup->cancel || !hdb->tran) break;
+    HDBUNLOCKMETHOD(hdb);
+    locked = false;
+    if(wsec > 1.0) wsec = 1.0;
+    tcsleep(wsec);
+  }
+  if(bkup->cancel){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    err = true;
+  } else if(!locked){
+    err = true;
+  } else if(!err){
+    if(hdb->async && !tchdbflushdrp(hdb)) err = true;
+    if(hdb->omode & HDBOWRITER){
+      if(!tchdbsavefbp(hdb)) err = true;
+      if(!tchdbmemsync(hdb, false)) err = true;
+      size_t xmsiz = (hdb->xmsiz > hdb->msiz) ? hdb->xmsiz : hdb->msiz;
+      if(!TCUBCACHE && msync(hdb->map, xmsiz, MS_SYNC) == -1){
+        tchdbsetecode(hdb, TCEMMAP, __FILE__, __LINE__, __func__);
+        err = true;
+      }
+    }
+    fsiz = hdb->fsiz;
+    if(!err && !tchdbbkcopypages(hdb, bkup, bkup->pages, fd, cend, buf, true)) err = true;
+    if(!err && !tchdbbkcopy(hdb, bkup, false, fd, cend, fsiz, buf, true)) err = true;
+    if(!err){
+      char hbuf[HDBHEADSIZ];
+      memcpy(hbuf, hdb->map, HDBHEADSIZ);
+      hbuf[HDBFLAGSOFF] &= ~HDBFOPEN;
+      if(!tchdbrlpwrite(hdb, fd, 0, hbuf, HDBHEADSIZ)) err = true;
+    }
+    if(!err && ftruncate(fd, fsiz) == -1){
+      tchdbsetecode(hdb, TCETRUNC, __FILE__, __LINE__, __func__);
+      err = true;
+    }
+    if(!err && vlfd >= 0){
+      vlsiz = hdb->vlhead;
+      if(!tchdbbkcopy(hdb, bkup, true, vlfd, vlend, vlsiz, buf, true)) err = true;
+      if(!err && ftruncate(vlfd, vlsiz) == -1){
+        tchdbsetecode(hdb, TCETRUNC, __FILE__, __LINE__, __func__);
+        err = true;
+      }
+    }
+  }
+  if(hdb->bkup == bkup) hdb->bkup = NULL;
+  if(locked) HDBUNLOCKMETHOD(hdb);
+  if(called) proc(false, op);
+  TCFREE(buf);
+  if(!err && fsync(fd) == -1){
+    tchdbsetecode(hdb, TCESYNC, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  if(!err && vlfd >= 0 && fsync(vlfd) == -1){
+    tchdbsetecode(hdb, TCESYNC, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  return !err;
 }
 
 
-/* Remove a record of a hash database object.
+/* Copy a region of a file of a hash database object for an online backup.
    `hdb' specifies the hash database object.
-   `kbuf' specifies the pointer to the region of the key.
-   `ksiz' specifies the size of the region of the key.
-   `bidx' specifies the index of the bucket array.
-   `hash' specifies the hash value for the collision tree.
-   If successful, the return value is true, else, it is false. */
-static bool tchdboutimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash){
-  assert(hdb && kbuf && ksiz >= 0);
-  if(hdb->recc) tcmdbout(hdb->recc, kbuf, ksiz);
-  off_t off = tchdbgetbucket(hdb, bidx);
-  off_t entoff = 0;
-  TCHREC rec;
-  char rbuf[HDBIOBUFSIZ];
-  while(off > 0){
-    rec.off = off;
-    if(!tchdbreadrec(hdb, &rec, rbuf)) return false;
-    if(hash > rec.hash){
-      off = rec.left;
-      entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t));
-    } else if(hash < rec.hash){
-      off = rec.right;
-      entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t)) +
-        (hdb->ba64 ? sizeof(uint64_t) : sizeof(uint32_t));
-    } else {
-      if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)) return false;
-      int kcmp = tcreckeycmp(kbuf, ksiz, rec.kbuf, rec.ksiz);
-      if(kcmp > 0){
-        off = rec.left;
-        TCFREE(rec.bbuf);
-        rec.kbuf = NULL;
-        rec.bbuf = NULL;
-        entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t));
-      } else if(kcmp < 0){
-        off = rec.right;
-        TCFREE(rec.bbuf);
-        rec.kbuf = NULL;
-        rec.bbuf = NULL;
-        entoff = rec.off + (sizeof(uint8_t) + sizeof(uint8_t)) +
-          (hdb->ba64 ? sizeof(uint64_t) : sizeof(uint32_t));
-      } else {
-        TCFREE(rec.bbuf);
-        rec.bbuf = NULL;
-        return tchdbremoverec(hdb, &rec, rbuf, bidx, entoff);
+   `bkup' specifies the state of the online backup.
+   `vl' specifies whether to copy the value log instead of the database file.
+   `dfd' specifies the file descriptor of the destination file.
+   `off' specifies the offset of the region.
+   `end' specifies the end offset of the region.
+   `buf' specifies the buffer of a chunk.
+   `locked' specifies whether the database is locked by the caller.
+   If successful, the return value is true, else, it is false.
+   Unless the caller locks the database, the shared lock is taken by chunks so that writers and
+   exclusive operations are not blocked for long. */
+static bool tchdbbkcopy(TCHDB *hdb, HDBBKUP *bkup, bool vl, int dfd, uint64_t off, uint64_t end,
+                        char *buf, bool locked){
+  assert(hdb && bkup && dfd >= 0 && off >= 0 && end >= 0 && buf);
+  while(off < end){
+    size_t size = tclmin(end - off, HDBBKCHUNKSIZ);
+    if(!locked && !HDBLOCKMETHOD(hdb, false)) return false;
+    if(bkup->cancel){
+      tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+      if(!locked) HDBUNLOCKMETHOD(hdb);
+      return false;
+    }
+    int sfd = vl ? hdb->vlfd : hdb->fd;
+    size_t rsiz = 0;
+    bool err = false;
+    while(rsiz < size){
+      ssize_t rb = pread(sfd, buf + rsiz, size - rsiz, off + rsiz);
+      if(rb > 0){
+        rsiz += rb;
+      } else if(rb == 0){
+        break;
+      } else if(errno != EINTR){
+        tchdbsetecode(hdb, TCEREAD, __FILE__, __LINE__, __func__);
+        err = true;
+        break;
       }
     }
+    if(!locked) HDBUNLOCKMETHOD(hdb);
+    if(err) return false;
+    if(rsiz < 1) break;
+    if(!tchdbrlpwrite(hdb, dfd, off, buf, rsiz)) return false;
+    off += rsiz;
+  }
+  return true;
+}
+
+
+/* Copy the updated pages of a hash database object for an online backup.
+   `hdb' specifies the hash database object.
+   `bkup' specifies the state of the online backup.
+   `pages' specifies the map object of the indices of the pages.
+   `dfd' specifies the file descriptor of the destination file.
+   `end' specifies the end offset of the region copied so far.
+   `buf' specifies the buffer of a chunk.
+   `locked' specifies whether the database is locked by the caller.
+   If successful, the return value is true, else, it is false.
+   The pages are sorted by the offset so that they are read and written sequentially. */
+static bool tchdbbkcopypages(TCHDB *hdb, HDBBKUP *bkup, TCMAP *pages, int dfd, uint64_t end,
+                             char *buf, bool locked){
+  assert(hdb && bkup && pages && dfd >= 0 && end >= 0 && buf);
+  int pnum = TCMAPRNUM(pages);
+  if(pnum < 1) return true;
+  uint64_t *pidxs;
+  TCMALLOC(pidxs, sizeof(*pidxs) * pnum);
+  int num = 0;
+  tcmapiterinit(pages);
+  const char *kbuf;
+  int ksiz;
+  while(num < pnum && (kbuf = tcmapiternext(pages, &ksiz)) != NULL){
+    memcpy(pidxs + num++, kbuf, sizeof(*pidxs));
+  }
+  qsort(pidxs, num, sizeof(*pidxs), tchdbrlmarkcmp);
+  bool err = false;
+  for(int i = 0; !err && i < num; i++){
+    uint64_t off = pidxs[i] * HDBBKPGSIZ;
+    if(off >= end) break;
+    if(!tchdbbkcopy(hdb, bkup, false, dfd, off, tclmin(off + HDBBKPGSIZ, end), buf, locked))
+      err = true;
+  }
+  TCFREE(pidxs);
+  return !err;
+}
+
+
+/* Mark a region updated during an online backup of a hash database object.
+   `hdb' specifies the hash database object.
+   `off' specifies the offset of the region.
+   `size' specifies the size of the region.
+   This function is called by writers holding the shared lock, so that the marks are not taken
+   out by the backup between the mark and the update. */
+static void tchdbbkmark(TCHDB *hdb, uint64_t off, int64_t size){
+  assert(hdb && off >= 0 && size >= 0);
+  HDBBKUP *bkup = hdb->bkup;
+  if(!bkup || size < 1) return;
+  uint64_t end = (off + size - 1) / HDBBKPGSIZ;
+  pthread_mutex_lock(&bkup->mutex);
+  for(uint64_t pidx = off / HDBBKPGSIZ; pidx <= end; pidx++){
+    tcmapputkeep(bkup->pages, &pidx, sizeof(pidx), "", 0);
   }
-  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
-  return false;
+  pthread_mutex_unlock(&bkup->mutex);
 }
 
 
-/* Retrieve a record in a hash database object.
-   `hdb' specifies the hash database object.
-   `kbuf' specifies the pointer to the region of the key.
-   `ksiz' specifies the size of the region of the key.
-   `bidx' specifies the index of the bucket array.
-   `hash' specifies the hash value for the collision tree.
-   `sp' specifies the pointer to the variable into which the size of the region of the return
-   value is assigned.
-   If successful, the return value is the pointer to the region of the value of the corresponding
-   record. */
-static char *tchdbgetimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash,
-                          int *sp){
-  assert(hdb && kbuf && ksiz >= 0 && sp);
-  if(hdb->recc){
-    int tvsiz;
-    char *tvbuf = tcmdbget(hdb->recc, kbuf, ksiz, &tvsiz);
-    if(tvbuf){
-      if(*tvbuf == '*'){
-        tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
-        TCFREE(tvbuf);
-        return NULL;
+/* Perform dynamic defragmentation of a hash database object.
+   `hdb' specifies the hash database object connected.
+   `step' specifie the number of steps.
+   If successful, the return value is true, else, it is false.
+   No record is moved while any value is pinned.  In append-only mode, live records are copied
+   forward instead of being slid down in place. */
+static bool tchdbdefragimpl(TCHDB *hdb, int64_t step){
+  assert(hdb && step >= 0);
+  TCDODEBUG(hdb->cnt_defrag++);
+  if(!tchdbvlgcstep(hdb, step)) return false;
+  if(!tchdbxtstep(hdb, step)) return false;
+  hdb->dfcnt = 0;
+  if(hdb->pinnum > 0) return true;
+  if(hdb->omode & HDBOAPPEND) return tchdbapdefrag(hdb, step);
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ];
+  while(true){
+    if(hdb->dfcur >= hdb->fsiz){
+      hdb->dfcur = hdb->frec;
+      return true;
+    }
+    if(step-- < 1) return true;
+    rec.off = hdb->dfcur;
+    if(!tchdbreadrec(hdb, &rec, rbuf)) return false;
+    if(rec.magic == HDBMAGICFB) break;
+    hdb->dfcur += rec.rsiz;
+  }
+  uint32_t align = hdb->align;
+  uint64_t base = hdb->dfcur;
+  uint64_t dest = base;
+  uint64_t cur = base;
+  if(hdb->iter == cur) hdb->iter += rec.rsiz;
+  cur += rec.rsiz;
+  uint64_t fbsiz = cur - dest;
+  step++;
+  while(step > 0 && cur < hdb->fsiz){
+    rec.off = cur;
+    if(!tchdbreadrec(hdb, &rec, rbuf)) return false;
+    uint32_t rsiz = rec.rsiz;
+    if(rec.magic == HDBMAGICREC || rec.magic == HDBMAGICXREC){
+      if(rec.psiz >= align){
+        int diff = rec.psiz - rec.psiz % align;
+        rec.psiz -= diff;
+        rec.rsiz -= diff;
+        fbsiz += diff;
       }
-      *sp = tvsiz - 1;
-      memmove(tvbuf, tvbuf + 1, tvsiz);
-      return tvbuf;
+      if(!tchdbshiftrec(hdb, &rec, rbuf, dest)) return false;
+      if(hdb->iter == cur) hdb->iter = dest;
+      dest += rec.rsiz;
+      step--;
+    } else {
+      if(hdb->iter == cur) hdb->iter += rec.rsiz;
+      fbsiz += rec.rsiz;
     }
+    cur += rsiz;
   }
-  off_t off = tchdbgetbucket(hdb, bidx);
-  TCHREC rec;
-  char rbuf[HDBIOBUFSIZ];
-  while(off > 0){
-    rec.off = off;
-    if(!tchdbreadrec(hdb, &rec, rbuf)) return NULL;
-    if(hash > rec.hash){
-      off = rec.left;
-    } else if(hash < rec.hash){
-      off = rec.right;
+  if(hdb->vlgccur > base) hdb->vlgccur = base;
+  if(hdb->xtcur > base) hdb->xtcur = base;
+  if(hdb->apsync > base) tchdbsetapsync(hdb, base);
+  if(cur < hdb->fsiz){
+    if(fbsiz > HDBFBMAXSIZ){
+      tchdbfbptrim(hdb, base, cur, 0, 0);
+      uint64_t off = dest;
+      uint64_t size = fbsiz;
+      while(size > 0){
+        uint32_t rsiz = (size > HDBFBMAXSIZ) ? HDBFBMAXSIZ : size;
+        if(size - rsiz < HDBMINRUNIT) rsiz = size;
+        tchdbfbpinsert(hdb, off, rsiz);
+        if(!tchdbwritefb(hdb, off, rsiz)) return false;
+        off += rsiz;
+        size -= rsiz;
+      }
     } else {
-      if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)) return NULL;
-      int kcmp = tcreckeycmp(kbuf, ksiz, rec.kbuf, rec.ksiz);
-      if(kcmp > 0){
-        off = rec.left;
-        TCFREE(rec.bbuf);
-        rec.kbuf = NULL;
-        rec.bbuf = NULL;
-      } else if(kcmp < 0){
-        off = rec.right;
-        TCFREE(rec.bbuf);
-        rec.kbuf = NULL;
-        rec.bbuf = NULL;
-      } else {
-        if(!rec.vbuf && !tchdbreadrecbody(hdb, &rec)) return NULL;
-        if(hdb->zmode){
-          int zsiz;
-          char *zbuf;
-          if(hdb->opts & HDBTDEFLATE){
-            zbuf = _tc_inflate(rec.vbuf, rec.vsiz, &zsiz, _TCZMRAW);
-          } else if(hdb->opts & HDBTBZIP){
-            zbuf = _tc_bzdecompress(rec.vbuf, rec.vsiz, &zsiz);
-          } else if(hdb->opts & HDBTTCBS){
-            zbuf = tcbsdecode(rec.vbuf, rec.vsiz, &zsiz);
-          } else {
-            zbuf = hdb->dec(rec.vbuf, rec.vsiz, &zsiz, hdb->decop);
-          }
-          TCFREE(rec.bbuf);
-          if(!zbuf){
-            tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
-            return NULL;
-          }
-          if(hdb->recc){
-            if(tcmdbrnum(hdb->recc) >= hdb->rcnum) tchdbcacheadjust(hdb);
-            tcmdbput4(hdb->recc, kbuf, ksiz, "=", 1, zbuf, zsiz);
-          }
-          *sp = zsiz;
-          return zbuf;
-        }
-        if(hdb->recc){
-          if(tcmdbrnum(hdb->recc) >= hdb->rcnum) tchdbcacheadjust(hdb);
-          tcmdbput4(hdb->recc, kbuf, ksiz, "=", 1, rec.vbuf, rec.vsiz);
-        }
-        if(rec.bbuf){
-          memmove(rec.bbuf, rec.vbuf, rec.vsiz);
-          rec.bbuf[rec.vsiz] = '\0';
-          *sp = rec.vsiz;
-          return rec.bbuf;
-        }
-        *sp = rec.vsiz;
-        char *rv;
-        TCMEMDUP(rv, rec.vbuf, rec.vsiz);
-        return rv;
+      tchdbfbptrim(hdb, base, cur, dest, fbsiz);
+      if(!tchdbwritefb(hdb, dest, fbsiz)) return false;
+    }
+    hdb->dfcur = cur - fbsiz;
+  } else {
+    TCDODEBUG(hdb->cnt_trunc++);
+    if(hdb->tran && !tchdbwalwrite(hdb, dest, fbsiz)) return false;
+    tchdbfbptrim(hdb, base, cur, 0, 0);
+    hdb->dfcur = hdb->frec;
+    hdb->fsiz = dest;
+    uint64_t llnum = hdb->fsiz;
+    llnum = TCHTOILL(llnum);
+    memcpy(hdb->map + HDBFSIZOFF, &llnum, sizeof(llnum));
+    if(hdb->iter >= hdb->fsiz) hdb->iter = UINT64_MAX;
+    if(!hdb->tran){
+      if(ftruncate(hdb->fd, hdb->fsiz) == -1){
+        tchdbsetecode(hdb, TCETRUNC, __FILE__, __LINE__, __func__);
+        return false;
       }
+      hdb->xfsiz = 0;
     }
   }
-  if(hdb->recc){
-    if(tcmdbrnum(hdb->recc) >= hdb->rcnum) tchdbcacheadjust(hdb);
-    tcmdbput(hdb->recc, kbuf, ksiz, "*", 1);
-  }
-  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
-  return NULL;
+  return true;
 }
 
 
-/* Retrieve a record in a hash database object and write the value into a buffer.
-   `hdb' specifies the hash database object.
-   `kbuf' specifies the pointer to the region of the key.
-   `ksiz' specifies the size of the region of the key.
-   `bidx' specifies the index of the bucket array.
-   `hash' specifies the hash value for the collision tree.
-   `vbuf' specifies the pointer to the buffer into which the value of the corresponding record is
-   written.
-   `max' specifies the size of the buffer.
-   If successful, the return value is the size of the written data, else, it is -1. */
-static int tchdbgetintobuf(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash,
-                           char *vbuf, int max){
-  assert(hdb && kbuf && ksiz >= 0 && vbuf && max >= 0);
-  if(hdb->recc){
-    int tvsiz;
-    char *tvbuf = tcmdbget(hdb->recc, kbuf, ksiz, &tvsiz);
-    if(tvbuf){
-      if(*tvbuf == '*'){
-        tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
-        TCFREE(tvbuf);
-        return -1;
-      }
-      tvsiz = tclmin(tvsiz - 1, max);
-      memcpy(vbuf, tvbuf + 1, tvsiz);
-      TCFREE(tvbuf);
-      return tvsiz;
-    }
-  }
-  off_t off = tchdbgetbucket(hdb, bidx);
+/* Perform dynamic defragmentation of a hash database object opened in append-only mode.
+   `hdb' specifies the hash database object connected as a writer.
+   `step' specifie the number of steps.
+   If successful, the return value is true, else, it is false.
+   Free blocks met by the cursor are joined into the free extent, which new records fill from its
+   head.  A live record behind a gap is copied into the extent or to the end of the file, and its
+   old region is made a free block only after the tree refers to the new copy.  The end of the
+   records synchronized is kept at or before the extent, so that recovery after a crash scans both
+   copies.  When the cursor reaches the end of the file, the file is truncated at the extent. */
+static bool tchdbapdefrag(TCHDB *hdb, int64_t step){
+  assert(hdb && step >= 0);
+  if(hdb->tran) return true;
   TCHREC rec;
   char rbuf[HDBIOBUFSIZ];
-  while(off > 0){
+  while(step-- > 0){
+    if(hdb->dfcur >= hdb->fsiz){
+      if(hdb->apend > 0 && hdb->apcur < hdb->fsiz){
+        TCDODEBUG(hdb->cnt_trunc++);
+        tchdbfbptrim(hdb, hdb->apcur, hdb->fsiz, 0, 0);
+        hdb->fsiz = hdb->apcur;
+        uint64_t llnum = hdb->fsiz;
+        llnum = TCHTOILL(llnum);
+        memcpy(hdb->map + HDBFSIZOFF, &llnum, sizeof(llnum));
+        if(hdb->iter >= hdb->fsiz) hdb->iter = UINT64_MAX;
+        if(hdb->apsync > hdb->fsiz) tchdbsetapsync(hdb, hdb->fsiz);
+        if(ftruncate(hdb->fd, hdb->fsiz) == -1){
+          tchdbsetecode(hdb, TCETRUNC, __FILE__, __LINE__, __func__);
+          return false;
+        }
+        hdb->xfsiz = 0;
+      }
+      hdb->dfcur = hdb->frec;
+      hdb->apcur = 0;
+      hdb->apend = 0;
+      return true;
+    }
+    uint64_t off = hdb->dfcur;
     rec.off = off;
-    if(!tchdbreadrec(hdb, &rec, rbuf)) return -1;
-    if(hash > rec.hash){
-      off = rec.left;
-    } else if(hash < rec.hash){
-      off = rec.right;
-    } else {
-      if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)) return -1;
-      int kcmp = tcreckeycmp(kbuf, ksiz, rec.kbuf, rec.ksiz);
-      if(kcmp > 0){
-        off = rec.left;
+    if(!tchdbreadrec(hdb, &rec, rbuf)) return false;
+    uint32_t rsiz = rec.rsiz;
+    if(rec.magic != HDBMAGICFB){
+      if(!rec.vbuf && !tchdbreadrecbody(hdb, &rec)) return false;
+      uint8_t hash;
+      uint64_t bidx = tchdbbidx(hdb, rec.kbuf, rec.ksiz, &hash);
+      bool hit = false;
+      if(hash == rec.hash && !tchdbreferred(hdb, &rec, bidx, hash, &hit)){
         TCFREE(rec.bbuf);
-        rec.kbuf = NULL;
-        rec.bbuf = NULL;
-      } else if(kcmp < 0){
-        off = rec.right;
+        return false;
+      }
+      if(hit && (hdb->apend < 1 || hdb->apcur == off)){
         TCFREE(rec.bbuf);
-        rec.kbuf = NULL;
-        rec.bbuf = NULL;
-      } else {
-        if(!rec.vbuf && !tchdbreadrecbody(hdb, &rec)) return -1;
-        if(hdb->zmode){
-          int zsiz;
-          char *zbuf;
-          if(hdb->opts & HDBTDEFLATE){
-            zbuf = _tc_inflate(rec.vbuf, rec.vsiz, &zsiz, _TCZMRAW);
-          } else if(hdb->opts & HDBTBZIP){
-            zbuf = _tc_bzdecompress(rec.vbuf, rec.vsiz, &zsiz);
-          } else if(hdb->opts & HDBTTCBS){
-            zbuf = tcbsdecode(rec.vbuf, rec.vsiz, &zsiz);
-          } else {
-            zbuf = hdb->dec(rec.vbuf, rec.vsiz, &zsiz, hdb->decop);
-          }
-          TCFREE(rec.bbuf);
-          if(!zbuf){
-            tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
-            return -1;
-          }
-          if(hdb->recc){
-            if(tcmdbrnum(hdb->recc) >= hdb->rcnum) tchdbcacheadjust(hdb);
-            tcmdbput4(hdb->recc, kbuf, ksiz, "=", 1, zbuf, zsiz);
-          }
-          zsiz = tclmin(zsiz, max);
-          memcpy(vbuf, zbuf, zsiz);
-          TCFREE(zbuf);
-          return zsiz;
-        }
-        if(hdb->recc){
-          if(tcmdbrnum(hdb->recc) >= hdb->rcnum) tchdbcacheadjust(hdb);
-          tcmdbput4(hdb->recc, kbuf, ksiz, "=", 1, rec.vbuf, rec.vsiz);
+        hdb->dfcur = off + rsiz;
+        if(hdb->apend > 0){
+          hdb->apcur = hdb->dfcur;
+          hdb->apend = hdb->dfcur;
         }
-        int vsiz = tclmin(rec.vsiz, max);
-        memcpy(vbuf, rec.vbuf, vsiz);
+        continue;
+      }
+      if(hit && hdb->iter > off && hdb->iter <= hdb->fsiz &&
+         tchdbapfit(hdb, rsiz - rec.psiz) < 0){
+        TCFREE(rec.bbuf);
+        hdb->dfcur = off + rsiz;
+        hdb->apcur = hdb->dfcur;
+        hdb->apend = hdb->dfcur;
+        continue;
+      }
+      if(hit){
+        TCDODEBUG(hdb->cnt_moverec++);
+        if(!tchdbshiftrec(hdb, &rec, rbuf, 0)) return false;
+        if(hdb->iter == off) hdb->iter = (rec.off < off) ? rec.off : off + rsiz;
+        if(hdb->vlgccur > rec.off) hdb->vlgccur = rec.off;
+        if(hdb->xtcur > rec.off) hdb->xtcur = rec.off;
+      } else {
         TCFREE(rec.bbuf);
-        return vsiz;
       }
+      if(!tchdbwritefb(hdb, off, rsiz)) return false;
+    }
+    tchdbfbptrim(hdb, off, off + rsiz, 0, 0);
+    if(hdb->apend == off && hdb->apend - hdb->apcur + rsiz <= HDBFBMAXSIZ){
+      hdb->apend += rsiz;
+      if(!tchdbwritefb(hdb, hdb->apcur, hdb->apend - hdb->apcur)) return false;
+    } else if(hdb->apcur >= hdb->apend){
+      hdb->apcur = off;
+      hdb->apend = off + rsiz;
+      if(hdb->apsync > off) tchdbsetapsync(hdb, off);
+    }
+    hdb->dfcur = off + rsiz;
+    if(hdb->iter > hdb->apcur && hdb->iter < hdb->dfcur) hdb->iter = hdb->dfcur;
+    if(hdb->vlgccur > hdb->apcur && hdb->vlgccur < hdb->dfcur) hdb->vlgccur = hdb->dfcur;
+    if(hdb->xtcur > hdb->apcur && hdb->xtcur < hdb->dfcur) hdb->xtcur = hdb->dfcur;
+  }
+  return true;
+}
+
+
+/* Open the value log of a hash database object.
+   `hdb' specifies the hash database object.
+   `path' specifies the path of the database file.
+   `omode' specifies the connection mode.
+   If successful, the return value is true, else, it is false.
+   The value log is created only by a writer with the threshold of the value log.  If it does not
+   exist, the database is used without it. */
+static bool tchdbvlopen(TCHDB *hdb, const char *path, int omode){
+  assert(hdb && path);
+  hdb->vlfd = -1;
+  hdb->vlhead = 0;
+  hdb->vlgccur = 0;
+  hdb->vlgcend = 0;
+  hdb->vlgcdead = 0;
+  char *vpath = tcsprintf("%s%c%s", path, MYEXTCHR, HDBVLSUFFIX);
+  int mode = O_RDONLY;
+  if(omode & HDBOWRITER){
+    mode = O_RDWR;
+    if(hdb->vlthres > 0) mode |= O_CREAT;
+    if(omode & HDBOTRUNC) mode |= O_TRUNC;
+  }
+  int fd = open(vpath, mode, HDBFILEMODE);
+  TCFREE(vpath);
+  if(fd < 0){
+    if(errno == ENOENT) return true;
+    int ecode = TCEOPEN;
+    switch(errno){
+      case EACCES: ecode = TCENOPERM; break;
+      case ENOTDIR: ecode = TCENOFILE; break;
     }
+    tchdbsetecode(hdb, ecode, __FILE__, __LINE__, __func__);
+    return false;
   }
-  if(hdb->recc){
-    if(tcmdbrnum(hdb->recc) >= hdb->rcnum) tchdbcacheadjust(hdb);
-    tcmdbput(hdb->recc, kbuf, ksiz, "*", 1);
+  struct stat sbuf;
+  if(fstat(fd, &sbuf) == -1 || !S_ISREG(sbuf.st_mode)){
+    tchdbsetecode(hdb, TCESTAT, __FILE__, __LINE__, __func__);
+    close(fd);
+    return false;
   }
-  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
-  return -1;
+  hdb->vlfd = fd;
+  hdb->vlhead = sbuf.st_size;
+  if(hdb->vltail > hdb->vlhead) hdb->vltail = hdb->vlhead;
+  return true;
 }
 
 
-/* Retrieve the next record of a record in a hash database object.
+/* Read data from the value log of a hash database object.
    `hdb' specifies the hash database object.
-   `kbuf' specifies the pointer to the region of the key.
-   `ksiz' specifies the size of the region of the key.
-   `sp' specifies the pointer to the variable into which the size of the region of the return
-   value is assigned.
-   `vbp' specifies the pointer to the variable into which the pointer to the value is assigned.
-   `vsp' specifies the pointer to the variable into which the size of the value is assigned.
-   If successful, the return value is the pointer to the region of the value of the next
-   record. */
-static char *tchdbgetnextimpl(TCHDB *hdb, const char *kbuf, int ksiz, int *sp,
-                              const char **vbp, int *vsp){
-  assert(hdb && sp);
-  if(!kbuf){
-    uint64_t iter = hdb->frec;
-    TCHREC rec;
-    char rbuf[HDBIOBUFSIZ];
-    while(iter < hdb->fsiz){
-      rec.off = iter;
-      if(!tchdbreadrec(hdb, &rec, rbuf)) return NULL;
-      iter += rec.rsiz;
-      if(rec.magic == HDBMAGICREC){
-        if(vbp){
-          if(hdb->zmode){
-            if(!tchdbreadrecbody(hdb, &rec)) return NULL;
-            int zsiz;
-            char *zbuf;
-            if(hdb->opts & HDBTDEFLATE){
-              zbuf = _tc_inflate(rec.vbuf, rec.vsiz, &zsiz, _TCZMRAW);
-            } else if(hdb->opts & HDBTBZIP){
-              zbuf = _tc_bzdecompress(rec.vbuf, rec.vsiz, &zsiz);
-            } else if(hdb->opts & HDBTTCBS){
-              zbuf = tcbsdecode(rec.vbuf, rec.vsiz, &zsiz);
-            } else {
-              zbuf = hdb->dec(rec.vbuf, rec.vsiz, &zsiz, hdb->decop);
-            }
-            if(!zbuf){
-              tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
-              TCFREE(rec.bbuf);
-              return NULL;
-            }
-            char *rv;
-            TCMALLOC(rv, rec.ksiz + zsiz + 1);
-            memcpy(rv, rec.kbuf, rec.ksiz);
-            memcpy(rv + rec.ksiz, zbuf, zsiz);
-            *sp = rec.ksiz;
-            *vbp = rv + rec.ksiz;
-            *vsp = zsiz;
-            TCFREE(zbuf);
-            TCFREE(rec.bbuf);
-            return rv;
-          }
-          if(rec.vbuf){
-            char *rv;
-            TCMALLOC(rv, rec.ksiz + rec.vsiz + 1);
-            memcpy(rv, rec.kbuf, rec.ksiz);
-            memcpy(rv + rec.ksiz, rec.vbuf, rec.vsiz);
-            *sp = rec.ksiz;
-            *vbp = rv + rec.ksiz;
-            *vsp = rec.vsiz;
-            return rv;
-          }
-          if(!tchdbreadrecbody(hdb, &rec)) return NULL;
-          *sp = rec.ksiz;
-          *vbp = rec.vbuf;
-          *vsp = rec.vsiz;
-          return rec.bbuf;
-        }
-        if(rec.kbuf){
-          *sp = rec.ksiz;
-          char *rv;
-          TCMEMDUP(rv, rec.kbuf, rec.ksiz);
-          return rv;
-        }
-        if(!tchdbreadrecbody(hdb, &rec)) return NULL;
-        rec.bbuf[rec.ksiz] = '\0';
-        *sp = rec.ksiz;
-        return rec.bbuf;
-      }
+   `off' specifies the offset of the region to read.
+   `buf' specifies the buffer to store into.
+   `size' specifies the size of the buffer.
+   The return value is true if successful, else, it is false. */
+static bool tchdbvlread(TCHDB *hdb, uint64_t off, void *buf, size_t size){
+  assert(hdb && buf && size >= 0);
+  if(!tchdbvlreadraw(hdb, off, buf, size)){
+    tchdbsetecode(hdb, TCEREAD, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  return true;
+}
+
+
+/* Read a region of the value log without setting the error code.
+   `hdb' specifies the hash database object.
+   `off' specifies the offset of the region.
+   `buf' specifies the buffer to store into.
+   `size' specifies the size of the region.
+   The return value is true if successful, else, it is false. */
+static bool tchdbvlreadraw(TCHDB *hdb, uint64_t off, void *buf, size_t size){
+  assert(hdb && buf && size >= 0);
+  if(hdb->vlfd < 0 || off < hdb->vltail) return false;
+  while(size > 0){
+    ssize_t rb = pread(hdb->vlfd, buf, size, off);
+    if(rb > 0){
+      buf = (char *)buf + rb;
+      size -= rb;
+      off += rb;
+    } else if(rb == -1 && errno == EINTR){
+      continue;
+    } else {
+      return false;
     }
-    tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
-    return NULL;
   }
-  uint8_t hash;
-  uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
-  off_t off = tchdbgetbucket(hdb, bidx);
+  return true;
+}
+
+
+/* Write data into the value log of a hash database object.
+   `hdb' specifies the hash database object.
+   `off' specifies the offset of the region to write.
+   `buf' specifies the buffer to write.
+   `size' specifies the size of the buffer.
+   The return value is true if successful, else, it is false. */
+static bool tchdbvlwrite(TCHDB *hdb, uint64_t off, const void *buf, size_t size){
+  assert(hdb && hdb->vlfd >= 0 && buf && size >= 0);
+  while(size > 0){
+    ssize_t wb = pwrite(hdb->vlfd, buf, size, off);
+    if(wb > 0){
+      buf = (char *)buf + wb;
+      size -= wb;
+      off += wb;
+    } else if(wb == -1 && errno == EINTR){
+      continue;
+    } else {
+      tchdbsetecode(hdb, TCEWRITE, __FILE__, __LINE__, __func__);
+      return false;
+    }
+  }
+  return true;
+}
+
+
+/* Perform a step of garbage collection of the value log of a hash database object.
+   `hdb' specifies the hash database object connected as a writer.
+   `step' specifie the number of records to be scanned.
+   If successful, the return value is true, else, it is false.
+   A pass is started when dead values occupy a certain ratio of the log.  It scans all records,
+   moves the live values in the region of the log as of the start of the pass to the end of the
+   log, and releases the region at last.  The collection is suspended during an online backup so
+   that the value log is only appended. */
+static bool tchdbvlgcstep(TCHDB *hdb, int64_t step){
+  assert(hdb && step >= 0);
+  if(hdb->vlfd < 0 || hdb->tran || hdb->bkup) return true;
+  if(hdb->vlgccur < 1){
+    uint64_t lsiz = hdb->vlhead - hdb->vltail;
+    if(hdb->vldead < 1 || hdb->vldead < lsiz * HDBVLGCRAT) return true;
+    hdb->vlgccur = hdb->frec;
+    hdb->vlgcend = hdb->vlhead;
+    hdb->vlgcdead = hdb->vldead;
+    hdb->vldead = 0;
+  }
   TCHREC rec;
   char rbuf[HDBIOBUFSIZ];
-  while(off > 0){
-    rec.off = off;
-    if(!tchdbreadrec(hdb, &rec, rbuf)) return NULL;
-    if(hash > rec.hash){
-      off = rec.left;
-    } else if(hash < rec.hash){
-      off = rec.right;
-    } else {
-      if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)) return NULL;
-      int kcmp = tcreckeycmp(kbuf, ksiz, rec.kbuf, rec.ksiz);
-      if(kcmp > 0){
-        off = rec.left;
-        TCFREE(rec.bbuf);
-        rec.kbuf = NULL;
-        rec.bbuf = NULL;
-      } else if(kcmp < 0){
-        off = rec.right;
-        TCFREE(rec.bbuf);
-        rec.kbuf = NULL;
-        rec.bbuf = NULL;
-      } else {
-        uint64_t iter = rec.off + rec.rsiz;
-        TCFREE(rec.bbuf);
-        rec.kbuf = NULL;
-        rec.bbuf = NULL;
-        while(iter < hdb->fsiz){
-          rec.off = iter;
-          if(!tchdbreadrec(hdb, &rec, rbuf)) return NULL;
-          iter += rec.rsiz;
-          if(rec.magic == HDBMAGICREC){
-            if(vbp){
-              if(hdb->zmode){
-                if(!tchdbreadrecbody(hdb, &rec)) return NULL;
-                int zsiz;
-                char *zbuf;
-                if(hdb->opts & HDBTDEFLATE){
-                  zbuf = _tc_inflate(rec.vbuf, rec.vsiz, &zsiz, _TCZMRAW);
-                } else if(hdb->opts & HDBTBZIP){
-                  zbuf = _tc_bzdecompress(rec.vbuf, rec.vsiz, &zsiz);
-                } else if(hdb->opts & HDBTTCBS){
-                  zbuf = tcbsdecode(rec.vbuf, rec.vsiz, &zsiz);
-                } else {
-                  zbuf = hdb->dec(rec.vbuf, rec.vsiz, &zsiz, hdb->decop);
-                }
-                if(!zbuf){
-                  tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
-                  TCFREE(rec.bbuf);
-                  return NULL;
-                }
-                char *rv;
-                TCMALLOC(rv, rec.ksiz + zsiz + 1);
-                memcpy(rv, rec.kbuf, rec.ksiz);
-                memcpy(rv + rec.ksiz, zbuf, zsiz);
-                *sp = rec.ksiz;
-                *vbp = rv + rec.ksiz;
-                *vsp = zsiz;
-                TCFREE(zbuf);
-                TCFREE(rec.bbuf);
-                return rv;
-              }
-              if(rec.vbuf){
-                char *rv;
-                TCMALLOC(rv, rec.ksiz + rec.vsiz + 1);
-                memcpy(rv, rec.kbuf, rec.ksiz);
-                memcpy(rv + rec.ksiz, rec.vbuf, rec.vsiz);
-                *sp = rec.ksiz;
-                *vbp = rv + rec.ksiz;
-                *vsp = rec.vsiz;
-                return rv;
-              }
-              if(!tchdbreadrecbody(hdb, &rec)) return NULL;
-              *sp = rec.ksiz;
-              *vbp = rec.vbuf;
-              *vsp = rec.vsiz;
-              return rec.bbuf;
-            }
-            if(rec.kbuf){
-              *sp = rec.ksiz;
-              char *rv;
-              TCMEMDUP(rv, rec.kbuf, rec.ksiz);
-              return rv;
-            }
-            if(!tchdbreadrecbody(hdb, &rec)) return NULL;
-            rec.bbuf[rec.ksiz] = '\0';
-            *sp = rec.ksiz;
-            return rec.bbuf;
-          }
+  char pbuf[HDBVLPTRSIZ];
+  while(step-- > 0 && hdb->vlgccur < hdb->fsiz){
+    rec.off = hdb->vlgccur;
+    if(!tchdbreadrec(hdb, &rec, rbuf)) return false;
+    if((rec.magic != HDBMAGICREC && rec.magic != HDBMAGICXREC) || !rec.vlog){
+      hdb->vlgccur += rec.rsiz;
+      continue;
+    }
+    if(!rec.vbuf && !tchdbreadrecbody(hdb, &rec)) return false;
+    bool err = false;
+    uint64_t off;
+    uint32_t vsiz;
+    if(tchdbvlgetref(hdb, &rec, &off, &vsiz)){
+      if(off < hdb->vlgcend){
+        char *vbuf;
+        TCMALLOC(vbuf, vsiz + 1);
+        uint64_t noff = __sync_fetch_and_add(&hdb->vlhead, vsiz);
+        if(tchdbvlread(hdb, off, vbuf, vsiz) && tchdbvlwrite(hdb, noff, vbuf, vsiz)){
+          tchdbvlsetref(pbuf, noff, vsiz);
+          if(!tchdbseekwrite(hdb, rec.boff + rec.ksiz, pbuf, HDBVLPTRSIZ)) err = true;
+        } else {
+          err = true;
         }
-        tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
-        return NULL;
+        TCFREE(vbuf);
       }
+    } else {
+      err = true;
+    }
+    TCFREE(rec.bbuf);
+    if(err) return false;
+    hdb->vlgccur += rec.rsiz;
+  }
+  if(hdb->vlgccur < hdb->fsiz) return true;
+  if(fsync(hdb->vlfd) == -1){
+    tchdbsetecode(hdb, TCESYNC, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  if(!tchdbmemsync(hdb, true)) return false;
+  if(hdb->vlgcend >= hdb->vlhead){
+    if(ftruncate(hdb->vlfd, 0) == -1){
+      tchdbsetecode(hdb, TCETRUNC, __FILE__, __LINE__, __func__);
+      return false;
+    }
+    hdb->vlhead = 0;
+    hdb->vltail = 0;
+  } else {
+#if defined(FALLOC_FL_PUNCH_HOLE) && defined(FALLOC_FL_KEEP_SIZE)
+    if(hdb->vlgcend > hdb->vltail)
+      fallocate(hdb->vlfd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                hdb->vltail, hdb->vlgcend - hdb->vltail);
+#endif
+    hdb->vltail = hdb->vlgcend;
+  }
+  hdb->vlgccur = 0;
+  hdb->vlgcend = 0;
+  hdb->vlgcdead = 0;
+  hdb->vlgcnum++;
+  return true;
+}
+
+
+/* Perform a step of the expiration sweeper of a hash database object.
+   `hdb' specifies the hash database object connected as a writer.
+   `step' specifie the number of records to be scanned.
+   If successful, the return value is true, else, it is false.
+   Records with expiration times are kept in the expiration index by coarse time slots, and the
+   sweeper visits only the offsets in the slots which have expired.  The index lives in memory,
+   so it is built by a pass scanning all records, which is started at most once in a certain
+   interval while the index is missing.  The pass also removes the records which have expired.
+   When the index is empty, the flag of expiration is cleared so that no more sweep is run until
+   a record with an expiration time is stored again. */
+static bool tchdbxtstep(TCHDB *hdb, int64_t step){
+  assert(hdb && step >= 0);
+  if(!(hdb->flags & HDBFEXPIRE) || hdb->tran) return true;
+  if(hdb->xtidx && hdb->xtinum > hdb->rnum * HDBXTIDXRAT + HDBXTIDXMIN) tchdbxtreset(hdb);
+  if(hdb->xtidx && hdb->xtcur < 1) return tchdbxtsweep(hdb, step);
+  if(hdb->xtcur < 1){
+    time_t now = time(NULL);
+    if(now < hdb->xtnext) return true;
+    hdb->xtcur = hdb->frec;
+    hdb->xtnext = now + HDBXTSWINTV;
+    hdb->xtidx = tctreenew2(tccmpint64, NULL);
+    hdb->xtinum = 0;
+  }
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ];
+  while(step-- > 0 && hdb->xtcur < hdb->fsiz){
+    rec.off = hdb->xtcur;
+    if(!tchdbreadrec(hdb, &rec, rbuf)) return false;
+    hdb->xtcur += rec.rsiz;
+    if(rec.magic == HDBMAGICXREC){
+      if(!tchdbxtremove(hdb, &rec, rbuf)) return false;
+    } else if(rec.magic == HDBMAGICREC && rec.xtime > 0){
+      tchdbxtindex(hdb, rec.off, rec.xtime);
     }
   }
-  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
-  return NULL;
+  if(hdb->xtcur >= hdb->fsiz){
+    hdb->xtcur = 0;
+    tchdbxtsetnext(hdb);
+  }
+  return true;
 }
 
 
-/* Get the size of the value of a record in a hash database object.
-   `hdb' specifies the hash database object.
-   `kbuf' specifies the pointer to the region of the key.
-   `ksiz' specifies the size of the region of the key.
-   `bidx' specifies the index of the bucket array.
-   `hash' specifies the hash value for the collision tree.
-   If successful, the return value is the size of the value of the corresponding record, else,
-   it is -1. */
-static int tchdbvsizimpl(TCHDB *hdb, const char *kbuf, int ksiz, uint64_t bidx, uint8_t hash){
-  assert(hdb && kbuf && ksiz >= 0);
-  if(hdb->recc){
-    int tvsiz;
-    char *tvbuf = tcmdbget(hdb->recc, kbuf, ksiz, &tvsiz);
-    if(tvbuf){
-      if(*tvbuf == '*'){
-        tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
-        TCFREE(tvbuf);
-        return -1;
+/* Sweep the expired slots of the expiration index of a hash database object.
+   `hdb' specifies the hash database object connected as a writer.
+   `step' specifie the number of offsets to be visited.
+   If successful, the return value is true, else, it is false.
+   An offset is stale if the record has been moved or removed since it was indexed.  It is
+   skipped unless a record which has expired starts there and the tree of its bucket refers to
+   it. */
+static bool tchdbxtsweep(TCHDB *hdb, int64_t step){
+  assert(hdb && hdb->xtidx && step >= 0);
+  time_t now = time(NULL);
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ+sizeof(uint64_t)];
+  while(step > 0 && tctreernum(hdb->xtidx) > 0){
+    tctreeiterinit(hdb->xtidx);
+    int ksiz;
+    const char *kbuf = tctreeiternext(hdb->xtidx, &ksiz);
+    int64_t slot;
+    memcpy(&slot, kbuf, sizeof(slot));
+    if((slot + 1) * HDBXTSWINTV > now) break;
+    int vsiz;
+    const char *vbuf = tctreeiterval(kbuf, &vsiz);
+    int onum = vsiz / sizeof(uint64_t);
+    int num = (onum > step) ? step : onum;
+    char *obuf;
+    TCMEMDUP(obuf, vbuf, vsiz);
+    uint64_t *offs = (uint64_t *)obuf;
+    if(num < onum){
+      tctreeput(hdb->xtidx, &slot, sizeof(slot), offs + num, (onum - num) * sizeof(uint64_t));
+    } else {
+      tctreeout(hdb->xtidx, &slot, sizeof(slot));
+    }
+    hdb->xtinum -= num;
+    step -= num;
+    bool err = false;
+    for(int i = 0; i < num && !err; i++){
+      uint64_t off = offs[i];
+      if(off < hdb->frec || off >= hdb->fsiz) continue;
+      int rsiz = tclmin(hdb->runit, hdb->fsiz - off);
+      if(rsiz < (int)(sizeof(uint8_t) + sizeof(uint32_t))) continue;
+      if(!tchdbseekread(hdb, off, rbuf, rsiz)){
+        err = true;
+        break;
       }
-      TCFREE(tvbuf);
-      return tvsiz - 1;
+      memset(rbuf + rsiz, 0, sizeof(uint64_t));
+      rec.off = off;
+      if(!tchdbparserectry(hdb, &rec, rbuf, rsiz) || rec.magic != HDBMAGICXREC ||
+         off + rec.rsiz > hdb->fsiz) continue;
+      if(!tchdbxtremove(hdb, &rec, rbuf)) err = true;
     }
+    TCFREE(obuf);
+    if(err) return false;
+  }
+  tchdbxtsetnext(hdb);
+  return true;
+}
+
+
+/* Remove a record which has expired from a hash database object.
+   `hdb' specifies the hash database object connected as a writer.
+   `rec' specifies the record object which has expired.
+   `rbuf' specifies the buffer for reading.
+   If successful, the return value is true, else, it is false.
+   Nothing is done unless the tree of the bucket refers to the record. */
+static bool tchdbxtremove(TCHDB *hdb, TCHREC *rec, char *rbuf){
+  assert(hdb && rec && rbuf);
+  TCHREC trec;
+  char tbuf[HDBIOBUFSIZ];
+  if(!rec->kbuf && !tchdbreadrecbody(hdb, rec)){
+    TCFREE(rec->bbuf);
+    return false;
   }
+  uint8_t hash;
+  uint64_t bidx = tchdbbidx(hdb, rec->kbuf, rec->ksiz, &hash);
   off_t off = tchdbgetbucket(hdb, bidx);
-  TCHREC rec;
-  char rbuf[HDBIOBUFSIZ];
-  while(off > 0){
-    rec.off = off;
-    if(!tchdbreadrec(hdb, &rec, rbuf)) return -1;
-    if(hash > rec.hash){
-      off = rec.left;
-    } else if(hash < rec.hash){
-      off = rec.right;
+  off_t entoff = 0;
+  bool err = false;
+  while(off > 0 && off != rec->off){
+    trec.off = off;
+    if(!tchdbreadrec(hdb, &trec, tbuf)){
+      err = true;
+      break;
+    }
+    if(hash > trec.hash){
+      off = trec.left;
+      entoff = trec.off + (sizeof(uint8_t) + sizeof(uint8_t));
+    } else if(hash < trec.hash){
+      off = trec.right;
+      entoff = trec.off + (sizeof(uint8_t) + sizeof(uint8_t)) +
+        (hdb->ba64 ? sizeof(uint64_t) : sizeof(uint32_t));
     } else {
-      if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)) return -1;
-      int kcmp = tcreckeycmp(kbuf, ksiz, rec.kbuf, rec.ksiz);
+      if(!trec.kbuf && !tchdbreadrecbody(hdb, &trec)){
+        TCFREE(trec.bbuf);
+        err = true;
+        break;
+      }
+      int kcmp = tcreckeycmp(rec->kbuf, rec->ksiz, trec.kbuf, trec.ksiz);
+      TCFREE(trec.bbuf);
       if(kcmp > 0){
-        off = rec.left;
-        TCFREE(rec.bbuf);
-        rec.kbuf = NULL;
-        rec.bbuf = NULL;
+        off = trec.left;
+        entoff = trec.off + (sizeof(uint8_t) + sizeof(uint8_t));
       } else if(kcmp < 0){
-        off = rec.right;
-        TCFREE(rec.bbuf);
-        rec.kbuf = NULL;
-        rec.bbuf = NULL;
+        off = trec.right;
+        entoff = trec.off + (sizeof(uint8_t) + sizeof(uint8_t)) +
+          (hdb->ba64 ? sizeof(uint64_t) : sizeof(uint32_t));
       } else {
-        if(hdb->zmode){
-          if(!rec.vbuf && !tchdbreadrecbody(hdb, &rec)) return -1;
-          int zsiz;
-          char *zbuf;
-          if(hdb->opts & HDBTDEFLATE){
-            zbuf = _tc_inflate(rec.vbuf, rec.vsiz, &zsiz, _TCZMRAW);
-          } else if(hdb->opts & HDBTBZIP){
-            zbuf = _tc_bzdecompress(rec.vbuf, rec.vsiz, &zsiz);
-          } else if(hdb->opts & HDBTTCBS){
-            zbuf = tcbsdecode(rec.vbuf, rec.vsiz, &zsiz);
-          } else {
-            zbuf = hdb->dec(rec.vbuf, rec.vsiz, &zsiz, hdb->decop);
-          }
-          TCFREE(rec.bbuf);
-          if(!zbuf){
-            tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
-            return -1;
-          }
-          if(hdb->recc){
-            if(tcmdbrnum(hdb->recc) >= hdb->rcnum) tchdbcacheadjust(hdb);
-            tcmdbput4(hdb->recc, kbuf, ksiz, "=", 1, zbuf, zsiz);
-          }
-          TCFREE(zbuf);
-          return zsiz;
-        }
-        if(hdb->recc && rec.vbuf){
-          if(tcmdbrnum(hdb->recc) >= hdb->rcnum) tchdbcacheadjust(hdb);
-          tcmdbput4(hdb->recc, kbuf, ksiz, "=", 1, rec.vbuf, rec.vsiz);
-        }
-        TCFREE(rec.bbuf);
-        return rec.vsiz;
+        break;
       }
     }
   }
-  if(hdb->recc){
-    if(tcmdbrnum(hdb->recc) >= hdb->rcnum) tchdbcacheadjust(hdb);
-    tcmdbput(hdb->recc, kbuf, ksiz, "*", 1);
+  if(!err && off == rec->off){
+    if(hdb->recc) tchdbrcout(hdb, rec->kbuf, rec->ksiz);
+    uint64_t vloff;
+    uint32_t vlsiz;
+    if(!tchdbvlpeek(hdb, rec, &vloff, &vlsiz)) err = true;
+    TCFREE(rec->bbuf);
+    rec->bbuf = NULL;
+    if(!err && !tchdbremoverec(hdb, rec, rbuf, bidx, entoff)) err = true;
+    if(!err) tchdbvlrelease(hdb, vloff, vlsiz);
+  } else {
+    TCFREE(rec->bbuf);
   }
-  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
-  return -1;
+  return !err;
 }
 
 
-/* Initialize the iterator of a hash database object.
+/* Add a record to the expiration index of a hash database object.
    `hdb' specifies the hash database object.
-   If successful, the return value is true, else, it is false. */
-static bool tchdbiterinitimpl(TCHDB *hdb){
-  assert(hdb);
-  hdb->iter = hdb->frec;
-  return true;
+   `off' specifies the offset of the record.
+   `xtime' specifies the expiration time of the record. */
+static void tchdbxtindex(TCHDB *hdb, uint64_t off, uint32_t xtime){
+  assert(hdb && off > 0);
+  if(!HDBLOCKDB(hdb)) return;
+  if(hdb->xtidx){
+    int64_t slot = xtime / HDBXTSWINTV;
+    tctreeputcat(hdb->xtidx, &slot, sizeof(slot), &off, sizeof(off));
+    hdb->xtinum++;
+  }
+  HDBUNLOCKDB(hdb);
 }
 
 
-/* Get the next key of the iterator of a hash database object.
+/* Discard the expiration index of a hash database object.
    `hdb' specifies the hash database object.
-   `sp' specifies the pointer to the variable into which the size of the region of the return
-   value is assigned.
-   If successful, the return value is the pointer to the region of the next key, else, it is
-   `NULL'. */
-static char *tchdbiternextimpl(TCHDB *hdb, int *sp){
-  assert(hdb && sp);
-  TCHREC rec;
-  char rbuf[HDBIOBUFSIZ];
-  while(hdb->iter < hdb->fsiz){
-    rec.off = hdb->iter;
-    if(!tchdbreadrec(hdb, &rec, rbuf)) return NULL;
-    hdb->iter += rec.rsiz;
-    if(rec.magic == HDBMAGICREC){
-      if(rec.kbuf){
-        *sp = rec.ksiz;
-        char *rv;
-        TCMEMDUP(rv, rec.kbuf, rec.ksiz);
-        return rv;
-      }
-      if(!tchdbreadrecbody(hdb, &rec)) return NULL;
-      rec.bbuf[rec.ksiz] = '\0';
-      *sp = rec.ksiz;
-      return rec.bbuf;
-    }
+   The index is built again by the next pass of the expiration sweeper. */
+static void tchdbxtreset(TCHDB *hdb){
+  assert(hdb);
+  if(hdb->xtidx){
+    tctreedel(hdb->xtidx);
+    hdb->xtidx = NULL;
   }
-  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
-  return NULL;
+  hdb->xtinum = 0;
 }
 
 
-/* Get the next extensible objects of the iterator of a hash database object. */
-static bool tchdbiternextintoxstr(TCHDB *hdb, TCXSTR *kxstr, TCXSTR *vxstr){
-  assert(hdb && kxstr && vxstr);
-  TCHREC rec;
-  char rbuf[HDBIOBUFSIZ];
-  while(hdb->iter < hdb->fsiz){
-    rec.off = hdb->iter;
-    if(!tchdbreadrec(hdb, &rec, rbuf)) return false;
-    hdb->iter += rec.rsiz;
-    if(rec.magic == HDBMAGICREC){
-      if(!rec.vbuf && !tchdbreadrecbody(hdb, &rec)) return false;
-      tcxstrclear(kxstr);
-      TCXSTRCAT(kxstr, rec.kbuf, rec.ksiz);
-      tcxstrclear(vxstr);
-      if(hdb->zmode){
-        int zsiz;
-        char *zbuf;
-        if(hdb->opts & HDBTDEFLATE){
-          zbuf = _tc_inflate(rec.vbuf, rec.vsiz, &zsiz, _TCZMRAW);
-        } else if(hdb->opts & HDBTBZIP){
-          zbuf = _tc_bzdecompress(rec.vbuf, rec.vsiz, &zsiz);
-        } else if(hdb->opts & HDBTTCBS){
-          zbuf = tcbsdecode(rec.vbuf, rec.vsiz, &zsiz);
-        } else {
-          zbuf = hdb->dec(rec.vbuf, rec.vsiz, &zsiz, hdb->decop);
-        }
-        if(!zbuf){
-          tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
-          TCFREE(rec.bbuf);
-          return false;
-        }
-        TCXSTRCAT(vxstr, zbuf, zsiz);
-        TCFREE(zbuf);
-      } else {
-        TCXSTRCAT(vxstr, rec.vbuf, rec.vsiz);
-      }
-      TCFREE(rec.bbuf);
-      return true;
-    }
+/* Set the time when the expiration sweeper of a hash database object runs next.
+   `hdb' specifies the hash database object connected as a writer.
+   It is when the earliest slot of the expiration index expires.  If the index is empty, the
+   flag of expiration is cleared instead. */
+static void tchdbxtsetnext(TCHDB *hdb){
+  assert(hdb && hdb->xtidx);
+  if(tctreernum(hdb->xtidx) < 1){
+    tchdbsetflag(hdb, HDBFEXPIRE, false);
+    return;
   }
-  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
-  return false;
+  tctreeiterinit(hdb->xtidx);
+  int ksiz;
+  const char *kbuf = tctreeiternext(hdb->xtidx, &ksiz);
+  int64_t slot;
+  memcpy(&slot, kbuf, sizeof(slot));
+  hdb->xtnext = (slot + 1) * HDBXTSWINTV;
 }
 
 
-/* Optimize the file of a hash database object.
+/* Move the iterator to the record corresponding a key of a hash database object.
    `hdb' specifies the hash database object.
-   `bnum' specifies the number of elements of the bucket array.
-   `apow' specifies the size of record alignment by power of 2.
-   `fpow' specifies the maximum number of elements of the free block pool by power of 2.
-   `opts' specifies options by bitwise-or.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
    If successful, the return value is true, else, it is false. */
-static bool tchdboptimizeimpl(TCHDB *hdb, int64_t bnum, int8_t apow, int8_t fpow, uint8_t opts){
-  assert(hdb);
-  char *tpath = tcsprintf("%s%ctmp%c%llu", hdb->path, MYEXTCHR, MYEXTCHR, hdb->inode);
-  TCHDB *thdb = tchdbnew();
-  thdb->dbgfd = hdb->dbgfd;
-  thdb->enc = hdb->enc;
-  thdb->encop = hdb->encop;
-  thdb->dec = hdb->dec;
-  thdb->decop = hdb->decop;
-  if(bnum < 1){
-    bnum = hdb->rnum * 2 + 1;
-    if(bnum < HDBDEFBNUM) bnum = HDBDEFBNUM;
-  }
-  if(apow < 0) apow = hdb->apow;
-  if(fpow < 0) fpow = hdb->fpow;
-  if(opts == UINT8_MAX) opts = hdb->opts;
-  tchdbtune(thdb, bnum, apow, fpow, opts);
-  if(!tchdbopen(thdb, tpath, HDBOWRITER | HDBOCREAT | HDBOTRUNC)){
-    tchdbsetecode(hdb, thdb->ecode, __FILE__, __LINE__, __func__);
-    tchdbdel(thdb);
-    TCFREE(tpath);
-    return false;
+static bool tchdbiterjumpimpl(TCHDB *hdb, const char *kbuf, int ksiz){
+  assert(hdb && kbuf && ksiz);
+  uint8_t hash;
+  uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
+  off_t off = tchdbgetbucket(hdb, bidx);
+  TCHREC rec;
+  char rbuf[HDBIOBUFSIZ];
+  while(off > 0){
+    rec.off = off;
+    if(!tchdbreadrec(hdb, &rec, rbuf)) return false;
+    if(hash > rec.hash){
+      off = rec.left;
+    } else if(hash < rec.hash){
+      off = rec.right;
+    } else {
+      if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)) return false;
+      int kcmp = tcreckeycmp(kbuf, ksiz, rec.kbuf, rec.ksiz);
+      if(kcmp > 0){
+        off = rec.left;
+        TCFREE(rec.bbuf);
+        rec.kbuf = NULL;
+        rec.bbuf = NULL;
+      } else if(kcmp < 0){
+        off = rec.right;
+        TCFREE(rec.bbuf);
+        rec.kbuf = NULL;
+        rec.bbuf = NULL;
+      } else {
+        hdb->iter = off;
+        return true;
+      }
+    }
   }
-  memcpy(tchdbopaque(thdb), tchdbopaque(hdb), HDBHEADSIZ - HDBOPAQUEOFF);
+  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
+  return false;
+}
+
+
+/* Process each record atomically of a hash database object.
+   `hdb' specifies the hash database object.
+   `beg' specifies the offset of the first record to be processed.
+   `end' specifies the offset where the processing stops.
+   `func' specifies the pointer to the iterator function called for each record.
+   `op' specifies an arbitrary pointer to be given as a parameter of the iterator function.
+   If successful, the return value is true, else, it is false. */
+static bool tchdbforeachimpl(TCHDB *hdb, uint64_t beg, uint64_t end, TCITER iter, void *op){
+  assert(hdb && iter);
   bool err = false;
-  uint64_t off = hdb->frec;
+  uint64_t off = beg;
+  HDBSCAN scan;
+  tchdbscaninit(&scan);
   TCHREC rec;
   char rbuf[HDBIOBUFSIZ];
-  while(off < hdb->fsiz){
+  bool cont = true;
+  while(cont && off < end){
     rec.off = off;
-    if(!tchdbreadrec(hdb, &rec, rbuf)){
+    if(!tchdbscanreadrec(hdb, &scan, &rec, rbuf)){
       err = true;
       break;
     }
     off += rec.rsiz;
     if(rec.magic == HDBMAGICREC){
-      if(!rec.vbuf && !tchdbreadrecbody(hdb, &rec)){
+      if(!tchdbreadrecvalue(hdb, &rec)){
         TCFREE(rec.bbuf);
         err = true;
       } else {
@@ -4569,308 +11031,728 @@ static bool tchdboptimizeimpl(TCHDB *hdb, int64_t bnum, int8_t apow, int8_t fpow
             zbuf = _tc_bzdecompress(rec.vbuf, rec.vsiz, &zsiz);
           } else if(hdb->opts & HDBTTCBS){
             zbuf = tcbsdecode(rec.vbuf, rec.vsiz, &zsiz);
+          } else if(hdb->opts & HDBTLZ){
+            zbuf = tclzdecode(rec.vbuf, rec.vsiz, &zsiz);
           } else {
             zbuf = hdb->dec(rec.vbuf, rec.vsiz, &zsiz, hdb->decop);
           }
           if(zbuf){
-            if(!tchdbput(thdb, rec.kbuf, rec.ksiz, zbuf, zsiz)){
-              tchdbsetecode(hdb, thdb->ecode, __FILE__, __LINE__, __func__);
-              err = true;
-            }
+            cont = iter(rec.kbuf, rec.ksiz, zbuf, zsiz, op);
             TCFREE(zbuf);
           } else {
             tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
             err = true;
           }
         } else {
-          if(!tchdbput(thdb, rec.kbuf, rec.ksiz, rec.vbuf, rec.vsiz)){
-            tchdbsetecode(hdb, thdb->ecode, __FILE__, __LINE__, __func__);
-            err = true;
-          }
+          cont = iter(rec.kbuf, rec.ksiz, rec.vbuf, rec.vsiz, op);
         }
       }
       TCFREE(rec.bbuf);
     }
   }
-  if(!tchdbclose(thdb)){
-    tchdbsetecode(hdb, thdb->ecode, __FILE__, __LINE__, __func__);
-    err = true;
-  }
-  bool esc = false;
-  if(err && (hdb->omode & HDBONOLCK) && !thdb->fatal){
-    err = false;
-    esc = true;
+  tchdbscanclear(&scan);
+  return !err;
+}
+
+
+/* Synchronize grouped commits which are not synchronized yet.
+   `hdb' specifies the hash database object.
+   If successful, the return value is true, else, it is false.
+   This function should be called while no transaction is running.  A checkpoint of the redo log
+   is also performed so that the frames in it are not applied over updates out of transactions. */
+static bool tchdbgcsync(TCHDB *hdb){
+  assert(hdb);
+  if(hdb->gcseq == hdb->gcsynced && hdb->rlsiz < 1) return true;
+  if(!HDBLOCKDB(hdb)) return false;
+  bool err = false;
+  if(hdb->gcseq != hdb->gcsynced){
+    if(!tchdbmemsync(hdb, true)) err = true;
+    if(!err && ftruncate(hdb->walfd, 0) == -1){
+      tchdbsetecode(hdb, TCETRUNC, __FILE__, __LINE__, __func__);
+      err = true;
+    }
+    if(!err) hdb->gcsynced = hdb->gcseq;
   }
-  tchdbdel(thdb);
-  if(err){
-    TCFREE(tpath);
+  if(!err && !tchdbrlckpt(hdb)) err = true;
+  HDBUNLOCKDB(hdb);
+  return !err;
+}
+
+
+/* Wait for a grouped commit to be synchronized.
+   `hdb' specifies the hash database object.
+   `seq' specifies the sequence number of the commit.
+   If successful, the return value is true, else, it is false.
+   The first waiter becomes the leader.  It lets other transactions join the group for the
+   waiting time, holds back new transactions until the running one is committed, and then
+   synchronizes the file on behalf of every member of the group. */
+static bool tchdbgcwaitimpl(TCHDB *hdb, uint64_t seq){
+  assert(hdb && seq > 0);
+  if(pthread_mutex_lock(hdb->gmtx) != 0){
+    tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
     return false;
   }
-  if(esc){
-    char *bpath = tcsprintf("%s%cbroken", tpath, MYEXTCHR);
-    if(rename(hdb->path, bpath) == -1){
-      tchdbsetecode(hdb, TCEUNLINK, __FILE__, __LINE__, __func__);
-      err = true;
+  bool err = false;
+  while(hdb->gcdone < seq){
+    if(hdb->gclead){
+      pthread_cond_wait(hdb->gcnd, hdb->gmtx);
+      continue;
     }
-    TCFREE(bpath);
-  } else {
-    if(unlink(hdb->path) == -1){
-      tchdbsetecode(hdb, TCEUNLINK, __FILE__, __LINE__, __func__);
-      err = true;
+    hdb->gclead = true;
+    pthread_mutex_unlock(hdb->gmtx);
+    tcsleep(hdb->gcwait);
+    uint64_t done = 0;
+    while(true){
+      if(!HDBLOCKMETHOD(hdb, true)){
+        err = true;
+        break;
+      }
+      if(!hdb->tran) break;
+      hdb->gcwant = true;
+      HDBUNLOCKMETHOD(hdb);
+      tcsleep(hdb->gcwait);
+    }
+    if(!err){
+      hdb->gcwant = false;
+      uint64_t target = hdb->gcseq;
+      if(tchdbgcsync(hdb)){
+        done = target;
+      } else {
+        err = true;
+      }
+      HDBUNLOCKMETHOD(hdb);
     }
+    pthread_mutex_lock(hdb->gmtx);
+    if(done > hdb->gcdone) hdb->gcdone = done;
+    hdb->gclead = false;
+    pthread_cond_broadcast(hdb->gcnd);
+    if(err) break;
   }
-  if(rename(tpath, hdb->path) == -1){
-    tchdbsetecode(hdb, TCERENAME, __FILE__, __LINE__, __func__);
+  pthread_mutex_unlock(hdb->gmtx);
+  return !err;
+}
+
+
+/* Perform auto defragmentation of a hash database object.
+   `hdb' specifies the hash database object.
+   If successful, the return value is true, else, it is false.
+   If the background defragmentation is working, the thread is only woken up. */
+static bool tchdbautodefrag(TCHDB *hdb){
+  assert(hdb);
+  HDBDFTH *dfth = hdb->dfth;
+  if(!dfth) return tchdbdefrag(hdb, hdb->dfunit * HDBDFRSRAT + 1);
+  if(__atomic_load_n(&dfth->kick, __ATOMIC_ACQUIRE)) return true;
+  if(pthread_mutex_lock(&dfth->mutex) != 0){
+    tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  __atomic_store_n(&dfth->kick, true, __ATOMIC_RELEASE);
+  pthread_cond_signal(&dfth->cond);
+  pthread_mutex_unlock(&dfth->mutex);
+  return true;
+}
+
+
+/* Start the background defragmentation thread of a hash database object.
+   `hdb' specifies the hash database object.
+   If successful, the return value is true, else, it is false. */
+static bool tchdbbgdefragstart(TCHDB *hdb){
+  assert(hdb && !hdb->dfth);
+  HDBDFTH *dfth;
+  TCMALLOC(dfth, sizeof(*dfth));
+  dfth->kick = false;
+  dfth->stop = false;
+  if(pthread_mutex_init(&dfth->mutex, NULL) != 0){
+    tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+    TCFREE(dfth);
+    return false;
+  }
+  if(pthread_cond_init(&dfth->cond, NULL) != 0){
+    tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+    pthread_mutex_destroy(&dfth->mutex);
+    TCFREE(dfth);
+    return false;
+  }
+  hdb->dfth = dfth;
+  if(pthread_create(&dfth->thid, NULL, tchdbbgdefragproc, hdb) != 0){
+    tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+    pthread_cond_destroy(&dfth->cond);
+    pthread_mutex_destroy(&dfth->mutex);
+    TCFREE(dfth);
+    hdb->dfth = NULL;
+    return false;
+  }
+  return true;
+}
+
+
+/* Stop the background defragmentation thread of a hash database object.
+   `hdb' specifies the hash database object.
+   If successful, the return value is true, else, it is false.
+   The method lock should not be held by the caller. */
+static bool tchdbbgdefragstop(TCHDB *hdb){
+  assert(hdb && hdb->dfth);
+  HDBDFTH *dfth = hdb->dfth;
+  bool err = false;
+  if(pthread_mutex_lock(&dfth->mutex) != 0){
+    tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  dfth->stop = true;
+  pthread_cond_signal(&dfth->cond);
+  pthread_mutex_unlock(&dfth->mutex);
+  void *rv;
+  if(pthread_join(dfth->thid, &rv) != 0){
+    tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
     err = true;
   }
-  TCFREE(tpath);
-  if(err) return false;
-  tpath = tcstrdup(hdb->path);
-  int omode = (hdb->omode & ~HDBOCREAT) & ~HDBOTRUNC;
-  if(!tchdbcloseimpl(hdb)){
-    TCFREE(tpath);
+  pthread_cond_destroy(&dfth->cond);
+  pthread_mutex_destroy(&dfth->mutex);
+  TCFREE(dfth);
+  hdb->dfth = NULL;
+  return !err;
+}
+
+
+/* Perform a step of background defragmentation of a hash database object.
+   `hdb' specifies the hash database object.
+   `bsp' specifies the pointer to the variable into which the size of the processed region is
+   assigned.
+   The return value is true if the current pass is not completed yet, else, it is false.
+   The step holds the shared method lock and the exclusive locks of all records, so readers are
+   stalled only while at most `HDBBGDFMAX' records are moved. */
+static bool tchdbbgdefragstep(TCHDB *hdb, uint64_t *bsp){
+  assert(hdb && bsp);
+  *bsp = 0;
+  if(!HDBLOCKMETHOD(hdb, false)) return false;
+  if(hdb->fd < 0 || !(hdb->omode & HDBOWRITER) || hdb->fatal || hdb->tran){
+    HDBUNLOCKMETHOD(hdb);
     return false;
   }
-  bool rv = tchdbopenimpl(hdb, tpath, omode);
-  TCFREE(tpath);
+  if(hdb->async && !tchdbflushdrp(hdb)){
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  if(!HDBLOCKALLRECORDS(hdb, true)){
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  if(hdb->dfcur == hdb->frec && hdb->dfcnt <= hdb->dfunit && hdb->vlgccur < 1 &&
+     hdb->xtcur < 1 && (!(hdb->flags & HDBFEXPIRE) || time(NULL) < hdb->xtnext)){
+    HDBUNLOCKALLRECORDS(hdb);
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  uint64_t cur = hdb->dfcur;
+  uint64_t fsiz = hdb->fsiz;
+  if(!tchdbdefragimpl(hdb, tclmin(hdb->dfunit * HDBDFRSRAT + 1, HDBBGDFMAX))){
+    HDBUNLOCKALLRECORDS(hdb);
+    HDBUNLOCKMETHOD(hdb);
+    return false;
+  }
+  bool rv = hdb->dfcur > cur || hdb->vlgccur > 0 || hdb->xtcur > 0;
+  uint64_t bsiz = (hdb->dfcur > cur) ? hdb->dfcur - cur : (fsiz > cur ? fsiz - cur : 0);
+  HDBUNLOCKALLRECORDS(hdb);
+  __sync_fetch_and_add(&hdb->dfsnum, 1);
+  __sync_fetch_and_add(&hdb->dfbsiz, bsiz);
+  if(!rv) __sync_fetch_and_add(&hdb->dfpnum, 1);
+  HDBUNLOCKMETHOD(hdb);
+  *bsp = bsiz;
   return rv;
 }
 
 
-/* Remove all records of a hash database object.
+/* Process the background defragmentation of a hash database object.
+   `arg' specifies the hash database object.
+   The return value is always `NULL'. */
+static void *tchdbbgdefragproc(void *arg){
+  TCHDB *hdb = arg;
+  HDBDFTH *dfth = hdb->dfth;
+  bool busy = false;
+  double wsec = 0.0;
+  pthread_mutex_lock(&dfth->mutex);
+  while(!dfth->stop){
+    double end = tctime() + (wsec > 0.0 ? wsec : HDBBGDFIDLE);
+    while(!dfth->stop && (wsec > 0.0 || (!busy && !dfth->kick))){
+      if(tctime() >= end) break;
+      struct timespec ts;
+      ts.tv_sec = (time_t)end;
+      ts.tv_nsec = (long)((end - ts.tv_sec) * 1000000000.0);
+      pthread_cond_timedwait(&dfth->cond, &dfth->mutex, &ts);
+    }
+    if(dfth->stop) break;
+    __atomic_store_n(&dfth->kick, false, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&dfth->mutex);
+    uint64_t bsiz;
+    busy = tchdbbgdefragstep(hdb, &bsiz);
+    wsec = bsiz / (double)hdb->dfbps;
+    pthread_mutex_lock(&dfth->mutex);
+  }
+  pthread_mutex_unlock(&dfth->mutex);
+  return NULL;
+}
+
+
+/* Start the asynchronous writer thread of a hash database object.
+   `hdb' specifies the hash database object.
+   If successful, the return value is true, else, it is false. */
+static bool tchdbawstart(TCHDB *hdb){
+  assert(hdb && !hdb->awth);
+  HDBAWTH *awth;
+  TCMALLOC(awth, sizeof(*awth));
+  uint64_t qnum = 1;
+  while(qnum < hdb->awqnum) qnum <<= 1;
+  TCMALLOC(awth->slots, qnum * sizeof(*awth->slots));
+  for(uint64_t i = 0; i < qnum; i++){
+    awth->slots[i].seq = i;
+    awth->slots[i].rbuf = NULL;
+    awth->slots[i].rsiz = 0;
+  }
+  awth->mask = qnum - 1;
+  awth->head = 0;
+  awth->tail = 0;
+  awth->dnum = 0;
+  awth->idle = false;
+  awth->wnum = 0;
+  awth->stop = false;
+  awth->ecode = TCESUCCESS;
+  if(pthread_mutex_init(&awth->mutex, NULL) != 0){
+    tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+    TCFREE(awth->slots);
+    TCFREE(awth);
+    return false;
+  }
+  if(pthread_cond_init(&awth->cond, NULL) != 0){
+    tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+    pthread_mutex_destroy(&awth->mutex);
+    TCFREE(awth->slots);
+    TCFREE(awth);
+    return false;
+  }
+  if(pthread_cond_init(&awth->dcnd, NULL) != 0){
+    tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+    pthread_cond_destroy(&awth->cond);
+    pthread_mutex_destroy(&awth->mutex);
+    TCFREE(awth->slots);
+    TCFREE(awth);
+    return false;
+  }
+  hdb->awth = awth;
+  if(pthread_create(&awth->thid, NULL, tchdbawproc, hdb) != 0){
+    tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+    pthread_cond_destroy(&awth->dcnd);
+    pthread_cond_destroy(&awth->cond);
+    pthread_mutex_destroy(&awth->mutex);
+    TCFREE(awth->slots);
+    TCFREE(awth);
+    hdb->awth = NULL;
+    return false;
+  }
+  return true;
+}
+
+
+/* Stop the asynchronous writer thread of a hash database object.
+   `hdb' specifies the hash database object.
+   If successful, the return value is true, else, it is false.
+   The queued records are stored before the thread finishes.  The method lock should not be held
+   by the caller. */
+static bool tchdbawstop(TCHDB *hdb){
+  assert(hdb && hdb->awth);
+  HDBAWTH *awth = hdb->awth;
+  bool err = false;
+  if(pthread_mutex_lock(&awth->mutex) != 0){
+    tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  awth->stop = true;
+  pthread_cond_signal(&awth->cond);
+  pthread_mutex_unlock(&awth->mutex);
+  void *rv;
+  if(pthread_join(awth->thid, &rv) != 0){
+    tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  if(awth->ecode != TCESUCCESS){
+    tchdbsetecode(hdb, awth->ecode, __FILE__, __LINE__, __func__);
+    err = true;
+  }
+  for(uint64_t i = 0; i <= awth->mask; i++){
+    TCFREE(awth->slots[i].rbuf);
+  }
+  pthread_cond_destroy(&awth->dcnd);
+  pthread_cond_destroy(&awth->cond);
+  pthread_mutex_destroy(&awth->mutex);
+  TCFREE(awth->slots);
+  TCFREE(awth);
+  hdb->awth = NULL;
+  return !err;
+}
+
+
+/* Put a record into the queue of the asynchronous writer of a hash database object.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `vbuf' specifies the pointer to the region of the value.
+   `vsiz' specifies the size of the region of the value.
+   If successful, the return value is true, else, it is false.
+   The value is compressed by the caller and the slot of the queue is claimed without locking.
+   If the queue is full, the caller waits until the writer stores some records. */
+static bool tchdbawpush(TCHDB *hdb, const char *kbuf, int ksiz, const char *vbuf, int vsiz){
+  assert(hdb && kbuf && ksiz >= 0 && vbuf && vsiz >= 0);
+  HDBAWTH *awth = hdb->awth;
+  if(awth->ecode != TCESUCCESS){
+    tchdbsetecode(hdb, awth->ecode, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  char *zbuf = NULL;
+  if(hdb->zmode){
+    if(hdb->opts & HDBTDEFLATE){
+      zbuf = _tc_deflate(vbuf, vsiz, &vsiz, _TCZMRAW);
+    } else if(hdb->opts & HDBTBZIP){
+      zbuf = _tc_bzcompress(vbuf, vsiz, &vsiz);
+    } else if(hdb->opts & HDBTTCBS){
+      zbuf = tcbsencode(vbuf, vsiz, &vsiz);
+    } else if(hdb->opts & HDBTLZ){
+      zbuf = tclzencode(vbuf, vsiz, &vsiz);
+    } else {
+      zbuf = hdb->enc(vbuf, vsiz, &vsiz, hdb->encop);
+    }
+    if(!zbuf){
+      tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+      return false;
+    }
+    vbuf = zbuf;
+  }
+  uint64_t pos = __atomic_load_n(&awth->tail, __ATOMIC_RELAXED);
+  HDBAWSLOT *slot;
+  while(true){
+    slot = awth->slots + (pos & awth->mask);
+    uint64_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    int64_t dif = (int64_t)(seq - pos);
+    if(dif == 0){
+      if(__atomic_compare_exchange_n(&awth->tail, &pos, pos + 1, true,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+    } else if(dif < 0){
+      if(pthread_mutex_lock(&awth->mutex) != 0){
+        tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+        TCFREE(zbuf);
+        return false;
+      }
+      awth->wnum++;
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      if((int64_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos) < 0){
+        pthread_cond_signal(&awth->cond);
+        double end = tctime() + HDBAWWAIT;
+        struct timespec ts;
+        ts.tv_sec = (time_t)end;
+        ts.tv_nsec = (long)((end - ts.tv_sec) * 1000000000.0);
+        pthread_cond_timedwait(&awth->dcnd, &awth->mutex, &ts);
+      }
+      awth->wnum--;
+      pthread_mutex_unlock(&awth->mutex);
+      pos = __atomic_load_n(&awth->tail, __ATOMIC_RELAXED);
+    } else {
+      pos = __atomic_load_n(&awth->tail, __ATOMIC_RELAXED);
+    }
+  }
+  if(ksiz + vsiz > slot->rsiz){
+    slot->rsiz = ksiz + vsiz;
+    TCREALLOC(slot->rbuf, slot->rbuf, slot->rsiz);
+  }
+  memcpy(slot->rbuf, kbuf, ksiz);
+  memcpy(slot->rbuf + ksiz, vbuf, vsiz);
+  slot->ksiz = ksiz;
+  slot->vsiz = vsiz;
+  TCFREE(zbuf);
+  __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if(awth->idle){
+    if(pthread_mutex_lock(&awth->mutex) != 0){
+      tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+      return false;
+    }
+    pthread_cond_signal(&awth->cond);
+    pthread_mutex_unlock(&awth->mutex);
+  }
+  return true;
+}
+
+
+/* Wait for the asynchronous writer of a hash database object to store the queued records.
+   `hdb' specifies the hash database object.
+   If successful, the return value is true, else, it is false.
+   Only the records queued before the call are waited for.  The method lock should not be held
+   by the caller. */
+static bool tchdbawbarrier(TCHDB *hdb){
+  assert(hdb && hdb->awth);
+  HDBAWTH *awth = hdb->awth;
+  uint64_t target = __atomic_load_n(&awth->tail, __ATOMIC_ACQUIRE);
+  if(__atomic_load_n(&awth->dnum, __ATOMIC_ACQUIRE) < target){
+    if(pthread_mutex_lock(&awth->mutex) != 0){
+      tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
+      return false;
+    }
+    awth->wnum++;
+    while(__atomic_load_n(&awth->dnum, __ATOMIC_ACQUIRE) < target){
+      pthread_cond_signal(&awth->cond);
+      double end = tctime() + HDBAWWAIT;
+      struct timespec ts;
+      ts.tv_sec = (time_t)end;
+      ts.tv_nsec = (long)((end - ts.tv_sec) * 1000000000.0);
+      pthread_cond_timedwait(&awth->dcnd, &awth->mutex, &ts);
+    }
+    awth->wnum--;
+    pthread_mutex_unlock(&awth->mutex);
+  }
+  if(awth->ecode != TCESUCCESS){
+    tchdbsetecode(hdb, awth->ecode, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  return true;
+}
+
+
+/* Store records in the queue of the asynchronous writer of a hash database object.
+   `hdb' specifies the hash database object.
+   `max' specifies the maximum number of records to be stored.
+   The return value is the number of records taken out of the queue.
+   Each slot is released after its record is stored, so that the buffer of the slot is reused
+   by the next producer.
+   If the queue becomes empty, the delayed record pool is flushed before the method lock is
+   released so that the other methods do not have to.  Buckets of linear hashing are split after
+   the lock is released, as they are after each call of `tchdbput'. */
+static int tchdbawdrain(TCHDB *hdb, int max){
+  assert(hdb && hdb->awth && max > 0);
+  HDBAWTH *awth = hdb->awth;
+  if(!HDBLOCKMETHOD(hdb, true)) return 0;
+  bool err = awth->ecode != TCESUCCESS;
+  hdb->async = true;
+  int num = 0;
+  while(num < max){
+    uint64_t pos = awth->head;
+    HDBAWSLOT *slot = awth->slots + (pos & awth->mask);
+    if(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1) break;
+    if(!err){
+      uint8_t hash;
+      uint64_t bidx = tchdbbidx(hdb, slot->rbuf, slot->ksiz, &hash);
+      if(!tchdbputasyncimpl(hdb, slot->rbuf, slot->ksiz, bidx, hash,
+                            slot->rbuf + slot->ksiz, slot->vsiz)) err = true;
+    }
+    if(slot->rsiz > HDBAWBUFMAX){
+      TCFREE(slot->rbuf);
+      slot->rbuf = NULL;
+      slot->rsiz = 0;
+    }
+    awth->head = pos + 1;
+    __atomic_store_n(&slot->seq, pos + awth->mask + 1, __ATOMIC_RELEASE);
+    num++;
+  }
+  if(num > 0 && !err && __atomic_load_n(&awth->slots[awth->head&awth->mask].seq,
+                                         __ATOMIC_ACQUIRE) != awth->head + 1 &&
+     !tchdbflushdrp(hdb)) err = true;
+  if(err && awth->ecode == TCESUCCESS){
+    int ecode = tchdbecode(hdb);
+    awth->ecode = (ecode != TCESUCCESS) ? ecode : TCEMISC;
+  }
+  __atomic_store_n(&awth->dnum, awth->head, __ATOMIC_RELEASE);
+  HDBUNLOCKMETHOD(hdb);
+  while(num > 0 && !err && HDBLHSPLITNEEDED(hdb)){
+    if(!tchdblhgrow(hdb)){
+      if(awth->ecode == TCESUCCESS){
+        int ecode = tchdbecode(hdb);
+        awth->ecode = (ecode != TCESUCCESS) ? ecode : TCEMISC;
+      }
+      break;
+    }
+  }
+  return num;
+}
+
+
+/* Process the asynchronous writer of a hash database object.
+   `arg' specifies the hash database object.
+   The return value is always `NULL'. */
+static void *tchdbawproc(void *arg){
+  TCHDB *hdb = arg;
+  HDBAWTH *awth = hdb->awth;
+  while(true){
+    int num = tchdbawdrain(hdb, HDBAWBATCH);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if(awth->wnum > 0){
+      pthread_mutex_lock(&awth->mutex);
+      pthread_cond_broadcast(&awth->dcnd);
+      pthread_mutex_unlock(&awth->mutex);
+    }
+    if(num > 0) continue;
+    pthread_mutex_lock(&awth->mutex);
+    if(awth->stop && awth->head == __atomic_load_n(&awth->tail, __ATOMIC_ACQUIRE)){
+      pthread_mutex_unlock(&awth->mutex);
+      break;
+    }
+    awth->idle = true;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    HDBAWSLOT *slot = awth->slots + (awth->head & awth->mask);
+    if(!awth->stop && __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != awth->head + 1){
+      double end = tctime() + HDBAWIDLE;
+      struct timespec ts;
+      ts.tv_sec = (time_t)end;
+      ts.tv_nsec = (long)((end - ts.tv_sec) * 1000000000.0);
+      pthread_cond_timedwait(&awth->cond, &awth->mutex, &ts);
+    }
+    awth->idle = false;
+    pthread_mutex_unlock(&awth->mutex);
+  }
+  return NULL;
+}
+
+
+/* Grow the bucket array of linear hashing by splitting buckets.
    `hdb' specifies the hash database object.
    If successful, the return value is true, else, it is false. */
-static bool tchdbvanishimpl(TCHDB *hdb){
+static bool tchdblhgrow(TCHDB *hdb){
   assert(hdb);
-  char *path = tcstrdup(hdb->path);
-  int omode = hdb->omode;
-  bool err = false;
-  if(!tchdbcloseimpl(hdb)) err = true;
-  if(!tchdbopenimpl(hdb, path, HDBOTRUNC | omode)){
-    tcpathunlock(hdb->rpath);
-    TCFREE(hdb->rpath);
-    err = true;
+  if(!HDBLOCKMETHOD(hdb, true)) return false;
+  if(hdb->fd < 0 || !(hdb->omode & HDBOWRITER)){
+    tchdbsetecode(hdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    HDBUNLOCKMETHOD(hdb);
+    return false;
   }
-  TCFREE(path);
-  return !err;
-}
-
-
-/* Copy the database file of a hash database object.
-   `hdb' specifies the hash database object.
-   `path' specifies the path of the destination file.
-   If successful, the return value is true, else, it is false. */
-static bool tchdbcopyimpl(TCHDB *hdb, const char *path){
-  assert(hdb && path);
-  bool err = false;
-  if(hdb->omode & HDBOWRITER){
-    if(!tchdbsavefbp(hdb)) err = true;
-    if(!tchdbmemsync(hdb, false)) err = true;
-    tchdbsetflag(hdb, HDBFOPEN, false);
+  if(hdb->async && !tchdbflushdrp(hdb)){
+    HDBUNLOCKMETHOD(hdb);
+    return false;
   }
-  if(*path == '@'){
-    char tsbuf[TCNUMBUFSIZ];
-    sprintf(tsbuf, "%llu", (unsigned long long)(tctime() * 1000000));
-    const char *args[3];
-    args[0] = path + 1;
-    args[1] = hdb->path;
-    args[2] = tsbuf;
-    if(tcsystem(args, sizeof(args) / sizeof(*args)) != 0) err = true;
-  } else {
-    if(!tccopyfile(hdb->path, path)){
-      tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+  bool err = false;
+  for(int i = 0; i < HDBLHSPLUNIT && HDBLHSPLITNEEDED(hdb); i++){
+    if(!tchdblhsplitimpl(hdb)){
       err = true;
+      break;
     }
   }
-  if(hdb->omode & HDBOWRITER) tchdbsetflag(hdb, HDBFOPEN, true);
+  HDBUNLOCKMETHOD(hdb);
   return !err;
 }
 
 
-/* Perform dynamic defragmentation of a hash database object.
-   `hdb' specifies the hash database object connected.
-   `step' specifie the number of steps.
-   If successful, the return value is true, else, it is false. */
-static bool tchdbdefragimpl(TCHDB *hdb, int64_t step){
-  assert(hdb && step >= 0);
-  TCDODEBUG(hdb->cnt_defrag++);
-  hdb->dfcnt = 0;
+/* Split the bucket at the split pointer of linear hashing.
+   `hdb' specifies the hash database object.
+   If successful, the return value is true, else, it is false.
+   The records of the bucket are divided between the bucket and the new one appended at the end
+   of the active region of the bucket array. */
+static bool tchdblhsplitimpl(TCHDB *hdb){
+  assert(hdb);
+  uint64_t sidx = hdb->lhnum - hdb->lhmod;
+  int oanum = HDBLHSPLUNIT;
+  uint64_t *offs;
+  TCMALLOC(offs, sizeof(*offs) * oanum);
+  int onum = 0;
+  off_t off = tchdbgetbucket(hdb, sidx);
+  if(off > 0) offs[onum++] = off;
   TCHREC rec;
   char rbuf[HDBIOBUFSIZ];
-  while(true){
-    if(hdb->dfcur >= hdb->fsiz){
-      hdb->dfcur = hdb->frec;
-      return true;
+  for(int i = 0; i < onum; i++){
+    rec.off = offs[i];
+    if(!tchdbreadrec(hdb, &rec, rbuf)){
+      TCFREE(offs);
+      return false;
     }
-    if(step-- < 1) return true;
-    rec.off = hdb->dfcur;
-    if(!tchdbreadrec(hdb, &rec, rbuf)) return false;
-    if(rec.magic == HDBMAGICFB) break;
-    hdb->dfcur += rec.rsiz;
-  }
-  uint32_t align = hdb->align;
-  uint64_t base = hdb->dfcur;
-  uint64_t dest = base;
-  uint64_t cur = base;
-  if(hdb->iter == cur) hdb->iter += rec.rsiz;
-  cur += rec.rsiz;
-  uint64_t fbsiz = cur - dest;
-  step++;
-  while(step > 0 && cur < hdb->fsiz){
-    rec.off = cur;
-    if(!tchdbreadrec(hdb, &rec, rbuf)) return false;
-    uint32_t rsiz = rec.rsiz;
-    if(rec.magic == HDBMAGICREC){
-      if(rec.psiz >= align){
-        int diff = rec.psiz - rec.psiz % align;
-        rec.psiz -= diff;
-        rec.rsiz -= diff;
-        fbsiz += diff;
-      }
-      if(!tchdbshiftrec(hdb, &rec, rbuf, dest)) return false;
-      if(hdb->iter == cur) hdb->iter = dest;
-      dest += rec.rsiz;
-      step--;
-    } else {
-      if(hdb->iter == cur) hdb->iter += rec.rsiz;
-      fbsiz += rec.rsiz;
+    if(onum + 2 > oanum){
+      oanum *= 2;
+      TCREALLOC(offs, offs, sizeof(*offs) * oanum);
     }
-    cur += rsiz;
-  }
-  if(cur < hdb->fsiz){
-    if(fbsiz > HDBFBMAXSIZ){
-      tchdbfbptrim(hdb, base, cur, 0, 0);
-      uint64_t off = dest;
-      uint64_t size = fbsiz;
-      while(size > 0){
-        uint32_t rsiz = (size > HDBFBMAXSIZ) ? HDBFBMAXSIZ : size;
-        if(size - rsiz < HDBMINRUNIT) rsiz = size;
-        tchdbfbpinsert(hdb, off, rsiz);
-        if(!tchdbwritefb(hdb, off, rsiz)) return false;
-        off += rsiz;
-        size -= rsiz;
-      }
-    } else {
-      tchdbfbptrim(hdb, base, cur, dest, fbsiz);
-      if(!tchdbwritefb(hdb, dest, fbsiz)) return false;
+    if(rec.left > 0) offs[onum++] = rec.left;
+    if(rec.right > 0) offs[onum++] = rec.right;
+  }
+  tchdbsetbucket(hdb, sidx, 0);
+  tchdbfpclear(hdb, sidx);
+  hdb->lhnum++;
+  if(hdb->lhnum >= hdb->lhmod * 2) hdb->lhmod *= 2;
+  uint64_t llnum = hdb->lhnum;
+  llnum = TCHTOILL(llnum);
+  memcpy(hdb->map + HDBLHNUMOFF, &llnum, sizeof(llnum));
+  char zbuf[sizeof(uint64_t)*2];
+  memset(zbuf, 0, sizeof(zbuf));
+  int csiz = hdb->ba64 ? sizeof(uint64_t) * 2 : sizeof(uint32_t) * 2;
+  bool err = false;
+  for(int i = 0; !err && i < onum; i++){
+    rec.off = offs[i];
+    if(!tchdbreadrec(hdb, &rec, rbuf)){
+      err = true;
+      break;
     }
-    hdb->dfcur = cur - fbsiz;
-  } else {
-    TCDODEBUG(hdb->cnt_trunc++);
-    if(hdb->tran && !tchdbwalwrite(hdb, dest, fbsiz)) return false;
-    tchdbfbptrim(hdb, base, cur, 0, 0);
-    hdb->dfcur = hdb->frec;
-    hdb->fsiz = dest;
-    uint64_t llnum = hdb->fsiz;
-    llnum = TCHTOILL(llnum);
-    memcpy(hdb->map + HDBFSIZOFF, &llnum, sizeof(llnum));
-    if(hdb->iter >= hdb->fsiz) hdb->iter = UINT64_MAX;
-    if(!hdb->tran){
-      if(ftruncate(hdb->fd, hdb->fsiz) == -1){
-        tchdbsetecode(hdb, TCETRUNC, __FILE__, __LINE__, __func__);
-        return false;
-      }
-      hdb->xfsiz = 0;
+    if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)){
+      TCFREE(rec.bbuf);
+      err = true;
+      break;
     }
+    uint8_t hash;
+    uint64_t bidx = tchdbbidx(hdb, rec.kbuf, rec.ksiz, &hash);
+    if(!tchdbseekwrite(hdb, rec.off + sizeof(uint8_t) * 2, zbuf, csiz) ||
+       !tchdblhlinkrec(hdb, &rec, bidx)) err = true;
+    TCFREE(rec.bbuf);
   }
-  return true;
+  TCFREE(offs);
+  return !err;
 }
 
 
-/* Move the iterator to the record corresponding a key of a hash database object.
+/* Link a record into the collision tree of a bucket.
    `hdb' specifies the hash database object.
-   `kbuf' specifies the pointer to the region of the key.
-   `ksiz' specifies the size of the region of the key.
+   `rec' specifies the record object whose key is read and whose children are cleared.
+   `bidx' specifies the index of the bucket.
    If successful, the return value is true, else, it is false. */
-static bool tchdbiterjumpimpl(TCHDB *hdb, const char *kbuf, int ksiz){
-  assert(hdb && kbuf && ksiz);
-  uint8_t hash;
-  uint64_t bidx = tchdbbidx(hdb, kbuf, ksiz, &hash);
+static bool tchdblhlinkrec(TCHDB *hdb, TCHREC *rec, uint64_t bidx){
+  assert(hdb && rec && rec->kbuf);
   off_t off = tchdbgetbucket(hdb, bidx);
-  TCHREC rec;
-  char rbuf[HDBIOBUFSIZ];
+  off_t entoff = 0;
+  TCHREC trec;
+  char tbuf[HDBIOBUFSIZ];
   while(off > 0){
-    rec.off = off;
-    if(!tchdbreadrec(hdb, &rec, rbuf)) return false;
-    if(hash > rec.hash){
-      off = rec.left;
-    } else if(hash < rec.hash){
-      off = rec.right;
+    trec.off = off;
+    if(!tchdbreadrec(hdb, &trec, tbuf)) return false;
+    if(rec->hash > trec.hash){
+      off = trec.left;
+      entoff = trec.off + (sizeof(uint8_t) + sizeof(uint8_t));
+    } else if(rec->hash < trec.hash){
+      off = trec.right;
+      entoff = trec.off + (sizeof(uint8_t) + sizeof(uint8_t)) +
+        (hdb->ba64 ? sizeof(uint64_t) : sizeof(uint32_t));
     } else {
-      if(!rec.kbuf && !tchdbreadrecbody(hdb, &rec)) return false;
-      int kcmp = tcreckeycmp(kbuf, ksiz, rec.kbuf, rec.ksiz);
+      if(!trec.kbuf && !tchdbreadrecbody(hdb, &trec)){
+        TCFREE(trec.bbuf);
+        return false;
+      }
+      int kcmp = tcreckeycmp(rec->kbuf, rec->ksiz, trec.kbuf, trec.ksiz);
+      TCFREE(trec.bbuf);
       if(kcmp > 0){
-        off = rec.left;
-        TCFREE(rec.bbuf);
-        rec.kbuf = NULL;
-        rec.bbuf = NULL;
+        off = trec.left;
+        entoff = trec.off + (sizeof(uint8_t) + sizeof(uint8_t));
       } else if(kcmp < 0){
-        off = rec.right;
-        TCFREE(rec.bbuf);
-        rec.kbuf = NULL;
-        rec.bbuf = NULL;
+        off = trec.right;
+        entoff = trec.off + (sizeof(uint8_t) + sizeof(uint8_t)) +
+          (hdb->ba64 ? sizeof(uint64_t) : sizeof(uint32_t));
       } else {
-        hdb->iter = off;
-        return true;
+        tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
+        return false;
       }
     }
   }
-  tchdbsetecode(hdb, TCENOREC, __FILE__, __LINE__, __func__);
-  return false;
-}
-
-
-/* Process each record atomically of a hash database object.
-   `hdb' specifies the hash database object.
-   `func' specifies the pointer to the iterator function called for each record.
-   `op' specifies an arbitrary pointer to be given as a parameter of the iterator function.
-   If successful, the return value is true, else, it is false. */
-static bool tchdbforeachimpl(TCHDB *hdb, TCITER iter, void *op){
-  assert(hdb && iter);
-  bool err = false;
-  uint64_t off = hdb->frec;
-  TCHREC rec;
-  char rbuf[HDBIOBUFSIZ];
-  bool cont = true;
-  while(cont && off < hdb->fsiz){
-    rec.off = off;
-    if(!tchdbreadrec(hdb, &rec, rbuf)){
-      err = true;
-      break;
-    }
-    off += rec.rsiz;
-    if(rec.magic == HDBMAGICREC){
-      if(!rec.vbuf && !tchdbreadrecbody(hdb, &rec)){
-        TCFREE(rec.bbuf);
-        err = true;
-      } else {
-        if(hdb->zmode){
-          int zsiz;
-          char *zbuf;
-          if(hdb->opts & HDBTDEFLATE){
-            zbuf = _tc_inflate(rec.vbuf, rec.vsiz, &zsiz, _TCZMRAW);
-          } else if(hdb->opts & HDBTBZIP){
-            zbuf = _tc_bzdecompress(rec.vbuf, rec.vsiz, &zsiz);
-          } else if(hdb->opts & HDBTTCBS){
-            zbuf = tcbsdecode(rec.vbuf, rec.vsiz, &zsiz);
-          } else {
-            zbuf = hdb->dec(rec.vbuf, rec.vsiz, &zsiz, hdb->decop);
-          }
-          if(zbuf){
-            cont = iter(rec.kbuf, rec.ksiz, zbuf, zsiz, op);
-            TCFREE(zbuf);
-          } else {
-            tchdbsetecode(hdb, TCEMISC, __FILE__, __LINE__, __func__);
-            err = true;
-          }
-        } else {
-          cont = iter(rec.kbuf, rec.ksiz, rec.vbuf, rec.vsiz, op);
-        }
-      }
-      TCFREE(rec.bbuf);
+  if(entoff > 0){
+    if(hdb->ba64){
+      uint64_t llnum = rec->off >> hdb->apow;
+      llnum = TCHTOILL(llnum);
+      if(!tchdbseekwrite(hdb, entoff, &llnum, sizeof(uint64_t))) return false;
+    } else {
+      uint32_t lnum = rec->off >> hdb->apow;
+      lnum = TCHTOIL(lnum);
+      if(!tchdbseekwrite(hdb, entoff, &lnum, sizeof(uint32_t))) return false;
     }
+  } else {
+    tchdbsetbucket(hdb, bidx, rec->off);
   }
-  return !err;
+  tchdbfpadd(hdb, bidx, rec->kbuf, rec->ksiz);
+  return true;
 }
 
 
@@ -4908,13 +11790,15 @@ static bool tchdbunlockmethod(TCHDB *hdb){
    `bidx' specifies the bucket index of the record.
    `wr' specifies whether the lock is writer or not.
    If successful, the return value is true, else, it is false. */
-static bool tchdblockrecord(TCHDB *hdb, uint8_t bidx, bool wr){
+static bool tchdblockrecord(TCHDB *hdb, uint64_t bidx, bool wr){
   assert(hdb);
-  if(wr ? pthread_rwlock_wrlock((pthread_rwlock_t *)hdb->rmtxs + bidx) != 0 :
-     pthread_rwlock_rdlock((pthread_rwlock_t *)hdb->rmtxs + bidx) != 0){
+  HDBRLOCK *rlock = HDBRLOCKPTR(hdb, bidx);
+  if(wr ? pthread_rwlock_wrlock(&rlock->rwlock) != 0 :
+     pthread_rwlock_rdlock(&rlock->rwlock) != 0){
     tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
     return false;
   }
+  if(wr) __sync_fetch_and_add(&rlock->seq, 1);
   TCTESTYIELD();
   return true;
 }
@@ -4924,9 +11808,11 @@ static bool tchdblockrecord(TCHDB *hdb, uint8_t bidx, bool wr){
    `hdb' specifies the hash database object.
    `bidx' specifies the bucket index of the record.
    If successful, the return value is true, else, it is false. */
-static bool tchdbunlockrecord(TCHDB *hdb, uint8_t bidx){
+static bool tchdbunlockrecord(TCHDB *hdb, uint64_t bidx){
   assert(hdb);
-  if(pthread_rwlock_unlock((pthread_rwlock_t *)hdb->rmtxs + bidx) != 0){
+  HDBRLOCK *rlock = HDBRLOCKPTR(hdb, bidx);
+  if(rlock->seq & 1) __sync_fetch_and_add(&rlock->seq, 1);
+  if(pthread_rwlock_unlock(&rlock->rwlock) != 0){
     tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
     return false;
   }
@@ -4941,15 +11827,19 @@ static bool tchdbunlockrecord(TCHDB *hdb, uint8_t bidx){
    If successful, the return value is true, else, it is false. */
 static bool tchdblockallrecords(TCHDB *hdb, bool wr){
   assert(hdb);
-  for(int i = 0; i <= UINT8_MAX; i++){
-    if(wr ? pthread_rwlock_wrlock((pthread_rwlock_t *)hdb->rmtxs + i) != 0 :
-       pthread_rwlock_rdlock((pthread_rwlock_t *)hdb->rmtxs + i) != 0){
+  for(int i = 0; i < hdb->rmtxnum; i++){
+    HDBRLOCK *rlock = HDBRLOCKPTR(hdb, i);
+    if(wr ? pthread_rwlock_wrlock(&rlock->rwlock) != 0 :
+       pthread_rwlock_rdlock(&rlock->rwlock) != 0){
       tchdbsetecode(hdb, TCETHREAD, __FILE__, __LINE__, __func__);
       while(--i >= 0){
-        pthread_rwlock_unlock((pthread_rwlock_t *)hdb->rmtxs + i);
+        rlock = HDBRLOCKPTR(hdb, i);
+        if(rlock->seq & 1) __sync_fetch_and_add(&rlock->seq, 1);
+        pthread_rwlock_unlock(&rlock->rwlock);
       }
       return false;
     }
+    if(wr) __sync_fetch_and_add(&rlock->seq, 1);
   }
   TCTESTYIELD();
   return true;
@@ -4962,8 +11852,10 @@ static bool tchdblockallrecords(TCHDB *hdb, bool wr){
 static bool tchdbunlockallrecords(TCHDB *hdb){
   assert(hdb);
   bool err = false;
-  for(int i = UINT8_MAX; i >= 0; i--){
-    if(pthread_rwlock_unlock((pthread_rwlock_t *)hdb->rmtxs + i)) err = true;
+  for(int i = hdb->rmtxnum - 1; i >= 0; i--){
+    HDBRLOCK *rlock = HDBRLOCKPTR(hdb, i);
+    if(rlock->seq & 1) __sync_fetch_and_add(&rlock->seq, 1);
+    if(pthread_rwlock_unlock(&rlock->rwlock)) err = true;
   }
   TCTESTYIELD();
   if(err){
@@ -5047,6 +11939,7 @@ void tchdbprintmeta(TCHDB *hdb){
   wp += sprintf(wp, "META:");
   wp += sprintf(wp, " mmtx=%p", (void *)hdb->mmtx);
   wp += sprintf(wp, " rmtxs=%p", (void *)hdb->rmtxs);
+  wp += sprintf(wp, " rmtxnum=%d", hdb->rmtxnum);
   wp += sprintf(wp, " dmtx=%p", (void *)hdb->dmtx);
   wp += sprintf(wp, " wmtx=%p", (void *)hdb->wmtx);
   wp += sprintf(wp, " eckey=%p", (void *)hdb->eckey);
@@ -5054,6 +11947,9 @@ void tchdbprintmeta(TCHDB *hdb){
   wp += sprintf(wp, " type=%02X", hdb->type);
   wp += sprintf(wp, " flags=%02X", hdb->flags);
   wp += sprintf(wp, " bnum=%llu", (unsigned long long)hdb->bnum);
+  wp += sprintf(wp, " lhbase=%llu", (unsigned long long)hdb->lhbase);
+  wp += sprintf(wp, " lhnum=%llu", (unsigned long long)hdb->lhnum);
+  wp += sprintf(wp, " lhmod=%llu", (unsigned long long)hdb->lhmod);
   wp += sprintf(wp, " apow=%u", hdb->apow);
   wp += sprintf(wp, " fpow=%u", hdb->fpow);
   wp += sprintf(wp, " opts=%u", hdb->opts);
@@ -5065,8 +11961,10 @@ void tchdbprintmeta(TCHDB *hdb){
   wp += sprintf(wp, " frec=%llu", (unsigned long long)hdb->frec);
   wp += sprintf(wp, " dfcur=%llu", (unsigned long long)hdb->dfcur);
   wp += sprintf(wp, " iter=%llu", (unsigned long long)hdb->iter);
+  wp += sprintf(wp, " apsync=%llu", (unsigned long long)hdb->apsync);
   wp += sprintf(wp, " map=%p", (void *)hdb->map);
   wp += sprintf(wp, " msiz=%llu", (unsigned long long)hdb->msiz);
+  wp += sprintf(wp, " mopts=%u", hdb->mopts);
   wp += sprintf(wp, " ba32=%p", (void *)hdb->ba32);
   wp += sprintf(wp, " ba64=%p", (void *)hdb->ba64);
   wp += sprintf(wp, " align=%u", hdb->align);
@@ -5081,6 +11979,7 @@ void tchdbprintmeta(TCHDB *hdb){
   wp += sprintf(wp, " drpoff=%llu", (unsigned long long)hdb->drpoff);
   wp += sprintf(wp, " recc=%p", (void *)hdb->recc);
   wp += sprintf(wp, " rcnum=%u", hdb->rcnum);
+  wp += sprintf(wp, " rcsiz=%lld", (long long)hdb->rcsiz);
   wp += sprintf(wp, " ecode=%d", hdb->ecode);
   wp += sprintf(wp, " fatal=%u", hdb->fatal);
   wp += sprintf(wp, " inode=%llu", (unsigned long long)(uint64_t)hdb->inode);
@@ -5090,7 +11989,20 @@ void tchdbprintmeta(TCHDB *hdb){
   wp += sprintf(wp, " tran=%d", hdb->tran);
   wp += sprintf(wp, " walfd=%d", hdb->walfd);
   wp += sprintf(wp, " walend=%llu", (unsigned long long)hdb->walend);
+  wp += sprintf(wp, " rlfd=%d", hdb->rlfd);
+  wp += sprintf(wp, " rlsiz=%llu", (unsigned long long)hdb->rlsiz);
+  wp += sprintf(wp, " gcwait=%.6f", hdb->gcwait);
+  wp += sprintf(wp, " gcseq=%llu", (unsigned long long)hdb->gcseq);
+  wp += sprintf(wp, " gcsynced=%llu", (unsigned long long)hdb->gcsynced);
+  wp += sprintf(wp, " dfbps=%lld", (long long)hdb->dfbps);
+  wp += sprintf(wp, " dfth=%p", (void *)hdb->dfth);
+  wp += sprintf(wp, " dfsnum=%llu", (unsigned long long)hdb->dfsnum);
+  wp += sprintf(wp, " dfbsiz=%llu", (unsigned long long)hdb->dfbsiz);
+  wp += sprintf(wp, " dfpnum=%llu", (unsigned long long)hdb->dfpnum);
+  wp += sprintf(wp, " awqnum=%d", hdb->awqnum);
+  wp += sprintf(wp, " awth=%p", (void *)hdb->awth);
   wp += sprintf(wp, " dbgfd=%d", hdb->dbgfd);
+  wp += sprintf(wp, " uring=%p", (void *)hdb->uring);
   wp += sprintf(wp, " cnt_writerec=%lld", (long long)hdb->cnt_writerec);
   wp += sprintf(wp, " cnt_reuserec=%lld", (long long)hdb->cnt_reuserec);
   wp += sprintf(wp, " cnt_moverec=%lld", (long long)hdb->cnt_moverec);
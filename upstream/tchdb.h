@@ -39,13 +39,19 @@ __TCHDB_CLINKAGEBEGIN
 typedef struct {                         /* type of structure for a hash database */
   void *mmtx;                            /* mutex for method */
   void *rmtxs;                           /* mutexes for records */
+  int32_t rmtxnum;                       /* number of mutexes for records */
   void *dmtx;                            /* mutex for the while database */
   void *wmtx;                            /* mutex for write ahead logging */
+  void *gmtx;                            /* mutex for group commit */
+  void *gcnd;                            /* condition variable for group commit */
   void *eckey;                           /* key for thread specific error code */
   char *rpath;                           /* real path for locking */
   uint8_t type;                          /* database type */
   uint8_t flags;                         /* additional flags */
   uint64_t bnum;                         /* number of the bucket array */
+  uint64_t lhbase;                       /* base number of active buckets of linear hashing */
+  uint64_t lhnum;                        /* number of active buckets of linear hashing */
+  uint64_t lhmod;                        /* modulus of the current round of linear hashing */
   uint8_t apow;                          /* power of record alignment */
   uint8_t fpow;                          /* power of free block pool number */
   uint8_t opts;                          /* options */
@@ -61,8 +67,12 @@ typedef struct {                         /* type of structure for a hash databas
   uint64_t msiz;                         /* size of the mapped memory */
   uint64_t xmsiz;                        /* size of the extra mapped memory */
   uint64_t xfsiz;                        /* extra size of the file for mapped memory */
+  uint8_t mopts;                         /* options of the mapped region */
   uint32_t *ba32;                        /* 32-bit bucket array */
   uint64_t *ba64;                        /* 64-bit bucket array */
+  uint32_t *fpa;                         /* fingerprint array of the buckets */
+  uint8_t fwpow;                         /* power of fingerprint words of each bucket */
+  uint8_t fknum;                         /* number of fingerprint bits of each key */
   uint32_t align;                        /* record alignment */
   uint32_t runit;                        /* record reading unit */
   bool zmode;                            /* whether compression is used */
@@ -74,8 +84,9 @@ typedef struct {                         /* type of structure for a hash databas
   TCXSTR *drpool;                        /* delayed record pool */
   TCXSTR *drpdef;                        /* deferred records of the delayed record pool */
   uint64_t drpoff;                       /* offset of the delayed record pool */
-  TCMDB *recc;                           /* cache for records */
+  void *recc;                            /* cache for records */
   uint32_t rcnum;                        /* maximum number of cached records */
+  int64_t rcsiz;                         /* maximum total size of cached records */
   TCCODEC enc;                           /* pointer to the encoding function */
   void *encop;                           /* opaque object for the encoding functions */
   TCCODEC dec;                           /* pointer to the decoding function */
@@ -89,7 +100,56 @@ typedef struct {                         /* type of structure for a hash databas
   bool tran;                             /* whether in the transaction */
   int walfd;                             /* file descriptor of write ahead logging */
   uint64_t walend;                       /* end offset of write ahead logging */
+  void *snap;                            /* reader snapshot of the transaction */
+  double gcwait;                         /* waiting time of group commit */
+  uint64_t gcseq;                        /* sequence number of the last grouped commit */
+  uint64_t gcsynced;                     /* sequence number of the last synchronized commit */
+  uint64_t gcdone;                       /* sequence number notified to waiting committers */
+  bool gclead;                           /* whether a leader of group commit is working */
+  bool gcwant;                           /* whether a leader of group commit is waiting */
+  uint64_t gcwaloff;                     /* offset of the log of the current transaction */
+  uint64_t gcfsiz;                       /* file size at the beginning of the transaction */
+  void *redo;                            /* state of the transaction with redo logging */
+  int rlfd;                              /* file descriptor of the redo log */
+  uint64_t rlsiz;                        /* size of the redo log since the last checkpoint */
+  int64_t rllim;                         /* size of the redo log to start a checkpoint */
+  int64_t dfbps;                         /* budget of background defragmentation per second */
+  void *dfth;                            /* background defragmentation thread */
+  uint64_t dfsnum;                       /* number of steps of background defragmentation */
+  uint64_t dfbsiz;                       /* total size scanned by background defragmentation */
+  uint64_t dfpnum;                       /* number of passes of background defragmentation */
+  int32_t awqnum;                        /* capacity of the queue of the asynchronous writer */
+  void *awth;                            /* asynchronous writer thread */
+  int32_t vlthres;                       /* threshold of the size of values in the value log */
+  int vlfd;                              /* file descriptor of the value log */
+  volatile uint64_t vlhead;              /* end offset of the value log */
+  uint64_t vltail;                       /* offset of the first live region of the value log */
+  volatile uint64_t vldead;              /* estimated size of dead values in the value log */
+  uint64_t vltran;                       /* end offset of the value log at the transaction */
+  uint64_t vltrandead;                   /* dead size of the value log at the transaction */
+  uint64_t vlgccur;                      /* offset of the cursor of the value log collection */
+  uint64_t vlgcend;                      /* end of the region of the current collection pass */
+  uint64_t vlgcdead;                     /* dead size of the region of the current pass */
+  uint64_t vlgcnum;                      /* number of passes of the value log collection */
+  int32_t optthnum;                      /* number of threads of optimization */
   int dbgfd;                             /* file descriptor for debugging */
+  void *uring;                           /* ring of asynchronous I/O */
+  void *iscan;                           /* readahead buffer of the iterator */
+  volatile uint64_t wseq;                /* number of updates discarding the iterator chunk */
+  TCSTATS *stats;                        /* statistics of operations */
+  void *bkup;                            /* state of the online backup */
+  uint64_t xtcur;                        /* offset of the cursor of the expiration sweeper */
+  time_t xtnext;                         /* time when the next pass of the sweeper may start */
+  TCTREE *xtidx;                         /* offsets of the records with expiration times by time */
+  uint64_t xtinum;                       /* number of the offsets in the expiration index */
+  uint64_t apsync;                       /* end of the records synchronized in append-only mode */
+  uint64_t apcur;                        /* offset of the free extent filled in append-only mode */
+  uint64_t apend;                        /* end of the free extent filled in append-only mode */
+  uint64_t aprel;                        /* offset of the record released in append-only mode */
+  TCMAP *pins;                           /* offsets of the records pinned by the live pins */
+  TCMAP *pinrecs;                        /* numbers of the live pins of the pinned records */
+  uint64_t pinid;                        /* identifier of the last pin */
+  volatile uint64_t pinnum;              /* number of the live pins */
   volatile int64_t cnt_writerec;         /* tesing counter for record write times */
   volatile int64_t cnt_reuserec;         /* tesing counter for record reuse times */
   volatile int64_t cnt_moverec;          /* tesing counter for record move times */
@@ -111,7 +171,8 @@ typedef struct {                         /* type of structure for a hash databas
 
 enum {                                   /* enumeration for additional flags */
   HDBFOPEN = 1 << 0,                     /* whether opened */
-  HDBFFATAL = 1 << 1                     /* whether with fatal error */
+  HDBFFATAL = 1 << 1,                    /* whether with fatal error */
+  HDBFEXPIRE = 1 << 2                    /* whether records with expiration times are stored */
 };
 
 enum {                                   /* enumeration for tuning options */
@@ -119,7 +180,9 @@ enum {                                   /* enumeration for tuning options */
   HDBTDEFLATE = 1 << 1,                  /* compress each record with Deflate */
   HDBTBZIP = 1 << 2,                     /* compress each record with BZIP2 */
   HDBTTCBS = 1 << 3,                     /* compress each record with TCBS */
-  HDBTEXCODEC = 1 << 4                   /* compress each record with custom functions */
+  HDBTEXCODEC = 1 << 4,                  /* compress each record with custom functions */
+  HDBTFPRINT = 1 << 5,                   /* keep key fingerprints in the bucket array */
+  HDBTLZ = 1 << 6                        /* compress each record with LZ */
 };
 
 enum {                                   /* enumeration for open modes */
@@ -129,7 +192,19 @@ enum {                                   /* enumeration for open modes */
   HDBOTRUNC = 1 << 3,                    /* writer truncating */
   HDBONOLCK = 1 << 4,                    /* open without locking */
   HDBOLCKNB = 1 << 5,                    /* lock without blocking */
-  HDBOTSYNC = 1 << 6                     /* synchronize every transaction */
+  HDBOTSYNC = 1 << 6,                    /* synchronize every transaction */
+  HDBOSNAPSHOT = 1 << 7,                 /* read the committed state during transactions */
+  HDBOREDO = 1 << 8,                     /* log transactions by redo logging */
+  HDBOAPPEND = 1 << 9                    /* append every written record at the end */
+};
+
+enum {                                   /* enumeration for mapping options */
+  HDBMHUGE = 1 << 0,                     /* back the bucket array with huge pages */
+  HDBMLOCK = 1 << 1,                     /* lock the bucket array in memory */
+  HDBMBRANDOM = 1 << 2,                  /* advise random access to the bucket array */
+  HDBMBWILLNEED = 1 << 3,                /* read the bucket array ahead */
+  HDBMRRANDOM = 1 << 4,                  /* advise random access to the mapped records */
+  HDBMRWILLNEED = 1 << 5                 /* read the mapped records ahead */
 };
 
 
@@ -186,7 +261,10 @@ bool tchdbsetmutex(TCHDB *hdb);
    `opts' specifies options by bitwise-or: `HDBTLARGE' specifies that the size of the database
    can be larger than 2GB by using 64-bit bucket array, `HDBTDEFLATE' specifies that each record
    is compressed with Deflate encoding, `HDBTBZIP' specifies that each record is compressed with
-   BZIP2 encoding, `HDBTTCBS' specifies that each record is compressed with TCBS encoding.
+   BZIP2 encoding, `HDBTTCBS' specifies that each record is compressed with TCBS encoding,
+   `HDBTLZ' specifies that each record is compressed with LZ encoding, which is much faster than
+   the others, `HDBTFPRINT' specifies that a 32-bit fingerprint of the keys is kept for each
+   bucket so that retrieval of a missing key can be resolved without reading records.
    If successful, the return value is true, else, it is false.
    Note that the tuning parameters should be set before the database is opened. */
 bool tchdbtune(TCHDB *hdb, int64_t bnum, int8_t apow, int8_t fpow, uint8_t opts);
@@ -201,6 +279,21 @@ bool tchdbtune(TCHDB *hdb, int64_t bnum, int8_t apow, int8_t fpow, uint8_t opts)
 bool tchdbsetcache(TCHDB *hdb, int32_t rcnum);
 
 
+/* Set the caching parameters of a hash database object with the size limit.
+   `hdb' specifies the hash database object which is not opened.
+   `rcnum' specifies the maximum number of records to be cached.  If it is not more than 0, the
+   number of records is not limited.
+   `rcsiz' specifies the maximum total size of the keys and the values of cached records.  If it
+   is not more than 0, the size is not limited.  If both of the limits are disabled, the record
+   cache is disabled.
+   If successful, the return value is true, else, it is false.
+   Note that the caching parameters should be set before the database is opened.  The cache is
+   divided into shards locked separately.  A record read once is kept in a small probationary
+   queue and it is promoted to the main queue only when it is read again after falling out of
+   the probation, so that a sequential scan does not flush the working set. */
+bool tchdbsetcache2(TCHDB *hdb, int32_t rcnum, int64_t rcsiz);
+
+
 /* Set the size of the extra mapped memory of a hash database object.
    `hdb' specifies the hash database object which is not opened.
    `xmsiz' specifies the size of the extra mapped memory.  If it is not more than 0, the extra
@@ -210,6 +303,22 @@ bool tchdbsetcache(TCHDB *hdb, int32_t rcnum);
 bool tchdbsetxmsiz(TCHDB *hdb, int64_t xmsiz);
 
 
+/* Set the options of the mapped region of a hash database object.
+   `hdb' specifies the hash database object which is not opened.
+   `mopts' specifies options by bitwise-or: `HDBMHUGE' specifies that the bucket array is backed
+   by transparent huge pages, `HDBMLOCK' specifies that the bucket array is locked in memory,
+   `HDBMBRANDOM' and `HDBMBWILLNEED' specify that random access is advised or the pages are read
+   ahead for the region of the bucket array, and `HDBMRRANDOM' and `HDBMRWILLNEED' specify the
+   same for the region of records in the extra mapped memory.  By default, no option is
+   specified.
+   If successful, the return value is true, else, it is false.
+   Note that the mapping parameters should be set before the database is opened.  The advice is
+   only a hint and it is ignored if the platform does not support it.  Huge pages of a file
+   mapping are available only if the kernel supports them for the file system.  If the bucket
+   array can not be locked, the database can not be opened. */
+bool tchdbsetmapopts(TCHDB *hdb, int mopts);
+
+
 /* Set the unit step number of auto defragmentation of a hash database object.
    `hdb' specifies the hash database object which is not opened.
    `dfunit' specifie the unit step number.  If it is not more than 0, the auto defragmentation
@@ -219,6 +328,117 @@ bool tchdbsetxmsiz(TCHDB *hdb, int64_t xmsiz);
 bool tchdbsetdfunit(TCHDB *hdb, int32_t dfunit);
 
 
+/* Set the initial number of active buckets of linear hashing of a hash database object.
+   `hdb' specifies the hash database object which is not opened.
+   `lhnum' specifies the initial number of active elements of the bucket array.  The number is
+   rounded up to a prime.  If it is not more than 0, linear hashing is disabled.  It is disabled
+   by default.
+   If successful, the return value is true, else, it is false.
+   In the linear hashing mode, the bucket number given with `tchdbtune' is the capacity of the
+   bucket array and only the active part of it is used.  When the number of records exceeds the
+   number of active buckets, buckets are split one by one and the active part grows until it
+   reaches the capacity.  Note that the parameter is stored in the database file when it is
+   created and it is ignored when an existing database file is opened. */
+bool tchdbsetlinear(TCHDB *hdb, int64_t lhnum);
+
+
+/* Set the false positive rate of the key fingerprints of a hash database object.
+   `hdb' specifies the hash database object which is not opened.
+   `rate' specifies the desired probability that a missing key passes the fingerprint of its
+   bucket and the collision tree is walked.  If it is not more than 0, the default geometry of
+   one 32-bit word and three bits per key is used.
+   If successful, the return value is true, else, it is false.
+   The fingerprints are kept only with the option `HDBTFPRINT'.  Each bucket has up to 64 words
+   and each key sets a few bits of one of them; the number of words and bits is derived from the
+   rate assuming two records per bucket.  Note that the parameter is stored in the database
+   file when it is created and it is ignored when an existing database file is opened. */
+bool tchdbsetfprate(TCHDB *hdb, double rate);
+
+
+/* Set the waiting time of group commit of a hash database object.
+   `hdb' specifies the hash database object which is not opened.
+   `wsec' specifies the time in seconds for which a committer waits for other transactions to
+   join its group.  If it is not more than 0, group commit is disabled.  It is disabled by
+   default.
+   If successful, the return value is true, else, it is false.
+   Group commit takes effect only if the database is opened with `HDBOTSYNC' and the mutual
+   exclusion control is enabled.  `tchdbtrancommit' then returns after a synchronization which
+   is shared with transactions committed by other threads in the meantime, instead of
+   synchronizing the file for each transaction.  Note that the parameter should be set before
+   the database is opened. */
+bool tchdbsetgcwait(TCHDB *hdb, double wsec);
+
+
+/* Set the checkpoint size of the redo log of a hash database object.
+   `hdb' specifies the hash database object which is not opened.
+   `ckptsiz' specifies the size of the redo log in bytes at which a commit starts a checkpoint.
+   If it is not more than 0, the default value is specified.  The default value is 67108864.
+   If successful, the return value is true, else, it is false.
+   The redo log is used only if the database is opened with `HDBOREDO'.  A checkpoint applies
+   nothing because every commit has applied its frame to the file already; it synchronizes the
+   file with the device if the database is opened with `HDBOTSYNC' and truncates the log.  Note
+   that the parameter should be set before the database is opened. */
+bool tchdbsetckptsiz(TCHDB *hdb, int64_t ckptsiz);
+
+
+/* Set the budget of background defragmentation of a hash database object.
+   `hdb' specifies the hash database object which is not opened.
+   `bps' specifies the number of bytes of the file which the background defragmentation may
+   process in a second.  If it is not more than 0, background defragmentation is disabled.  It is
+   disabled by default.
+   If successful, the return value is true, else, it is false.
+   Background defragmentation takes effect only if the auto defragmentation is enabled with
+   `tchdbsetdfunit', the mutual exclusion control is enabled, and the database is opened as a
+   writer.  Then, the steps of auto defragmentation are performed by a thread owned by the
+   database object instead of by the writing threads, and the thread sleeps between steps so that
+   the budget is not exceeded.  Each step excludes readers of records only while it moves at most
+   256 records.  Note that the parameter should be set before the database is opened. */
+bool tchdbsetbgdefrag(TCHDB *hdb, int64_t bps);
+
+
+/* Set the asynchronous writer of a hash database object.
+   `hdb' specifies the hash database object which is not opened.
+   `qnum' specifies the capacity of the queue of records stored in asynchronous fashion.  It is
+   rounded up to a power of 2.  If it is not more than 0, the asynchronous writer is disabled.
+   It is disabled by default.
+   If successful, the return value is true, else, it is false.
+   The asynchronous writer takes effect only if the mutual exclusion control is enabled and the
+   database is opened as a writer.  Then, `tchdbputasync' only copies the record into a bounded
+   queue and a thread owned by the database object stores the queued records into the file.  If
+   the queue is full, the caller waits until the writer makes room.  The other methods accessing
+   records wait until the records queued before the call are stored, so that queued records are
+   seen by later retrievals and are not stored over later updates of the same keys.  Note that
+   the parameter should be set before the database is opened. */
+bool tchdbsetasyncwriter(TCHDB *hdb, int32_t qnum);
+
+
+/* Set the threshold of the value log of a hash database object.
+   `hdb' specifies the hash database object which is not opened.
+   `thres' specifies the minimum size of a value stored in the value log.  If it is not more than
+   0, the value log is not used for new values.  It is disabled by default.
+   If successful, the return value is true, else, it is false.
+   Note that the threshold should be set before the database is opened.  A value whose size
+   after compression is not less than the threshold is appended to the value log, which is the
+   file whose name is the database name with the suffix ".vlog", and the record keeps the key
+   and a reference of 12 bytes, so that the collision trees stay small.  The space of dead values
+   is reclaimed along with defragmentation: when dead values occupy half of the log, a pass
+   scanning all records moves the live values to the end of the log and releases the region
+   before.  The value log is used when the database is opened even without the threshold if the
+   file exists. */
+bool tchdbsetvlog(TCHDB *hdb, int32_t thres);
+
+
+/* Set the number of threads of optimization of a hash database object.
+   `hdb' specifies the hash database object.
+   `tnum' specifies the number of worker threads used by `tchdboptimize'.  If it is not more than
+   1, records are copied by the calling thread.  It is disabled by default.
+   If successful, the return value is true, else, it is false.
+   With worker threads, the file is partitioned by offset into chunks of whole records, which are
+   decompressed and compressed again by the workers, and the records are stored into the new file
+   by the calling thread in the original order.  Custom codec functions must be thread-safe. */
+bool tchdbsetoptthreads(TCHDB *hdb, int32_t tnum);
+
+
 /* Open a database file and connect a hash database object.
    `hdb' specifies the hash database object which is not opened.
    `path' specifies the path of the database file.
@@ -226,10 +446,27 @@ bool tchdbsetdfunit(TCHDB *hdb, int32_t dfunit);
    If the mode is `HDBOWRITER', the following may be added by bitwise-or: `HDBOCREAT', which
    means it creates a new database if not exist, `HDBOTRUNC', which means it creates a new
    database regardless if one exists, `HDBOTSYNC', which means every transaction synchronizes
-   updated contents with the device.  Both of `HDBOREADER' and `HDBOWRITER' can be added to by
-   bitwise-or: `HDBONOLCK', which means it opens the database file without file locking, or
-   `HDBOLCKNB', which means locking is performed without blocking.
-   If successful, the return value is true, else, it is false. */
+   updated contents with the device, `HDBOSNAPSHOT', which means threads other than the one
+   which began a transaction retrieve the last committed state while it runs, `HDBOREDO', which
+   means transactions are logged by redo logging instead of the pre-images, `HDBOAPPEND', which
+   means every written record is appended at the end of the file.  Both of
+   `HDBOREADER' and `HDBOWRITER' can be added to by bitwise-or: `HDBONOLCK', which means it opens
+   the database file without file locking, or `HDBOLCKNB', which means locking is performed
+   without blocking.
+   If successful, the return value is true, else, it is false.
+   With `HDBOSNAPSHOT', `tchdbget', `tchdbget3', `tchdbvsiz' and `tchdbrnum' called by the other
+   threads are served from the pre-images in the write ahead log without waiting for the
+   transaction.  It takes effect only if the object is shared by threads with `tchdbsetmutex'.
+   With `HDBOREDO', the file is not modified while a transaction runs, and a commit appends the
+   new contents of the updated regions to the redo log sequentially and then applies them to the
+   file.  With `HDBOTSYNC', a commit synchronizes only the log and the file is synchronized at
+   checkpoints.  The log left by a crash is applied when the database is opened next time.
+   With `HDBOAPPEND', a record is never written in place nor into a free block: storing a record
+   appends it at the end of the file and only the link to it is updated, and the region of the
+   old record is left as a free block.  The regions are reclaimed by the defragmentation, which
+   should be enabled with `tchdbsetdfunit' or `tchdbsetbgdefrag'.  If the database was not closed
+   appropriately, opening it again scans only the records appended after the last
+   synchronization and fixes the end of the file. */
 bool tchdbopen(TCHDB *hdb, const char *path, int omode);
 
 
@@ -261,6 +498,24 @@ bool tchdbput(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz
 bool tchdbput2(TCHDB *hdb, const char *kstr, const char *vstr);
 
 
+/* Store a record with an expiration time into a hash database object.
+   `hdb' specifies the hash database object connected as a writer.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `vbuf' specifies the pointer to the region of the value.
+   `vsiz' specifies the size of the region of the value.
+   `xt' specifies the expiration time.  If it is positive, it is the lifetime in seconds from now.
+   If it is negative, its absolute value is the time in seconds since the epoch.  If it is 0, the
+   record never expires.
+   If successful, the return value is true, else, it is false.
+   If a record with the same key exists in the database, it is overwritten.  A record which has
+   expired is treated as missing by every function and its region is reclaimed when it is
+   overwritten or removed, by the defragmentation, and by the optimization.  Functions which
+   modify the value of an existing record, such as `tchdbputcat' and `tchdbaddint', keep its
+   expiration time, while the other functions storing a record clear it. */
+bool tchdbputxt(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int vsiz, int64_t xt);
+
+
 /* Store a new record into a hash database object.
    `hdb' specifies the hash database object connected as a writer.
    `kbuf' specifies the pointer to the region of the key.
@@ -323,6 +578,15 @@ bool tchdbputasync(TCHDB *hdb, const void *kbuf, int ksiz, const void *vbuf, int
 bool tchdbputasync2(TCHDB *hdb, const char *kstr, const char *vstr);
 
 
+/* Wait for records stored in asynchronous fashion to be written into a hash database object.
+   `hdb' specifies the hash database object connected as a writer.
+   If successful, the return value is true, else, it is false.
+   When this function returns, every record passed to `tchdbputasync' before the call has been
+   stored and is visible to the other methods.  If storing a queued record failed, false is
+   returned. */
+bool tchdbasyncflush(TCHDB *hdb);
+
+
 /* Remove a record of a hash database object.
    `hdb' specifies the hash database object connected as a writer.
    `kbuf' specifies the pointer to the region of the key.
@@ -377,6 +641,54 @@ char *tchdbget2(TCHDB *hdb, const char *kstr);
 int tchdbget3(TCHDB *hdb, const void *kbuf, int ksiz, void *vbuf, int max);
 
 
+/* Retrieve records of multiple keys in a hash database object.
+   `hdb' specifies the hash database object.
+   `keys' specifies a list object of the keys.
+   If successful, the return value is a list object of the keys and the values of the existing
+   records, arranged alternately in the order of `keys'.  `NULL' is returned if an error occurs.
+   Missing keys are not regarded as an error.
+   The probes are sorted by the record lock and the bucket index and are processed in groups.
+   The first records of the buckets of a group which are outside the mapped region are read
+   under the record locks in the order of their offsets with one submission through io_uring
+   where it is available, and the trees are walked from the data read in the same order, so
+   that a batch is read with less random I/O than calling `tchdbget' for each key.  Each key is
+   recorded as a retrieval in the statistics.
+   Because the object of the return value is created with the function `tclistnew', it should be
+   deleted with the function `tclistdel' when it is no longer in use. */
+TCLIST *tchdbgetmulti(TCHDB *hdb, const TCLIST *keys);
+
+
+/* Retrieve a record in a hash database object and pin the value in the mapped region.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   `sp' specifies the pointer to the variable into which the size of the region of the return
+   value is assigned.
+   `pinp' specifies the pointer to the variable into which the identifier of the pin is
+   assigned.
+   If successful, the return value is the pointer to the region of the value in the mapped
+   region, else, it is `NULL'.  `NULL' is returned if no record corresponds to the specified key,
+   and also with the error code `TCEINVALID' if the value can not be pinned because it is
+   compressed, stored in the value log, or not inside the mapped region, or because a transaction
+   is running.  Then `tchdbget' should be used instead.
+   The value is neither copied nor terminated by a zero code.  No lock is held after the call.
+   Until `tchdbunpin' is called with the identifier, the region of the pinned record is neither
+   overwritten nor reused: a record updated while pinned is written at the end of the file, the
+   region of a record removed while pinned is left to the defragmentation, the defragmentation
+   does not move records, and `tchdboptimize' and `tchdbvanish' fail.  Every pin is released
+   when the database is closed. */
+const void *tchdbgetpin(TCHDB *hdb, const void *kbuf, int ksiz, int *sp, uint64_t *pinp);
+
+
+/* Release a value pinned by `tchdbgetpin' in a hash database object.
+   `hdb' specifies the hash database object.
+   `pin' specifies the identifier of the pin.
+   If successful, the return value is true, else, it is false.  False is returned with the error
+   code `TCEINVALID' if the identifier is not of a live pin.
+   The region returned by `tchdbgetpin' must not be accessed afterward. */
+bool tchdbunpin(TCHDB *hdb, uint64_t pin);
+
+
 /* Get the size of the value of a record in a hash database object.
    `hdb' specifies the hash database object.
    `kbuf' specifies the pointer to the region of the key.
@@ -394,6 +706,15 @@ int tchdbvsiz(TCHDB *hdb, const void *kbuf, int ksiz);
 int tchdbvsiz2(TCHDB *hdb, const char *kstr);
 
 
+/* Get the expiration time of a record in a hash database object.
+   `hdb' specifies the hash database object.
+   `kbuf' specifies the pointer to the region of the key.
+   `ksiz' specifies the size of the region of the key.
+   If successful, the return value is the expiration time of the corresponding record in seconds
+   since the epoch, or 0 if it never expires.  -1 is returned if no record corresponds. */
+int64_t tchdbgetxt(TCHDB *hdb, const void *kbuf, int ksiz);
+
+
 /* Initialize the iterator of a hash database object.
    `hdb' specifies the hash database object.
    If successful, the return value is true, else, it is false.
@@ -507,7 +828,9 @@ bool tchdbsync(TCHDB *hdb);
    `opts' specifies options by bitwise-or: `HDBTLARGE' specifies that the size of the database
    can be larger than 2GB by using 64-bit bucket array, `HDBTDEFLATE' specifies that each record
    is compressed with Deflate encoding, `HDBTBZIP' specifies that each record is compressed with
-   BZIP2 encoding, `HDBTTCBS' specifies that each record is compressed with TCBS encoding.  If it
+   BZIP2 encoding, `HDBTTCBS' specifies that each record is compressed with TCBS encoding,
+   `HDBTLZ' specifies that each record is compressed with LZ encoding, `HDBTFPRINT' specifies
+   that a 32-bit fingerprint of the keys is kept for each bucket.  If it
    is `UINT8_MAX', the current setting is not changed.
    If successful, the return value is true, else, it is false.
    This function is useful to reduce the size of the database file with data fragmentation by
@@ -533,6 +856,21 @@ bool tchdbvanish(TCHDB *hdb);
 bool tchdbcopy(TCHDB *hdb, const char *path);
 
 
+/* Copy the database file of a hash database object without blocking writers.
+   `hdb' specifies the hash database object.
+   `path' specifies the path of the destination file.  A command line beginning with `@' is not
+   supported.
+   If successful, the return value is true, else, it is false.
+   The file is copied while the database is updated by other threads, and the pages updated
+   during each pass are copied again by the next pass.  When few pages remain, they are copied in
+   a short catch-up phase while the database is locked, so that the destination is a consistent
+   image as of the end of the backup.  The value log is also copied if it exists.  Only one
+   online backup can be performed with a database object at the same time.  If the database is
+   closed during the backup, the backup fails.  As the catch-up phase waits for the running
+   transaction to finish, this function should not be called by the thread in a transaction. */
+bool tchdbbackup(TCHDB *hdb, const char *path);
+
+
 /* Begin the transaction of a hash database object.
    `hdb' specifies the hash database object connected as a writer.
    If successful, the return value is true, else, it is false.
@@ -540,7 +878,10 @@ bool tchdbcopy(TCHDB *hdb, const char *path);
    activated with a database object at the same time.  Thus, the serializable isolation level is
    assumed if every database operation is performed in the transaction.  All updated regions are
    kept track of by write ahead logging while the transaction.  If the database is closed during
-   transaction, the transaction is aborted implicitly. */
+   transaction, the transaction is aborted implicitly.  If the database is opened with
+   `HDBOSNAPSHOT', regions are logged by pages and readers in other threads see the state before
+   the transaction.  If the database is opened with `HDBOREDO', updated regions are kept in memory
+   instead and nothing is logged until the commit. */
 bool tchdbtranbegin(TCHDB *hdb);
 
 
@@ -705,6 +1046,27 @@ char *tchdbopaque(TCHDB *hdb);
 uint64_t tchdbbnumused(TCHDB *hdb);
 
 
+/* Get the number of active elements of the bucket array of a hash database object.
+   `hdb' specifies the hash database object.
+   The return value is the number of active elements of the bucket array or 0 if the object
+   does not connect to any database file.  If linear hashing is disabled, it is the same as the
+   number of elements of the bucket array. */
+uint64_t tchdbbnumactive(TCHDB *hdb);
+
+
+/* Set mutual exclusion control of a hash database object for threading with the number of
+   record locks.
+   `hdb' specifies the hash database object which is not opened.
+   `rmtxnum' specifies the number of locks for records.  It is rounded up to a power of 2.  If it
+   is not more than 0, the default value is specified.  The default value is 256.
+   If successful, the return value is true, else, it is false.
+   Each lock occupies its own cache line.  Retrieval by `tchdbget' reads records in the mapped
+   region without taking the record lock and validates the result by a sequence number which
+   writers update while holding the lock.  Note that the mutual exclusion control should be set
+   before the database is opened. */
+bool tchdbsetmutex2(TCHDB *hdb, int32_t rmtxnum);
+
+
 /* Set the custom codec functions of a hash database object.
    `hdb' specifies the hash database object.
    `enc' specifies the pointer to the custom encoding function.  It receives four parameters.
@@ -747,16 +1109,67 @@ uint32_t tchdbdfunit(TCHDB *hdb);
    `hdb' specifies the hash database object connected as a writer.
    `step' specifie the number of steps.  If it is not more than 0, the whole file is defragmented
    gradually without keeping a continuous lock.
-   If successful, the return value is true, else, it is false. */
+   If successful, the return value is true, else, it is false.
+   Records which have expired are also removed by a sweeper scanning the file step by step.  A
+   pass of it is started at most once per minute, or by the whole defragmentation. */
 bool tchdbdefrag(TCHDB *hdb, int64_t step);
 
 
+/* Get the progress of background defragmentation of a hash database object.
+   `hdb' specifies the hash database object.
+   `snp' specifies the pointer to the variable into which the number of performed steps is
+   assigned.  If it is `NULL', it is not used.
+   `bsp' specifies the pointer to the variable into which the total size of the processed region
+   is assigned.  If it is `NULL', it is not used.
+   `pnp' specifies the pointer to the variable into which the number of completed passes over the
+   whole file is assigned.  If it is `NULL', it is not used.
+   If successful, the return value is true, else, it is false.
+   The counters are accumulated over the lifetime of the object. */
+bool tchdbbgdefragstat(TCHDB *hdb, uint64_t *snp, uint64_t *bsp, uint64_t *pnp);
+
+
 /* Clear the cache of a hash tree database object.
    `hdb' specifies the hash tree database object.
    If successful, the return value is true, else, it is false. */
 bool tchdbcacheclear(TCHDB *hdb);
 
 
+/* Get the statistics of the record cache of a hash database object.
+   `hdb' specifies the hash database object.
+   `hitp' specifies the pointer to the variable into which the number of cache hits is assigned.
+   If it is `NULL', it is not used.
+   `missp' specifies the pointer to the variable into which the number of cache misses is
+   assigned.  If it is `NULL', it is not used.
+   `rnump' specifies the pointer to the variable into which the number of cached records is
+   assigned.  If it is `NULL', it is not used.
+   `msizp' specifies the pointer to the variable into which the estimated memory usage of the
+   cached records is assigned.  If it is `NULL', it is not used.
+   If successful, the return value is true, else, it is false.
+   The counters are reset when the database is opened. */
+bool tchdbcachestat(TCHDB *hdb, uint64_t *hitp, uint64_t *missp, uint64_t *rnump,
+                    uint64_t *msizp);
+
+
+/* Get the statistics of the value log of a hash database object.
+   `hdb' specifies the hash database object.
+   `lsizp' specifies the pointer to the variable into which the size of the region of the value
+   log in use is assigned.  If it is `NULL', it is not used.
+   `dsizp' specifies the pointer to the variable into which the estimated size of dead values in
+   the region is assigned.  If it is `NULL', it is not used.
+   `pnp' specifies the pointer to the variable into which the number of completed passes of the
+   garbage collection is assigned.  If it is `NULL', it is not used.
+   If successful, the return value is true, else, it is false. */
+bool tchdbvlogstat(TCHDB *hdb, uint64_t *lsizp, uint64_t *dsizp, uint64_t *pnp);
+
+
+/* Get the statistics of operations of a hash database object.
+   `hdb' specifies the hash database object.
+   The return value is the statistics object of the database.  It is updated by every thread
+   calling the API of the object and valid until the object is deleted.  It can be read with
+   such functions as `tcstatspctl' and `tcstatsmap', and reset with `tcstatsclear'. */
+TCSTATS *tchdbstats(TCHDB *hdb);
+
+
 /* Store a record into a hash database object with a duplication handler.
    `hdb' specifies the hash database object connected as a writer.
    `kbuf' specifies the pointer to the region of the key.
@@ -855,6 +1268,104 @@ bool tchdbiterinit3(TCHDB *hdb, const char *kstr);
 bool tchdbforeach(TCHDB *hdb, TCITER iter, void *op);
 
 
+/* Split the record region of a hash database object into partitions for parallel iteration.
+   `hdb' specifies the hash database object.
+   `pnum' specifies the number of partitions desired.
+   `np' specifies the pointer to the variable into which the number of partitions actually made
+   is assigned.  It may be less than `pnum' if the database is small.
+   If successful, the return value is the pointer to the array of `*np + 1' offsets, else, it is
+   `NULL'.  The partition `i' begins at the element `i' and ends before the element `i + 1'.
+   Each boundary is the offset of a record head found in the bucket array, so no record is
+   scanned by two partitions.
+   Because the region of the return value is allocated with the `malloc' call, it should be
+   released with the `free' call when it is no longer in use.  The offsets are invalidated by
+   the defragmentation and the optimization of the database. */
+uint64_t *tchdbpartition(TCHDB *hdb, int pnum, int *np);
+
+
+/* Get the next record of a partition of a hash database object.
+   `hdb' specifies the hash database object.
+   `curp' specifies the pointer to the cursor of the partition.  It should be initialized with
+   the beginning offset of the partition and is advanced past the record retrieved.
+   `end' specifies the ending offset of the partition.
+   `kxstr' specifies the object into which the key is wrote down.
+   `vxstr' specifies the object into which the value is wrote down.
+   If successful, the return value is true, else, it is false.  False is returned when no record
+   is to be get out of the partition.
+   Only the shared method lock and the lock of the bucket of each record are held, so that
+   threads can iterate distinct partitions of the same object concurrently with readers and
+   writers.  However, records moved by the defragmentation may be visited twice or missed. */
+bool tchdbiternextpart(TCHDB *hdb, uint64_t *curp, uint64_t end, TCXSTR *kxstr, TCXSTR *vxstr);
+
+
+/* Process each record of a partition of a hash database object atomically.
+   `hdb' specifies the hash database object.
+   `beg' specifies the beginning offset of the partition.
+   `end' specifies the ending offset of the partition.
+   `iter' specifies the pointer to the iterator function called for each record.  It is the same
+   as that of `tchdbforeach'.
+   `op' specifies an arbitrary pointer to be given as a parameter of the iterator function.  If
+   it is not needed, `NULL' can be specified.
+   If successful, the return value is true, else, it is false.
+   Every record lock is held in shared mode while the partition is processed, so that several
+   partitions can be processed concurrently while writers wait. */
+bool tchdbforeachpart(TCHDB *hdb, uint64_t beg, uint64_t end, TCITER iter, void *op);
+
+
+/* type of the pointer to a function feeding records to the bulk loader.
+   `ksp' specifies the pointer to the variable into which the size of the region of the key is
+   assigned.
+   `vbp' specifies the pointer to the variable into which the pointer to the region of the value
+   is assigned.
+   `vsp' specifies the pointer to the variable into which the size of the region of the value is
+   assigned.
+   `xtp' specifies the pointer to the variable into which the expiration time of the record is
+   assigned.  It is zero before the call, which means the record never expires, and otherwise has
+   the same meaning as that of `tchdbputxt'.
+   `op' specifies the pointer to the optional opaque object.
+   The return value is the pointer to the region of the key of the next record, or `NULL' if
+   there is no more record.  The regions are only referred to until the next call. */
+typedef const void *(*TCHDBFEED)(int *ksp, const void **vbp, int *vsp, int64_t *xtp, void *op);
+
+/* Create a hash database file from a stream of records in bulk.
+   `hdb' specifies the hash database object which is not opened.
+   `path' specifies the path of the database file.  If it exists, it is truncated.
+   `feed' specifies the pointer to the function feeding the records.
+   `op' specifies an arbitrary pointer to be given as a parameter of the feeding function.  If
+   it is not needed, `NULL' can be specified.
+   If successful, the return value is true, else, it is false.
+   The records are sorted by bucket in runs spilled into temporary files beside the database
+   file, and the merged runs are written sequentially behind the bucket array, so that no
+   random I/O occurs regardless of the number of records.  At most 64 runs are merged at once,
+   and more runs are merged in several levels.  The tuning parameters set on the object are
+   applied to the new file: with linear hashing, the active buckets are grown as if the records
+   had been stored one by one, and values as large as the threshold of the value log are written
+   sequentially into it.  If a key is fed more than once, the last value is stored.  The database
+   object is closed when this function returns. */
+bool tchdbbulkload(TCHDB *hdb, const char *path, TCHDBFEED feed, void *op);
+
+
+/* type of the pointer to a function called around the catch-up phase of an online backup.
+   `begin' specifies true before the catch-up phase or false after it.
+   `op' specifies the pointer to the optional opaque object.
+   The return value should be true on success or false on failure.  It is ignored after the
+   catch-up phase. */
+typedef bool (*TCHDBBKPROC)(bool begin, void *op);
+
+/* Copy the database file of a hash database object without blocking writers, with a hook.
+   `hdb' specifies the hash database object.
+   `path' specifies the path of the destination file.
+   `proc' specifies the pointer to the function called before and after the catch-up phase.  If
+   it is `NULL', no function is called.
+   `op' specifies an arbitrary pointer to be given as a parameter of the function.  If it is not
+   needed, `NULL' can be specified.
+   If successful, the return value is true, else, it is false.
+   The function is called before the database is locked for the catch-up phase and after it is
+   unlocked, so that the caller can flush and lock its own structures built on the database.  If
+   it fails before the catch-up phase, the backup fails without calling it again. */
+bool tchdbbackupproc(TCHDB *hdb, const char *path, TCHDBBKPROC proc, void *op);
+
+
 /* Void the transaction of a hash database object.
    `hdb' specifies the hash database object connected as a writer.
    If successful, the return value is true, else, it is false.
@@ -24,12 +24,22 @@ const char *g_progname;                  // program name
 int g_dbgfd;                             // debugging output
 
 
+typedef struct {                         // type of structure for the feeder of bulk loading
+  FILE *ifp;                             // input stream
+  char *line;                            // current line
+  bool sc;                               // whether to normalize keys
+  int64_t xt;                            // expiration time of the records
+  int cnt;                               // number of fed records
+} BULKFEED;
+
+
 /* function prototypes */
 int main(int argc, char **argv);
 static void usage(void);
 static void printerr(TCHDB *hdb);
 static int printdata(const char *ptr, int size, bool px);
 static char *mygetline(FILE *ifp);
+static const void *bulkfeed(int *ksp, const void **vbp, int *vsp, int64_t *xtp, void *op);
 static int runcreate(int argc, char **argv);
 static int runinform(int argc, char **argv);
 static int runput(int argc, char **argv);
@@ -38,8 +48,10 @@ static int runget(int argc, char **argv);
 static int runlist(int argc, char **argv);
 static int runoptimize(int argc, char **argv);
 static int runimporttsv(int argc, char **argv);
+static int runbulkload(int argc, char **argv);
 static int runversion(int argc, char **argv);
-static int proccreate(const char *path, int bnum, int apow, int fpow, int opts);
+static int proccreate(const char *path, int bnum, int apow, int fpow, int opts, int lhnum,
+                      double fprate);
 static int procinform(const char *path, int omode);
 static int procput(const char *path, const char *kbuf, int ksiz, const char *vbuf, int vsiz,
                    int omode, int dmode);
@@ -47,8 +59,10 @@ static int procout(const char *path, const char *kbuf, int ksiz, int omode);
 static int procget(const char *path, const char *kbuf, int ksiz, int omode, bool px, bool pz);
 static int proclist(const char *path, int omode, int max, bool pv, bool px, const char *fmstr);
 static int procoptimize(const char *path, int bnum, int apow, int fpow, int opts, int omode,
-                        bool df);
+                        bool df, int tnum);
 static int procimporttsv(const char *path, const char *file, int omode, bool sc);
+static int procbulkload(const char *path, const char *file, int bnum, int apow, int fpow,
+                        int opts, int lhnum, double fprate, int vlthres, int64_t xt, bool sc);
 static int procversion(void);
 
 
@@ -76,6 +90,8 @@ int main(int argc, char **argv){
     rv = runoptimize(argc, argv);
   } else if(!strcmp(argv[1], "importtsv")){
     rv = runimporttsv(argc, argv);
+  } else if(!strcmp(argv[1], "bulkload")){
+    rv = runbulkload(argc, argv);
   } else if(!strcmp(argv[1], "version") || !strcmp(argv[1], "--version")){
     rv = runversion(argc, argv);
   } else {
@@ -90,15 +106,18 @@ static void usage(void){
   fprintf(stderr, "%s: the command line utility of the hash database API\n", g_progname);
   fprintf(stderr, "\n");
   fprintf(stderr, "usage:\n");
-  fprintf(stderr, "  %s create [-tl] [-td|-tb|-tt|-tx] path [bnum [apow [fpow]]]\n", g_progname);
+  fprintf(stderr, "  %s create [-tl] [-tf] [-fr num] [-td|-tb|-tt|-ts|-tx] [-lh num]"
+          " path [bnum [apow [fpow]]]\n", g_progname);
   fprintf(stderr, "  %s inform [-nl|-nb] path\n", g_progname);
   fprintf(stderr, "  %s put [-nl|-nb] [-sx] [-dk|-dc|-dai|-dad] path key value\n", g_progname);
   fprintf(stderr, "  %s out [-nl|-nb] [-sx] path key\n", g_progname);
   fprintf(stderr, "  %s get [-nl|-nb] [-sx] [-px] [-pz] path key\n", g_progname);
   fprintf(stderr, "  %s list [-nl|-nb] [-m num] [-pv] [-px] [-fm str] path\n", g_progname);
-  fprintf(stderr, "  %s optimize [-tl] [-td|-tb|-tt|-tx] [-tz] [-nl|-nb] [-df]"
+  fprintf(stderr, "  %s optimize [-tl] [-tf] [-td|-tb|-tt|-ts|-tx] [-tz] [-nl|-nb] [-df] [-th num]"
           " path [bnum [apow [fpow]]]\n", g_progname);
   fprintf(stderr, "  %s importtsv [-nl|-nb] [-sc] path [file]\n", g_progname);
+  fprintf(stderr, "  %s bulkload [-tl] [-tf] [-fr num] [-td|-tb|-tt|-ts|-tx] [-lh num] [-vl num]"
+          " [-xt num] [-sc] path [file [bnum [apow [fpow]]]]\n", g_progname);
   fprintf(stderr, "  %s version\n", g_progname);
   fprintf(stderr, "\n");
   exit(1);
@@ -157,6 +176,39 @@ static char *mygetline(FILE *ifp){
 }
 
 
+/* feed the next record of a TSV stream to the bulk loader */
+static const void *bulkfeed(int *ksp, const void **vbp, int *vsp, int64_t *xtp, void *op){
+  BULKFEED *feed = op;
+  if(feed->line){
+    tcfree(feed->line);
+    feed->line = NULL;
+  }
+  char *line;
+  while((line = mygetline(feed->ifp)) != NULL){
+    char *pv = strchr(line, '\t');
+    if(!pv){
+      tcfree(line);
+      continue;
+    }
+    *pv = '\0';
+    if(feed->sc) tcstrutfnorm(line, TCUNSPACE | TCUNLOWER | TCUNNOACC | TCUNWIDTH);
+    feed->line = line;
+    *ksp = strlen(line);
+    *vbp = pv + 1;
+    *vsp = strlen(pv + 1);
+    *xtp = feed->xt;
+    if(feed->cnt > 0 && feed->cnt % 100 == 0){
+      putchar('.');
+      fflush(stdout);
+      if(feed->cnt % 5000 == 0) printf(" (%08d)\n", feed->cnt);
+    }
+    feed->cnt++;
+    return line;
+  }
+  return NULL;
+}
+
+
 /* parse arguments of create command */
 static int runcreate(int argc, char **argv){
   char *path = NULL;
@@ -164,6 +216,8 @@ static int runcreate(int argc, char **argv){
   char *astr = NULL;
   char *fstr = NULL;
   int opts = 0;
+  int lhnum = 0;
+  double fprate = 0;
   for(int i = 2; i < argc; i++){
     if(!path && argv[i][0] == '-'){
       if(!strcmp(argv[i], "-tl")){
@@ -174,8 +228,18 @@ static int runcreate(int argc, char **argv){
         opts |= HDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= HDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= HDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= HDBTEXCODEC;
+      } else if(!strcmp(argv[i], "-tf")){
+        opts |= HDBTFPRINT;
+      } else if(!strcmp(argv[i], "-fr")){
+        if(++i >= argc) usage();
+        fprate = tcatof(argv[i]);
+      } else if(!strcmp(argv[i], "-lh")){
+        if(++i >= argc) usage();
+        lhnum = tcatoix(argv[i]);
       } else {
         usage();
       }
@@ -195,7 +259,7 @@ static int runcreate(int argc, char **argv){
   int bnum = bstr ? tcatoix(bstr) : -1;
   int apow = astr ? tcatoix(astr) : -1;
   int fpow = fstr ? tcatoix(fstr) : -1;
-  int rv = proccreate(path, bnum, apow, fpow, opts);
+  int rv = proccreate(path, bnum, apow, fpow, opts, lhnum, fprate);
   return rv;
 }
 
@@ -415,6 +479,7 @@ static int runoptimize(int argc, char **argv){
   int opts = UINT8_MAX;
   int omode = 0;
   bool df = false;
+  int tnum = 0;
   for(int i = 2; i < argc; i++){
     if(!path && argv[i][0] == '-'){
       if(!strcmp(argv[i], "-tl")){
@@ -429,9 +494,15 @@ static int runoptimize(int argc, char **argv){
       } else if(!strcmp(argv[i], "-tt")){
         if(opts == UINT8_MAX) opts = 0;
         opts |= HDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        if(opts == UINT8_MAX) opts = 0;
+        opts |= HDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         if(opts == UINT8_MAX) opts = 0;
         opts |= HDBTEXCODEC;
+      } else if(!strcmp(argv[i], "-tf")){
+        if(opts == UINT8_MAX) opts = 0;
+        opts |= HDBTFPRINT;
       } else if(!strcmp(argv[i], "-tz")){
         if(opts == UINT8_MAX) opts = 0;
       } else if(!strcmp(argv[i], "-nl")){
@@ -440,6 +511,9 @@ static int runoptimize(int argc, char **argv){
         omode |= HDBOLCKNB;
       } else if(!strcmp(argv[i], "-df")){
         df = true;
+      } else if(!strcmp(argv[i], "-th")){
+        if(++i >= argc) usage();
+        tnum = tcatoix(argv[i]);
       } else {
         usage();
       }
@@ -459,7 +533,7 @@ static int runoptimize(int argc, char **argv){
   int bnum = bstr ? tcatoix(bstr) : -1;
   int apow = astr ? tcatoix(astr) : -1;
   int fpow = fstr ? tcatoix(fstr) : -1;
-  int rv = procoptimize(path, bnum, apow, fpow, opts, omode, df);
+  int rv = procoptimize(path, bnum, apow, fpow, opts, omode, df, tnum);
   return rv;
 }
 
@@ -495,6 +569,75 @@ static int runimporttsv(int argc, char **argv){
 }
 
 
+/* parse arguments of bulkload command */
+static int runbulkload(int argc, char **argv){
+  char *path = NULL;
+  char *file = NULL;
+  char *bstr = NULL;
+  char *astr = NULL;
+  char *fstr = NULL;
+  int opts = 0;
+  int lhnum = 0;
+  double fprate = 0;
+  int vlthres = 0;
+  int64_t xt = 0;
+  bool sc = false;
+  for(int i = 2; i < argc; i++){
+    if(!path && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-tl")){
+        opts |= HDBTLARGE;
+      } else if(!strcmp(argv[i], "-td")){
+        opts |= HDBTDEFLATE;
+      } else if(!strcmp(argv[i], "-tb")){
+        opts |= HDBTBZIP;
+      } else if(!strcmp(argv[i], "-tt")){
+        opts |= HDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= HDBTLZ;
+      } else if(!strcmp(argv[i], "-tx")){
+        opts |= HDBTEXCODEC;
+      } else if(!strcmp(argv[i], "-tf")){
+        opts |= HDBTFPRINT;
+      } else if(!strcmp(argv[i], "-fr")){
+        if(++i >= argc) usage();
+        fprate = tcatof(argv[i]);
+      } else if(!strcmp(argv[i], "-lh")){
+        if(++i >= argc) usage();
+        lhnum = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-vl")){
+        if(++i >= argc) usage();
+        vlthres = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-xt")){
+        if(++i >= argc) usage();
+        xt = tcatoi(argv[i]);
+      } else if(!strcmp(argv[i], "-sc")){
+        sc = true;
+      } else {
+        usage();
+      }
+    } else if(!path){
+      path = argv[i];
+    } else if(!file){
+      file = argv[i];
+    } else if(!bstr){
+      bstr = argv[i];
+    } else if(!astr){
+      astr = argv[i];
+    } else if(!fstr){
+      fstr = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if(!path) usage();
+  int bnum = bstr ? tcatoix(bstr) : -1;
+  int apow = astr ? tcatoix(astr) : -1;
+  int fpow = fstr ? tcatoix(fstr) : -1;
+  int rv = procbulkload(path, file, bnum, apow, fpow, opts, lhnum, fprate, vlthres, xt, sc);
+  return rv;
+}
+
+
 /* parse arguments of version command */
 static int runversion(int argc, char **argv){
   int rv = procversion();
@@ -503,7 +646,8 @@ static int runversion(int argc, char **argv){
 
 
 /* perform create command */
-static int proccreate(const char *path, int bnum, int apow, int fpow, int opts){
+static int proccreate(const char *path, int bnum, int apow, int fpow, int opts, int lhnum,
+                      double fprate){
   TCHDB *hdb = tchdbnew();
   if(g_dbgfd >= 0) tchdbsetdbgfd(hdb, g_dbgfd);
   if(!tchdbsetcodecfunc(hdb, _tc_recencode, NULL, _tc_recdecode, NULL)) printerr(hdb);
@@ -512,6 +656,16 @@ static int proccreate(const char *path, int bnum, int apow, int fpow, int opts){
     tchdbdel(hdb);
     return 1;
   }
+  if(lhnum > 0 && !tchdbsetlinear(hdb, lhnum)){
+    printerr(hdb);
+    tchdbdel(hdb);
+    return 1;
+  }
+  if(fprate > 0 && !tchdbsetfprate(hdb, fprate)){
+    printerr(hdb);
+    tchdbdel(hdb);
+    return 1;
+  }
   if(!tchdbopen(hdb, path, HDBOWRITER | HDBOCREAT | HDBOTRUNC)){
     printerr(hdb);
     tchdbdel(hdb);
@@ -553,8 +707,11 @@ static int procinform(const char *path, int omode){
   printf("additional flags:");
   if(flags & HDBFOPEN) printf(" open");
   if(flags & HDBFFATAL) printf(" fatal");
+  if(flags & HDBFEXPIRE) printf(" expire");
   printf("\n");
   printf("bucket number: %llu\n", (unsigned long long)tchdbbnum(hdb));
+  if(hdb->lhmod > 0)
+    printf("active bucket number: %llu\n", (unsigned long long)tchdbbnumactive(hdb));
   if(hdb->cnt_writerec >= 0)
     printf("used bucket number: %lld\n", (long long)tchdbbnumused(hdb));
   printf("alignment: %u\n", tchdbalign(hdb));
@@ -569,7 +726,9 @@ static int procinform(const char *path, int omode){
   if(opts & HDBTDEFLATE) printf(" deflate");
   if(opts & HDBTBZIP) printf(" bzip");
   if(opts & HDBTTCBS) printf(" tcbs");
+  if(opts & HDBTLZ) printf(" lz");
   if(opts & HDBTEXCODEC) printf(" excodec");
+  if(opts & HDBTFPRINT) printf(" fprint");
   printf("\n");
   printf("record number: %llu\n", (unsigned long long)tchdbrnum(hdb));
   printf("file size: %llu\n", (unsigned long long)tchdbfsiz(hdb));
@@ -757,10 +916,11 @@ static int proclist(const char *path, int omode, int max, bool pv, bool px, cons
 
 /* perform optimize command */
 static int procoptimize(const char *path, int bnum, int apow, int fpow, int opts, int omode,
-                        bool df){
+                        bool df, int tnum){
   TCHDB *hdb = tchdbnew();
   if(g_dbgfd >= 0) tchdbsetdbgfd(hdb, g_dbgfd);
   if(!tchdbsetcodecfunc(hdb, _tc_recencode, NULL, _tc_recdecode, NULL)) printerr(hdb);
+  if(tnum > 0 && !tchdbsetoptthreads(hdb, tnum)) printerr(hdb);
   if(!tchdbopen(hdb, path, HDBOWRITER | omode)){
     printerr(hdb);
     tchdbdel(hdb);
@@ -837,6 +997,45 @@ static int procimporttsv(const char *path, const char *file, int omode, bool sc)
 }
 
 
+/* perform bulkload command */
+static int procbulkload(const char *path, const char *file, int bnum, int apow, int fpow,
+                        int opts, int lhnum, double fprate, int vlthres, int64_t xt, bool sc){
+  FILE *ifp = file ? fopen(file, "rb") : stdin;
+  if(!ifp){
+    fprintf(stderr, "%s: could not open\n", file ? file : "(stdin)");
+    return 1;
+  }
+  TCHDB *hdb = tchdbnew();
+  if(g_dbgfd >= 0) tchdbsetdbgfd(hdb, g_dbgfd);
+  if(!tchdbsetcodecfunc(hdb, _tc_recencode, NULL, _tc_recdecode, NULL)) printerr(hdb);
+  if(!tchdbtune(hdb, bnum, apow, fpow, opts) ||
+     (lhnum > 0 && !tchdbsetlinear(hdb, lhnum)) ||
+     (fprate > 0 && !tchdbsetfprate(hdb, fprate)) ||
+     (vlthres > 0 && !tchdbsetvlog(hdb, vlthres))){
+    printerr(hdb);
+    tchdbdel(hdb);
+    if(ifp != stdin) fclose(ifp);
+    return 1;
+  }
+  bool err = false;
+  BULKFEED feed;
+  feed.ifp = ifp;
+  feed.line = NULL;
+  feed.sc = sc;
+  feed.xt = xt;
+  feed.cnt = 0;
+  if(!tchdbbulkload(hdb, path, bulkfeed, &feed)){
+    printerr(hdb);
+    err = true;
+  }
+  if(feed.line) tcfree(feed.line);
+  printf(" (%08d)\n", feed.cnt);
+  tchdbdel(hdb);
+  if(ifp != stdin) fclose(ifp);
+  return err ? 1 : 0;
+}
+
+
 /* perform version command */
 static int procversion(void){
   printf("Tokyo Cabinet version %s (%d:%s) for %s\n",
@@ -36,6 +36,16 @@ typedef struct {                         // type of structure for read thread
   int id;
 } TARGREAD;
 
+typedef struct {                         // type of structure for partition thread
+  TCHDB *hdb;
+  uint64_t beg;
+  uint64_t end;
+  int64_t cnt;
+  int rnum;
+  volatile bool *stop;
+  int id;
+} TARGPART;
+
 typedef struct {                         // type of structure for remove thread
   TCHDB *hdb;
   int rnum;
@@ -56,6 +66,7 @@ typedef struct {                         // type of structure for typical thread
   int rnum;
   bool nc;
   int rratio;
+  bool as;
   int id;
 } TARGTYPICAL;
 
@@ -65,6 +76,12 @@ typedef struct {                         // type of structure for race thread
   int id;
 } TARGRACE;
 
+typedef struct {                         // type of structure for backup thread
+  TCHDB *hdb;
+  int rnum;
+  int id;
+} TARGBACKUP;
+
 
 /* global variables */
 const char *g_progname;                  // program name
@@ -83,30 +100,41 @@ static void sysprint(void);
 static int myrand(int range);
 static int myrandnd(int range);
 static bool iterfunc(const void *kbuf, int ksiz, const void *vbuf, int vsiz, void *op);
+static bool partfunc(const void *kbuf, int ksiz, const void *vbuf, int vsiz, void *op);
+static int backupval(char *buf, int id, int num);
+static bool checkbackup(const char *path, int tnum, int rnum, bool full);
 static int runwrite(int argc, char **argv);
 static int runread(int argc, char **argv);
 static int runremove(int argc, char **argv);
 static int runwicked(int argc, char **argv);
 static int runtypical(int argc, char **argv);
 static int runrace(int argc, char **argv);
+static int runbackup(int argc, char **argv);
 static int procwrite(const char *path, int tnum, int rnum, int bnum, int apow, int fpow,
-                     int opts, int rcnum, int xmsiz, int dfunit, int omode, bool as, bool rnd);
+                     int opts, int rcnum, int xmsiz, int dfunit, int lhnum, int omode, bool as,
+                     int awqnum, bool rnd);
 static int procread(const char *path, int tnum, int rcnum, int xmsiz, int dfunit, int omode,
-                    bool wb, bool rnd);
+                    bool wb, bool rnd, bool pt, bool pw);
 static int procremove(const char *path, int tnum, int rcnum, int xmsiz, int dfunit, int omode,
                       bool rnd);
-static int procwicked(const char *path, int tnum, int rnum, int opts, int omode, bool nc);
+static int procwicked(const char *path, int tnum, int rnum, int opts, int omode, bool nc,
+                      int gcwait);
 static int proctypical(const char *path, int tnum, int rnum, int bnum, int apow, int fpow,
-                       int opts, int rcnum, int xmsiz, int dfunit, int omode,
-                       bool nc, int rratio);
+                       int opts, int rcnum, int xmsiz, int dfunit, int dfbps, int lknum,
+                       int awqnum, int omode, bool nc, int rratio);
 static int procrace(const char *path, int tnum, int rnum, int bnum, int apow, int fpow,
                     int opts, int xmsiz, int dfunit, int omode);
+static int procbackup(const char *path, int tnum, int rnum, int bnum, int apow, int fpow,
+                      int opts, int xmsiz, int dfunit, int vlthres, int omode);
 static void *threadwrite(void *targ);
 static void *threadread(void *targ);
+static void *threadpart(void *targ);
+static void *threadpartwrite(void *targ);
 static void *threadremove(void *targ);
 static void *threadwicked(void *targ);
 static void *threadtypical(void *targ);
 static void *threadrace(void *targ);
+static void *threadbackup(void *targ);
 
 
 /* main routine */
@@ -131,6 +159,8 @@ int main(int argc, char **argv){
     rv = runtypical(argc, argv);
   } else if(!strcmp(argv[1], "race")){
     rv = runrace(argc, argv);
+  } else if(!strcmp(argv[1], "backup")){
+    rv = runbackup(argc, argv);
   } else {
     usage();
   }
@@ -150,17 +180,22 @@ static void usage(void){
   fprintf(stderr, "%s: test cases of the hash database API of Tokyo Cabinet\n", g_progname);
   fprintf(stderr, "\n");
   fprintf(stderr, "usage:\n");
-  fprintf(stderr, "  %s write [-tl] [-td|-tb|-tt|-tx] [-rc num] [-xm num] [-df num]"
-          " [-nl|-nb] [-as] [-rnd] path tnum rnum [bnum [apow [fpow]]]\n", g_progname);
-  fprintf(stderr, "  %s read [-rc num] [-xm num] [-df num] [-nl|-nb] [-wb] [-rnd] path tnum\n",
+  fprintf(stderr, "  %s write [-tl] [-td|-tb|-tt|-ts|-tx] [-rc num] [-xm num] [-df num]"
+          " [-lh num] [-nl|-nb] [-as] [-aw num] [-rnd] path tnum rnum [bnum [apow [fpow]]]\n",
+          g_progname);
+  fprintf(stderr, "  %s read [-rc num] [-xm num] [-df num] [-nl|-nb] [-wb] [-rnd] [-pt] [-pw]"
+          " path tnum\n",
           g_progname);
   fprintf(stderr, "  %s remove [-rc num] [-xm num] [-df num] [-nl|-nb] [-rnd] path tnum\n",
           g_progname);
-  fprintf(stderr, "  %s wicked [-tl] [-td|-tb|-tt|-tx] [-nl|-nb] [-nc]"
-          " path tnum rnum\n", g_progname);
-  fprintf(stderr, "  %s typical [-tl] [-td|-tb|-tt|-tx] [-rc num] [-xm num] [-df num]"
-          " [-nl|-nb] [-nc] [-rr num] path tnum rnum [bnum [apow [fpow]]]\n", g_progname);
-  fprintf(stderr, "  %s race [-tl] [-td|-tb|-tt|-tx] [-xm num] [-df num] [-nl|-nb]"
+  fprintf(stderr, "  %s wicked [-tl] [-td|-tb|-tt|-ts|-tx] [-nl|-nb] [-nc] [-gc num] [-ss]"
+          " [-rd] [-ap] path tnum rnum\n", g_progname);
+  fprintf(stderr, "  %s typical [-tl] [-td|-tb|-tt|-ts|-tx] [-rc num] [-xm num] [-df num] [-bd num]"
+          " [-lk num] [-aw num] [-nl|-nb] [-nc] [-rr num] path tnum rnum [bnum [apow [fpow]]]\n",
+          g_progname);
+  fprintf(stderr, "  %s race [-tl] [-td|-tb|-tt|-ts|-tx] [-xm num] [-df num] [-nl|-nb]"
+          " path tnum rnum [bnum [apow [fpow]]]\n", g_progname);
+  fprintf(stderr, "  %s backup [-tl] [-td|-tb|-tt|-ts|-tx] [-xm num] [-df num] [-vl num] [-nl|-nb]"
           " path tnum rnum [bnum [apow [fpow]]]\n", g_progname);
   fprintf(stderr, "\n");
   exit(1);
@@ -262,6 +297,89 @@ static bool iterfunc(const void *kbuf, int ksiz, const void *vbuf, int vsiz, voi
 }
 
 
+/* partition iterator function */
+static bool partfunc(const void *kbuf, int ksiz, const void *vbuf, int vsiz, void *op){
+  (*(int64_t *)op)++;
+  return true;
+}
+
+
+/* make the value of a record of the backup test */
+static int backupval(char *buf, int id, int num){
+  int len = sprintf(buf, "%d-%d:", id, num);
+  int vsiz = len + (num * 37) % 300;
+  memset(buf + len, 'a' + num % 26, vsiz - len);
+  return vsiz;
+}
+
+
+/* check a backup file made by the backup test */
+static bool checkbackup(const char *path, int tnum, int rnum, bool full){
+  bool err = false;
+  TCHDB *hdb = tchdbnew();
+  if(!tchdbsetcodecfunc(hdb, _tc_recencode, NULL, _tc_recdecode, NULL)){
+    eprint(hdb, __LINE__, "tchdbsetcodecfunc");
+    err = true;
+  }
+  if(!tchdbopen(hdb, path, HDBOREADER)){
+    eprint(hdb, __LINE__, "tchdbopen");
+    tchdbdel(hdb);
+    return false;
+  }
+  int64_t cnt = 0;
+  for(int t = 0; !err && t < tnum; t++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "%d", t);
+    char *cstr = tchdbget2(hdb, kbuf);
+    int cnum = cstr ? tcatoi(cstr) : 0;
+    tcfree(cstr);
+    if(cnum > 0) cnt++;
+    if(full && cnum != rnum){
+      eprint(hdb, __LINE__, "(validation)");
+      err = true;
+    }
+    for(int i = 1; !err && i <= rnum; i++){
+      ksiz = sprintf(kbuf, "%d-%d", t, i);
+      int vsiz;
+      char *vbuf = tchdbget(hdb, kbuf, ksiz, &vsiz);
+      if(vbuf) cnt++;
+      bool exist;
+      if(i < cnum){
+        exist = (i + 1) % 3 != 0;
+      } else if(i > cnum + 1){
+        exist = false;
+      } else {
+        exist = vbuf != NULL;
+      }
+      if(exist != (vbuf != NULL)){
+        eprint(hdb, __LINE__, "(validation)");
+        err = true;
+      } else if(vbuf){
+        char ebuf[RECBUFSIZ*8];
+        int esiz = backupval(ebuf, t, i);
+        if(vsiz != esiz || memcmp(vbuf, ebuf, esiz)){
+          eprint(hdb, __LINE__, "(validation)");
+          err = true;
+        }
+      }
+      tcfree(vbuf);
+    }
+  }
+  if(!err && tchdbrnum(hdb) != cnt){
+    eprint(hdb, __LINE__, "(validation)");
+    err = true;
+  }
+  iprintf("backup: %s: rnum=%llu fsiz=%llu\n", path,
+          (unsigned long long)tchdbrnum(hdb), (unsigned long long)tchdbfsiz(hdb));
+  if(!tchdbclose(hdb)){
+    eprint(hdb, __LINE__, "tchdbclose");
+    err = true;
+  }
+  tchdbdel(hdb);
+  return !err;
+}
+
+
 /* parse arguments of write command */
 static int runwrite(int argc, char **argv){
   char *path = NULL;
@@ -274,8 +392,10 @@ static int runwrite(int argc, char **argv){
   int rcnum = 0;
   int xmsiz = -1;
   int dfunit = 0;
+  int lhnum = 0;
   int omode = 0;
   bool as = false;
+  int awqnum = 0;
   bool rnd = false;
   for(int i = 2; i < argc; i++){
     if(!path && argv[i][0] == '-'){
@@ -287,6 +407,8 @@ static int runwrite(int argc, char **argv){
         opts |= HDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= HDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= HDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= HDBTEXCODEC;
       } else if(!strcmp(argv[i], "-rc")){
@@ -298,12 +420,19 @@ static int runwrite(int argc, char **argv){
       } else if(!strcmp(argv[i], "-df")){
         if(++i >= argc) usage();
         dfunit = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-lh")){
+        if(++i >= argc) usage();
+        lhnum = tcatoix(argv[i]);
       } else if(!strcmp(argv[i], "-nl")){
         omode |= HDBONOLCK;
       } else if(!strcmp(argv[i], "-nb")){
         omode |= HDBOLCKNB;
       } else if(!strcmp(argv[i], "-as")){
         as = true;
+      } else if(!strcmp(argv[i], "-aw")){
+        if(++i >= argc) usage();
+        awqnum = tcatoix(argv[i]);
+        as = true;
       } else if(!strcmp(argv[i], "-rnd")){
         rnd = true;
       } else {
@@ -332,8 +461,8 @@ static int runwrite(int argc, char **argv){
   int bnum = bstr ? tcatoix(bstr) : -1;
   int apow = astr ? tcatoix(astr) : -1;
   int fpow = fstr ? tcatoix(fstr) : -1;
-  int rv = procwrite(path, tnum, rnum, bnum, apow, fpow, opts, rcnum, xmsiz, dfunit, omode,
-                     as, rnd);
+  int rv = procwrite(path, tnum, rnum, bnum, apow, fpow, opts, rcnum, xmsiz, dfunit, lhnum,
+                     omode, as, awqnum, rnd);
   return rv;
 }
 
@@ -348,6 +477,8 @@ static int runread(int argc, char **argv){
   int omode = 0;
   bool wb = false;
   bool rnd = false;
+  bool pt = false;
+  bool pw = false;
   for(int i = 2; i < argc; i++){
     if(!path && argv[i][0] == '-'){
       if(!strcmp(argv[i], "-rc")){
@@ -367,6 +498,11 @@ static int runread(int argc, char **argv){
         wb = true;
       } else if(!strcmp(argv[i], "-rnd")){
         rnd = true;
+      } else if(!strcmp(argv[i], "-pt")){
+        pt = true;
+      } else if(!strcmp(argv[i], "-pw")){
+        pt = true;
+        pw = true;
       } else {
         usage();
       }
@@ -381,7 +517,7 @@ static int runread(int argc, char **argv){
   if(!path || !tstr) usage();
   int tnum = tcatoix(tstr);
   if(tnum < 1) usage();
-  int rv = procread(path, tnum, rcnum, xmsiz, dfunit, omode, wb, rnd);
+  int rv = procread(path, tnum, rcnum, xmsiz, dfunit, omode, wb, rnd, pt, pw);
   return rv;
 }
 
@@ -439,6 +575,7 @@ static int runwicked(int argc, char **argv){
   int opts = 0;
   int omode = 0;
   bool nc = false;
+  int gcwait = 0;
   for(int i = 2; i < argc; i++){
     if(!path && argv[i][0] == '-'){
       if(!strcmp(argv[i], "-tl")){
@@ -449,6 +586,8 @@ static int runwicked(int argc, char **argv){
         opts |= HDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= HDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= HDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= HDBTEXCODEC;
       } else if(!strcmp(argv[i], "-nl")){
@@ -457,6 +596,16 @@ static int runwicked(int argc, char **argv){
         omode |= HDBOLCKNB;
       } else if(!strcmp(argv[i], "-nc")){
         nc = true;
+      } else if(!strcmp(argv[i], "-gc")){
+        if(++i >= argc) usage();
+        gcwait = tcatoix(argv[i]);
+        omode |= HDBOTSYNC;
+      } else if(!strcmp(argv[i], "-ss")){
+        omode |= HDBOSNAPSHOT;
+      } else if(!strcmp(argv[i], "-rd")){
+        omode |= HDBOREDO;
+      } else if(!strcmp(argv[i], "-ap")){
+        omode |= HDBOAPPEND;
       } else {
         usage();
       }
@@ -474,7 +623,7 @@ static int runwicked(int argc, char **argv){
   int tnum = tcatoix(tstr);
   int rnum = tcatoix(rstr);
   if(tnum < 1 || rnum < 1) usage();
-  int rv = procwicked(path, tnum, rnum, opts, omode, nc);
+  int rv = procwicked(path, tnum, rnum, opts, omode, nc, gcwait);
   return rv;
 }
 
@@ -491,6 +640,9 @@ static int runtypical(int argc, char **argv){
   int rcnum = 0;
   int xmsiz = -1;
   int dfunit = 0;
+  int dfbps = 0;
+  int lknum = 0;
+  int awqnum = 0;
   int omode = 0;
   int rratio = -1;
   bool nc = false;
@@ -504,6 +656,8 @@ static int runtypical(int argc, char **argv){
         opts |= HDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= HDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= HDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= HDBTEXCODEC;
       } else if(!strcmp(argv[i], "-rc")){
@@ -515,6 +669,15 @@ static int runtypical(int argc, char **argv){
       } else if(!strcmp(argv[i], "-df")){
         if(++i >= argc) usage();
         dfunit = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-bd")){
+        if(++i >= argc) usage();
+        dfbps = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-lk")){
+        if(++i >= argc) usage();
+        lknum = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-aw")){
+        if(++i >= argc) usage();
+        awqnum = tcatoix(argv[i]);
       } else if(!strcmp(argv[i], "-nl")){
         omode |= HDBONOLCK;
       } else if(!strcmp(argv[i], "-nb")){
@@ -550,8 +713,8 @@ static int runtypical(int argc, char **argv){
   int bnum = bstr ? tcatoix(bstr) : -1;
   int apow = astr ? tcatoix(astr) : -1;
   int fpow = fstr ? tcatoix(fstr) : -1;
-  int rv = proctypical(path, tnum, rnum, bnum, apow, fpow, opts, rcnum, xmsiz, dfunit, omode,
-                       nc, rratio);
+  int rv = proctypical(path, tnum, rnum, bnum, apow, fpow, opts, rcnum, xmsiz, dfunit, dfbps,
+                       lknum, awqnum, omode, nc, rratio);
   return rv;
 }
 
@@ -578,6 +741,8 @@ static int runrace(int argc, char **argv){
         opts |= HDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= HDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= HDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= HDBTEXCODEC;
       } else if(!strcmp(argv[i], "-xm")){
@@ -621,13 +786,85 @@ static int runrace(int argc, char **argv){
 }
 
 
+/* parse arguments of backup command */
+static int runbackup(int argc, char **argv){
+  char *path = NULL;
+  char *tstr = NULL;
+  char *rstr = NULL;
+  char *bstr = NULL;
+  char *astr = NULL;
+  char *fstr = NULL;
+  int opts = 0;
+  int xmsiz = -1;
+  int dfunit = 0;
+  int vlthres = 0;
+  int omode = 0;
+  for(int i = 2; i < argc; i++){
+    if(!path && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-tl")){
+        opts |= HDBTLARGE;
+      } else if(!strcmp(argv[i], "-td")){
+        opts |= HDBTDEFLATE;
+      } else if(!strcmp(argv[i], "-tb")){
+        opts |= HDBTBZIP;
+      } else if(!strcmp(argv[i], "-tt")){
+        opts |= HDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= HDBTLZ;
+      } else if(!strcmp(argv[i], "-tx")){
+        opts |= HDBTEXCODEC;
+      } else if(!strcmp(argv[i], "-xm")){
+        if(++i >= argc) usage();
+        xmsiz = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-df")){
+        if(++i >= argc) usage();
+        dfunit = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-vl")){
+        if(++i >= argc) usage();
+        vlthres = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-nl")){
+        omode |= HDBONOLCK;
+      } else if(!strcmp(argv[i], "-nb")){
+        omode |= HDBOLCKNB;
+      } else {
+        usage();
+      }
+    } else if(!path){
+      path = argv[i];
+    } else if(!tstr){
+      tstr = argv[i];
+    } else if(!rstr){
+      rstr = argv[i];
+    } else if(!bstr){
+      bstr = argv[i];
+    } else if(!astr){
+      astr = argv[i];
+    } else if(!fstr){
+      fstr = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if(!path || !tstr || !rstr) usage();
+  int tnum = tcatoix(tstr);
+  int rnum = tcatoix(rstr);
+  if(tnum < 1 || rnum < 1) usage();
+  int bnum = bstr ? tcatoix(bstr) : -1;
+  int apow = astr ? tcatoix(astr) : -1;
+  int fpow = fstr ? tcatoix(fstr) : -1;
+  int rv = procbackup(path, tnum, rnum, bnum, apow, fpow, opts, xmsiz, dfunit, vlthres, omode);
+  return rv;
+}
+
+
 /* perform write command */
 static int procwrite(const char *path, int tnum, int rnum, int bnum, int apow, int fpow,
-                     int opts, int rcnum, int xmsiz, int dfunit, int omode, bool as, bool rnd){
+                     int opts, int rcnum, int xmsiz, int dfunit, int lhnum, int omode, bool as,
+                     int awqnum, bool rnd){
   iprintf("<Writing Test>\n  seed=%u  path=%s  tnum=%d  rnum=%d  bnum=%d  apow=%d  fpow=%d"
-          "  opts=%d  rcnum=%d  xmsiz=%d  dfunit=%d  omode=%d  as=%d  rnd=%d\n\n",
-          g_randseed, path, tnum, rnum, bnum, apow, fpow, opts, rcnum, xmsiz, dfunit, omode,
-          as, rnd);
+          "  opts=%d  rcnum=%d  xmsiz=%d  dfunit=%d  lhnum=%d  omode=%d  as=%d  awqnum=%d"
+          "  rnd=%d\n\n", g_randseed, path, tnum, rnum, bnum, apow, fpow, opts, rcnum, xmsiz,
+          dfunit, lhnum, omode, as, awqnum, rnd);
   bool err = false;
   double stime = tctime();
   TCHDB *hdb = tchdbnew();
@@ -656,6 +893,14 @@ static int procwrite(const char *path, int tnum, int rnum, int bnum, int apow, i
     eprint(hdb, __LINE__, "tchdbsetdfunit");
     err = true;
   }
+  if(lhnum > 0 && !tchdbsetlinear(hdb, lhnum)){
+    eprint(hdb, __LINE__, "tchdbsetlinear");
+    err = true;
+  }
+  if(awqnum > 0 && !tchdbsetasyncwriter(hdb, awqnum)){
+    eprint(hdb, __LINE__, "tchdbsetasyncwriter");
+    err = true;
+  }
   if(!tchdbopen(hdb, path, HDBOWRITER | HDBOCREAT | HDBOTRUNC | omode)){
     eprint(hdb, __LINE__, "tchdbopen");
     err = true;
@@ -693,6 +938,19 @@ static int procwrite(const char *path, int tnum, int rnum, int bnum, int apow, i
       }
     }
   }
+  if(as && !tchdbasyncflush(hdb)){
+    eprint(hdb, __LINE__, "tchdbasyncflush");
+    err = true;
+  }
+  if(!err && tcstatsopnum(tchdbstats(hdb), TCSOPUT) != (uint64_t)tnum * rnum){
+    eprint(hdb, __LINE__, "tcstatsopnum");
+    err = true;
+  }
+  if(lhnum > 0 && tchdbbnumactive(hdb) < tchdbbnum(hdb) &&
+     tchdbrnum(hdb) > tchdbbnumactive(hdb) * 2){
+    eprint(hdb, __LINE__, "tchdbbnumactive");
+    err = true;
+  }
   iprintf("record number: %llu\n", (unsigned long long)tchdbrnum(hdb));
   iprintf("size: %llu\n", (unsigned long long)tchdbfsiz(hdb));
   mprint(hdb);
@@ -710,9 +968,10 @@ static int procwrite(const char *path, int tnum, int rnum, int bnum, int apow, i
 
 /* perform read command */
 static int procread(const char *path, int tnum, int rcnum, int xmsiz, int dfunit, int omode,
-                    bool wb, bool rnd){
+                    bool wb, bool rnd, bool pt, bool pw){
   iprintf("<Reading Test>\n  seed=%u  path=%s  tnum=%d  rcnum=%d  xmsiz=%d  dfunit=%d  omode=%d"
-          "  wb=%d  rnd=%d\n\n", g_randseed, path, tnum, rcnum, xmsiz, dfunit, omode, wb, rnd);
+          "  wb=%d  rnd=%d  pt=%d  pw=%d\n\n", g_randseed, path, tnum, rcnum, xmsiz, dfunit,
+          omode, wb, rnd, pt, pw);
   bool err = false;
   double stime = tctime();
   TCHDB *hdb = tchdbnew();
@@ -737,7 +996,7 @@ static int procread(const char *path, int tnum, int rcnum, int xmsiz, int dfunit
     eprint(hdb, __LINE__, "tchdbsetdfunit");
     err = true;
   }
-  if(!tchdbopen(hdb, path, HDBOREADER | omode)){
+  if(!tchdbopen(hdb, path, (pw ? HDBOWRITER : HDBOREADER) | omode)){
     eprint(hdb, __LINE__, "tchdbopen");
     err = true;
   }
@@ -775,6 +1034,78 @@ static int procread(const char *path, int tnum, int rcnum, int xmsiz, int dfunit
       }
     }
   }
+  if(pt && !err){
+    iprintf("scanning partitions:\n");
+    int pnum;
+    uint64_t *offs = tchdbpartition(hdb, tnum, &pnum);
+    if(offs){
+      int64_t ornum = tchdbrnum(hdb);
+      volatile bool stop = !pw;
+      TARGPART pargs[pnum];
+      pthread_t pthreads[pnum];
+      for(int i = 0; i < pnum; i++){
+        pargs[i].hdb = hdb;
+        pargs[i].beg = offs[i];
+        pargs[i].end = offs[i+1];
+        pargs[i].cnt = 0;
+        pargs[i].rnum = 0;
+        pargs[i].stop = pw ? &stop : NULL;
+        pargs[i].id = i;
+        if(pthread_create(pthreads + i, NULL, threadpart, pargs + i) != 0){
+          eprint(hdb, __LINE__, "pthread_create");
+          pargs[i].id = -1;
+          err = true;
+        }
+      }
+      if(pw){
+        TARGPART wargs[tnum];
+        pthread_t wthreads[tnum];
+        for(int i = 0; i < tnum; i++){
+          wargs[i].hdb = hdb;
+          wargs[i].rnum = rnum;
+          wargs[i].id = i;
+          if(pthread_create(wthreads + i, NULL, threadpartwrite, wargs + i) != 0){
+            eprint(hdb, __LINE__, "pthread_create");
+            wargs[i].id = -1;
+            err = true;
+          }
+        }
+        for(int i = 0; i < tnum; i++){
+          if(wargs[i].id == -1) continue;
+          void *rv;
+          if(pthread_join(wthreads[i], &rv) != 0){
+            eprint(hdb, __LINE__, "pthread_join");
+            err = true;
+          } else if(rv){
+            err = true;
+          }
+        }
+        stop = true;
+      }
+      int64_t cnt = 0;
+      for(int i = 0; i < pnum; i++){
+        if(pargs[i].id == -1) continue;
+        void *rv;
+        if(pthread_join(pthreads[i], &rv) != 0){
+          eprint(hdb, __LINE__, "pthread_join");
+          err = true;
+        } else if(rv){
+          err = true;
+        }
+        cnt += pargs[i].cnt;
+      }
+      iprintf("partition number: %d\n", pnum);
+      iprintf("scanned number: %lld\n", (long long)cnt);
+      if(!err && cnt != (pw ? ornum : tchdbrnum(hdb))){
+        eprint(hdb, __LINE__, "(validation)");
+        err = true;
+      }
+      tcfree(offs);
+    } else {
+      eprint(hdb, __LINE__, "tchdbpartition");
+      err = true;
+    }
+  }
   iprintf("record number: %llu\n", (unsigned long long)tchdbrnum(hdb));
   iprintf("size: %llu\n", (unsigned long long)tchdbfsiz(hdb));
   mprint(hdb);
@@ -871,9 +1202,10 @@ static int procremove(const char *path, int tnum, int rcnum, int xmsiz, int dfun
 
 
 /* perform wicked command */
-static int procwicked(const char *path, int tnum, int rnum, int opts, int omode, bool nc){
-  iprintf("<Writing Test>\n  seed=%u  path=%s  tnum=%d  rnum=%d  opts=%d  omode=%d  nc=%d\n\n",
-          g_randseed, path, tnum, rnum, opts, omode, nc);
+static int procwicked(const char *path, int tnum, int rnum, int opts, int omode, bool nc,
+                      int gcwait){
+  iprintf("<Writing Test>\n  seed=%u  path=%s  tnum=%d  rnum=%d  opts=%d  omode=%d  nc=%d"
+          "  gcwait=%d\n\n", g_randseed, path, tnum, rnum, opts, omode, nc, gcwait);
   bool err = false;
   double stime = tctime();
   TCHDB *hdb = tchdbnew();
@@ -902,6 +1234,10 @@ static int procwicked(const char *path, int tnum, int rnum, int opts, int omode,
     eprint(hdb, __LINE__, "tchdbsetdfunit");
     err = true;
   }
+  if(gcwait > 0 && !tchdbsetgcwait(hdb, gcwait / 1000000.0)){
+    eprint(hdb, __LINE__, "tchdbsetgcwait");
+    err = true;
+  }
   if(!tchdbopen(hdb, path, HDBOWRITER | HDBOCREAT | HDBOTRUNC | omode)){
     eprint(hdb, __LINE__, "tchdbopen");
     err = true;
@@ -1000,18 +1336,18 @@ static int procwicked(const char *path, int tnum, int rnum, int opts, int omode,
 
 /* perform typical command */
 static int proctypical(const char *path, int tnum, int rnum, int bnum, int apow, int fpow,
-                       int opts, int rcnum, int xmsiz, int dfunit, int omode,
-                       bool nc, int rratio){
+                       int opts, int rcnum, int xmsiz, int dfunit, int dfbps, int lknum,
+                       int awqnum, int omode, bool nc, int rratio){
   iprintf("<Typical Access Test>\n  seed=%u  path=%s  tnum=%d  rnum=%d  bnum=%d  apow=%d"
-          "  fpow=%d  opts=%d  rcnum=%d  xmsiz=%d  dfunit=%d  omode=%d  nc=%d  rratio=%d\n\n",
-          g_randseed, path, tnum, rnum, bnum, apow, fpow, opts, rcnum, xmsiz, dfunit, omode,
-          nc, rratio);
+          "  fpow=%d  opts=%d  rcnum=%d  xmsiz=%d  dfunit=%d  dfbps=%d  lknum=%d  awqnum=%d"
+          "  omode=%d  nc=%d  rratio=%d\n\n", g_randseed, path, tnum, rnum, bnum, apow, fpow,
+          opts, rcnum, xmsiz, dfunit, dfbps, lknum, awqnum, omode, nc, rratio);
   bool err = false;
   double stime = tctime();
   TCHDB *hdb = tchdbnew();
   if(g_dbgfd >= 0) tchdbsetdbgfd(hdb, g_dbgfd);
-  if(!tchdbsetmutex(hdb)){
-    eprint(hdb, __LINE__, "tchdbsetmutex");
+  if(!tchdbsetmutex2(hdb, lknum)){
+    eprint(hdb, __LINE__, "tchdbsetmutex2");
     err = true;
   }
   if(!tchdbsetcodecfunc(hdb, _tc_recencode, NULL, _tc_recdecode, NULL)){
@@ -1034,6 +1370,14 @@ static int proctypical(const char *path, int tnum, int rnum, int bnum, int apow,
     eprint(hdb, __LINE__, "tchdbsetdfunit");
     err = true;
   }
+  if(dfbps > 0 && !tchdbsetbgdefrag(hdb, dfbps)){
+    eprint(hdb, __LINE__, "tchdbsetbgdefrag");
+    err = true;
+  }
+  if(awqnum > 0 && !tchdbsetasyncwriter(hdb, awqnum)){
+    eprint(hdb, __LINE__, "tchdbsetasyncwriter");
+    err = true;
+  }
   if(!tchdbopen(hdb, path, HDBOWRITER | HDBOCREAT | HDBOTRUNC | omode)){
     eprint(hdb, __LINE__, "tchdbopen");
     err = true;
@@ -1045,6 +1389,7 @@ static int proctypical(const char *path, int tnum, int rnum, int bnum, int apow,
     targs[0].rnum = rnum;
     targs[0].nc = nc;
     targs[0].rratio = rratio;
+    targs[0].as = awqnum > 0;
     targs[0].id = 0;
     if(threadtypical(targs) != NULL) err = true;
   } else {
@@ -1053,6 +1398,7 @@ static int proctypical(const char *path, int tnum, int rnum, int bnum, int apow,
       targs[i].rnum = rnum;
       targs[i].nc = nc;
       targs[i].rratio= rratio;
+      targs[i].as = awqnum > 0;
       targs[i].id = i;
       if(pthread_create(threads + i, NULL, threadtypical, targs + i) != 0){
         eprint(hdb, __LINE__, "pthread_create");
@@ -1073,6 +1419,16 @@ static int proctypical(const char *path, int tnum, int rnum, int bnum, int apow,
   }
   iprintf("record number: %llu\n", (unsigned long long)tchdbrnum(hdb));
   iprintf("size: %llu\n", (unsigned long long)tchdbfsiz(hdb));
+  if(dfbps > 0){
+    uint64_t snum, bsiz, pnum;
+    if(tchdbbgdefragstat(hdb, &snum, &bsiz, &pnum)){
+      iprintf("background defragmentation: steps=%llu bytes=%llu passes=%llu\n",
+              (unsigned long long)snum, (unsigned long long)bsiz, (unsigned long long)pnum);
+    } else {
+      eprint(hdb, __LINE__, "tchdbbgdefragstat");
+      err = true;
+    }
+  }
   mprint(hdb);
   sysprint();
   if(!tchdbclose(hdb)){
@@ -1164,6 +1520,102 @@ static int procrace(const char *path, int tnum, int rnum, int bnum, int apow, in
 }
 
 
+/* perform backup command */
+static int procbackup(const char *path, int tnum, int rnum, int bnum, int apow, int fpow,
+                      int opts, int xmsiz, int dfunit, int vlthres, int omode){
+  iprintf("<Online Backup Test>\n  seed=%u  path=%s  tnum=%d  rnum=%d  bnum=%d  apow=%d"
+          "  fpow=%d  opts=%d  xmsiz=%d  dfunit=%d  vlthres=%d  omode=%d\n\n",
+          g_randseed, path, tnum, rnum, bnum, apow, fpow, opts, xmsiz, dfunit, vlthres, omode);
+  bool err = false;
+  double stime = tctime();
+  TCHDB *hdb = tchdbnew();
+  if(g_dbgfd >= 0) tchdbsetdbgfd(hdb, g_dbgfd);
+  if(!tchdbsetmutex(hdb)){
+    eprint(hdb, __LINE__, "tchdbsetmutex");
+    err = true;
+  }
+  if(!tchdbsetcodecfunc(hdb, _tc_recencode, NULL, _tc_recdecode, NULL)){
+    eprint(hdb, __LINE__, "tchdbsetcodecfunc");
+    err = true;
+  }
+  if(!tchdbtune(hdb, bnum, apow, fpow, opts)){
+    eprint(hdb, __LINE__, "tchdbtune");
+    err = true;
+  }
+  if(xmsiz >= 0 && !tchdbsetxmsiz(hdb, xmsiz)){
+    eprint(hdb, __LINE__, "tchdbsetxmsiz");
+    err = true;
+  }
+  if(dfunit >= 0 && !tchdbsetdfunit(hdb, dfunit)){
+    eprint(hdb, __LINE__, "tchdbsetdfunit");
+    err = true;
+  }
+  if(vlthres > 0 && !tchdbsetvlog(hdb, vlthres)){
+    eprint(hdb, __LINE__, "tchdbsetvlog");
+    err = true;
+  }
+  if(!tchdbopen(hdb, path, HDBOWRITER | HDBOCREAT | HDBOTRUNC | omode)){
+    eprint(hdb, __LINE__, "tchdbopen");
+    err = true;
+  }
+  char *bpath = tcsprintf("%s-backup", path);
+  TARGBACKUP targs[tnum];
+  pthread_t threads[tnum];
+  for(int i = 0; i < tnum; i++){
+    targs[i].hdb = hdb;
+    targs[i].rnum = rnum;
+    targs[i].id = i;
+    if(pthread_create(threads + i, NULL, threadbackup, targs + i) != 0){
+      eprint(hdb, __LINE__, "pthread_create");
+      targs[i].id = -1;
+      err = true;
+    }
+  }
+  for(int i = 0; !err && i < 3; i++){
+    tcsleep(0.01);
+    if(!tchdbbackup(hdb, bpath)){
+      eprint(hdb, __LINE__, "tchdbbackup");
+      err = true;
+    } else if(!checkbackup(bpath, tnum, rnum, false)){
+      err = true;
+    }
+  }
+  for(int i = 0; i < tnum; i++){
+    if(targs[i].id == -1) continue;
+    void *rv;
+    if(pthread_join(threads[i], &rv) != 0){
+      eprint(hdb, __LINE__, "pthread_join");
+      err = true;
+    } else if(rv){
+      err = true;
+    }
+  }
+  if(!tchdbbackup(hdb, bpath)){
+    eprint(hdb, __LINE__, "tchdbbackup");
+    err = true;
+  } else if(!checkbackup(bpath, tnum, rnum, true)){
+    err = true;
+  }
+  if(tchdbbackup(hdb, "@cp")){
+    eprint(hdb, __LINE__, "(validation)");
+    err = true;
+  }
+  tcfree(bpath);
+  iprintf("record number: %llu\n", (unsigned long long)tchdbrnum(hdb));
+  iprintf("size: %llu\n", (unsigned long long)tchdbfsiz(hdb));
+  mprint(hdb);
+  sysprint();
+  if(!tchdbclose(hdb)){
+    eprint(hdb, __LINE__, "tchdbclose");
+    err = true;
+  }
+  tchdbdel(hdb);
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
 /* thread the write function */
 static void *threadwrite(void *targ){
   TCHDB *hdb = ((TARGWRITE *)targ)->hdb;
@@ -1235,6 +1687,116 @@ static void *threadread(void *targ){
 }
 
 
+/* thread the partition function */
+static void *threadpart(void *targ){
+  TCHDB *hdb = ((TARGPART *)targ)->hdb;
+  uint64_t beg = ((TARGPART *)targ)->beg;
+  uint64_t end = ((TARGPART *)targ)->end;
+  volatile bool *stop = ((TARGPART *)targ)->stop;
+  int id = ((TARGPART *)targ)->id;
+  bool err = false;
+  int64_t cnt = 0;
+  if(stop){
+    TCXSTR *kxstr = tcxstrnew();
+    TCXSTR *vxstr = tcxstrnew();
+    int64_t ocnt = -1;
+    int pnum = 0;
+    // the passes are bounded as bucket splits of the writers wait for the readers to leave
+    do {
+      cnt = 0;
+      uint64_t cur = beg;
+      while(tchdbiternextpart(hdb, &cur, end, kxstr, vxstr)){
+        const char *kbuf = TCXSTRPTR(kxstr);
+        int ksiz = TCXSTRSIZE(kxstr);
+        const char *vbuf = TCXSTRPTR(vxstr);
+        int vsiz = TCXSTRSIZE(vxstr);
+        if(vsiz < ksiz || memcmp(vbuf, kbuf, ksiz) || (*kbuf != 'w' && vsiz != ksiz)){
+          eprint(hdb, __LINE__, "(validation)");
+          err = true;
+          break;
+        }
+        if(*kbuf != 'w') cnt++;
+      }
+      if(!err && tchdbecode(hdb) != TCENOREC){
+        eprint(hdb, __LINE__, "tchdbiternextpart");
+        err = true;
+      }
+      if(!err && ocnt >= 0 && cnt != ocnt){
+        eprint(hdb, __LINE__, "(validation)");
+        err = true;
+      }
+      ocnt = cnt;
+    } while(!err && !*stop && ++pnum < 8);
+    tcxstrdel(vxstr);
+    tcxstrdel(kxstr);
+  } else if(id % 2 == 0){
+    TCXSTR *kxstr = tcxstrnew();
+    TCXSTR *vxstr = tcxstrnew();
+    uint64_t cur = beg;
+    while(tchdbiternextpart(hdb, &cur, end, kxstr, vxstr)){
+      cnt++;
+    }
+    if(tchdbecode(hdb) != TCENOREC){
+      eprint(hdb, __LINE__, "tchdbiternextpart");
+      err = true;
+    }
+    tcxstrdel(vxstr);
+    tcxstrdel(kxstr);
+  } else if(!tchdbforeachpart(hdb, beg, end, partfunc, &cnt)){
+    eprint(hdb, __LINE__, "tchdbforeachpart");
+    err = true;
+  }
+  ((TARGPART *)targ)->cnt = cnt;
+  return err ? "error" : NULL;
+}
+
+
+/* thread the writing function during partitioned iteration */
+static void *threadpartwrite(void *targ){
+  TCHDB *hdb = ((TARGPART *)targ)->hdb;
+  int rnum = ((TARGPART *)targ)->rnum;
+  int id = ((TARGPART *)targ)->id;
+  bool err = false;
+  int range = rnum / 4 + 1;
+  for(int i = 1; i <= rnum && !err; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "w%d-%d", id, myrand(range));
+    char vbuf[RECBUFSIZ*8];
+    int vsiz = ksiz + myrand(sizeof(vbuf) - ksiz);
+    memcpy(vbuf, kbuf, ksiz);
+    memset(vbuf + ksiz, 'a' + i % 26, vsiz - ksiz);
+    switch(myrand(4)){
+      case 0:
+        if(!tchdbout(hdb, kbuf, ksiz) && tchdbecode(hdb) != TCENOREC){
+          eprint(hdb, __LINE__, "tchdbout");
+          err = true;
+        }
+        break;
+      case 1:
+        if(!tchdbputkeep(hdb, kbuf, ksiz, kbuf, ksiz) && tchdbecode(hdb) != TCEKEEP){
+          eprint(hdb, __LINE__, "tchdbputkeep");
+          err = true;
+        } else if(!tchdbputcat(hdb, kbuf, ksiz, vbuf + ksiz, vsiz - ksiz)){
+          eprint(hdb, __LINE__, "tchdbputcat");
+          err = true;
+        }
+        break;
+      default:
+        if(!tchdbput(hdb, kbuf, ksiz, vbuf, vsiz)){
+          eprint(hdb, __LINE__, "tchdbput");
+          err = true;
+        }
+        break;
+    }
+    if(id == 0 && rnum > 250 && i % (rnum / 250) == 0){
+      iputchar('.');
+      if(i == rnum || i % (rnum / 10) == 0) iprintf(" (%08d)\n", i);
+    }
+  }
+  return err ? "error" : NULL;
+}
+
+
 /* thread the remove function */
 static void *threadremove(void *targ){
   TCHDB *hdb = ((TARGREMOVE *)targ)->hdb;
@@ -1524,6 +2086,7 @@ static void *threadtypical(void *targ){
   int rnum = ((TARGTYPICAL *)targ)->rnum;
   bool nc = ((TARGTYPICAL *)targ)->nc;
   int rratio = ((TARGTYPICAL *)targ)->rratio;
+  bool as = ((TARGTYPICAL *)targ)->as;
   int id = ((TARGTYPICAL *)targ)->id;
   bool err = false;
   TCMAP *map = (!nc && id == 0) ? tcmapnew2(rnum + 1) : NULL;
@@ -1552,7 +2115,7 @@ static void *threadtypical(void *targ){
       }
       if(map) tcmapputcat(map, buf, len, buf, len);
     } else if(rnd < 25){
-      if(i > rnum / 10 * 9){
+      if(as || i > rnum / 10 * 9){
         if(!tchdbputasync(hdb, buf, len, buf, len)){
           eprint(hdb, __LINE__, "tchdbputasync");
           err = true;
@@ -1671,6 +2234,21 @@ static void *threadrace(void *targ){
         eprint(hdb, __LINE__, "tchdbputasync");
         err = true;
       }
+    } else if(rnd < 33){
+      TCLIST *keys = tclistnew();
+      for(int j = 0; j < 16; j++){
+        char kbuf[RECBUFSIZ];
+        int ksiz = sprintf(kbuf, "%d", myrandnd(i));
+        tclistpush(keys, kbuf, ksiz);
+      }
+      TCLIST *recs = tchdbgetmulti(hdb, keys);
+      if(recs){
+        tclistdel(recs);
+      } else {
+        eprint(hdb, __LINE__, "tchdbgetmulti");
+        err = true;
+      }
+      tclistdel(keys);
     } else {
       if(myrand(10) == 0){
         int rsiz = myrand(256);
@@ -1753,5 +2331,42 @@ static void *threadrace(void *targ){
 }
 
 
+/* thread the backup function */
+static void *threadbackup(void *targ){
+  TCHDB *hdb = ((TARGBACKUP *)targ)->hdb;
+  int rnum = ((TARGBACKUP *)targ)->rnum;
+  int id = ((TARGBACKUP *)targ)->id;
+  bool err = false;
+  for(int i = 1; !err && i <= rnum; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "%d-%d", id, i);
+    char vbuf[RECBUFSIZ*8];
+    int vsiz = backupval(vbuf, id, i);
+    if(!tchdbput(hdb, kbuf, ksiz, vbuf, vsiz)){
+      eprint(hdb, __LINE__, "tchdbput");
+      err = true;
+    }
+    if(i % 3 == 0){
+      ksiz = sprintf(kbuf, "%d-%d", id, i - 1);
+      if(!tchdbout(hdb, kbuf, ksiz)){
+        eprint(hdb, __LINE__, "tchdbout");
+        err = true;
+      }
+    }
+    ksiz = sprintf(kbuf, "%d", id);
+    vsiz = sprintf(vbuf, "%d", i);
+    if(!tchdbput(hdb, kbuf, ksiz, vbuf, vsiz)){
+      eprint(hdb, __LINE__, "tchdbput");
+      err = true;
+    }
+    if(id == 0 && rnum > 250 && i % (rnum / 250) == 0){
+      iputchar('.');
+      if(i == rnum || i % (rnum / 10) == 0) iprintf(" (%08d)\n", i);
+    }
+  }
+  return err ? "error" : NULL;
+}
+
+
 
 // END OF FILE
@@ -19,6 +19,17 @@
 #include "myconf.h"
 
 #define RECBUFSIZ      48                // buffer for records
+#define PINMAXNUM      16                // number of the records pinned by misc command
+#define BULKVLSIZ      256               // size of the large values of bulk loading
+#define BULKVLTHRES    128               // threshold of the value log of bulk loading
+
+typedef struct {                         // type of structure for the feeder of bulk loading
+  int rnum;                              // number of distinct records
+  int cnt;                               // number of fed records
+  int64_t xt;                            // expiration time of every third record
+  char buf[BULKVLSIZ];                   // buffer of the current value
+  char kbuf[RECBUFSIZ];                  // buffer of the current key
+} BULKFEED;
 
 
 /* global variables */
@@ -38,24 +49,31 @@ static void sysprint(void);
 static int myrand(int range);
 static void *pdprocfunc(const void *vbuf, int vsiz, int *sp, void *op);
 static bool iterfunc(const void *kbuf, int ksiz, const void *vbuf, int vsiz, void *op);
+static int bulkvalue(char *buf, int id, bool dup);
+static const void *bulkfeed(int *ksp, const void **vbp, int *vsp, int64_t *xtp, void *op);
+static bool expirecheck(TCHDB *hdb, int rnum, TCMAP *map, TCMAP *xmap);
 static int runwrite(int argc, char **argv);
 static int runread(int argc, char **argv);
 static int runremove(int argc, char **argv);
 static int runrcat(int argc, char **argv);
 static int runmisc(int argc, char **argv);
 static int runwicked(int argc, char **argv);
+static int runexpire(int argc, char **argv);
 static int procwrite(const char *path, int rnum, int bnum, int apow, int fpow,
-                     bool mt, int opts, int rcnum, int xmsiz, int dfunit, int omode,
-                     bool as, bool rnd);
-static int procread(const char *path, bool mt, int rcnum, int xmsiz, int dfunit, int omode,
-                    bool wb, bool rnd);
+                     bool mt, int opts, double fprate, int rcnum, int xmsiz, int dfunit, int lhnum,
+                     int omode, bool as, bool rnd);
+static int procread(const char *path, bool mt, int rcnum, int64_t rcsiz, int xmsiz, int mopts,
+                    int dfunit, int omode, bool wb, int gmnum, bool pn, bool rnd);
 static int procremove(const char *path, bool mt, int rcnum, int xmsiz, int dfunit, int omode,
                       bool rnd);
 static int procrcat(const char *path, int rnum, int bnum, int apow, int fpow,
-                    bool mt, int opts, int rcnum, int xmsiz, int dfunit, int omode, int pnum,
-                    bool dai, bool dad, bool rl, bool ru);
+                    bool mt, int opts, int rcnum, int xmsiz, int dfunit, int lhnum, int omode,
+                    int pnum, bool dai, bool dad, bool rl, bool ru);
 static int procmisc(const char *path, int rnum, bool mt, int opts, int omode);
-static int procwicked(const char *path, int rnum, bool mt, int opts, int omode);
+static int procwicked(const char *path, int rnum, bool mt, int opts, int xmsiz, int mopts,
+                      int vlthres, int otnum, int omode);
+static int procexpire(const char *path, int rnum, bool mt, int opts, int rcnum, int vlthres,
+                      int otnum, int omode);
 
 
 /* main routine */
@@ -80,6 +98,8 @@ int main(int argc, char **argv){
     rv = runmisc(argc, argv);
   } else if(!strcmp(argv[1], "wicked")){
     rv = runwicked(argc, argv);
+  } else if(!strcmp(argv[1], "expire")){
+    rv = runexpire(argc, argv);
   } else {
     usage();
   }
@@ -99,17 +119,23 @@ static void usage(void){
   fprintf(stderr, "%s: test cases of the hash database API of Tokyo Cabinet\n", g_progname);
   fprintf(stderr, "\n");
   fprintf(stderr, "usage:\n");
-  fprintf(stderr, "  %s write [-mt] [-tl] [-td|-tb|-tt|-tx] [-rc num] [-xm num] [-df num]"
-          " [-nl|-nb] [-as] [-rnd] path rnum [bnum [apow [fpow]]]\n", g_progname);
-  fprintf(stderr, "  %s read [-mt] [-rc num] [-xm num] [-df num] [-nl|-nb] [-wb] [-rnd] path\n",
+  fprintf(stderr, "  %s write [-mt] [-tl] [-tf] [-fr num] [-td|-tb|-tt|-ts|-tx] [-rc num] [-xm num]"
+          " [-df num] [-lh num] [-nl|-nb] [-as] [-rnd] path rnum [bnum [apow [fpow]]]\n",
+          g_progname);
+  fprintf(stderr, "  %s read [-mt] [-rc num] [-rs num] [-xm num] [-mh] [-ml] [-mr] [-mw]"
+          " [-df num] [-nl|-nb] [-wb|-gm num|-pn] [-rnd] path\n",
           g_progname);
   fprintf(stderr, "  %s remove [-mt] [-rc num] [-xm num] [-df num] [-nl|-nb] [-rnd] path\n",
           g_progname);
-  fprintf(stderr, "  %s rcat [-mt] [-tl] [-td|-tb|-tt|-tx] [-rc num] [-xm num] [-df num]"
-          " [-nl|-nb] [-pn num] [-dai|-dad|-rl|-ru] path rnum [bnum [apow [fpow]]]\n",
+  fprintf(stderr, "  %s rcat [-mt] [-tl] [-tf] [-td|-tb|-tt|-ts|-tx] [-rc num] [-xm num] [-df num]"
+          " [-lh num] [-nl|-nb] [-pn num] [-dai|-dad|-rl|-ru] path rnum [bnum [apow [fpow]]]\n",
           g_progname);
-  fprintf(stderr, "  %s misc [-mt] [-tl] [-td|-tb|-tt|-tx] [-nl|-nb] path rnum\n", g_progname);
-  fprintf(stderr, "  %s wicked [-mt] [-tl] [-td|-tb|-tt|-tx] [-nl|-nb] path rnum\n", g_progname);
+  fprintf(stderr, "  %s misc [-mt] [-tl] [-tf] [-td|-tb|-tt|-ts|-tx] [-nl|-nb] [-rd] [-ap]"
+          " path rnum\n", g_progname);
+  fprintf(stderr, "  %s wicked [-mt] [-tl] [-tf] [-td|-tb|-tt|-ts|-tx] [-xm num] [-mh] [-ml]"
+          " [-mr] [-mw] [-vl num] [-ot num] [-nl|-nb] [-rd] [-ap] path rnum\n", g_progname);
+  fprintf(stderr, "  %s expire [-mt] [-tl] [-td|-tb|-tt|-ts|-tx] [-rc num] [-vl num] [-ot num]"
+          " [-nl|-nb] path rnum\n", g_progname);
   fprintf(stderr, "\n");
   exit(1);
 }
@@ -146,6 +172,7 @@ static void mprint(TCHDB *hdb){
   if(hdb->cnt_writerec < 0) return;
   iprintf("bucket number: %lld\n", (long long)tchdbbnum(hdb));
   iprintf("used bucket number: %lld\n", (long long)tchdbbnumused(hdb));
+  iprintf("active bucket number: %lld\n", (long long)tchdbbnumactive(hdb));
   iprintf("cnt_writerec: %lld\n", (long long)hdb->cnt_writerec);
   iprintf("cnt_reuserec: %lld\n", (long long)hdb->cnt_reuserec);
   iprintf("cnt_moverec: %lld\n", (long long)hdb->cnt_moverec);
@@ -231,6 +258,91 @@ static bool iterfunc(const void *kbuf, int ksiz, const void *vbuf, int vsiz, voi
 }
 
 
+/* make the value of a record of bulk loading */
+static int bulkvalue(char *buf, int id, bool dup){
+  int len = sprintf(buf, "%s:%08d", dup ? "dup" : "org", id);
+  if(id % 4 == 0){
+    memset(buf + len, '*', BULKVLSIZ - len);
+    len = BULKVLSIZ;
+  }
+  return len;
+}
+
+
+/* feed records to the bulk loader, the first tenth of them twice */
+static const void *bulkfeed(int *ksp, const void **vbp, int *vsp, int64_t *xtp, void *op){
+  BULKFEED *feed = op;
+  if(feed->cnt >= feed->rnum + feed->rnum / 10) return NULL;
+  bool dup = feed->cnt >= feed->rnum;
+  int id = dup ? feed->cnt - feed->rnum + 1 : feed->cnt + 1;
+  feed->cnt++;
+  *ksp = sprintf(feed->kbuf, "%08d", id);
+  *vsp = bulkvalue(feed->buf, id, dup);
+  *vbp = feed->buf;
+  if(id % 3 == 0) *xtp = feed->xt;
+  return feed->kbuf;
+}
+
+
+/* check every record of a hash database against the model of expire command */
+static bool expirecheck(TCHDB *hdb, int rnum, TCMAP *map, TCMAP *xmap){
+  bool err = false;
+  for(int i = 1; i <= rnum && !err; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "%08d", i);
+    int vsiz;
+    const char *vbuf = tcmapget(map, kbuf, ksiz, &vsiz);
+    int rsiz;
+    char *rbuf = tchdbget(hdb, kbuf, ksiz, &rsiz);
+    if(vbuf){
+      if(!rbuf){
+        eprint(hdb, __LINE__, "tchdbget");
+        err = true;
+      } else if(rsiz != vsiz || memcmp(rbuf, vbuf, rsiz)){
+        eprint(hdb, __LINE__, "(validation)");
+        err = true;
+      }
+      const char *xstr = tcmapget2(xmap, kbuf);
+      if(tchdbgetxt(hdb, kbuf, ksiz) != (xstr ? tcatoi(xstr) : 0)){
+        eprint(hdb, __LINE__, "tchdbgetxt");
+        err = true;
+      }
+    } else {
+      if(rbuf || tchdbecode(hdb) != TCENOREC){
+        eprint(hdb, __LINE__, "tchdbget");
+        err = true;
+      }
+      if(tchdbgetxt(hdb, kbuf, ksiz) != -1){
+        eprint(hdb, __LINE__, "tchdbgetxt");
+        err = true;
+      }
+    }
+    tcfree(rbuf);
+  }
+  if(!tchdbiterinit(hdb)){
+    eprint(hdb, __LINE__, "tchdbiterinit");
+    err = true;
+  }
+  int inum = 0;
+  char *kbuf;
+  int ksiz;
+  while((kbuf = tchdbiternext(hdb, &ksiz)) != NULL){
+    int vsiz;
+    if(!tcmapget(map, kbuf, ksiz, &vsiz)){
+      eprint(hdb, __LINE__, "(validation)");
+      err = true;
+    }
+    tcfree(kbuf);
+    inum++;
+  }
+  if(inum != tcmaprnum(map)){
+    eprint(hdb, __LINE__, "(validation)");
+    err = true;
+  }
+  return !err;
+}
+
+
 /* parse arguments of write command */
 static int runwrite(int argc, char **argv){
   char *path = NULL;
@@ -240,9 +352,11 @@ static int runwrite(int argc, char **argv){
   char *fstr = NULL;
   bool mt = false;
   int opts = 0;
+  double fprate = 0;
   int rcnum = 0;
   int xmsiz = -1;
   int dfunit = 0;
+  int lhnum = 0;
   int omode = 0;
   bool as = false;
   bool rnd = false;
@@ -258,8 +372,15 @@ static int runwrite(int argc, char **argv){
         opts |= HDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= HDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= HDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= HDBTEXCODEC;
+      } else if(!strcmp(argv[i], "-tf")){
+        opts |= HDBTFPRINT;
+      } else if(!strcmp(argv[i], "-fr")){
+        if(++i >= argc) usage();
+        fprate = tcatof(argv[i]);
       } else if(!strcmp(argv[i], "-rc")){
         if(++i >= argc) usage();
         rcnum = tcatoix(argv[i]);
@@ -269,6 +390,9 @@ static int runwrite(int argc, char **argv){
       } else if(!strcmp(argv[i], "-df")){
         if(++i >= argc) usage();
         dfunit = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-lh")){
+        if(++i >= argc) usage();
+        lhnum = tcatoix(argv[i]);
       } else if(!strcmp(argv[i], "-nl")){
         omode |= HDBONOLCK;
       } else if(!strcmp(argv[i], "-nb")){
@@ -301,7 +425,7 @@ static int runwrite(int argc, char **argv){
   int apow = astr ? tcatoix(astr) : -1;
   int fpow = fstr ? tcatoix(fstr) : -1;
   int rv = procwrite(path, rnum, bnum, apow, fpow,
-                     mt, opts, rcnum, xmsiz, dfunit, omode, as, rnd);
+                     mt, opts, fprate, rcnum, xmsiz, dfunit, lhnum, omode, as, rnd);
   return rv;
 }
 
@@ -311,10 +435,14 @@ static int runread(int argc, char **argv){
   char *path = NULL;
   bool mt = false;
   int rcnum = 0;
+  int64_t rcsiz = 0;
   int xmsiz = -1;
+  int mopts = 0;
   int dfunit = 0;
   int omode = 0;
   bool wb = false;
+  int gmnum = 0;
+  bool pn = false;
   bool rnd = false;
   for(int i = 2; i < argc; i++){
     if(!path && argv[i][0] == '-'){
@@ -323,9 +451,20 @@ static int runread(int argc, char **argv){
       } else if(!strcmp(argv[i], "-rc")){
         if(++i >= argc) usage();
         rcnum = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-rs")){
+        if(++i >= argc) usage();
+        rcsiz = tcatoix(argv[i]);
       } else if(!strcmp(argv[i], "-xm")){
         if(++i >= argc) usage();
         xmsiz = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-mh")){
+        mopts |= HDBMHUGE;
+      } else if(!strcmp(argv[i], "-ml")){
+        mopts |= HDBMLOCK;
+      } else if(!strcmp(argv[i], "-mr")){
+        mopts |= HDBMBRANDOM | HDBMRRANDOM;
+      } else if(!strcmp(argv[i], "-mw")){
+        mopts |= HDBMBWILLNEED | HDBMRWILLNEED;
       } else if(!strcmp(argv[i], "-df")){
         if(++i >= argc) usage();
         dfunit = tcatoix(argv[i]);
@@ -335,6 +474,11 @@ static int runread(int argc, char **argv){
         omode |= HDBOLCKNB;
       } else if(!strcmp(argv[i], "-wb")){
         wb = true;
+      } else if(!strcmp(argv[i], "-gm")){
+        if(++i >= argc) usage();
+        gmnum = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-pn")){
+        pn = true;
       } else if(!strcmp(argv[i], "-rnd")){
         rnd = true;
       } else {
@@ -347,7 +491,7 @@ static int runread(int argc, char **argv){
     }
   }
   if(!path) usage();
-  int rv = procread(path, mt, rcnum, xmsiz, dfunit, omode, wb, rnd);
+  int rv = procread(path, mt, rcnum, rcsiz, xmsiz, mopts, dfunit, omode, wb, gmnum, pn, rnd);
   return rv;
 }
 
@@ -407,6 +551,7 @@ static int runrcat(int argc, char **argv){
   int rcnum = 0;
   int xmsiz = -1;
   int dfunit = 0;
+  int lhnum = 0;
   int omode = 0;
   int pnum = 0;
   bool dai = false;
@@ -425,8 +570,12 @@ static int runrcat(int argc, char **argv){
         opts |= HDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= HDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= HDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= HDBTEXCODEC;
+      } else if(!strcmp(argv[i], "-tf")){
+        opts |= HDBTFPRINT;
       } else if(!strcmp(argv[i], "-rc")){
         if(++i >= argc) usage();
         rcnum = tcatoix(argv[i]);
@@ -436,6 +585,9 @@ static int runrcat(int argc, char **argv){
       } else if(!strcmp(argv[i], "-df")){
         if(++i >= argc) usage();
         dfunit = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-lh")){
+        if(++i >= argc) usage();
+        lhnum = tcatoix(argv[i]);
       } else if(!strcmp(argv[i], "-nl")){
         omode |= HDBONOLCK;
       } else if(!strcmp(argv[i], "-nb")){
@@ -474,8 +626,8 @@ static int runrcat(int argc, char **argv){
   int bnum = bstr ? tcatoix(bstr) : -1;
   int apow = astr ? tcatoix(astr) : -1;
   int fpow = fstr ? tcatoix(fstr) : -1;
-  int rv = procrcat(path, rnum, bnum, apow, fpow, mt, opts, rcnum, xmsiz, dfunit, omode, pnum,
-                    dai, dad, rl, ru);
+  int rv = procrcat(path, rnum, bnum, apow, fpow, mt, opts, rcnum, xmsiz, dfunit, lhnum, omode,
+                    pnum, dai, dad, rl, ru);
   return rv;
 }
 
@@ -499,12 +651,20 @@ static int runmisc(int argc, char **argv){
         opts |= HDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= HDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= HDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= HDBTEXCODEC;
+      } else if(!strcmp(argv[i], "-tf")){
+        opts |= HDBTFPRINT;
       } else if(!strcmp(argv[i], "-nl")){
         omode |= HDBONOLCK;
       } else if(!strcmp(argv[i], "-nb")){
         omode |= HDBOLCKNB;
+      } else if(!strcmp(argv[i], "-rd")){
+        omode |= HDBOREDO;
+      } else if(!strcmp(argv[i], "-ap")){
+        omode |= HDBOAPPEND;
       } else {
         usage();
       }
@@ -530,6 +690,82 @@ static int runwicked(int argc, char **argv){
   char *rstr = NULL;
   bool mt = false;
   int opts = 0;
+  int xmsiz = -1;
+  int mopts = 0;
+  int vlthres = 0;
+  int otnum = 0;
+  int omode = 0;
+  for(int i = 2; i < argc; i++){
+    if(!path && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-mt")){
+        mt = true;
+      } else if(!strcmp(argv[i], "-tl")){
+        opts |= HDBTLARGE;
+      } else if(!strcmp(argv[i], "-td")){
+        opts |= HDBTDEFLATE;
+      } else if(!strcmp(argv[i], "-tb")){
+        opts |= HDBTBZIP;
+      } else if(!strcmp(argv[i], "-tt")){
+        opts |= HDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= HDBTLZ;
+      } else if(!strcmp(argv[i], "-tx")){
+        opts |= HDBTEXCODEC;
+      } else if(!strcmp(argv[i], "-tf")){
+        opts |= HDBTFPRINT;
+      } else if(!strcmp(argv[i], "-xm")){
+        if(++i >= argc) usage();
+        xmsiz = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-mh")){
+        mopts |= HDBMHUGE;
+      } else if(!strcmp(argv[i], "-ml")){
+        mopts |= HDBMLOCK;
+      } else if(!strcmp(argv[i], "-mr")){
+        mopts |= HDBMBRANDOM | HDBMRRANDOM;
+      } else if(!strcmp(argv[i], "-mw")){
+        mopts |= HDBMBWILLNEED | HDBMRWILLNEED;
+      } else if(!strcmp(argv[i], "-vl")){
+        if(++i >= argc) usage();
+        vlthres = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-ot")){
+        if(++i >= argc) usage();
+        otnum = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-nl")){
+        omode |= HDBONOLCK;
+      } else if(!strcmp(argv[i], "-nb")){
+        omode |= HDBOLCKNB;
+      } else if(!strcmp(argv[i], "-rd")){
+        omode |= HDBOREDO;
+      } else if(!strcmp(argv[i], "-ap")){
+        omode |= HDBOAPPEND;
+      } else {
+        usage();
+      }
+    } else if(!path){
+      path = argv[i];
+    } else if(!rstr){
+      rstr = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if(!path || !rstr) usage();
+  int rnum = tcatoix(rstr);
+  if(rnum < 1) usage();
+  int rv = procwicked(path, rnum, mt, opts, xmsiz, mopts, vlthres, otnum, omode);
+  return rv;
+}
+
+
+/* parse arguments of expire command */
+static int runexpire(int argc, char **argv){
+  char *path = NULL;
+  char *rstr = NULL;
+  bool mt = false;
+  int opts = 0;
+  int rcnum = 0;
+  int vlthres = 0;
+  int otnum = 0;
   int omode = 0;
   for(int i = 2; i < argc; i++){
     if(!path && argv[i][0] == '-'){
@@ -543,8 +779,19 @@ static int runwicked(int argc, char **argv){
         opts |= HDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= HDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= HDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= HDBTEXCODEC;
+      } else if(!strcmp(argv[i], "-rc")){
+        if(++i >= argc) usage();
+        rcnum = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-vl")){
+        if(++i >= argc) usage();
+        vlthres = tcatoix(argv[i]);
+      } else if(!strcmp(argv[i], "-ot")){
+        if(++i >= argc) usage();
+        otnum = tcatoix(argv[i]);
       } else if(!strcmp(argv[i], "-nl")){
         omode |= HDBONOLCK;
       } else if(!strcmp(argv[i], "-nb")){
@@ -563,19 +810,19 @@ static int runwicked(int argc, char **argv){
   if(!path || !rstr) usage();
   int rnum = tcatoix(rstr);
   if(rnum < 1) usage();
-  int rv = procwicked(path, rnum, mt, opts, omode);
+  int rv = procexpire(path, rnum, mt, opts, rcnum, vlthres, otnum, omode);
   return rv;
 }
 
 
 /* perform write command */
 static int procwrite(const char *path, int rnum, int bnum, int apow, int fpow,
-                     bool mt, int opts, int rcnum, int xmsiz, int dfunit, int omode,
-                     bool as, bool rnd){
+                     bool mt, int opts, double fprate, int rcnum, int xmsiz, int dfunit, int lhnum,
+                     int omode, bool as, bool rnd){
   iprintf("<Writing Test>\n  seed=%u  path=%s  rnum=%d  bnum=%d  apow=%d  fpow=%d  mt=%d"
-          "  opts=%d  rcnum=%d  xmsiz=%d  dfunit=%d  omode=%d  as=%d  rnd=%d\n\n",
-          g_randseed, path, rnum, bnum, apow, fpow, mt, opts, rcnum, xmsiz, dfunit,
-          omode, as, rnd);
+          "  opts=%d  fprate=%g  rcnum=%d  xmsiz=%d  dfunit=%d  lhnum=%d  omode=%d  as=%d"
+          "  rnd=%d\n\n", g_randseed, path, rnum, bnum, apow, fpow, mt, opts, fprate, rcnum,
+          xmsiz, dfunit, lhnum, omode, as, rnd);
   bool err = false;
   double stime = tctime();
   TCHDB *hdb = tchdbnew();
@@ -604,6 +851,14 @@ static int procwrite(const char *path, int rnum, int bnum, int apow, int fpow,
     eprint(hdb, __LINE__, "tchdbsetdfunit");
     err = true;
   }
+  if(lhnum > 0 && !tchdbsetlinear(hdb, lhnum)){
+    eprint(hdb, __LINE__, "tchdbsetlinear");
+    err = true;
+  }
+  if(fprate > 0 && !tchdbsetfprate(hdb, fprate)){
+    eprint(hdb, __LINE__, "tchdbsetfprate");
+    err = true;
+  }
   if(!rnd) omode |= HDBOTRUNC;
   if(!tchdbopen(hdb, path, HDBOWRITER | HDBOCREAT | omode)){
     eprint(hdb, __LINE__, "tchdbopen");
@@ -646,10 +901,12 @@ static int procwrite(const char *path, int rnum, int bnum, int apow, int fpow,
 
 
 /* perform read command */
-static int procread(const char *path, bool mt, int rcnum, int xmsiz, int dfunit, int omode,
-                    bool wb, bool rnd){
-  iprintf("<Reading Test>\n  seed=%u  path=%s  mt=%d  rcnum=%d  xmsiz=%d  dfunit=%d  omode=%d"
-          "  wb=%d  rnd=%d\n\n", g_randseed, path, mt, rcnum, xmsiz, dfunit, omode, wb, rnd);
+static int procread(const char *path, bool mt, int rcnum, int64_t rcsiz, int xmsiz, int mopts,
+                    int dfunit, int omode, bool wb, int gmnum, bool pn, bool rnd){
+  iprintf("<Reading Test>\n  seed=%u  path=%s  mt=%d  rcnum=%d  rcsiz=%lld  xmsiz=%d  mopts=%d"
+          "  dfunit=%d  omode=%d  wb=%d  gmnum=%d  pn=%d  rnd=%d\n\n",
+          g_randseed, path, mt, rcnum, (long long)rcsiz, xmsiz, mopts, dfunit, omode, wb, gmnum,
+          pn, rnd);
   bool err = false;
   double stime = tctime();
   TCHDB *hdb = tchdbnew();
@@ -662,14 +919,18 @@ static int procread(const char *path, bool mt, int rcnum, int xmsiz, int dfunit,
     eprint(hdb, __LINE__, "tchdbsetcodecfunc");
     err = true;
   }
-  if(!tchdbsetcache(hdb, rcnum)){
-    eprint(hdb, __LINE__, "tchdbsetcache");
+  if(!tchdbsetcache2(hdb, rcnum, rcsiz)){
+    eprint(hdb, __LINE__, "tchdbsetcache2");
     err = true;
   }
   if(xmsiz >= 0 && !tchdbsetxmsiz(hdb, xmsiz)){
     eprint(hdb, __LINE__, "tchdbsetxmsiz");
     err = true;
   }
+  if(mopts > 0 && !tchdbsetmapopts(hdb, mopts)){
+    eprint(hdb, __LINE__, "tchdbsetmapopts");
+    err = true;
+  }
   if(dfunit >= 0 && !tchdbsetdfunit(hdb, dfunit)){
     eprint(hdb, __LINE__, "tchdbsetdfunit");
     err = true;
@@ -679,11 +940,31 @@ static int procread(const char *path, bool mt, int rcnum, int xmsiz, int dfunit,
     err = true;
   }
   int rnum = tchdbrnum(hdb);
+  int pinnum = 0;
+  TCLIST *keys = tclistnew();
   for(int i = 1; i <= rnum; i++){
     char kbuf[RECBUFSIZ];
     int ksiz = sprintf(kbuf, "%08d", rnd ? myrand(rnum) + 1 : i);
     int vsiz;
-    if(wb){
+    if(gmnum > 0){
+      tclistpush(keys, kbuf, ksiz);
+      if(tclistnum(keys) >= gmnum || i == rnum){
+        TCLIST *recs = tchdbgetmulti(hdb, keys);
+        if(!recs){
+          eprint(hdb, __LINE__, "tchdbgetmulti");
+          err = true;
+          break;
+        }
+        if(!rnd && tclistnum(recs) != tclistnum(keys) * 2){
+          eprint(hdb, __LINE__, "(validation)");
+          err = true;
+          tclistdel(recs);
+          break;
+        }
+        tclistdel(recs);
+        tclistclear(keys);
+      }
+    } else if(wb){
       char vbuf[RECBUFSIZ];
       int vsiz = tchdbget3(hdb, kbuf, ksiz, vbuf, RECBUFSIZ);
       if(vsiz < 0 && !(rnd && tchdbecode(hdb) == TCENOREC)){
@@ -691,6 +972,36 @@ static int procread(const char *path, bool mt, int rcnum, int xmsiz, int dfunit,
         err = true;
         break;
       }
+    } else if(pn){
+      uint64_t pin;
+      const char *pbuf = tchdbgetpin(hdb, kbuf, ksiz, &vsiz, &pin);
+      if(pbuf){
+        int csiz;
+        char *cbuf = tchdbget(hdb, kbuf, ksiz, &csiz);
+        if(!cbuf || csiz != vsiz || memcmp(cbuf, pbuf, vsiz)){
+          eprint(hdb, __LINE__, "(validation)");
+          err = true;
+        }
+        tcfree(cbuf);
+        if(!tchdbunpin(hdb, pin)){
+          eprint(hdb, __LINE__, "tchdbunpin");
+          err = true;
+        }
+        if(err) break;
+        pinnum++;
+      } else if(tchdbecode(hdb) == TCEINVALID){
+        char *vbuf = tchdbget(hdb, kbuf, ksiz, &vsiz);
+        if(!vbuf && !(rnd && tchdbecode(hdb) == TCENOREC)){
+          eprint(hdb, __LINE__, "tchdbget");
+          err = true;
+          break;
+        }
+        tcfree(vbuf);
+      } else if(!(rnd && tchdbecode(hdb) == TCENOREC)){
+        eprint(hdb, __LINE__, "tchdbgetpin");
+        err = true;
+        break;
+      }
     } else {
       char *vbuf = tchdbget(hdb, kbuf, ksiz, &vsiz);
       if(!vbuf && !(rnd && tchdbecode(hdb) == TCENOREC)){
@@ -705,6 +1016,20 @@ static int procread(const char *path, bool mt, int rcnum, int xmsiz, int dfunit,
       if(i == rnum || i % (rnum / 10) == 0) iprintf(" (%08d)\n", i);
     }
   }
+  tclistdel(keys);
+  if(pn) iprintf("pinned records: %d\n", pinnum);
+  if(rcnum > 0 || rcsiz > 0){
+    uint64_t hnum, mnum, cnum, csiz;
+    if(tchdbcachestat(hdb, &hnum, &mnum, &cnum, &csiz)){
+      iprintf("cache hits: %llu\n", (unsigned long long)hnum);
+      iprintf("cache misses: %llu\n", (unsigned long long)mnum);
+      iprintf("cached records: %llu (%llu bytes)\n",
+              (unsigned long long)cnum, (unsigned long long)csiz);
+    } else {
+      eprint(hdb, __LINE__, "tchdbcachestat");
+      err = true;
+    }
+  }
   iprintf("record number: %llu\n", (unsigned long long)tchdbrnum(hdb));
   iprintf("size: %llu\n", (unsigned long long)tchdbfsiz(hdb));
   mprint(hdb);
@@ -784,13 +1109,14 @@ static int procremove(const char *path, bool mt, int rcnum, int xmsiz, int dfuni
 
 /* perform rcat command */
 static int procrcat(const char *path, int rnum, int bnum, int apow, int fpow,
-                    bool mt, int opts, int rcnum, int xmsiz, int dfunit, int omode, int pnum,
-                    bool dai, bool dad, bool rl, bool ru){
+                    bool mt, int opts, int rcnum, int xmsiz, int dfunit, int lhnum, int omode,
+                    int pnum, bool dai, bool dad, bool rl, bool ru){
   iprintf("<Random Concatenating Test>\n"
           "  seed=%u  path=%s  rnum=%d  bnum=%d  apow=%d  fpow=%d  mt=%d  opts=%d"
-          "  rcnum=%d  xmsiz=%d  dfunit=%d  omode=%d  pnum=%d  dai=%d  dad=%d  rl=%d  ru=%d\n\n",
-          g_randseed, path, rnum, bnum, apow, fpow, mt, opts, rcnum, xmsiz, dfunit, omode, pnum,
-          dai, dad, rl, ru);
+          "  rcnum=%d  xmsiz=%d  dfunit=%d  lhnum=%d  omode=%d  pnum=%d  dai=%d  dad=%d  rl=%d"
+          "  ru=%d\n\n",
+          g_randseed, path, rnum, bnum, apow, fpow, mt, opts, rcnum, xmsiz, dfunit, lhnum, omode,
+          pnum, dai, dad, rl, ru);
   if(pnum < 1) pnum = rnum;
   bool err = false;
   double stime = tctime();
@@ -820,6 +1146,10 @@ static int procrcat(const char *path, int rnum, int bnum, int apow, int fpow,
     eprint(hdb, __LINE__, "tchdbsetdfunit");
     err = true;
   }
+  if(lhnum > 0 && !tchdbsetlinear(hdb, lhnum)){
+    eprint(hdb, __LINE__, "tchdbsetlinear");
+    err = true;
+  }
   if(!tchdbopen(hdb, path, HDBOWRITER | HDBOCREAT | HDBOTRUNC | omode)){
     eprint(hdb, __LINE__, "tchdbopen");
     err = true;
@@ -985,6 +1315,98 @@ static int procmisc(const char *path, int rnum, bool mt, int opts, int omode){
     }
     tchdbdel(hdbdup);
   }
+  iprintf("checking pins:\n");
+  int pnum = 0;
+  uint64_t pins[PINMAXNUM];
+  const char *pbufs[PINMAXNUM];
+  int psizs[PINMAXNUM];
+  int pids[PINMAXNUM];
+  for(int i = 0; i < PINMAXNUM && !err; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "pin:%d", i);
+    if(!tchdbput(hdb, kbuf, ksiz, kbuf, ksiz)){
+      eprint(hdb, __LINE__, "tchdbput");
+      err = true;
+      break;
+    }
+    pbufs[pnum] = tchdbgetpin(hdb, kbuf, ksiz, psizs + pnum, pins + pnum);
+    if(pbufs[pnum]){
+      pids[pnum++] = i;
+    } else if(tchdbecode(hdb) != TCEINVALID){
+      eprint(hdb, __LINE__, "tchdbgetpin");
+      err = true;
+    }
+  }
+  for(int i = 0; i < PINMAXNUM && !err; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "pin:%d", i);
+    if(i % 2 == 0){
+      char vbuf[RECBUFSIZ];
+      memset(vbuf, '*', i);
+      if(!tchdbput(hdb, kbuf, ksiz, vbuf, i)){
+        eprint(hdb, __LINE__, "tchdbput");
+        err = true;
+      }
+    } else if(!tchdbout(hdb, kbuf, ksiz)){
+      eprint(hdb, __LINE__, "tchdbout");
+      err = true;
+    }
+  }
+  for(int i = 1; i <= rnum / 10 && !err; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "pinfill:%d", i);
+    if(!tchdbput(hdb, kbuf, ksiz, kbuf, ksiz)){
+      eprint(hdb, __LINE__, "tchdbput");
+      err = true;
+    }
+  }
+  for(int i = 1; i <= rnum / 10 && !err; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "pinfill:%d", i);
+    if(!tchdbout(hdb, kbuf, ksiz)){
+      eprint(hdb, __LINE__, "tchdbout");
+      err = true;
+    }
+  }
+  if(!err && pnum > 0){
+    if(!tchdbdefrag(hdb, 0)){
+      eprint(hdb, __LINE__, "tchdbdefrag");
+      err = true;
+    }
+    if(tchdbvanish(hdb) || tchdbecode(hdb) != TCEINVALID){
+      eprint(hdb, __LINE__, "tchdbvanish");
+      err = true;
+    }
+  }
+  for(int i = 0; i < pnum; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "pin:%d", pids[i]);
+    if(!err && (psizs[i] != ksiz || memcmp(pbufs[i], kbuf, ksiz))){
+      eprint(hdb, __LINE__, "(validation)");
+      err = true;
+    }
+    if(!tchdbunpin(hdb, pins[i])){
+      eprint(hdb, __LINE__, "tchdbunpin");
+      err = true;
+    }
+  }
+  if(pnum > 0 && (tchdbunpin(hdb, pins[0]) || tchdbecode(hdb) != TCEINVALID)){
+    eprint(hdb, __LINE__, "tchdbunpin");
+    err = true;
+  }
+  for(int i = 0; i < PINMAXNUM && !err; i += 2){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "pin:%d", i);
+    if(!tchdbout(hdb, kbuf, ksiz)){
+      eprint(hdb, __LINE__, "tchdbout");
+      err = true;
+    }
+  }
+  if(!(opts & (HDBTDEFLATE | HDBTBZIP | HDBTTCBS | HDBTLZ | HDBTEXCODEC)) && pnum < 1){
+    eprint(hdb, __LINE__, "(validation)");
+    err = true;
+  }
+  iprintf("pinned records: %d\n", pnum);
   iprintf("writing:\n");
   for(int i = 1; i <= rnum; i++){
     char buf[RECBUFSIZ];
@@ -1283,6 +1705,60 @@ static int procmisc(const char *path, int rnum, bool mt, int opts, int omode){
       if(i == rnum || i % (rnum / 10) == 0) iprintf(" (%08d)\n", i);
     }
   }
+  iprintf("batch reading:\n");
+  uint64_t gonum = tcstatsopnum(tchdbstats(hdb), TCSOGET);
+  uint64_t msnum = tcstatscnt(tchdbstats(hdb), TCSCMISS);
+  int bknum = 0;
+  int bmnum = 0;
+  TCLIST *keys = tclistnew();
+  for(int i = 1; i <= rnum; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "%08d", i);
+    tclistpush(keys, kbuf, ksiz);
+    if(i % 100 == 0 || i == rnum){
+      tclistpush2(keys, "[missing]");
+      bknum += tclistnum(keys);
+      bmnum++;
+      TCLIST *recs = tchdbgetmulti(hdb, keys);
+      if(!recs){
+        eprint(hdb, __LINE__, "tchdbgetmulti");
+        err = true;
+        tclistdel(keys);
+        keys = NULL;
+        break;
+      }
+      int rsnum = tclistnum(recs);
+      if(rsnum != (tclistnum(keys) - 1) * 2){
+        eprint(hdb, __LINE__, "(validation)");
+        err = true;
+      }
+      for(int j = 0; j < rsnum - 1 && !err; j += 2){
+        int rksiz, rvsiz;
+        const char *rkbuf = tclistval(recs, j, &rksiz);
+        const char *rvbuf = tclistval(recs, j + 1, &rvsiz);
+        int eksiz;
+        const char *ekbuf = tclistval(keys, j / 2, &eksiz);
+        if(rksiz != eksiz || memcmp(rkbuf, ekbuf, eksiz) ||
+           rvsiz != rksiz || memcmp(rvbuf, rkbuf, rvsiz)){
+          eprint(hdb, __LINE__, "(validation)");
+          err = true;
+        }
+      }
+      tclistdel(recs);
+      tclistclear(keys);
+      if(err) break;
+    }
+    if(rnum > 250 && i % (rnum / 250) == 0){
+      iputchar('.');
+      if(i == rnum || i % (rnum / 10) == 0) iprintf(" (%08d)\n", i);
+    }
+  }
+  if(keys) tclistdel(keys);
+  if(!err && (tcstatsopnum(tchdbstats(hdb), TCSOGET) != gonum + bknum ||
+              tcstatscnt(tchdbstats(hdb), TCSCMISS) != msnum + bmnum)){
+    eprint(hdb, __LINE__, "tcstatsopnum");
+    err = true;
+  }
   iprintf("checking words:\n");
   for(int i = 0; words[i] != NULL; i += 2){
     const char *kbuf = words[i];
@@ -1692,45 +2168,232 @@ static int procmisc(const char *path, int rnum, bool mt, int opts, int omode){
     eprint(hdb, __LINE__, "tchdbclose");
     err = true;
   }
-  tchdbdel(hdb);
-  iprintf("time: %.3f\n", tctime() - stime);
-  iprintf("%s\n\n", err ? "error" : "ok");
-  return err ? 1 : 0;
-}
-
-
-/* perform wicked command */
-static int procwicked(const char *path, int rnum, bool mt, int opts, int omode){
-  iprintf("<Wicked Writing Test>\n  seed=%u  path=%s  rnum=%d  mt=%d  opts=%d  omode=%d\n\n",
-          g_randseed, path, rnum, mt, opts, omode);
-  bool err = false;
-  double stime = tctime();
-  TCHDB *hdb = tchdbnew();
-  if(g_dbgfd >= 0) tchdbsetdbgfd(hdb, g_dbgfd);
-  if(mt && !tchdbsetmutex(hdb)){
-    eprint(hdb, __LINE__, "tchdbsetmutex");
-    err = true;
-  }
-  if(!tchdbsetcodecfunc(hdb, _tc_recencode, NULL, _tc_recdecode, NULL)){
-    eprint(hdb, __LINE__, "tchdbsetcodecfunc");
-    err = true;
-  }
-  if(!tchdbtune(hdb, rnum / 50, 2, -1, opts)){
-    eprint(hdb, __LINE__, "tchdbtune");
-    err = true;
-  }
-  if(!tchdbsetcache(hdb, rnum / 10)){
-    eprint(hdb, __LINE__, "tchdbsetcache");
-    err = true;
-  }
-  if(!tchdbsetxmsiz(hdb, rnum * sizeof(int))){
-    eprint(hdb, __LINE__, "tchdbsetxmsiz");
-    err = true;
-  }
-  if(!tchdbsetdfunit(hdb, 8)){
+  if(!err && (omode & HDBOAPPEND)){
+    iprintf("checking recovery after a crash:\n");
+    pid_t pid = fork();
+    if(pid == 0){
+      if(!tchdbopen(hdb, path, HDBOWRITER | omode)) _exit(1);
+      for(int i = 1; i <= rnum / 10; i++){
+        char buf[RECBUFSIZ];
+        int len = sprintf(buf, "crash:%d", i);
+        if(!tchdbput(hdb, buf, len, buf, 1) || !tchdbput(hdb, buf, len, buf, len)) _exit(1);
+        if(i == rnum / 20 && !tchdbsync(hdb)) _exit(1);
+      }
+      _exit(0);
+    }
+    int status;
+    if(pid == -1 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+       WEXITSTATUS(status) != 0){
+      eprint(hdb, __LINE__, "(crash)");
+      err = true;
+    }
+    if(!tchdbopen(hdb, path, HDBOWRITER | omode)){
+      eprint(hdb, __LINE__, "tchdbopen");
+      err = true;
+    }
+    for(int i = 1; i <= rnum / 10 && !err; i++){
+      char buf[RECBUFSIZ];
+      int len = sprintf(buf, "crash:%d", i);
+      int rsiz;
+      char *rbuf = tchdbget(hdb, buf, len, &rsiz);
+      if(!rbuf || rsiz != len || memcmp(rbuf, buf, len)){
+        eprint(hdb, __LINE__, "(validation)");
+        err = true;
+      }
+      tcfree(rbuf);
+    }
+    iprintf("checking recovery after a crash during overwrites:\n");
+    for(int i = 1; i <= 5 && !err; i++){
+      if(!tchdbclose(hdb)){
+        eprint(hdb, __LINE__, "tchdbclose");
+        err = true;
+        break;
+      }
+      pid = fork();
+      if(pid == 0){
+        if(!tchdbsetdfunit(hdb, 2) || !tchdbopen(hdb, path, HDBOWRITER | omode)) _exit(1);
+        for(int j = 0; true; j++){
+          for(int k = 1; k <= rnum / 10; k++){
+            char buf[RECBUFSIZ];
+            int len = sprintf(buf, "crash:%d", k);
+            int vsiz = len + sprintf(buf + len, ":%d", j);
+            if(!tchdbput(hdb, buf, len, buf, vsiz)) _exit(1);
+          }
+        }
+      }
+      if(pid != -1){
+        tcsleep(0.01 + myrand(50) / 1000.0);
+        kill(pid, SIGKILL);
+      }
+      if(pid == -1 || waitpid(pid, &status, 0) != pid || !WIFSIGNALED(status)){
+        eprint(hdb, __LINE__, "(crash)");
+        err = true;
+      }
+      if(!tchdbopen(hdb, path, HDBOWRITER | omode)){
+        eprint(hdb, __LINE__, "tchdbopen");
+        err = true;
+        break;
+      }
+      for(int k = 1; k <= rnum / 10 && !err; k++){
+        char buf[RECBUFSIZ];
+        int len = sprintf(buf, "crash:%d", k);
+        int rsiz;
+        char *rbuf = tchdbget(hdb, buf, len, &rsiz);
+        if(!rbuf || rsiz < len || memcmp(rbuf, buf, len)){
+          eprint(hdb, __LINE__, "(validation)");
+          err = true;
+        }
+        tcfree(rbuf);
+      }
+      if(!err && !tchdbiterinit(hdb)){
+        eprint(hdb, __LINE__, "tchdbiterinit");
+        err = true;
+      }
+      uint64_t inum = 0;
+      char *kbuf;
+      int ksiz;
+      while(!err && (kbuf = tchdbiternext(hdb, &ksiz)) != NULL){
+        inum++;
+        tcfree(kbuf);
+      }
+      if(!err && inum != tchdbrnum(hdb)){
+        eprint(hdb, __LINE__, "(validation)");
+        err = true;
+      }
+    }
+    if(!tchdbdefrag(hdb, 0)){
+      eprint(hdb, __LINE__, "tchdbdefrag");
+      err = true;
+    }
+    iprintf("record number: %llu\n", (unsigned long long)tchdbrnum(hdb));
+    iprintf("size: %llu\n", (unsigned long long)tchdbfsiz(hdb));
+    if(!tchdbclose(hdb)){
+      eprint(hdb, __LINE__, "tchdbclose");
+      err = true;
+    }
+  }
+  tchdbdel(hdb);
+  if(!err){
+    iprintf("checking bulk loading:\n");
+    hdb = tchdbnew();
+    if(g_dbgfd >= 0) tchdbsetdbgfd(hdb, g_dbgfd);
+    if(!tchdbsetcodecfunc(hdb, _tc_recencode, NULL, _tc_recdecode, NULL)){
+      eprint(hdb, __LINE__, "tchdbsetcodecfunc");
+      err = true;
+    }
+    if(!tchdbtune(hdb, rnum * 2, 2, -1, opts)){
+      eprint(hdb, __LINE__, "tchdbtune");
+      err = true;
+    }
+    if(!tchdbsetlinear(hdb, rnum / 50 + 1)){
+      eprint(hdb, __LINE__, "tchdbsetlinear");
+      err = true;
+    }
+    if(!tchdbsetvlog(hdb, BULKVLTHRES)){
+      eprint(hdb, __LINE__, "tchdbsetvlog");
+      err = true;
+    }
+    BULKFEED feed;
+    feed.rnum = rnum;
+    feed.cnt = 0;
+    feed.xt = -((int64_t)tctime() + 3600);
+    if(!tchdbbulkload(hdb, path, bulkfeed, &feed)){
+      eprint(hdb, __LINE__, "tchdbbulkload");
+      err = true;
+    }
+    if(!tchdbopen(hdb, path, HDBOREADER)){
+      eprint(hdb, __LINE__, "tchdbopen");
+      err = true;
+    }
+    if(tchdbrnum(hdb) != rnum || tchdbbnumactive(hdb) < rnum){
+      eprint(hdb, __LINE__, "(validation)");
+      err = true;
+    }
+    uint64_t vlsum = 0;
+    for(int i = 1; i <= rnum && !err; i++){
+      char kbuf[RECBUFSIZ];
+      int ksiz = sprintf(kbuf, "%08d", i);
+      char vbuf[BULKVLSIZ];
+      int vsiz = bulkvalue(vbuf, i, i <= rnum / 10);
+      if(vsiz >= BULKVLTHRES) vlsum += vsiz;
+      int rsiz;
+      char *rbuf = tchdbget(hdb, kbuf, ksiz, &rsiz);
+      if(!rbuf || rsiz != vsiz || memcmp(rbuf, vbuf, rsiz) ||
+         tchdbgetxt(hdb, kbuf, ksiz) != (i % 3 == 0 ? -feed.xt : 0)){
+        eprint(hdb, __LINE__, "(validation)");
+        err = true;
+      }
+      tcfree(rbuf);
+    }
+    uint64_t vlsiz;
+    if(!tchdbvlogstat(hdb, &vlsiz, NULL, NULL)){
+      eprint(hdb, __LINE__, "tchdbvlogstat");
+      err = true;
+    } else if(!(opts & (HDBTDEFLATE | HDBTBZIP | HDBTTCBS | HDBTLZ | HDBTEXCODEC)) &&
+              vlsiz != vlsum){
+      eprint(hdb, __LINE__, "(validation)");
+      err = true;
+    }
+    iprintf("record number: %llu\n", (unsigned long long)tchdbrnum(hdb));
+    iprintf("size: %llu\n", (unsigned long long)tchdbfsiz(hdb));
+    if(!tchdbclose(hdb)){
+      eprint(hdb, __LINE__, "tchdbclose");
+      err = true;
+    }
+    tchdbdel(hdb);
+  }
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
+/* perform wicked command */
+static int procwicked(const char *path, int rnum, bool mt, int opts, int xmsiz, int mopts,
+                      int vlthres, int otnum, int omode){
+  iprintf("<Wicked Writing Test>\n  seed=%u  path=%s  rnum=%d  mt=%d  opts=%d  xmsiz=%d"
+          "  mopts=%d  vlthres=%d  otnum=%d  omode=%d\n\n", g_randseed, path, rnum, mt, opts,
+          xmsiz, mopts, vlthres, otnum, omode);
+  bool err = false;
+  double stime = tctime();
+  TCHDB *hdb = tchdbnew();
+  if(g_dbgfd >= 0) tchdbsetdbgfd(hdb, g_dbgfd);
+  if(mt && !tchdbsetmutex(hdb)){
+    eprint(hdb, __LINE__, "tchdbsetmutex");
+    err = true;
+  }
+  if(!tchdbsetcodecfunc(hdb, _tc_recencode, NULL, _tc_recdecode, NULL)){
+    eprint(hdb, __LINE__, "tchdbsetcodecfunc");
+    err = true;
+  }
+  if(!tchdbtune(hdb, rnum / 50, 2, -1, opts)){
+    eprint(hdb, __LINE__, "tchdbtune");
+    err = true;
+  }
+  if(!tchdbsetcache(hdb, rnum / 10)){
+    eprint(hdb, __LINE__, "tchdbsetcache");
+    err = true;
+  }
+  if(!tchdbsetxmsiz(hdb, xmsiz >= 0 ? xmsiz : rnum * sizeof(int))){
+    eprint(hdb, __LINE__, "tchdbsetxmsiz");
+    err = true;
+  }
+  if(mopts > 0 && !tchdbsetmapopts(hdb, mopts)){
+    eprint(hdb, __LINE__, "tchdbsetmapopts");
+    err = true;
+  }
+  if(!tchdbsetdfunit(hdb, 8)){
     eprint(hdb, __LINE__, "tchdbsetdfunit");
     err = true;
   }
+  if(vlthres > 0 && !tchdbsetvlog(hdb, vlthres)){
+    eprint(hdb, __LINE__, "tchdbsetvlog");
+    err = true;
+  }
+  if(otnum > 0 && !tchdbsetoptthreads(hdb, otnum)){
+    eprint(hdb, __LINE__, "tchdbsetoptthreads");
+    err = true;
+  }
   if(!tchdbopen(hdb, path, HDBOWRITER | HDBOCREAT | HDBOTRUNC | omode)){
     eprint(hdb, __LINE__, "tchdbopen");
     err = true;
@@ -1967,6 +2630,11 @@ static int procwicked(const char *path, int rnum, bool mt, int opts, int omode){
       }
       tchdbdel(nhdb);
       unlink(npath);
+      if(vlthres > 0){
+        char *vpath = tcsprintf("%s.vlog", npath);
+        unlink(vpath);
+        tcfree(vpath);
+      }
       tcfree(npath);
       if(!tchdboptimize(hdb, rnum / 50, -1, -1, -1)){
         eprint(hdb, __LINE__, "tchdboptimize");
@@ -2080,9 +2748,78 @@ static int procwicked(const char *path, int rnum, bool mt, int opts, int omode){
     eprint(hdb, __LINE__, "(validation)");
     err = true;
   }
+  iprintf("checking iteration with writes:\n");
+  if(!tchdbiterinit(hdb)){
+    eprint(hdb, __LINE__, "tchdbiterinit");
+    err = true;
+  }
+  TCMAP *wmap = tcmapnew();
+  TCMAP *imap = tcmapnew();
+  TCXSTR *ikey = tcxstrnew();
+  TCXSTR *ival = tcxstrnew();
+  inum = 0;
+  while(!err && tchdbiternext3(hdb, ikey, ival)){
+    inum++;
+    iputchar('=');
+    const char *ikbuf = tcxstrptr(ikey);
+    int iksiz = tcxstrsize(ikey);
+    int vsiz;
+    const char *vbuf = tcmapget(map, ikbuf, iksiz, &vsiz);
+    if(!vbuf || vsiz != tcxstrsize(ival) || memcmp(vbuf, tcxstrptr(ival), vsiz)){
+      eprint(hdb, __LINE__, "(validation)");
+      err = true;
+      break;
+    }
+    if(!tcmapputkeep(imap, ikbuf, iksiz, "", 0) && !tcmapget(wmap, ikbuf, iksiz, &vsiz)){
+      eprint(hdb, __LINE__, "(validation)");
+      err = true;
+      break;
+    }
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "%d", myrand(rnum));
+    char nbuf[RECBUFSIZ*4];
+    int nsiz = myrand(sizeof(nbuf));
+    memset(nbuf, 'a' + inum % 26, nsiz);
+    tcmapput(wmap, kbuf, ksiz, "", 0);
+    if(myrand(3) == 0){
+      if(!tchdbout(hdb, kbuf, ksiz) && tchdbecode(hdb) != TCENOREC){
+        eprint(hdb, __LINE__, "tchdbout");
+        err = true;
+      }
+      tcmapout(map, kbuf, ksiz);
+    } else {
+      if(!tchdbput(hdb, kbuf, ksiz, nbuf, nsiz)){
+        eprint(hdb, __LINE__, "tchdbput");
+        err = true;
+      }
+      tcmapput(map, kbuf, ksiz, nbuf, nsiz);
+    }
+    if(inum % 50 == 0) iprintf(" (%08d)\n", inum);
+  }
+  if(inum % 50 > 0) iprintf(" (%08d)\n", inum);
+  if(!err && tchdbecode(hdb) != TCENOREC){
+    eprint(hdb, __LINE__, "tchdbiternext3");
+    err = true;
+  }
   tcmapiterinit(map);
   int ksiz;
   const char *kbuf;
+  while(!err && (kbuf = tcmapiternext(map, &ksiz)) != NULL){
+    int vsiz;
+    if(!tcmapget(wmap, kbuf, ksiz, &vsiz) && !tcmapget(imap, kbuf, ksiz, &vsiz)){
+      eprint(hdb, __LINE__, "(validation)");
+      err = true;
+    }
+  }
+  tcxstrdel(ival);
+  tcxstrdel(ikey);
+  tcmapdel(imap);
+  tcmapdel(wmap);
+  if(tchdbrnum(hdb) != tcmaprnum(map)){
+    eprint(hdb, __LINE__, "(validation)");
+    err = true;
+  }
+  tcmapiterinit(map);
   for(int i = 1; (kbuf = tcmapiternext(map, &ksiz)) != NULL; i++){
     iputchar('+');
     int vsiz;
@@ -2109,8 +2846,69 @@ static int procwicked(const char *path, int rnum, bool mt, int opts, int omode){
     eprint(hdb, __LINE__, "(validation)");
     err = true;
   }
+  if(vlthres > 0 && !err){
+    iprintf("checking accounting of the value log:\n");
+    char vbuf[RECBUFSIZ*2];
+    int vsiz = vlthres * 2;
+    if(vsiz > (int)sizeof(vbuf)) vsiz = sizeof(vbuf);
+    memset(vbuf, 'v', vsiz);
+    if(!tchdbput(hdb, "vlog", 4, vbuf, vsiz)){
+      eprint(hdb, __LINE__, "tchdbput");
+      err = true;
+    }
+    uint64_t osiz, odsiz, opnum, nsiz, ndsiz, npnum;
+    if(!tchdbvlogstat(hdb, &osiz, &odsiz, &opnum)){
+      eprint(hdb, __LINE__, "tchdbvlogstat");
+      err = true;
+    }
+    if(tchdbaddint(hdb, "vlog", 4, 1) != INT_MIN || tchdbecode(hdb) != TCEKEEP ||
+       !isnan(tchdbadddouble(hdb, "vlog", 4, 1.0)) || tchdbecode(hdb) != TCEKEEP){
+      eprint(hdb, __LINE__, "(validation)");
+      err = true;
+    }
+    if(!tchdbvlogstat(hdb, &nsiz, &ndsiz, &npnum) || (npnum == opnum && ndsiz != odsiz)){
+      eprint(hdb, __LINE__, "(validation)");
+      err = true;
+    }
+    if(!tchdbtranbegin(hdb)){
+      eprint(hdb, __LINE__, "tchdbtranbegin");
+      err = true;
+    }
+    int tnum = 16;
+    for(int i = 0; i < tnum; i++){
+      char kbuf[RECBUFSIZ];
+      int ksiz = sprintf(kbuf, "vlog:%d", i);
+      if(!tchdbput(hdb, kbuf, ksiz, vbuf, vsiz)){
+        eprint(hdb, __LINE__, "tchdbput");
+        err = true;
+      }
+    }
+    if(!tchdbout(hdb, "vlog", 4)){
+      eprint(hdb, __LINE__, "tchdbout");
+      err = true;
+    }
+    if(!tchdbtranabort(hdb)){
+      eprint(hdb, __LINE__, "tchdbtranabort");
+      err = true;
+    }
+    if(!tchdbvlogstat(hdb, &nsiz, &ndsiz, &npnum) ||
+       (npnum == opnum && ndsiz != odsiz + (nsiz - osiz)) ||
+       (!(opts & (HDBTDEFLATE | HDBTBZIP | HDBTTCBS | HDBTEXCODEC | HDBTLZ)) &&
+        nsiz < osiz + (uint64_t)vsiz * tnum) || tchdbrnum(hdb) != 1){
+      eprint(hdb, __LINE__, "(validation)");
+      err = true;
+    }
+    if(!tchdbout(hdb, "vlog", 4)){
+      eprint(hdb, __LINE__, "tchdbout");
+      err = true;
+    }
+  }
   iprintf("record number: %llu\n", (unsigned long long)tchdbrnum(hdb));
   iprintf("size: %llu\n", (unsigned long long)tchdbfsiz(hdb));
+  uint64_t vlsiz, vldsiz, vlpnum;
+  if(vlthres > 0 && tchdbvlogstat(hdb, &vlsiz, &vldsiz, &vlpnum))
+    iprintf("value log: size=%llu  dead=%llu  passes=%llu\n", (unsigned long long)vlsiz,
+            (unsigned long long)vldsiz, (unsigned long long)vlpnum);
   mprint(hdb);
   sysprint();
   tcmapdel(map);
@@ -2126,4 +2924,267 @@ static int procwicked(const char *path, int rnum, bool mt, int opts, int omode){
 
 
 
+/* perform expire command */
+static int procexpire(const char *path, int rnum, bool mt, int opts, int rcnum, int vlthres,
+                      int otnum, int omode){
+  iprintf("<Expiration Test>\n  seed=%u  path=%s  rnum=%d  mt=%d  opts=%d  rcnum=%d"
+          "  vlthres=%d  otnum=%d  omode=%d\n\n",
+          g_randseed, path, rnum, mt, opts, rcnum, vlthres, otnum, omode);
+  bool err = false;
+  double stime = tctime();
+  TCHDB *hdb = tchdbnew();
+  if(g_dbgfd >= 0) tchdbsetdbgfd(hdb, g_dbgfd);
+  if(mt && !tchdbsetmutex(hdb)){
+    eprint(hdb, __LINE__, "tchdbsetmutex");
+    err = true;
+  }
+  if(!tchdbsetcodecfunc(hdb, _tc_recencode, NULL, _tc_recdecode, NULL)){
+    eprint(hdb, __LINE__, "tchdbsetcodecfunc");
+    err = true;
+  }
+  if(!tchdbtune(hdb, rnum / 50, 2, -1, opts)){
+    eprint(hdb, __LINE__, "tchdbtune");
+    err = true;
+  }
+  if(!tchdbsetcache(hdb, rcnum)){
+    eprint(hdb, __LINE__, "tchdbsetcache");
+    err = true;
+  }
+  if(!tchdbsetdfunit(hdb, 8)){
+    eprint(hdb, __LINE__, "tchdbsetdfunit");
+    err = true;
+  }
+  if(vlthres > 0 && !tchdbsetvlog(hdb, vlthres)){
+    eprint(hdb, __LINE__, "tchdbsetvlog");
+    err = true;
+  }
+  if(otnum > 0 && !tchdbsetoptthreads(hdb, otnum)){
+    eprint(hdb, __LINE__, "tchdbsetoptthreads");
+    err = true;
+  }
+  if(!tchdbopen(hdb, path, HDBOWRITER | HDBOCREAT | HDBOTRUNC | omode)){
+    eprint(hdb, __LINE__, "tchdbopen");
+    err = true;
+  }
+  TCMAP *map = tcmapnew2(rnum / 5);
+  TCMAP *xmap = tcmapnew2(rnum / 5);
+  int64_t xfar = (int64_t)time(NULL) + INT16_MAX * 100;
+  for(int i = 1; i <= rnum && !err; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "%08d", myrand(rnum) + 1);
+    char vbuf[RECBUFSIZ*4];
+    int vsiz = myrand(myrand(10) == 0 ? sizeof(vbuf) : RECBUFSIZ);
+    memset(vbuf, '*', vsiz);
+    char xbuf[RECBUFSIZ];
+    int xsiz;
+    int64_t xt;
+    switch(myrand(10)){
+      case 0:
+        iputchar('0');
+        if(!tchdbput(hdb, kbuf, ksiz, vbuf, vsiz)){
+          eprint(hdb, __LINE__, "tchdbput");
+          err = true;
+        }
+        tcmapput(map, kbuf, ksiz, vbuf, vsiz);
+        tcmapout(xmap, kbuf, ksiz);
+        break;
+      case 1:
+      case 2:
+        iputchar('1');
+        xt = xfar + myrand(100);
+        if(!tchdbputxt(hdb, kbuf, ksiz, vbuf, vsiz, -xt)){
+          eprint(hdb, __LINE__, "tchdbputxt");
+          err = true;
+        }
+        tcmapput(map, kbuf, ksiz, vbuf, vsiz);
+        xsiz = sprintf(xbuf, "%lld", (long long)xt);
+        tcmapput(xmap, kbuf, ksiz, xbuf, xsiz);
+        break;
+      case 3:
+        iputchar('2');
+        if(!tchdbputxt(hdb, kbuf, ksiz, vbuf, vsiz, INT16_MAX)){
+          eprint(hdb, __LINE__, "tchdbputxt");
+          err = true;
+        }
+        xt = tchdbgetxt(hdb, kbuf, ksiz);
+        if(xt < (int64_t)time(NULL) + INT16_MAX - 1 || xt > (int64_t)time(NULL) + INT16_MAX){
+          eprint(hdb, __LINE__, "tchdbgetxt");
+          err = true;
+        }
+        tcmapput(map, kbuf, ksiz, vbuf, vsiz);
+        xsiz = sprintf(xbuf, "%lld", (long long)xt);
+        tcmapput(xmap, kbuf, ksiz, xbuf, xsiz);
+        break;
+      case 4:
+      case 5:
+        iputchar('3');
+        if(!tchdbputxt(hdb, kbuf, ksiz, vbuf, vsiz, -1 - myrand(100))){
+          eprint(hdb, __LINE__, "tchdbputxt");
+          err = true;
+        }
+        tcmapout(map, kbuf, ksiz);
+        tcmapout(xmap, kbuf, ksiz);
+        break;
+      case 6:
+        iputchar('4');
+        if(tchdbputkeep(hdb, kbuf, ksiz, vbuf, vsiz)){
+          if(tcmapget(map, kbuf, ksiz, &xsiz)){
+            eprint(hdb, __LINE__, "tchdbputkeep");
+            err = true;
+          }
+          tcmapput(map, kbuf, ksiz, vbuf, vsiz);
+          tcmapout(xmap, kbuf, ksiz);
+        } else if(tchdbecode(hdb) != TCEKEEP || !tcmapget(map, kbuf, ksiz, &xsiz)){
+          eprint(hdb, __LINE__, "tchdbputkeep");
+          err = true;
+        }
+        break;
+      case 7:
+        iputchar('5');
+        if(!tchdbputcat(hdb, kbuf, ksiz, vbuf, vsiz)){
+          eprint(hdb, __LINE__, "tchdbputcat");
+          err = true;
+        }
+        tcmapputcat(map, kbuf, ksiz, vbuf, vsiz);
+        break;
+      case 8:
+        iputchar('6');
+        if(tchdbout(hdb, kbuf, ksiz)){
+          if(!tcmapget(map, kbuf, ksiz, &xsiz)){
+            eprint(hdb, __LINE__, "tchdbout");
+            err = true;
+          }
+        } else if(tchdbecode(hdb) != TCENOREC || tcmapget(map, kbuf, ksiz, &xsiz)){
+          eprint(hdb, __LINE__, "tchdbout");
+          err = true;
+        }
+        tcmapout(map, kbuf, ksiz);
+        tcmapout(xmap, kbuf, ksiz);
+        break;
+      default:
+        iputchar('7');
+        if(myrand(rnum / 50 + 1) == 0){
+          if(!tchdbdefrag(hdb, myrand(2) == 0 ? 0 : myrand(rnum / 10 + 1) + 1)){
+            eprint(hdb, __LINE__, "tchdbdefrag");
+            err = true;
+          }
+        } else if(myrand(rnum / 20 + 1) == 0){
+          if(!tchdboptimize(hdb, -1, -1, -1, UINT8_MAX)){
+            eprint(hdb, __LINE__, "tchdboptimize");
+            err = true;
+          }
+        } else {
+          const char *mbuf = tcmapget(map, kbuf, ksiz, &xsiz);
+          int rsiz;
+          char *rbuf = tchdbget(hdb, kbuf, ksiz, &rsiz);
+          if(mbuf ? (!rbuf || rsiz != xsiz || memcmp(rbuf, mbuf, rsiz)) : rbuf != NULL){
+            eprint(hdb, __LINE__, "tchdbget");
+            err = true;
+          }
+          tcfree(rbuf);
+        }
+        break;
+    }
+    if(i % 50 == 0) iprintf(" (%08d)\n", i);
+  }
+  if(rnum % 50 > 0) iprintf(" (%08d)\n", rnum);
+  if(!expirecheck(hdb, rnum, map, xmap)) err = true;
+  if(!tchdbdefrag(hdb, 0)){
+    eprint(hdb, __LINE__, "tchdbdefrag");
+    err = true;
+  }
+  if(tchdbrnum(hdb) != tcmaprnum(map)){
+    eprint(hdb, __LINE__, "(validation)");
+    err = true;
+  }
+  if(!expirecheck(hdb, rnum, map, xmap)) err = true;
+  for(int i = 1; i <= rnum / 10; i++){
+    char kbuf[RECBUFSIZ];
+    int ksiz = sprintf(kbuf, "%08d", myrand(rnum) + 1);
+    if(!tchdbputxt(hdb, kbuf, ksiz, kbuf, ksiz, -1)){
+      eprint(hdb, __LINE__, "tchdbputxt");
+      err = true;
+      break;
+    }
+    tcmapout(map, kbuf, ksiz);
+    tcmapout(xmap, kbuf, ksiz);
+  }
+  if(!tchdboptimize(hdb, -1, -1, -1, UINT8_MAX)){
+    eprint(hdb, __LINE__, "tchdboptimize");
+    err = true;
+  }
+  if(tchdbrnum(hdb) != tcmaprnum(map)){
+    eprint(hdb, __LINE__, "(validation)");
+    err = true;
+  }
+  if(!expirecheck(hdb, rnum, map, xmap)) err = true;
+  if(tcmaprnum(xmap) > 0 && !(tchdbflags(hdb) & HDBFEXPIRE)){
+    eprint(hdb, __LINE__, "tchdbflags");
+    err = true;
+  }
+  tcmapiterinit(xmap);
+  const char *xkbuf;
+  int xksiz;
+  while((xkbuf = tcmapiternext(xmap, &xksiz)) != NULL){
+    int vsiz;
+    const char *vbuf = tcmapget(map, xkbuf, xksiz, &vsiz);
+    if(!tchdbput(hdb, xkbuf, xksiz, vbuf, vsiz)){
+      eprint(hdb, __LINE__, "tchdbput");
+      err = true;
+      break;
+    }
+  }
+  tcmapclear(xmap);
+  if(!tchdbdefrag(hdb, 0)){
+    eprint(hdb, __LINE__, "tchdbdefrag");
+    err = true;
+  }
+  if(tchdbflags(hdb) & HDBFEXPIRE){
+    eprint(hdb, __LINE__, "tchdbflags");
+    err = true;
+  }
+  if(!expirecheck(hdb, rnum, map, xmap)) err = true;
+  char xbuf[RECBUFSIZ];
+  int xsiz = sprintf(xbuf, "%08d", myrand(rnum) + 1);
+  if(!tchdbputxt(hdb, xbuf, xsiz, xbuf, xsiz, INT16_MAX)){
+    eprint(hdb, __LINE__, "tchdbputxt");
+    err = true;
+  }
+  tcmapput(map, xbuf, xsiz, xbuf, xsiz);
+  tcmapprintf(xmap, xbuf, "%lld", (long long)tchdbgetxt(hdb, xbuf, xsiz));
+  if(!tchdbdefrag(hdb, 0)){
+    eprint(hdb, __LINE__, "tchdbdefrag");
+    err = true;
+  }
+  if(!(tchdbflags(hdb) & HDBFEXPIRE)){
+    eprint(hdb, __LINE__, "tchdbflags");
+    err = true;
+  }
+  if(!expirecheck(hdb, rnum, map, xmap)) err = true;
+  if(!tchdbclose(hdb)){
+    eprint(hdb, __LINE__, "tchdbclose");
+    err = true;
+  }
+  if(!tchdbopen(hdb, path, HDBOREADER | omode)){
+    eprint(hdb, __LINE__, "tchdbopen");
+    err = true;
+  }
+  if(!expirecheck(hdb, rnum, map, xmap)) err = true;
+  iprintf("record number: %llu\n", (unsigned long long)tchdbrnum(hdb));
+  iprintf("size: %llu\n", (unsigned long long)tchdbfsiz(hdb));
+  mprint(hdb);
+  sysprint();
+  tcmapdel(xmap);
+  tcmapdel(map);
+  if(!tchdbclose(hdb)){
+    eprint(hdb, __LINE__, "tchdbclose");
+    err = true;
+  }
+  tchdbdel(hdb);
+  iprintf("time: %.3f\n", tctime() - stime);
+  iprintf("%s\n\n", err ? "error" : "ok");
+  return err ? 1 : 0;
+}
+
+
 // END OF FILE
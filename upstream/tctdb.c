@@ -182,6 +182,7 @@ TCTDB *tctdbnew(void){
   TCMALLOC(tdb, sizeof(*tdb));
   tctdbclear(tdb);
   tdb->hdb = tchdbnew();
+  tdb->stats = tcstatsnew();
   tchdbtune(tdb->hdb, TDBDEFBNUM, TDBDEFAPOW, TDBDEFFPOW, 0);
   tchdbsetxmsiz(tdb->hdb, TDBDEFXMSIZ);
   return tdb;
@@ -192,6 +193,7 @@ TCTDB *tctdbnew(void){
 void tctdbdel(TCTDB *tdb){
   assert(tdb);
   if(tdb->open) tctdbclose(tdb);
+  tcstatsdel(tdb->stats);
   tchdbdel(tdb->hdb);
   if(tdb->mmtx){
     pthread_rwlock_destroy(tdb->mmtx);
@@ -241,6 +243,7 @@ bool tctdbtune(TCTDB *tdb, int64_t bnum, int8_t apow, int8_t fpow, uint8_t opts)
   if(opts & TDBTDEFLATE) hopts |= HDBTDEFLATE;
   if(opts & TDBTBZIP) hopts |= HDBTBZIP;
   if(opts & TDBTTCBS) hopts |= HDBTTCBS;
+  if(opts & TDBTLZ) hopts |= HDBTLZ;
   if(opts & TDBTEXCODEC) hopts |= HDBTEXCODEC;
   bnum = (bnum > 0) ? bnum : TDBDEFBNUM;
   apow = (apow >= 0) ? apow : TDBDEFAPOW;
@@ -273,6 +276,17 @@ bool tctdbsetxmsiz(TCTDB *tdb, int64_t xmsiz){
 }
 
 
+/* Set the options of the mapped region of a table database object. */
+bool tctdbsetmapopts(TCTDB *tdb, int mopts){
+  assert(tdb);
+  if(tdb->open){
+    tctdbsetecode(tdb, TCEINVALID, __FILE__, __LINE__, __func__);
+    return false;
+  }
+  return tchdbsetmapopts(tdb->hdb, mopts);
+}
+
+
 /* Set the unit step number of auto defragmentation of a table database object. */
 bool tctdbsetdfunit(TCTDB *tdb, int32_t dfunit){
   assert(tdb);
@@ -317,6 +331,7 @@ bool tctdbclose(TCTDB *tdb){
 /* Store a record into a table database object. */
 bool tctdbput(TCTDB *tdb, const void *pkbuf, int pksiz, TCMAP *cols){
   assert(tdb && pkbuf && pksiz >= 0 && cols);
+  uint64_t stime = tcstatsclock();
   int vsiz;
   if(tcmapget(cols, "", 0, &vsiz)){
     tctdbsetecode(tdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -330,6 +345,7 @@ bool tctdbput(TCTDB *tdb, const void *pkbuf, int pksiz, TCMAP *cols){
   }
   bool rv = tctdbputimpl(tdb, pkbuf, pksiz, cols, TDBPDOVER);
   TDBUNLOCKMETHOD(tdb);
+  tcstatsop(tdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -357,6 +373,7 @@ bool tctdbput3(TCTDB *tdb, const char *pkstr, const char *cstr){
 /* Store a new record into a table database object. */
 bool tctdbputkeep(TCTDB *tdb, const void *pkbuf, int pksiz, TCMAP *cols){
   assert(tdb && pkbuf && pksiz >= 0 && cols);
+  uint64_t stime = tcstatsclock();
   int vsiz;
   if(tcmapget(cols, "", 0, &vsiz)){
     tctdbsetecode(tdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -370,6 +387,7 @@ bool tctdbputkeep(TCTDB *tdb, const void *pkbuf, int pksiz, TCMAP *cols){
   }
   bool rv = tctdbputimpl(tdb, pkbuf, pksiz, cols, TDBPDKEEP);
   TDBUNLOCKMETHOD(tdb);
+  tcstatsop(tdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -397,6 +415,7 @@ bool tctdbputkeep3(TCTDB *tdb, const char *pkstr, const char *cstr){
 /* Concatenate columns of the existing record in a table database object. */
 bool tctdbputcat(TCTDB *tdb, const void *pkbuf, int pksiz, TCMAP *cols){
   assert(tdb && pkbuf && pksiz >= 0 && cols);
+  uint64_t stime = tcstatsclock();
   int vsiz;
   if(tcmapget(cols, "", 0, &vsiz)){
     tctdbsetecode(tdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -410,6 +429,7 @@ bool tctdbputcat(TCTDB *tdb, const void *pkbuf, int pksiz, TCMAP *cols){
   }
   bool rv = tctdbputimpl(tdb, pkbuf, pksiz, cols, TDBPDCAT);
   TDBUNLOCKMETHOD(tdb);
+  tcstatsop(tdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -437,6 +457,7 @@ bool tctdbputcat3(TCTDB *tdb, const char *pkstr, const char *cstr){
 /* Remove a record of a table database object. */
 bool tctdbout(TCTDB *tdb, const void *pkbuf, int pksiz){
   assert(tdb && pkbuf && pksiz >= 0);
+  uint64_t stime = tcstatsclock();
   if(!TDBLOCKMETHOD(tdb, true)) return false;
   if(!tdb->open || !tdb->wmode){
     tctdbsetecode(tdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -445,6 +466,7 @@ bool tctdbout(TCTDB *tdb, const void *pkbuf, int pksiz){
   }
   bool rv = tctdboutimpl(tdb, pkbuf, pksiz);
   TDBUNLOCKMETHOD(tdb);
+  tcstatsop(tdb->stats, TCSOOUT, stime);
   return rv;
 }
 
@@ -459,6 +481,7 @@ bool tctdbout2(TCTDB *tdb, const char *pkstr){
 /* Retrieve a record in a table database object. */
 TCMAP *tctdbget(TCTDB *tdb, const void *pkbuf, int pksiz){
   assert(tdb && pkbuf && pksiz >= 0);
+  uint64_t stime = tcstatsclock();
   if(!TDBLOCKMETHOD(tdb, false)) return NULL;
   if(!tdb->open){
     tctdbsetecode(tdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -467,6 +490,8 @@ TCMAP *tctdbget(TCTDB *tdb, const void *pkbuf, int pksiz){
   }
   TCMAP *rv = tctdbgetimpl(tdb, pkbuf, pksiz);
   TDBUNLOCKMETHOD(tdb);
+  if(!rv) tcstatsadd(tdb->stats, TCSCMISS, 1);
+  tcstatsop(tdb->stats, TCSOGET, stime);
   return rv;
 }
 
@@ -533,6 +558,7 @@ bool tctdbiterinit(TCTDB *tdb){
 /* Get the next primary key of the iterator of a table database object. */
 void *tctdbiternext(TCTDB *tdb, int *sp){
   assert(tdb && sp);
+  uint64_t stime = tcstatsclock();
   if(!TDBLOCKMETHOD(tdb, true)) return NULL;
   if(!tdb->open){
     tctdbsetecode(tdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -541,6 +567,7 @@ void *tctdbiternext(TCTDB *tdb, int *sp){
   }
   char *rv = tchdbiternext(tdb->hdb, sp);
   TDBUNLOCKMETHOD(tdb);
+  tcstatsop(tdb->stats, TCSOITER, stime);
   return rv;
 }
 
@@ -556,6 +583,7 @@ char *tctdbiternext2(TCTDB *tdb){
 /* Get the columns of the next record of the iterator of a table database object. */
 TCMAP *tctdbiternext3(TCTDB *tdb){
   assert(tdb);
+  uint64_t stime = tcstatsclock();
   TCXSTR *kstr = tcxstrnew();
   TCXSTR *vstr = tcxstrnew();
   TCMAP *cols = NULL;
@@ -565,6 +593,7 @@ TCMAP *tctdbiternext3(TCTDB *tdb){
   }
   tcxstrdel(vstr);
   tcxstrdel(kstr);
+  tcstatsop(tdb->stats, TCSOITER, stime);
   return cols;
 }
 
@@ -594,6 +623,7 @@ TCLIST *tctdbfwmkeys2(TCTDB *tdb, const char *pstr, int max){
 /* Add an integer to a column of a record in a table database object. */
 int tctdbaddint(TCTDB *tdb, const void *pkbuf, int pksiz, int num){
   assert(tdb && pkbuf && pksiz >= 0);
+  uint64_t stime = tcstatsclock();
   if(!TDBLOCKMETHOD(tdb, true)) return INT_MIN;
   if(!tdb->open){
     tctdbsetecode(tdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -602,6 +632,7 @@ int tctdbaddint(TCTDB *tdb, const void *pkbuf, int pksiz, int num){
   }
   double rv = tctdbaddnumber(tdb, pkbuf, pksiz, num);
   TDBUNLOCKMETHOD(tdb);
+  tcstatsop(tdb->stats, TCSOPUT, stime);
   return isnan(rv) ? INT_MIN : (int)rv;
 }
 
@@ -609,6 +640,7 @@ int tctdbaddint(TCTDB *tdb, const void *pkbuf, int pksiz, int num){
 /* Add a real number to a column of a record in a table database object. */
 double tctdbadddouble(TCTDB *tdb, const void *pkbuf, int pksiz, double num){
   assert(tdb && pkbuf && pksiz >= 0);
+  uint64_t stime = tcstatsclock();
   if(!TDBLOCKMETHOD(tdb, true)) return INT_MIN;
   if(!tdb->open){
     tctdbsetecode(tdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -617,6 +649,7 @@ double tctdbadddouble(TCTDB *tdb, const void *pkbuf, int pksiz, double num){
   }
   double rv = tctdbaddnumber(tdb, pkbuf, pksiz, num);
   TDBUNLOCKMETHOD(tdb);
+  tcstatsop(tdb->stats, TCSOPUT, stime);
   return rv;
 }
 
@@ -624,6 +657,7 @@ double tctdbadddouble(TCTDB *tdb, const void *pkbuf, int pksiz, double num){
 /* Synchronize updated contents of a table database object with the file and the device. */
 bool tctdbsync(TCTDB *tdb){
   assert(tdb);
+  uint64_t stime = tcstatsclock();
   if(!TDBLOCKMETHOD(tdb, true)) return false;
   if(!tdb->open || !tdb->wmode || tdb->tran){
     tctdbsetecode(tdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -632,6 +666,7 @@ bool tctdbsync(TCTDB *tdb){
   }
   bool rv = tctdbmemsync(tdb, true);
   TDBUNLOCKMETHOD(tdb);
+  tcstatsop(tdb->stats, TCSOSYNC, stime);
   return rv;
 }
 
@@ -712,6 +747,7 @@ bool tctdbtranbegin(TCTDB *tdb){
 /* Commit the transaction of a table database object. */
 bool tctdbtrancommit(TCTDB *tdb){
   assert(tdb);
+  uint64_t stime = tcstatsclock();
   if(!TDBLOCKMETHOD(tdb, true)) return false;
   if(!tdb->open || !tdb->wmode || !tdb->tran){
     tctdbsetecode(tdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -722,6 +758,7 @@ bool tctdbtrancommit(TCTDB *tdb){
   bool err = false;
   if(!tctdbtrancommitimpl(tdb)) err = true;
   TDBUNLOCKMETHOD(tdb);
+  tcstatsop(tdb->stats, TCSOTRAN, stime);
   return !err;
 }
 
@@ -1514,10 +1551,18 @@ bool tctdbcacheclear(TCTDB *tdb){
 }
 
 
+/* Get the statistics of operations of a table database object. */
+TCSTATS *tctdbstats(TCTDB *tdb){
+  assert(tdb);
+  return tdb->stats;
+}
+
+
 /* Store a record into a table database object with a duplication handler. */
 bool tctdbputproc(TCTDB *tdb, const void *pkbuf, int pksiz, const void *cbuf, int csiz,
                   TCPDPROC proc, void *op){
   assert(tdb && pkbuf && pksiz >= 0 && proc);
+  uint64_t stime = tcstatsclock();
   if(!TDBLOCKMETHOD(tdb, true)) return false;
   if(!tdb->open || !tdb->wmode){
     tctdbsetecode(tdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -1555,6 +1600,7 @@ bool tctdbputproc(TCTDB *tdb, const void *pkbuf, int pksiz, const void *cbuf, in
     }
   }
   TDBUNLOCKMETHOD(tdb);
+  tcstatsop(tdb->stats, TCSOPUT, stime);
   return !err;
 }
 
@@ -1562,6 +1608,7 @@ bool tctdbputproc(TCTDB *tdb, const void *pkbuf, int pksiz, const void *cbuf, in
 /* Retrieve the value of a column of a record in a table database object. */
 char *tctdbget4(TCTDB *tdb, const void *pkbuf, int pksiz, const void *nbuf, int nsiz, int *sp){
   assert(tdb && pkbuf && pksiz >= 0 && nbuf && nsiz >= 0 && sp);
+  uint64_t stime = tcstatsclock();
   if(!TDBLOCKMETHOD(tdb, false)) return NULL;
   if(!tdb->open){
     tctdbsetecode(tdb, TCEINVALID, __FILE__, __LINE__, __func__);
@@ -1570,6 +1617,8 @@ char *tctdbget4(TCTDB *tdb, const void *pkbuf, int pksiz, const void *nbuf, int
   }
   char *rv = tctdbgetonecol(tdb, pkbuf, pksiz, nbuf, nsiz, sp);
   TDBUNLOCKMETHOD(tdb);
+  if(!rv) tcstatsadd(tdb->stats, TCSCMISS, 1);
+  tcstatsop(tdb->stats, TCSOGET, stime);
   return rv;
 }
 
@@ -1925,6 +1974,7 @@ static void tctdbclear(TCTDB *tdb){
   tdb->idxs = NULL;
   tdb->inum = 0;
   tdb->tran = false;
+  tdb->stats = NULL;
 }
 
 
@@ -2044,6 +2094,7 @@ static bool tctdbopenimpl(TCTDB *tdb, const char *path, int omode){
   if(hopts & HDBTDEFLATE) opts |= TDBTDEFLATE;
   if(hopts & HDBTBZIP) opts |= TDBTBZIP;
   if(hopts & HDBTTCBS) opts |= TDBTTCBS;
+  if(hopts & HDBTLZ) opts |= TDBTLZ;
   if(hopts & HDBTEXCODEC) opts |= TDBTEXCODEC;
   tdb->opts = opts;
   tdb->tran = false;
@@ -2127,6 +2178,7 @@ static bool tctdbputimpl(TCTDB *tdb, const void *pkbuf, int pksiz, TCMAP *cols,
       int csiz;
       char *cbuf = tcmapdump(ocols, &csiz);
       if(!tchdbput(tdb->hdb, pkbuf, pksiz, cbuf, csiz)) err = true;
+      tcstatsadd(tdb->stats, TCSCWRITE, csiz);
       TCFREE(cbuf);
     } else {
       TCMAP *ncols = tcmapnew2(TCMAPRNUM(cols) + 1);
@@ -2150,6 +2202,7 @@ static bool tctdbputimpl(TCTDB *tdb, const void *pkbuf, int pksiz, TCMAP *cols,
       int csiz;
       char *cbuf = tcmapdump(cols, &csiz);
       if(!tchdbput(tdb->hdb, pkbuf, pksiz, cbuf, csiz)) err = true;
+      tcstatsadd(tdb->stats, TCSCWRITE, csiz);
       TCFREE(cbuf);
     }
     tcmapdel(ocols);
@@ -2159,6 +2212,7 @@ static bool tctdbputimpl(TCTDB *tdb, const void *pkbuf, int pksiz, TCMAP *cols,
     int csiz;
     char *cbuf = tcmapdump(cols, &csiz);
     if(!tchdbput(tdb->hdb, pkbuf, pksiz, cbuf, csiz)) err = true;
+    tcstatsadd(tdb->stats, TCSCWRITE, csiz);
     TCFREE(cbuf);
   }
   return !err;
@@ -2195,6 +2249,7 @@ static TCMAP *tctdbgetimpl(TCTDB *tdb, const void *pkbuf, int pksiz){
   int csiz;
   char *cbuf = tchdbget(tdb->hdb, pkbuf, pksiz, &csiz);
   if(!cbuf) return NULL;
+  tcstatsadd(tdb->stats, TCSCREAD, csiz);
   TCMAP *cols = tcmapload(cbuf, csiz);
   TCFREE(cbuf);
   return cols;
@@ -2314,6 +2369,7 @@ static bool tctdboptimizeimpl(TCTDB *tdb, int64_t bnum, int8_t apow, int8_t fpow
   if(opts & TDBTDEFLATE) hopts |= HDBTDEFLATE;
   if(opts & TDBTBZIP) hopts |= HDBTBZIP;
   if(opts & TDBTTCBS) hopts |= HDBTTCBS;
+  if(opts & TDBTLZ) hopts |= HDBTLZ;
   if(opts & TDBTEXCODEC) hopts |= HDBTEXCODEC;
   tchdbtune(thdb, bnum, apow, fpow, hopts);
   if(tchdbopen(thdb, tpath, HDBOWRITER | HDBOCREAT | HDBOTRUNC)){
@@ -2685,6 +2741,7 @@ static bool tctdbsetindeximpl(TCTDB *tdb, const char *name, int type){
   if(opts & TDBTDEFLATE) bopts |= BDBTDEFLATE;
   if(opts & TDBTBZIP) bopts |= BDBTBZIP;
   if(opts & TDBTTCBS) bopts |= BDBTTCBS;
+  if(opts & TDBTLZ) bopts |= BDBTLZ;
   if(opts & TDBTEXCODEC) bopts |= BDBTEXCODEC;
   switch(type){
     case TDBITLEXICAL:
@@ -58,6 +58,7 @@ typedef struct {                         /* type of structure for a table databa
   TDBIDX *idxs;                          /* column indices */
   int inum;                              /* number of column indices */
   bool tran;                             /* whether in the transaction */
+  TCSTATS *stats;                        /* statistics of operations */
 } TCTDB;
 
 enum {                                   /* enumeration for additional flags */
@@ -70,7 +71,8 @@ enum {                                   /* enumeration for tuning options */
   TDBTDEFLATE = 1 << 1,                  /* compress each page with Deflate */
   TDBTBZIP = 1 << 2,                     /* compress each record with BZIP2 */
   TDBTTCBS = 1 << 3,                     /* compress each page with TCBS */
-  TDBTEXCODEC = 1 << 4                   /* compress each record with outer functions */
+  TDBTEXCODEC = 1 << 4,                  /* compress each record with outer functions */
+  TDBTLZ = 1 << 5                        /* compress each page with LZ */
 };
 
 enum {                                   /* enumeration for open modes */
@@ -83,6 +85,15 @@ enum {                                   /* enumeration for open modes */
   TDBOTSYNC = 1 << 6                     /* synchronize every transaction */
 };
 
+enum {                                   /* enumeration for mapping options */
+  TDBMHUGE = HDBMHUGE,                   /* back the bucket array with huge pages */
+  TDBMLOCK = HDBMLOCK,                   /* lock the bucket array in memory */
+  TDBMBRANDOM = HDBMBRANDOM,             /* advise random access to the bucket array */
+  TDBMBWILLNEED = HDBMBWILLNEED,         /* read the bucket array ahead */
+  TDBMRRANDOM = HDBMRRANDOM,             /* advise random access to the mapped records */
+  TDBMRWILLNEED = HDBMRWILLNEED          /* read the mapped records ahead */
+};
+
 enum {                                   /* enumeration for index types */
   TDBITLEXICAL,                          /* lexical string */
   TDBITDECIMAL,                          /* decimal string */
@@ -225,7 +236,8 @@ bool tctdbsetmutex(TCTDB *tdb);
    `opts' specifies options by bitwise-or: `TDBTLARGE' specifies that the size of the database
    can be larger than 2GB by using 64-bit bucket array, `TDBTDEFLATE' specifies that each record
    is compressed with Deflate encoding, `TDBTBZIP' specifies that each record is compressed with
-   BZIP2 encoding, `TDBTTCBS' specifies that each record is compressed with TCBS encoding.
+   BZIP2 encoding, `TDBTTCBS' specifies that each record is compressed with TCBS encoding,
+   `TDBTLZ' specifies that each record is compressed with LZ encoding.
    If successful, the return value is true, else, it is false.
    Note that the tuning parameters should be set before the database is opened. */
 bool tctdbtune(TCTDB *tdb, int64_t bnum, int8_t apow, int8_t fpow, uint8_t opts);
@@ -254,6 +266,16 @@ bool tctdbsetcache(TCTDB *tdb, int32_t rcnum, int32_t lcnum, int32_t ncnum);
 bool tctdbsetxmsiz(TCTDB *tdb, int64_t xmsiz);
 
 
+/* Set the options of the mapped region of a table database object.
+   `tdb' specifies the table database object which is not opened.
+   `mopts' specifies options by bitwise-or: `TDBMHUGE', `TDBMLOCK', `TDBMBRANDOM',
+   `TDBMBWILLNEED', `TDBMRRANDOM', and `TDBMRWILLNEED'.  They have the same meanings as
+   the options of `tchdbsetmapopts'.  By default, no option is specified.
+   If successful, the return value is true, else, it is false.
+   Note that the mapping parameters should be set before the database is opened. */
+bool tctdbsetmapopts(TCTDB *tdb, int mopts);
+
+
 /* Set the unit step number of auto defragmentation of a table database object.
    `tdb' specifies the table database object which is not opened.
    `dfunit' specifie the unit step number.  If it is not more than 0, the auto defragmentation
@@ -568,8 +590,8 @@ bool tctdbsync(TCTDB *tdb);
    `opts' specifies options by bitwise-or: `BDBTLARGE' specifies that the size of the database
    can be larger than 2GB by using 64-bit bucket array, `BDBTDEFLATE' specifies that each record
    is compressed with Deflate encoding, `BDBTBZIP' specifies that each record is compressed with
-   BZIP2 encoding, `BDBTTCBS' specifies that each record is compressed with TCBS encoding.  If it
-   is `UINT8_MAX', the current setting is not changed.
+   BZIP2 encoding, `BDBTTCBS' specifies that each record is compressed with TCBS encoding,
+   `BDBTLZ' specifies that each record is compressed with LZ encoding.  If it is `UINT8_MAX', the current setting is not changed.
    If successful, the return value is true, else, it is false.
    This function is useful to reduce the size of the database file with data fragmentation by
    successive updating. */
@@ -931,6 +953,14 @@ bool tctdbdefrag(TCTDB *tdb, int64_t step);
 bool tctdbcacheclear(TCTDB *tdb);
 
 
+/* Get the statistics of operations of a table database object.
+   `tdb' specifies the table database object.
+   The return value is the statistics object of the database.  It is updated by every thread
+   calling the API of the object and valid until the object is deleted.  Read and written bytes
+   are counted by serialized records. */
+TCSTATS *tctdbstats(TCTDB *tdb);
+
+
 /* Store a record into a table database object with a duplication handler.
    `tdb' specifies the table database object connected as a writer.
    `pkbuf' specifies the pointer to the region of the primary key.
@@ -98,18 +98,18 @@ static void usage(void){
   fprintf(stderr, "%s: test cases of the table database API of Tokyo Cabinet\n", g_progname);
   fprintf(stderr, "\n");
   fprintf(stderr, "usage:\n");
-  fprintf(stderr, "  %s write [-mt] [-tl] [-td|-tb|-tt|-tx] [-rc num] [-lc num] [-nc num]"
+  fprintf(stderr, "  %s write [-mt] [-tl] [-td|-tb|-tt|-ts|-tx] [-rc num] [-lc num] [-nc num]"
           " [-xm num] [-df num] [-ip] [-is] [-in] [-it] [-if] [-ix] [-nl|-nb] [-rnd]"
           " path rnum [bnum [apow [fpow]]]\n", g_progname);
   fprintf(stderr, "  %s read [-mt] [-rc num] [-lc num] [-nc num] [-xm num] [-df num]"
           " [-nl|-nb] [-rnd] path\n", g_progname);
   fprintf(stderr, "  %s remove [-mt] [-rc num] [-lc num] [-nc num] [-xm num] [-df num]"
           " [-nl|-nb] [-rnd] path\n", g_progname);
-  fprintf(stderr, "  %s rcat [-mt] [-tl] [-td|-tb|-tt|-tx] [-rc num] [-lc num] [-nc num]"
+  fprintf(stderr, "  %s rcat [-mt] [-tl] [-td|-tb|-tt|-ts|-tx] [-rc num] [-lc num] [-nc num]"
           " [-xm num] [-df num] [-ip] [-is] [-in] [-it] [-if] [-ix] [-nl|-nb] [-pn num]"
           " [-dai|-dad|-rl|-ru] path rnum [bnum [apow [fpow]]]\n", g_progname);
-  fprintf(stderr, "  %s misc [-mt] [-tl] [-td|-tb|-tt|-tx] [-nl|-nb] path rnum\n", g_progname);
-  fprintf(stderr, "  %s wicked [-mt] [-tl] [-td|-tb|-tt|-tx] [-nl|-nb] path rnum\n", g_progname);
+  fprintf(stderr, "  %s misc [-mt] [-tl] [-td|-tb|-tt|-ts|-tx] [-nl|-nb] path rnum\n", g_progname);
+  fprintf(stderr, "  %s wicked [-mt] [-tl] [-td|-tb|-tt|-ts|-tx] [-nl|-nb] path rnum\n", g_progname);
   fprintf(stderr, "\n");
   exit(1);
 }
@@ -220,6 +220,8 @@ static int runwrite(int argc, char **argv){
         opts |= TDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= TDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= TDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= TDBTEXCODEC;
       } else if(!strcmp(argv[i], "-rc")){
@@ -419,6 +421,8 @@ static int runrcat(int argc, char **argv){
         opts |= TDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= TDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= TDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= TDBTEXCODEC;
       } else if(!strcmp(argv[i], "-xm")){
@@ -511,6 +515,8 @@ static int runmisc(int argc, char **argv){
         opts |= TDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= TDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= TDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= TDBTEXCODEC;
       } else if(!strcmp(argv[i], "-nl")){
@@ -555,6 +561,8 @@ static int runwicked(int argc, char **argv){
         opts |= TDBTBZIP;
       } else if(!strcmp(argv[i], "-tt")){
         opts |= TDBTTCBS;
+      } else if(!strcmp(argv[i], "-ts")){
+        opts |= TDBTLZ;
       } else if(!strcmp(argv[i], "-tx")){
         opts |= TDBTEXCODEC;
       } else if(!strcmp(argv[i], "-nl")){
@@ -33,6 +33,7 @@ static int runmime(int argc, char **argv);
 static int runhex(int argc, char **argv);
 static int runpack(int argc, char **argv);
 static int runtcbs(int argc, char **argv);
+static int runlz(int argc, char **argv);
 static int runzlib(int argc, char **argv);
 static int runbzip(int argc, char **argv);
 static int runxml(int argc, char **argv);
@@ -51,6 +52,7 @@ static int procmime(const char *ibuf, int isiz, bool dec, const char *ename, boo
 static int prochex(const char *ibuf, int isiz, bool dec);
 static int procpack(const char *ibuf, int isiz, bool dec, bool bwt);
 static int proctcbs(const char *ibuf, int isiz, bool dec);
+static int proclz(const char *ibuf, int isiz, bool dec);
 static int proczlib(const char *ibuf, int isiz, bool dec, bool gz);
 static int procbzip(const char *ibuf, int isiz, bool dec);
 static int procxml(const char *ibuf, int isiz, bool dec, bool br);
@@ -82,6 +84,8 @@ int main(int argc, char **argv){
     rv = runpack(argc, argv);
   } else if(!strcmp(argv[1], "tcbs")){
     rv = runtcbs(argc, argv);
+  } else if(!strcmp(argv[1], "lz")){
+    rv = runlz(argc, argv);
   } else if(!strcmp(argv[1], "zlib")){
     rv = runzlib(argc, argv);
   } else if(!strcmp(argv[1], "bzip")){
@@ -122,6 +126,7 @@ static void usage(void){
   fprintf(stderr, "  %s hex [-d] [file]\n", g_progname);
   fprintf(stderr, "  %s pack [-d] [-bwt] [file]\n", g_progname);
   fprintf(stderr, "  %s tcbs [-d] [file]\n", g_progname);
+  fprintf(stderr, "  %s lz [-d] [file]\n", g_progname);
   fprintf(stderr, "  %s zlib [-d] [-gz] [file]\n", g_progname);
   fprintf(stderr, "  %s bzip [-d] [file]\n", g_progname);
   fprintf(stderr, "  %s xml [-d] [-br] [file]\n", g_progname);
@@ -431,6 +436,42 @@ static int runtcbs(int argc, char **argv){
 }
 
 
+/* parse arguments of lz command */
+static int runlz(int argc, char **argv){
+  char *path = NULL;
+  bool dec = false;
+  for(int i = 2; i < argc; i++){
+    if(!path && argv[i][0] == '-'){
+      if(!strcmp(argv[i], "-d")){
+        dec = true;
+      } else {
+        usage();
+      }
+    } else if(!path){
+      path = argv[i];
+    } else {
+      usage();
+    }
+  }
+  char *ibuf;
+  int isiz;
+  if(path && path[0] == '@'){
+    isiz = strlen(path) - 1;
+    ibuf = tcmemdup(path + 1, isiz);
+  } else {
+    ibuf = tcreadfile(path, -1, &isiz);
+  }
+  if(!ibuf){
+    eprintf("%s: cannot open", path ? path : "(stdin)");
+    return 1;
+  }
+  int rv = proclz(ibuf, isiz, dec);
+  if(path && path[0] == '@') printf("\n");
+  tcfree(ibuf);
+  return rv;
+}
+
+
 /* parse arguments of zlib command */
 static int runzlib(int argc, char **argv){
   char *path = NULL;
@@ -992,6 +1033,27 @@ static int proctcbs(const char *ibuf, int isiz, bool dec){
 }
 
 
+/* perform lz command */
+static int proclz(const char *ibuf, int isiz, bool dec){
+  if(dec){
+    int osiz;
+    char *obuf = tclzdecode(ibuf, isiz, &osiz);
+    if(!obuf){
+      eprintf("decoding failed");
+      return 1;
+    }
+    fwrite(obuf, 1, osiz, stdout);
+    tcfree(obuf);
+  } else {
+    int osiz;
+    char *obuf = tclzencode(ibuf, isiz, &osiz);
+    fwrite(obuf, 1, osiz, stdout);
+    tcfree(obuf);
+  }
+  return 0;
+}
+
+
 /* perform zlib command */
 static int proczlib(const char *ibuf, int isiz, bool dec, bool gz){
   if(dec){
@@ -1032,6 +1032,23 @@ static int procmisc(int rnum){
       }
       tcptrlistdel(ptrlist);
     }
+    if(i % 100 == 1){
+      TCSTATS *stats = tcstatsnew();
+      for(int j = 0; j < 100; j++){
+        tcstatsop(stats, TCSOGET, tcstatsclock() - j * 1000);
+      }
+      tcstatsadd(stats, TCSCMISS, 3);
+      double pctl = tcstatspctl(stats, TCSOGET, 0.5);
+      if(tcstatsopnum(stats, TCSOGET) != 100 || tcstatscnt(stats, TCSCMISS) != 3 ||
+         pctl < 16384.0 || pctl > 131072.0 || tcstatspctl(stats, TCSOPUT, 0.99) != 0.0)
+        err = true;
+      TCMAP *smap = tcstatsmap(stats);
+      if(tcatoi(tcmapget4(smap, "get_count", "")) != 100) err = true;
+      tcmapdel(smap);
+      tcstatsclear(stats);
+      if(tcstatsopnum(stats, TCSOGET) != 0) err = true;
+      tcstatsdel(stats);
+    }
     buf = tcurlencode(str, slen);
     if(strcmp(buf, "5%252%2B3-1%3D4%20%22Yes%2FNo%22%20%3Ca%26b%3E")) err = true;
     dec = tcurldecode(buf, &dsiz);
@@ -1119,6 +1136,11 @@ static int procmisc(int rnum){
     if(dsiz != slen || strcmp(dec, str)) err = true;
     tcfree(dec);
     tcfree(buf);
+    buf = tclzencode(str, slen, &bsiz);
+    dec = tclzdecode(buf, bsiz, &dsiz);
+    if(!dec || dsiz != slen || strcmp(dec, str)) err = true;
+    tcfree(dec);
+    tcfree(buf);
     int idx;
     buf = tcbwtencode(str, slen, &idx);
     if(memcmp(buf, "4\"o 5a23s-%+=> 1b/\"<&YNe", slen) || idx != 13) err = true;
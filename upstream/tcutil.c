@@ -9500,6 +9500,177 @@ void tcptrlistclear(TCPTRLIST *ptrlist){
 
 
 
+/*************************************************************************************************
+ * operation statistics
+ *************************************************************************************************/
+
+
+static int tcstatsseq = 0;               // sequence number to assign slots to threads
+static __thread int tcstatsslot = -1;    // slot index of the current thread
+
+
+/* Get the slot of the current thread of a statistics object.
+   `stats' specifies the statistics object.
+   The return value is the slot object. */
+static TCSTATSLOT *tcstatsmyslot(TCSTATS *stats){
+  if(tcstatsslot < 0) tcstatsslot = __sync_fetch_and_add(&tcstatsseq, 1) % TCSTATSLOTNUM;
+  return stats->slots + tcstatsslot;
+}
+
+
+/* Create a statistics object. */
+TCSTATS *tcstatsnew(void){
+  TCSTATS *stats;
+  TCMALLOC(stats, sizeof(*stats));
+  memset(stats, 0, sizeof(*stats));
+  return stats;
+}
+
+
+/* Delete a statistics object. */
+void tcstatsdel(TCSTATS *stats){
+  assert(stats);
+  TCFREE(stats);
+}
+
+
+/* Reset every counter and histogram of a statistics object. */
+void tcstatsclear(TCSTATS *stats){
+  assert(stats);
+  memset(stats, 0, sizeof(*stats));
+}
+
+
+/* Get the current time of the monotonic clock for statistics. */
+uint64_t tcstatsclock(void){
+  struct timespec ts;
+  if(clock_gettime(CLOCK_MONOTONIC, &ts) != 0) return 0;
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+/* Record an operation into a statistics object. */
+void tcstatsop(TCSTATS *stats, int op, uint64_t start){
+  assert(stats && op >= 0 && op < TCSONUM);
+  uint64_t now = tcstatsclock();
+  uint64_t lat = now > start ? now - start : 0;
+  int bidx = 0;
+  while(bidx < TCSTATBKTNUM - 1 && (lat >> (bidx + 1)) > 0){
+    bidx++;
+  }
+  TCSTATSLOT *slot = tcstatsmyslot(stats);
+  __sync_fetch_and_add(slot->opnums + op, 1);
+  __sync_fetch_and_add(slot->optimes + op, lat);
+  __sync_fetch_and_add(slot->hists[op] + bidx, 1);
+}
+
+
+/* Add a value to a counter of a statistics object. */
+void tcstatsadd(TCSTATS *stats, int cnt, int64_t num){
+  assert(stats && cnt >= 0 && cnt < TCSCNUM);
+  TCSTATSLOT *slot = tcstatsmyslot(stats);
+  __sync_fetch_and_add(slot->cnts + cnt, num);
+}
+
+
+/* Get the number of operations recorded in a statistics object. */
+uint64_t tcstatsopnum(const TCSTATS *stats, int op){
+  assert(stats && op >= 0 && op < TCSONUM);
+  uint64_t sum = 0;
+  for(int i = 0; i < TCSTATSLOTNUM; i++){
+    sum += stats->slots[i].opnums[op];
+  }
+  return sum;
+}
+
+
+/* Get the value of a counter of a statistics object. */
+uint64_t tcstatscnt(const TCSTATS *stats, int cnt){
+  assert(stats && cnt >= 0 && cnt < TCSCNUM);
+  uint64_t sum = 0;
+  for(int i = 0; i < TCSTATSLOTNUM; i++){
+    sum += stats->slots[i].cnts[cnt];
+  }
+  return sum;
+}
+
+
+/* Get the latency histogram of an operation type of a statistics object. */
+void tcstatshist(const TCSTATS *stats, int op, uint64_t *hist){
+  assert(stats && op >= 0 && op < TCSONUM && hist);
+  memset(hist, 0, sizeof(*hist) * TCSTATBKTNUM);
+  for(int i = 0; i < TCSTATSLOTNUM; i++){
+    const uint64_t *shist = stats->slots[i].hists[op];
+    for(int j = 0; j < TCSTATBKTNUM; j++){
+      hist[j] += shist[j];
+    }
+  }
+}
+
+
+/* Get a percentile of the latencies of an operation type of a statistics object. */
+double tcstatspctl(const TCSTATS *stats, int op, double ratio){
+  assert(stats && op >= 0 && op < TCSONUM);
+  uint64_t hist[TCSTATBKTNUM];
+  tcstatshist(stats, op, hist);
+  uint64_t total = 0;
+  for(int i = 0; i < TCSTATBKTNUM; i++){
+    total += hist[i];
+  }
+  if(total < 1) return 0.0;
+  if(ratio < 0.0) ratio = 0.0;
+  if(ratio > 1.0) ratio = 1.0;
+  double rank = ratio * total;
+  uint64_t sum = 0;
+  for(int i = 0; i < TCSTATBKTNUM; i++){
+    if(hist[i] < 1) continue;
+    if(sum + hist[i] >= rank || i == TCSTATBKTNUM - 1){
+      double lower = i > 0 ? (double)(1ULL << i) : 0.0;
+      double upper = (double)(1ULL << (i + 1));
+      return lower + (upper - lower) * (rank - sum) / hist[i];
+    }
+    sum += hist[i];
+  }
+  return 0.0;
+}
+
+
+/* Get a summary of a statistics object. */
+TCMAP *tcstatsmap(const TCSTATS *stats){
+  assert(stats);
+  const char *opnames[] = { "get", "put", "out", "iter", "tran", "sync" };
+  const char *cntnames[] = { "miss", "cache_hit", "chain", "read_bytes", "write_bytes" };
+  TCMAP *map = tcmapnew2(TCSONUM * 6 + TCSCNUM + 1);
+  for(int i = 0; i < TCSONUM; i++){
+    uint64_t num = 0;
+    uint64_t elapsed = 0;
+    for(int j = 0; j < TCSTATSLOTNUM; j++){
+      num += stats->slots[j].opnums[i];
+      elapsed += stats->slots[j].optimes[i];
+    }
+    const char *name = opnames[i];
+    char kbuf[TCNUMBUFSIZ];
+    sprintf(kbuf, "%s_count", name);
+    tcmapprintf(map, kbuf, "%llu", (unsigned long long)num);
+    sprintf(kbuf, "%s_mean", name);
+    tcmapprintf(map, kbuf, "%.3f", num > 0 ? elapsed / 1000.0 / num : 0.0);
+    sprintf(kbuf, "%s_p50", name);
+    tcmapprintf(map, kbuf, "%.3f", tcstatspctl(stats, i, 0.5) / 1000.0);
+    sprintf(kbuf, "%s_p90", name);
+    tcmapprintf(map, kbuf, "%.3f", tcstatspctl(stats, i, 0.9) / 1000.0);
+    sprintf(kbuf, "%s_p99", name);
+    tcmapprintf(map, kbuf, "%.3f", tcstatspctl(stats, i, 0.99) / 1000.0);
+    sprintf(kbuf, "%s_p999", name);
+    tcmapprintf(map, kbuf, "%.3f", tcstatspctl(stats, i, 0.999) / 1000.0);
+  }
+  for(int i = 0; i < TCSCNUM; i++){
+    tcmapprintf(map, cntnames[i], "%llu", (unsigned long long)tcstatscnt(stats, i));
+  }
+  return map;
+}
+
+
+
 /*************************************************************************************************
  * features for experts
  *************************************************************************************************/
@@ -9509,6 +9680,12 @@ void tcptrlistclear(TCPTRLIST *ptrlist){
 #define TCBWTCNTMIN    64               // minimum element number of counting sort
 #define TCBWTCNTLV     4                // maximum recursion level of counting sort
 #define TCBWTBUFNUM    16384            // number of elements of BWT buffer
+#define TCLZHASHBITS   13               // number of bits of the hash table of LZ encoding
+#define TCLZMINMATCH   4                // minimum length of a match of LZ encoding
+#define TCLZMAXOFF     65535            // maximum distance of a match of LZ encoding
+#define TCLZLASTLIT    5                // number of literals which must end LZ encoding
+#define TCLZMFLIMIT    12               // minimum distance from the end to start a match
+#define TCLZSKIPTRIG   6                // power of misses which increase the skipping step
 
 typedef struct {                         // type of structure for a BWT character
   int fchr;                              // character code of the first character
@@ -9527,6 +9704,7 @@ static void tcbwtsortchrinsert(unsigned char *str, int len);
 static void tcbwtsortreccount(TCBWTREC *arrays, int anum);
 static void tcbwtsortrecinsert(TCBWTREC *array, int anum);
 static int tcbwtsearchrec(TCBWTREC *array, int anum, int tchr);
+static char *tclzwriteseq(char *wp, const char *lbuf, int lsiz, int off, int msiz);
 static void tcmtfencode(char *ptr, int size);
 static void tcmtfdecode(char *ptr, int size);
 static int tcgammaencode(const char *ptr, int size, char *obuf);
@@ -9945,6 +10123,156 @@ char *tcbsdecode(const char *ptr, int size, int *sp){
 }
 
 
+/* Compress a serial object with LZ encoding. */
+char *tclzencode(const char *ptr, int size, int *sp){
+  assert(ptr && size >= 0 && sp);
+  char *result;
+  TCMALLOC(result, size + size / 255 + sizeof(uint64_t) * 2 + 0x10);
+  char *wp = result;
+  int step;
+  TCSETVNUMBUF(step, wp, size);
+  wp += step;
+  const char *anchor = ptr;
+  const char *end = ptr + size;
+  if(size >= TCLZMFLIMIT){
+    uint32_t table[1<<TCLZHASHBITS];
+    memset(table, 0, sizeof(table));
+    const char *rp = ptr + 1;
+    const char *mflimit = end - TCLZMFLIMIT;
+    const char *mlimit = end - TCLZLASTLIT;
+    int miss = 1 << TCLZSKIPTRIG;
+    while(rp < mflimit){
+      uint32_t seq;
+      memcpy(&seq, rp, sizeof(seq));
+      uint32_t hidx = (seq * 2654435761U) >> (32 - TCLZHASHBITS);
+      const char *ref = ptr + table[hidx];
+      table[hidx] = rp - ptr;
+      uint32_t rseq;
+      memcpy(&rseq, ref, sizeof(rseq));
+      if(ref >= rp || rp - ref > TCLZMAXOFF || rseq != seq){
+        rp += miss++ >> TCLZSKIPTRIG;
+        continue;
+      }
+      miss = 1 << TCLZSKIPTRIG;
+      while(rp > anchor && ref > ptr && rp[-1] == ref[-1]){
+        rp--;
+        ref--;
+      }
+      const char *mp = rp + TCLZMINMATCH;
+      const char *cp = ref + TCLZMINMATCH;
+      while(mp + sizeof(uint64_t) <= mlimit){
+        uint64_t anum, bnum;
+        memcpy(&anum, mp, sizeof(anum));
+        memcpy(&bnum, cp, sizeof(bnum));
+        if(anum != bnum) break;
+        mp += sizeof(anum);
+        cp += sizeof(bnum);
+      }
+      while(mp < mlimit && *mp == *cp){
+        mp++;
+        cp++;
+      }
+      wp = tclzwriteseq(wp, anchor, rp - anchor, rp - ref, mp - rp - TCLZMINMATCH);
+      rp = mp;
+      anchor = rp;
+      if(rp < mflimit){
+        memcpy(&seq, rp - 2, sizeof(seq));
+        table[(seq * 2654435761U) >> (32 - TCLZHASHBITS)] = rp - 2 - ptr;
+      }
+    }
+  }
+  wp = tclzwriteseq(wp, anchor, end - anchor, 0, 0);
+  *sp = wp - result;
+  return result;
+}
+
+
+/* Decompress a serial object compressed with LZ encoding. */
+char *tclzdecode(const char *ptr, int size, int *sp){
+  assert(ptr && size >= 0 && sp);
+  const unsigned char *rp = (const unsigned char *)ptr;
+  const unsigned char *ep = rp + size;
+  int64_t osiz = 0;
+  int64_t base = 1;
+  while(true){
+    if(rp >= ep || base > (1 << 28)) return NULL;
+    int c = *(signed char *)(rp++);
+    if(c >= 0){
+      osiz += c * base;
+      break;
+    }
+    osiz += base * (-c - 1);
+    base <<= 7;
+  }
+  if(osiz > INT_MAX - 1) return NULL;
+  char *result;
+  TCMALLOC(result, osiz + 1);
+  char *wp = result;
+  char *wend = result + osiz;
+  while(true){
+    if(rp >= ep) break;
+    int token = *(rp++);
+    int64_t lsiz = token >> 4;
+    if(lsiz == 0xf){
+      int c;
+      do {
+        if(rp >= ep) break;
+        c = *(rp++);
+        lsiz += c;
+      } while(c == 0xff);
+    }
+    if(lsiz > ep - rp || lsiz > wend - wp) break;
+    if(lsiz <= 16 && ep - rp >= 16 && wend - wp >= 16){
+      memcpy(wp, rp, 16);
+    } else {
+      memcpy(wp, rp, lsiz);
+    }
+    wp += lsiz;
+    rp += lsiz;
+    if(rp >= ep){
+      if(wp != wend) break;
+      *wp = '\0';
+      *sp = osiz;
+      return result;
+    }
+    if(ep - rp < 2) break;
+    int off = rp[0] | (rp[1] << 8);
+    rp += 2;
+    if(off < 1 || off > wp - result) break;
+    int64_t msiz = token & 0xf;
+    if(msiz == 0xf){
+      int c;
+      do {
+        if(rp >= ep) break;
+        c = *(rp++);
+        msiz += c;
+      } while(c == 0xff);
+    }
+    msiz += TCLZMINMATCH;
+    if(msiz > wend - wp) break;
+    const char *mp = wp - off;
+    if(off >= sizeof(uint64_t) && wend - wp >= msiz + (int)sizeof(uint64_t)){
+      char *mend = wp + msiz;
+      while(wp < mend){
+        memcpy(wp, mp, sizeof(uint64_t));
+        wp += sizeof(uint64_t);
+        mp += sizeof(uint64_t);
+      }
+      wp = mend;
+    } else if(off >= msiz){
+      memcpy(wp, mp, msiz);
+      wp += msiz;
+    } else {
+      while(msiz-- > 0){
+        *(wp++) = *(mp++);
+      }
+    }
+  }
+  TCFREE(result);
+  return NULL;
+}
+
+
 /* Encode a serial object with BWT encoding. */
 char *tcbwtencode(const char *ptr, int size, int *idxp){
   assert(ptr && size >= 0 && idxp);
@@ -10394,6 +10722,43 @@ const unsigned char tcmtftable[] = {
 };
 
 
+/* Write a sequence of LZ encoding.
+   `wp' specifies the pointer to the region into which the sequence is written.
+   `lbuf' specifies the pointer to the region of the literals.
+   `lsiz' specifies the size of the literals.
+   `off' specifies the distance of the match.  If it is 0, the sequence is the last one.
+   `msiz' specifies the length of the match minus the minimum length.
+   The return value is the pointer to the end of the written sequence. */
+static char *tclzwriteseq(char *wp, const char *lbuf, int lsiz, int off, int msiz){
+  assert(wp && lbuf && lsiz >= 0 && off >= 0 && msiz >= 0);
+  unsigned char *tp = (unsigned char *)(wp++);
+  *tp = ((lsiz < 0xf) ? lsiz : 0xf) << 4;
+  if(lsiz >= 0xf){
+    int rest = lsiz - 0xf;
+    while(rest >= 0xff){
+      *(wp++) = 0xff;
+      rest -= 0xff;
+    }
+    *(wp++) = rest;
+  }
+  memcpy(wp, lbuf, lsiz);
+  wp += lsiz;
+  if(off < 1) return wp;
+  *(wp++) = off & 0xff;
+  *(wp++) = off >> 8;
+  *tp |= (msiz < 0xf) ? msiz : 0xf;
+  if(msiz >= 0xf){
+    int rest = msiz - 0xf;
+    while(rest >= 0xff){
+      *(wp++) = 0xff;
+      rest -= 0xff;
+    }
+    *(wp++) = rest;
+  }
+  return wp;
+}
+
+
 /* Encode a region with MTF encoding.
    `ptr' specifies the pointer to the region.
    `size' specifies the size of the region. */
@@ -3144,6 +3144,32 @@ char *tcbsencode(const char *ptr, int size, int *sp);
 char *tcbsdecode(const char *ptr, int size, int *sp);
 
 
+/* Compress a serial object with LZ encoding.
+   `ptr' specifies the pointer to the region.
+   `size' specifies the size of the region.
+   `sp' specifies the pointer to the variable into which the size of the region of the return
+   value is assigned.
+   If successful, the return value is the pointer to the result object, else, it is `NULL'.
+   Because the region of the return value is allocated with the `malloc' call, it should be
+   released with the `free' call when it is no longer in use.
+   LZ encoding only replaces repeated strings with references to earlier ones.  Its ratio is
+   lower than that of Deflate but both of compression and decompression are much faster. */
+char *tclzencode(const char *ptr, int size, int *sp);
+
+
+/* Decompress a serial object compressed with LZ encoding.
+   `ptr' specifies the pointer to the region.
+   `size' specifies the size of the region.
+   `sp' specifies the pointer to a variable into which the size of the region of the return
+   value is assigned.
+   If successful, the return value is the pointer to the result object, else, it is `NULL'.
+   `NULL' is returned if the region is broken.  Because an additional zero code is appended at
+   the end of the region of the return value, the return value can be treated as a character
+   string.  Because the region of the return value is allocated with the `malloc' call, it
+   should be released with the `free' call when it is no longer in use. */
+char *tclzdecode(const char *ptr, int size, int *sp);
+
+
 /* Compress a serial object with Deflate encoding.
    `ptr' specifies the pointer to the region.
    `size' specifies the size of the region.
@@ -3563,6 +3589,131 @@ void tcptrlistclear(TCPTRLIST *ptrlist);
 
 
 
+/*************************************************************************************************
+ * operation statistics
+ *************************************************************************************************/
+
+
+enum {                                   /* enumeration for operation types of statistics */
+  TCSOGET,                               /* retrieval of a record */
+  TCSOPUT,                               /* storing of a record */
+  TCSOOUT,                               /* removal of a record */
+  TCSOITER,                              /* traversal of a record */
+  TCSOTRAN,                              /* commitment of a transaction */
+  TCSOSYNC,                              /* synchronization with the device */
+  TCSONUM                                /* number of operation types */
+};
+
+enum {                                   /* enumeration for counters of statistics */
+  TCSCMISS,                              /* retrievals of missing records */
+  TCSCCACHE,                             /* hits of the record or page cache */
+  TCSCCHAIN,                             /* elements visited while searching */
+  TCSCREAD,                              /* bytes read from the file */
+  TCSCWRITE,                             /* bytes written into the file */
+  TCSCNUM                                /* number of counters */
+};
+
+#define TCSTATSLOTNUM  16                /* number of slots shared by threads */
+#define TCSTATBKTNUM   40                /* number of buckets of a latency histogram */
+
+typedef struct {                         /* type of structure for a slot of statistics */
+  uint64_t opnums[TCSONUM];              /* numbers of operations */
+  uint64_t optimes[TCSONUM];             /* total latencies of operations in nanoseconds */
+  uint64_t cnts[TCSCNUM];                /* counters */
+  uint64_t hists[TCSONUM][TCSTATBKTNUM]; /* latency histograms by powers of two */
+} TCSTATSLOT;
+
+typedef struct {                         /* type of structure for operation statistics */
+  TCSTATSLOT slots[TCSTATSLOTNUM];       /* slots assigned to threads */
+} TCSTATS;
+
+
+/* Create a statistics object.
+   The return value is the new statistics object.
+   Each thread updates one of the slots of the object so that threads rarely touch the same
+   memory, and readers sum up all slots. */
+TCSTATS *tcstatsnew(void);
+
+
+/* Delete a statistics object.
+   `stats' specifies the statistics object.
+   Note that the deleted object can not be used anymore. */
+void tcstatsdel(TCSTATS *stats);
+
+
+/* Reset every counter and histogram of a statistics object.
+   `stats' specifies the statistics object. */
+void tcstatsclear(TCSTATS *stats);
+
+
+/* Get the current time of the monotonic clock for statistics.
+   The return value is the time in nanoseconds, which makes sense only as the start time of
+   `tcstatsop'. */
+uint64_t tcstatsclock(void);
+
+
+/* Record an operation into a statistics object.
+   `stats' specifies the statistics object.
+   `op' specifies the operation type: `TCSOGET', `TCSOPUT', `TCSOOUT', `TCSOITER', `TCSOTRAN',
+   or `TCSOSYNC'.
+   `start' specifies the time when the operation started, which is got by `tcstatsclock'. */
+void tcstatsop(TCSTATS *stats, int op, uint64_t start);
+
+
+/* Add a value to a counter of a statistics object.
+   `stats' specifies the statistics object.
+   `cnt' specifies the counter: `TCSCMISS', `TCSCCACHE', `TCSCCHAIN', `TCSCREAD', or
+   `TCSCWRITE'.
+   `num' specifies the additional value. */
+void tcstatsadd(TCSTATS *stats, int cnt, int64_t num);
+
+
+/* Get the number of operations recorded in a statistics object.
+   `stats' specifies the statistics object.
+   `op' specifies the operation type.
+   The return value is the number of operations of the type. */
+uint64_t tcstatsopnum(const TCSTATS *stats, int op);
+
+
+/* Get the value of a counter of a statistics object.
+   `stats' specifies the statistics object.
+   `cnt' specifies the counter.
+   The return value is the value of the counter. */
+uint64_t tcstatscnt(const TCSTATS *stats, int cnt);
+
+
+/* Get the latency histogram of an operation type of a statistics object.
+   `stats' specifies the statistics object.
+   `op' specifies the operation type.
+   `hist' specifies the array of `TCSTATBKTNUM' elements into which the numbers of operations
+   are written.  The element `i' counts the operations which took from 2 to the `i'-th power
+   nanoseconds to less than 2 to the `i'+1-th power nanoseconds, and the last element also
+   counts slower ones. */
+void tcstatshist(const TCSTATS *stats, int op, uint64_t *hist);
+
+
+/* Get a percentile of the latencies of an operation type of a statistics object.
+   `stats' specifies the statistics object.
+   `op' specifies the operation type.
+   `ratio' specifies the ratio of the percentile, as 0.99 for the 99th percentile.
+   The return value is the estimated latency in nanoseconds, interpolated in the bucket of the
+   histogram, or 0.0 if no operation has been recorded. */
+double tcstatspctl(const TCSTATS *stats, int op, double ratio);
+
+
+/* Get a summary of a statistics object.
+   `stats' specifies the statistics object.
+   The return value is a map object of the summary.  For each operation type named "get",
+   "put", "out", "iter", "tran", and "sync", the number and the mean and the 50th, 90th, 99th,
+   and 99.9th percentiles of latencies in microseconds are stored with keys like "get_count",
+   "get_mean", "get_p50", "get_p90", "get_p99", and "get_p999".  The counters are stored with
+   the keys "miss", "cache_hit", "chain", "read_bytes", and "write_bytes".
+   Because the object of the return value is created with the function `tcmapnew', it should be
+   deleted with the function `tcmapdel' when it is no longer in use. */
+TCMAP *tcstatsmap(const TCSTATS *stats);
+
+
+
 /*************************************************************************************************
  * bit operation utilities
  *************************************************************************************************/